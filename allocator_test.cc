@@ -0,0 +1,825 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Define the allocator stress workloads shared by the memory and
+/// scheduler test programs. Each workload allocates blocks from one of the
+/// allocators in an ALLOCATOR_TEST_STATE and hands most of them to another
+/// thread or task to free. memory.cc runs the workloads on plain threads, and
+/// scheduler.cc runs them as tasks and as scaling benchmarks. Include this
+/// file after win32_oslayer.cc.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define a set of slots used by the allocator stress workloads to pass live blocks between threads, so that blocks are freed by a thread other than the one that allocated them.
+struct ALLOCATOR_HANDOFF
+{   static size_t const SLOT_COUNT = 1024;           /// The number of slots. Must be a power of two.
+    std::atomic<uint64_t> Slots[SLOT_COUNT];         /// Each slot holds an encoded block, or zero if the slot is empty.
+};
+
+/// @summary Define the frame in progress on one of the chained arenas of an ALLOCATOR_TEST_STATE.
+struct ALLOCATOR_CHAINED_FRAME
+{   static size_t const OBJECT_COUNT = 32;           /// The number of objects allocated during each frame. Stress iteration counts must be a multiple of this value.
+    os_arena_marker_t   FrameStart;                  /// The arena marker taken before the first object of the frame was allocated.
+    os_arena_marker_t   MidFrame;                    /// The arena marker taken before the second half of the frame was allocated.
+    uint8_t            *Objects[OBJECT_COUNT];       /// The objects allocated so far during the frame.
+    size_t              Sizes[OBJECT_COUNT];         /// The size of each object in Objects, in bytes.
+};
+
+/// @summary Define the allocators exercised by the allocator stress workloads, along with the per-thread state used with them.
+/// Each thread or task pool using the allocators is assigned a cache index, which selects its thread caches, chained arena and chained frame.
+struct ALLOCATOR_TEST_STATE
+{
+    OS_CONCURRENT_BUDDY_ALLOCATOR BuddyAllocator;    /// The concurrent buddy allocator managing the first ALLOCATOR_HEAP_BYTES of HeapMemory.
+    OS_BUDDY_THREAD_CACHE *BuddyCaches;              /// One buddy allocator thread cache per cache index.
+    OS_SLAB_ALLOCATOR      SlabAllocator;            /// The slab allocator managing SlabMemory.
+    OS_SLAB_THREAD_CACHE  *SlabCaches;               /// One slab allocator thread cache per cache index.
+    OS_HOST_MEMORY_ALLOCATION SlabMemory;            /// Describes the ALLOCATOR_SLAB_BYTES following the buddy allocator heap. The range is fully committed, so the slab allocator never grows it.
+    OS_TLSF_ALLOCATOR      TlsfAllocator;            /// The TLSF allocator managing the ALLOCATOR_TLSF_BYTES following the slab allocator memory.
+    OS_MUTEX               TlsfLock;                 /// Held across every call to the TLSF allocator, which is not safe for concurrent use.
+    OS_HOST_MEMORY_POOL    ArenaPool;                /// The pool from which the chained arenas acquire their blocks. Threads acquire and release blocks concurrently.
+    OS_CHAINED_ARENA      *ChainedArenas;            /// One chained arena per cache index.
+    ALLOCATOR_CHAINED_FRAME *ChainedFrames;          /// One frame per cache index, describing the frame in progress on the corresponding chained arena.
+    ALLOCATOR_HANDOFF     *Handoff;                  /// The slots used to pass live blocks between threads.
+    uint8_t               *HeapMemory;               /// The ALLOCATOR_HEAP_BYTES of host memory managed by the buddy allocator.
+    size_t                 CacheCount;               /// The number of cache indices, which is also the number of entries in each per-cache array.
+    bool                   StampBlocks;              /// true to fill each block with a value identifying it and check the value when the block is freed. Benchmarks clear this so that they measure the allocator rather than memory bandwidth.
+};
+
+/// @summary Define the signature of the allocation step of an allocator stress workload.
+/// @param state The ALLOCATOR_TEST_STATE holding the allocator.
+/// @param cache_index The zero-based cache index of the calling thread.
+/// @param iteration The zero-based iteration number of the calling thread.
+/// @param rng The random number generator state of the calling thread.
+/// @param encoded On return, a non-zero value identifying the allocated block, or zero if no block is to be handed to another thread.
+/// @return false if the allocator returned an invalid block.
+typedef bool (*ALLOCATOR_STRESS_ALLOCFUNC)(ALLOCATOR_TEST_STATE *state, size_t cache_index, uint32_t iteration, uint32_t &rng, uint64_t &encoded);
+
+/// @summary Define the signature of the free step of an allocator stress workload.
+/// @param state The ALLOCATOR_TEST_STATE holding the allocator.
+/// @param cache_index The zero-based cache index of the calling thread, or SIZE_MAX if the thread has no cache.
+/// @param iteration The zero-based iteration number of the calling thread.
+/// @param rng The random number generator state of the calling thread.
+/// @param encoded The value identifying the block to free, which may have been allocated by any thread.
+/// @return false if the block was overwritten while it was live.
+typedef bool (*ALLOCATOR_STRESS_FREEFUNC)(ALLOCATOR_TEST_STATE *state, size_t cache_index, uint32_t iteration, uint32_t &rng, uint64_t encoded);
+
+/// @summary Define the signature of the function that checks an allocator once every block has been freed. No other thread may be using the allocator.
+/// @param state The ALLOCATOR_TEST_STATE holding the allocator.
+/// @return true if the allocator is consistent.
+typedef bool (*ALLOCATOR_STRESS_FINISHFUNC)(ALLOCATOR_TEST_STATE *state);
+
+/// @summary Describe an allocator stress workload.
+struct ALLOCATOR_STRESS_DESC
+{
+    char const         *Name;                        /// A zero-terminated string specifying the name of the allocator, used to name tests and benchmarks.
+    ALLOCATOR_STRESS_ALLOCFUNC  Allocate;            /// Allocate a block.
+    ALLOCATOR_STRESS_FREEFUNC   Free;                /// Check and free a block, or NULL if blocks are never handed to other threads.
+    ALLOCATOR_STRESS_FINISHFUNC Finish;              /// Flush the thread caches and check the allocator once all blocks are freed.
+    uint32_t            PopMask;                     /// An iteration that hands off its block only frees a block from the handoff slots if (NextRandom() & PopMask) == 0.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary The number of bytes of heap memory managed by the buddy allocator in an ALLOCATOR_TEST_STATE. Must be a power of two.
+global_variable size_t const ALLOCATOR_HEAP_BYTES   = Megabytes(32);
+
+/// @summary The number of bytes of memory managed by the slab allocator in an ALLOCATOR_TEST_STATE. Must be a multiple of OS_SLAB_ALLOCATOR::DEFAULT_SLAB_SIZE.
+global_variable size_t const ALLOCATOR_SLAB_BYTES   = Megabytes(32);
+
+/// @summary The number of bytes of memory managed by the TLSF allocator in an ALLOCATOR_TEST_STATE.
+global_variable size_t const ALLOCATOR_TLSF_BYTES   = Megabytes(16);
+
+/// @summary The minimum size of each block acquired by the chained arenas in an ALLOCATOR_TEST_STATE.
+global_variable size_t const ALLOCATOR_CHAINED_BLOCK_BYTES = Kilobytes(64);
+
+/// @summary The number of ArenaPool allocations available to each chained arena in an ALLOCATOR_TEST_STATE.
+global_variable size_t const ALLOCATOR_CHAINED_BLOCK_COUNT = 8;
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Compute the number of bytes of host memory required by CreateAllocatorTestState.
+/// @param cache_count The number of threads or task pools using the allocators.
+/// @return The number of bytes of memory to supply to CreateAllocatorTestState.
+internal_function size_t
+AllocatorTestMemorySize
+(
+    size_t cache_count
+)
+{
+    return ALLOCATOR_HEAP_BYTES + ALLOCATOR_SLAB_BYTES + ALLOCATOR_TLSF_BYTES + sizeof(ALLOCATOR_HANDOFF) + ((sizeof(OS_BUDDY_THREAD_CACHE) + sizeof(OS_SLAB_THREAD_CACHE) + sizeof(OS_CHAINED_ARENA) + sizeof(ALLOCATOR_CHAINED_FRAME)) * cache_count);
+}
+
+/// @summary Initialize the allocators shared by the allocator stress workloads.
+/// @param state The ALLOCATOR_TEST_STATE to initialize.
+/// @param memory The committed host memory to sub-allocate from. The size must be at least AllocatorTestMemorySize(cache_count) bytes, and the address must be 64-byte aligned.
+/// @param cache_count The number of threads or task pools using the allocators.
+/// @return Zero if the allocators are initialized successfully, or -1 if an error occurred.
+internal_function int
+CreateAllocatorTestState
+(
+    ALLOCATOR_TEST_STATE *state,
+    uint8_t             *memory,
+    size_t          cache_count
+)
+{
+    size_t const     per_cache_size = sizeof(OS_BUDDY_THREAD_CACHE) + sizeof(OS_SLAB_THREAD_CACHE) + sizeof(OS_CHAINED_ARENA) + sizeof(ALLOCATOR_CHAINED_FRAME);
+    uint8_t             *slab_memory = memory + ALLOCATOR_HEAP_BYTES;
+    uint8_t             *tlsf_memory = memory + ALLOCATOR_HEAP_BYTES + ALLOCATOR_SLAB_BYTES;
+    uint8_t              *state_data = memory + ALLOCATOR_HEAP_BYTES + ALLOCATOR_SLAB_BYTES + ALLOCATOR_TLSF_BYTES;
+    size_t                 page_size = 0;
+    size_t               granularity = 0;
+    OS_BUDDY_ALLOCATOR_INIT buddy_init;
+    OS_SLAB_ALLOCATOR_INIT   slab_init;
+    OS_HOST_MEMORY_POOL_INIT pool_init;
+
+    OsZeroMemory(state, sizeof(ALLOCATOR_TEST_STATE));
+    OsZeroMemory(state_data, sizeof(ALLOCATOR_HANDOFF) + (per_cache_size * cache_count));
+    OsVmmQueryPageSize(page_size, granularity);
+    state->SlabMemory.BaseAddress     = slab_memory;
+    state->SlabMemory.BytesReserved   = ALLOCATOR_SLAB_BYTES;
+    state->SlabMemory.BytesCommitted  = ALLOCATOR_SLAB_BYTES;
+    state->SlabMemory.PageSize        = page_size;
+    state->SlabMemory.AllocationFlags = OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE;
+    buddy_init.AllocationSizeMin = 64;
+    buddy_init.AllocationSizeMax = ALLOCATOR_HEAP_BYTES;
+    buddy_init.BytesReserved     = 0;
+    slab_init.HostMemory         =&state->SlabMemory;
+    slab_init.SlabSize           = 0;
+    slab_init.SizeClasses        = NULL;
+    slab_init.SizeClassCount     = 0;
+    pool_init.PoolName           = "Chained Arena Pool";
+    pool_init.PoolCapacity       = ALLOCATOR_CHAINED_BLOCK_COUNT * cache_count;
+    pool_init.MinAllocationSize  = ALLOCATOR_CHAINED_BLOCK_BYTES;
+    pool_init.MinCommitIncrease  = Kilobytes(4);
+    pool_init.NumaPolicy         = OS_HOST_MEMORY_NUMA_POLICY_DEFAULT;
+    pool_init.NumaNode           = 0;
+    if (OsCreateConcurrentBuddyAllocator(&state->BuddyAllocator, &buddy_init) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to create the concurrent buddy allocator.\n", __FUNCTION__, OsThreadId());
+        return -1;
+    }
+    if (OsCreateSlabAllocator(&state->SlabAllocator, &slab_init) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to create the slab allocator.\n", __FUNCTION__, OsThreadId());
+        OsDeleteConcurrentBuddyAllocator(&state->BuddyAllocator);
+        return -1;
+    }
+    if (OsCreateTlsfAllocator(&state->TlsfAllocator, OsInitHostMemoryRange(tlsf_memory, ALLOCATOR_TLSF_BYTES)) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to create the TLSF allocator.\n", __FUNCTION__, OsThreadId());
+        OsDeleteSlabAllocator(&state->SlabAllocator);
+        OsDeleteConcurrentBuddyAllocator(&state->BuddyAllocator);
+        return -1;
+    }
+    if (OsCreateHostMemoryPool(&state->ArenaPool, &pool_init) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to create the chained arena host memory pool.\n", __FUNCTION__, OsThreadId());
+        OsDeleteSlabAllocator(&state->SlabAllocator);
+        OsDeleteConcurrentBuddyAllocator(&state->BuddyAllocator);
+        return -1;
+    }
+    state->HeapMemory    = memory;
+    state->Handoff       =(ALLOCATOR_HANDOFF      *)(state_data);
+    state->BuddyCaches   =(OS_BUDDY_THREAD_CACHE  *)(state_data + sizeof(ALLOCATOR_HANDOFF));
+    state->SlabCaches    =(OS_SLAB_THREAD_CACHE   *)(state_data + sizeof(ALLOCATOR_HANDOFF) + (sizeof(OS_BUDDY_THREAD_CACHE) * cache_count));
+    state->ChainedArenas =(OS_CHAINED_ARENA       *)(state_data + sizeof(ALLOCATOR_HANDOFF) + ((sizeof(OS_BUDDY_THREAD_CACHE) + sizeof(OS_SLAB_THREAD_CACHE)) * cache_count));
+    state->ChainedFrames =(ALLOCATOR_CHAINED_FRAME*)(state_data + sizeof(ALLOCATOR_HANDOFF) + ((sizeof(OS_BUDDY_THREAD_CACHE) + sizeof(OS_SLAB_THREAD_CACHE) + sizeof(OS_CHAINED_ARENA)) * cache_count));
+    state->CacheCount    = cache_count;
+    state->StampBlocks   = true;
+    for (size_t i = 0; i < cache_count; ++i)
+    {
+        if (OsCreateChainedArena(&state->ChainedArenas[i], &state->ArenaPool, ALLOCATOR_CHAINED_BLOCK_BYTES, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE) < 0)
+        {
+            OsLayerError("ERROR: %S(%u): Failed to create the chained arena for cache %Iu.\n", __FUNCTION__, OsThreadId(), i);
+            while (i > 0) OsDeleteChainedArena(&state->ChainedArenas[--i]);
+            OsDeleteHostMemoryPool(&state->ArenaPool);
+            OsDeleteSlabAllocator(&state->SlabAllocator);
+            OsDeleteConcurrentBuddyAllocator(&state->BuddyAllocator);
+            return -1;
+        }
+    }
+    OsCreateMutex(&state->TlsfLock, 0x1000);
+    return 0;
+}
+
+/// @summary Free the resources associated with the allocators in an ALLOCATOR_TEST_STATE. No threads may be accessing the allocators.
+/// @param state The ALLOCATOR_TEST_STATE to delete.
+internal_function void
+DeleteAllocatorTestState
+(
+    ALLOCATOR_TEST_STATE *state
+)
+{
+    for (size_t i = 0, n = state->CacheCount; i < n; ++i)
+    {
+        OsDeleteChainedArena(&state->ChainedArenas[i]);
+    }
+    OsDeleteHostMemoryPool(&state->ArenaPool);
+    OsDeleteMutex(&state->TlsfLock);
+    OsDeleteSlabAllocator(&state->SlabAllocator);
+    OsDeleteConcurrentBuddyAllocator(&state->BuddyAllocator);
+}
+
+/// @summary Advance a xorshift32 random number generator.
+/// @param state The generator state. Must be non-zero.
+/// @return The next value in the sequence.
+internal_function uint32_t
+NextRandom
+(
+    uint32_t &state
+)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state <<  5;
+    return state;
+}
+
+/// @summary Store an encoded block in an empty slot of a handoff set, so that another thread can free it.
+/// @param handoff The ALLOCATOR_HANDOFF to update.
+/// @param value The non-zero encoded block.
+/// @param start The index of the first slot to try.
+/// @return true if the block was stored, or false if every slot is occupied.
+internal_function bool
+HandoffPush
+(
+    ALLOCATOR_HANDOFF *handoff,
+    uint64_t             value,
+    uint32_t             start
+)
+{
+    for (size_t i = 0; i < ALLOCATOR_HANDOFF::SLOT_COUNT; ++i)
+    {
+        uint64_t expected = 0;
+        if (handoff->Slots[(start + i) & (ALLOCATOR_HANDOFF::SLOT_COUNT - 1)].compare_exchange_strong(expected, value))
+            return true;
+    }
+    return false;
+}
+
+/// @summary Remove an encoded block from a handoff set.
+/// @param handoff The ALLOCATOR_HANDOFF to update.
+/// @param start The index of the first slot to try.
+/// @return The encoded block, or zero if every slot is empty.
+internal_function uint64_t
+HandoffPop
+(
+    ALLOCATOR_HANDOFF *handoff,
+    uint32_t             start
+)
+{
+    for (size_t i = 0; i < ALLOCATOR_HANDOFF::SLOT_COUNT; ++i)
+    {
+        std::atomic<uint64_t> &slot = handoff->Slots[(start + i) & (ALLOCATOR_HANDOFF::SLOT_COUNT - 1)];
+        uint64_t             value = 0;
+        if (slot.load(std::memory_order_relaxed) != 0 && (value = slot.exchange(0)) != 0)
+            return value;
+    }
+    return 0;
+}
+
+/// @summary Fill a block with a value identifying it, so that a block handed out twice can be detected.
+/// @param block The start of the block. The address must be 8-byte aligned.
+/// @param size The size of the block, in bytes. Must be a multiple of 8.
+/// @param value The value to write to each 64-bit word of the block.
+internal_function void
+StampBlock
+(
+    uint8_t *block,
+    size_t    size,
+    uint64_t value
+)
+{
+    uint64_t *words = (uint64_t*) block;
+    for (size_t i = 0, n = size / sizeof(uint64_t); i < n; ++i)
+    {
+        words[i] = value;
+    }
+}
+
+/// @summary Check that a block still contains the value written by StampBlock.
+/// @param block The start of the block. The address must be 8-byte aligned.
+/// @param size The size of the block, in bytes. Must be a multiple of 8.
+/// @param value The value expected in each 64-bit word of the block.
+/// @return true if every word of the block contains the expected value.
+internal_function bool
+CheckBlockStamp
+(
+    uint8_t const *block,
+    size_t          size,
+    uint64_t       value
+)
+{
+    uint64_t const *words = (uint64_t const*) block;
+    for (size_t i = 0, n = size / sizeof(uint64_t); i < n; ++i)
+    {
+        if (words[i] != value)
+            return false;
+    }
+    return true;
+}
+
+/// @summary Fill a block with a value identifying it, except for the second word, which holds the block size, so that a thread that frees the block can check it without knowing its size.
+/// @param block The start of the block. The address must be 8-byte aligned.
+/// @param size The size of the block, in bytes. Must be a multiple of 8, and at least 16.
+/// @param value The value to write to each 64-bit word of the block.
+internal_function void
+StampSizedBlock
+(
+    uint8_t *block,
+    size_t    size,
+    uint64_t value
+)
+{
+    StampBlock(block, size, value);
+    ((uint64_t*) block)[1] = size;
+}
+
+/// @summary Check that a block still contains the values written by StampSizedBlock.
+/// @param block The start of the block. The address must be 8-byte aligned.
+/// @param value The value expected in each 64-bit word of the block, except the second.
+/// @param max_size The largest size that may be stored in the second word of the block.
+/// @return true if the block is intact.
+internal_function bool
+CheckSizedBlockStamp
+(
+    uint8_t const *block,
+    uint64_t       value,
+    size_t      max_size
+)
+{
+    uint64_t const *words = (uint64_t const*) block;
+    uint64_t const   size = words[1];
+    if (words[0] != value || size < 16 || size > max_size)
+        return false;
+    return CheckBlockStamp(block + 16, (size_t) size - 16, value);
+}
+
+/// @summary Count the objects on a slab allocator free list, checking that each object lies on an object boundary within a slab owned by the size class.
+/// @param alloc The OS_SLAB_ALLOCATOR that owns the list.
+/// @param class_index The zero-based index of the size class that owns the list.
+/// @param head The first object in the list, or NULL.
+/// @param limit The maximum number of objects expected on the list. Longer lists, which may contain a cycle, are rejected.
+/// @return The number of objects on the list, or SIZE_MAX if the list is invalid.
+internal_function size_t
+CountSlabFreeList
+(
+    OS_SLAB_ALLOCATOR *alloc,
+    uint32_t     class_index,
+    void             *head,
+    size_t            limit
+)
+{
+    size_t object_size = alloc->SizeClasses[class_index].ObjectSize;
+    size_t       count = 0;
+    while (head != NULL)
+    {
+        size_t offset = (size_t)((uint8_t*) head - alloc->HostMemory->BaseAddress);
+        size_t   slab = offset >> alloc->SlabShift;
+        if (count == limit || slab >= alloc->SlabCount || alloc->SlabClass[slab] != class_index || ((offset & (alloc->SlabSize - 1)) % object_size) != 0)
+            return SIZE_MAX;
+        head = *(void**) head;
+        count++;
+    }
+    return count;
+}
+
+/// @summary Allocate a block from the concurrent buddy allocator. Most requests are for the cached levels; one in sixteen is for up to 32KB, which is allocated directly from the tree.
+/// Blocks are encoded as their offset, which is a multiple of 64, combined with the base-2 logarithm of their size.
+internal_function bool
+BuddyStressAllocate
+(
+    ALLOCATOR_TEST_STATE *state,
+    size_t          cache_index,
+    uint32_t          iteration,
+    uint32_t               &rng,
+    uint64_t           &encoded
+)
+{
+    size_t    size = 48 + (NextRandom(rng) % ((iteration & 15) == 0 ? Kilobytes(32) - 48 : Kilobytes(4) - 48));
+    OS_MEMORY_RANGE block;
+    encoded = 0;
+    if (OsConcurrentBuddyAllocate(&state->BuddyAllocator, &state->BuddyCaches[cache_index], size, 16, block))
+    {
+        encoded = block.ByteOffset | OsBitScanReverse64(block.SizeInBytes);
+        if (state->StampBlocks)
+            StampBlock(state->HeapMemory + block.ByteOffset, block.SizeInBytes, encoded);
+    }
+    return true;
+}
+
+/// @summary Free a block allocated by BuddyStressAllocate. Every fourth free bypasses the thread cache.
+internal_function bool
+BuddyStressFree
+(
+    ALLOCATOR_TEST_STATE *state,
+    size_t          cache_index,
+    uint32_t          iteration,
+    uint32_t               &rng,
+    uint64_t            encoded
+)
+{
+    OS_BUDDY_THREAD_CACHE *cache = (cache_index < state->CacheCount && (iteration & 3) != 0) ? &state->BuddyCaches[cache_index] : NULL;
+    OS_MEMORY_RANGE        block;
+    UNREFERENCED_PARAMETER(rng);
+    block.ByteOffset  = (size_t)(encoded & ~uint64_t(63));
+    block.SizeInBytes = (size_t) 1 << (encoded & 63);
+    if (state->StampBlocks && !CheckBlockStamp(state->HeapMemory + block.ByteOffset, block.SizeInBytes, encoded))
+    {
+        OsLayerError("ERROR: %S(%u): Block at offset %Iu was overwritten while live.\n", __FUNCTION__, OsThreadId(), block.ByteOffset);
+        return false;
+    }
+    OsConcurrentBuddyFree(&state->BuddyAllocator, cache, block);
+    return true;
+}
+
+/// @summary Flush the buddy allocator thread caches and check that every block merged with its buddy.
+internal_function bool
+BuddyStressFinish
+(
+    ALLOCATOR_TEST_STATE *state
+)
+{
+    OS_ALLOCATOR_STATS stats;
+    for (size_t i = 0, n = state->CacheCount; i < n; ++i)
+    {
+        OsConcurrentBuddyFlushCache(&state->BuddyAllocator, &state->BuddyCaches[i]);
+    }
+    OsConcurrentBuddyTrim(&state->BuddyAllocator);
+    OsBuddyAllocatorQueryStats(&state->BuddyAllocator.Tree, &stats);
+    OsLayerError("STATUS: %I64u allocations from the tree, %I64u failed.\n", stats.AllocationCount, stats.FailedCount);
+    if (stats.BytesFree != ALLOCATOR_HEAP_BYTES || stats.LargestFreeBlock != ALLOCATOR_HEAP_BYTES)
+    {
+        OsLayerError("ERROR: %S(%u): %I64u bytes free in blocks of up to %I64u bytes after all blocks were returned.\n", __FUNCTION__, OsThreadId(), stats.BytesFree, stats.LargestFreeBlock);
+        return false;
+    }
+    return true;
+}
+
+/// @summary Allocate an object of up to 2KB from the slab allocator. Objects are encoded as their address.
+internal_function bool
+SlabStressAllocate
+(
+    ALLOCATOR_TEST_STATE *state,
+    size_t          cache_index,
+    uint32_t          iteration,
+    uint32_t               &rng,
+    uint64_t           &encoded
+)
+{
+    size_t      size = OsAlignUp(16 + (NextRandom(rng) % (2048 - 15)), sizeof(uint64_t));
+    uint8_t  *object = (uint8_t*) OsSlabAllocate(&state->SlabAllocator, &state->SlabCaches[cache_index], size);
+    UNREFERENCED_PARAMETER(iteration);
+    encoded = (uint64_t)(uintptr_t) object;
+    if (object != NULL && state->StampBlocks)
+        StampSizedBlock(object, size, encoded);
+    return true;
+}
+
+/// @summary Free an object allocated by SlabStressAllocate. Every fourth free goes to the lock-free remote list.
+internal_function bool
+SlabStressFree
+(
+    ALLOCATOR_TEST_STATE *state,
+    size_t          cache_index,
+    uint32_t          iteration,
+    uint32_t               &rng,
+    uint64_t            encoded
+)
+{
+    OS_SLAB_THREAD_CACHE *cache = (cache_index < state->CacheCount && (iteration & 3) != 0) ? &state->SlabCaches[cache_index] : NULL;
+    uint8_t             *object = (uint8_t*)(uintptr_t) encoded;
+    UNREFERENCED_PARAMETER(rng);
+    if (state->StampBlocks && !CheckSizedBlockStamp(object, encoded, 2048))
+    {
+        OsLayerError("ERROR: %S(%u): Object %p was overwritten while live.\n", __FUNCTION__, OsThreadId(), object);
+        return false;
+    }
+    OsSlabFree(&state->SlabAllocator, cache, object);
+    return true;
+}
+
+/// @summary Flush the slab allocator magazines and check that every object carved from a slab is on exactly one free list.
+internal_function bool
+SlabStressFinish
+(
+    ALLOCATOR_TEST_STATE *state
+)
+{
+    OS_SLAB_ALLOCATOR *alloc = &state->SlabAllocator;
+    size_t      remote_frees = 0;
+    bool              passed = true;
+    for (size_t i = 0, n = state->CacheCount; i < n; ++i)
+    {
+        OsSlabFlushCache(alloc, &state->SlabCaches[i]);
+    }
+    for (uint32_t i = 0; i < alloc->SizeClassCount; ++i)
+    {
+        OS_SLAB_SIZE_CLASS *sc = &alloc->SizeClasses[i];
+        size_t          carved = (sc->SlabCount * (alloc->SlabSize / sc->ObjectSize)) - ((size_t)(sc->CarveEnd - sc->CarveNext) / sc->ObjectSize);
+        size_t           local = CountSlabFreeList(alloc, i, sc->FreeList, carved);
+        size_t          remote = CountSlabFreeList(alloc, i, sc->RemoteFree.load(), carved);
+        if (local == SIZE_MAX || remote == SIZE_MAX || local + remote != carved)
+        {
+            OsLayerError("ERROR: %S(%u): Size class %u has %Iu objects carved, %Iu on the free list and %Iu on the remote list.\n", __FUNCTION__, OsThreadId(), i, carved, local, remote);
+            passed = false;
+        }
+        remote_frees += sc->RemoteFreeCount.load();
+    }
+    OsLayerError("STATUS: %Iu slabs acquired, %Iu remote frees.\n", alloc->SlabCount, remote_frees);
+    if (remote_frees == 0)
+    {
+        OsLayerError("ERROR: %S(%u): No objects were freed through the remote list.\n", __FUNCTION__, OsThreadId());
+        passed = false;
+    }
+    return passed;
+}
+
+/// @summary Allocate a block from the TLSF allocator with TlsfLock held. One request in eight asks for 256-byte alignment. Blocks are encoded as their offset.
+internal_function bool
+TlsfStressAllocate
+(
+    ALLOCATOR_TEST_STATE *state,
+    size_t          cache_index,
+    uint32_t          iteration,
+    uint32_t               &rng,
+    uint64_t           &encoded
+)
+{
+    uint8_t *base = state->TlsfAllocator.HostMemory.HostAddress;
+    size_t   size = 16 + (NextRandom(rng) % ((iteration & 15) == 0 ? Kilobytes(64) - 16 : Kilobytes(4) - 16));
+    size_t  align = (iteration & 7) == 0 ? 256 : 16;
+    bool       ok = false;
+    OS_MEMORY_RANGE block;
+    UNREFERENCED_PARAMETER(cache_index);
+    encoded = 0;
+    OsLockMutex(&state->TlsfLock);
+    {
+        ok = OsTlsfAllocate(&state->TlsfAllocator, size, align, block);
+    }
+    OsUnlockMutex(&state->TlsfLock);
+    if (!ok)
+        return true;
+    if (((uintptr_t)(base + block.ByteOffset) & (align - 1)) != 0 || block.SizeInBytes < size)
+    {
+        OsLayerError("ERROR: %S(%u): Block at offset %Iu has %Iu bytes; requested %Iu bytes aligned to %Iu.\n", __FUNCTION__, OsThreadId(), block.ByteOffset, block.SizeInBytes, size, align);
+        return false;
+    }
+    encoded = block.ByteOffset;
+    if (state->StampBlocks)
+        StampSizedBlock(base + block.ByteOffset, block.SizeInBytes & ~(sizeof(uint64_t) - 1), encoded);
+    return true;
+}
+
+/// @summary Free a block allocated by TlsfStressAllocate with TlsfLock held. Every fourth block is resized before it is freed, and must keep its contents whether or not it moves.
+internal_function bool
+TlsfStressFree
+(
+    ALLOCATOR_TEST_STATE *state,
+    size_t          cache_index,
+    uint32_t          iteration,
+    uint32_t               &rng,
+    uint64_t            encoded
+)
+{
+    uint8_t *base = state->TlsfAllocator.HostMemory.HostAddress;
+    bool       ok = false;
+    OS_MEMORY_RANGE  block;
+    OS_MEMORY_RANGE resize;
+    UNREFERENCED_PARAMETER(cache_index);
+    // the stamp records the block size; other threads may update the flags in the block header, so it cannot be read without TlsfLock.
+    // OsTlsfFree and OsTlsfReallocate read the size from the header themselves, so without a stamp any non-zero SizeInBytes will do.
+    block.ByteOffset  = (size_t) encoded;
+    block.SizeInBytes = state->StampBlocks ? (size_t)((uint64_t*)(base + block.ByteOffset))[1] : 1;
+    if (state->StampBlocks && !CheckSizedBlockStamp(base + block.ByteOffset, encoded, ALLOCATOR_TLSF_BYTES))
+    {
+        OsLayerError("ERROR: %S(%u): Block at offset %Iu was overwritten while live.\n", __FUNCTION__, OsThreadId(), block.ByteOffset);
+        return false;
+    }
+    if ((iteration & 3) == 0)
+    {
+        OsLockMutex(&state->TlsfLock);
+        {
+            ok = OsTlsfReallocate(&state->TlsfAllocator, block, 16 + (NextRandom(rng) % (Kilobytes(8) - 16)), 16, resize);
+        }
+        OsUnlockMutex(&state->TlsfLock);
+        if (ok)
+        {   // the common prefix, including the first word of the stamp, is preserved.
+            size_t keep = (block.SizeInBytes < resize.SizeInBytes ? block.SizeInBytes : resize.SizeInBytes) & ~(sizeof(uint64_t) - 1);
+            if (state->StampBlocks && (*(uint64_t*)(base + resize.ByteOffset) != encoded || !CheckBlockStamp(base + resize.ByteOffset + 16, keep - 16, encoded)))
+            {
+                OsLayerError("ERROR: %S(%u): Block at offset %Iu lost its contents when resized to offset %Iu.\n", __FUNCTION__, OsThreadId(), block.ByteOffset, resize.ByteOffset);
+                return false;
+            }
+            block = resize;
+        }
+    }
+    OsLockMutex(&state->TlsfLock);
+    {
+        OsTlsfFree(&state->TlsfAllocator, block);
+    }
+    OsUnlockMutex(&state->TlsfLock);
+    return true;
+}
+
+/// @summary Check that the TLSF allocator merged all of its free space back into a single block.
+internal_function bool
+TlsfStressFinish
+(
+    ALLOCATOR_TEST_STATE *state
+)
+{
+    OS_ALLOCATOR_STATS stats;
+    OsTlsfAllocatorQueryStats(&state->TlsfAllocator, &stats);
+    OsLayerError("STATUS: %I64u allocations, %I64u failed, peak %I64u KB.\n", stats.AllocationCount, stats.FailedCount, stats.BytesPeak / 1024);
+    if (stats.BytesLive != 0 || stats.LargestFreeBlock != stats.BytesFree)
+    {
+        OsLayerError("ERROR: %S(%u): %I64u bytes live and %I64u bytes free in blocks of up to %I64u bytes after all blocks were returned.\n", __FUNCTION__, OsThreadId(), stats.BytesLive, stats.BytesFree, stats.LargestFreeBlock);
+        return false;
+    }
+    return true;
+}
+
+/// @summary Allocate the next object of the frame in progress on the chained arena of the calling thread. The last object of each frame is up to 32KB, so
+/// frames usually outgrow the current block. At the end of each frame, the second half is discarded by rolling back to the mid-frame marker, and the frame
+/// is then rolled back to its start, or every eighth frame, reset, which coalesces the chain into a single block. Objects are never handed off.
+internal_function bool
+ChainedStressAllocate
+(
+    ALLOCATOR_TEST_STATE *state,
+    size_t          cache_index,
+    uint32_t          iteration,
+    uint32_t               &rng,
+    uint64_t           &encoded
+)
+{
+    size_t const             LAST = ALLOCATOR_CHAINED_FRAME::OBJECT_COUNT - 1;
+    OS_CHAINED_ARENA        *arena = &state->ChainedArenas[cache_index];
+    ALLOCATOR_CHAINED_FRAME *frame = &state->ChainedFrames[cache_index];
+    size_t                       i = iteration % ALLOCATOR_CHAINED_FRAME::OBJECT_COUNT;
+    size_t                    size = OsAlignUp(16 + (NextRandom(rng) % (i == LAST ? Kilobytes(32) - 16 : Kilobytes(4) - 16)), 16);
+    size_t                   align = (i & 7) == 0 ? 256 : 16;
+    uint8_t                *object = NULL;
+
+    encoded = 0;
+    if (i == 0)
+    {
+        frame->FrameStart = OsChainedArenaMark(arena);
+    }
+    if (i == ALLOCATOR_CHAINED_FRAME::OBJECT_COUNT / 2)
+    {   // everything allocated after this point is discarded by the rollback.
+        frame->MidFrame = OsChainedArenaMark(arena);
+    }
+    if ((object = (uint8_t*) OsChainedArenaAllocate(arena, size, align)) == NULL || ((uintptr_t) object & (align - 1)) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to allocate %Iu bytes aligned to %Iu from a chained arena.\n", __FUNCTION__, OsThreadId(), size, align);
+        return false;
+    }
+    if (state->StampBlocks)
+        StampBlock(object, size, (uint64_t)(uintptr_t) object);
+    frame->Objects[i] = object;
+    frame->Sizes  [i] = size;
+    if (i != LAST)
+        return true;
+
+    OsChainedArenaResetToMarker(arena, frame->MidFrame);
+    if (OsChainedArenaMark(arena) != frame->MidFrame)
+    {
+        OsLayerError("ERROR: %S(%u): Chained arena did not roll back to the mid-frame marker.\n", __FUNCTION__, OsThreadId());
+        return false;
+    }
+    for (size_t j = 0; j < ALLOCATOR_CHAINED_FRAME::OBJECT_COUNT / 2 && state->StampBlocks; ++j)
+    {
+        if (!CheckBlockStamp(frame->Objects[j], frame->Sizes[j], (uint64_t)(uintptr_t) frame->Objects[j]))
+        {
+            OsLayerError("ERROR: %S(%u): Object %Iu was overwritten before the frame was reset.\n", __FUNCTION__, OsThreadId(), j);
+            return false;
+        }
+    }
+    if (((iteration / ALLOCATOR_CHAINED_FRAME::OBJECT_COUNT) & 7) == 7)
+    {
+        OsChainedArenaReset(arena);
+        if (arena->BlockCount != 1 || OsChainedArenaMark(arena) != OS_CHAINED_ARENA::BLOCK_HEADER_SIZE)
+        {
+            OsLayerError("ERROR: %S(%u): Chained arena holds %Iu blocks after a reset.\n", __FUNCTION__, OsThreadId(), (size_t) arena->BlockCount);
+            return false;
+        }
+    }
+    else
+    {
+        OsChainedArenaResetToMarker(arena, frame->FrameStart);
+        if (OsChainedArenaMark(arena) != frame->FrameStart)
+        {
+            OsLayerError("ERROR: %S(%u): Chained arena did not roll back to the start of the frame.\n", __FUNCTION__, OsThreadId());
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @summary Check that every chained arena was rolled back to empty, that the arenas grew, and that no ArenaPool allocation failed.
+internal_function bool
+ChainedStressFinish
+(
+    ALLOCATOR_TEST_STATE *state
+)
+{
+    uint64_t grow_count = 0;
+    bool         passed = true;
+    OS_ALLOCATOR_STATS stats;
+    for (size_t i = 0, n = state->CacheCount; i < n; ++i)
+    {   // every thread leaves its arena as it found it.
+        OS_CHAINED_ARENA *arena = &state->ChainedArenas[i];
+        if (OsChainedArenaMark(arena) != OS_CHAINED_ARENA::BLOCK_HEADER_SIZE || arena->FailedCount != 0)
+        {
+            OsLayerError("ERROR: %S(%u): Chained arena %Iu is at offset %I64u with %I64u failed allocations.\n", __FUNCTION__, OsThreadId(), i, (uint64_t) OsChainedArenaMark(arena), arena->FailedCount);
+            passed = false;
+        }
+        grow_count += arena->GrowCount;
+    }
+    OsHostMemoryPoolQueryStats(&state->ArenaPool, &stats);
+    OsLayerError("STATUS: %I64u blocks acquired from the pool, %I64u by growing an arena, %I64u failed.\n", stats.AllocationCount, grow_count, stats.FailedCount);
+    if (stats.FailedCount != 0 || grow_count == 0)
+    {
+        OsLayerError("ERROR: %S(%u): The chained arenas grew %I64u times, with %I64u failed pool allocations.\n", __FUNCTION__, OsThreadId(), grow_count, stats.FailedCount);
+        passed = false;
+    }
+    return passed;
+}
+
+/// @summary Run an allocator stress workload on the calling thread. Each iteration allocates a block and hands it to another thread through the handoff slots.
+/// If the slots are full, or on some iterations if they are not, the iteration also frees a block, which may have been allocated by any thread.
+/// @param desc The workload to run.
+/// @param state The ALLOCATOR_TEST_STATE holding the allocator.
+/// @param cache_index The zero-based cache index of the calling thread. No other thread may use the same cache index at the same time.
+/// @param seed A value used to seed the random number generator of the calling thread.
+/// @param iterations The number of iterations to run. Must be a multiple of ALLOCATOR_CHAINED_FRAME::OBJECT_COUNT.
+/// @return true if the allocator behaved correctly.
+internal_function bool
+RunAllocatorStress
+(
+    ALLOCATOR_STRESS_DESC const *desc,
+    ALLOCATOR_TEST_STATE       *state,
+    size_t                cache_index,
+    uint32_t                     seed,
+    uint32_t               iterations
+)
+{
+    uint32_t rng = (seed + 1) * 0x9E3779B9U;
+    for (uint32_t n = 0; n < iterations; ++n)
+    {
+        uint64_t encoded = 0;
+        if (!desc->Allocate(state, cache_index, n, rng, encoded))
+            return false;
+        if (encoded != 0 && HandoffPush(state->Handoff, encoded, NextRandom(rng)))
+        {   // another thread frees the block.
+            encoded = 0;
+        }
+        if (encoded == 0 && desc->Free != NULL && (NextRandom(rng) & desc->PopMask) == 0)
+        {   // free a block allocated by any thread.
+            encoded = HandoffPop(state->Handoff, NextRandom(rng));
+        }
+        if (encoded != 0 && !desc->Free(state, cache_index, n, rng, encoded))
+            return false;
+    }
+    return true;
+}
+
+/// @summary Free the blocks left in the handoff slots once every thread running an allocator stress workload has finished, and check the allocator.
+/// @param desc The workload that was run.
+/// @param state The ALLOCATOR_TEST_STATE holding the allocator.
+/// @return true if the allocator behaved correctly.
+internal_function bool
+FinishAllocatorStress
+(
+    ALLOCATOR_STRESS_DESC const *desc,
+    ALLOCATOR_TEST_STATE       *state
+)
+{
+    uint32_t     rng = 0x9E3779B9U;
+    uint64_t encoded = 0;
+    bool      passed = true;
+    while (desc->Free != NULL && (encoded = HandoffPop(state->Handoff, 0)) != 0)
+    {
+        if (!desc->Free(state, SIZE_MAX, 1, rng, encoded))
+            passed = false;
+    }
+    return desc->Finish(state) && passed;
+}
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary Stress the concurrent buddy allocator and its per-thread caches, freeing most blocks into a cache other than the one they came from.
+global_variable ALLOCATOR_STRESS_DESC const BuddyStress   = { "Buddy"  , BuddyStressAllocate  , BuddyStressFree, BuddyStressFinish  , 0 };
+
+/// @summary Stress the slab allocator, freeing most objects into a magazine other than the one they came from, or to the remote list.
+global_variable ALLOCATOR_STRESS_DESC const SlabStress    = { "Slab"   , SlabStressAllocate   , SlabStressFree , SlabStressFinish   , 0 };
+
+/// @summary Stress the lock-protected TLSF allocator. Popping on only half of the iterations keeps the handoff slots nearly full, fragmenting the heap.
+global_variable ALLOCATOR_STRESS_DESC const TlsfStress    = { "Tlsf"   , TlsfStressAllocate   , TlsfStressFree , TlsfStressFinish   , 1 };
+
+/// @summary Stress the per-thread chained arenas, which acquire and release blocks from the shared ArenaPool concurrently.
+global_variable ALLOCATOR_STRESS_DESC const ChainedStress = { "Chained", ChainedStressAllocate, NULL           , ChainedStressFinish, 0 };
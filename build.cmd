@@ -52,6 +52,7 @@ cl %CPPFLAGS% ..\scheduler.cc %DEFINES% %LIBRARIES% %LNKFLAGS% /Fescheduler.exe
 cl %CPPFLAGS% ..\vulkan.cc %DEFINES% %LIBRARIES% %LNKFLAGS% /Fevulkan.exe
 cl %CPPFLAGS% ..\audio.cc %DEFINES% %LIBRARIES% %LNKFLAGS% /Feaudio.exe
 cl %CPPFLAGS% ..\filepath.cc %DEFINES% %LIBRARIES% %LNKFLAGS% /Fefilepath.exe
+cl %CPPFLAGS% ..\memory.cc %DEFINES% %LIBRARIES% %LNKFLAGS% /Fememory.exe
 POPD
 
 @ECHO Build complete.
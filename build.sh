@@ -0,0 +1,34 @@
+#!/bin/sh
+# Build the test programs that support Linux. Only the host memory subsystem
+# of win32_oslayer.cc is available on Linux, so only memory.cc is built here.
+# The task scheduler, and with it scheduler.cc and its benchmark report, is
+# Win32-only; build those with build.cmd.
+# Usage: ./build.sh [debug]
+
+OUTPUTDIR="$(cd "$(dirname "$0")" && pwd)/build"
+CXX=${CXX:-g++}
+
+DEFINES_DEBUG="-DDEBUG -D_DEBUG -DBUILD_STATIC"
+CPPFLAGS_DEBUG="-std=c++17 -Wall -Wextra -Werror -Wno-unknown-pragmas -Wno-unused-function -g -O0"
+
+DEFINES_RELEASE="-DBUILD_STATIC"
+CPPFLAGS_RELEASE="-std=c++17 -Wall -Wextra -Werror -Wno-unknown-pragmas -Wno-unused-function -g -O2"
+
+LIBRARIES="-lpthread"
+
+if [ "$1" = "debug" ]; then
+    DEFINES=$DEFINES_DEBUG
+    CPPFLAGS=$CPPFLAGS_DEBUG
+    echo "Building debug configuration..."
+else
+    DEFINES=$DEFINES_RELEASE
+    CPPFLAGS=$CPPFLAGS_RELEASE
+    echo "Building release configuration..."
+fi
+
+mkdir -p "$OUTPUTDIR"
+cd "$OUTPUTDIR" || exit 1
+$CXX $CPPFLAGS $DEFINES ../memory.cc $LIBRARIES -o memory || exit 1
+cd ..
+
+echo "Build complete."
@@ -0,0 +1,1548 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Test the host memory subsystem - the VMM wrappers, host memory
+/// pools and the allocators built on top of them. Unlike the other test
+/// programs, this one builds and runs on both Windows and Linux, so it is the
+/// only place the Linux VMM paths are exercised. Run with the name of one or
+/// more tests to run only those tests.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include "win32_oslayer.cc"
+#include "allocator_test.cc"
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Report a failed check and fail the calling test.
+/// @param _cond The condition that must hold for the test to continue.
+#define MEMORY_TEST_CHECK(_cond)                                               \
+    if (!(_cond)) {                                                            \
+        OsLayerError("FAILED: %S(%u): Check \"%S\" failed.\n", __FUNCTION__, (uint32_t) __LINE__, #_cond); \
+        return false;                                                          \
+    }
+
+/// @summary Define the signature of a memory subsystem test.
+/// @param pool The host memory pool available to the test. Every allocation made by the test must be returned before the test exits.
+/// @return true if the test passed.
+typedef bool (*MEMORY_TESTFUNC)(OS_HOST_MEMORY_POOL *pool);
+
+/// @summary Describe a single memory subsystem test.
+struct MEMORY_TEST_DESC
+{
+    char const         *Name;                        /// A nul-terminated string specifying the name of the test, used to select it on the command line.
+    MEMORY_TESTFUNC     Func;                        /// The function implementing the test.
+};
+
+/// @summary Define the data recorded by the memory pressure callbacks registered by TestMemoryBudget.
+struct MEMORY_PRESSURE_STATE
+{
+    OS_MEMORY_BUDGET   *Budget;                      /// The budget the callbacks are registered with.
+    OS_HOST_MEMORY_POOL *Pool;                       /// The pool the callbacks commit memory from.
+    uint32_t            CallCount;                   /// The number of times the callback was invoked.
+    uint32_t            MaxLevel;                    /// The highest OS_MEMORY_PRESSURE_LEVEL passed to the callback.
+    bool                Unlocked;                    /// Set if another thread could take the budget lock while the callback was running.
+    bool                Committed;                   /// Set if the callback could commit and release host memory.
+};
+
+/// @summary Define a fence attached to the frames of an OS_FRAME_ARENA by TestFrameArena.
+struct MEMORY_FRAME_FENCE
+{
+    bool                Signaled;                    /// Set once the work submitted during the frame has completed.
+    uint32_t            WaitCount;                   /// The number of times the frame arena waited on the fence.
+};
+
+/// @summary Define the data used by the relocate callback in TestBuddyCompaction, mapping block offsets to handles.
+struct MEMORY_COMPACT_HEAP
+{   static size_t const BLOCK_SIZE = 64;             /// The size of each allocated block, in bytes.
+    static size_t const BLOCK_COUNT= 16384;          /// The number of blocks in the heap.
+    uint8_t            *Base;                        /// The base address of the managed memory.
+    uint32_t           *OffsetToHandle;              /// BLOCK_COUNT entries mapping a block offset / BLOCK_SIZE to the handle of the block that lives there.
+    uint64_t           *HandleOffset;                /// BLOCK_COUNT entries mapping a handle to the current offset of its block.
+    bool               *HandlePinned;                /// BLOCK_COUNT entries, true if the block with a given handle may not be moved.
+    uint64_t            MoveCount;                   /// The number of blocks moved by the callback.
+    uint64_t            DeclineCount;                /// The number of moves declined by the callback.
+};
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Fill a block with a pattern derived from a seed value.
+/// @param dst The block to fill.
+/// @param size The number of bytes to fill.
+/// @param seed The seed identifying the pattern.
+internal_function void
+FillPattern
+(
+    void     *dst,
+    size_t   size,
+    uint32_t seed
+)
+{
+    uint8_t *p = (uint8_t*) dst;
+    for (size_t i = 0; i < size; ++i)
+    {
+        p[i] = (uint8_t)((i * 31) + seed);
+    }
+}
+
+/// @summary Determine whether a block contains the pattern written by FillPattern.
+/// @param src The block to check.
+/// @param size The number of bytes to check.
+/// @param seed The seed identifying the pattern.
+/// @return true if the block contains the pattern.
+internal_function bool
+CheckPattern
+(
+    void const *src,
+    size_t     size,
+    uint32_t   seed
+)
+{
+    uint8_t const *p = (uint8_t const*) src;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (p[i] != (uint8_t)((i * 31) + seed))
+            return false;
+    }
+    return true;
+}
+
+#if defined(__linux__)
+/// @summary Read a per-mapping value from /proc/self/smaps for the mapping containing a given address.
+/// @param address An address within the mapping.
+/// @param key The nul-terminated name of the field, including the trailing colon, for example "AnonHugePages:".
+/// @param value On return, set to the value of the field, in kilobytes.
+/// @return true if the mapping and field were found.
+internal_function bool
+QueryMappingValue
+(
+    void const *address,
+    char const     *key,
+    uint64_t     &value
+)
+{
+    FILE     *fp = NULL;
+    char line[512];
+    bool   found = false;
+    bool  inside = false;
+    size_t   len = strlen(key);
+    if ((fp = fopen("/proc/self/smaps", "r")) == NULL)
+        return false;
+    while (!found && fgets(line, sizeof(line), fp) != NULL)
+    {
+        unsigned long long beg = 0;
+        unsigned long long end = 0;
+        if (sscanf(line, "%llx-%llx ", &beg, &end) == 2 && strchr(line, '-') < strchr(line, ' '))
+        {   // start of a new mapping.
+            inside = (uintptr_t) address >= beg && (uintptr_t) address < end;
+        }
+        else if (inside && strncmp(line, key, len) == 0)
+        {
+            unsigned long long kb = 0;
+            found = sscanf(line + len, " %llu kB", &kb) == 1;
+            value = kb;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+#endif /* defined(__linux__) */
+
+/// @summary A no-op memory pressure callback.
+/// @param context Unused.
+/// @param level Unused.
+/// @param bytes_used Unused.
+/// @param bytes_limit Unused.
+internal_function void
+IgnoreMemoryPressure
+(
+    void       *context, 
+    uint32_t      level, 
+    uint64_t bytes_used, 
+    uint64_t bytes_limit
+)
+{
+    UNREFERENCED_PARAMETER(context);
+    UNREFERENCED_PARAMETER(level);
+    UNREFERENCED_PARAMETER(bytes_used);
+    UNREFERENCED_PARAMETER(bytes_limit);
+}
+
+/// @summary A memory pressure callback that records its invocations, and checks that the budget lock is not held and that host memory can be committed.
+/// @param context The MEMORY_PRESSURE_STATE to update.
+/// @param level One of OS_MEMORY_PRESSURE_LEVEL specifying the new pressure level.
+/// @param bytes_used The estimated number of bytes in use.
+/// @param bytes_limit The budget limit, in bytes.
+internal_function void
+RecordMemoryPressure
+(
+    void       *context, 
+    uint32_t      level, 
+    uint64_t bytes_used, 
+    uint64_t bytes_limit
+)
+{
+    MEMORY_PRESSURE_STATE *state = (MEMORY_PRESSURE_STATE*) context;
+    OS_HOST_MEMORY_ALLOCATION *mem = NULL;
+    UNREFERENCED_PARAMETER(bytes_used);
+    UNREFERENCED_PARAMETER(bytes_limit);
+    state->CallCount++;
+    state->MaxLevel = level > state->MaxLevel ? level : state->MaxLevel;
+    if (state->CallCount == 1)
+    {   // registration takes the budget lock, so this would deadlock if the lock were held during dispatch.
+        std::thread other([state] { state->Unlocked = OsMemoryBudgetRegisterCallback(state->Budget, OS_MEMORY_PRESSURE_LEVEL_CRITICAL, IgnoreMemoryPressure, NULL) == 0; });
+        other.join();
+        if ((mem = OsHostMemoryPoolAllocate(state->Pool, Megabytes(1), Megabytes(1), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL)
+        {
+            OsHostMemoryPoolRelease(state->Pool, mem);
+            state->Committed = true;
+        }
+    }
+}
+
+/// @summary Wait on a MEMORY_FRAME_FENCE. The fence is signaled or not; the wait never blocks.
+/// @param context The MEMORY_FRAME_FENCE to wait on.
+/// @param timeout_ns Unused.
+/// @return true if the fence is signaled.
+internal_function bool
+WaitFrameFence
+(
+    void        *context, 
+    uint64_t  timeout_ns
+)
+{
+    MEMORY_FRAME_FENCE *fence = (MEMORY_FRAME_FENCE*) context;
+    UNREFERENCED_PARAMETER(timeout_ns);
+    fence->WaitCount++;
+    return fence->Signaled;
+}
+
+/// @summary Move a live block for OsBuddyCompact and update the handle table, unless the block is pinned.
+/// @param context The MEMORY_COMPACT_HEAP.
+/// @param src_offset The current byte offset of the block.
+/// @param dst_offset The byte offset the block is being moved to.
+/// @param size The size of the block, in bytes.
+/// @return true if the block was moved.
+internal_function bool
+RelocateHeapBlock
+(
+    void        *context, 
+    uint64_t  src_offset, 
+    uint64_t  dst_offset, 
+    uint64_t        size
+)
+{
+    MEMORY_COMPACT_HEAP *heap = (MEMORY_COMPACT_HEAP*) context;
+    uint32_t          handle = heap->OffsetToHandle[src_offset / MEMORY_COMPACT_HEAP::BLOCK_SIZE];
+    if (heap->HandlePinned[handle])
+    {
+        heap->DeclineCount++;
+        return false;
+    }
+    memmove(heap->Base + dst_offset, heap->Base + src_offset, (size_t) size);
+    heap->OffsetToHandle[dst_offset / MEMORY_COMPACT_HEAP::BLOCK_SIZE] = handle;
+    heap->HandleOffset[handle] = dst_offset;
+    heap->MoveCount++;
+    return true;
+}
+
+/// @summary Reserve, commit, grow and release host memory allocations, and check the pool statistics.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestHostMemoryPool
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    OS_HOST_MEMORY_ALLOCATION *a = NULL;
+    OS_HOST_MEMORY_ALLOCATION *b = NULL;
+    OS_ALLOCATOR_STATS     stats = {};
+
+    MEMORY_TEST_CHECK((a = OsHostMemoryPoolAllocate(pool, Megabytes(4), Kilobytes(64), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    MEMORY_TEST_CHECK(a->BaseAddress != NULL && a->BytesReserved >= Megabytes(4) && a->BytesCommitted >= Kilobytes(64));
+    MEMORY_TEST_CHECK(a->GuardSize > 0);
+    FillPattern(a->BaseAddress, a->BytesCommitted, 1);
+    MEMORY_TEST_CHECK(OsHostMemoryIncreaseCommitment(a, Megabytes(4)) == 0);
+    MEMORY_TEST_CHECK(a->BytesCommitted == a->BytesReserved);
+    MEMORY_TEST_CHECK(CheckPattern(a->BaseAddress, Kilobytes(64), 1));
+    FillPattern(a->BaseAddress, a->BytesCommitted, 2);
+    MEMORY_TEST_CHECK(CheckPattern(a->BaseAddress, a->BytesCommitted, 2));
+    MEMORY_TEST_CHECK(OsHostMemoryIncreaseCommitment(a, Megabytes(8)) == 0); // clamped to the reservation.
+    MEMORY_TEST_CHECK(a->BytesCommitted == a->BytesReserved);
+
+    MEMORY_TEST_CHECK((b = OsHostMemoryPoolAllocate(pool, Kilobytes(16), Kilobytes(16), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE | OS_HOST_MEMORY_ALLOCATION_FLAG_NO_GUARD_PAGE)) != NULL);
+    MEMORY_TEST_CHECK(b->GuardSize == 0 && b->BytesCommitted >= Kilobytes(16));
+    OsZeroMemory(b->BaseAddress, b->BytesCommitted);
+
+    OsHostMemoryPoolQueryStats(pool, &stats);
+    MEMORY_TEST_CHECK(stats.BytesReserved  >= a->BytesReserved  + b->BytesReserved);
+    MEMORY_TEST_CHECK(stats.BytesCommitted >= a->BytesCommitted + b->BytesCommitted);
+    OsHostMemoryPoolRelease(pool, b);
+    OsHostMemoryPoolRelease(pool, a);
+    OsHostMemoryPoolQueryStats(pool, &stats);
+    MEMORY_TEST_CHECK(stats.BytesReserved == 0 && stats.BytesCommitted == 0);
+    return true;
+}
+
+/// @summary Allocate from a host memory arena, and check alignment, markers and exhaustion.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestHostMemoryArena
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    OS_HOST_MEMORY_ALLOCATION *mem = NULL;
+    OS_HOST_MEMORY_ARENA     arena = {};
+    os_arena_marker_t       marker = 0;
+    void                        *p = NULL;
+    void                        *q = NULL;
+
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, Megabytes(1), Megabytes(1), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    MEMORY_TEST_CHECK(OsCreateHostMemoryArena(&arena, OsInitHostMemoryRange(mem)) == 0);
+    MEMORY_TEST_CHECK((p = OsHostMemoryArenaAllocate(&arena, 100, 16)) != NULL);
+    MEMORY_TEST_CHECK(((uintptr_t) p & 15) == 0);
+    marker = OsHostMemoryArenaMark(&arena);
+    MEMORY_TEST_CHECK((q = OsHostMemoryArenaAllocate(&arena, 1000, 4096)) != NULL);
+    MEMORY_TEST_CHECK(((uintptr_t) q & 4095) == 0);
+    OsHostMemoryArenaResetToMarker(&arena, marker);
+    MEMORY_TEST_CHECK(OsHostMemoryArenaMark(&arena) == marker);
+    MEMORY_TEST_CHECK(OsHostMemoryArenaAllocate(&arena, Megabytes(2), 16) == NULL);
+    OsDeleteHostMemoryArena(&arena);
+    OsHostMemoryPoolRelease(pool, mem);
+    return true;
+}
+
+/// @summary Check the portable lock and timestamp functions used by the memory subsystem.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestPlatformPrimitives
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    OS_MUTEX  mutex;
+    uint64_t     t0 = OsTimestampInTicks();
+    uint64_t     t1 = 0;
+    UNREFERENCED_PARAMETER(pool);
+
+    MEMORY_TEST_CHECK(OsCreateMutex(&mutex, 0x1000) == 0);
+    OsLockMutex(&mutex);
+    MEMORY_TEST_CHECK(OsTryLockMutex(&mutex)); // the lock is recursive.
+    OsUnlockMutex(&mutex);
+    OsUnlockMutex(&mutex);
+    OsDeleteMutex(&mutex);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    t1 = OsTimestampInTicks();
+    MEMORY_TEST_CHECK(t1 > t0);
+    MEMORY_TEST_CHECK(OsElapsedNanoseconds(t0, t1) >= 1000000ULL);
+    MEMORY_TEST_CHECK(OsThreadId() != 0);
+    return true;
+}
+
+/// @summary Allocate host memory backed by large pages, and check that the allocation falls back to normal pages when large pages are unavailable.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestHostMemoryLargePages
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    OS_HOST_MEMORY_ALLOCATION *mem = NULL;
+    size_t              large_page = OsVmmQueryLargePageSize();
+
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, Megabytes(3), Megabytes(1), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE | OS_HOST_MEMORY_ALLOCATION_FLAG_LARGE_PAGES)) != NULL);
+    MEMORY_TEST_CHECK(mem->BytesCommitted >= Megabytes(1) && mem->BytesReserved >= Megabytes(3));
+    if (large_page != 0 && mem->PageSize == large_page)
+    {   // large pages were used. the reservation and commitment are rounded up to whole large pages.
+        MEMORY_TEST_CHECK(((uintptr_t) mem->BaseAddress & (large_page - 1)) == 0);
+        MEMORY_TEST_CHECK((mem->BytesReserved  & (large_page - 1)) == 0);
+        MEMORY_TEST_CHECK((mem->BytesCommitted & (large_page - 1)) == 0);
+        FillPattern(mem->BaseAddress, mem->BytesCommitted, 3);
+#if defined(__linux__)
+        uint64_t huge_kb = 0;
+        uint64_t page_kb = 0;
+        MEMORY_TEST_CHECK(QueryMappingValue(mem->BaseAddress, "KernelPageSize:", page_kb));
+        if (page_kb * 1024 == large_page)
+        {   // the range came from the reserved hugetlbfs pool, and is fully committed with no guard page.
+            MEMORY_TEST_CHECK(mem->GuardSize == 0 && mem->BytesCommitted == mem->BytesReserved);
+            OsLayerOutput("STATUS: Large pages backed by hugetlbfs (%I64u KB pages).\n", page_kb);
+        }
+        else
+        {   // the range is eligible for transparent huge pages. the kernel may still decline to back it.
+            MEMORY_TEST_CHECK(QueryMappingValue(mem->BaseAddress, "AnonHugePages:", huge_kb));
+            OsLayerOutput("STATUS: Large pages backed by transparent huge pages (%I64u KB of %Iu KB).\n", huge_kb, mem->BytesCommitted / 1024);
+        }
+#endif
+        MEMORY_TEST_CHECK(OsHostMemoryIncreaseCommitment(mem, mem->BytesReserved) == 0);
+        MEMORY_TEST_CHECK(mem->BytesCommitted == mem->BytesReserved);
+        FillPattern(mem->BaseAddress, mem->BytesCommitted, 4);
+        MEMORY_TEST_CHECK(CheckPattern(mem->BaseAddress, mem->BytesCommitted, 4));
+    }
+    else
+    {   // large pages are unavailable, and the allocation silently fell back to normal pages.
+        OsLayerOutput("STATUS: Large pages are unavailable; using %Iu byte pages.\n", mem->PageSize);
+        MEMORY_TEST_CHECK(mem->PageSize == pool->PageSize);
+        FillPattern(mem->BaseAddress, mem->BytesCommitted, 3);
+        MEMORY_TEST_CHECK(CheckPattern(mem->BaseAddress, mem->BytesCommitted, 3));
+    }
+    OsHostMemoryPoolRelease(pool, mem);
+    return true;
+}
+
+/// @summary Allocate host memory with each NUMA placement policy, and check where the pages are placed.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestHostMemoryNuma
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    OS_HOST_MEMORY_ALLOCATION *mem = NULL;
+    uint32_t const           flags = OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE;
+    int32_t                   node = -1;
+
+    // bind to node 0, which exists on every host.
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, Megabytes(1), Megabytes(1), flags, OS_HOST_MEMORY_NUMA_POLICY_BIND, 0)) != NULL);
+    MEMORY_TEST_CHECK(mem->NumaPolicy == OS_HOST_MEMORY_NUMA_POLICY_BIND && mem->NumaNode == 0);
+    FillPattern(mem->BaseAddress, mem->BytesCommitted, 5);
+    MEMORY_TEST_CHECK((node = OsHostMemoryQueryNumaNode(mem->BaseAddress)) == 0);
+    MEMORY_TEST_CHECK((node = OsHostMemoryQueryNumaNode(mem->BaseAddress + mem->BytesCommitted - 1)) == 0);
+#if defined(__linux__)
+    int mode = -1;
+    MEMORY_TEST_CHECK(syscall(SYS_get_mempolicy, &mode, NULL, 0, mem->BaseAddress, MPOL_F_ADDR) == 0);
+    MEMORY_TEST_CHECK(mode == MPOL_BIND);
+#endif
+    OsHostMemoryPoolRelease(pool, mem);
+
+    // interleave across the nodes the process may allocate from.
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, Megabytes(1), Megabytes(1), flags, OS_HOST_MEMORY_NUMA_POLICY_INTERLEAVE, 0)) != NULL);
+    FillPattern(mem->BaseAddress, mem->BytesCommitted, 6);
+    MEMORY_TEST_CHECK((node = OsHostMemoryQueryNumaNode(mem->BaseAddress)) >= 0);
+#if defined(__linux__)
+    MEMORY_TEST_CHECK(syscall(SYS_get_mempolicy, &mode, NULL, 0, mem->BaseAddress, MPOL_F_ADDR) == 0);
+    MEMORY_TEST_CHECK(mode == MPOL_INTERLEAVE);
+#endif
+    MEMORY_TEST_CHECK(CheckPattern(mem->BaseAddress, mem->BytesCommitted, 6));
+    OsHostMemoryPoolRelease(pool, mem);
+
+    // the pool default policy applies when none is specified.
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, Megabytes(1), Megabytes(1), flags)) != NULL);
+    MEMORY_TEST_CHECK(mem->NumaPolicy == pool->NumaPolicy);
+    OsHostMemoryPoolRelease(pool, mem);
+
+#if defined(__linux__)
+    // node indices beyond the mbind node mask are rejected before calling into the kernel.
+    MEMORY_TEST_CHECK(!OsVmmSetNumaPolicy(NULL, 0, OS_HOST_MEMORY_NUMA_POLICY_BIND, 1024));
+    MEMORY_TEST_CHECK(OsHostMemoryPoolAllocate(pool, Megabytes(1), Megabytes(1), flags, OS_HOST_MEMORY_NUMA_POLICY_BIND, 1024) == NULL);
+#endif
+    return true;
+}
+
+/// @summary Trim the pages of a host memory arena above its watermark, and check that live data is kept and the pages are returned to the operating system.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestHostMemoryArenaTrim
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    OS_HOST_MEMORY_ALLOCATION *mem = NULL;
+    OS_HOST_MEMORY_ARENA     arena = {};
+    uint8_t                  *live = NULL;
+    uint8_t                 *spike = NULL;
+    size_t                 trimmed = 0;
+
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, Megabytes(4), Megabytes(4), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    MEMORY_TEST_CHECK(OsCreateHostMemoryArena(&arena, OsInitHostMemoryRange(mem)) == 0);
+    MEMORY_TEST_CHECK((live = (uint8_t*) OsHostMemoryArenaAllocate(&arena, Kilobytes(64), 16)) != NULL);
+    FillPattern(live, Kilobytes(64), 7);
+
+    // a one-off spike touches 3MB above the live data.
+    os_arena_marker_t marker = OsHostMemoryArenaMark(&arena);
+    MEMORY_TEST_CHECK((spike = (uint8_t*) OsHostMemoryArenaAllocate(&arena, Megabytes(3), 16)) != NULL);
+    FillPattern(spike, Megabytes(3), 8);
+    OsHostMemoryArenaResetToMarker(&arena, marker);
+    MEMORY_TEST_CHECK(OsHostMemoryArenaHighWaterMark(&arena) >= Kilobytes(64) + Megabytes(3));
+
+    // nothing is released when less than the hysteresis amount lies above the watermark.
+    MEMORY_TEST_CHECK(OsHostMemoryArenaTrim(&arena, Megabytes(3), Megabytes(1)) == 0);
+#if defined(__linux__)
+    uint64_t rss_kb_before  = 0;
+    uint64_t rss_kb_after   = 0;
+    uint64_t lazy_kb_after  = 0;
+    MEMORY_TEST_CHECK(QueryMappingValue(mem->BaseAddress, "Rss:", rss_kb_before));
+#endif
+    // the spike is released, and the live data is kept.
+    MEMORY_TEST_CHECK((trimmed = OsHostMemoryArenaTrim(&arena, 0, Megabytes(1))) >= Megabytes(3) - mem->PageSize);
+    MEMORY_TEST_CHECK(CheckPattern(live, Kilobytes(64), 7));
+#if defined(__linux__)
+    // MADV_FREE pages stay in Rss until the kernel reclaims them, but are reported as LazyFree.
+    MEMORY_TEST_CHECK(QueryMappingValue(mem->BaseAddress, "Rss:", rss_kb_after));
+    MEMORY_TEST_CHECK(QueryMappingValue(mem->BaseAddress, "LazyFree:", lazy_kb_after) || rss_kb_after < rss_kb_before);
+    // pages still held in per-CPU LRU batches are not counted yet, so allow some slack.
+    MEMORY_TEST_CHECK((rss_kb_before > rss_kb_after ? rss_kb_before - rss_kb_after : 0) + lazy_kb_after >= (trimmed / 1024) * 3 / 4);
+    OsLayerOutput("STATUS: Trimmed %Iu KB (Rss %I64u KB -> %I64u KB, LazyFree %I64u KB).\n", trimmed / 1024, rss_kb_before, rss_kb_after, lazy_kb_after);
+#endif
+    // the trimmed range remains committed and usable.
+    MEMORY_TEST_CHECK((spike = (uint8_t*) OsHostMemoryArenaAllocate(&arena, Megabytes(3), 16)) != NULL);
+    FillPattern(spike, Megabytes(3), 9);
+    MEMORY_TEST_CHECK(CheckPattern(spike, Megabytes(3), 9));
+    MEMORY_TEST_CHECK(CheckPattern(live, Kilobytes(64), 7));
+    OsDeleteHostMemoryArena(&arena);
+    OsHostMemoryPoolRelease(pool, mem);
+    return true;
+}
+
+/// @summary Rotate a frame arena through several generations, and check that each frame reuses the oldest generation, 
+/// that an unsignaled fence holds the generation back without disturbing the current frame, and the per-generation statistics.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestFrameArena
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    uint32_t const  GENERATION_COUNT = 3;
+    uint32_t const       FRAME_COUNT = 10;
+    size_t const          FRAME_SIZE = Kilobytes(1);
+    OS_HOST_MEMORY_ALLOCATION   *mem = NULL;
+    OS_FRAME_ARENA             arena = {};
+    OS_ALLOCATOR_STATS         stats = {};
+    MEMORY_FRAME_FENCE fences[FRAME_COUNT] = {};
+    MEMORY_FRAME_FENCE       pending = {};
+    uint8_t          *frames[FRAME_COUNT];
+    size_t              used[FRAME_COUNT];
+    uint8_t                  *parked = NULL;
+    uint8_t                       *p = NULL;
+    size_t               parked_used = 0;
+    size_t                    p_used = 0;
+    size_t                slice_size = 0;
+
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, Megabytes(3), Megabytes(3), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    MEMORY_TEST_CHECK(OsCreateFrameArena(&arena, OsInitHostMemoryRange(mem), 0) != 0);
+    MEMORY_TEST_CHECK(OsCreateFrameArena(&arena, OsInitHostMemoryRange(mem), OS_FRAME_ARENA::MAX_GENERATIONS + 1) != 0);
+    MEMORY_TEST_CHECK(OsCreateFrameArena(&arena, OsInitHostMemoryRange(mem), GENERATION_COUNT) == 0);
+    MEMORY_TEST_CHECK((slice_size = arena.Generations[0].Arena.HostMemory.SizeInBytes) == Megabytes(1));
+
+    // frame 0 begins when the arena is created, so there is no earlier frame to query.
+    MEMORY_TEST_CHECK(arena.FrameIndex == 0 && arena.CurrentGeneration == 0);
+    MEMORY_TEST_CHECK(OsFrameArenaQueryStats(&arena, 0, &stats) && stats.BytesLive == 0);
+    MEMORY_TEST_CHECK(!OsFrameArenaQueryStats(&arena, 1, &stats));
+
+    // each frame reuses the oldest generation, while the previous GENERATION_COUNT-1 frames keep their data and their end-of-frame usage.
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+    {
+        uint8_t *base = (uint8_t*) mem->BaseAddress + (i % GENERATION_COUNT) * slice_size;
+        if (i > 0)
+        {
+            MEMORY_TEST_CHECK(OsFrameArenaBeginFrame(&arena, 0));
+        }
+        if (i >= GENERATION_COUNT)
+        {   // the generation was reclaimed only after waiting on the fence of the frame that last used it.
+            MEMORY_TEST_CHECK(fences[i - GENERATION_COUNT].WaitCount == 1);
+        }
+        MEMORY_TEST_CHECK(arena.FrameIndex == i && arena.CurrentGeneration == i % GENERATION_COUNT);
+        MEMORY_TEST_CHECK(OsFrameArenaQueryStats(&arena, 0, &stats) && stats.BytesLive == 0);
+        MEMORY_TEST_CHECK((frames[i] = (uint8_t*) OsFrameArenaAllocate(&arena, FRAME_SIZE * (i + 1), 16)) != NULL);
+        MEMORY_TEST_CHECK(frames[i] >= base && frames[i] < base + slice_size);
+        MEMORY_TEST_CHECK(i < GENERATION_COUNT || frames[i] == frames[i - GENERATION_COUNT]);
+        FillPattern(frames[i], FRAME_SIZE * (i + 1), i);
+        used[i] = (size_t)(frames[i] - base) + FRAME_SIZE * (i + 1);
+        MEMORY_TEST_CHECK(OsFrameArenaQueryStats(&arena, 0, &stats) && stats.BytesLive == used[i]);
+        for (uint32_t j = 1; j < GENERATION_COUNT; ++j)
+        {
+            if (j > i)
+            {   // the frame has not occurred.
+                MEMORY_TEST_CHECK(!OsFrameArenaQueryStats(&arena, j, &stats));
+                continue;
+            }
+            MEMORY_TEST_CHECK(CheckPattern(frames[i - j], FRAME_SIZE * (i - j + 1), i - j));
+            MEMORY_TEST_CHECK(OsFrameArenaQueryStats(&arena, j, &stats) && stats.BytesLive == used[i - j]);
+        }
+        MEMORY_TEST_CHECK(!OsFrameArenaQueryStats(&arena, GENERATION_COUNT, &stats));
+        fences[i].Signaled = true;
+        OsFrameArenaEndFrame(&arena, WaitFrameFence, &fences[i]);
+    }
+
+    // hold back the generation of the next frame with a fence that has not been signaled.
+    MEMORY_TEST_CHECK(OsFrameArenaBeginFrame(&arena, 0));
+    MEMORY_TEST_CHECK((parked = (uint8_t*) OsFrameArenaAllocate(&arena, FRAME_SIZE, 16)) != NULL);
+    FillPattern(parked, FRAME_SIZE, 100);
+    parked_used = (size_t)(parked - arena.Generations[arena.CurrentGeneration].Arena.HostMemory.HostAddress) + FRAME_SIZE;
+    OsFrameArenaEndFrame(&arena, WaitFrameFence, &pending);
+    for (uint32_t i = 1; i < GENERATION_COUNT; ++i)
+    {
+        MEMORY_TEST_CHECK(OsFrameArenaBeginFrame(&arena, 0));
+        OsFrameArenaEndFrame(&arena, NULL, NULL);
+    }
+    MEMORY_TEST_CHECK(arena.FrameIndex == FRAME_COUNT + GENERATION_COUNT - 1);
+    MEMORY_TEST_CHECK((p = (uint8_t*) OsFrameArenaAllocate(&arena, FRAME_SIZE * 2, 16)) != NULL);
+    FillPattern(p, FRAME_SIZE * 2, 101);
+    p_used = (size_t)(p - arena.Generations[arena.CurrentGeneration].Arena.HostMemory.HostAddress) + FRAME_SIZE * 2;
+    OsFrameArenaEndFrame(&arena, NULL, NULL);
+
+    // the frame does not advance, and neither the current frame nor the parked generation is reset.
+    MEMORY_TEST_CHECK(!OsFrameArenaBeginFrame(&arena, 0));
+    MEMORY_TEST_CHECK(pending.WaitCount == 1);
+    MEMORY_TEST_CHECK(arena.FrameIndex == FRAME_COUNT + GENERATION_COUNT - 1);
+    MEMORY_TEST_CHECK(arena.CurrentGeneration == (FRAME_COUNT + GENERATION_COUNT - 1) % GENERATION_COUNT);
+    MEMORY_TEST_CHECK(OsFrameArenaQueryStats(&arena, 0, &stats) && stats.BytesLive == p_used);
+    MEMORY_TEST_CHECK(OsFrameArenaQueryStats(&arena, GENERATION_COUNT - 1, &stats) && stats.BytesLive == parked_used);
+    MEMORY_TEST_CHECK(CheckPattern(p, FRAME_SIZE * 2, 101));
+    MEMORY_TEST_CHECK(CheckPattern(parked, FRAME_SIZE, 100));
+
+    // once the fence is signaled, the parked generation is reset and becomes current.
+    pending.Signaled = true;
+    MEMORY_TEST_CHECK(OsFrameArenaBeginFrame(&arena, 0));
+    MEMORY_TEST_CHECK(pending.WaitCount == 2);
+    MEMORY_TEST_CHECK(arena.FrameIndex == FRAME_COUNT + GENERATION_COUNT);
+    MEMORY_TEST_CHECK(OsFrameArenaQueryStats(&arena, 0, &stats) && stats.BytesLive == 0);
+    MEMORY_TEST_CHECK(OsFrameArenaAllocate(&arena, FRAME_SIZE, 16) == parked);
+    MEMORY_TEST_CHECK(OsFrameArenaQueryStats(&arena, 1, &stats) && stats.BytesLive == p_used);
+    OsDeleteFrameArena(&arena);
+    OsHostMemoryPoolRelease(pool, mem);
+    return true;
+}
+
+/// @summary Write records to a magic ring buffer from one and from several producer threads, and check that records wrapping the end of the buffer read back contiguously.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestMagicRingBuffer
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    size_t const     RECORD_SIZE = 100;   // not a divisor of the capacity, so records straddle the wrap point.
+    size_t const    THREAD_COUNT = 4;
+    size_t const RECORDS_PER_THREAD = 20000;
+    OS_MAGIC_RING_BUFFER    ring;
+    std::thread     producers[THREAD_COUNT];
+    uint32_t        next_seq[THREAD_COUNT] = {};
+    size_t                 bytes = 0;
+    size_t              received = 0;
+    uint8_t                   *p = NULL;
+    UNREFERENCED_PARAMETER(pool);
+
+    MEMORY_TEST_CHECK(OsCreateMagicRingBuffer(&ring, 1) == 0);
+    MEMORY_TEST_CHECK(ring.Capacity >= 4096 && (ring.Capacity & (ring.Capacity - 1)) == 0);
+
+    // both views are backed by the same pages.
+    ring.BaseAddress[0] = 0xA5;
+    ring.BaseAddress[ring.Capacity - 1] = 0x5A;
+    MEMORY_TEST_CHECK(ring.BaseAddress[ring.Capacity] == 0xA5);
+    MEMORY_TEST_CHECK(ring.BaseAddress[ring.Capacity * 2 - 1] == 0x5A);
+
+    // single producer: write and read back records through several wraps.
+    for (uint32_t i = 0; i < uint32_t((ring.Capacity * 8) / RECORD_SIZE); ++i)
+    {
+        MEMORY_TEST_CHECK((p = (uint8_t*) OsMagicRingBufferWriteBegin(&ring, bytes)) != NULL && bytes >= RECORD_SIZE);
+        FillPattern(p, RECORD_SIZE, i);
+        OsMagicRingBufferWriteEnd(&ring, RECORD_SIZE);
+        MEMORY_TEST_CHECK((p = (uint8_t*) OsMagicRingBufferReadBegin(&ring, bytes)) != NULL && bytes == RECORD_SIZE);
+        MEMORY_TEST_CHECK(CheckPattern(p, RECORD_SIZE, i));
+        OsMagicRingBufferReadEnd(&ring, RECORD_SIZE);
+    }
+
+    OsDeleteMagicRingBuffer(&ring);
+
+    // multiple producers: each record stores the producer index and a per-producer sequence number, followed by a pattern.
+    // the two ways of writing cannot be mixed on one ring, since WriteEnd does not advance the reserve cursor.
+    MEMORY_TEST_CHECK(OsCreateMagicRingBuffer(&ring, 1) == 0);
+    for (size_t t = 0; t < THREAD_COUNT; ++t)
+    {
+        producers[t] = std::thread([&ring, t, RECORD_SIZE, RECORDS_PER_THREAD]
+        {
+            for (uint32_t seq = 0; seq < RECORDS_PER_THREAD; )
+            {
+                uint64_t cursor = 0;
+                uint8_t   *data = (uint8_t*) OsMagicRingBufferReserve(&ring, RECORD_SIZE, cursor);
+                if (data == NULL)
+                {   // the buffer is full. wait for the consumer.
+                    std::this_thread::yield();
+                    continue;
+                }
+                uint32_t header[2] = { (uint32_t) t, seq };
+                memcpy(data, header, sizeof(header));
+                FillPattern(data + sizeof(header), RECORD_SIZE - sizeof(header), seq + (uint32_t) t);
+                OsMagicRingBufferCommit(&ring, cursor, RECORD_SIZE);
+                seq++;
+            }
+        });
+    }
+    while (received < THREAD_COUNT * RECORDS_PER_THREAD)
+    {
+        p = (uint8_t*) OsMagicRingBufferReadBegin(&ring, bytes);
+        if (bytes < RECORD_SIZE)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t offset = 0; offset + RECORD_SIZE <= bytes; offset += RECORD_SIZE, ++received)
+        {
+            uint32_t header[2];
+            memcpy(header, p + offset, sizeof(header));
+            if (header[0] >= THREAD_COUNT || header[1] != next_seq[header[0]] || !CheckPattern(p + offset + sizeof(header), RECORD_SIZE - sizeof(header), header[1] + header[0]))
+            {
+                for (size_t t = 0; t < THREAD_COUNT; ++t) producers[t].detach();
+                MEMORY_TEST_CHECK(!"record is out of order or corrupt");
+            }
+            next_seq[header[0]]++;
+        }
+        OsMagicRingBufferReadEnd(&ring, bytes - (bytes % RECORD_SIZE));
+    }
+    for (size_t t = 0; t < THREAD_COUNT; ++t)
+    {
+        producers[t].join();
+        MEMORY_TEST_CHECK(next_seq[t] == RECORDS_PER_THREAD);
+    }
+    MEMORY_TEST_CHECK(ring.WriteCursor.load() == ring.ReadCursor.load());
+    OsDeleteMagicRingBuffer(&ring);
+    return true;
+}
+
+/// @summary Prefault host memory on one and on several threads, and check that the pages become resident and existing contents are kept.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestHostMemoryPrefault
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    OS_HOST_MEMORY_ALLOCATION *mem = NULL;
+    size_t const              SIZE = Megabytes(16);
+#if defined(__linux__)
+    uint64_t                rss_kb = 0;
+#endif
+
+    // single thread, unaligned range. live data in the first page is kept.
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, SIZE, SIZE, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    FillPattern(mem->BaseAddress, 1000, 10);
+#if defined(__linux__)
+    MEMORY_TEST_CHECK(QueryMappingValue(mem->BaseAddress, "Rss:", rss_kb) && rss_kb < SIZE / 2048);
+#endif
+    MEMORY_TEST_CHECK(OsHostMemoryPrefault(mem->BaseAddress + 100, Megabytes(4) - 200));
+    MEMORY_TEST_CHECK(CheckPattern(mem->BaseAddress, 1000, 10));
+#if defined(__linux__)
+    MEMORY_TEST_CHECK(QueryMappingValue(mem->BaseAddress, "Rss:", rss_kb) && rss_kb >= Megabytes(4) / 1024);
+#endif
+    MEMORY_TEST_CHECK(OsHostMemoryPrefault(mem->BaseAddress, 0));
+    OsHostMemoryPoolRelease(pool, mem);
+
+    // several threads, bound to NUMA node 0.
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, SIZE, SIZE, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE, OS_HOST_MEMORY_NUMA_POLICY_BIND, 0)) != NULL);
+    FillPattern(mem->BaseAddress + SIZE - 1000, 1000, 11);
+    MEMORY_TEST_CHECK(OsHostMemoryPrefaultParallel(mem, 4));
+    MEMORY_TEST_CHECK(CheckPattern(mem->BaseAddress + SIZE - 1000, 1000, 11));
+#if defined(__linux__)
+    MEMORY_TEST_CHECK(QueryMappingValue(mem->BaseAddress, "Rss:", rss_kb) && rss_kb >= SIZE / 1024);
+#endif
+    MEMORY_TEST_CHECK(OsHostMemoryQueryNumaNode(mem->BaseAddress + SIZE / 2) == 0);
+    OsHostMemoryPoolRelease(pool, mem);
+    return true;
+}
+
+/// @summary Detect the memory limit of the process and read its current usage. On Linux, run in a cgroup with memory.max set to exercise the cgroup path.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestMemoryBudgetLimit
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    OS_MEMORY_BUDGET           budget;
+    OS_MEMORY_BUDGET_STATUS    status;
+    UNREFERENCED_PARAMETER(pool);
+
+    MEMORY_TEST_CHECK(OsCreateMemoryBudget(&budget, NULL) == 0);
+    OsMemoryBudgetQuery(&budget, &status);
+    OsLayerOutput("STATUS: Memory limit %I64u KB (source %u), usage %I64u KB.\n", status.Limit / 1024, status.LimitSource, status.SystemUsage / 1024);
+    MEMORY_TEST_CHECK(status.Limit > 0 && status.SystemUsage > 0 && status.SystemUsage < status.Limit);
+    MEMORY_TEST_CHECK(status.LimitSource == OS_MEMORY_BUDGET_SOURCE_PHYSICAL || status.LimitSource == OS_MEMORY_BUDGET_SOURCE_CGROUP || status.LimitSource == OS_MEMORY_BUDGET_SOURCE_JOB_OBJECT);
+    MEMORY_TEST_CHECK(status.Level == OsMemoryBudgetPressureLevel(&budget, status.SystemUsage));
+#if defined(__linux__)
+    MEMORY_TEST_CHECK((status.LimitSource == OS_MEMORY_BUDGET_SOURCE_CGROUP) == (budget.UsagePath[0] != '\0'));
+#endif
+    OsDeleteMemoryBudget(&budget);
+    return true;
+}
+
+/// @summary Drive a budget with a limit just above the current usage through its pressure levels until commits are refused.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestMemoryBudget
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    size_t const           BLOCK_SIZE = Megabytes(4);
+    size_t const          BLOCK_COUNT = 48;
+    OS_HOST_MEMORY_ALLOCATION *blocks[BLOCK_COUNT] = {};
+    OS_MEMORY_BUDGET           budget;
+    OS_MEMORY_BUDGET_INIT        init = {};
+    OS_MEMORY_BUDGET_STATUS    status;
+    MEMORY_PRESSURE_STATE    moderate = {};
+    MEMORY_PRESSURE_STATE    critical = {};
+    OS_ALLOCATION_TRACE         trace;
+    size_t                      count = 0;
+    bool                      refused = false;
+
+    // read the current usage, then override the limit so the moderate level is entered after committing 16MB, the critical level after 24MB and commits fail after 32MB.
+    MEMORY_TEST_CHECK(OsCreateMemoryBudget(&budget, NULL) == 0);
+    OsMemoryBudgetQuery(&budget, &status);
+    OsDeleteMemoryBudget(&budget);
+    init.LimitOverride     = status.SystemUsage + Megabytes(40);
+    init.ModeratePercent   = uint32_t(((status.SystemUsage + Megabytes(16)) * 100) / init.LimitOverride);
+    init.CriticalPercent   = uint32_t(((status.SystemUsage + Megabytes(24)) * 100) / init.LimitOverride);
+    init.RefusePercent     = uint32_t(((status.SystemUsage + Megabytes(32)) * 100) / init.LimitOverride);
+    init.RefreshInterval   = Megabytes(8);
+    MEMORY_TEST_CHECK(OsCreateMemoryBudget(&budget, &init) == 0);
+    MEMORY_TEST_CHECK(budget.LimitSource == OS_MEMORY_BUDGET_SOURCE_OVERRIDE && budget.Limit == init.LimitOverride);
+    moderate.Budget = critical.Budget = &budget;
+    moderate.Pool   = critical.Pool   = pool;
+    MEMORY_TEST_CHECK(OsMemoryBudgetRegisterCallback(&budget, OS_MEMORY_PRESSURE_LEVEL_MODERATE, RecordMemoryPressure, &moderate) == 0);
+    MEMORY_TEST_CHECK(OsMemoryBudgetRegisterCallback(&budget, OS_MEMORY_PRESSURE_LEVEL_CRITICAL, RecordMemoryPressure, &critical) == 0);
+    MEMORY_TEST_CHECK(OsSetMemoryBudget(&budget) == NULL);
+
+    // storage committed internally is charged too.
+    MEMORY_TEST_CHECK(OsCreateAllocationTrace(&trace, 4096) == 0);
+    MEMORY_TEST_CHECK(budget.BytesCharged.load() == (int64_t) trace.StorageSize);
+    OsDeleteAllocationTrace(&trace);
+    MEMORY_TEST_CHECK(budget.BytesCharged.load() == 0);
+
+    // touch each block, so the usage re-read from the operating system agrees with the charges.
+    for (count = 0; count < BLOCK_COUNT; ++count)
+    {
+        if ((blocks[count] = OsHostMemoryPoolAllocate(pool, BLOCK_SIZE, BLOCK_SIZE, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) == NULL)
+        {
+            refused = true;
+            break;
+        }
+        FillPattern(blocks[count]->BaseAddress, BLOCK_SIZE, (uint32_t) count);
+    }
+    OsMemoryBudgetQuery(&budget, &status);
+    OsLayerOutput("STATUS: Refused after %Iu MB; %I64u dispatches, estimated usage %I64u KB.\n", (count * BLOCK_SIZE) / Megabytes(1), status.DispatchCount, status.EstimatedUsage / 1024);
+    MEMORY_TEST_CHECK(refused && count >= 4 && status.RefusedCount == 1);
+    MEMORY_TEST_CHECK(status.Level == OS_MEMORY_PRESSURE_LEVEL_CRITICAL && status.DispatchCount >= 2);
+    MEMORY_TEST_CHECK(moderate.CallCount >= 2 && moderate.MaxLevel == OS_MEMORY_PRESSURE_LEVEL_CRITICAL);
+    MEMORY_TEST_CHECK(critical.CallCount >= 1 && critical.MaxLevel == OS_MEMORY_PRESSURE_LEVEL_CRITICAL);
+    MEMORY_TEST_CHECK(moderate.Unlocked && moderate.Committed && critical.Unlocked && critical.Committed);
+
+    // releasing the memory drops the level once usage falls below the thresholds less the hysteresis.
+    while (count > 0)
+    {
+        OsHostMemoryPoolRelease(pool, blocks[--count]);
+    }
+    MEMORY_TEST_CHECK(OsMemoryBudgetUpdate(&budget) == OS_MEMORY_PRESSURE_LEVEL_NONE);
+    MEMORY_TEST_CHECK(OsSetMemoryBudget(NULL) == &budget);
+    OsMemoryBudgetUnregisterCallback(&budget, RecordMemoryPressure, &moderate);
+    OsMemoryBudgetUnregisterCallback(&budget, RecordMemoryPressure, &critical);
+    OsMemoryBudgetUnregisterCallback(&budget, IgnoreMemoryPressure, NULL);
+    OsMemoryBudgetUnregisterCallback(&budget, IgnoreMemoryPressure, NULL);
+    MEMORY_TEST_CHECK(budget.CallbackCount == 0);
+    OsDeleteMemoryBudget(&budget);
+    return true;
+}
+
+/// @summary Check the bulk memory kernels for each instruction set supported by the host against memcpy, memset and memcmp, for every 
+/// small size and misalignment, and for sizes around the streaming threshold.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestMemoryRoutines
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    size_t const      THRESHOLD = 4096;
+    size_t const    BUFFER_SIZE = Kilobytes(128);
+    size_t const     SIZE_COUNT = 301 + 129 + 2;
+    size_t                sizes[SIZE_COUNT];
+    OS_HOST_MEMORY_ALLOCATION *mem = NULL;
+    OS_MEMORY_ROUTINES    routines;
+    uint8_t                   *src = NULL;
+    uint8_t                   *dst = NULL;
+    uint8_t                   *ref = NULL;
+    size_t                   count = 0;
+
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, BUFFER_SIZE * 3, BUFFER_SIZE * 3, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    src = mem->BaseAddress;
+    dst = mem->BaseAddress + BUFFER_SIZE;
+    ref = mem->BaseAddress + BUFFER_SIZE * 2;
+    FillPattern(src, BUFFER_SIZE, 7);
+    for (size_t i = 0; i <= 300; ++i)
+        sizes[count++] = i;
+    for (size_t i = THRESHOLD - 64; i <= THRESHOLD + 64; ++i)
+        sizes[count++] = i;
+    sizes[count++] = THRESHOLD * 3 + 37;
+    sizes[count++] = Kilobytes(64) + 13;
+
+    for (int32_t isa = OS_MEMORY_ISA_SSE2; isa <= OS_MEMORY_ISA_AVX512; ++isa)
+    {
+        if (OsSelectMemoryRoutines(isa, THRESHOLD) != isa)
+        {
+            OsLayerOutput("STATUS: Instruction set %d is not supported by the host; skipping.\n", isa);
+            continue;
+        }
+        OsQueryMemoryRoutines(&routines);
+        MEMORY_TEST_CHECK(routines.StreamingThreshold == THRESHOLD);
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t   size = sizes[i];
+            // every pairing of misalignments for small sizes; the cost of larger sizes limits them to 64 pairings.
+            for (size_t pair = 0, npair = size <= 300 ? 64 * 64 : 64; pair < npair; ++pair)
+            {
+                size_t doff = pair % 64;
+                size_t soff = size <= 300 ? pair / 64 : (pair * 7) % 64;
+                uint8_t val = (uint8_t)(size + pair);
+                memset(dst, 0xCC, size + 128);
+                memset(ref, 0xCC, size + 128);
+                OsCopyMemory(dst + doff, src + soff, size);
+                memcpy(ref + doff, src + soff, size);
+                MEMORY_TEST_CHECK(memcmp(dst, ref, size + 128) == 0);
+                OsFillMemory(dst + doff, size, val);
+                memset(ref + doff, val, size);
+                MEMORY_TEST_CHECK(memcmp(dst, ref, size + 128) == 0);
+                OsZeroMemory(dst + doff, size);
+                memset(ref + doff, 0, size);
+                MEMORY_TEST_CHECK(memcmp(dst, ref, size + 128) == 0);
+            }
+            // the sign of the result must match memcmp, including for bytes that are negative when treated as signed.
+            for (size_t doff = 0; doff < 64; ++doff)
+            {
+                size_t soff = (doff * 13) % 64;
+                memcpy(dst + doff, src + soff, size);
+                MEMORY_TEST_CHECK(OsCompareMemory(dst + doff, src + soff, size) == 0);
+                if (size == 0)
+                    continue;
+                size_t where[3] = { 0, size / 2, size - 1 };
+                for (size_t w = 0; w < 3; ++w)
+                {
+                    uint8_t  old = dst[doff + where[w]];
+                    dst[doff + where[w]] = 0x80;
+                    src[soff + where[w]] = 0x7F;
+                    MEMORY_TEST_CHECK(OsCompareMemory(dst + doff, src + soff, size) > 0 && OsCompareMemory(src + soff, dst + doff, size) < 0);
+                    dst[doff + where[w]] = 0x00;
+                    MEMORY_TEST_CHECK(OsCompareMemory(dst + doff, src + soff, size) < 0 && OsCompareMemory(src + soff, dst + doff, size) > 0);
+                    dst[doff + where[w]] = old;
+                    src[soff + where[w]] = old;
+                }
+                MEMORY_TEST_CHECK(OsCompareMemory(dst + doff, src + soff, size) == 0);
+            }
+        }
+    }
+    OsSelectMemoryRoutines(OS_MEMORY_ISA_AUTO, 0);
+    OsHostMemoryPoolRelease(pool, mem);
+    return true;
+}
+
+/// @summary Split and merge blocks in buddy allocators, check them against a reference model, cover reserved ranges, manage 
+/// offsets beyond 4GB, and check that metadata for a large range is committed lazily and reset per-level.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestBuddyAllocator
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    size_t const       LIVE_MAX = 256;
+    OS_BUDDY_ALLOCATOR    buddy;
+    OS_BUDDY_ALLOCATOR_INIT init;
+    OS_ALLOCATOR_STATS    stats;
+    OS_BUDDY_BLOCK_INFO    info;
+    OS_MEMORY_RANGE        live[LIVE_MAX];
+    OS_MEMORY_RANGE       range;
+    OS_MEMORY_RANGE       other;
+    size_t           live_count = 0;
+    uint32_t               seed = 12345;
+    UNREFERENCED_PARAMETER(pool);
+
+    // split and merge: the first minimum-size block splits every level, and freeing it merges them again.
+    init.AllocationSizeMin = 16;
+    init.AllocationSizeMax = 4096;
+    init.BytesReserved     = 0;
+    MEMORY_TEST_CHECK(OsCreateBuddyAllocator(&buddy, &init) == 0);
+    MEMORY_TEST_CHECK(buddy.LevelCount == 9 && buddy.LevelMask == 1);
+    MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, 1, 1, range) && range.ByteOffset == 0 && range.SizeInBytes == 16);
+    MEMORY_TEST_CHECK(buddy.LevelMask == 0x1FE);
+    MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, 16, 16, other) && other.ByteOffset == 16);
+    MEMORY_TEST_CHECK(buddy.LevelMask == 0x0FE);
+    MEMORY_TEST_CHECK(OsBuddyAllocatorBlockInfo(&info, &buddy, 16) && info.LevelIndex == 8 && info.BuddyIndex == 0);
+    MEMORY_TEST_CHECK(!OsBuddyAllocatorBlockInfo(&info, &buddy, 32));
+    OsBuddyFree(&buddy, range);
+    MEMORY_TEST_CHECK(buddy.LevelMask == 0x1FE);
+    OsBuddyFree(&buddy, other);
+    MEMORY_TEST_CHECK(buddy.LevelMask == 1 && buddy.BytesLive == 0);
+
+    // reallocate: grow into a free buddy, shrink in place, and move when the buddy is live.
+    MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, 100, 16, range) && range.ByteOffset == 0 && range.SizeInBytes == 128);
+    MEMORY_TEST_CHECK(OsBuddyReallocate(&buddy, range, 200, 16, range) && range.ByteOffset == 0 && range.SizeInBytes == 256);
+    MEMORY_TEST_CHECK(OsBuddyReallocate(&buddy, range, 20, 16, range) && range.ByteOffset == 0 && range.SizeInBytes == 32);
+    MEMORY_TEST_CHECK(OsBuddyBlockSize(&buddy, 0) == 32 && buddy.BytesLive == 32);
+    MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, 32, 16, other) && other.ByteOffset == 32);
+    MEMORY_TEST_CHECK(OsBuddyReallocate(&buddy, range, 64, 16, range) && range.ByteOffset == 64 && range.SizeInBytes == 64);
+    OsBuddyFree(&buddy, range);
+    OsBuddyFree(&buddy, other);
+    MEMORY_TEST_CHECK(buddy.LevelMask == 1 && buddy.BytesLive == 0);
+
+    // random allocations and frees, checked against the set of live blocks.
+    for (uint32_t iter = 0; iter < 20000; ++iter)
+    {
+        seed = seed * 1103515245U + 12345U;
+        if (live_count > 0 && (live_count == LIVE_MAX || (seed >> 16) % 3 == 0))
+        {
+            size_t victim = (seed >> 8) % live_count;
+            OsBuddyFree(&buddy, live[victim]);
+            live[victim] = live[--live_count];
+        }
+        else
+        {
+            size_t size = 1 + ((seed >> 12) % 300);
+            if (!OsBuddyAllocate(&buddy, size, 16, range))
+                continue;
+            MEMORY_TEST_CHECK(range.SizeInBytes >= size && (range.SizeInBytes & (range.SizeInBytes - 1)) == 0);
+            MEMORY_TEST_CHECK((range.ByteOffset & (range.SizeInBytes - 1)) == 0 && range.ByteOffset + range.SizeInBytes <= 4096);
+            MEMORY_TEST_CHECK(OsBuddyBlockSize(&buddy, range.ByteOffset) == range.SizeInBytes);
+            for (size_t i = 0; i < live_count; ++i)
+            {
+                MEMORY_TEST_CHECK(range.ByteOffset + range.SizeInBytes <= live[i].ByteOffset || live[i].ByteOffset + live[i].SizeInBytes <= range.ByteOffset);
+            }
+            live[live_count++] = range;
+        }
+    }
+    while (live_count > 0)
+    {
+        OsBuddyFree(&buddy, live[--live_count]);
+    }
+    OsBuddyAllocatorQueryStats(&buddy, &stats);
+    MEMORY_TEST_CHECK(stats.BytesLive == 0 && stats.BytesFree == 4096 && stats.LargestFreeBlock == 4096);
+    OsDeleteBuddyAllocator(&buddy);
+
+    // reserved ranges are covered exactly, rounded up to the minimum block size.
+    size_t const reserved_sizes[] = { 1, 16, 17, 100, 1000, 2047, 2048, 3000, 4095 - 16 };
+    for (size_t r = 0; r < sizeof(reserved_sizes) / sizeof(reserved_sizes[0]); ++r)
+    {
+        size_t reserve_end = OsAlignUp(reserved_sizes[r], 16);
+        size_t       count = 0;
+        init.BytesReserved = reserved_sizes[r];
+        MEMORY_TEST_CHECK(OsCreateBuddyAllocator(&buddy, &init) == 0);
+        OsBuddyAllocatorQueryStats(&buddy, &stats);
+        MEMORY_TEST_CHECK(stats.BytesFree == 4096 - reserve_end);
+        while (OsBuddyAllocate(&buddy, 16, 16, range))
+        {
+            MEMORY_TEST_CHECK(range.ByteOffset >= reserve_end);
+            count++;
+        }
+        MEMORY_TEST_CHECK(count * 16 == 4096 - reserve_end);
+        OsDeleteBuddyAllocator(&buddy);
+    }
+
+    // offsets beyond 4GB, in a 1TB range with 1MB blocks.
+    init.AllocationSizeMin = Megabytes(1);
+    init.AllocationSizeMax = size_t(1) << 40;
+    init.BytesReserved     = Megabytes(3);
+    MEMORY_TEST_CHECK(OsCreateBuddyAllocator(&buddy, &init) == 0);
+    MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, size_t(1) << 39, 1, range) && range.ByteOffset == (size_t(1) << 39));
+    MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, size_t(1) << 32, 1, other) && other.ByteOffset == (size_t(1) << 32));
+    MEMORY_TEST_CHECK(OsBuddyBlockSize(&buddy, other.ByteOffset) == (size_t(1) << 32));
+    MEMORY_TEST_CHECK(OsBuddyAllocatorBlockInfo(&info, &buddy, range.ByteOffset) && info.LevelIndex == 1 && info.BlockIndex == 1);
+    MEMORY_TEST_CHECK(OsBuddyReallocate(&buddy, other, size_t(1) << 33, 1, other) && other.ByteOffset == (size_t(1) << 33));
+    OsBuddyFree(&buddy, range);
+    OsBuddyFree(&buddy, other);
+    OsBuddyAllocatorQueryStats(&buddy, &stats);
+    MEMORY_TEST_CHECK(stats.BytesLive == 0 && stats.LargestFreeBlock == (uint64_t(1) << 39));
+    OsDeleteBuddyAllocator(&buddy);
+
+    // a 64GB range of 16-byte blocks has 1.5GB of metadata, of which only the pages that are written are committed.
+    init.AllocationSizeMin = 16;
+    init.AllocationSizeMax = size_t(1) << 36;
+    init.BytesReserved     = 0;
+    MEMORY_TEST_CHECK(OsCreateBuddyAllocator(&buddy, &init) == 0);
+    OsLayerOutput("STATUS: Buddy metadata %Iu KB reserved, %Iu KB committed.\n", buddy.MetadataSize / 1024, buddy.MetadataCommitted / 1024);
+    MEMORY_TEST_CHECK(buddy.MetadataSize >= Megabytes(1024) && buddy.MetadataCommitted <= Megabytes(1));
+    for (size_t i = 0; i < LIVE_MAX; ++i)
+    {
+        MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, 16, 16, live[i]) && live[i].ByteOffset == i * 16);
+    }
+    MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, size_t(1) << 35, 1, range) && range.ByteOffset == (size_t(1) << 35));
+    MEMORY_TEST_CHECK(!OsBuddyAllocatorBlockInfo(&info, &buddy, (size_t(1) << 34) + 16));
+    MEMORY_TEST_CHECK(buddy.MetadataCommitted <= Megabytes(1));
+    size_t committed = buddy.MetadataCommitted;
+    OsBuddyReset(&buddy);
+    MEMORY_TEST_CHECK(buddy.LevelsUsed == 1 && buddy.LevelMask == 1 && buddy.MetadataCommitted == committed);
+    for (size_t i = 0; i < LIVE_MAX; ++i)
+    {
+        MEMORY_TEST_CHECK(!OsBuddyAllocatorBlockInfo(&info, &buddy, i * 16));
+        MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, 16, 16, live[i]) && live[i].ByteOffset == i * 16);
+    }
+    for (size_t i = 0; i < LIVE_MAX; ++i)
+    {
+        OsBuddyFree(&buddy, live[i]);
+    }
+    MEMORY_TEST_CHECK(buddy.LevelMask == 1 && buddy.BytesLive == 0 && buddy.MetadataCommitted == committed);
+    OsDeleteBuddyAllocator(&buddy);
+    return true;
+}
+
+/// @summary Fragment a buddy heap by freeing every other block, then compact it in bounded passes with some blocks pinned, and check 
+/// that the data follows the handles, pinned blocks stay put, the pass budgets are honored, and a large allocation then succeeds.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestBuddyCompaction
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    size_t const          BLOCK_SIZE = MEMORY_COMPACT_HEAP::BLOCK_SIZE;
+    size_t const         BLOCK_COUNT = MEMORY_COMPACT_HEAP::BLOCK_COUNT;
+    size_t const           HEAP_SIZE = BLOCK_SIZE * BLOCK_COUNT;
+    size_t const          TABLE_SIZE = BLOCK_COUNT * (sizeof(uint32_t) + sizeof(uint64_t) + sizeof(bool));
+    OS_HOST_MEMORY_ALLOCATION   *mem = NULL;
+    OS_BUDDY_ALLOCATOR         buddy;
+    OS_BUDDY_ALLOCATOR_INIT     init;
+    OS_BUDDY_COMPACT_RESULT   result;
+    OS_ALLOCATOR_STATS         stats;
+    OS_MEMORY_RANGE            range;
+    MEMORY_COMPACT_HEAP         heap;
+    uint32_t                  passes = 0;
+
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, HEAP_SIZE + TABLE_SIZE, HEAP_SIZE + TABLE_SIZE, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    heap.Base           = mem->BaseAddress;
+    heap.HandleOffset   =(uint64_t*)(mem->BaseAddress + HEAP_SIZE);
+    heap.OffsetToHandle =(uint32_t*)(mem->BaseAddress + HEAP_SIZE + BLOCK_COUNT * sizeof(uint64_t));
+    heap.HandlePinned   =(bool    *)(mem->BaseAddress + HEAP_SIZE + BLOCK_COUNT * (sizeof(uint64_t) + sizeof(uint32_t)));
+    heap.MoveCount      = 0;
+    heap.DeclineCount   = 0;
+    init.AllocationSizeMin = BLOCK_SIZE;
+    init.AllocationSizeMax = HEAP_SIZE;
+    init.BytesReserved     = 0;
+    MEMORY_TEST_CHECK(OsCreateBuddyAllocator(&buddy, &init) == 0);
+
+    // fill the heap, then free every other block. pin a few survivors, including the last, which the compactor would otherwise move.
+    for (uint32_t handle = 0; handle < BLOCK_COUNT; ++handle)
+    {
+        MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, BLOCK_SIZE, BLOCK_SIZE, range) && range.ByteOffset == handle * BLOCK_SIZE);
+        FillPattern(heap.Base + range.ByteOffset, BLOCK_SIZE, handle);
+        heap.OffsetToHandle[handle] = handle;
+        heap.HandleOffset[handle]   = range.ByteOffset;
+        heap.HandlePinned[handle]   =((handle % 4096) == 0 && handle < BLOCK_COUNT / 2) || handle == BLOCK_COUNT - 2;
+    }
+    for (uint32_t handle = 1; handle < BLOCK_COUNT; handle += 2)
+    {
+        range.ByteOffset  =(size_t) heap.HandleOffset[handle];
+        range.SizeInBytes = BLOCK_SIZE;
+        OsBuddyFree(&buddy, range);
+        heap.HandleOffset[handle] = UINT64_MAX;
+    }
+    OsBuddyAllocatorQueryStats(&buddy, &stats);
+    MEMORY_TEST_CHECK(stats.BytesFree == HEAP_SIZE / 2 && stats.LargestFreeBlock == BLOCK_SIZE);
+    MEMORY_TEST_CHECK(!OsBuddyAllocate(&buddy, BLOCK_SIZE * 2, BLOCK_SIZE, range));
+
+    // a byte budget smaller than a block still moves one block.
+    MEMORY_TEST_CHECK(!OsBuddyCompact(&buddy, RelocateHeapBlock, &heap, 1, &result));
+    MEMORY_TEST_CHECK(result.BlocksMoved == 1 && result.BytesMoved == BLOCK_SIZE && !result.Complete);
+
+    // with an unlimited byte budget, a pass stops once it has examined MAX_COMPACT_PROBES blocks.
+    MEMORY_TEST_CHECK(!OsBuddyCompact(&buddy, RelocateHeapBlock, &heap, UINT64_MAX, &result));
+    MEMORY_TEST_CHECK(result.BlocksMoved > 0 && result.BlocksMoved < OS_BUDDY_ALLOCATOR::MAX_COMPACT_PROBES);
+
+    // bounded passes until no further compaction is possible.
+    for (passes = 0; passes < 100000; ++passes)
+    {
+        bool done = OsBuddyCompact(&buddy, RelocateHeapBlock, &heap, BLOCK_SIZE * 16, &result);
+        MEMORY_TEST_CHECK(result.BytesMoved <= BLOCK_SIZE * 16);
+        if (done)
+            break;
+    }
+    OsBuddyAllocatorQueryStats(&buddy, &stats);
+    OsLayerOutput("STATUS: Compacted in %u passes; moved %I64u blocks, %I64u declined, largest free block %I64u KB.\n", passes, heap.MoveCount, heap.DeclineCount, stats.LargestFreeBlock / 1024);
+    MEMORY_TEST_CHECK(result.Complete && heap.DeclineCount > 0);
+    MEMORY_TEST_CHECK(stats.BytesFree == HEAP_SIZE / 2 && stats.LargestFreeBlock >= HEAP_SIZE / 4);
+
+    // every block followed its handle, and pinned blocks did not move.
+    for (uint32_t handle = 0; handle < BLOCK_COUNT; handle += 2)
+    {
+        uint64_t offset = heap.HandleOffset[handle];
+        MEMORY_TEST_CHECK(OsBuddyBlockSize(&buddy, (size_t) offset) == BLOCK_SIZE);
+        MEMORY_TEST_CHECK(CheckPattern(heap.Base + offset, BLOCK_SIZE, handle));
+        MEMORY_TEST_CHECK(!heap.HandlePinned[handle] || offset == handle * BLOCK_SIZE);
+    }
+    MEMORY_TEST_CHECK(OsBuddyAllocate(&buddy, HEAP_SIZE / 4, BLOCK_SIZE, range));
+    OsDeleteBuddyAllocator(&buddy);
+    OsHostMemoryPoolRelease(pool, mem);
+    return true;
+}
+
+/// @summary Allocate from a concurrent arena on several threads at once, and check that deleting and re-creating the arena invalidates outstanding chunks.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestConcurrentArena
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    size_t const          ARENA_SIZE = Megabytes(8);
+    size_t const        THREAD_COUNT = 8;
+    size_t const         ALLOCS_EACH = 4096;
+    OS_HOST_MEMORY_ALLOCATION   *mem = NULL;
+    OS_CONCURRENT_ARENA        arena = {};
+    OS_CONCURRENT_ARENA_CHUNK  chunk = {};
+    std::thread threads[THREAD_COUNT];
+    bool         passed[THREAD_COUNT];
+    uint8_t                       *p = NULL;
+
+    // NextOffset must not share a cache line with the read-mostly fields, or with anything adjacent to the arena.
+    MEMORY_TEST_CHECK(std::alignment_of<OS_CONCURRENT_ARENA>::value == OS_CACHELINE_SIZE);
+    MEMORY_TEST_CHECK(((uintptr_t) &arena.NextOffset & (OS_CACHELINE_SIZE - 1)) == 0);
+    MEMORY_TEST_CHECK((uintptr_t) &arena.HostMemory - (uintptr_t) &arena.NextOffset >= OS_CACHELINE_SIZE);
+
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, ARENA_SIZE, ARENA_SIZE, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    MEMORY_TEST_CHECK(OsCreateConcurrentArena(&arena, OsInitHostMemoryRange(mem), 4096) == 0);
+
+    // a request that does not fit, or whose size overflows, fails without consuming any of the arena.
+    MEMORY_TEST_CHECK(OsConcurrentArenaAllocate(&arena, ARENA_SIZE + 1, 1) == NULL);
+    MEMORY_TEST_CHECK(OsConcurrentArenaAllocate(&arena, SIZE_MAX, 16) == NULL);
+    MEMORY_TEST_CHECK(OsConcurrentArenaAllocate(&arena, &chunk, SIZE_MAX, 16) == NULL);
+    MEMORY_TEST_CHECK(arena.NextOffset.load(std::memory_order_relaxed) == 0);
+    MEMORY_TEST_CHECK(OsConcurrentArenaAllocate(&arena, ARENA_SIZE - 64, 1) == mem->BaseAddress);
+    MEMORY_TEST_CHECK(OsConcurrentArenaAllocate(&arena, 128, 1) == NULL);
+    MEMORY_TEST_CHECK(OsConcurrentArenaAllocate(&arena, 64, 1) == (uint8_t*) mem->BaseAddress + ARENA_SIZE - 64);
+    MEMORY_TEST_CHECK(arena.NextOffset.load(std::memory_order_relaxed) == ARENA_SIZE);
+    OsConcurrentArenaReset(&arena);
+
+    // each thread fills its blocks with a pattern, then checks that no other thread overwrote them.
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        threads[i] = std::thread([&arena, &passed, i]
+        {
+            OS_CONCURRENT_ARENA_CHUNK local = {};
+            uint8_t        *blocks[ALLOCS_EACH];
+            passed[i] = true;
+            for (size_t j = 0; j < ALLOCS_EACH; ++j)
+            {
+                size_t     size = 16 + ((i * 131 + j * 17) % 160);
+                size_t    align = size_t(1) << (j % 7);
+                uint8_t *block  = (uint8_t*)((j % 64) == 0 ? OsConcurrentArenaAllocate(&arena, size, align) : OsConcurrentArenaAllocate(&arena, &local, size, align));
+                if (block == NULL || ((uintptr_t) block & (align - 1)) != 0)
+                {
+                    passed[i] = false;
+                    return;
+                }
+                FillPattern(block, size, (uint32_t)(i * ALLOCS_EACH + j));
+                blocks[j] = block;
+            }
+            for (size_t j = 0; j < ALLOCS_EACH; ++j)
+            {
+                size_t size = 16 + ((i * 131 + j * 17) % 160);
+                if (!CheckPattern(blocks[j], size, (uint32_t)(i * ALLOCS_EACH + j)))
+                    passed[i] = false;
+            }
+        });
+    }
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        threads[i].join();
+        MEMORY_TEST_CHECK(passed[i]);
+    }
+
+    // a chunk acquired before a delete must not be used once the arena is re-created over the same memory.
+    MEMORY_TEST_CHECK((p = (uint8_t*) OsConcurrentArenaAllocate(&arena, &chunk, 64, 16)) != NULL);
+    MEMORY_TEST_CHECK(p != mem->BaseAddress);
+    OsDeleteConcurrentArena(&arena);
+    MEMORY_TEST_CHECK(OsCreateConcurrentArena(&arena, OsInitHostMemoryRange(mem), 4096) == 0);
+    MEMORY_TEST_CHECK(chunk.Generation != arena.Generation.load(std::memory_order_relaxed));
+    MEMORY_TEST_CHECK(OsConcurrentArenaAllocate(&arena, &chunk, 64, 16) == mem->BaseAddress);
+    MEMORY_TEST_CHECK(arena.NextOffset.load(std::memory_order_relaxed) == 4096);
+
+    // re-creating without a delete also invalidates the chunk.
+    MEMORY_TEST_CHECK(OsCreateConcurrentArena(&arena, OsInitHostMemoryRange(mem), 4096) == 0);
+    MEMORY_TEST_CHECK(chunk.Generation != arena.Generation.load(std::memory_order_relaxed));
+    MEMORY_TEST_CHECK(OsConcurrentArenaAllocate(&arena, &chunk, 64, 16) == mem->BaseAddress);
+
+    // the generation never returns to zero, which zero-initialized chunks hold.
+    arena.Generation.store(UINT32_MAX - 1, std::memory_order_relaxed);
+    OsDeleteConcurrentArena(&arena);
+    MEMORY_TEST_CHECK(OsCreateConcurrentArena(&arena, OsInitHostMemoryRange(mem), 4096) == 0);
+    MEMORY_TEST_CHECK(arena.Generation.load(std::memory_order_relaxed) != 0);
+    OsDeleteConcurrentArena(&arena);
+    OsHostMemoryPoolRelease(pool, mem);
+    return true;
+}
+
+/// @summary Record events from several threads into a small allocation trace, so that writers lap the ring, while another thread reads it, 
+/// and check that no record returned by the reader is torn.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestAllocationTrace
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    size_t const        THREAD_COUNT = 8;
+    size_t const        RECORD_COUNT = 100000;
+    size_t const           READ_SIZE = 256;
+    OS_ALLOCATION_TRACE        trace;
+    OS_ALLOCATION_TRACE_RECORD records[READ_SIZE];
+    std::thread threads[THREAD_COUNT];
+    uint64_t       last[THREAD_COUNT];
+    std::atomic<uint32_t>       done(0);
+    uint64_t          read_index = 0;
+    uint64_t          read_count = 0;
+    bool                  passed = true;
+    UNREFERENCED_PARAMETER(pool);
+
+    MEMORY_TEST_CHECK(OsCreateAllocationTrace(&trace, 4) == 0);
+    MEMORY_TEST_CHECK(OsSetAllocationTrace(&trace) == NULL);
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {   // every field of a record is derived from the same value, so a record mixing two writers is detected.
+        last[i] = 0;
+        threads[i] = std::thread([&done, i]
+        {
+            for (uint64_t n = 1; n <= RECORD_COUNT; ++n)
+            {
+                uint64_t value = (uint64_t(i) << 32) | n;
+                OsAllocationTraceRecord((void const*)(uintptr_t)(i + 1), (void const*)(uintptr_t) value, (uint32_t) i, value, ~value, (uint32_t) value ^ 0x5A5A5A5AU);
+            }
+            done.fetch_add(1);
+        });
+    }
+    for ( ; ; )
+    {
+        bool   finished = done.load() == THREAD_COUNT;
+        size_t    count = OsAllocationTraceRead(&trace, read_index, records, READ_SIZE);
+        for (size_t j = 0; j < count; ++j)
+        {
+            OS_ALLOCATION_TRACE_RECORD &r = records[j];
+            uint64_t                thread = r.Offset >> 32;
+            if (thread >= THREAD_COUNT || r.Event != thread || r.Allocator != (void const*)(uintptr_t)(thread + 1) || r.Caller != (void const*)(uintptr_t) r.Offset || 
+                r.Size != ~r.Offset || r.Alignment != ((uint32_t) r.Offset ^ 0x5A5A5A5AU) || (r.Offset & 0xFFFFFFFFU) <= last[thread])
+            {   // the record is torn, or records from one thread were returned out of order.
+                passed = false;
+                break;
+            }
+            last[thread] = r.Offset & 0xFFFFFFFFU;
+        }
+        read_count += count;
+        if (finished && count == 0)
+            break;
+    }
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        threads[i].join();
+    }
+    OsLayerOutput("STATUS: Read %I64u of %I64u trace records.\n", read_count, trace.WriteIndex.load());
+    MEMORY_TEST_CHECK(passed);
+    MEMORY_TEST_CHECK(trace.WriteIndex.load() == THREAD_COUNT * RECORD_COUNT);
+
+    // once the writers finish, the last Capacity records are all readable.
+    read_index = 0;
+    MEMORY_TEST_CHECK(OsAllocationTraceRead(&trace, read_index, records, READ_SIZE) == trace.Capacity);
+    MEMORY_TEST_CHECK(read_index == THREAD_COUNT * RECORD_COUNT);
+
+    // a writer whose slot was claimed by a writer from a later lap drops its record, rather than writing over the newer one.
+    read_index = trace.WriteIndex.load();
+    trace.Slots[read_index & (trace.Capacity - 1)].Sequence.store(((read_index + trace.Capacity) * 2) + 1);
+    OsAllocationTraceRecord(&trace, NULL, 0, 0, 0, 0);
+    MEMORY_TEST_CHECK(trace.Slots[read_index & (trace.Capacity - 1)].Sequence.load() == ((read_index + trace.Capacity) * 2) + 1);
+    MEMORY_TEST_CHECK(trace.Slots[read_index & (trace.Capacity - 1)].Record.Allocator != &trace);
+    MEMORY_TEST_CHECK(OsAllocationTraceRead(&trace, read_index, records, READ_SIZE) == 0);
+    MEMORY_TEST_CHECK(OsSetAllocationTrace(NULL) == &trace);
+    OsDeleteAllocationTrace(&trace);
+    return true;
+}
+
+/// @summary Run an allocator stress workload on several threads at once, each with its own thread cache and chained arena, and check the allocator once every thread has finished.
+/// @param pool The host memory pool available to the test.
+/// @param desc The workload to run.
+/// @return true if the test passed.
+internal_function bool
+RunAllocatorStressThreads
+(
+    OS_HOST_MEMORY_POOL         *pool, 
+    ALLOCATOR_STRESS_DESC const *desc
+)
+{
+    size_t const        THREAD_COUNT = 8;
+    uint32_t const        ITERATIONS = 16384;
+    OS_HOST_MEMORY_ALLOCATION   *mem = NULL;
+    ALLOCATOR_TEST_STATE       state;
+    std::thread threads[THREAD_COUNT];
+    bool         passed[THREAD_COUNT];
+    bool                    finished = false;
+
+    MEMORY_TEST_CHECK((mem = OsHostMemoryPoolAllocate(pool, AllocatorTestMemorySize(THREAD_COUNT), AllocatorTestMemorySize(THREAD_COUNT), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) != NULL);
+    MEMORY_TEST_CHECK(CreateAllocatorTestState(&state, mem->BaseAddress, THREAD_COUNT) == 0);
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        threads[i] = std::thread([desc, &state, &passed, i]
+        {
+            passed[i] = RunAllocatorStress(desc, &state, i, (uint32_t) i, ITERATIONS);
+        });
+    }
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        threads[i].join();
+    }
+    finished = FinishAllocatorStress(desc, &state);
+    DeleteAllocatorTestState(&state);
+    OsHostMemoryPoolRelease(pool, mem);
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        MEMORY_TEST_CHECK(passed[i]);
+    }
+    MEMORY_TEST_CHECK(finished);
+    return true;
+}
+
+/// @summary Allocate and free blocks from a concurrent buddy allocator on several threads at once, handing most blocks to other threads to free,
+/// and check that no block is handed out twice and that every block is merged back once the caches are flushed.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestConcurrentBuddyStress
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    return RunAllocatorStressThreads(pool, &BuddyStress);
+}
+
+/// @summary Allocate and free objects from a slab allocator on several threads at once, handing most objects to other threads to free and returning one
+/// in four through the lock-free remote list, and check that every object carved from a slab ends up on exactly one free list.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestSlabStress
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    return RunAllocatorStressThreads(pool, &SlabStress);
+}
+
+/// @summary Allocate, reallocate and free blocks from a lock-protected TLSF allocator on several threads at once, handing most blocks to other threads to free,
+/// and check that block contents survive reallocation and that all free space merges back into a single block.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestTlsfStress
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    return RunAllocatorStressThreads(pool, &TlsfStress);
+}
+
+/// @summary Run a frame loop on several threads at once, each with its own chained arena acquiring blocks from a shared host memory pool, and check that
+/// rolling back to a marker preserves earlier objects and that every arena returns to empty.
+/// @param pool The host memory pool available to the test.
+/// @return true if the test passed.
+internal_function bool
+TestChainedArenaStress
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    return RunAllocatorStressThreads(pool, &ChainedStress);
+}
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary The set of memory subsystem tests, in the order they are run.
+global_variable MEMORY_TEST_DESC const MemoryTests[] =
+{
+    { "primitives"  , TestPlatformPrimitives   },
+    { "hostpool"    , TestHostMemoryPool       },
+    { "hostarena"   , TestHostMemoryArena      },
+    { "arenatrim"   , TestHostMemoryArenaTrim  },
+    { "framearena"  , TestFrameArena           },
+    { "largepages"  , TestHostMemoryLargePages },
+    { "numa"        , TestHostMemoryNuma       },
+    { "magicring"   , TestMagicRingBuffer      },
+    { "prefault"    , TestHostMemoryPrefault   },
+    { "budgetlimit" , TestMemoryBudgetLimit    },
+    { "budget"      , TestMemoryBudget         },
+    { "routines"    , TestMemoryRoutines       },
+    { "buddy"       , TestBuddyAllocator       },
+    { "compact"     , TestBuddyCompaction      },
+    { "concurrent"  , TestConcurrentArena      },
+    { "trace"       , TestAllocationTrace      },
+    { "cbuddy"      , TestConcurrentBuddyStress},
+    { "slab"        , TestSlabStress           },
+    { "tlsf"        , TestTlsfStress           },
+    { "chained"     , TestChainedArenaStress   },
+};
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Implement the entry point of the application.
+/// @param argc The number of arguments passed on the command line.
+/// @param argv An array of @a argc zero-terminated strings specifying the command-line arguments.
+/// @return Zero if all tests pass, or non-zero otherwise.
+int
+main
+(
+    int    argc,
+    char **argv
+)
+{
+    OS_HOST_MEMORY_POOL          host_pool = {};  // The pool of host memory allocations used by the tests.
+    OS_HOST_MEMORY_POOL_INIT host_pool_init = {}; // Data used to configure the host memory pool.
+    OS_ALLOCATOR_STATS          pool_stats = {};  // Used to check that each test returned its allocations.
+    size_t                      test_count = sizeof(MemoryTests) / sizeof(MemoryTests[0]);
+    size_t                      fail_count = 0;
+
+    host_pool_init.PoolName          = "Memory Test Pool";
+    host_pool_init.PoolCapacity      = 64;
+    host_pool_init.MinAllocationSize = Kilobytes(4);
+    host_pool_init.MinCommitIncrease = Kilobytes(4);
+    if (OsCreateHostMemoryPool(&host_pool, &host_pool_init) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to create host memory pool.\n", __FUNCTION__, OsThreadId());
+        return -1;
+    }
+    for (size_t i = 0; i < test_count; ++i)
+    {
+        bool selected = (argc < 2);
+        for (int j = 1; j < argc && !selected; ++j)
+        {
+            selected = strcmp(argv[j], MemoryTests[i].Name) == 0;
+        }
+        if (!selected)
+            continue;
+
+        bool passed = MemoryTests[i].Func(&host_pool);
+        OsHostMemoryPoolQueryStats(&host_pool, &pool_stats);
+        if (pool_stats.BytesReserved != 0)
+        {   // a failed test may return early; reclaim its allocations so they don't affect the next test.
+            if (passed) OsLayerError("FAILED: Test \"%S\" did not release %I64u bytes of host memory.\n", MemoryTests[i].Name, pool_stats.BytesReserved);
+            OsHostMemoryPoolReset(&host_pool);
+            passed = false;
+        }
+        OsLayerOutput("STATUS: Finished test \"%S\" (%S).\n", MemoryTests[i].Name, passed ? "SUCCEEDED" : "FAILED");
+        if (!passed) fail_count++;
+    }
+    OsDeleteHostMemoryPool(&host_pool);
+    return fail_count == 0 ? 0 : 1;
+}
+
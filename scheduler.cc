@@ -1,5 +1,14 @@
 /*/////////////////////////////////////////////////////////////////////////////
-/// @summary Test the thread pool and task profiler functionality.
+/// @summary Test the task scheduler and measure its performance. Correctness
+/// tests run first, followed by a set of microbenchmarks whose median and p99
+/// timings are written to a JSON report, along with a set of bulk memory
+/// benchmarks comparing OsCopyMemory, OsFillMemory and OsCompareMemory with
+/// the C runtime, and a set of hash table benchmarks comparing OS_HASH_MAP 
+/// with std::unordered_map. Run with -json - to write the report to stdout, 
+/// or -notests / -nobench to run only one half.
+/// The task scheduler is only implemented for Win32, so this program and its
+/// JSON report are Windows-only; build it with build.cmd. build.sh does not
+/// build it on Linux.
 ///////////////////////////////////////////////////////////////////////////80*/
 
 //#define OS_DISABLE_TASK_PROFILER
@@ -8,7 +17,11 @@
 //   Includes   //
 ////////////////*/
 #include <atomic>
+#include <unordered_map>
+#include <stdio.h>
+#include <stdlib.h>
 #include "win32_oslayer.cc"
+#include "allocator_test.cc"
 
 /*//////////////////
 //   Data Types   //
@@ -39,6 +52,24 @@ struct EMPTY_CHILD_TEST_STATE
     TASK_ID_AND_THREAD *Result;         /// The list of received task IDs.
     uint32_t            ChildCount;     /// The number of child tasks to spawn.
 };
+
+/// @summary Define the state shared by the tasks of an allocator stress test, allocated in global memory.
+struct ALLOCATOR_STRESS_TEST_STATE
+{   typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer that can be read and written atomically.
+    ALLOCATOR_TEST_STATE   Allocators;               /// The allocators, with one cache index per task pool, indexed by OS_TASK_POOL::PoolIndex.
+    ALLOCATOR_STRESS_DESC const *Desc;               /// The allocator stress workload run by each task.
+    atomic_u32_t           Failed;                   /// Set to non-zero by any task that detects an error.
+    uint32_t               TaskCount;                /// The number of tasks spawned by the root task of a test.
+    uint32_t               Iterations;               /// The number of iterations of the workload performed by each task of a test.
+};
+
+/// @summary Define the arguments passed to each task spawned by an allocator stress test.
+struct ALLOCATOR_TEST_ARGS
+{
+    ALLOCATOR_STRESS_TEST_STATE *State;              /// The shared test state.
+    uint32_t              Index;                     /// The zero-based index of the task, used to seed its random number generator.
+};
+
 /// @summary Define the data passed from the test harness to the root task of the test.
 struct TEST_TASK_ARGS
 {
@@ -47,10 +78,21 @@ struct TEST_TASK_ARGS
 };
 #define TEST_SUCCEEDED(_test_task_args) *(_test_task_args)->TestSucceeded = true
 #define TEST_FAILED(_test_task_args)  *(_test_task_args)->TestSucceeded = false
+#define TEST_CHECK(_cond)                                                      \
+    __pragma(warning(push))                                                    \
+    __pragma(warning(disable:4127))                                            \
+    do {                                                                       \
+        if (!(_cond)) {                                                        \
+            OsLayerError("FAILED: %S(%u): Check \"%S\" failed.\n", __FUNCTION__, (uint32_t) __LINE__, #_cond); \
+            return false;                                                      \
+        }                                                                      \
+    } while (0)                                                                \
+    __pragma(warning(pop))
+#define HASH_TEST_CHECK(_cond) TEST_CHECK(_cond)
 
 /// @summary Define the signature for the callback invoked before the root task for a test is created.
 /// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
-/// @param test_state On return, set this value to test state data to be passed to the shutdown function.
+/// @param test_state On entry, the test_param value passed to ParallelTest. On return, set this value to test state data to be passed to the shutdown function.
 /// @return Zero if the test initialization completes successfully, or -1 if an error occurs.
 typedef int  (*TEST_INITFUNC)(OS_TASK_ENVIRONMENT *taskenv, uintptr_t *test_state);
 
@@ -81,9 +123,241 @@ struct TEST_SCOPE
     }
 };
 
+/// @summary Define the shared state for a single run of a benchmark, allocated in global memory.
+struct BENCHMARK_STATE
+{   typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer that can be read and written atomically.
+    typedef std::atomic<uint64_t>      atomic_u64_t; /// An unsigned 64-bit integer that can be read and written atomically.
+    atomic_u32_t        Counter;                     /// Incremented by leaf tasks; used to verify that all expected work was executed.
+    atomic_u32_t        Failed;                      /// Set to non-zero by any task that detects an error.
+    atomic_u32_t        Ready;                       /// Set to non-zero by a helper task to indicate that it is running.
+    atomic_u32_t        Done;                        /// Set to non-zero by the measured task to indicate that it has run.
+    atomic_u64_t        SampleNs;                    /// The latency measured by the benchmark tasks, in nanoseconds. Only used by latency benchmarks.
+    uint64_t            StartTicks;                  /// The timestamp, in ticks, at which the harness defined the root task.
+    uint32_t            Param;                       /// The benchmark-specific size parameter (task count, chain length, recursion depth, etc.)
+    uint32_t            WorkerCount;                 /// The number of worker threads in the task scheduler.
+    ALLOCATOR_TEST_STATE *Allocators;                /// The allocators shared by the allocator benchmarks, taken from BENCHMARK_CONFIG::Allocators.
+    ALLOCATOR_STRESS_DESC const *Allocator;          /// The allocator stress workload run by the allocator benchmarks, taken from BENCHMARK_DESC::Allocator.
+};
+
+/// @summary Define the arguments passed to every benchmark task. Must fit in OS_TASK_DATA::MAX_DATA_BYTES.
+struct BENCHMARK_TASK_ARGS
+{
+    BENCHMARK_STATE    *State;                       /// The benchmark state, allocated in global memory.
+    uint64_t            SpawnTicks;                  /// The timestamp, in ticks, at which the task was spawned. Used by latency probes.
+    uint32_t            Index;                       /// The zero-based index of the task, or the recursion depth.
+    uint32_t            Count;                       /// The number of items to process.
+    os_task_id_t        WaitId;                      /// The task identifier to wait on, for tasks that call OsWaitForTask.
+};
+
+/// @summary Describe a single benchmark scenario.
+struct BENCHMARK_DESC
+{
+    char const         *Name;                        /// A zero-terminated string specifying the benchmark name, as written to the report.
+    OS_TASK_ENTRYPOINT  RootTask;                    /// The entry point of the root task for the benchmark.
+    uint32_t            Param;                       /// The value to store in BENCHMARK_STATE::Param.
+    uint32_t            ExpectCount;                 /// The expected value of BENCHMARK_STATE::Counter at the end of each run, or 0 to skip the check.
+    uint32_t            ItemCount;                   /// The number of tasks executed per run, as written to the report.
+    uint32_t            IdleMs;                      /// The number of milliseconds to sleep before each run so that all workers are idle.
+    uint32_t            MinWorkers;                  /// The minimum number of worker threads required to run the benchmark.
+    bool                MeasureLatency;              /// true to report BENCHMARK_STATE::SampleNs, or false to report the wall-clock time of each run.
+    ALLOCATOR_STRESS_DESC const *Allocator;          /// The allocator stress workload run by AllocatorScalingBench, or NULL for other benchmarks.
+};
+
+/// @summary Define the configuration shared by all benchmarks.
+struct BENCHMARK_CONFIG
+{
+    uint32_t            WarmupRuns;                  /// The number of untimed runs executed before measurement begins.
+    uint32_t            MeasuredRuns;                /// The number of timed runs. Must be at least 1.
+    ALLOCATOR_TEST_STATE *Allocators;                /// The allocators shared by the allocator benchmarks, created before any benchmark runs.
+};
+
+/// @summary Define the summary statistics computed for a single benchmark.
+struct BENCHMARK_RESULT
+{
+    char const         *Name;                        /// The benchmark name, taken from BENCHMARK_DESC::Name.
+    uint32_t            ItemCount;                   /// The number of tasks executed per run.
+    uint32_t            SampleCount;                 /// The number of measured samples, or 0 if the benchmark was skipped.
+    bool                Skipped;                     /// true if the host configuration could not run the benchmark.
+    bool                Failed;                      /// true if any run failed verification.
+    uint64_t            MinNs;                       /// The smallest sample value, in nanoseconds.
+    uint64_t            MaxNs;                       /// The largest sample value, in nanoseconds.
+    uint64_t            MeanNs;                      /// The arithmetic mean of the sample values, in nanoseconds.
+    uint64_t            MedianNs;                    /// The 50th percentile sample value, in nanoseconds.
+    uint64_t            P99Ns;                       /// The 99th percentile sample value, in nanoseconds.
+};
+
+/// @summary Define the signature of a bulk memory operation measured by a memory benchmark.
+/// @param dst The destination buffer.
+/// @param src The source buffer. For comparisons, the contents of src and dst are identical.
+/// @param size The number of bytes to process.
+typedef void (*MEMORY_BENCHFUNC)(void *dst, void const *src, size_t size);
+
+/// @summary Describe a single bulk memory benchmark. Each sample measures enough calls to process MEMORY_BENCHMARK_BYTES bytes.
+struct MEMORY_BENCHMARK_DESC
+{
+    char const         *Name;                        /// A zero-terminated string specifying the benchmark name, as written to the report.
+    MEMORY_BENCHFUNC    Func;                        /// The operation to measure.
+    size_t              Size;                        /// The number of bytes processed by each call.
+    int32_t             InstructionSet;              /// One of OS_MEMORY_ISA specifying the kernels to select before the benchmark runs.
+};
+
+/// @summary Define the signature of a hash table operation measured by a hash table benchmark.
+/// @param arena The arena used for OS_HASH_MAP storage. The arena is reset before each run.
+/// @param keys The keys inserted into the table.
+/// @param probes The keys searched for by lookup benchmarks. Either the same as keys, or a set of keys disjoint from keys.
+/// @param key_count The number of items in the keys and probes arrays.
+/// @return The time spent in the measured operations, in nanoseconds. Lookup benchmarks exclude the time spent building the table.
+typedef uint64_t (*HASH_BENCHFUNC)(OS_HOST_MEMORY_ARENA *arena, uint64_t const *keys, uint64_t const *probes, size_t key_count);
+
+/// @summary Define the state shared by the hash table tests.
+struct HASH_TEST_STATE
+{
+    OS_HOST_MEMORY_ARENA Arena;                      /// The arena over HASH_TEST_BYTES of global memory from which table storage is allocated. Reset after each test.
+};
+
+/// @summary Define the signature of a hash table test.
+/// @param arena The arena used for table storage. The arena is reset after the test returns.
+/// @return true if the test passed.
+typedef bool (*HASH_TESTFUNC)(OS_HOST_MEMORY_ARENA *arena);
+
+/// @summary Describe a single hash table test.
+struct HASH_TEST_DESC
+{
+    char const         *Name;                        /// A zero-terminated string specifying the test name, as written to the log.
+    HASH_TESTFUNC       Func;                        /// The test entry point.
+};
+
+/// @summary Define a node of the linked list written to an arena snapshot by the snapshot test. Links are self-relative, so they remain valid wherever the snapshot is mapped.
+struct SNAPSHOT_TEST_NODE
+{
+    OS_RELATIVE_PTR<SNAPSHOT_TEST_NODE> Next;        /// The next node in the list, or NULL for the last node.
+    uint64_t            Value;                       /// A value derived from the position of the node in the list.
+};
+
+/// @summary Define the root object of the arena snapshot written by the snapshot test.
+struct SNAPSHOT_TEST_ROOT
+{
+    OS_RELATIVE_PTR<SNAPSHOT_TEST_NODE> Head;        /// The first node in the list.
+    uint64_t            NodeCount;                   /// The number of nodes in the list.
+};
+
+/// @summary Define the state used by the arena snapshot test.
+struct SNAPSHOT_TEST_STATE
+{
+    OS_HOST_MEMORY_ARENA Arena;                      /// The arena over SNAPSHOT_TEST_BYTES of global memory in which the data to snapshot is built.
+    WCHAR               Path[MAX_PATH];              /// The path of the snapshot file, in the temporary directory.
+};
+
+/// @summary Define the state shared by the tasks of the worker scaling test, allocated in global memory.
+struct WORKER_SCALING_TEST_STATE
+{   typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer that can be read and written atomically.
+    atomic_u32_t        LinkCount;                   /// The number of chain links that have run.
+    atomic_u32_t        LeafCount;                   /// The number of leaf tasks that have run.
+    atomic_u32_t        Failed;                      /// Set to non-zero by any task that detects an error.
+};
+
+/// @summary Define the arguments passed to each task of the worker scaling test.
+struct WORKER_SCALING_TEST_ARGS
+{
+    WORKER_SCALING_TEST_STATE *State;                /// The shared test state.
+    os_task_id_t        RootId;                      /// The identifier of the root task, which is the parent of every other task.
+    uint32_t            Depth;                       /// The number of links remaining in the chain, including this one.
+};
+
+/// @summary Define the state shared by the thread-affine task test and the application thread it runs tasks on, allocated in global memory.
+struct AFFINE_TEST_STATE
+{   typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer that can be read and written atomically.
+    OS_TASK_SCHEDULER  *Scheduler;                   /// The task scheduler from which the helper thread allocates its task pool.
+    HANDLE              HelperThread;                /// The application thread that owns a task pool and executes the tasks delivered to its mailbox.
+    HANDLE              HelperReady;                 /// Signaled by the helper thread once it owns its task pool.
+    HANDLE              HelperStop;                  /// Signaled to make the helper thread return its task pool and exit.
+    uint32_t            HelperPoolId;                /// The application pool type of the task pool allocated by the helper thread.
+    uint32_t            HelperPool;                  /// The index of the task pool owned by the helper thread.
+    uint32_t            HelperThreadId;              /// The operating system identifier of the helper thread.
+    atomic_u32_t        AffineCount;                 /// The number of independent thread-affine tasks that have run.
+    atomic_u32_t        ChainCount;                  /// The number of links of the dependency chain that have run.
+    atomic_u32_t        CancelRan;                   /// Set to non-zero if the task targeting the returned task pool ran.
+    atomic_u32_t        AfterCancelRan;              /// Set to non-zero when the task depending on the cancelled task runs.
+    atomic_u32_t        Failed;                      /// Set to non-zero by any task that detects an error.
+};
+
+/// @summary Define the arguments passed to each task of the thread-affine task test.
+struct AFFINE_TEST_ARGS
+{
+    AFFINE_TEST_STATE  *State;                       /// The shared test state.
+    uint32_t            Index;                       /// The zero-based index of the task within its group.
+    uint32_t            TargetPool;                  /// The index of the task pool the task must run on, or OS_TASK_POOL_INDEX_ANY.
+    uint32_t            TargetThread;                /// The operating system identifier of the thread that owns TargetPool, or zero.
+};
+
+/// @summary Describe a single hash table benchmark.
+struct HASH_BENCHMARK_DESC
+{
+    char const         *Name;                        /// A zero-terminated string specifying the benchmark name, as written to the report.
+    HASH_BENCHFUNC      Func;                        /// The operation to measure.
+    size_t              KeyCount;                    /// The number of keys inserted into the table.
+    bool                Miss;                        /// true if lookups search for keys that are not present in the table.
+};
+
 /*///////////////
 //   Globals   //
 ///////////////*/
+/// @summary The number of bytes processed by each sample of a memory benchmark, and the size of each benchmark buffer.
+global_variable size_t const MEMORY_BENCHMARK_BYTES = Megabytes(64);
+
+/// @summary Accumulates comparison results so that the compiler cannot discard the comparisons being measured.
+global_variable int volatile MemoryBenchmarkSink    = 0;
+
+/// @summary The number of bytes of host memory available to the hash table benchmarks, including the key arrays.
+global_variable size_t const HASH_BENCHMARK_BYTES   = Megabytes(64);
+
+/// @summary Accumulates lookup results so that the compiler cannot discard the lookups being measured.
+global_variable uint64_t volatile HashBenchmarkSink = 0;
+
+/// @summary The number of bytes of global memory available to the hash table tests.
+global_variable size_t const HASH_TEST_BYTES        = Megabytes(8);
+
+/// @summary The number of bytes of global memory available to the arena snapshot test.
+global_variable size_t const SNAPSHOT_TEST_BYTES    = Megabytes(1);
+
+/// @summary The number of nodes in the linked list written to an arena snapshot by the arena snapshot test.
+global_variable uint64_t const SNAPSHOT_TEST_NODES  = 4096;
+
+/// @summary The user tag identifying the layout of the data written by the arena snapshot test.
+global_variable uint64_t const SNAPSHOT_TEST_TAG    = 0x534E415054455354ULL;
+
+/// @summary The number of independent thread-affine tasks defined by the thread-affine task test.
+global_variable uint32_t const AFFINE_TEST_TASKS = 64;
+
+/// @summary The number of links in the dependency chain of the thread-affine task test. Links cycle between the helper thread, the worker running the root task, and any worker.
+global_variable uint32_t const AFFINE_TEST_CHAIN = 48;
+
+/// @summary The number of dependency chains run concurrently by the worker scaling test.
+global_variable uint32_t const WORKER_SCALING_TEST_CHAINS = 8;
+
+/// @summary The number of links in each dependency chain of the worker scaling test.
+global_variable uint32_t const WORKER_SCALING_TEST_DEPTH  = 256;
+
+/// @summary The number of leaf tasks spawned by each link of the worker scaling test. The next link depends on all of them.
+global_variable uint32_t const WORKER_SCALING_TEST_LEAVES = 4;
+
+/// @summary The amount of time each leaf task of the worker scaling test spins, in nanoseconds.
+global_variable uint64_t const WORKER_SCALING_TEST_LEAF_NS = 20000;
+
+/// @summary The number of iterations of the allocator stress workload performed by each task of an allocator benchmark.
+global_variable uint32_t const ALLOCATOR_BENCHMARK_OPS = 16384;
+
+/// @summary The task counts at which the allocator benchmarks run. Each allocator gets one benchmark, named <Name>Scaling/<count>, per entry.
+global_variable uint32_t const ALLOCATOR_SCALING_TASKS[] = { 1, 2, 4, 8 };
+
+/// @summary The allocator stress workloads, in the order they are run.
+global_variable ALLOCATOR_STRESS_DESC const *AllocatorStressTests[] =
+{
+    &BuddyStress,
+    &SlabStress,
+    &TlsfStress,
+    &ChainedStress
+};
 
 /*//////////////////////////
 //   Internal Functions   //
@@ -94,6 +368,7 @@ struct TEST_SCOPE
 /// @param test_main The test task entry point.
 /// @param test_init The function to call before the root task is spawned to set up any global state.
 /// @param test_shutdown The function to call after all tasks have completed to examing 
+/// @param test_param A value passed to test_init, which receives it through its test_state argument.
 /// @return true if the test was successful, or false if the test failed.
 internal_function bool
 ParallelTest
@@ -102,18 +377,19 @@ ParallelTest
     OS_TASK_ENVIRONMENT   *taskenv,
     OS_TASK_ENTRYPOINT   test_main, 
     TEST_INITFUNC        test_init=NULL, 
-    TEST_SHUTFUNC    test_shutdown=NULL
+    TEST_SHUTFUNC    test_shutdown=NULL, 
+    uintptr_t           test_param=0
 )
 {
     TEST_SCOPE          test(test_name, taskenv);
-    uintptr_t     test_state = 0;
+    uintptr_t     test_state = test_param;
     TEST_TASK_ARGS      args = {};
     os_task_id_t   root_task = OS_INVALID_TASK_ID;
     OS_TASK_FENCE fence_done = {};
     bool         did_succeed = false;
 
     // reset the memory arena in preparation for the test run.
-    OsMemoryArenaReset(taskenv->GlobalMemory);
+    OsConcurrentArenaReset(taskenv->GlobalMemory);
 
     // perform global initialization for the test. this may allocate global memory.
     if (test_init && test_init(taskenv, &test_state) < 0)
@@ -268,14 +544,14 @@ EmptyChildTestInit
 )
 {
     uint32_t const               N = 128000;
-    os_arena_marker_t       marker = OsMemoryArenaMark(taskenv->GlobalMemory);
-    EMPTY_CHILD_TEST_STATE  *state = OsMemoryArenaAllocate<EMPTY_CHILD_TEST_STATE >(taskenv->GlobalMemory);
-    TASK_ID_AND_THREAD     *expect = OsMemoryArenaAllocateArray<TASK_ID_AND_THREAD>(taskenv->GlobalMemory, N);
-    TASK_ID_AND_THREAD     *result = OsMemoryArenaAllocateArray<TASK_ID_AND_THREAD>(taskenv->GlobalMemory, N);
+    os_arena_marker_t       marker = OsConcurrentArenaMark(taskenv->GlobalMemory);
+    EMPTY_CHILD_TEST_STATE  *state = OsConcurrentArenaAllocate<EMPTY_CHILD_TEST_STATE>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk);
+    TASK_ID_AND_THREAD     *expect = OsConcurrentArenaAllocateArray<TASK_ID_AND_THREAD>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk, N);
+    TASK_ID_AND_THREAD     *result = OsConcurrentArenaAllocateArray<TASK_ID_AND_THREAD>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk, N);
     if (state == NULL || expect == NULL || result == NULL)
     {
         OsLayerError("ERROR: %S(%u): Failed to allocate global test state.\n", __FUNCTION__, OsThreadId());
-        OsMemoryArenaResetToMarker(taskenv->GlobalMemory, marker);
+        OsConcurrentArenaResetToMarker(taskenv->GlobalMemory, marker);
         return -1;
     }
     OsZeroMemory(state , sizeof(EMPTY_CHILD_TEST_STATE));
@@ -363,97 +639,2846 @@ EmptyChildTest
     }
 }
 
-/*////////////////////////
-//   Public Functions   //
-////////////////////////*/
-/// @summary Implement the entry point of the application.
-/// @param argc The number of arguments passed on the command line.
-/// @param argv An array of @a argc zero-terminated strings specifying the command-line arguments.
-/// @return Zero if the function completes successfully, or non-zero otherwise.
-export_function int 
-main
+/// @summary Run the allocator stress workload of the test on the executing worker, using the thread caches and chained arena of its task pool.
+/// Blocks handed off by the task are freed by tasks running on other workers.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AllocatorStressTask
 (
-    int    argc, 
-    char **argv
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
 )
 {
-    OS_MEMORY_ARENA                       arena  = {};  // The memory arena used to store the TASK_DATA instances.
-    OS_CPU_INFO                        cpu_info  = {};  // Information about the host CPU configuration.
-    OS_TASK_SCHEDULER                 scheduler  = {};  // The task scheduler.
-    OS_TASK_ENVIRONMENT                 rootenv  = {};  // The OS_TASK_ENVIRONMENT for the main thread.
-    size_t const               MAIN_THREAD_POOL  = 0;
-    size_t const                 IO_THREAD_POOL  = 1;
-    size_t const          SCHEDULER_THREAD_POOL  = 2;
-    size_t const                TASK_POOL_COUNT  = 3;
-    OS_TASK_POOL_INIT pool_init[TASK_POOL_COUNT] = {};
-    OS_TASK_SCHEDULER_INIT       scheduler_init  = {};
-
-    UNREFERENCED_PARAMETER(argc);
-    UNREFERENCED_PARAMETER(argv);
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        ALLOCATOR_TEST_ARGS          *args = (ALLOCATOR_TEST_ARGS*) task_args;
+        ALLOCATOR_STRESS_TEST_STATE *state =  args->State;
+        if (!RunAllocatorStress(state->Desc, &state->Allocators, OsGetTaskPoolIndex(taskenv), args->Index, state->Iterations))
+        {
+            OsLayerError("ERROR: %S(%u): %S stress task %u failed.\n", __FUNCTION__, taskenv->ThreadId, state->Desc->Name, args->Index);
+            state->Failed.store(1);
+        }
+    }
+}
 
-    // create the memory arena used to store the TASK_DATA work items.
-    if (OsCreateMemoryArena(&arena, Megabytes(128), true, true) < 0)
+/// @summary Initialize the shared allocators and per-pool thread caches in global memory for one of the allocator stress tests.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_state On entry, the ALLOCATOR_STRESS_DESC of the workload to run. On return, set this value to test state data to be passed to the shutdown function.
+/// @return Zero if initialization is successful, or -1 if initialization failed.
+internal_function int
+AllocatorStressTestInit
+(
+    OS_TASK_ENVIRONMENT *taskenv, 
+    uintptr_t        *test_state
+)
+{
+    ALLOCATOR_STRESS_DESC const *desc = (ALLOCATOR_STRESS_DESC const*) *test_state;
+    size_t                 pool_count = taskenv->TaskScheduler->TaskPoolCount;
+    os_arena_marker_t          marker = OsConcurrentArenaMark(taskenv->GlobalMemory);
+    ALLOCATOR_STRESS_TEST_STATE *state = OsConcurrentArenaAllocate<ALLOCATOR_STRESS_TEST_STATE>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk);
+    uint8_t                   *memory = (uint8_t*) OsConcurrentArenaAllocate(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk, AllocatorTestMemorySize(pool_count), 64);
+    if (state == NULL || memory == NULL)
     {
-        OsLayerError("ERROR: %S(%u): Unable to initialize main memory arena.\n", __FUNCTION__, GetCurrentThreadId());
+        OsLayerError("ERROR: %S(%u): Failed to allocate global test state.\n", __FUNCTION__, OsThreadId());
+        OsConcurrentArenaResetToMarker(taskenv->GlobalMemory, marker);
         return -1;
     }
-    if (!OsQueryHostCpuLayout(&cpu_info, &arena))
+    if (CreateAllocatorTestState(&state->Allocators, memory, pool_count) < 0)
     {
-        OsLayerError("ERROR: %S(%u): Unable to query host CPU layout.\n", __FUNCTION__, GetCurrentThreadId());
+        OsConcurrentArenaResetToMarker(taskenv->GlobalMemory, marker);
         return -1;
     }
+    state->Desc       = desc;
+    state->Failed.store(0);
+    state->TaskCount  = (uint32_t) taskenv->HostCpuInfo->HardwareThreads * 4;
+    state->Iterations = 10240;
+   *test_state = (uintptr_t) state;
+    return 0;
+}
 
-    // create three types of task pools - one for the main thread, one for I/O workers, and one for scheduler workers.
-    // the main thread can define, but not ever run tasks. it creates very few tasks.
-    // the I/O threads can define, but not ever run tasks. they create very few tasks.
-    // the scheduler worker threads can define and execute tasks. they may create many tasks.
-    pool_init[MAIN_THREAD_POOL].PoolId               = MAIN_THREAD_POOL;
-    pool_init[MAIN_THREAD_POOL].PoolUsage            = OS_TASK_POOL_USAGE_FLAG_DEFINE | OS_TASK_POOL_USAGE_FLAG_PUBLISH;
-    pool_init[MAIN_THREAD_POOL].PoolCount            = 1;
-    pool_init[MAIN_THREAD_POOL].MaxIoRequests        = 0;
-    pool_init[MAIN_THREAD_POOL].MaxActiveTasks       = 64;
-    pool_init[MAIN_THREAD_POOL].LocalMemorySize      = 0;
+/// @summary Free the blocks still held in the handoff slots, flush the thread caches of every pool and check the allocator exercised by an allocator stress test.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_args The arguments passed to the root task of the test harness.
+/// @return true if the test was successful, or false if the test failed.
+internal_function bool
+AllocatorStressTestShutdown
+(
+    OS_TASK_ENVIRONMENT *taskenv,
+    TEST_TASK_ARGS         *args
+)
+{
+    UNREFERENCED_PARAMETER(taskenv);
+    ALLOCATOR_STRESS_TEST_STATE *state = (ALLOCATOR_STRESS_TEST_STATE*) args->TestState;
+    bool                        passed = *args->TestSucceeded && state->Failed.load() == 0;
 
-    pool_init[IO_THREAD_POOL].PoolId                 = IO_THREAD_POOL;
-    pool_init[IO_THREAD_POOL].PoolUsage              = OS_TASK_POOL_USAGE_FLAG_DEFINE | OS_TASK_POOL_USAGE_FLAG_PUBLISH;
-    pool_init[IO_THREAD_POOL].PoolCount              = cpu_info.PhysicalCores;
-    pool_init[IO_THREAD_POOL].MaxIoRequests          = 0;
-    pool_init[IO_THREAD_POOL].MaxActiveTasks         = OS_MIN_TASKS_PER_POOL;
-    pool_init[IO_THREAD_POOL].LocalMemorySize        = 0;
+    // all tasks have finished, so the main thread can return the blocks cached on behalf of every pool.
+    if (!FinishAllocatorStress(state->Desc, &state->Allocators))
+        passed = false;
+    DeleteAllocatorTestState(&state->Allocators);
+    if (passed)
+    {
+        TEST_SUCCEEDED(args);
+    }
+    else
+    {
+        TEST_FAILED(args);
+    }
+    return passed;
+}
 
-    pool_init[SCHEDULER_THREAD_POOL].PoolId          = SCHEDULER_THREAD_POOL;
-    pool_init[SCHEDULER_THREAD_POOL].PoolUsage       = OS_TASK_POOL_USAGE_FLAG_DEFINE | OS_TASK_POOL_USAGE_FLAG_EXECUTE | OS_TASK_POOL_USAGE_FLAG_PUBLISH | OS_TASK_POOL_USAGE_FLAG_WORKER;
-    pool_init[SCHEDULER_THREAD_POOL].PoolCount       = cpu_info.HardwareThreads;
-    pool_init[SCHEDULER_THREAD_POOL].MaxIoRequests   = 512;
-    pool_init[SCHEDULER_THREAD_POOL].MaxActiveTasks  = OS_MAX_TASKS_PER_POOL;
-    pool_init[SCHEDULER_THREAD_POOL].LocalMemorySize = Megabytes(32);
+/// @summary Stress one of the shared allocators from every worker. The root task spawns tasks that allocate blocks and free blocks allocated on other workers.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AllocatorStressTest
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        TEST_TASK_ARGS               *args = (TEST_TASK_ARGS*) task_args;
+        ALLOCATOR_STRESS_TEST_STATE *state = (ALLOCATOR_STRESS_TEST_STATE*) args->TestState;
+        ALLOCATOR_TEST_ARGS          child = {state, 0};
+        for (uint32_t i = 0, n = state->TaskCount; i < n; ++i)
+        {
+            child.Index = i;
+            if (OsSpawnChildTask(taskenv, AllocatorStressTask, &child, task_id) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn child %u (%d).\n", __FUNCTION__, taskenv->ThreadId, i, OsGetTaskPoolError(taskenv));
+                TEST_FAILED(args);
+                return;
+            }
+            OsPublishTasks(taskenv, 1);
+        }
+        TEST_SUCCEEDED(args);
+    }
+}
 
-    // the task scheduler will create and manage its own pool of worker threads.
-    scheduler_init.WorkerThreadCount = cpu_info.HardwareThreads;
-    scheduler_init.GlobalMemorySize  = Megabytes(256);
-    scheduler_init.PoolTypeCount     = TASK_POOL_COUNT;
-    scheduler_init.TaskPoolTypes     = pool_init;
-    scheduler_init.IoThreadPool      = NULL;
-    scheduler_init.TaskContextData   = 0;
-    if (OsCreateTaskScheduler(&scheduler, &scheduler_init, &arena, "Task Scheduler") < 0)
+/// @summary Initialize a host memory arena over a block of global memory for the hash table tests.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_state On return, set this value to test state data to be passed to the shutdown function.
+/// @return Zero if initialization is successful, or -1 if initialization failed.
+internal_function int
+HashTableTestInit
+(
+    OS_TASK_ENVIRONMENT *taskenv, 
+    uintptr_t        *test_state
+)
+{
+    os_arena_marker_t   marker = OsConcurrentArenaMark(taskenv->GlobalMemory);
+    HASH_TEST_STATE     *state = OsConcurrentArenaAllocate<HASH_TEST_STATE>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk);
+    uint8_t            *memory = (uint8_t*) OsConcurrentArenaAllocate(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk, HASH_TEST_BYTES, 64);
+    if (state == NULL || memory == NULL)
     {
-        OsLayerError("ERROR: %S(%u): Failed to initialize task scheduler.\n", __FUNCTION__, OsThreadId());
+        OsLayerError("ERROR: %S(%u): Failed to allocate global test state.\n", __FUNCTION__, OsThreadId());
+        OsConcurrentArenaResetToMarker(taskenv->GlobalMemory, marker);
         return -1;
     }
-    if (OsAllocateTaskPool(&rootenv, &scheduler, MAIN_THREAD_POOL, OsThreadId()) < 0)
+    if (OsCreateHostMemoryArena(&state->Arena, OsInitHostMemoryRange(memory, HASH_TEST_BYTES)) < 0)
     {
-        OsLayerError("ERROR: %S(%u): Failed to allocate main thread task pool.\n", __FUNCTION__, OsThreadId());
+        OsLayerError("ERROR: %S(%u): Failed to create the hash table test arena.\n", __FUNCTION__, OsThreadId());
+        OsConcurrentArenaResetToMarker(taskenv->GlobalMemory, marker);
         return -1;
     }
+   *test_state = (uintptr_t) state;
+    return 0;
+}
 
-    ParallelTest("EmptyTest", &rootenv, EmptyTest, EmptyInit, EmptyShutdown);
-    ParallelTest("EmptyChildTest", &rootenv, EmptyChildTest, EmptyChildTestInit, EmptyChildTestShutdown);
+/// @summary Release the arena used by the hash table tests.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_args The arguments passed to the root task of the test harness.
+/// @return true if the test was successful, or false if the test failed.
+internal_function bool
+HashTableTestShutdown
+(
+    OS_TASK_ENVIRONMENT *taskenv,
+    TEST_TASK_ARGS         *args
+)
+{
+    UNREFERENCED_PARAMETER(taskenv);
+    HASH_TEST_STATE *state = (HASH_TEST_STATE*) args->TestState;
+    OsDeleteHostMemoryArena(&state->Arena);
+    return *args->TestSucceeded;
+}
 
-    // shut down the task scheduler and kill all worker threads.
-    OsDestroyTaskScheduler(&scheduler);
+/// @summary Compute the group at which the probe sequence for a key starts.
+/// @param key The key.
+/// @param capacity The number of slots in the table.
+/// @return The zero-based index of the first group probed for the key.
+internal_function size_t
+HashKeyStartGroup
+(
+    uint64_t    key, 
+    size_t capacity
+)
+{
+    return (size_t)(OsHashKey(key) >> 7) & ((capacity / OS_HASH_GROUP_WIDTH) - 1);
+}
 
-    // clean up everything else.
-    OsDeleteMemoryArena(&arena);
-    return 0;
+/// @summary Retrieve the slot holding a key, by scanning every slot rather than probing.
+/// @param map The OS_HASH_MAP to search.
+/// @param key The key to search for.
+/// @return The zero-based index of the slot holding the key, or SIZE_MAX.
+internal_function size_t
+HashKeySlot
+(
+    OS_HASH_MAP<uint64_t, uint64_t> *map, 
+    uint64_t                         key
+)
+{
+    for (size_t i = 0, n = map->Capacity; i < n; ++i)
+    {
+        if ((map->Control[i] & 0x80) == 0 && map->Keys[i] == key)
+            return i;
+    }
+    return SIZE_MAX;
+}
+
+/// @summary Fill a table with 32 slots so that its first group holds only keys whose probe sequence starts there, followed by one key that had to probe past it.
+/// @param map The OS_HASH_MAP to fill. The map must be empty, with a capacity of 32 slots.
+/// @param group_keys On return, the 16 keys stored in the first group.
+/// @param spill_key On return, a key whose probe sequence starts at the first group, but which is stored in the second.
+/// @param next_key The next candidate key value. On return, the key value following the last one examined.
+/// @return true if the table was filled.
+internal_function bool
+HashFillFirstGroup
+(
+    OS_HASH_MAP<uint64_t, uint64_t> *map, 
+    uint64_t                 *group_keys, 
+    uint64_t                   &spill_key, 
+    uint64_t                    &next_key
+)
+{
+    size_t count = 0;
+    while (count <= OS_HASH_GROUP_WIDTH)
+    {
+        uint64_t key = next_key++;
+        if (HashKeyStartGroup(key, map->Capacity) != 0)
+            continue;
+        if (OsHashMapInsert(map, key, key * 3) == NULL)
+            return false;
+        if (count < OS_HASH_GROUP_WIDTH)
+            group_keys[count] = key;
+        else
+            spill_key = key;
+        count++;
+    }
+    HASH_TEST_CHECK(map->Capacity == 2 * OS_HASH_GROUP_WIDTH);
+    HASH_TEST_CHECK(HashKeySlot(map, spill_key) >= OS_HASH_GROUP_WIDTH);
+    return true;
+}
+
+/// @summary Insert, erase and look up random keys in an OS_HASH_MAP that starts empty and grows several times, and compare every result with std::unordered_map.
+/// @param arena The arena used for table storage.
+/// @return true if the test passed.
+internal_function bool
+HashTestReferenceMap
+(
+    OS_HOST_MEMORY_ARENA *arena
+)
+{
+    uint32_t const                   KEY_RANGE = 8192;
+    uint32_t const                   OPERATIONS = 60000;
+    std::unordered_map<uint64_t, uint64_t>  ref;
+    OS_HASH_MAP<uint64_t, uint64_t>         map;
+    uint32_t                                 rng = 0x2545F491U;
+    size_t                            capacity = 0;
+    size_t                           grow_count = 0;
+
+    HASH_TEST_CHECK(OsCreateHashMap(&map, arena, 0, OS_HASH_TABLE_FLAGS_NONE) == 0);
+    // insertions outnumber erasures two to one, so the table grows from empty while keys are also being erased.
+    for (uint32_t n = 0; n < OPERATIONS; ++n)
+    {
+        uint32_t  op = NextRandom(rng) % 3;
+        uint64_t key = (uint64_t)(NextRandom(rng) % KEY_RANGE) * 0x9E3779B97F4A7C15ULL;
+        if (op != 2)
+        {
+            uint64_t *value = OsHashMapInsert(&map, key, (uint64_t) n);
+            HASH_TEST_CHECK(value != NULL && *value == n);
+            ref[key] = n;
+        }
+        else
+        {
+            HASH_TEST_CHECK(OsHashMapRemove(&map, key) == (ref.erase(key) != 0));
+            HASH_TEST_CHECK(OsHashMapFind(&map, key) == NULL);
+        }
+        HASH_TEST_CHECK(map.Count == ref.size());
+        if (map.Capacity != capacity)
+        {   // every key must be found at its new slot after the table grows.
+            for (auto const &kv : ref)
+            {
+                uint64_t *value = OsHashMapFind(&map, kv.first);
+                HASH_TEST_CHECK(value != NULL && *value == kv.second);
+            }
+            capacity = map.Capacity;
+            grow_count++;
+        }
+    }
+    HASH_TEST_CHECK(grow_count > 4);
+    for (uint32_t i = 0; i < KEY_RANGE; ++i)
+    {
+        uint64_t    key = (uint64_t) i * 0x9E3779B97F4A7C15ULL;
+        uint64_t *value = OsHashMapFind(&map, key);
+        auto       iter = ref.find(key);
+        HASH_TEST_CHECK((value != NULL) == (iter != ref.end()));
+        HASH_TEST_CHECK(value == NULL || *value == iter->second);
+    }
+    // iteration visits every key exactly once.
+    {
+        size_t     iterator = 0;
+        size_t      visited = 0;
+        uint64_t       *key = NULL;
+        uint64_t     *value = NULL;
+        while (OsHashMapIterate(&map, iterator, key, value))
+        {
+            auto iter = ref.find(*key);
+            HASH_TEST_CHECK(iter != ref.end() && iter->second == *value);
+            visited++;
+        }
+        HASH_TEST_CHECK(visited == ref.size());
+    }
+    return true;
 }
 
+/// @summary Check that erasing a key leaves its slot empty when the group still has an empty slot, and marks it deleted when the group is full,
+/// so that keys which probed past the full group can still be found.
+/// @param arena The arena used for table storage.
+/// @return true if the test passed.
+internal_function bool
+HashTestEraseMarkers
+(
+    OS_HOST_MEMORY_ARENA *arena
+)
+{
+    OS_HASH_MAP<uint64_t, uint64_t> map;
+    uint64_t group_keys[OS_HASH_GROUP_WIDTH];
+    uint64_t                   spill_key = 0;
+    uint64_t                    next_key = 1;
+    size_t                   growth_left = 0;
+    size_t                          slot = 0;
+
+    // a table with two groups, and 28 usable slots.
+    HASH_TEST_CHECK(OsCreateHashMap(&map, arena, 20, OS_HASH_TABLE_FLAGS_NONE) == 0);
+    HASH_TEST_CHECK(HashFillFirstGroup(&map, group_keys, spill_key, next_key));
+
+    // the first group has no empty slot, so the erased slot is marked deleted and GrowthLeft is unchanged.
+    growth_left = map.GrowthLeft;
+    slot        = HashKeySlot(&map, group_keys[3]);
+    HASH_TEST_CHECK(slot < OS_HASH_GROUP_WIDTH);
+    HASH_TEST_CHECK(OsHashMapRemove(&map, group_keys[3]));
+    HASH_TEST_CHECK(map.Control[slot] == OS_HASH_CONTROL_DELETED);
+    HASH_TEST_CHECK(map.GrowthLeft == growth_left);
+    HASH_TEST_CHECK(OsHashMapFind(&map, group_keys[3]) == NULL);
+    HASH_TEST_CHECK(OsHashMapFind(&map, spill_key) != NULL && *OsHashMapFind(&map, spill_key) == spill_key * 3);
+
+    // the second group has empty slots, so the erased slot becomes empty and GrowthLeft increases.
+    slot = HashKeySlot(&map, spill_key);
+    HASH_TEST_CHECK(OsHashMapRemove(&map, spill_key));
+    HASH_TEST_CHECK(map.Control[slot] == OS_HASH_CONTROL_EMPTY);
+    HASH_TEST_CHECK(map.GrowthLeft == growth_left + 1);
+    HASH_TEST_CHECK(OsHashMapFind(&map, spill_key) == NULL);
+    for (size_t i = 0; i < OS_HASH_GROUP_WIDTH; ++i)
+    {
+        HASH_TEST_CHECK((OsHashMapFind(&map, group_keys[i]) != NULL) == (i != 3));
+    }
+    return true;
+}
+
+/// @summary Check that an insert reuses a deleted slot when GrowthLeft is zero, rather than growing the table.
+/// @param arena The arena used for table storage.
+/// @return true if the test passed.
+internal_function bool
+HashTestDeletedSlotReuse
+(
+    OS_HOST_MEMORY_ARENA *arena
+)
+{
+    OS_HASH_MAP<uint64_t, uint64_t> map;
+    uint64_t group_keys[OS_HASH_GROUP_WIDTH];
+    uint64_t                   spill_key = 0;
+    uint64_t                    next_key = 1;
+    uint64_t                     new_key = 0;
+    uint8_t                     *control = NULL;
+    os_arena_marker_t             marker = 0;
+    size_t                          slot = 0;
+
+    HASH_TEST_CHECK(OsCreateHashMap(&map, arena, 20, OS_HASH_TABLE_FLAGS_NONE) == 0);
+    HASH_TEST_CHECK(HashFillFirstGroup(&map, group_keys, spill_key, next_key));
+    while (map.GrowthLeft > 0)
+    {   // fill the second group up to the maximum load factor with keys that start there.
+        uint64_t key = next_key++;
+        if (HashKeyStartGroup(key, map.Capacity) == 1)
+            HASH_TEST_CHECK(OsHashMapInsert(&map, key, key * 3) != NULL);
+    }
+    HASH_TEST_CHECK(map.Capacity == 2 * OS_HASH_GROUP_WIDTH && map.Count == map.Capacity - map.Capacity / 8);
+
+    // erase a key from the full first group, leaving a deleted slot, then insert a new key that starts at the first group.
+    slot = HashKeySlot(&map, group_keys[7]);
+    HASH_TEST_CHECK(OsHashMapRemove(&map, group_keys[7]));
+    HASH_TEST_CHECK(map.Control[slot] == OS_HASH_CONTROL_DELETED && map.GrowthLeft == 0);
+    do
+    {
+        new_key = next_key++;
+    } while (HashKeyStartGroup(new_key, map.Capacity) != 0);
+    control = map.Control;
+    marker  = OsHostMemoryArenaMark(arena);
+    HASH_TEST_CHECK(OsHashMapInsert(&map, new_key, new_key * 3) != NULL);
+    HASH_TEST_CHECK(map.Control == control && map.Capacity == 2 * OS_HASH_GROUP_WIDTH);
+    HASH_TEST_CHECK(OsHostMemoryArenaMark(arena) == marker);
+    HASH_TEST_CHECK(HashKeySlot(&map, new_key) == slot && map.GrowthLeft == 0);
+
+    // with no deleted slots left, the next insert must grow the table.
+    do
+    {
+        new_key = next_key++;
+    } while (HashKeyStartGroup(new_key, map.Capacity) != 0);
+    HASH_TEST_CHECK(OsHashMapInsert(&map, new_key, new_key * 3) != NULL);
+    HASH_TEST_CHECK(map.Capacity > 2 * OS_HASH_GROUP_WIDTH);
+    HASH_TEST_CHECK(OsHashMapFind(&map, spill_key) != NULL && OsHashMapFind(&map, group_keys[7]) == NULL);
+    return true;
+}
+
+/// @summary Check that a table whose slots fill up with deleted markers under a steady stream of inserts and erases rehashes at the same capacity,
+/// instead of growing without bound.
+/// @param arena The arena used for table storage.
+/// @return true if the test passed.
+internal_function bool
+HashTestRehashInPlace
+(
+    OS_HOST_MEMORY_ARENA *arena
+)
+{
+    uint64_t const               LIVE_COUNT = 256;
+    uint64_t const                   ROUNDS = 50000;
+    OS_HASH_MAP<uint64_t, uint64_t>      map;
+    size_t                         capacity = 0;
+    size_t                     rehash_count = 0;
+    uint64_t                           next = 0;
+    uint8_t                        *control = NULL;
+
+    // fill the table to the maximum load factor, so that most groups are full, then erase down to LIVE_COUNT keys, leaving deleted slots behind.
+    HASH_TEST_CHECK(OsCreateHashMap(&map, arena, 400, OS_HASH_TABLE_FLAGS_NONE) == 0);
+    capacity = map.Capacity;
+    control  = map.Control;
+    while (map.GrowthLeft > 0)
+    {
+        HASH_TEST_CHECK(OsHashMapInsert(&map, next, next) != NULL);
+        next++;
+    }
+    for (uint64_t i = 0; i < next - LIVE_COUNT; ++i)
+    {
+        HASH_TEST_CHECK(OsHashMapRemove(&map, i));
+    }
+    HASH_TEST_CHECK(map.Control == control && map.Count == LIVE_COUNT);
+
+    // a sliding window of keys: each round erases the oldest key and inserts a new one. with 256 live keys, 
+    // every rehash is sized for 385 keys, which fits the current capacity, so deleted slots are reclaimed without growing.
+    for (uint64_t i = next; i < next + ROUNDS; ++i)
+    {
+        HASH_TEST_CHECK(OsHashMapRemove(&map, i - LIVE_COUNT));
+        HASH_TEST_CHECK(OsHashMapInsert(&map, i, i) != NULL);
+        HASH_TEST_CHECK(map.Capacity == capacity && map.Count == LIVE_COUNT);
+        if (map.Control != control)
+        {   // the table was rehashed; the live window must survive.
+            for (uint64_t k = i + 1 - LIVE_COUNT; k <= i; ++k)
+            {
+                uint64_t *value = OsHashMapFind(&map, k);
+                HASH_TEST_CHECK(value != NULL && *value == k);
+            }
+            control = map.Control;
+            rehash_count++;
+        }
+    }
+    HASH_TEST_CHECK(rehash_count > 0);
+    HASH_TEST_CHECK(OsHashMapFind(&map, next + ROUNDS - LIVE_COUNT - 1) == NULL);
+    return true;
+}
+
+/// @summary Check that a fixed-capacity table fails inserts once it reaches the maximum load factor, leaves its contents intact, and accepts inserts again after an explicit reserve.
+/// @param arena The arena used for table storage.
+/// @return true if the test passed.
+internal_function bool
+HashTestFixedCapacity
+(
+    OS_HOST_MEMORY_ARENA *arena
+)
+{
+    OS_HASH_MAP<uint64_t, uint64_t> map;
+    OS_HASH_SET<uint64_t>           set;
+    size_t                        limit = 0;
+    uint64_t                        key = 0;
+    os_arena_marker_t            marker = 0;
+
+    HASH_TEST_CHECK(OsCreateHashMap(&map, arena, 0, OS_HASH_TABLE_FLAG_FIXED_CAPACITY) < 0);
+    HASH_TEST_CHECK(OsCreateHashMap(&map, arena, 100, OS_HASH_TABLE_FLAG_FIXED_CAPACITY) == 0);
+    limit = map.Capacity - (map.Capacity / 8);
+    for (key = 0; key < limit; ++key)
+    {
+        HASH_TEST_CHECK(OsHashMapInsert(&map, key, key + 1) != NULL);
+    }
+    marker = OsHostMemoryArenaMark(arena);
+    HASH_TEST_CHECK(OsHashMapInsert(&map, key, key + 1) == NULL);
+    HASH_TEST_CHECK(map.Count == limit && OsHashMapFind(&map, key) == NULL);
+    HASH_TEST_CHECK(OsHostMemoryArenaMark(arena) == marker);
+    // replacing the value of a key that is already present does not need a slot.
+    HASH_TEST_CHECK(OsHashMapInsert(&map, (uint64_t) 0, (uint64_t) 42) != NULL && *OsHashMapFind(&map, (uint64_t) 0) == 42);
+    for (uint64_t i = 1; i < limit; ++i)
+    {
+        HASH_TEST_CHECK(OsHashMapFind(&map, i) != NULL && *OsHashMapFind(&map, i) == i + 1);
+    }
+    HASH_TEST_CHECK(OsHashMapReserve(&map, 2 * limit) == 0);
+    HASH_TEST_CHECK(OsHashMapInsert(&map, key, key + 1) != NULL && map.Count == limit + 1);
+
+    // sets report a full table with -1, distinct from 0 for a key that is already present.
+    HASH_TEST_CHECK(OsCreateHashSet(&set, arena, 10, OS_HASH_TABLE_FLAG_FIXED_CAPACITY) == 0);
+    limit = set.Capacity - (set.Capacity / 8);
+    for (key = 0; key < limit; ++key)
+    {
+        HASH_TEST_CHECK(OsHashSetInsert(&set, key) == 1);
+    }
+    HASH_TEST_CHECK(OsHashSetInsert(&set, (uint64_t) 0) == 0);
+    HASH_TEST_CHECK(OsHashSetInsert(&set, key) == -1);
+    HASH_TEST_CHECK(OsHashSetRemove(&set, (uint64_t) 0) && OsHashSetInsert(&set, key) == 1);
+    return true;
+}
+
+/// @summary Check that tables keyed by nul-terminated strings hash and compare the string contents rather than the pointers.
+/// @param arena The arena used for table storage.
+/// @return true if the test passed.
+internal_function bool
+HashTestStringKeys
+(
+    OS_HOST_MEMORY_ARENA *arena
+)
+{
+    size_t const                   KEY_COUNT = 500;
+    OS_HASH_MAP<char const*, uint32_t>   map;
+    OS_HASH_SET<char const*>             set;
+    char                              *names = (char*) OsHostMemoryArenaAllocate(arena, KEY_COUNT * 16, 16);
+    char                             *copies = (char*) OsHostMemoryArenaAllocate(arena, KEY_COUNT * 16, 16);
+    uint32_t                          *value = NULL;
+
+    HASH_TEST_CHECK(names != NULL && copies != NULL);
+    HASH_TEST_CHECK(OsCreateHashMap(&map, arena, 0, OS_HASH_TABLE_FLAGS_NONE) == 0);
+    HASH_TEST_CHECK(OsCreateHashSet(&set, arena, 0, OS_HASH_TABLE_FLAGS_NONE) == 0);
+    for (size_t i = 0; i < KEY_COUNT; ++i)
+    {   // each name has an identical copy at a different address.
+        snprintf(names  + (i * 16), 16, "key-%04u", (uint32_t) i);
+        snprintf(copies + (i * 16), 16, "key-%04u", (uint32_t) i);
+        HASH_TEST_CHECK(OsHashMapInsert(&map, (char const*)(names + (i * 16)), (uint32_t) i) != NULL);
+        HASH_TEST_CHECK(OsHashSetInsert(&set, (char const*)(names + (i * 16))) == 1);
+    }
+    for (size_t i = 0; i < KEY_COUNT; ++i)
+    {
+        char const *copy = copies + (i * 16);
+        HASH_TEST_CHECK((value = OsHashMapFind(&map, copy)) != NULL && *value == i);
+        HASH_TEST_CHECK(OsHashSetContains(&set, copy));
+        HASH_TEST_CHECK(OsHashSetInsert(&set, copy) == 0);
+    }
+    HASH_TEST_CHECK(map.Count == KEY_COUNT && set.Count == KEY_COUNT);
+    // a name that shares a prefix with stored keys, and erasure through a copy of the key.
+    HASH_TEST_CHECK(OsHashMapFind(&map, (char const*) "key-000") == NULL);
+    HASH_TEST_CHECK(OsHashMapRemove(&map, (char const*)(copies + 16)) && OsHashMapFind(&map, (char const*)(names + 16)) == NULL);
+    HASH_TEST_CHECK(OsHashSetRemove(&set, (char const*)(copies + 16)) && !OsHashSetContains(&set, (char const*)(names + 16)));
+    HASH_TEST_CHECK(map.Count == KEY_COUNT - 1 && set.Count == KEY_COUNT - 1);
+    return true;
+}
+
+/// @summary Run each of the hash table tests, resetting the test arena between them. The tables are task-local, so the tests run within the root task.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+HashTableTest
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        TEST_TASK_ARGS      *args = (TEST_TASK_ARGS*) task_args;
+        HASH_TEST_STATE    *state = (HASH_TEST_STATE*) args->TestState;
+        os_arena_marker_t  marker = OsHostMemoryArenaMark(&state->Arena);
+        bool               passed = true;
+        HASH_TEST_DESC const tests[] = 
+        {
+            { "ReferenceMap"    , HashTestReferenceMap    },
+            { "EraseMarkers"    , HashTestEraseMarkers    },
+            { "DeletedSlotReuse", HashTestDeletedSlotReuse},
+            { "RehashInPlace"   , HashTestRehashInPlace   },
+            { "FixedCapacity"   , HashTestFixedCapacity   },
+            { "StringKeys"      , HashTestStringKeys      },
+        };
+        for (size_t i = 0, n = sizeof(tests) / sizeof(tests[0]); i < n; ++i)
+        {
+            if (!tests[i].Func(&state->Arena))
+            {
+                OsLayerError("ERROR: %S(%u): Hash table test \"%S\" failed.\n", __FUNCTION__, taskenv->ThreadId, tests[i].Name);
+                passed = false;
+            }
+            OsHostMemoryArenaResetToMarker(&state->Arena, marker);
+        }
+        if (passed)
+        {
+            TEST_SUCCEEDED(args);
+        }
+        else
+        {
+            TEST_FAILED(args);
+        }
+    }
+}
+
+/// @summary Initialize a host memory arena over a block of global memory, and choose a file path in the temporary directory, for the arena snapshot test.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_state On return, set this value to test state data to be passed to the shutdown function.
+/// @return Zero if initialization is successful, or -1 if initialization failed.
+internal_function int
+ArenaSnapshotTestInit
+(
+    OS_TASK_ENVIRONMENT *taskenv, 
+    uintptr_t        *test_state
+)
+{
+    os_arena_marker_t   marker = OsConcurrentArenaMark(taskenv->GlobalMemory);
+    SNAPSHOT_TEST_STATE *state = OsConcurrentArenaAllocate<SNAPSHOT_TEST_STATE>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk);
+    uint8_t            *memory = (uint8_t*) OsConcurrentArenaAllocate(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk, SNAPSHOT_TEST_BYTES, 64);
+    if (state == NULL || memory == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to allocate global test state.\n", __FUNCTION__, OsThreadId());
+        OsConcurrentArenaResetToMarker(taskenv->GlobalMemory, marker);
+        return -1;
+    }
+    if (GetTempPathW(MAX_PATH, state->Path) == 0 || FAILED(StringCchCatW(state->Path, MAX_PATH, L"OsArenaSnapshotTest.snap")))
+    {
+        OsLayerError("ERROR: %S(%u): Unable to build the snapshot file path (%08X).\n", __FUNCTION__, OsThreadId(), GetLastError());
+        OsConcurrentArenaResetToMarker(taskenv->GlobalMemory, marker);
+        return -1;
+    }
+    if (OsCreateHostMemoryArena(&state->Arena, OsInitHostMemoryRange(memory, SNAPSHOT_TEST_BYTES)) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to create the snapshot test arena.\n", __FUNCTION__, OsThreadId());
+        OsConcurrentArenaResetToMarker(taskenv->GlobalMemory, marker);
+        return -1;
+    }
+   *test_state = (uintptr_t) state;
+    return 0;
+}
+
+/// @summary Delete the snapshot file and release the arena used by the arena snapshot test.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_args The arguments passed to the root task of the test harness.
+/// @return true if the test was successful, or false if the test failed.
+internal_function bool
+ArenaSnapshotTestShutdown
+(
+    OS_TASK_ENVIRONMENT *taskenv,
+    TEST_TASK_ARGS         *args
+)
+{
+    UNREFERENCED_PARAMETER(taskenv);
+    SNAPSHOT_TEST_STATE *state = (SNAPSHOT_TEST_STATE*) args->TestState;
+    DeleteFileW(state->Path);
+    OsDeleteHostMemoryArena(&state->Arena);
+    return *args->TestSucceeded;
+}
+
+/// @summary Corrupt a snapshot file in place, either by inverting one byte or by truncating the file.
+/// @param path The zero-terminated UTF-16 path of the snapshot file.
+/// @param offset The byte offset of the byte to invert, or the new size of the file if truncate is true.
+/// @param truncate true to truncate the file at offset, or false to invert the byte at offset.
+/// @return true if the file was modified.
+internal_function bool
+CorruptSnapshotFile
+(
+    WCHAR const *path, 
+    uint64_t   offset, 
+    bool     truncate
+)
+{
+    HANDLE        fd = INVALID_HANDLE_VALUE;
+    LARGE_INTEGER at = {};
+    DWORD     nbytes = 0;
+    uint8_t     byte = 0;
+    bool          ok = false;
+
+    if ((fd = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to open snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        return false;
+    }
+    at.QuadPart = (LONGLONG) offset;
+    if (truncate)
+    {
+        ok = SetFilePointerEx(fd, at, NULL, FILE_BEGIN) && SetEndOfFile(fd);
+    }
+    else if (SetFilePointerEx(fd, at, NULL, FILE_BEGIN) && ReadFile(fd, &byte, 1, &nbytes, NULL) && nbytes == 1)
+    {
+        byte ^= 0xFF;
+        ok = SetFilePointerEx(fd, at, NULL, FILE_BEGIN) && WriteFile(fd, &byte, 1, &nbytes, NULL) && nbytes == 1;
+    }
+    CloseHandle(fd);
+    return ok;
+}
+
+/// @summary Follow the links of the list in a mapped arena snapshot from the root object, checking that every node lies within the snapshot data and holds the value it was written with.
+/// @param snapshot The OS_ARENA_SNAPSHOT to check.
+/// @return true if the list is intact.
+internal_function bool
+CheckSnapshotList
+(
+    OS_ARENA_SNAPSHOT const *snapshot
+)
+{
+    SNAPSHOT_TEST_ROOT const *root = (SNAPSHOT_TEST_ROOT const*) snapshot->Root;
+    SNAPSHOT_TEST_NODE const *node = NULL;
+    uint64_t                 count = 0;
+
+    TEST_CHECK(root != NULL && root->NodeCount == SNAPSHOT_TEST_NODES);
+    for (node = OsRelativePtrGet(&root->Head); node != NULL; node = OsRelativePtrGet(&node->Next))
+    {
+        TEST_CHECK((uint8_t const*) node >= snapshot->BaseAddress && (uint8_t const*)(node + 1) <= snapshot->BaseAddress + snapshot->DataSize);
+        TEST_CHECK(count < root->NodeCount && node->Value == (count + 1) * 0x9E3779B97F4A7C15ULL);
+        count++;
+    }
+    TEST_CHECK(count == root->NodeCount);
+    return true;
+}
+
+/// @summary Build a linked list in a host memory arena, write it to a snapshot file and map it back, then check that damaged or mismatched files are rejected
+/// and that writes through a copy-on-write mapping never reach the file.
+/// @param state The SNAPSHOT_TEST_STATE holding the arena and the snapshot file path.
+/// @return true if the test passed.
+internal_function bool
+RunArenaSnapshotTest
+(
+    SNAPSHOT_TEST_STATE *state
+)
+{
+    OS_HOST_MEMORY_ARENA *arena = &state->Arena;
+    SNAPSHOT_TEST_ROOT     *root = OsHostMemoryArenaAllocate<SNAPSHOT_TEST_ROOT>(arena);
+    SNAPSHOT_TEST_NODE     *prev = NULL;
+    uint64_t           file_size = 0;
+    OS_ARENA_SNAPSHOT   snapshot;
+
+    TEST_CHECK(root != NULL);
+    root->Head.Offset = 0;
+    root->NodeCount   = SNAPSHOT_TEST_NODES;
+    for (uint64_t i = 0; i < SNAPSHOT_TEST_NODES; ++i)
+    {   // each node is linked from its predecessor, or from the root for the first node.
+        SNAPSHOT_TEST_NODE *node = OsHostMemoryArenaAllocate<SNAPSHOT_TEST_NODE>(arena);
+        TEST_CHECK(node != NULL);
+        node->Next.Offset = 0;
+        node->Value       = (i + 1) * 0x9E3779B97F4A7C15ULL;
+        OsRelativePtrSet(prev != NULL ? &prev->Next : &root->Head, node);
+        prev = node;
+    }
+    file_size = OS_ARENA_SNAPSHOT_DATA_ALIGNMENT + arena->Allocator.NextOffset;
+    TEST_CHECK(OsWriteArenaSnapshot(arena, root, SNAPSHOT_TEST_TAG, state->Path) == 0);
+
+    // the list is read through the mapping, which is at a different address than the arena it was built in.
+    TEST_CHECK(OsLoadArenaSnapshot(&snapshot, state->Path, SNAPSHOT_TEST_TAG, OS_ARENA_SNAPSHOT_FLAG_VERIFY_CHECKSUM) == 0);
+    TEST_CHECK(snapshot.BaseAddress != arena->HostMemory.HostAddress && snapshot.DataSize == arena->Allocator.NextOffset && snapshot.UserTag == SNAPSHOT_TEST_TAG);
+    TEST_CHECK((uint8_t*) snapshot.Root == snapshot.BaseAddress + ((uint8_t*) root - arena->HostMemory.HostAddress));
+    TEST_CHECK(CheckSnapshotList(&snapshot));
+    OsCloseArenaSnapshot(&snapshot);
+
+    // a snapshot written for a different data layout is rejected.
+    TEST_CHECK(OsLoadArenaSnapshot(&snapshot, state->Path, SNAPSHOT_TEST_TAG + 1, OS_ARENA_SNAPSHOT_FLAGS_NONE) < 0 && snapshot.MapPtr == NULL);
+
+    // writes through a copy-on-write mapping are private to the process, so the file still holds the original list.
+    TEST_CHECK(OsLoadArenaSnapshot(&snapshot, state->Path, SNAPSHOT_TEST_TAG, OS_ARENA_SNAPSHOT_FLAG_COPY_ON_WRITE) == 0);
+    {
+        SNAPSHOT_TEST_ROOT *cow_root = (SNAPSHOT_TEST_ROOT*) snapshot.Root;
+        SNAPSHOT_TEST_NODE *cow_head = OsRelativePtrGet(&cow_root->Head);
+        cow_head->Value       = 0;
+        cow_root->Head.Offset = 0;
+        TEST_CHECK(OsRelativePtrGet(&cow_root->Head) == NULL);
+    }
+    OsCloseArenaSnapshot(&snapshot);
+    TEST_CHECK(OsLoadArenaSnapshot(&snapshot, state->Path, SNAPSHOT_TEST_TAG, OS_ARENA_SNAPSHOT_FLAG_VERIFY_CHECKSUM) == 0);
+    TEST_CHECK(CheckSnapshotList(&snapshot));
+    OsCloseArenaSnapshot(&snapshot);
+
+    // invert a byte of the value of the last node. the header is intact, so only a load that verifies the checksum notices.
+    TEST_CHECK(CorruptSnapshotFile(state->Path, file_size - sizeof(uint64_t), false));
+    TEST_CHECK(OsLoadArenaSnapshot(&snapshot, state->Path, SNAPSHOT_TEST_TAG, OS_ARENA_SNAPSHOT_FLAG_VERIFY_CHECKSUM) < 0);
+    TEST_CHECK(OsLoadArenaSnapshot(&snapshot, state->Path, SNAPSHOT_TEST_TAG, OS_ARENA_SNAPSHOT_FLAGS_NONE) == 0);
+    OsCloseArenaSnapshot(&snapshot);
+
+    // a file that ends before the data described by its header is rejected, whether or not the checksum is verified.
+    TEST_CHECK(CorruptSnapshotFile(state->Path, file_size - sizeof(SNAPSHOT_TEST_NODE), true));
+    TEST_CHECK(OsLoadArenaSnapshot(&snapshot, state->Path, SNAPSHOT_TEST_TAG, OS_ARENA_SNAPSHOT_FLAGS_NONE) < 0);
+    TEST_CHECK(OsLoadArenaSnapshot(&snapshot, state->Path, SNAPSHOT_TEST_TAG, OS_ARENA_SNAPSHOT_FLAG_VERIFY_CHECKSUM) < 0);
+    return true;
+}
+
+/// @summary Run the arena snapshot test. The test performs file I/O on a single thread, so it runs within the root task.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+ArenaSnapshotTest
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        TEST_TASK_ARGS       *args = (TEST_TASK_ARGS*) task_args;
+        SNAPSHOT_TEST_STATE *state = (SNAPSHOT_TEST_STATE*) args->TestState;
+        if (RunArenaSnapshotTest(state))
+        {
+            TEST_SUCCEEDED(args);
+        }
+        else
+        {
+            TEST_FAILED(args);
+        }
+    }
+}
+
+/// @summary Implement the application thread used by the thread-affine task test. The thread owns a task pool and executes the tasks delivered to its mailbox until it is told to return the pool.
+/// @param argp The AFFINE_TEST_STATE.
+/// @return Zero if the thread exited normally, or 1 if it could not allocate its task pool.
+internal_function unsigned int __cdecl
+AffineTestHelperThread
+(
+    void *argp
+)
+{
+    AFFINE_TEST_STATE *state = (AFFINE_TEST_STATE*) argp;
+    OS_TASK_ENVIRONMENT  env = {};
+    HANDLE              wake = CreateEvent(NULL, FALSE, FALSE, NULL);
+    HANDLE           wset[2] = { state->HelperStop, wake };
+
+    if (wake == NULL || OsAllocateTaskPool(&env, state->Scheduler, state->HelperPoolId, GetCurrentThreadId()) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to set up the helper thread.\n", __FUNCTION__, GetCurrentThreadId());
+        if (wake != NULL) CloseHandle(wake);
+        state->Failed.store(1);
+        SetEvent(state->HelperReady);
+        return 1;
+    }
+    state->HelperPool     = OsGetTaskPoolIndex(&env);
+    state->HelperThreadId = env.ThreadId;
+    OsSetTaskMailboxEvent(&env, wake);
+    SetEvent(state->HelperReady);
+
+    while (WaitForMultipleObjects(2, wset, FALSE, INFINITE) == (WAIT_OBJECT_0 + 1))
+    {   // tasks were delivered to the mailbox. tasks they make ready-to-run are published to the workers.
+        OsExecuteMailboxTasks(&env);
+    }
+    // tasks targeting the pool after this point are cancelled.
+    OsReturnTaskPool(&env);
+    CloseHandle(wake);
+    return 0;
+}
+
+/// @summary Create the shared state and start the helper thread for the thread-affine task test.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_state On entry, the application pool type the helper thread allocates its task pool from. On return, the AFFINE_TEST_STATE.
+/// @return Zero if initialization is successful, or -1 if initialization failed.
+internal_function int
+AffineTaskTestInit
+(
+    OS_TASK_ENVIRONMENT *taskenv, 
+    uintptr_t        *test_state
+)
+{
+    AFFINE_TEST_STATE *state = OsConcurrentArenaAllocate<AFFINE_TEST_STATE>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk);
+    if (state == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to allocate global test state.\n", __FUNCTION__, OsThreadId());
+        return -1;
+    }
+    OsZeroMemory(state, sizeof(AFFINE_TEST_STATE));
+    state->Scheduler    = taskenv->TaskScheduler;
+    state->HelperPoolId =(uint32_t) *test_state;
+    state->HelperReady  = CreateEvent(NULL, TRUE, FALSE, NULL);
+    state->HelperStop   = CreateEvent(NULL, TRUE, FALSE, NULL);
+   *test_state = (uintptr_t) state;
+    if (state->HelperReady == NULL || state->HelperStop == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to create helper thread events (%08X).\n", __FUNCTION__, OsThreadId(), GetLastError());
+        return -1;
+    }
+    if ((state->HelperThread = (HANDLE) _beginthreadex(NULL, 0, AffineTestHelperThread, state, 0, NULL)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to start helper thread (errno = %d).\n", __FUNCTION__, OsThreadId(), errno);
+        return -1;
+    }
+    WaitForSingleObject(state->HelperReady, INFINITE);
+    return state->Failed.load() == 0 ? 0 : -1;
+}
+
+/// @summary Check that a thread-affine task is running on the thread that owns its target task pool.
+/// @param args The arguments of the running task.
+/// @param taskenv The execution environment of the running task.
+/// @return true if the task has no target pool, or if it is running on the owning thread.
+internal_function bool
+AffineTaskOnTarget
+(
+    AFFINE_TEST_ARGS const *args,
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    if (args->TargetPool == OS_TASK_POOL_INDEX_ANY)
+        return true;
+    return OsGetTaskPoolIndex(taskenv) == args->TargetPool && taskenv->ThreadId == args->TargetThread && GetCurrentThreadId() == args->TargetThread;
+}
+
+/// @summary Run an independent thread-affine task of the thread-affine task test.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AffineCheckTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    AFFINE_TEST_ARGS *args = (AFFINE_TEST_ARGS*) task_args;
+    if (!AffineTaskOnTarget(args, taskenv))
+    {
+        OsLayerError("FAILED: %S(%u): Task %u targeting pool %u ran on pool %u.\n", __FUNCTION__, GetCurrentThreadId(), args->Index, args->TargetPool, OsGetTaskPoolIndex(taskenv));
+        args->State->Failed.store(1);
+    }
+    args->State->AffineCount.fetch_add(1, std::memory_order_seq_cst);
+}
+
+/// @summary Run a link of the dependency chain of the thread-affine task test. Verifies that links run in order, on their target thread.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AffineChainTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    AFFINE_TEST_ARGS *args = (AFFINE_TEST_ARGS*) task_args;
+    if (!AffineTaskOnTarget(args, taskenv))
+    {
+        OsLayerError("FAILED: %S(%u): Link %u targeting pool %u ran on pool %u.\n", __FUNCTION__, GetCurrentThreadId(), args->Index, args->TargetPool, OsGetTaskPoolIndex(taskenv));
+        args->State->Failed.store(1);
+    }
+    if (args->State->ChainCount.fetch_add(1, std::memory_order_seq_cst) != args->Index)
+    {   // a link ran before its predecessor.
+        args->State->Failed.store(1);
+    }
+}
+
+/// @summary Run after every task defined by the root task of the thread-affine task test, and check that all of them ran.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AffineJoinTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    AFFINE_TEST_ARGS *args = (AFFINE_TEST_ARGS*) task_args;
+    if (args->State->AffineCount.load() != AFFINE_TEST_TASKS || args->State->ChainCount.load() != AFFINE_TEST_CHAIN)
+    {
+        OsLayerError("FAILED: %S(%u): Ran %u of %u affine tasks and %u of %u links.\n", __FUNCTION__, GetCurrentThreadId(), args->State->AffineCount.load(), AFFINE_TEST_TASKS, args->State->ChainCount.load(), AFFINE_TEST_CHAIN);
+        args->State->Failed.store(1);
+    }
+}
+
+/// @summary Implement the task that targets the helper thread after it has returned its task pool. The task must be cancelled, so it never runs.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AffineCancelledTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    AFFINE_TEST_ARGS *args = (AFFINE_TEST_ARGS*) task_args;
+    args->State->CancelRan.store(1);
+}
+
+/// @summary Implement the task that depends on the cancelled task. It must still run.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AffineAfterCancelTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    AFFINE_TEST_ARGS *args = (AFFINE_TEST_ARGS*) task_args;
+    args->State->AfterCancelRan.store(1);
+}
+
+/// @summary Check that a thread-affine task whose target pool is returned while the task waits on a dependency is cancelled rather than stranded, and that tasks depending on it still run.
+/// Called from the main thread after the tasks defined by the root task have completed.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param state The shared test state. The helper thread is stopped by this function.
+/// @return true if the test was successful, or false if the test failed.
+internal_function bool
+RunAffineCancelTest
+(
+    OS_TASK_ENVIRONMENT *taskenv,
+    AFFINE_TEST_STATE     *state
+)
+{
+    AFFINE_TEST_ARGS    args = { state, 0, state->HelperPool, state->HelperThreadId };
+    OS_TASK_FENCE      fence = {};
+    os_task_id_t        gate = OS_INVALID_TASK_ID;
+    os_task_id_t      cancel = OS_INVALID_TASK_ID;
+    os_task_id_t       after = OS_INVALID_TASK_ID;
+    bool           completed = false;
+
+    // the affine task cannot become ready-to-run until the gate is completed below.
+    TEST_CHECK((gate = OsCreateExternalTask(taskenv)) != OS_INVALID_TASK_ID);
+    TEST_CHECK((cancel = OsSpawnAffineTask(taskenv, state->HelperPool, AffineCancelledTask, &args, &gate, 1)) != OS_INVALID_TASK_ID);
+    TEST_CHECK((after = OsDefineTask(taskenv, OS_TASK_ID_TYPE_INTERNAL, AffineAfterCancelTask, &args, sizeof(args), &cancel, 1)) != OS_INVALID_TASK_ID);
+    TEST_CHECK(OsCreateTaskFence(taskenv, &fence, &after, 1) != OS_INVALID_TASK_ID);
+    OsFinishTaskDefinition(taskenv, after);
+
+    // return the helper thread's task pool while the affine task is still waiting.
+    SetEvent(state->HelperStop);
+    WaitForSingleObject(state->HelperThread, INFINITE);
+    CloseHandle(state->HelperThread);
+    state->HelperThread = NULL;
+
+    // new affine tasks cannot target the returned pool at all.
+    TEST_CHECK(OsDefineAffineTask(taskenv, OS_TASK_ID_TYPE_INTERNAL, AffineCancelledTask, &args, sizeof(args), state->HelperPool, NULL, 0) == OS_INVALID_TASK_ID);
+    TEST_CHECK(OsGetTaskPoolError(taskenv) == OS_TASK_POOL_ERROR_INVALID_TARGET);
+
+    // the waiting task is cancelled when the gate completes, which releases the task depending on it.
+    OsCompleteTask(taskenv, gate);
+    completed = OsWaitTaskFence(&fence, OsMillisecondsToNanoseconds(5000));
+    OsDestroyTaskFence(&fence);
+    TEST_CHECK(completed);
+    TEST_CHECK(state->CancelRan.load() == 0);
+    TEST_CHECK(state->AfterCancelRan.load() != 0);
+    return true;
+}
+
+/// @summary Stop the helper thread, run the cancellation check, and analyze the results of the thread-affine task test.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_args The arguments passed to the root task of the test harness.
+/// @return true if the test was successful, or false if the test failed.
+internal_function bool
+AffineTaskTestShutdown
+(
+    OS_TASK_ENVIRONMENT *taskenv,
+    TEST_TASK_ARGS         *args
+)
+{
+    AFFINE_TEST_STATE *state = (AFFINE_TEST_STATE*) args->TestState;
+    if (*args->TestSucceeded && !RunAffineCancelTest(taskenv, state))
+    {
+        TEST_FAILED(args);
+    }
+    if (state->HelperThread != NULL)
+    {
+        SetEvent(state->HelperStop);
+        WaitForSingleObject(state->HelperThread, INFINITE);
+        CloseHandle(state->HelperThread);
+    }
+    if (state->HelperReady != NULL) CloseHandle(state->HelperReady);
+    if (state->HelperStop  != NULL) CloseHandle(state->HelperStop);
+    if (state->Failed.load() != 0)
+    {
+        TEST_FAILED(args);
+    }
+    return *args->TestSucceeded;
+}
+
+/// @summary Test thread-affine tasks. Independent tasks target the helper thread and the worker running this task, and a dependency chain crosses between those pools and any worker.
+/// A child task depending on all of them keeps the test running until they have completed.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AffineTaskTest
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        TEST_TASK_ARGS      *args = (TEST_TASK_ARGS*) task_args;
+        AFFINE_TEST_STATE  *state = (AFFINE_TEST_STATE*) args->TestState;
+        uint32_t const  self_pool =  OsGetTaskPoolIndex(taskenv);
+        uint32_t const   pools[3] = { state->HelperPool    , self_pool        , OS_TASK_POOL_INDEX_ANY };
+        uint32_t const threads[3] = { state->HelperThreadId, taskenv->ThreadId, 0                      };
+        os_task_id_t  deps[AFFINE_TEST_TASKS + 1];
+        os_task_id_t         prev = OS_INVALID_TASK_ID;
+
+        for (uint32_t i = 0; i < AFFINE_TEST_TASKS; ++i)
+        {   // alternate between the helper thread and the worker running this task.
+            AFFINE_TEST_ARGS task = { state, i, pools[i & 1], threads[i & 1] };
+            if ((deps[i] = OsSpawnAffineTask(taskenv, task.TargetPool, AffineCheckTask, &task)) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn affine task %u (%d).\n", __FUNCTION__, taskenv->ThreadId, i, OsGetTaskPoolError(taskenv));
+                TEST_FAILED(args);
+                return;
+            }
+        }
+        for (uint32_t i = 0; i < AFFINE_TEST_CHAIN; ++i)
+        {   // each link becomes ready-to-run on the thread that ran the previous link, which is usually a different one.
+            AFFINE_TEST_ARGS link = { state, i, pools[i % 3], threads[i % 3] };
+            if ((prev = OsSpawnAffineTask(taskenv, link.TargetPool, AffineChainTask, &link, &prev, i == 0 ? 0 : 1)) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn chain link %u (%d).\n", __FUNCTION__, taskenv->ThreadId, i, OsGetTaskPoolError(taskenv));
+                TEST_FAILED(args);
+                return;
+            }
+        }
+        deps[AFFINE_TEST_TASKS] = prev;
+
+        AFFINE_TEST_ARGS join = { state, 0, OS_TASK_POOL_INDEX_ANY, 0 };
+        if (OsSpawnChildTask(taskenv, AffineJoinTask, &join, task_id, deps, AFFINE_TEST_TASKS + 1) == OS_INVALID_TASK_ID)
+        {
+            OsLayerError("ERROR: %S(%u): Failed to spawn join task (%d).\n", __FUNCTION__, taskenv->ThreadId, OsGetTaskPoolError(taskenv));
+            TEST_FAILED(args);
+            return;
+        }
+        TEST_SUCCEEDED(args);
+    }
+}
+
+/// @summary Initialize the global memory for the worker scaling test.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_state On return, set this value to test state data to be passed to the shutdown function.
+/// @return Zero if initialization is successful, or -1 if initialization failed.
+internal_function int
+WorkerScalingTestInit
+(
+    OS_TASK_ENVIRONMENT *taskenv, 
+    uintptr_t        *test_state
+)
+{
+    WORKER_SCALING_TEST_STATE *state = OsConcurrentArenaAllocate<WORKER_SCALING_TEST_STATE>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk);
+    if (state == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to allocate global test state.\n", __FUNCTION__, OsThreadId());
+        return -1;
+    }
+    state->LinkCount.store(0, std::memory_order_relaxed);
+    state->LeafCount.store(0, std::memory_order_relaxed);
+    state->Failed.store(0, std::memory_order_relaxed);
+   *test_state = (uintptr_t) state;
+    return 0;
+}
+
+/// @summary Check that every link and leaf of the worker scaling test ran exactly once.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param test_args The arguments passed to the root task of the test harness.
+/// @return true if the test was successful, or false if the test failed.
+internal_function bool
+WorkerScalingTestShutdown
+(
+    OS_TASK_ENVIRONMENT *taskenv,
+    TEST_TASK_ARGS         *args
+)
+{
+    UNREFERENCED_PARAMETER(taskenv);
+    WORKER_SCALING_TEST_STATE *state = (WORKER_SCALING_TEST_STATE*) args->TestState;
+    uint32_t const        link_count = WORKER_SCALING_TEST_CHAINS * WORKER_SCALING_TEST_DEPTH;
+    uint32_t const        leaf_count = link_count * WORKER_SCALING_TEST_LEAVES;
+    if (state->Failed.load() != 0 || state->LinkCount.load() != link_count || state->LeafCount.load() != leaf_count)
+    {
+        OsLayerError("FAILED: %S(%u): Ran %u of %u links and %u of %u leaves.\n", __FUNCTION__, OsThreadId(), state->LinkCount.load(), link_count, state->LeafCount.load(), leaf_count);
+        TEST_FAILED(args);
+    }
+    return *args->TestSucceeded;
+}
+
+/// @summary Spin for WORKER_SCALING_TEST_LEAF_NS to keep workers busy while the worker count changes.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+WorkerScalingLeafTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    WORKER_SCALING_TEST_ARGS *args = (WORKER_SCALING_TEST_ARGS*) task_args;
+    uint64_t            start_time = OsTimestampInTicks();
+    do
+    {
+        _mm_pause();
+    } while (OsElapsedNanoseconds(start_time, OsTimestampInTicks()) < WORKER_SCALING_TEST_LEAF_NS);
+    args->State->LeafCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// @summary Run one link of a worker scaling test dependency chain. The link publishes its leaf tasks and defines the next link, which waits on the leaves in the task pool of the worker running this link.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+WorkerScalingLinkTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        WORKER_SCALING_TEST_ARGS  *args = (WORKER_SCALING_TEST_ARGS*) task_args;
+        WORKER_SCALING_TEST_STATE *state = args->State;
+        os_task_id_t leaves[WORKER_SCALING_TEST_LEAVES];
+
+        state->LinkCount.fetch_add(1, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < WORKER_SCALING_TEST_LEAVES; ++i)
+        {
+            if ((leaves[i] = OsSpawnChildTask(taskenv, WorkerScalingLeafTask, args, args->RootId)) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn leaf %u (%d).\n", __FUNCTION__, taskenv->ThreadId, i, OsGetTaskPoolError(taskenv));
+                state->Failed.store(1);
+                return;
+            }
+        }
+        if (args->Depth > 1)
+        {
+            WORKER_SCALING_TEST_ARGS next = { state, args->RootId, args->Depth - 1 };
+            if (OsSpawnChildTask(taskenv, WorkerScalingLinkTask, &next, args->RootId, leaves, WORKER_SCALING_TEST_LEAVES) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn chain link %u (%d).\n", __FUNCTION__, taskenv->ThreadId, next.Depth, OsGetTaskPoolError(taskenv));
+                state->Failed.store(1);
+            }
+        }
+        // spread the leaves across the other workers, so that the next link stays in this pool while they run.
+        OsPublishTasks(taskenv, WORKER_SCALING_TEST_LEAVES);
+    }
+}
+
+/// @summary Start the dependency chains of the worker scaling test.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+WorkerScalingTest
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        TEST_TASK_ARGS             *args = (TEST_TASK_ARGS*) task_args;
+        WORKER_SCALING_TEST_STATE *state = (WORKER_SCALING_TEST_STATE*) args->TestState;
+        for (uint32_t i = 0; i < WORKER_SCALING_TEST_CHAINS; ++i)
+        {
+            WORKER_SCALING_TEST_ARGS link = { state, task_id, WORKER_SCALING_TEST_DEPTH };
+            if (OsSpawnChildTask(taskenv, WorkerScalingLinkTask, &link, task_id) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn chain %u (%d).\n", __FUNCTION__, taskenv->ThreadId, i, OsGetTaskPoolError(taskenv));
+                state->Failed.store(1);
+                break;
+            }
+            OsPublishTasks(taskenv, 1);
+        }
+        TEST_SUCCEEDED(args);
+    }
+}
+
+/// @summary Execute the worker scaling test. This works like ParallelTest, except that while the tasks run the main thread alternately retires all but one worker and relaunches them.
+/// Afterwards, a scaling policy with no maximum and a minimum above the scheduler limit must restore every worker, which also leaves the scheduler at full strength for the benchmarks.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @return true if the test was successful, or false if the test failed.
+internal_function bool
+WorkerScalingParallelTest
+(
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    TEST_SCOPE                        test("WorkerScalingTest", taskenv);
+    OS_TASK_SCHEDULER           *scheduler = taskenv->TaskScheduler;
+    OS_TASK_SCHEDULER_SCALING_POLICY policy = {};
+    size_t                     max_workers = scheduler->MaxWorkerThreadCount;
+    size_t                          active = 0;
+    uint32_t                   resize_count = 0;
+    uintptr_t                    test_state = 0;
+    TEST_TASK_ARGS                     args = {};
+    os_task_id_t                  root_task = OS_INVALID_TASK_ID;
+    OS_TASK_FENCE                fence_done = {};
+    bool                        did_succeed = false;
+
+    OsConcurrentArenaReset(taskenv->GlobalMemory);
+    if (WorkerScalingTestInit(taskenv, &test_state) < 0)
+    {
+        OsLayerError("FAILED: Initialization for test failed.\n");
+        return false;
+    }
+    args.TestState     = test_state;
+    args.TestSucceeded =&did_succeed;
+
+    if ((root_task = OsDefineTask(taskenv, WorkerScalingTest, &args)) == OS_INVALID_TASK_ID)
+    {
+        OsLayerError("FAILED: Unable to create root task (%d).\n", OsGetTaskPoolError(taskenv));
+        goto test_cleanup;
+    }
+    if (OsCreateTaskFence(taskenv, &fence_done, &root_task, 1) == OS_INVALID_TASK_ID)
+    {
+        OsLayerError("FAILED: Unable to create fence (%d).\n", OsGetTaskPoolError(taskenv));
+        goto test_cleanup;
+    }
+    OsFinishTaskDefinition(taskenv, root_task);
+
+    while (!OsWaitTaskFence(&fence_done, OsMillisecondsToNanoseconds(1)))
+    {   // retired workers must finish the chain links waiting in their task pools before the pools are reused.
+        active = scheduler->WorkerThreadCount.load(std::memory_order_seq_cst);
+        if (resize_count++ & 1)
+        {
+            OsAddWorkerThreads(scheduler, max_workers - active);
+        }
+        else
+        {
+            OsRemoveWorkerThreads(scheduler, active - 1);
+        }
+    }
+    OsDestroyTaskFence(&fence_done);
+
+    // a maximum of zero means the scheduler limit, and the minimum is clamped to it.
+    // the first update after the scheduler is created only takes a sample.
+    policy.MinWorkerThreads = max_workers + 1;
+    policy.MaxWorkerThreads = 0;
+    OsRemoveWorkerThreads(scheduler, scheduler->WorkerThreadCount.load(std::memory_order_seq_cst) - 1);
+    OsUpdateWorkerThreadCount(scheduler, &policy);
+    if ((active = OsUpdateWorkerThreadCount(scheduler, &policy)) != max_workers)
+    {
+        OsLayerError("FAILED: %S(%u): Scaling policy restored %Iu of %Iu workers.\n", __FUNCTION__, OsThreadId(), active, max_workers);
+        OsAddWorkerThreads(scheduler, max_workers - scheduler->WorkerThreadCount.load(std::memory_order_seq_cst));
+        did_succeed = false;
+    }
+    else if (max_workers > 1 && resize_count == 0)
+    {
+        OsLayerError("FAILED: %S(%u): The tasks completed before the worker count was changed.\n", __FUNCTION__, OsThreadId());
+        did_succeed = false;
+    }
+
+test_cleanup:
+    did_succeed = WorkerScalingTestShutdown(taskenv, &args);
+    OsLayerError("STATUS: Finished test \"%S\" (%S).\n", "WorkerScalingTest", did_succeed ? "SUCCEEDED" : "FAILED");
+    return did_succeed;
+}
+
+/// @summary Compute the number of leaf tasks executed by the recursive fib benchmark for a given depth.
+/// @param n The recursion depth.
+/// @return The number of leaf tasks (those with depth less than 2) in the call tree.
+internal_function uint32_t
+FibLeafCount
+(
+    uint32_t n
+)
+{
+    uint32_t a = 1;
+    uint32_t b = 1;
+    for (uint32_t i = 1; i < n; ++i)
+    {
+        uint32_t t = a + b;
+        a = b;
+        b = t;
+    }
+    return b;
+}
+
+/// @summary Sort an array of timing samples into ascending order. The sample count is small, so insertion sort is used.
+/// @param samples The array of samples to sort.
+/// @param count The number of samples in the array.
+internal_function void
+SortSamples
+(
+    uint64_t *samples, 
+    size_t      count
+)
+{
+    for (size_t i = 1; i < count; ++i)
+    {
+        uint64_t v = samples[i];
+        size_t   j = i;
+        while (j > 0 && samples[j-1] > v)
+        {
+            samples[j] = samples[j-1];
+            --j;
+        }
+        samples[j] = v;
+    }
+}
+
+/// @summary Retrieve a percentile value from a sorted sample array using the nearest-rank method.
+/// @param samples The sorted array of samples.
+/// @param count The number of samples in the array. Must be at least 1.
+/// @param percentile The percentile to retrieve, in [1, 100].
+/// @return The sample value at the specified percentile.
+internal_function uint64_t
+SamplePercentile
+(
+    uint64_t const *samples, 
+    size_t            count, 
+    uint32_t     percentile
+)
+{
+    size_t rank = (percentile * count + 99) / 100;
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return samples[rank - 1];
+}
+
+/// @summary Busy-wait the calling thread for a specified amount of time to simulate a fixed amount of work.
+/// @param nanoseconds The amount of time to spin, in nanoseconds.
+internal_function void
+SpinFor
+(
+    uint64_t nanoseconds
+)
+{
+    uint64_t start_time = OsTimestampInTicks();
+    do
+    {
+        _mm_pause();
+    } while (OsElapsedNanoseconds(start_time, OsTimestampInTicks()) < nanoseconds);
+}
+
+/// @summary Record a latency sample, retaining the largest value seen during the current run.
+/// @param state The benchmark state.
+/// @param latency_ns The latency value to record, in nanoseconds.
+internal_function void
+RecordMaxLatency
+(
+    BENCHMARK_STATE *state, 
+    uint64_t    latency_ns
+)
+{
+    uint64_t current = state->SampleNs.load(std::memory_order_relaxed);
+    while (latency_ns > current)
+    {
+        if (state->SampleNs.compare_exchange_weak(current, latency_ns, std::memory_order_seq_cst, std::memory_order_relaxed))
+            break;
+    }
+}
+
+/// @summary A leaf task that performs no work beyond incrementing the benchmark counter.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+BenchCountTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+    args->State->Counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// @summary A task that does nothing. Used as a gate that the root task holds open.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+BenchNoOpTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(task_args);
+    UNREFERENCED_PARAMETER(taskenv);
+}
+
+/// @summary Measure spawn/complete throughput. The root task spawns Param empty child tasks from a single thread.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+SpawnThroughputBench
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS  *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE     *state =  args->State;
+        BENCHMARK_TASK_ARGS  child = {state, 0, 0, 0, OS_INVALID_TASK_ID};
+        for (uint32_t i = 0, n = state->Param; i < n; ++i)
+        {
+            child.Index = i;
+            if (OsSpawnChildTask(taskenv, BenchCountTask, &child, task_id) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn child %u (%d).\n", __FUNCTION__, taskenv->ThreadId, i, OsGetTaskPoolError(taskenv));
+                state->Failed.store(1);
+                break;
+            }
+            if ((i & 255) == 255)
+            {   // let idle workers start stealing while the root continues to spawn.
+                OsPublishTasks(taskenv, 1);
+            }
+        }
+        OsPublishTasks(taskenv, state->WorkerCount);
+    }
+}
+
+/// @summary Spawn one chunk of leaf tasks for the fan-out/fan-in benchmark.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+FanOutChunkTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS  *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE     *state =  args->State;
+        BENCHMARK_TASK_ARGS  child = {state, 0, 0, 0, OS_INVALID_TASK_ID};
+        for (uint32_t i = 0, n = args->Count; i < n; ++i)
+        {
+            child.Index = args->Index + i;
+            if (OsSpawnChildTask(taskenv, BenchCountTask, &child, task_id) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn leaf %u (%d).\n", __FUNCTION__, taskenv->ThreadId, child.Index, OsGetTaskPoolError(taskenv));
+                state->Failed.store(1);
+                break;
+            }
+        }
+        OsPublishTasks(taskenv, 1);
+    }
+}
+
+/// @summary Verify the results of the fan-out stage. This task runs only after all chunk tasks (and their children) complete.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+FanInJoinTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE    *state =  args->State;
+        if (state->Counter.load(std::memory_order_seq_cst) != state->Param)
+        {   // the join ran before all of its dependencies finished.
+            state->Failed.store(1);
+        }
+    }
+}
+
+/// @summary Measure wide fan-out and fan-in. The root spawns one chunk task per worker, each of which spawns Param/WorkerCount leaves, and a join task that depends on every chunk.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+FanOutFanInBench
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS  *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE     *state =  args->State;
+        uint32_t const  MAX_CHUNKS =  64;
+        os_task_id_t     chunk_ids[MAX_CHUNKS];
+        uint32_t            chunks =  state->WorkerCount;
+        if (chunks > MAX_CHUNKS)
+            chunks = MAX_CHUNKS;
+        if (chunks < 1)
+            chunks = 1;
+        uint32_t             count =  state->Param / chunks;
+        uint32_t             extra =  state->Param % chunks;
+        for (uint32_t i = 0; i < chunks; ++i)
+        {
+            BENCHMARK_TASK_ARGS chunk = {state, 0, count * i, count, OS_INVALID_TASK_ID};
+            if (i == (chunks - 1))
+            {   // the last chunk picks up any remainder.
+                chunk.Count += extra;
+            }
+            if ((chunk_ids[i] = OsSpawnChildTask(taskenv, FanOutChunkTask, &chunk, task_id)) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn chunk %u (%d).\n", __FUNCTION__, taskenv->ThreadId, i, OsGetTaskPoolError(taskenv));
+                state->Failed.store(1);
+                return;
+            }
+            OsPublishTasks(taskenv, 1);
+        }
+        BENCHMARK_TASK_ARGS join = {state, 0, 0, 0, OS_INVALID_TASK_ID};
+        if (OsSpawnChildTask(taskenv, FanInJoinTask, &join, task_id, chunk_ids, chunks) == OS_INVALID_TASK_ID)
+        {
+            OsLayerError("ERROR: %S(%u): Failed to spawn join task (%d).\n", __FUNCTION__, taskenv->ThreadId, OsGetTaskPoolError(taskenv));
+            state->Failed.store(1);
+        }
+    }
+}
+
+/// @summary A single link in the dependency chain benchmark. Verifies that links run in order.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+ChainLinkTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+    if (args->State->Counter.fetch_add(1, std::memory_order_seq_cst) != args->Index)
+    {   // a link ran before its predecessor.
+        args->State->Failed.store(1);
+    }
+}
+
+/// @summary Measure a long dependency chain. The root spawns Param tasks, each of which depends on the previous one.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+DependencyChainBench
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS  *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE     *state =  args->State;
+        os_task_id_t          prev =  OS_INVALID_TASK_ID;
+        for (uint32_t i = 0, n = state->Param; i < n; ++i)
+        {
+            BENCHMARK_TASK_ARGS link = {state, 0, i, 0, OS_INVALID_TASK_ID};
+            size_t            ndeps = (i == 0) ? 0 : 1;
+            if ((prev = OsSpawnChildTask(taskenv, ChainLinkTask, &link, task_id, &prev, ndeps)) == OS_INVALID_TASK_ID)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to spawn chain link %u (%d).\n", __FUNCTION__, taskenv->ThreadId, i, OsGetTaskPoolError(taskenv));
+                state->Failed.store(1);
+                return;
+            }
+        }
+    }
+}
+
+/// @summary Recursive fib-style task. Spawns two children for depths 2 and above; leaves increment the benchmark counter.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+FibTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+    BENCHMARK_STATE    *state =  args->State;
+    if (args->Index < 2)
+    {
+        state->Counter.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    BENCHMARK_TASK_ARGS    n1 = {state, 0, args->Index - 1, 0, OS_INVALID_TASK_ID};
+    BENCHMARK_TASK_ARGS    n2 = {state, 0, args->Index - 2, 0, OS_INVALID_TASK_ID};
+    if (OsSpawnChildTask(taskenv, FibTask, &n1, task_id) == OS_INVALID_TASK_ID || 
+        OsSpawnChildTask(taskenv, FibTask, &n2, task_id) == OS_INVALID_TASK_ID)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to spawn fib(%u) children (%d).\n", __FUNCTION__, taskenv->ThreadId, args->Index, OsGetTaskPoolError(taskenv));
+        state->Failed.store(1);
+        return;
+    }
+    // keep one child local, and offer the other to an idle worker.
+    OsPublishTasks(taskenv, 1);
+}
+
+/// @summary Measure recursive fib-style spawning with a recursion depth of Param.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+RecursiveFibBench
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS  *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE     *state =  args->State;
+        BENCHMARK_TASK_ARGS   root = {state, 0, state->Param, 0, OS_INVALID_TASK_ID};
+        if (OsSpawnChildTask(taskenv, FibTask, &root, task_id) == OS_INVALID_TASK_ID)
+        {
+            OsLayerError("ERROR: %S(%u): Failed to spawn fib(%u) (%d).\n", __FUNCTION__, taskenv->ThreadId, state->Param, OsGetTaskPoolError(taskenv));
+            state->Failed.store(1);
+        }
+    }
+}
+
+/// @summary Run on a worker thread and spin inside OsWaitForTask, which steals from every task pool, until the gate task completes.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+StealThiefTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+    args->State->Ready.store(1, std::memory_order_seq_cst);
+    OsWaitForTask(taskenv, args->WaitId);
+}
+
+/// @summary The task measured by the steal latency benchmark. Records the time elapsed since it was pushed onto the victim's queue.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+StealTargetTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+    args->State->SampleNs.store(OsElapsedNanoseconds(args->SpawnTicks, OsTimestampInTicks()));
+    args->State->Done.store(1, std::memory_order_seq_cst);
+}
+
+/// @summary Measure steal latency: the time from a task being pushed onto a busy worker's queue until an already-awake thief starts executing it.
+/// No steal notification is published for the measured task, so only the spinning thief can pick it up.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+StealLatencyBench
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS  *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE     *state =  args->State;
+        os_task_id_t          gate =  OS_INVALID_TASK_ID;
+
+        // the gate is held open (not finished) until the measurement completes.
+        if ((gate = OsDefineChildTask(taskenv, BenchNoOpTask, task_id)) == OS_INVALID_TASK_ID)
+        {
+            state->Failed.store(1);
+            return;
+        }
+        BENCHMARK_TASK_ARGS thief = {state, 0, 0, 0, gate};
+        if (OsSpawnChildTask(taskenv, StealThiefTask, &thief, task_id) == OS_INVALID_TASK_ID)
+        {
+            state->Failed.store(1);
+            OsFinishTaskDefinition(taskenv, gate);
+            return;
+        }
+        // notify every worker; the notification sent to this thread's own worker 
+        // would otherwise sit in its completion port until this task returns.
+        OsPublishTasks(taskenv, state->WorkerCount);
+        while (state->Ready.load(std::memory_order_seq_cst) == 0)
+        {
+            _mm_pause();
+        }
+
+        BENCHMARK_TASK_ARGS target = {state, OsTimestampInTicks(), 0, 0, OS_INVALID_TASK_ID};
+        if (OsSpawnChildTask(taskenv, StealTargetTask, &target, task_id) == OS_INVALID_TASK_ID)
+        {
+            state->Failed.store(1);
+            OsFinishTaskDefinition(taskenv, gate);
+            return;
+        }
+        while (state->Done.load(std::memory_order_seq_cst) == 0)
+        {   // this thread must not run the target itself.
+            _mm_pause();
+        }
+        OsFinishTaskDefinition(taskenv, gate);
+    }
+}
+
+/// @summary Measure wake-from-idle latency. The harness sleeps before each run so every worker is blocked; this root task records the time since it was defined on the main thread.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+WakeLatencyBench
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+    args->State->SampleNs.store(OsElapsedNanoseconds(args->State->StartTicks, OsTimestampInTicks()));
+}
+
+/// @summary A long-running task used to occupy worker threads in the interference benchmark.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+LongWorkTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+        SpinFor(args->Count * 1000ULL);
+    }
+}
+
+/// @summary A short latency-sensitive task used in the interference benchmark. Records the time elapsed since it was spawned.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+LatencyProbeTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    UNREFERENCED_PARAMETER(taskenv);
+    BENCHMARK_TASK_ARGS *args = (BENCHMARK_TASK_ARGS*) task_args;
+    RecordMaxLatency(args->State, OsElapsedNanoseconds(args->SpawnTicks, OsTimestampInTicks()));
+    args->State->Counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// @summary Measure interference between long-running and latency-sensitive work. The root occupies every worker with a long task, then spawns Param short probes; the sample is the worst probe latency.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+MixedInterferenceBench
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS  *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE     *state =  args->State;
+        BENCHMARK_TASK_ARGS   work = {state, 0, 0, 500, OS_INVALID_TASK_ID}; // 500us per long task
+        for (uint32_t i = 0, n = state->WorkerCount; i < n; ++i)
+        {
+            if (OsSpawnChildTask(taskenv, LongWorkTask, &work, task_id) == OS_INVALID_TASK_ID)
+            {
+                state->Failed.store(1);
+                return;
+            }
+            OsPublishTasks(taskenv, 1);
+        }
+        for (uint32_t i = 0, n = state->Param; i < n; ++i)
+        {
+            BENCHMARK_TASK_ARGS probe = {state, OsTimestampInTicks(), i, 0, OS_INVALID_TASK_ID};
+            if (OsSpawnChildTask(taskenv, LatencyProbeTask, &probe, task_id) == OS_INVALID_TASK_ID)
+            {
+                state->Failed.store(1);
+                return;
+            }
+            OsPublishTasks(taskenv, 1);
+        }
+    }
+}
+
+/// @summary Run Count iterations of the allocator stress workload of the benchmark on the executing worker, using the thread caches and chained arena of its task pool.
+/// Blocks are not stamped, so the benchmark measures the allocator, including the cost of freeing blocks allocated on other workers.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AllocatorScalingTask
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    UNREFERENCED_PARAMETER(task_id);
+    BENCHMARK_TASK_ARGS      *args = (BENCHMARK_TASK_ARGS*) task_args;
+    BENCHMARK_STATE         *state =  args->State;
+    if (!RunAllocatorStress(state->Allocator, state->Allocators, OsGetTaskPoolIndex(taskenv), args->Index, args->Count))
+        state->Failed.store(1);
+    state->Counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// @summary Measure how the throughput of one of the shared allocators scales with the number of workers. The root task spawns Param tasks, each of which runs 
+/// ALLOCATOR_BENCHMARK_OPS iterations of the allocator stress workload; with perfect scaling the wall-clock time of a run does not depend on Param.
+/// @param task_id The unique identifier of the task, returned to the application when the task was defined.
+/// @param task_args A pointer to the parameter data supplied with the task. This pointer is always valid.
+/// @param taskenv The execution environment for the task, providing access to local and global memory.
+internal_function void
+AllocatorScalingBench
+(
+    os_task_id_t         task_id, 
+    void              *task_args, 
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_PROFILE_TASK(task_id, taskenv);
+    {
+        BENCHMARK_TASK_ARGS  *args = (BENCHMARK_TASK_ARGS*) task_args;
+        BENCHMARK_STATE     *state =  args->State;
+        BENCHMARK_TASK_ARGS  child = {state, 0, 0, ALLOCATOR_BENCHMARK_OPS, OS_INVALID_TASK_ID};
+        for (uint32_t i = 0, n = state->Param; i < n; ++i)
+        {
+            child.Index = i;
+            if (OsSpawnChildTask(taskenv, AllocatorScalingTask, &child, task_id) == OS_INVALID_TASK_ID)
+            {
+                state->Failed.store(1);
+                return;
+            }
+            OsPublishTasks(taskenv, 1);
+        }
+    }
+}
+
+/// @summary Execute a benchmark several times and compute summary statistics for the measured runs.
+/// @param result On return, the summary statistics for the benchmark.
+/// @param desc The benchmark to execute.
+/// @param config The warmup and measurement run counts.
+/// @param taskenv The OS_TASK_ENVIRONMENT for the main thread.
+/// @param samples An array of at least config->MeasuredRuns values used to store the raw samples.
+/// @return true if all runs completed and passed verification.
+internal_function bool
+RunBenchmark
+(
+    BENCHMARK_RESULT       *result, 
+    BENCHMARK_DESC const     *desc, 
+    BENCHMARK_CONFIG const *config, 
+    OS_TASK_ENVIRONMENT   *taskenv, 
+    uint64_t              *samples
+)
+{
+    OS_TASK_FENCE     fence = {};
+    uint32_t   worker_count = (uint32_t) taskenv->TaskScheduler->WorkerThreadCount;
+    uint32_t     total_runs = config->WarmupRuns + config->MeasuredRuns;
+    uint64_t            sum = 0;
+
+    OsZeroMemory(result, sizeof(BENCHMARK_RESULT));
+    result->Name      = desc->Name;
+    result->ItemCount = desc->ItemCount;
+
+    if (worker_count < desc->MinWorkers)
+    {
+        OsLayerError("SKIP: Benchmark \"%S\" requires at least %u worker threads (have %u).\n", desc->Name, desc->MinWorkers, worker_count);
+        result->Skipped = true;
+        return true;
+    }
+
+    for (uint32_t run = 0; run < total_runs; ++run)
+    {
+        BENCHMARK_STATE     *state = NULL;
+        BENCHMARK_TASK_ARGS   args = {};
+        os_task_id_t          root = OS_INVALID_TASK_ID;
+        uint64_t        start_time = 0;
+        uint64_t          end_time = 0;
+
+        // each run gets fresh state in global memory.
+        OsConcurrentArenaReset(taskenv->GlobalMemory);
+        if ((state = OsConcurrentArenaAllocate<BENCHMARK_STATE>(taskenv->GlobalMemory, &taskenv->GlobalMemoryChunk)) == NULL)
+        {
+            OsLayerError("ERROR: %S(%u): Failed to allocate state for benchmark \"%S\".\n", __FUNCTION__, OsThreadId(), desc->Name);
+            goto benchmark_failed;
+        }
+        OsZeroMemory(state, sizeof(BENCHMARK_STATE));
+        state->Param       = desc->Param;
+        state->WorkerCount = worker_count;
+        state->Allocators  = config->Allocators;
+        state->Allocator   = desc->Allocator;
+        args.State         = state;
+
+        if (desc->IdleMs > 0)
+        {   // give every worker time to go back to sleep on its completion port.
+            Sleep(desc->IdleMs);
+        }
+
+        start_time = OsTimestampInTicks();
+        state->StartTicks = start_time;
+        if ((root = OsDefineTask(taskenv, desc->RootTask, &args)) == OS_INVALID_TASK_ID)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to create root task for benchmark \"%S\" (%d).\n", __FUNCTION__, OsThreadId(), desc->Name, OsGetTaskPoolError(taskenv));
+            goto benchmark_failed;
+        }
+        if (OsCreateTaskFence(taskenv, &fence, &root, 1) == OS_INVALID_TASK_ID)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to create fence for benchmark \"%S\" (%d).\n", __FUNCTION__, OsThreadId(), desc->Name, OsGetTaskPoolError(taskenv));
+            OsFinishTaskDefinition(taskenv, root);
+            goto benchmark_failed;
+        }
+        OsFinishTaskDefinition(taskenv, root);
+        OsWaitTaskFence(&fence);
+        end_time = OsTimestampInTicks();
+
+        if (state->Failed.load() != 0 || (desc->ExpectCount != 0 && state->Counter.load() != desc->ExpectCount))
+        {
+            OsLayerError("ERROR: %S(%u): Benchmark \"%S\" failed verification on run %u (count %u, expected %u).\n", __FUNCTION__, OsThreadId(), desc->Name, run, state->Counter.load(), desc->ExpectCount);
+            goto benchmark_failed;
+        }
+        if (run >= config->WarmupRuns)
+        {
+            uint64_t sample = desc->MeasureLatency ? state->SampleNs.load() : OsElapsedNanoseconds(start_time, end_time);
+            samples[run - config->WarmupRuns] = sample;
+            sum += sample;
+        }
+    }
+    OsDestroyTaskFence(&fence);
+
+    SortSamples(samples, config->MeasuredRuns);
+    result->SampleCount = config->MeasuredRuns;
+    result->MinNs       = samples[0];
+    result->MaxNs       = samples[config->MeasuredRuns - 1];
+    result->MeanNs      = sum / config->MeasuredRuns;
+    result->MedianNs    = SamplePercentile(samples, config->MeasuredRuns, 50);
+    result->P99Ns       = SamplePercentile(samples, config->MeasuredRuns, 99);
+    OsLayerError("STATUS: Benchmark \"%S\" median %I64uns p99 %I64uns.\n", desc->Name, result->MedianNs, result->P99Ns);
+    return true;
+
+benchmark_failed:
+    OsDestroyTaskFence(&fence);
+    result->Failed = true;
+    return false;
+}
+
+/// @summary Copy memory using the C runtime.
+internal_function void
+CrtCopyBench
+(
+    void       *dst, 
+    void const *src, 
+    size_t     size
+)
+{
+    memcpy(dst, src, size);
+}
+
+/// @summary Copy memory using the OS layer.
+internal_function void
+OsCopyBench
+(
+    void       *dst, 
+    void const *src, 
+    size_t     size
+)
+{
+    OsCopyMemory(dst, src, size);
+}
+
+/// @summary Fill memory using the C runtime.
+internal_function void
+CrtFillBench
+(
+    void       *dst, 
+    void const *src, 
+    size_t     size
+)
+{
+    UNREFERENCED_PARAMETER(src);
+    memset(dst, 0x5A, size);
+}
+
+/// @summary Fill memory using the OS layer.
+internal_function void
+OsFillBench
+(
+    void       *dst, 
+    void const *src, 
+    size_t     size
+)
+{
+    UNREFERENCED_PARAMETER(src);
+    OsFillMemory(dst, size, 0x5A);
+}
+
+/// @summary Compare two identical blocks of memory using the C runtime.
+internal_function void
+CrtCompareBench
+(
+    void       *dst, 
+    void const *src, 
+    size_t     size
+)
+{
+    MemoryBenchmarkSink += memcmp(dst, src, size);
+}
+
+/// @summary Compare two identical blocks of memory using the OS layer.
+internal_function void
+OsCompareBench
+(
+    void       *dst, 
+    void const *src, 
+    size_t     size
+)
+{
+    MemoryBenchmarkSink += OsCompareMemory(dst, src, size);
+}
+
+/// @summary Insert keys into an OS_HASH_MAP that starts empty and grows as needed.
+internal_function uint64_t
+OsHashMapInsertBench
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    uint64_t const        *keys, 
+    uint64_t const      *probes, 
+    size_t            key_count
+)
+{
+    UNREFERENCED_PARAMETER(probes);
+    OS_HASH_MAP<uint64_t, uint64_t> map;
+    uint64_t                 start_time = OsTimestampInTicks();
+    OsCreateHashMap(&map, arena, 0, OS_HASH_TABLE_FLAGS_NONE);
+    for (size_t i = 0; i < key_count; ++i)
+    {
+        OsHashMapInsert(&map, keys[i], (uint64_t) i);
+    }
+    uint64_t elapsed = OsElapsedNanoseconds(start_time, OsTimestampInTicks());
+    HashBenchmarkSink += map.Count;
+    return elapsed;
+}
+
+/// @summary Insert keys into an OS_HASH_MAP whose capacity is reserved up front.
+internal_function uint64_t
+OsHashMapInsertReservedBench
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    uint64_t const        *keys, 
+    uint64_t const      *probes, 
+    size_t            key_count
+)
+{
+    UNREFERENCED_PARAMETER(probes);
+    OS_HASH_MAP<uint64_t, uint64_t> map;
+    uint64_t                 start_time = OsTimestampInTicks();
+    OsCreateHashMap(&map, arena, key_count, OS_HASH_TABLE_FLAG_FIXED_CAPACITY);
+    for (size_t i = 0; i < key_count; ++i)
+    {
+        OsHashMapInsert(&map, keys[i], (uint64_t) i);
+    }
+    uint64_t elapsed = OsElapsedNanoseconds(start_time, OsTimestampInTicks());
+    HashBenchmarkSink += map.Count;
+    return elapsed;
+}
+
+/// @summary Search an OS_HASH_MAP for a set of keys.
+internal_function uint64_t
+OsHashMapLookupBench
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    uint64_t const        *keys, 
+    uint64_t const      *probes, 
+    size_t            key_count
+)
+{
+    OS_HASH_MAP<uint64_t, uint64_t> map;
+    uint64_t                        sum = 0;
+    OsCreateHashMap(&map, arena, key_count, OS_HASH_TABLE_FLAGS_NONE);
+    for (size_t i = 0; i < key_count; ++i)
+    {
+        OsHashMapInsert(&map, keys[i], (uint64_t) i);
+    }
+    uint64_t start_time = OsTimestampInTicks();
+    for (size_t i = 0; i < key_count; ++i)
+    {
+        uint64_t *value = OsHashMapFind(&map, probes[i]);
+        if (value != NULL)
+            sum += *value;
+    }
+    uint64_t elapsed = OsElapsedNanoseconds(start_time, OsTimestampInTicks());
+    HashBenchmarkSink += sum;
+    return elapsed;
+}
+
+/// @summary Insert keys into a std::unordered_map that starts empty and grows as needed.
+internal_function uint64_t
+StdMapInsertBench
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    uint64_t const        *keys, 
+    uint64_t const      *probes, 
+    size_t            key_count
+)
+{
+    UNREFERENCED_PARAMETER(arena);
+    UNREFERENCED_PARAMETER(probes);
+    std::unordered_map<uint64_t, uint64_t> map;
+    uint64_t                        start_time = OsTimestampInTicks();
+    for (size_t i = 0; i < key_count; ++i)
+    {
+        map[keys[i]] = (uint64_t) i;
+    }
+    uint64_t elapsed = OsElapsedNanoseconds(start_time, OsTimestampInTicks());
+    HashBenchmarkSink += map.size();
+    return elapsed;
+}
+
+/// @summary Insert keys into a std::unordered_map whose bucket count is reserved up front.
+internal_function uint64_t
+StdMapInsertReservedBench
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    uint64_t const        *keys, 
+    uint64_t const      *probes, 
+    size_t            key_count
+)
+{
+    UNREFERENCED_PARAMETER(arena);
+    UNREFERENCED_PARAMETER(probes);
+    std::unordered_map<uint64_t, uint64_t> map;
+    uint64_t                        start_time = OsTimestampInTicks();
+    map.reserve(key_count);
+    for (size_t i = 0; i < key_count; ++i)
+    {
+        map[keys[i]] = (uint64_t) i;
+    }
+    uint64_t elapsed = OsElapsedNanoseconds(start_time, OsTimestampInTicks());
+    HashBenchmarkSink += map.size();
+    return elapsed;
+}
+
+/// @summary Search a std::unordered_map for a set of keys.
+internal_function uint64_t
+StdMapLookupBench
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    uint64_t const        *keys, 
+    uint64_t const      *probes, 
+    size_t            key_count
+)
+{
+    UNREFERENCED_PARAMETER(arena);
+    std::unordered_map<uint64_t, uint64_t> map;
+    uint64_t                               sum = 0;
+    map.reserve(key_count);
+    for (size_t i = 0; i < key_count; ++i)
+    {
+        map[keys[i]] = (uint64_t) i;
+    }
+    uint64_t start_time = OsTimestampInTicks();
+    for (size_t i = 0; i < key_count; ++i)
+    {
+        std::unordered_map<uint64_t, uint64_t>::const_iterator iter = map.find(probes[i]);
+        if (iter != map.end())
+            sum += iter->second;
+    }
+    uint64_t elapsed = OsElapsedNanoseconds(start_time, OsTimestampInTicks());
+    HashBenchmarkSink += sum;
+    return elapsed;
+}
+
+/// @summary Execute a bulk memory benchmark several times on the calling thread and compute summary statistics for the measured runs.
+/// @param result On return, the summary statistics for the benchmark.
+/// @param desc The benchmark to execute.
+/// @param config The warmup and measurement run counts.
+/// @param dst The destination buffer, at least MEMORY_BENCHMARK_BYTES bytes.
+/// @param src The source buffer, at least MEMORY_BENCHMARK_BYTES bytes.
+/// @param samples An array of at least config->MeasuredRuns values used to store the raw samples.
+internal_function void
+RunMemoryBenchmark
+(
+    BENCHMARK_RESULT            *result, 
+    MEMORY_BENCHMARK_DESC const   *desc, 
+    BENCHMARK_CONFIG const      *config, 
+    void                           *dst, 
+    void const                     *src, 
+    uint64_t                   *samples
+)
+{
+    uint32_t   total_runs = config->WarmupRuns + config->MeasuredRuns;
+    size_t     iterations = MEMORY_BENCHMARK_BYTES / desc->Size;
+    uint64_t          sum = 0;
+
+    OsZeroMemory(result, sizeof(BENCHMARK_RESULT));
+    result->Name      = desc->Name;
+    result->ItemCount = (uint32_t) iterations;
+
+    if (desc->InstructionSet != OS_MEMORY_ISA_AUTO && OsSelectMemoryRoutines(desc->InstructionSet, 0) != desc->InstructionSet)
+    {
+        OsLayerError("SKIP: Benchmark \"%S\" requires an instruction set the host does not support.\n", desc->Name);
+        OsSelectMemoryRoutines(OS_MEMORY_ISA_AUTO, 0);
+        result->Skipped = true;
+        return;
+    }
+    // comparisons scan the entire block only when both blocks are identical.
+    memcpy(dst, src, desc->Size);
+
+    for (uint32_t run = 0; run < total_runs; ++run)
+    {
+        uint64_t start_time = OsTimestampInTicks();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            desc->Func(dst, src, desc->Size);
+        }
+        if (run >= config->WarmupRuns)
+        {
+            uint64_t sample = OsElapsedNanoseconds(start_time, OsTimestampInTicks());
+            samples[run - config->WarmupRuns] = sample;
+            sum += sample;
+        }
+    }
+    OsSelectMemoryRoutines(OS_MEMORY_ISA_AUTO, 0);
+
+    SortSamples(samples, config->MeasuredRuns);
+    result->SampleCount = config->MeasuredRuns;
+    result->MinNs       = samples[0];
+    result->MaxNs       = samples[config->MeasuredRuns - 1];
+    result->MeanNs      = sum / config->MeasuredRuns;
+    result->MedianNs    = SamplePercentile(samples, config->MeasuredRuns, 50);
+    result->P99Ns       = SamplePercentile(samples, config->MeasuredRuns, 99);
+    OsLayerError("STATUS: Benchmark \"%S\" median %I64uns p99 %I64uns.\n", desc->Name, result->MedianNs, result->P99Ns);
+}
+
+/// @summary Execute a hash table benchmark several times on the calling thread and compute summary statistics for the measured runs.
+/// @param result On return, the summary statistics for the benchmark.
+/// @param desc The benchmark to execute.
+/// @param config The warmup and measurement run counts.
+/// @param arena The arena used for OS_HASH_MAP storage. The arena is reset to its current position after each run.
+/// @param keys The keys to insert, at least desc->KeyCount items.
+/// @param misses A set of at least desc->KeyCount keys, none of which appear in keys.
+/// @param samples An array of at least config->MeasuredRuns values used to store the raw samples.
+internal_function void
+RunHashBenchmark
+(
+    BENCHMARK_RESULT            *result, 
+    HASH_BENCHMARK_DESC const     *desc, 
+    BENCHMARK_CONFIG const      *config, 
+    OS_HOST_MEMORY_ARENA         *arena, 
+    uint64_t const                *keys, 
+    uint64_t const              *misses, 
+    uint64_t                   *samples
+)
+{
+    uint32_t   total_runs = config->WarmupRuns + config->MeasuredRuns;
+    uint64_t const *probe = desc->Miss ? misses : keys;
+    os_arena_marker_t mark = OsHostMemoryArenaMark(arena);
+    uint64_t          sum  = 0;
+
+    OsZeroMemory(result, sizeof(BENCHMARK_RESULT));
+    result->Name      = desc->Name;
+    result->ItemCount = (uint32_t) desc->KeyCount;
+
+    for (uint32_t run = 0; run < total_runs; ++run)
+    {
+        uint64_t sample = desc->Func(arena, keys, probe, desc->KeyCount);
+        OsHostMemoryArenaResetToMarker(arena, mark);
+        if (run >= config->WarmupRuns)
+        {
+            samples[run - config->WarmupRuns] = sample;
+            sum += sample;
+        }
+    }
+
+    SortSamples(samples, config->MeasuredRuns);
+    result->SampleCount = config->MeasuredRuns;
+    result->MinNs       = samples[0];
+    result->MaxNs       = samples[config->MeasuredRuns - 1];
+    result->MeanNs      = sum / config->MeasuredRuns;
+    result->MedianNs    = SamplePercentile(samples, config->MeasuredRuns, 50);
+    result->P99Ns       = SamplePercentile(samples, config->MeasuredRuns, 99);
+    OsLayerError("STATUS: Benchmark \"%S\" median %I64uns p99 %I64uns.\n", desc->Name, result->MedianNs, result->P99Ns);
+}
+
+/// @summary Write the benchmark results as a JSON document.
+/// @param fp The stream to write to.
+/// @param results The array of benchmark results.
+/// @param result_count The number of items in the results array.
+/// @param config The configuration used to execute the benchmarks.
+/// @param cpu_info Information about the host CPU.
+/// @param worker_count The number of worker threads in the task scheduler.
+internal_function void
+WriteBenchmarkReport
+(
+    FILE                      *fp, 
+    BENCHMARK_RESULT const *results, 
+    size_t             result_count, 
+    BENCHMARK_CONFIG const  *config, 
+    OS_CPU_INFO const     *cpu_info, 
+    size_t             worker_count
+)
+{
+    char const       *isa_names[] = { "sse2", "avx2", "avx512" };
+    OS_MEMORY_ROUTINES memory_isa = {};
+
+    OsQueryMemoryRoutines(&memory_isa);
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"host\": {\"vendor\": \"%s\", \"numa_nodes\": %Iu, \"physical_cores\": %Iu, \"hardware_threads\": %Iu, \"worker_threads\": %Iu, \"memory_isa\": \"%s\", \"streaming_threshold\": %Iu},\n", 
+        cpu_info->VendorName, cpu_info->NumaNodes, cpu_info->PhysicalCores, cpu_info->HardwareThreads, worker_count, isa_names[memory_isa.InstructionSet], memory_isa.StreamingThreshold);
+    fprintf(fp, "  \"config\": {\"warmup_runs\": %u, \"measured_runs\": %u},\n", config->WarmupRuns, config->MeasuredRuns);
+    fprintf(fp, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < result_count; ++i)
+    {
+        BENCHMARK_RESULT const *r = &results[i];
+        char const        *status = r->Skipped ? "skipped" : (r->Failed ? "failed" : "ok");
+        fprintf(fp, "    {\"name\": \"%s\", \"status\": \"%s\", \"unit\": \"ns\", \"items\": %u, \"samples\": %u, \"min\": %" PRIu64 ", \"max\": %" PRIu64 ", \"mean\": %" PRIu64 ", \"median\": %" PRIu64 ", \"p99\": %" PRIu64 "}%s\n", 
+            r->Name, status, r->ItemCount, r->SampleCount, r->MinNs, r->MaxNs, r->MeanNs, r->MedianNs, r->P99Ns, (i + 1 < result_count) ? "," : "");
+    }
+    fprintf(fp, "  ]\n");
+    fprintf(fp, "}\n");
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Implement the entry point of the application.
+/// @param argc The number of arguments passed on the command line.
+/// @param argv An array of @a argc zero-terminated strings specifying the command-line arguments.
+/// @return Zero if the function completes successfully, or non-zero otherwise.
+export_function int 
+main
+(
+    int    argc, 
+    char **argv
+)
+{
+    OS_HOST_MEMORY_POOL               host_pool  = {};  // The pool of host memory allocations used by the application and scheduler.
+    OS_HOST_MEMORY_POOL_INIT     host_pool_init  = {};  // Data used to configure the host memory pool.
+    OS_HOST_MEMORY_ALLOCATION         *main_mem  = NULL;// The host memory allocation used by the main thread.
+    OS_HOST_MEMORY_ARENA             main_arena  = {};  // The memory arena used to store benchmark samples and results.
+    OS_CPU_INFO                        cpu_info  = {};  // Information about the host CPU configuration.
+    OS_TASK_SCHEDULER                 scheduler  = {};  // The task scheduler.
+    OS_TASK_ENVIRONMENT                 rootenv  = {};  // The OS_TASK_ENVIRONMENT for the main thread.
+    size_t const               MAIN_THREAD_POOL  = 0;
+    size_t const                 IO_THREAD_POOL  = 1;
+    size_t const          SCHEDULER_THREAD_POOL  = 2;
+    size_t const                TASK_POOL_COUNT  = 3;
+    OS_TASK_POOL_INIT pool_init[TASK_POOL_COUNT] = {};
+    OS_TASK_SCHEDULER_INIT       scheduler_init  = {};
+    BENCHMARK_CONFIG               bench_config  = {};
+    BENCHMARK_RESULT                   *results  = NULL;
+    uint64_t                           *samples  = NULL;
+    char const                      *report_path = "scheduler_bench.json";
+    bool                             run_tests   = true;
+    bool                             run_bench   = true;
+    bool                             prefault    = false;
+    int                              exit_code   = 0;
+
+    // parse command-line options:
+    // -warmup N   : the number of untimed runs per benchmark (default 5.)
+    // -runs N     : the number of timed runs per benchmark (default 50.)
+    // -json PATH  : the path of the JSON report, or - for stdout (default scheduler_bench.json.)
+    // -notests    : skip the correctness tests.
+    // -nobench    : skip the benchmarks.
+    // -prefault   : populate scheduler global and worker-local memory with physical pages at startup.
+    bench_config.WarmupRuns   = 5;
+    bench_config.MeasuredRuns = 50;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-warmup") && (i + 1) < argc)
+            bench_config.WarmupRuns = (uint32_t) atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-runs") && (i + 1) < argc)
+            bench_config.MeasuredRuns = (uint32_t) atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-json") && (i + 1) < argc)
+            report_path = argv[++i];
+        else if (!strcmp(argv[i], "-notests"))
+            run_tests = false;
+        else if (!strcmp(argv[i], "-nobench"))
+            run_bench = false;
+        else if (!strcmp(argv[i], "-prefault"))
+            prefault = true;
+        else
+            OsLayerError("WARNING: Ignoring unrecognized argument \"%S\".\n", argv[i]);
+    }
+    if (bench_config.MeasuredRuns < 1)
+        bench_config.MeasuredRuns = 1;
+
+    // create the pool of host memory allocations. the scheduler allocates its memory from this pool.
+    host_pool_init.PoolName          = "Main Memory Pool";
+    host_pool_init.PoolCapacity      = 16;
+    host_pool_init.MinAllocationSize = Kilobytes(64);
+    host_pool_init.MinCommitIncrease = Kilobytes(64);
+    if (OsCreateHostMemoryPool(&host_pool, &host_pool_init) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to create host memory pool.\n", __FUNCTION__, OsThreadId());
+        return -1;
+    }
+    if ((main_mem = OsHostMemoryPoolAllocate(&host_pool, Megabytes(4), Megabytes(4), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to allocate main thread memory.\n", __FUNCTION__, OsThreadId());
+        OsDeleteHostMemoryPool(&host_pool);
+        return -1;
+    }
+    if (!OsQueryHostCpuLayout(&cpu_info, OsInitHostMemoryRange(main_mem)))
+    {
+        OsLayerError("ERROR: %S(%u): Unable to query host CPU layout.\n", __FUNCTION__, OsThreadId());
+        OsDeleteHostMemoryPool(&host_pool);
+        return -1;
+    }
+    // the CPU query is finished with the scratch memory; reuse it for the main arena.
+    if (OsCreateHostMemoryArena(&main_arena, OsInitHostMemoryRange(main_mem)) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to initialize main memory arena.\n", __FUNCTION__, OsThreadId());
+        OsDeleteHostMemoryPool(&host_pool);
+        return -1;
+    }
+
+    // create three types of task pools - one for the main thread, one for I/O workers, and one for scheduler workers.
+    // the main thread can define, but not ever run tasks. it creates very few tasks.
+    // the I/O threads can define, but not ever run tasks. they create very few tasks.
+    // the scheduler worker threads can define and execute tasks. they may create many tasks.
+    pool_init[MAIN_THREAD_POOL].PoolId               = MAIN_THREAD_POOL;
+    pool_init[MAIN_THREAD_POOL].PoolUsage            = OS_TASK_POOL_USAGE_FLAG_DEFINE | OS_TASK_POOL_USAGE_FLAG_PUBLISH;
+    pool_init[MAIN_THREAD_POOL].PoolCount            = 1;
+    pool_init[MAIN_THREAD_POOL].MaxIoRequests        = 0;
+    pool_init[MAIN_THREAD_POOL].MaxActiveTasks       = 64;
+    pool_init[MAIN_THREAD_POOL].LocalMemorySize      = 0;
+
+    pool_init[IO_THREAD_POOL].PoolId                 = IO_THREAD_POOL;
+    pool_init[IO_THREAD_POOL].PoolUsage              = OS_TASK_POOL_USAGE_FLAG_DEFINE | OS_TASK_POOL_USAGE_FLAG_PUBLISH;
+    pool_init[IO_THREAD_POOL].PoolCount              = cpu_info.PhysicalCores;
+    pool_init[IO_THREAD_POOL].MaxIoRequests          = 0;
+    pool_init[IO_THREAD_POOL].MaxActiveTasks         = OS_MIN_TASKS_PER_POOL;
+    pool_init[IO_THREAD_POOL].LocalMemorySize        = 0;
+
+    pool_init[SCHEDULER_THREAD_POOL].PoolId          = SCHEDULER_THREAD_POOL;
+    pool_init[SCHEDULER_THREAD_POOL].PoolUsage       = OS_TASK_POOL_USAGE_FLAG_DEFINE | OS_TASK_POOL_USAGE_FLAG_EXECUTE | OS_TASK_POOL_USAGE_FLAG_PUBLISH | OS_TASK_POOL_USAGE_FLAG_WORKER;
+    pool_init[SCHEDULER_THREAD_POOL].PoolCount       = cpu_info.HardwareThreads;
+    pool_init[SCHEDULER_THREAD_POOL].MaxIoRequests   = 512;
+    pool_init[SCHEDULER_THREAD_POOL].MaxActiveTasks  = OS_MAX_TASKS_PER_POOL;
+    pool_init[SCHEDULER_THREAD_POOL].LocalMemorySize = Megabytes(32);
+
+    // the task scheduler will create and manage its own pool of worker threads.
+    scheduler_init.SchedulerMemoryPool = &host_pool;
+    scheduler_init.WorkerThreadCount   = cpu_info.HardwareThreads;
+    scheduler_init.GlobalMemorySize    = Megabytes(256);
+    scheduler_init.PoolTypeCount       = TASK_POOL_COUNT;
+    scheduler_init.TaskPoolTypes       = pool_init;
+    scheduler_init.IoThreadPool        = NULL;
+    scheduler_init.TaskContextData     = 0;
+    scheduler_init.PrefaultMemory      = prefault;
+    if (OsCreateTaskScheduler(&scheduler, &scheduler_init, "Task Scheduler") < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to initialize task scheduler.\n", __FUNCTION__, OsThreadId());
+        OsDeleteHostMemoryPool(&host_pool);
+        return -1;
+    }
+    if (OsAllocateTaskPool(&rootenv, &scheduler, MAIN_THREAD_POOL, OsThreadId()) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to allocate main thread task pool.\n", __FUNCTION__, OsThreadId());
+        OsDestroyTaskScheduler(&scheduler);
+        OsDeleteHostMemoryPool(&host_pool);
+        return -1;
+    }
+
+    if (run_tests)
+    {
+        if (!ParallelTest("EmptyTest", &rootenv, EmptyTest, EmptyInit, EmptyShutdown))
+            exit_code = 1;
+        if (!ParallelTest("EmptyChildTest", &rootenv, EmptyChildTest, EmptyChildTestInit, EmptyChildTestShutdown))
+            exit_code = 1;
+        for (size_t i = 0, n = sizeof(AllocatorStressTests) / sizeof(AllocatorStressTests[0]); i < n; ++i)
+        {
+            char test_name[64];
+            snprintf(test_name, sizeof(test_name), "%sStressTest", AllocatorStressTests[i]->Name);
+            if (!ParallelTest(test_name, &rootenv, AllocatorStressTest, AllocatorStressTestInit, AllocatorStressTestShutdown, (uintptr_t) AllocatorStressTests[i]))
+                exit_code = 1;
+        }
+        if (!ParallelTest("HashTableTest", &rootenv, HashTableTest, HashTableTestInit, HashTableTestShutdown))
+            exit_code = 1;
+        if (!ParallelTest("ArenaSnapshotTest", &rootenv, ArenaSnapshotTest, ArenaSnapshotTestInit, ArenaSnapshotTestShutdown))
+            exit_code = 1;
+        if (!ParallelTest("AffineTaskTest", &rootenv, AffineTaskTest, AffineTaskTestInit, AffineTaskTestShutdown, IO_THREAD_POOL))
+            exit_code = 1;
+        if (!WorkerScalingParallelTest(&rootenv))
+            exit_code = 1;
+    }
+
+    if (run_bench)
+    {
+        uint32_t const      FIB_DEPTH = 20;
+        uint32_t const     FIB_LEAVES = FibLeafCount(FIB_DEPTH);
+        BENCHMARK_DESC   benchmarks[] = 
+        {   // Name                RootTask                 Param      ExpectCount  ItemCount            IdleMs  MinWorkers  MeasureLatency
+            { "SpawnThroughput"  , SpawnThroughputBench   , 32768    , 32768      , 32768              , 0     , 1         , false },
+            { "FanOutFanIn"      , FanOutFanInBench       , 32768    , 32768      , 32768              , 0     , 1         , false },
+            { "DependencyChain"  , DependencyChainBench   , 4096     , 4096       , 4096               , 0     , 1         , false },
+            { "RecursiveFib"     , RecursiveFibBench      , FIB_DEPTH, FIB_LEAVES , 2 * FIB_LEAVES - 1 , 0     , 1         , false },
+            { "StealLatency"     , StealLatencyBench      , 0        , 0          , 1                  , 0     , 2         , true  },
+            { "WakeFromIdle"     , WakeLatencyBench       , 0        , 0          , 1                  , 5     , 1         , true  },
+            { "MixedInterference", MixedInterferenceBench , 16       , 16         , 16                 , 0     , 1         , true  },
+        };
+        MEMORY_BENCHMARK_DESC membench[] = 
+        {   // Name                      Func             Size             InstructionSet
+            { "memcpy/64"              , CrtCopyBench   , 64             , OS_MEMORY_ISA_AUTO   },
+            { "OsCopyMemory/64"        , OsCopyBench    , 64             , OS_MEMORY_ISA_AUTO   },
+            { "memcpy/4K"              , CrtCopyBench   , Kilobytes(4)   , OS_MEMORY_ISA_AUTO   },
+            { "OsCopyMemory/4K"        , OsCopyBench    , Kilobytes(4)   , OS_MEMORY_ISA_AUTO   },
+            { "memcpy/256K"            , CrtCopyBench   , Kilobytes(256) , OS_MEMORY_ISA_AUTO   },
+            { "OsCopyMemory/256K"      , OsCopyBench    , Kilobytes(256) , OS_MEMORY_ISA_AUTO   },
+            { "memcpy/64M"             , CrtCopyBench   , Megabytes(64)  , OS_MEMORY_ISA_AUTO   },
+            { "OsCopyMemory/64M"       , OsCopyBench    , Megabytes(64)  , OS_MEMORY_ISA_AUTO   },
+            { "OsCopyMemory.sse2/4K"   , OsCopyBench    , Kilobytes(4)   , OS_MEMORY_ISA_SSE2   },
+            { "OsCopyMemory.avx2/4K"   , OsCopyBench    , Kilobytes(4)   , OS_MEMORY_ISA_AVX2   },
+            { "OsCopyMemory.avx512/4K" , OsCopyBench    , Kilobytes(4)   , OS_MEMORY_ISA_AVX512 },
+            { "OsCopyMemory.sse2/64M"  , OsCopyBench    , Megabytes(64)  , OS_MEMORY_ISA_SSE2   },
+            { "OsCopyMemory.avx2/64M"  , OsCopyBench    , Megabytes(64)  , OS_MEMORY_ISA_AVX2   },
+            { "OsCopyMemory.avx512/64M", OsCopyBench    , Megabytes(64)  , OS_MEMORY_ISA_AVX512 },
+            { "memset/64"              , CrtFillBench   , 64             , OS_MEMORY_ISA_AUTO   },
+            { "OsFillMemory/64"        , OsFillBench    , 64             , OS_MEMORY_ISA_AUTO   },
+            { "memset/4K"              , CrtFillBench   , Kilobytes(4)   , OS_MEMORY_ISA_AUTO   },
+            { "OsFillMemory/4K"        , OsFillBench    , Kilobytes(4)   , OS_MEMORY_ISA_AUTO   },
+            { "memset/256K"            , CrtFillBench   , Kilobytes(256) , OS_MEMORY_ISA_AUTO   },
+            { "OsFillMemory/256K"      , OsFillBench    , Kilobytes(256) , OS_MEMORY_ISA_AUTO   },
+            { "memset/64M"             , CrtFillBench   , Megabytes(64)  , OS_MEMORY_ISA_AUTO   },
+            { "OsFillMemory/64M"       , OsFillBench    , Megabytes(64)  , OS_MEMORY_ISA_AUTO   },
+            { "memcmp/64"              , CrtCompareBench, 64             , OS_MEMORY_ISA_AUTO   },
+            { "OsCompareMemory/64"     , OsCompareBench , 64             , OS_MEMORY_ISA_AUTO   },
+            { "memcmp/4K"              , CrtCompareBench, Kilobytes(4)   , OS_MEMORY_ISA_AUTO   },
+            { "OsCompareMemory/4K"     , OsCompareBench , Kilobytes(4)   , OS_MEMORY_ISA_AUTO   },
+            { "memcmp/256K"            , CrtCompareBench, Kilobytes(256) , OS_MEMORY_ISA_AUTO   },
+            { "OsCompareMemory/256K"   , OsCompareBench , Kilobytes(256) , OS_MEMORY_ISA_AUTO   },
+            { "memcmp/64M"             , CrtCompareBench, Megabytes(64)  , OS_MEMORY_ISA_AUTO   },
+            { "OsCompareMemory/64M"    , OsCompareBench , Megabytes(64)  , OS_MEMORY_ISA_AUTO   },
+        };
+        HASH_BENCHMARK_DESC hashbench[] = 
+        {   // Name                                 Func                          KeyCount         Miss
+            { "OsHashMap.insert/1K"               , OsHashMapInsertBench        , Kilobytes(1)   , false },
+            { "unordered_map.insert/1K"           , StdMapInsertBench           , Kilobytes(1)   , false },
+            { "OsHashMap.insert_reserved/1K"      , OsHashMapInsertReservedBench, Kilobytes(1)   , false },
+            { "unordered_map.insert_reserved/1K"  , StdMapInsertReservedBench   , Kilobytes(1)   , false },
+            { "OsHashMap.find_hit/1K"             , OsHashMapLookupBench        , Kilobytes(1)   , false },
+            { "unordered_map.find_hit/1K"         , StdMapLookupBench           , Kilobytes(1)   , false },
+            { "OsHashMap.find_miss/1K"            , OsHashMapLookupBench        , Kilobytes(1)   , true  },
+            { "unordered_map.find_miss/1K"        , StdMapLookupBench           , Kilobytes(1)   , true  },
+            { "OsHashMap.insert/64K"              , OsHashMapInsertBench        , Kilobytes(64)  , false },
+            { "unordered_map.insert/64K"          , StdMapInsertBench           , Kilobytes(64)  , false },
+            { "OsHashMap.insert_reserved/64K"     , OsHashMapInsertReservedBench, Kilobytes(64)  , false },
+            { "unordered_map.insert_reserved/64K" , StdMapInsertReservedBench   , Kilobytes(64)  , false },
+            { "OsHashMap.find_hit/64K"            , OsHashMapLookupBench        , Kilobytes(64)  , false },
+            { "unordered_map.find_hit/64K"        , StdMapLookupBench           , Kilobytes(64)  , false },
+            { "OsHashMap.find_miss/64K"           , OsHashMapLookupBench        , Kilobytes(64)  , true  },
+            { "unordered_map.find_miss/64K"       , StdMapLookupBench           , Kilobytes(64)  , true  },
+            { "OsHashMap.insert/256K"             , OsHashMapInsertBench        , Kilobytes(256) , false },
+            { "unordered_map.insert/256K"         , StdMapInsertBench           , Kilobytes(256) , false },
+            { "OsHashMap.insert_reserved/256K"    , OsHashMapInsertReservedBench, Kilobytes(256) , false },
+            { "unordered_map.insert_reserved/256K", StdMapInsertReservedBench   , Kilobytes(256) , false },
+            { "OsHashMap.find_hit/256K"           , OsHashMapLookupBench        , Kilobytes(256) , false },
+            { "unordered_map.find_hit/256K"       , StdMapLookupBench           , Kilobytes(256) , false },
+            { "OsHashMap.find_miss/256K"          , OsHashMapLookupBench        , Kilobytes(256) , true  },
+            { "unordered_map.find_miss/256K"      , StdMapLookupBench           , Kilobytes(256) , true  },
+        };
+        size_t const bench_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+        size_t const alloc_tasks = sizeof(ALLOCATOR_SCALING_TASKS) / sizeof(ALLOCATOR_SCALING_TASKS[0]);
+        size_t const alloc_count = alloc_tasks * (sizeof(AllocatorStressTests) / sizeof(AllocatorStressTests[0]));
+        size_t const   mem_count = sizeof(membench) / sizeof(membench[0]);
+        size_t const  hash_count = sizeof(hashbench) / sizeof(hashbench[0]);
+        size_t const  max_keys   = Kilobytes(256);
+        OS_HOST_MEMORY_ALLOCATION *mem_buffers = NULL;
+        OS_HOST_MEMORY_ALLOCATION    *hash_mem = NULL;
+        OS_HOST_MEMORY_ALLOCATION   *alloc_mem = NULL;
+        BENCHMARK_DESC             *allocbench = NULL;
+        char                      *alloc_names = NULL;
+        OS_HOST_MEMORY_ARENA        hash_arena = {};
+        uint8_t                         *mem_src = NULL;
+        uint8_t                         *mem_dst = NULL;
+        uint64_t                      *hash_keys = NULL;
+        uint64_t                    *hash_misses = NULL;
+        uint64_t                       key_state = 0x9E3779B97F4A7C15ULL;
+        FILE               *fp   = NULL;
+
+        results = OsHostMemoryArenaAllocateArray<BENCHMARK_RESULT>(&main_arena, bench_count + alloc_count + mem_count + hash_count);
+        samples = OsHostMemoryArenaAllocateArray<uint64_t>(&main_arena, bench_config.MeasuredRuns);
+        if (results == NULL || samples == NULL)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to allocate benchmark sample storage for %u runs.\n", __FUNCTION__, OsThreadId(), bench_config.MeasuredRuns);
+            exit_code = 1;
+            goto cleanup;
+        }
+
+        // the allocator benchmarks share one set of allocators, so that the per-pool caches stay warm across runs.
+        // each allocator benchmark runs the stress workload of one allocator on one of the ALLOCATOR_SCALING_TASKS task counts.
+        if ((alloc_mem = OsHostMemoryPoolAllocate(&host_pool, AllocatorTestMemorySize(scheduler.TaskPoolCount), AllocatorTestMemorySize(scheduler.TaskPoolCount), OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) == NULL || 
+            (bench_config.Allocators = OsHostMemoryArenaAllocate<ALLOCATOR_TEST_STATE>(&main_arena)) == NULL || 
+            (allocbench  = OsHostMemoryArenaAllocateArray<BENCHMARK_DESC>(&main_arena, alloc_count)) == NULL || 
+            (alloc_names = OsHostMemoryArenaAllocateArray<char>(&main_arena, alloc_count * 32)) == NULL || 
+             CreateAllocatorTestState(bench_config.Allocators, alloc_mem->BaseAddress, scheduler.TaskPoolCount) < 0)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to create the allocator benchmark state.\n", __FUNCTION__, OsThreadId());
+            exit_code = 1;
+            goto cleanup;
+        }
+        bench_config.Allocators->StampBlocks = false;
+        for (size_t i = 0; i < alloc_count; ++i)
+        {
+            ALLOCATOR_STRESS_DESC const *alloc = AllocatorStressTests[i / alloc_tasks];
+            uint32_t                     tasks = ALLOCATOR_SCALING_TASKS[i % alloc_tasks];
+            snprintf(alloc_names + (i * 32), 32, "%sScaling/%u", alloc->Name, tasks);
+            allocbench[i].Name           = alloc_names + (i * 32);
+            allocbench[i].RootTask       = AllocatorScalingBench;
+            allocbench[i].Param          = tasks;
+            allocbench[i].ExpectCount    = tasks;
+            allocbench[i].ItemCount      = tasks;
+            allocbench[i].IdleMs         = 0;
+            allocbench[i].MinWorkers     = tasks;
+            allocbench[i].MeasureLatency = false;
+            allocbench[i].Allocator      = alloc;
+        }
+        for (size_t i = 0; i < bench_count; ++i)
+        {
+            if (!RunBenchmark(&results[i], &benchmarks[i], &bench_config, &rootenv, samples))
+                exit_code = 1;
+        }
+        for (size_t i = 0; i < alloc_count; ++i)
+        {
+            if (!RunBenchmark(&results[bench_count + i], &allocbench[i], &bench_config, &rootenv, samples))
+                exit_code = 1;
+            if ((i % alloc_tasks) == (alloc_tasks - 1) && !FinishAllocatorStress(allocbench[i].Allocator, bench_config.Allocators))
+            {   // the handoff slots are drained before the next allocator is measured.
+                results[bench_count + i].Failed = true;
+                exit_code = 1;
+            }
+        }
+        DeleteAllocatorTestState(bench_config.Allocators);
+        OsHostMemoryPoolRelease(&host_pool, alloc_mem);
+
+        // the bulk memory benchmarks run on the main thread while the workers are idle.
+        if ((mem_buffers = OsHostMemoryPoolAllocate(&host_pool, 2 * MEMORY_BENCHMARK_BYTES, 2 * MEMORY_BENCHMARK_BYTES, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) == NULL)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to allocate memory benchmark buffers.\n", __FUNCTION__, OsThreadId());
+            exit_code = 1;
+            goto cleanup;
+        }
+        mem_src = mem_buffers->BaseAddress;
+        mem_dst = mem_buffers->BaseAddress + MEMORY_BENCHMARK_BYTES;
+        for (size_t i = 0; i < MEMORY_BENCHMARK_BYTES; ++i)
+        {   // write both buffers so that no benchmark measures page faults.
+            mem_src[i] = (uint8_t) (i * 31);
+            mem_dst[i] = (uint8_t) (i * 31);
+        }
+        for (size_t i = 0; i < mem_count; ++i)
+        {
+            RunMemoryBenchmark(&results[bench_count + alloc_count + i], &membench[i], &bench_config, mem_dst, mem_src, samples);
+        }
+        OsHostMemoryPoolRelease(&host_pool, mem_buffers);
+
+        // the hash table benchmarks also run on the main thread. the key arrays sit at the start of the arena, and each run resets the arena past them.
+        if ((hash_mem = OsHostMemoryPoolAllocate(&host_pool, HASH_BENCHMARK_BYTES, HASH_BENCHMARK_BYTES, OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)) == NULL || 
+             OsCreateHostMemoryArena(&hash_arena, OsInitHostMemoryRange(hash_mem)) < 0)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to allocate hash table benchmark memory.\n", __FUNCTION__, OsThreadId());
+            exit_code = 1;
+            goto cleanup;
+        }
+        hash_keys   = OsHostMemoryArenaAllocateArray<uint64_t>(&hash_arena, max_keys);
+        hash_misses = OsHostMemoryArenaAllocateArray<uint64_t>(&hash_arena, max_keys);
+        for (size_t i = 0; i < max_keys; ++i)
+        {   // xorshift64 keys; the low bit separates the inserted keys from the keys that are never inserted.
+            key_state ^= key_state << 13;
+            key_state ^= key_state >>  7;
+            key_state ^= key_state << 17;
+            hash_keys  [i] = key_state & ~1ULL;
+            hash_misses[i] = key_state |  1ULL;
+        }
+        for (size_t i = 0; i < hash_count; ++i)
+        {
+            RunHashBenchmark(&results[bench_count + alloc_count + mem_count + i], &hashbench[i], &bench_config, &hash_arena, hash_keys, hash_misses, samples);
+        }
+        OsHostMemoryPoolRelease(&host_pool, hash_mem);
+        if (!strcmp(report_path, "-"))
+        {
+            fp = stdout;
+        }
+        else if (fopen_s(&fp, report_path, "w") != 0 || fp == NULL)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to open benchmark report \"%S\" for writing.\n", __FUNCTION__, OsThreadId(), report_path);
+            exit_code = 1;
+            goto cleanup;
+        }
+        WriteBenchmarkReport(fp, results, bench_count + alloc_count + mem_count + hash_count, &bench_config, &cpu_info, scheduler.WorkerThreadCount);
+        if (fp != stdout)
+        {
+            fclose(fp);
+        }
+    }
+
+cleanup:
+    // shut down the task scheduler and kill all worker threads.
+    OsDestroyTaskScheduler(&scheduler);
+
+    // clean up everything else.
+    OsDeleteHostMemoryPool(&host_pool);
+    return exit_code;
+}
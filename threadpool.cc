@@ -92,6 +92,7 @@ main
     OS_THREAD_POOL           pool = {};  // The worker thread pool.
     OS_THREAD_POOL_INIT pool_init = {};  // Data used to configure the thread pool.
     TASK_DATA          *task_data = NULL;
+    uintptr_t          *work_list = NULL;
     std::atomic<uint32_t>   ndone = 0;
 
     UNREFERENCED_PARAMETER(argc);
@@ -113,11 +114,17 @@ main
         OsLayerError("ERROR: %S(%u): Unable to allocate TASK_DATA array.\n", __FUNCTION__, GetCurrentThreadId());
         return -1;
     }
+    if ((work_list = OsMemoryArenaAllocateArray<uintptr_t>(&arena, 100)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to allocate work item list.\n", __FUNCTION__, GetCurrentThreadId());
+        return -1;
+    }
 
     // initialize the TASK_DATA items to execute for a small, but random number of milliseconds.
     for (size_t i = 0; i < 100; ++i)
     {
         task_data[i].WorkTime = (rand() % 30) + 1;
+        work_list[i] = (uintptr_t) &task_data[i];
     }
 
     // create the thread pool used to execute the tasks.
@@ -127,6 +134,7 @@ main
     pool_init.ThreadCount = 2;      // specify the number of worker threads.
     pool_init.StackSize   = OS_WORKER_THREAD_STACK_DEFAULT;
     pool_init.ArenaSize   = Megabytes(4);
+    pool_init.QueueCapacity = OS_WORKER_QUEUE_CAPACITY_DEFAULT;
     pool_init.NUMAGroup   = 0;
     if (OsCreateThreadPool(&pool, &pool_init, &arena, "Worker Pool") < 0)
     {
@@ -138,10 +146,13 @@ main
     // launch all threads in the pool and have them start waiting for work.
     OsLaunchThreadPool(&pool);
 
-    // submit all work items. worker threads will increment ndone when they complete an item.
-    for (size_t i = 0; i < 100; ++i)
+    // submit all work items as a single batch. the items are spread across the worker queues, 
+    // and only idle workers are woken. worker threads will increment ndone when they complete an item.
+    if (!OsSubmitWorkItems(&pool, work_list, 100))
     {
-        OsSignalWorkerThreads(&pool, (uintptr_t) &task_data[i], 1);
+        OsLayerError("ERROR: %S(%u): Unable to submit work items.\n", __FUNCTION__, GetCurrentThreadId());
+        OsDestroyThreadPool(&pool);
+        return -1;
     }
 
     // busy-wait for all work items to complete.
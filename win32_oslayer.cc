@@ -35,10 +35,14 @@
 ////////////////////*/
 /// @summary Define static/dynamic library import/export for the compiler.
 #ifndef library_function
-    #if   defined(BUILD_DYNAMIC)
+    #if   defined(BUILD_DYNAMIC) && defined(__GNUC__)
+        #define library_function                     __attribute__((visibility("default")))
+    #elif defined(BUILD_DYNAMIC)
         #define library_function                     __declspec(dllexport)
     #elif defined(BUILD_STATIC)
         #define library_function
+    #elif defined(__GNUC__)
+        #define library_function                     __attribute__((visibility("default")))
     #else
         #define library_function                     __declspec(dllimport)
     #endif
@@ -82,10 +86,44 @@
 
 /// @summary Define macros for controlling compiler inlining.
 #ifndef never_inline
-    #define never_inline                            __declspec(noinline)
+    #if defined(__GNUC__)
+        #define never_inline                        __attribute__((noinline))
+    #else
+        #define never_inline                        __declspec(noinline)
+    #endif
 #endif
 #ifndef force_inline
-    #define force_inline                            __forceinline
+    #if defined(__GNUC__)
+        #define force_inline                        inline __attribute__((always_inline))
+    #else
+        #define force_inline                        __forceinline
+    #endif
+#endif
+
+/// @summary Define macros used to compile a single function for an instruction set extension that may not be available on every host.
+/// MSVC allows intrinsics for any instruction set to be used in any function; GCC and Clang require the target to be enabled per-function.
+#ifndef OS_TARGET_AVX2
+    #if defined(__GNUC__)
+        #define OS_TARGET_AVX2                      __attribute__((target("avx2")))
+    #else
+        #define OS_TARGET_AVX2
+    #endif
+#endif
+#ifndef OS_TARGET_AVX512
+    #if defined(__GNUC__)
+        #define OS_TARGET_AVX512                    __attribute__((target("avx512f,avx512bw")))
+    #else
+        #define OS_TARGET_AVX512
+    #endif
+#endif
+
+/// @summary Define a macro to retrieve the address the current function will return to.
+#ifndef OS_RETURN_ADDRESS
+    #if defined(__GNUC__)
+        #define OS_RETURN_ADDRESS()                 __builtin_return_address(0)
+    #else
+        #define OS_RETURN_ADDRESS()                 _ReturnAddress()
+    #endif
 #endif
 
 /// @summary Define the size of a single cacheline on the target architecture.
@@ -95,7 +133,11 @@
 
 /// @summary Define a macro to align a type or field to a cacheline boundary.
 #ifndef OS_CACHELINE_ALIGN
-    #define OS_CACHELINE_ALIGN                      __declspec(align(OS_CACHELINE_SIZE))
+    #if defined(__GNUC__)
+        #define OS_CACHELINE_ALIGN                  alignas(OS_CACHELINE_SIZE)
+    #else
+        #define OS_CACHELINE_ALIGN                  __declspec(align(OS_CACHELINE_SIZE))
+    #endif
 #endif
 
 /// @summary Define the value indicating an unused device handle.
@@ -127,6 +169,8 @@
 #ifndef OS_TASK_SCHEDULER_CONSTANTS
     #define OS_TASK_SCHEDULER_CONSTANTS
     #define OS_INVALID_TASK_ID                      0x7FFFFFFFL
+    #define OS_TASK_MAILBOX_CLOSED                  0x7FFFFFFEL
+    #define OS_TASK_POOL_INDEX_ANY                  0xFFFFFFFFUL
     #define OS_MIN_TASK_POOLS                       1
     #define OS_MAX_TASK_POOLS                       4096
     #define OS_MIN_TASKS_PER_POOL                   2
@@ -142,20 +186,25 @@
 #endif
 
 /// @summary Helper macro to write a message to stdout.
+/// On Linux, format strings written with the MSVC conversion specifiers (%S, %Iu, %I64u) are translated by OsLayerPrint.
 #ifndef OsLayerOutput
-    #ifndef OS_LAYER_NO_OUTPUT
-        #define OsLayerOutput(fmt_str, ...)         _ftprintf(stdout, _T(fmt_str), __VA_ARGS__)
-    #else
+    #if   defined(OS_LAYER_NO_OUTPUT)
         #define OsLayerOutput(fmt_str, ...)         
+    #elif defined(__linux__)
+        #define OsLayerOutput(fmt_str, ...)         OsLayerPrint(stdout, fmt_str, ##__VA_ARGS__)
+    #else
+        #define OsLayerOutput(fmt_str, ...)         _ftprintf(stdout, _T(fmt_str), __VA_ARGS__)
     #endif
 #endif
 
 /// @summary Helper macro to write a message to stderr.
 #ifndef OsLayerError
-    #ifndef OS_LAYER_NO_OUTPUT
-        #define OsLayerError(fmt_str, ...)          _ftprintf(stderr, _T(fmt_str), __VA_ARGS__)
-    #else
+    #if   defined(OS_LAYER_NO_OUTPUT)
         #define OsLayerError(fmt_str, ...)          
+    #elif defined(__linux__)
+        #define OsLayerError(fmt_str, ...)          OsLayerPrint(stderr, fmt_str, ##__VA_ARGS__)
+    #else
+        #define OsLayerError(fmt_str, ...)          _ftprintf(stderr, _T(fmt_str), __VA_ARGS__)
     #endif
 #endif
 
@@ -337,7 +386,40 @@
     #include <stdarg.h>
     #include <assert.h>
     #include <inttypes.h>
-
+    #include <limits.h>
+    #include <immintrin.h>
+
+#if defined(__linux__)
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <time.h>
+    #include <sched.h>
+    #include <pthread.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <cpuid.h>
+    #ifndef UNREFERENCED_PARAMETER
+        #define UNREFERENCED_PARAMETER(x)   ((void)(x))
+    #endif
+    #ifndef MFD_CLOEXEC
+        #define MFD_CLOEXEC            0x0001U
+    #endif
+    #ifndef MADV_POPULATE_WRITE
+        #define MADV_POPULATE_WRITE    23
+    #endif
+    #ifndef MPOL_DEFAULT
+        #define MPOL_DEFAULT            0
+        #define MPOL_BIND               2
+        #define MPOL_INTERLEAVE         3
+        #define MPOL_F_NODE            (1 << 0)
+        #define MPOL_F_ADDR            (1 << 1)
+        #define MPOL_F_MEMS_ALLOWED    (1 << 2)
+    #endif
+#else
     #include <process.h>
     #include <conio.h>
     #include <fcntl.h>
@@ -345,6 +427,7 @@
 
     #include <tchar.h>
     #include <Windows.h>
+    #include <Psapi.h>
     #include <Shlobj.h>
     #include <Shellapi.h>
     #include <strsafe.h>
@@ -358,13 +441,15 @@
     #include <vulkan/vulkan.h>
 
     #include "cvmarkers.h"
-#endif
+#endif /* defined(__linux__) */
+#endif /* !defined(OS_LAYER_NO_INCLUDES) */
 
 /*//////////////////
 //   Data Types   //
 //////////////////*/
 /// @summary Forward-declare several public types.
 struct OS_CPU_INFO;
+struct OS_MEMORY_ROUTINES;
 
 struct OS_HOST_MEMORY_POOL;
 struct OS_HOST_MEMORY_POOL_INIT;
@@ -373,16 +458,46 @@ struct OS_HOST_MEMORY_ALLOCATION;
 struct OS_MEMORY_RANGE;
 struct OS_ARENA_ALLOCATOR;
 struct OS_BUDDY_BLOCK_INFO;
+struct OS_BUDDY_COMPACT_RESULT;
+struct OS_BUDDY_BITSET;
 struct OS_BUDDY_ALLOCATOR;
+struct OS_BUDDY_THREAD_CACHE;
+struct OS_BUDDY_LEVEL_DEPOT;
+struct OS_CONCURRENT_BUDDY_ALLOCATOR;
+struct OS_TLSF_BLOCK_HEADER;
+struct OS_TLSF_ALLOCATOR;
 struct OS_HOST_MEMORY_ARENA;
+struct OS_FRAME_ARENA_GENERATION;
+struct OS_FRAME_ARENA;
+struct OS_CHAINED_ARENA_BLOCK;
+struct OS_CHAINED_ARENA;
+struct OS_CONCURRENT_ARENA;
+struct OS_CONCURRENT_ARENA_CHUNK;
 struct OS_HOST_MEMORY_ALLOCATOR;
+struct OS_ALLOCATOR_STATS;
+struct OS_ALLOCATION_TRACE_RECORD;
+struct OS_ALLOCATION_TRACE_SLOT;
+struct OS_ALLOCATION_TRACE;
+struct OS_MEMORY_PRESSURE_CALLBACK;
+struct OS_MEMORY_BUDGET;
+struct OS_MEMORY_BUDGET_INIT;
+struct OS_MEMORY_BUDGET_STATUS;
+struct OS_MAGIC_RING_BUFFER;
+struct OS_SLAB_SIZE_CLASS;
+struct OS_SLAB_THREAD_CACHE;
+struct OS_SLAB_ALLOCATOR;
+struct OS_SLAB_ALLOCATOR_INIT;
 
 struct OS_WORKER_THREAD;
+struct OS_WORKER_QUEUE;
+struct OS_WORKER_QUEUE_CELL;
 struct OS_THREAD_POOL;
 struct OS_THREAD_POOL_INIT;
 
 struct OS_FILE_DATA;
 struct OS_FILE_MAPPING;
+struct OS_ARENA_SNAPSHOT_HEADER;
+struct OS_ARENA_SNAPSHOT;
 struct OS_PATH_PARTS;
 
 struct OS_IO_OPERATION;
@@ -405,6 +520,8 @@ struct OS_TASK_POOL_INIT;
 struct OS_TASK_ENVIRONMENT;
 struct OS_TASK_SCHEDULER;
 struct OS_TASK_SCHEDULER_INIT;
+struct OS_TASK_SCHEDULER_SCALING_POLICY;
+struct OS_TASK_WORKER_STATS;
 struct OS_TASK_PROFILER;
 struct OS_TASK_PROFILER_SPAN;
 struct OS_TASK_FENCE;
@@ -422,18 +539,41 @@ struct OS_AUDIO_DEVICE_LIST;
 struct OS_AUDIO_OUTPUT_DEVICE;
 struct OS_AUDIO_CAPTURE_DEVICE;
 
+/// @summary Define the lock type used by the memory subsystem. The lock is recursive on all platforms, matching CRITICAL_SECTION.
+#if defined(__linux__)
+typedef pthread_mutex_t                OS_MUTEX;
+#else
+typedef CRITICAL_SECTION               OS_MUTEX;
+#endif
+
 /// @summary Represents a pool of pre-allocated OS_HOST_MEMORY_ALLOCATION instances.
-/// Typically each thread maintains its own OS_HOST_MEMORY_POOL from which it alone acquires and releases allocations.
+/// Any number of threads may acquire and release allocations concurrently. The free list is a lock-free stack of node indices, 
+/// with the head tagged by an update counter to prevent ABA. OsCreateHostMemoryPool, OsDeleteHostMemoryPool and OsHostMemoryPoolReset
+/// must not be called while other threads are using the pool.
 struct OS_HOST_MEMORY_POOL
-{
+{   typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer value that can be read and written atomically.
+    typedef std::atomic<uint64_t>      atomic_u64_t; /// An unsigned 64-bit integer value that can be read and written atomically.
     char const                *Name;                 /// A nul-terminated string specifying the name of the pool. This value is used for debugging purposes only.
-    OS_HOST_MEMORY_ALLOCATION *FreeList;             /// The first free OS_HOST_MEMORY_ALLOCATION instance.
+    atomic_u64_t               FreeHead;             /// The head of the free list. Bits 0-31 store one plus the index of the first free node, or zero if the list is empty. Bits 32-63 store the update tag.
+    atomic_u32_t              *FreeLinks;            /// Storage for Capacity free list links. FreeLinks[i] stores one plus the index of the free node following NodeList[i], or zero.
     OS_HOST_MEMORY_ALLOCATION *NodeList;             /// The pre-allocated storage for Capacity OS_HOST_MEMORY_ALLOCATION instances.
     size_t                     Capacity;             /// The maximum number of allocations that can be made from the pool.
     size_t                     MinAllocationSize;    /// The minimum number of bytes that can be associated with any individual allocation.
     size_t                     MinCommitIncrease;    /// The minimum number of bytes that memory commitment can increase by for each allocation from the pool.
     uint32_t                   PageSize;             /// The size of a VMM page, in bytes, on the host operating system.
     uint32_t                   Granularity;          /// The VMM allocation granularity, in bytes.
+    uint32_t                   NumaPolicy;           /// One of OS_HOST_MEMORY_NUMA_POLICY specifying the default placement of physical memory for allocations from the pool.
+    uint32_t                   NumaNode;             /// The zero-based index of the NUMA node used with OS_HOST_MEMORY_NUMA_POLICY_BIND.
+    atomic_u64_t               AllocationCount;      /// The number of allocations successfully acquired from the pool.
+    atomic_u64_t               ReleaseCount;         /// The number of allocations returned to the pool.
+    atomic_u64_t               FailedCount;          /// The number of allocation requests that could not be satisfied.
+    atomic_u64_t               ExhaustedCount;       /// The number of allocation requests that failed because every OS_HOST_MEMORY_ALLOCATION in the pool was in use.
+    atomic_u64_t               CommitCount;          /// The number of VMM commit operations performed for allocations from the pool.
+    atomic_u64_t               NodesInUse;           /// The number of OS_HOST_MEMORY_ALLOCATION instances currently acquired from the pool.
+    atomic_u64_t               NodesInUsePeak;       /// The largest value of NodesInUse since the pool was created. Compare with Capacity to size the pool.
+    atomic_u64_t               BytesReserved;        /// The total number of bytes of address space currently reserved by allocations from the pool.
+    atomic_u64_t               BytesCommitted;       /// The total number of bytes of address space currently committed by allocations from the pool.
+    atomic_u64_t               BytesCommittedPeak;   /// The largest value of BytesCommitted since the pool was created.
 };
 
 /// @summary Define the data used to initialize a pool of OS_HOST_MEMORY_ALLOCATION instances.
@@ -443,6 +583,8 @@ struct OS_HOST_MEMORY_POOL_INIT
     size_t                     PoolCapacity;         /// The maximum number of allocations that can be made from the pool.
     size_t                     MinAllocationSize;    /// The minimum number of bytes that can be associated with any individual allocation.
     size_t                     MinCommitIncrease;    /// The minimum number of bytes that memory commitment can increase by for each allocation from the pool.
+    uint32_t                   NumaPolicy;           /// One of OS_HOST_MEMORY_NUMA_POLICY specifying the default placement of physical memory for allocations from the pool.
+    uint32_t                   NumaNode;             /// The zero-based index of the NUMA node used with OS_HOST_MEMORY_NUMA_POLICY_BIND.
 };
 
 /// @summary Define the data associated with a single host memory allocation. Each allocation corresponds to a VirtualAlloc call.
@@ -450,11 +592,15 @@ struct OS_HOST_MEMORY_POOL_INIT
 struct OS_HOST_MEMORY_ALLOCATION
 {
     OS_HOST_MEMORY_POOL       *SourcePool;           /// The OS_HOST_MEMORY_POOL from which the chunk was allocated.
-    OS_HOST_MEMORY_ALLOCATION *NextAllocation;       /// Used by the OS_HOST_MEMORY_POOL to maintain the free list. May be used by the application.
+    OS_HOST_MEMORY_ALLOCATION *NextAllocation;       /// Not used by the OS_HOST_MEMORY_POOL. May be used by the application while the allocation is acquired.
     uint8_t                   *BaseAddress;          /// The address of the first accessible byte.
     size_t                     BytesReserved;        /// The number of bytes of process address space reserved by this allocation, not including the guard page (if any).
     size_t                     BytesCommitted;       /// The number of bytes of process address space committed by this allocation. Always <= BytesReserved.
+    size_t                     PageSize;             /// The size of the VMM pages backing the allocation, in bytes. Commitment increases in multiples of this value.
+    size_t                     GuardSize;            /// The size of the trailing guard page, in bytes, or zero if the allocation has no guard page.
     uint32_t                   AllocationFlags;      /// One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS.
+    uint32_t                   NumaPolicy;           /// One of OS_HOST_MEMORY_NUMA_POLICY specifying the placement of physical memory for the allocation.
+    uint32_t                   NumaNode;             /// The zero-based index of the NUMA node used with OS_HOST_MEMORY_NUMA_POLICY_BIND.
 };
 
 /// @summary Represents a range of host-visible memory. This type is not specific to the host operating system.
@@ -473,6 +619,10 @@ struct OS_ARENA_ALLOCATOR
 {
     size_t              NextOffset;                  /// The byte offset, relative to the start of the associated memory range, of the next free byte.
     size_t              SizeInBytes;                 /// The maximum offset value. NextOffset is always <= SizeInBytes.
+    size_t              HighWaterMark;               /// The largest value of NextOffset since the allocator was created or the high-water mark was last reset.
+    uint64_t            AllocationCount;             /// The number of allocation requests satisfied by the allocator.
+    uint64_t            FailedCount;                 /// The number of allocation requests that could not be satisfied.
+    uint64_t            ResetCount;                  /// The number of times the allocator was reset, either fully or to a marker.
 };
 
 /// @summary Define the set of information returned from a buddy allocator block query.
@@ -480,51 +630,69 @@ struct OS_ARENA_ALLOCATOR
 struct OS_BUDDY_BLOCK_INFO
 {
     uint32_t            LevelIndex;                  /// The zero-based index of the level at which the block was allocated, with level 0 being the largest level.
-    uint32_t            BitIndex;                    /// The zero-based index of the bit that is set for blocks in this level.
-    uint32_t            BlockSize;                   /// The size of the blocks in this level, in bytes.
-    uint32_t            BlockCount;                  /// The maximum number of blocks in this level.
-    uint32_t            IndexOffset;                 /// The offset used to transform an absolute index into a relative index.
-    uint32_t            LeftAbsoluteIndex;           /// The absolute block index of the leftmost block of the buddy pair, either BlockAbsoluteIndex or BuddyAbsoluteIndex.
-    uint32_t            BlockAbsoluteIndex;          /// The absolute block index of the input block.
-    uint32_t            BuddyAbsoluteIndex;          /// The absolute block index of the buddy of the input block.
+    uint32_t            BitIndex;                    /// The zero-based index of the bit that is set for blocks in this level; BlockSize is 1 << BitIndex.
+    uint64_t            BlockSize;                   /// The size of the blocks in this level, in bytes.
+    uint64_t            BlockOffset;                 /// The byte offset of the start of the block.
+    uint64_t            BlockIndex;                  /// The zero-based index of the block within its level.
+    uint64_t            BuddyIndex;                  /// The zero-based index of the buddy of the block within its level.
 };
 
-/// @summary Define the information used to look up the status of a block in the allocator merge index.
-/// The merge index contains one bit per buddy-pair. The bit is clear if both blocks are free or both are allocated, and set if only one block is allocated.
-/// This type can be used regardless of whether the memory being managed is host or device memory.
-struct OS_BUDDY_BLOCK_MERGE_INFO
-{
-    uint32_t            WordIndex;                   /// The zero-based index of the uint32_t value in the OS_BUDDY_ALLOCATOR::MergeIndex field.
-    uint32_t            Mask;                        /// The mask value used to test or manipulate the state of the bit.
+/// @summary Define the signature of the callback invoked by OsBuddyCompact to move a live block to a new location.
+/// The callback must copy size bytes from src_offset to dst_offset within the managed memory and update every reference to the block.
+/// The source and destination ranges never overlap. Return false to leave the block in place, for example because it is pinned or in use by a device.
+/// @param context Opaque data supplied by the caller of OsBuddyCompact, such as a handle table mapping block offsets to handles.
+/// @param src_offset The current byte offset of the live block.
+/// @param dst_offset The byte offset to which the block is being moved. On return, the block lives at this offset.
+/// @param size The size of the block, in bytes.
+/// @return true if the block was moved, or false to keep the block at src_offset.
+typedef bool          (*OS_BUDDY_RELOCATE_FUNC)(void *context, uint64_t src_offset, uint64_t dst_offset, uint64_t size);
+
+/// @summary Define the results of a single incremental compaction pass over an OS_BUDDY_ALLOCATOR.
+struct OS_BUDDY_COMPACT_RESULT
+{
+    uint64_t            BlocksMoved;                 /// The number of live blocks relocated during the pass.
+    uint64_t            BytesMoved;                  /// The total size of the relocated blocks, in bytes.
+    uint64_t            BlocksPinned;                /// The number of relocations declined by the callback.
+    bool                Complete;                    /// true if the pass examined every level without moving any blocks, meaning no further compaction is possible.
 };
 
-/// @summary Define the information used to look up the status of a block in the allocator split index.
-/// The split index contains one bit per block for each level not including the leaf level. The bit is set if the corresponding block has been split.
+/// @summary Define a hierarchical bitset used by the buddy allocator to locate a set bit with one bit scan per tier.
+/// Tier 0 stores one bit per block. Each bit in tier t+1 is set if the corresponding 64-bit word in tier t is non-zero. The top tier is a single word.
 /// This type can be used regardless of whether the memory being managed is host or device memory.
-struct OS_BUDDY_BLOCK_SPLIT_INFO
-{
-    uint32_t            WordIndex;                   /// The zero-based index of the uint32_t value in the OS_BUDDY_ALLOCATOR::SplitIndex field.
-    uint32_t            Mask;                        /// The mask value used to test or manipulate the state of the bit.
+struct OS_BUDDY_BITSET
+{   static size_t const MAX_TIERS = 8;               /// The maximum number of tiers, enough to represent 2^48 bits.
+    uint64_t           *Tiers[MAX_TIERS];            /// TierCount pointers to the word arrays for each tier, with tier 0 being the leaf tier.
+    uint32_t            TierCount;                   /// The number of valid entries in the Tiers array.
 };
 
 /// @summary Define the data associated with a buddy allocator.
 /// The buddy allocator divides a memory range into power-of-two sized chunks between a minimum and maximum size.
 /// It supports a general-style allocation interface, including realloc functionality, and may be used for host or device memory.
+/// Each level maintains a hierarchical bitset of free blocks, and a bitmap of split blocks, so allocation and free cost depends only on the level count.
+/// The metadata is reserved up front but committed a page at a time as it is first written, so only the parts of the range that are used cost memory.
 /// See http://bitsquid.blogspot.com/2015/08/allocation-adventures-3-buddy-allocator.html
 struct OS_BUDDY_ALLOCATOR
-{   static size_t const MAX_LEVELS = 16;             /// The maximum number of powers of two that can separate AllocationSizeMin and AllocationSizeMax.
-    size_t              AllocationSizeMin;           /// The size of the smallest memory block that can be returned by this allocator.
-    size_t              AllocationSizeMax;           /// The size of the largest memory block that can be returned by this allocator.
-    size_t              BytesReserved;               /// The number of bytes marked as reserved. These bytes can never be allocated to the application.
-    uint8_t            *MetadataBase;                /// The base address of the metadata storage allocation.
-    uint32_t           *FreeListData;                /// Storage for the free list arrays, allocated as a single contiguous block. There are 1 << LevelCount uint32_t values.
-    uint32_t           *MergeIndex;                  /// An array of 1 << (LevelCount-1) bits with each bit storing the state of a pair of buddies.
-    uint32_t           *SplitIndex;                  /// An array of 1 << (LevelCount-1) bits with each bit set if the block at bit index i has been set.
-    uint32_t            Reserved;                    /// Reserved for future use. Set to zero.
+{   static size_t const MAX_LEVELS = 48;             /// The maximum number of levels, where each level halves the block size of the previous level.
+    static size_t const MAX_COMPACT_PROBES = 256;    /// The maximum number of free blocks examined by a single call to OsBuddyCompact.
+    uint64_t            AllocationSizeMin;           /// The size of the smallest memory block that can be returned by this allocator.
+    uint64_t            AllocationSizeMax;           /// The size of the largest memory block that can be returned by this allocator.
+    uint64_t            BytesReserved;               /// The number of bytes marked as reserved. These bytes can never be allocated to the application.
+    uint8_t            *MetadataBase;                /// The base address of the metadata storage reservation.
+    size_t              MetadataSize;                /// The size of the metadata storage reservation, in bytes.
+    size_t              MetadataCommitted;           /// The number of bytes of metadata storage committed.
+    uint64_t           *MetadataCommitMap;           /// One bit per page of metadata storage, set if the page is committed. Stored at the start of the metadata, and always committed.
+    uint32_t            MetadataPageShift;           /// The base-2 logarithm of the page size used to commit metadata storage.
+    uint64_t            LevelsUsed;                  /// Bit i is set if the metadata for level i has been written since the allocator was created or reset.
+    uint64_t            LevelMask;                   /// Bit i is set if level i has at least one free block.
     uint32_t            LevelCount;                  /// The total number of levels used by the allocator, with level 0 representing the largest level.
     uint32_t            LevelBits[MAX_LEVELS];       /// The zero-based index of the set bit for each level. LevelCount entries are valid.
-    uint32_t            FreeCount[MAX_LEVELS];       /// The number of entries in the free list for each level. LevelCount entries are valid.
-    uint32_t           *FreeLists[MAX_LEVELS];       /// Each of LevelCount entries points to an array of 1 << LevelIndex values specifying free block offsets for that level.
+    OS_BUDDY_BITSET     FreeBlocks[MAX_LEVELS];      /// For each level, a bitset with one bit per block, set if the block is free. LevelCount entries are valid.
+    uint64_t           *SplitBlocks[MAX_LEVELS];     /// For each level, a bitmap with one bit per block, set if the block has been split. LevelCount-1 entries are valid.
+    uint64_t            AllocationCount;             /// The number of allocation requests satisfied by the allocator.
+    uint64_t            FreeCount;                   /// The number of blocks returned to the allocator.
+    uint64_t            FailedCount;                 /// The number of allocation requests that could not be satisfied.
+    uint64_t            BytesLive;                   /// The total size of all allocated blocks, in bytes, not including the reserved range.
+    uint64_t            BytesPeak;                   /// The largest value of BytesLive since the allocator was created or reset.
 };
 
 /// @summary Define the data used to initialize a buddy allocator.
@@ -535,11 +703,207 @@ struct OS_BUDDY_ALLOCATOR_INIT
     size_t              BytesReserved;               /// The number of bytes marked as reserved. These bytes can never be allocated to the application.
 };
 
+/// @summary Define a per-thread cache of free blocks for the smallest levels of an OS_CONCURRENT_BUDDY_ALLOCATOR. Zero-initialize before first use.
+/// Blocks in the cache remain allocated within the underlying buddy allocator; they are not merged with their buddies until returned to the allocator.
+struct OS_BUDDY_THREAD_CACHE
+{   static size_t const MAX_LEVELS = 8;              /// The number of (smallest) levels with cached blocks.
+    static size_t const CAPACITY   = 32;             /// The maximum number of blocks cached per-level.
+    static size_t const BATCH_SIZE = CAPACITY / 2;   /// The number of blocks moved between the cache and the allocator at once.
+    uint32_t            Generation;                  /// The value of OS_CONCURRENT_BUDDY_ALLOCATOR::Generation at the time the cache was last filled.
+    uint32_t            Count [MAX_LEVELS];          /// The number of blocks cached for each level.
+    uint64_t            Blocks[MAX_LEVELS][CAPACITY];/// The byte offsets of the cached blocks for each level.
+};
+
+/// @summary Define a lock-protected store of free blocks for a single level of an OS_CONCURRENT_BUDDY_ALLOCATOR, shared by all threads.
+/// Blocks in the depot remain allocated within the underlying buddy allocator; merging is deferred until the depot overflows or is drained.
+struct OS_BUDDY_LEVEL_DEPOT
+{   static size_t const CAPACITY   = 256;            /// The maximum number of blocks stored in the depot.
+    OS_MUTEX            Lock;                        /// The lock protecting the depot contents. Each level has its own lock.
+    uint32_t            Count;                       /// The number of blocks stored in the depot.
+    uint64_t            Blocks[CAPACITY];            /// The byte offsets of the blocks stored in the depot.
+};
+
+/// @summary Define the data associated with a buddy allocator that can be safely used by multiple threads concurrently.
+/// Requests for the smallest levels are satisfied from a caller-supplied OS_BUDDY_THREAD_CACHE, then from a per-level depot, and only then from the underlying allocator.
+/// Splits and merges in the underlying allocator are serialized by TreeLock. The lock order is TreeLock, then any depot lock.
+struct OS_CONCURRENT_BUDDY_ALLOCATOR
+{   typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer value that can be read and written atomically.
+    static size_t const MAX_CACHED_LEVELS = OS_BUDDY_THREAD_CACHE::MAX_LEVELS;
+    OS_MUTEX            TreeLock;                    /// The lock serializing access to the Tree allocator.
+    OS_BUDDY_ALLOCATOR  Tree;                        /// The underlying single-threaded buddy allocator.
+    uint32_t            FirstCachedLevel;            /// The index of the largest level whose blocks may be cached. Levels [FirstCachedLevel, Tree.LevelCount) are cached.
+    uint32_t            CachedLevelCount;            /// The number of levels whose blocks may be cached.
+    atomic_u32_t        Generation;                  /// Incremented by each reset to invalidate all outstanding thread caches.
+    OS_BUDDY_LEVEL_DEPOT Depots[MAX_CACHED_LEVELS];  /// The shared depots for each cached level. CachedLevelCount entries are valid.
+};
+
+/// @summary Define the header stored in host memory immediately before each block managed by an OS_TLSF_ALLOCATOR.
+/// All links are byte offsets from the start of the managed memory range, so the heap contents are position-independent.
+struct OS_TLSF_BLOCK_HEADER
+{
+    uint64_t            PrevPhysical;                /// The offset of the header of the physically preceding block, or OS_TLSF_ALLOCATOR::NULL_OFFSET.
+    uint64_t            SizeAndFlags;                /// The size of the block payload, in bytes, combined with OS_TLSF_ALLOCATOR::BLOCK_FREE and BLOCK_PREV_FREE.
+    uint64_t            NextFree;                    /// The offset of the next block in the same free list. Valid only while the block is free; overlaps the payload.
+    uint64_t            PrevFree;                    /// The offset of the previous block in the same free list. Valid only while the block is free; overlaps the payload.
+};
+
+/// @summary Define the data associated with a two-level segregated-fit (TLSF) allocator.
+/// The first level segregates free blocks by power-of-two size class, and the second level linearly subdivides each class, so allocation and free run in constant time.
+/// Block headers are stored in-band, so this allocator may only manage host-visible memory. It is not safe for concurrent use.
+/// See http://www.gii.upv.es/tlsf/files/ecrts04_tlsf.pdf
+struct OS_TLSF_ALLOCATOR
+{   static uint32_t const SL_INDEX_COUNT_LOG2 = 5;   /// The base-2 logarithm of the number of second-level lists per first-level class.
+    static uint32_t const SL_INDEX_COUNT   = 1U << SL_INDEX_COUNT_LOG2;
+    static uint32_t const ALIGN_SIZE_LOG2  = 4;      /// The base-2 logarithm of the minimum block alignment and size granularity.
+    static uint32_t const ALIGN_SIZE       = 1U << ALIGN_SIZE_LOG2;
+    static uint32_t const FL_INDEX_MAX     = 40;     /// The base-2 logarithm of the block size limit.
+    static uint32_t const FL_INDEX_SHIFT   = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+    static uint32_t const FL_INDEX_COUNT   = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+    static uint64_t const SMALL_BLOCK_SIZE = 1ULL << FL_INDEX_SHIFT; /// Blocks smaller than this are stored in first-level class 0, linearly subdivided.
+    static uint64_t const BLOCK_OVERHEAD   = 2 * sizeof(uint64_t);   /// The number of header bytes preceding an allocated block payload.
+    static uint64_t const BLOCK_SIZE_MIN   = 2 * sizeof(uint64_t);   /// The minimum payload size, large enough to hold the free list links.
+    static uint64_t const BLOCK_SIZE_MAX   =(1ULL << FL_INDEX_MAX) - ALIGN_SIZE;
+    static uint64_t const BLOCK_FREE       = 1;      /// Flag set in SizeAndFlags when the block is free.
+    static uint64_t const BLOCK_PREV_FREE  = 2;      /// Flag set in SizeAndFlags when the physically preceding block is free.
+    static uint64_t const NULL_OFFSET      = ~0ULL;  /// The offset value used to represent a NULL block link.
+    OS_MEMORY_RANGE     HostMemory;                  /// The OS_MEMORY_RANGE specifying the start and size of the host-visible memory. The entire range must be committed.
+    uint64_t            BytesFree;                   /// The total payload size of all free blocks, in bytes.
+    uint64_t            BytesLive;                   /// The total payload size of all allocated blocks, in bytes.
+    uint64_t            BytesPeak;                   /// The largest value of BytesLive since the allocator was created or reset.
+    uint64_t            AllocationCount;             /// The number of allocation requests satisfied by the allocator.
+    uint64_t            FreeCount;                   /// The number of blocks returned to the allocator.
+    uint64_t            FailedCount;                 /// The number of allocation requests that could not be satisfied.
+    uint32_t            FlBitmap;                    /// Bit i is set if first-level class i has at least one free block.
+    uint32_t            SlBitmap  [FL_INDEX_COUNT];  /// For each first-level class, bit j is set if second-level list j has at least one free block.
+    uint64_t            FreeBlocks[FL_INDEX_COUNT][SL_INDEX_COUNT]; /// The offset of the first free block in each list, or NULL_OFFSET.
+};
+
 /// @summary Define the data associated with an arena-style host memory allocator. 
 struct OS_HOST_MEMORY_ARENA
 {
     OS_MEMORY_RANGE     HostMemory;                  /// The OS_MEMORY_RANGE specifying the start and size of the host-visible memory.
     OS_ARENA_ALLOCATOR  Allocator;                   /// The OS_ARENA_ALLOCATOR maintaining the allocator state.
+    size_t              ResidentSize;                /// The number of bytes at the start of HostMemory that may be backed by physical pages, as of the last trim.
+    size_t              PageSize;                    /// The VMM page size, in bytes. Trimming releases whole pages only.
+};
+
+/// @summary Define the data associated with an open-addressing hash set whose storage is allocated from an OS_HOST_MEMORY_ARENA.
+/// Slots are arranged in groups of OS_HASH_GROUP_WIDTH, each with one control byte per slot storing seven bits of the hash of the key 
+/// in the slot, or a marker for an empty or deleted slot. Lookups compare the control bytes of an entire group at once using SIMD.
+/// Keys must be trivially copyable, and are hashed with OsHashKey and compared with OsHashKeyEqual. When the table grows, new storage 
+/// is allocated from the arena and the old storage is abandoned, so reserve capacity up front where the final size is known.
+/// @typeparam K The key type.
+template <typename K>
+struct OS_HASH_SET
+{
+    uint8_t            *Control;                     /// Capacity control bytes, one per slot. Aligned to OS_HASH_GROUP_WIDTH.
+    K                  *Keys;                        /// Storage for Capacity keys. Only slots with a full control byte hold a valid key.
+    size_t              Capacity;                    /// The number of slots. Either zero, or a power of two no less than OS_HASH_GROUP_WIDTH.
+    size_t              Count;                       /// The number of keys in the table.
+    size_t              GrowthLeft;                  /// The number of empty slots that can be filled before the table must grow.
+    OS_HOST_MEMORY_ARENA *Arena;                     /// The arena from which table storage is allocated.
+    uint32_t            Flags;                       /// One or more of OS_HASH_TABLE_FLAGS.
+};
+
+/// @summary Define the data associated with an open-addressing hash map whose storage is allocated from an OS_HOST_MEMORY_ARENA.
+/// The map is laid out the same way as OS_HASH_SET, with a parallel array of values. Keys and values must be trivially copyable.
+/// @typeparam K The key type.
+/// @typeparam V The value type.
+template <typename K, typename V>
+struct OS_HASH_MAP
+{
+    uint8_t            *Control;                     /// Capacity control bytes, one per slot. Aligned to OS_HASH_GROUP_WIDTH.
+    K                  *Keys;                        /// Storage for Capacity keys. Only slots with a full control byte hold a valid key.
+    V                  *Values;                      /// Storage for Capacity values, parallel to Keys.
+    size_t              Capacity;                    /// The number of slots. Either zero, or a power of two no less than OS_HASH_GROUP_WIDTH.
+    size_t              Count;                       /// The number of keys in the table.
+    size_t              GrowthLeft;                  /// The number of empty slots that can be filled before the table must grow.
+    OS_HOST_MEMORY_ARENA *Arena;                     /// The arena from which table storage is allocated.
+    uint32_t            Flags;                       /// One or more of OS_HASH_TABLE_FLAGS.
+};
+
+/// @summary Define the signature for a caller-supplied fence used to determine when a frame arena generation can be reused.
+/// For example, the callback might wait on a Vulkan fence submitted with the command buffers that reference the frame data.
+/// @param context Opaque data supplied by the application with the callback.
+/// @param timeout_ns The maximum amount of time to wait for the fence to become signaled, specified in nanoseconds.
+/// @return true if the fence is signaled, or false if a timeout or error occurs.
+typedef bool          (*OS_FRAME_FENCE_WAIT)(void *context, uint64_t timeout_ns);
+
+/// @summary Define the data associated with a single generation of an OS_FRAME_ARENA.
+struct OS_FRAME_ARENA_GENERATION
+{
+    OS_HOST_MEMORY_ARENA Arena;                      /// The memory arena holding allocations made during frame FrameIndex.
+    OS_TASK_FENCE      *TaskFence;                   /// The task fence that must be signaled before the generation is reset, or NULL.
+    OS_FRAME_FENCE_WAIT FenceWait;                   /// The caller-supplied fence that must be signaled before the generation is reset, or NULL.
+    void               *FenceContext;                /// Opaque data passed to FenceWait.
+    uint64_t            FrameIndex;                  /// The index of the frame that most recently allocated from the generation.
+    size_t              BytesUsed;                   /// The number of bytes allocated during frame FrameIndex, as of the end of the frame.
+};
+
+/// @summary Define the data associated with a set of memory arenas used in rotation for per-frame transient allocations.
+/// Memory allocated during frame N remains valid until the generation is reused, GenerationCount frames later, and the 
+/// fence attached at the end of frame N has been signaled. Allocation, and frame rotation, must be performed from a single thread.
+struct OS_FRAME_ARENA
+{   static uint32_t const MAX_GENERATIONS = 4;       /// The maximum number of frames that can be in-flight at once.
+    uint32_t            GenerationCount;             /// The number of valid entries in the Generations array.
+    uint32_t            CurrentGeneration;           /// The zero-based index of the generation receiving allocations for the current frame.
+    uint64_t            FrameIndex;                  /// The index of the current frame. Incremented by OsFrameArenaBeginFrame.
+    OS_FRAME_ARENA_GENERATION Generations[MAX_GENERATIONS];
+};
+
+/// @summary Define the header stored at the start of each block of memory owned by an OS_CHAINED_ARENA.
+struct OS_CHAINED_ARENA_BLOCK
+{
+    OS_HOST_MEMORY_ALLOCATION *Allocation;           /// The host memory allocation containing the block. The header is stored at Allocation->BaseAddress.
+    OS_CHAINED_ARENA_BLOCK    *PrevBlock;            /// The block allocated from before this block, or NULL for the first block.
+    size_t                     BaseOffset;           /// The logical offset of the start of the block, equal to the sum of the sizes of all previous blocks.
+    size_t                     NextOffset;           /// The byte offset, relative to the start of the block, of the next free byte.
+    size_t                     SizeInBytes;          /// The size of the block, in bytes, including the header.
+};
+
+/// @summary Define the data associated with an arena-style allocator that acquires additional blocks from an OS_HOST_MEMORY_POOL when the current block is exhausted.
+/// Markers are logical offsets spanning all blocks, so marking and resetting work as they do for a single-block arena.
+/// Resetting the arena releases all but one block; if more than one block was in use, the remaining block is sized to hold the high-water mark.
+struct OS_CHAINED_ARENA
+{   static size_t const BLOCK_HEADER_SIZE = (sizeof(OS_CHAINED_ARENA_BLOCK) + OS_CACHELINE_SIZE - 1) & ~size_t(OS_CACHELINE_SIZE - 1);
+    OS_HOST_MEMORY_POOL       *SourcePool;           /// The OS_HOST_MEMORY_POOL from which blocks are acquired.
+    OS_CHAINED_ARENA_BLOCK    *FirstBlock;           /// The first block in the chain.
+    OS_CHAINED_ARENA_BLOCK    *CurrentBlock;         /// The block currently being allocated from, which is the last block in the chain.
+    size_t                     BlockSize;            /// The minimum number of bytes of address space reserved for each block.
+    size_t                     HighWaterMark;        /// The largest logical offset of the next free byte since the arena was created or last reset.
+    uint32_t                   AllocationFlags;      /// One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS used for each block.
+    uint32_t                   BlockCount;           /// The number of blocks in the chain.
+    uint64_t                   AllocationCount;      /// The number of allocation requests satisfied by the arena.
+    uint64_t                   FailedCount;          /// The number of allocation requests that could not be satisfied.
+    uint64_t                   ResetCount;           /// The number of times the arena was reset, either fully or to a marker.
+    uint64_t                   GrowCount;            /// The number of blocks acquired to satisfy allocation requests after the arena was created.
+};
+
+/// @summary Define the data associated with an arena-style host memory allocator that can be safely allocated from by multiple threads concurrently.
+/// Threads allocate by atomically advancing NextOffset, either directly or in ChunkSize pieces carved into a thread-owned OS_CONCURRENT_ARENA_CHUNK.
+/// Marking and resetting the arena must be performed by a single thread while no other thread is allocating (for example, between frames).
+/// The structure is cache-line aligned, so NextOffset does not share a cache line with data preceding or following the arena.
+#pragma warning(push)
+#pragma warning(disable:4324)                        /// Structure was padded due to __declspec(align())
+struct OS_CACHELINE_ALIGN OS_CONCURRENT_ARENA
+{   typedef std::atomic<size_t>        atomic_size_t;/// A size_t value that can be read and written atomically.
+    typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer value that can be read and written atomically.
+    static size_t const DEFAULT_CHUNK_SIZE = 64 * 1024; /// The chunk size used when zero is specified to OsCreateConcurrentArena.
+    static size_t const PADDING_BYTES  = OS_CACHELINE_SIZE - sizeof(atomic_size_t);
+    atomic_size_t       NextOffset;                  /// The byte offset, relative to the start of HostMemory, of the next free byte. Never exceeds HostMemory.SizeInBytes.
+    uint8_t             Pad0[PADDING_BYTES];         /// Padding separating the frequently-written NextOffset from read-mostly data.
+    OS_MEMORY_RANGE     HostMemory;                  /// The OS_MEMORY_RANGE specifying the start and size of the host-visible memory.
+    size_t              ChunkSize;                   /// The number of bytes handed out to a thread-owned OS_CONCURRENT_ARENA_CHUNK at once.
+    atomic_u32_t        Generation;                  /// Incremented by each create, delete, mark or reset operation to invalidate all outstanding thread-owned chunks.
+};
+#pragma warning(pop)
+
+/// @summary Define the data associated with a chunk of an OS_CONCURRENT_ARENA owned by a single thread. Zero-initialize before first use.
+struct OS_CONCURRENT_ARENA_CHUNK
+{
+    size_t              NextOffset;                  /// The byte offset, relative to the start of the arena memory, of the next free byte in the chunk.
+    size_t              EndOffset;                   /// The byte offset, relative to the start of the arena memory, of the end of the chunk.
+    uint32_t            Generation;                  /// The value of OS_CONCURRENT_ARENA::Generation at the time the chunk was acquired.
 };
 
 /// @summary Define the data associated with a buddy-style host memory allocator.
@@ -549,6 +913,203 @@ struct OS_HOST_MEMORY_ALLOCATOR
     OS_BUDDY_ALLOCATOR  Allocator;                   /// The OS_BUDDY_ALLOCATOR maintaining the allocator state.
 };
 
+/// @summary Define the state associated with a single object size class within an OS_SLAB_ALLOCATOR.
+/// Objects are carved from slabs owned by the size class, and returned objects are kept on a free list. No objects are returned to the slab.
+struct OS_SLAB_SIZE_CLASS
+{   typedef std::atomic<void*>         atomic_ptr_t; /// A pointer value that can be read and written atomically.
+    typedef std::atomic<size_t>        atomic_size_t;/// A size_t value that can be read and written atomically.
+    OS_MUTEX            Lock;                        /// The lock protecting FreeList and the carve range.
+    size_t              ObjectSize;                  /// The size of each object in the size class, in bytes. Always a multiple of OS_SLAB_ALLOCATOR::OBJECT_ALIGNMENT.
+    void               *FreeList;                    /// The first object in the list of objects returned by thread caches. Protected by Lock.
+    uint8_t            *CarveNext;                   /// The address of the next never-allocated object in the current slab. Protected by Lock.
+    uint8_t            *CarveEnd;                    /// The address of the end of the usable portion of the current slab. Protected by Lock.
+    atomic_ptr_t        RemoteFree;                  /// The first object in a lock-free list of objects freed by threads without a cache.
+    atomic_size_t       RemoteFreeCount;             /// The total number of objects pushed onto the RemoteFree list.
+    size_t              SlabCount;                   /// The number of slabs acquired by this size class. Protected by Lock.
+    size_t              RefillCount;                 /// The number of times a thread cache was refilled from this size class. Protected by Lock.
+};
+
+/// @summary Define a per-thread cache (magazine) of free objects for each size class of an OS_SLAB_ALLOCATOR. Zero-initialize before first use.
+struct OS_SLAB_THREAD_CACHE
+{   static size_t const MAX_SIZE_CLASSES = 16;       /// The maximum number of size classes supported by an OS_SLAB_ALLOCATOR.
+    static size_t const CAPACITY   = 32;             /// The maximum number of objects cached per-size class.
+    static size_t const BATCH_SIZE = CAPACITY / 2;   /// The number of objects moved between the cache and the allocator at once.
+    uint32_t            Count  [MAX_SIZE_CLASSES];   /// The number of objects cached for each size class.
+    void               *Objects[MAX_SIZE_CLASSES][CAPACITY]; /// The addresses of the cached objects for each size class.
+};
+
+/// @summary Define the data associated with a fixed-size object allocator that can be safely used by multiple threads concurrently.
+/// Memory is divided into equal-size slabs, each of which is dedicated to a single size class. The size class of an object is determined from the slab containing it.
+struct OS_SLAB_ALLOCATOR
+{   static size_t const MAX_SIZE_CLASSES  = OS_SLAB_THREAD_CACHE::MAX_SIZE_CLASSES;
+    static size_t const DEFAULT_SLAB_SIZE = 64 * 1024; /// The slab size used when zero is specified in OS_SLAB_ALLOCATOR_INIT::SlabSize.
+    static size_t const OBJECT_ALIGNMENT  = 16;      /// The alignment of every object returned by the allocator, in bytes.
+    OS_MUTEX            SlabLock;                    /// The lock protecting SlabCount and the commitment of HostMemory.
+    OS_HOST_MEMORY_ALLOCATION *HostMemory;           /// The host memory allocation from which slabs are carved. Commitment is increased as slabs are acquired.
+    size_t              SlabSize;                    /// The size of each slab, in bytes. Always a power of two.
+    uint32_t            SlabShift;                   /// The base-2 logarithm of SlabSize.
+    uint32_t            SizeClassCount;              /// The number of valid entries in the SizeClasses array.
+    size_t              SlabCount;                   /// The number of slabs acquired from HostMemory.
+    size_t              SlabCapacity;                /// The maximum number of slabs that can be acquired from HostMemory.
+    uint8_t            *SlabClass;                   /// An array of SlabCapacity values specifying the size class index for each acquired slab.
+    size_t              SlabClassSize;               /// The size of the SlabClass allocation, in bytes.
+    OS_SLAB_SIZE_CLASS  SizeClasses[MAX_SIZE_CLASSES]; /// The state associated with each size class, in ascending order of object size.
+};
+
+/// @summary Define the data used to initialize a slab allocator.
+struct OS_SLAB_ALLOCATOR_INIT
+{
+    OS_HOST_MEMORY_ALLOCATION *HostMemory;           /// The host memory allocation from which slabs are carved. The allocator takes ownership of the committed portion.
+    size_t              SlabSize;                    /// The size of each slab, in bytes. Must be a power of two and a multiple of the page size, or zero to use DEFAULT_SLAB_SIZE.
+    size_t const       *SizeClasses;                 /// An array of SizeClassCount object sizes, in ascending order, or NULL to use power-of-two sizes from 16 to 2048 bytes.
+    uint32_t            SizeClassCount;              /// The number of object sizes in the SizeClasses array.
+};
+
+/// @summary Define the statistics reported by the allocator query functions. Fields that do not apply to a given allocator type are set to zero.
+/// Fragmentation can be estimated as 1 - (LargestFreeBlock / BytesFree).
+struct OS_ALLOCATOR_STATS
+{
+    uint64_t            AllocationCount;             /// The number of allocation requests satisfied by the allocator.
+    uint64_t            FreeCount;                   /// The number of blocks returned to the allocator, or the number of resets for arena allocators.
+    uint64_t            FailedCount;                 /// The number of allocation requests that could not be satisfied.
+    uint64_t            BytesLive;                   /// The number of bytes currently allocated to the application, including any rounding.
+    uint64_t            BytesPeak;                   /// The largest value of BytesLive observed by the allocator.
+    uint64_t            BytesFree;                   /// The number of bytes available for allocation.
+    uint64_t            LargestFreeBlock;            /// The size of the largest free block, in bytes. For TLSF allocators this is a lower bound.
+    uint64_t            BytesReserved;               /// The number of bytes of address space (or offset range) managed by the allocator.
+    uint64_t            BytesCommitted;              /// The number of bytes of address space known to be committed.
+    uint64_t            CommitCount;                 /// The number of VMM commit operations performed.
+};
+
+/// @summary Define the data recorded for a single allocator event in an OS_ALLOCATION_TRACE.
+struct OS_ALLOCATION_TRACE_RECORD
+{
+    uint64_t            Timestamp;                   /// The time at which the event occurred, as returned by OsTimestampInTicks.
+    void const         *Allocator;                   /// The address of the allocator object that generated the event.
+    void const         *Caller;                      /// The return address of the allocator function, identifying the call site.
+    uint64_t            Offset;                      /// The byte offset or address of the block, as returned by the allocator.
+    uint64_t            Size;                        /// The size of the block, in bytes.
+    uint32_t            Alignment;                   /// The requested alignment, in bytes, or zero if not applicable.
+    uint32_t            Event;                       /// One of OS_ALLOCATION_EVENT.
+    uint32_t            ThreadId;                    /// The operating system identifier of the thread that generated the event.
+};
+
+/// @summary Define a single slot in an OS_ALLOCATION_TRACE ring buffer.
+struct OS_ALLOCATION_TRACE_SLOT
+{   typedef std::atomic<uint64_t>      atomic_u64_t; /// An unsigned 64-bit integer value that can be read and written atomically.
+    atomic_u64_t        Sequence;                    /// 2 * (index + 1) once the record with the given index is published, or 2 * index + 1 while it is being written. Zero if the slot is empty.
+    OS_ALLOCATION_TRACE_RECORD Record;               /// The record data.
+};
+
+/// @summary Define a fixed-size, lock-free ring buffer of allocator events. Any number of threads may record events concurrently.
+/// When the ring is full, the oldest records are overwritten.
+struct OS_ALLOCATION_TRACE
+{   typedef std::atomic<uint64_t>      atomic_u64_t; /// An unsigned 64-bit integer value that can be read and written atomically.
+    static size_t const PADDING_BYTES  = OS_CACHELINE_SIZE - sizeof(atomic_u64_t);
+    OS_ALLOCATION_TRACE_SLOT *Slots;                 /// Storage for Capacity record slots.
+    uint64_t            Capacity;                    /// The number of record slots. Always a power of two.
+    size_t              StorageSize;                 /// The size of the Slots allocation, in bytes.
+    uint8_t             Pad0[PADDING_BYTES];         /// Padding separating the frequently-written WriteIndex from read-mostly data.
+    atomic_u64_t        WriteIndex;                  /// The index of the next record to be written. Records [WriteIndex - Capacity, WriteIndex) may be available.
+    uint8_t             Pad1[PADDING_BYTES];         /// Padding separating WriteIndex from any data following the trace.
+};
+
+/// @summary Define the signature of a callback invoked when memory usage rises to a pressure level.
+/// The callback runs synchronously on the thread whose commit raised the pressure level, or on the thread calling OsMemoryBudgetUpdate. 
+/// The budget lock is not held, so the callback may commit and release memory through the host memory APIs, but it may run concurrently 
+/// with callbacks dispatched by other threads. It should release memory quickly - trim caches, shrink arenas - and must not call into the 
+/// allocator that was committing memory when the callback was invoked, or call OsMemoryBudgetUnregisterCallback.
+/// @param context The opaque data supplied when the callback was registered.
+/// @param level One of OS_MEMORY_PRESSURE_LEVEL specifying the new pressure level.
+/// @param bytes_used The estimated number of bytes in use.
+/// @param bytes_limit The number of bytes at which the process will be terminated or its commits will fail.
+typedef void          (*OS_MEMORY_PRESSURE_FUNC)(void *context, uint32_t level, uint64_t bytes_used, uint64_t bytes_limit);
+
+/// @summary Define the data associated with a callback registered with an OS_MEMORY_BUDGET.
+struct OS_MEMORY_PRESSURE_CALLBACK
+{
+    OS_MEMORY_PRESSURE_FUNC Callback;                /// The function to invoke.
+    void               *Context;                     /// Opaque data passed through to the callback.
+    uint32_t            Level;                       /// One of OS_MEMORY_PRESSURE_LEVEL. The callback is invoked whenever usage rises to this level or higher.
+};
+
+/// @summary Define the data associated with a process-wide memory budget. The budget limit is read from the cgroup v2 memory.max 
+/// of the process on Linux, or from the job object limits on Windows. Every commit made through the host memory APIs is charged 
+/// against the budget while it is active, as is the storage committed internally for pools, allocator metadata, traces and ring buffers. 
+/// Usage reported by the operating system is re-read periodically. When the estimated usage rises past a threshold, the registered 
+/// pressure callbacks are invoked so memory can be released before the process is killed.
+struct OS_MEMORY_BUDGET
+{   typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer value that can be read and written atomically.
+    typedef std::atomic<uint64_t>      atomic_u64_t; /// An unsigned 64-bit integer value that can be read and written atomically.
+    typedef std::atomic<int64_t>       atomic_s64_t; /// A signed 64-bit integer value that can be read and written atomically.
+    static size_t const MAX_CALLBACKS  = 16;         /// The maximum number of pressure callbacks that can be registered.
+    static size_t const MAX_PATH_CHARS = 512;        /// The maximum length of UsagePath, including the nul terminator.
+    OS_MUTEX            Lock;                        /// Serializes callback registration, pressure level transitions and usage refresh. Not held while callbacks run.
+    OS_MEMORY_PRESSURE_CALLBACK Callbacks[MAX_CALLBACKS]; /// The registered pressure callbacks. Protected by Lock.
+    size_t              CallbackCount;               /// The number of valid entries in Callbacks. Protected by Lock.
+    uint64_t            Limit;                       /// The budget limit, in bytes.
+    uint64_t            Thresholds[3];               /// The estimated usage, in bytes, at which each OS_MEMORY_PRESSURE_LEVEL is entered.
+    uint64_t            RefuseThreshold;             /// The estimated usage, in bytes, above which commits fail, or zero if commits are never refused.
+    uint64_t            Hysteresis;                  /// The number of bytes usage must fall below a threshold before the pressure level drops.
+    uint64_t            RefreshInterval;             /// The number of bytes charged or released between reads of the operating system usage counter.
+    uint32_t            LimitSource;                 /// One of OS_MEMORY_BUDGET_SOURCE specifying where Limit was obtained.
+    char                UsagePath[MAX_PATH_CHARS];   /// On Linux, the path of the cgroup memory.current file, or an empty string if the process has no cgroup limit.
+    atomic_u64_t        SystemUsage;                 /// The usage, in bytes, reported by the operating system at the last refresh.
+    atomic_s64_t        ChargedSinceRefresh;         /// The net number of bytes committed through the host memory APIs since the last refresh.
+    atomic_s64_t        BytesCharged;                /// The net number of bytes committed through the host memory APIs while the budget was active.
+    atomic_u32_t        Level;                       /// One of OS_MEMORY_PRESSURE_LEVEL specifying the current pressure level.
+    atomic_u64_t        RefreshCount;                /// The number of times the operating system usage counter was read.
+    atomic_u64_t        DispatchCount;               /// The number of times the pressure level rose and callbacks were invoked.
+    atomic_u32_t        DispatchActive;              /// The number of threads currently invoking callbacks. OsMemoryBudgetUnregisterCallback waits for this to reach zero.
+    atomic_u64_t        RefusedCount;                /// The number of commits that failed because they would have exceeded RefuseThreshold.
+};
+
+/// @summary Define the data used to configure an OS_MEMORY_BUDGET. Zero-initialize the structure to use the defaults.
+struct OS_MEMORY_BUDGET_INIT
+{
+    uint64_t            LimitOverride;               /// The budget limit, in bytes, or zero to detect the limit from the cgroup or job object containing the process.
+    uint32_t            ModeratePercent;             /// The percentage of the limit at which OS_MEMORY_PRESSURE_LEVEL_MODERATE is entered, or zero for 75.
+    uint32_t            CriticalPercent;             /// The percentage of the limit at which OS_MEMORY_PRESSURE_LEVEL_CRITICAL is entered, or zero for 90.
+    uint32_t            RefusePercent;               /// The percentage of the limit above which commits fail after the critical callbacks have run, or zero to never refuse commits.
+    uint32_t            HysteresisPercent;           /// The percentage of the limit usage must fall below a threshold before the pressure level drops, or zero for 5.
+    uint64_t            RefreshInterval;             /// The number of bytes charged or released between reads of the operating system usage counter, or zero for 16MB.
+};
+
+/// @summary Define the data returned by OsMemoryBudgetQuery.
+struct OS_MEMORY_BUDGET_STATUS
+{
+    uint64_t            Limit;                       /// The budget limit, in bytes.
+    uint64_t            SystemUsage;                 /// The usage, in bytes, reported by the operating system at the last refresh.
+    uint64_t            EstimatedUsage;              /// SystemUsage plus the bytes committed through the host memory APIs since the last refresh.
+    int64_t             BytesCharged;                /// The net number of bytes committed through the host memory APIs while the budget was active.
+    uint64_t            RefreshCount;                /// The number of times the operating system usage counter was read.
+    uint64_t            DispatchCount;               /// The number of times the pressure level rose and callbacks were invoked.
+    uint64_t            RefusedCount;                /// The number of commits that failed because they would have exceeded the refuse threshold.
+    uint32_t            Level;                       /// One of OS_MEMORY_PRESSURE_LEVEL specifying the current pressure level.
+    uint32_t            LimitSource;                 /// One of OS_MEMORY_BUDGET_SOURCE specifying where Limit was obtained.
+};
+
+/// @summary Define the data associated with a ring buffer whose storage is mapped twice, back-to-back, in the process address space.
+/// Any span of up to Capacity bytes starting anywhere in the buffer can be accessed as a single contiguous range without handling wraparound.
+/// Use either OsMagicRingBufferWriteBegin/WriteEnd from a single producer thread, or OsMagicRingBufferReserve/Commit from any number of producer threads.
+/// In both cases, a single consumer thread uses OsMagicRingBufferReadBegin/ReadEnd.
+#pragma warning(push)
+#pragma warning(disable:4324)                        /// Structure was padded due to __declspec(align())
+struct OS_CACHELINE_ALIGN OS_MAGIC_RING_BUFFER
+{   typedef std::atomic<uint64_t>      atomic_u64_t; /// An unsigned 64-bit integer value that can be read and written atomically.
+    static size_t const PADDING_BYTES  = OS_CACHELINE_SIZE - sizeof(atomic_u64_t);
+    atomic_u64_t        WriteCursor;                 /// The total number of bytes made visible to the consumer.
+    uint8_t             Pad0[PADDING_BYTES];         /// Padding separating the producer and consumer ends of the buffer.
+    atomic_u64_t        ReserveCursor;               /// The total number of bytes reserved by producers calling OsMagicRingBufferReserve.
+    uint8_t             Pad1[PADDING_BYTES];         /// Padding separating the reserve cursor from the consumer end of the buffer.
+    atomic_u64_t        ReadCursor;                  /// The total number of bytes consumed.
+    uint8_t             Pad2[PADDING_BYTES];         /// Padding separating the consumer end and shared data.
+    uint8_t            *BaseAddress;                 /// The address of the first mapping. The second mapping starts at BaseAddress + Capacity.
+    uint64_t            Capacity;                    /// The size of the buffer, in bytes. Always a power of two and a multiple of the allocation granularity.
+    uint64_t            Mask;                        /// The bitmask used to map cursor values to byte offsets within the buffer.
+};
+#pragma warning(pop)
+
 /// @summary Alias type for a marker within a memory arena.
 typedef uintptr_t       os_arena_marker_t;           /// The marker stores the value of the OS_ARENA_ALLOCATOR::NextOffset field at a given point in time.
 
@@ -566,6 +1127,23 @@ struct OS_CPU_INFO
     char                IsVirtualMachine;            /// Set to 1 if the process is running in a virtual machine.
 };
 
+/// @summary Define the signatures of the bulk memory kernels selected at runtime based on the instruction set extensions supported by the host CPU.
+/// Copies and fills of at least nt_threshold bytes use non-temporal stores that bypass the cache hierarchy.
+typedef void          (*OS_COPY_MEMORY_FUNC)(void * __restrict dst, void const * __restrict src, size_t len, size_t nt_threshold);
+typedef void          (*OS_FILL_MEMORY_FUNC)(void *dst, size_t len, uint8_t val, size_t nt_threshold);
+typedef int           (*OS_COMPARE_MEMORY_FUNC)(void const *a, void const *b, size_t len);
+
+/// @summary Define the set of kernels used to implement OsCopyMemory, OsZeroMemory, OsFillMemory and OsCompareMemory.
+struct OS_MEMORY_ROUTINES
+{
+    OS_COPY_MEMORY_FUNC    CopyMemory;               /// The kernel used to copy between non-overlapping blocks.
+    OS_FILL_MEMORY_FUNC    FillMemory;               /// The kernel used to zero-fill or fill a block with a byte value.
+    OS_COMPARE_MEMORY_FUNC CompareMemory;            /// The kernel used to lexicographically compare two blocks.
+    size_t                 StreamingThreshold;       /// Copies and fills of at least this many bytes use non-temporal stores. SIZE_MAX disables streaming stores.
+    int32_t                InstructionSet;           /// One of OS_MEMORY_ISA identifying the instruction set used by the kernels.
+};
+
+#if !defined(__linux__)
 /// @summary Represents the user-facing identifier of a task within the task scheduler.
 typedef uint32_t        os_task_id_t;                /// The task ID stores the thread that created the task and the task index.
 
@@ -610,7 +1188,7 @@ struct OS_CACHELINE_ALIGN OS_TASK_QUEUE
 struct OS_CACHELINE_ALIGN OS_TASK_DATA
 {   typedef std::atomic<int32_t>       atomic_s32_t; /// A signed 32-bit integer that can be read and written atomically.
     static size_t const MAX_DATA_BYTES = 48;         /// The maximum size of the per-task parameter data, in bytes.
-    static size_t const MAX_PERMITS    = 14;         /// The maximum number of tasks that this task can permit to run.
+    static size_t const MAX_PERMITS    = 12;         /// The maximum number of tasks that this task can permit to run.
     atomic_s32_t        WaitCount;                   /// The number of tasks that must complete before this task is ready-to-run.
     os_task_id_t        ParentId;                    /// The identifier of the parent task, or OS_INVALID_TASK_ID.
     OS_TASK_ENTRYPOINT  TaskMain;                    /// The task entry point, or NULL for external tasks.
@@ -618,12 +1196,17 @@ struct OS_CACHELINE_ALIGN OS_TASK_DATA
 
     atomic_s32_t        WorkCount;                   /// The number of outstanding work items (this task, plus one for each child task.)
     atomic_s32_t        PermitCount;                 /// The number of tasks that this task permits to run (the number of valid entries in PermitIds.)
+    uint32_t            TargetPool;                  /// The zero-based index of the OS_TASK_POOL whose owning thread must execute the task, or OS_TASK_POOL_INDEX_ANY.
+    os_task_id_t        MailboxNext;                 /// The identifier of the next task in the target pool's mailbox, valid while the task is in the mailbox.
     os_task_id_t        PermitIds[MAX_PERMITS];      /// The task ID of each task permitted to run when this task completes.
 };
 
 /// @summary Define the data associated with a pre-allocated, fixed-size pool of tasks. Task pools are associated with a single thread.
 struct OS_CACHELINE_ALIGN OS_TASK_POOL
 {   typedef std::atomic<uint8_t>       atomic_u8_t;  /// An unsigned 8-bit integer that can be read and written atomically.
+    typedef std::atomic<uint32_t>      atomic_u32_t; /// An unsigned 32-bit integer that can be read and written atomically.
+    typedef std::atomic<os_task_id_t>  atomic_tid_t; /// A task identifier that can be read and written atomically.
+    typedef std::atomic<HANDLE>      atomic_handle_t;/// A HANDLE that can be read and written atomically.
     atomic_u8_t        *SlotStatus;                  /// For each task slot in the pool, 0 if the slot is available or 1 if the slot is in-use.
     uint32_t            IndexMask;                   /// Bitmask used to map an index value into the task data array(s). This is the array size minus one.
     uint32_t            NextIndex;                   /// The zero-based index of the first slot to check when the next task is allocated from the pool.
@@ -632,13 +1215,17 @@ struct OS_CACHELINE_ALIGN OS_TASK_POOL
     uint32_t            ThreadId;                    /// The operating system identifier of the thread that owns the pool.
     int32_t             LastError;                   /// The error code reported by the last attempt to define a task on the pool.
     uint32_t            PoolId;                      /// The application-defined identifier of the associated pool type.
-    uint16_t            NextWorker;                  /// The zero-based index of the next worker to notify.
-    uint16_t            WorkerCount;                 /// The total number of worker threads in the scheduler thread pool.
+    uint32_t            NextWorker;                  /// The zero-based index of the next worker to notify. This value is taken modulo the active worker count.
     OS_TASK_POOL       *TaskPoolList;                /// A local pointer to the set of all task pools within the scheduler.
     OS_TASK_DATA       *TaskPoolData;                /// The buffer storing per-task data.
     OS_TASK_POOL       *NextFreePool;                /// Pointer to the next OS_TASK_POOL in the free list, or NULL if this pool is allocated.
 
     OS_TASK_QUEUE       WorkQueue;                   /// The work-stealing deque of task IDs that are ready-to-run.
+
+    atomic_tid_t        Mailbox;                     /// The most recently delivered ready-to-run thread-affine task, linked through OS_TASK_DATA::MailboxNext, OS_INVALID_TASK_ID, or OS_TASK_MAILBOX_CLOSED if the pool is not owned by a thread. Only the owning thread removes tasks.
+    atomic_handle_t     WakePort;                    /// The I/O completion port of the worker thread that owns the pool, or NULL if the pool is owned by an application thread.
+    atomic_handle_t     WakeEvent;                   /// The event signaled when a thread-affine task is delivered to an empty mailbox of a pool owned by an application thread, or NULL.
+    atomic_u32_t        PostActive;                  /// The number of threads currently delivering a task to the mailbox. The pool is not returned until this reaches zero.
 };
 
 /// @summary Define the data that might be needed by a thread when defining or executing tasks.
@@ -651,8 +1238,9 @@ struct OS_TASK_ENVIRONMENT
     uint32_t                   ThreadId;             /// The operating system identifier of the thread associated with the execution environment.
     uint32_t                   PoolUsage;            /// One or more of OS_TASK_POOL_USAGE indicating whether the pool can be used to run tasks.
     uintptr_t                  ContextData;          /// The opaque value passed through to each task and specified in the OS_TASK_SCHEDULER_INIT::TaskContextData field.
-    OS_HOST_MEMORY_ARENA      *LocalMemory;          /// The thread-local memory arena used for temporary working space.
-    OS_HOST_MEMORY_ARENA      *GlobalMemory;         /// The shared global memory arena used for persistent storage.
+    OS_HOST_MEMORY_ARENA      *LocalMemory;          /// The thread-local memory arena used for temporary working space. Allocations remain valid until the allocating task returns.
+    OS_CONCURRENT_ARENA       *GlobalMemory;         /// The shared global memory arena used for persistent storage. Allocate using GlobalMemoryChunk.
+    OS_CONCURRENT_ARENA_CHUNK  GlobalMemoryChunk;    /// The chunk of global memory owned by the thread, used to allocate from GlobalMemory without contention.
     OS_IO_THREAD_POOL         *IoThreadPool;         /// The application thread pool used for submitting asynchronous I/O requests.
     OS_IO_REQUEST_POOL        *IoRequestPool;        /// The OS_IO_REQUEST_POOL allocated to the thread.
 };
@@ -672,9 +1260,20 @@ struct OS_TASK_SCHEDULER_THREAD_INIT
     uint32_t                   PoolId;               /// The value used to identify the type of task pool to allocate during initialization.
 };
 
+/// @summary Define the per-worker statistics maintained by the task scheduler and used to drive the automatic worker scaling policy.
+#pragma warning(push)
+#pragma warning(disable:4324)                        /// Structure was padded due to __declspec(align())
+struct OS_CACHELINE_ALIGN OS_TASK_WORKER_STATS
+{   typedef std::atomic<uint64_t>      atomic_u64_t; /// An unsigned 64-bit integer that can be read and written atomically.
+    atomic_u64_t        IdleNanoseconds;             /// The total amount of time the worker has spent blocked waiting for work, in nanoseconds.
+    atomic_u64_t        IdleSince;                   /// The timestamp, in ticks, at which the worker began waiting for work, or zero if the worker is running.
+    atomic_u64_t        TasksExecuted;               /// The total number of tasks executed by the worker from its main loop.
+};
+#pragma warning(pop)
+
 /// @summary Define the data associated with a task scheduler. The task scheduler maintains several pools used to define tasks, along with a pool of worker threads dedicated to executing tasks.
 struct OS_TASK_SCHEDULER
-{
+{   typedef std::atomic<size_t>        atomic_size_t;/// A size_t value that can be read and written atomically.
     size_t                     PoolTypeCount;        /// The number of task pool types defined within the scheduler.
     uint32_t                  *PoolIdList;           /// An array of PoolTypeCount items specifying the unique identifers for each task pool type.
     OS_TASK_POOL             **PoolFreeLists;        /// An array of PoolTypeCount pointers to OS_TASK_POOL representing the free list for each pool type.
@@ -683,17 +1282,24 @@ struct OS_TASK_SCHEDULER
     OS_TASK_POOL              *TaskPoolList;         /// An array of TaskPoolCount OS_TASK_POOL objects representing all task pools (regardless of type) created by the scheduler.
     OS_HOST_MEMORY_ARENA      *TaskPoolArenas;       /// An array of TaskPoolCount OS_HOST_MEMORY_ARENA objects representing the thread-local memory arena allocated for each task pool.
     OS_IO_REQUEST_POOL        *TaskIoRequestPools;   /// An array of TaskPoolCount OS_IO_REQUEST_POOL objects representing the thread-local I/O request pool allocated for each task pool.
-    size_t                     WorkerThreadCount;    /// The number of currently worker threads dedicated to executing tasks.
-    unsigned int              *WorkerThreadIds;      /// An array of WorkerThreadCount values specifying the operating system thread identifier for each active worker thread.
-    HANDLE                    *WorkerThreadHandle;   /// An array of WorkerThreadCount values specifying the operating system thread handle for each active worker thread.
-    HANDLE                    *WorkerThreadReady;    /// An array of WorkerThreadCount values specifying the manual-reset event signaled by each active worker to indicate that it is ready to run.
-    HANDLE                    *WorkerThreadError;    /// An array of WorkerThreadCount values specifying the manual-reset event signaled by each active worker to indicate a fatal error has occurred.
-    HANDLE                    *WorkerThreadPort;     /// An array of WorkerThreadCount values specifying the I/O completion port used to wait and wake worker threads in the pool.
-
-    OS_HOST_MEMORY_ARENA       GlobalMemoryArena;    /// The global memory arena.
+    atomic_size_t              WorkerThreadCount;    /// The number of currently active worker threads dedicated to executing tasks. Workers [0, WorkerThreadCount) are running.
+    size_t                     MaxWorkerThreadCount; /// The maximum number of worker threads that can be active at once. Each per-worker array has this many entries.
+    uint32_t                   WorkerPoolId;         /// The identifier of the task pool type allocated by each worker thread.
+    unsigned int              *WorkerThreadIds;      /// An array of MaxWorkerThreadCount values specifying the operating system thread identifier for each active worker thread.
+    HANDLE                    *WorkerThreadHandle;   /// An array of MaxWorkerThreadCount values specifying the operating system thread handle for each active worker thread.
+    HANDLE                    *WorkerThreadReady;    /// An array of MaxWorkerThreadCount values specifying the manual-reset event signaled by each active worker to indicate that it is ready to run.
+    HANDLE                    *WorkerThreadError;    /// An array of MaxWorkerThreadCount values specifying the manual-reset event signaled by each active worker to indicate a fatal error has occurred.
+    HANDLE                    *WorkerThreadPort;     /// An array of MaxWorkerThreadCount values specifying the I/O completion port used to wait and wake worker threads in the pool. Ports outlive retired workers.
+    OS_TASK_WORKER_STATS      *WorkerThreadStats;    /// An array of MaxWorkerThreadCount per-worker statistics used by OsUpdateWorkerThreadCount.
+    CRITICAL_SECTION           WorkerControlLock;    /// Serializes changes to the set of active worker threads.
+    uint64_t                   ScalingSampleTime;    /// The timestamp, in ticks, of the last sample taken by OsUpdateWorkerThreadCount.
+    uint64_t                   ScalingIdleTotal;     /// The total worker idle time, in nanoseconds, at ScalingSampleTime.
+
+    OS_CONCURRENT_ARENA        GlobalMemoryArena;    /// The global memory arena, shared between all task pools.
     OS_IO_THREAD_POOL         *IoThreadPool;         /// The thread pool to use for executing I/O reqests.
     OS_CPU_INFO                HostCpuInfo;          /// Information about the host CPU.
     uintptr_t                  TaskContextData;      /// An opaque value to be passed through to each task when it executes.
+    bool                       PrefaultMemory;       /// If true, each worker thread populates its local memory with physical pages when it starts.
 
     OS_TASK_PROFILER           TaskProfiler;         /// The task profiler associated with the thread pool.
 
@@ -717,12 +1323,27 @@ struct OS_TASK_POOL_INIT
 struct OS_TASK_SCHEDULER_INIT
 {
     OS_HOST_MEMORY_POOL       *SchedulerMemoryPool;  /// The pool from which host memory is allocated for scheduler global and local memory.
-    size_t                     WorkerThreadCount;    /// The number of worker threads dedicated to executing tasks.
+    size_t                     WorkerThreadCount;    /// The number of worker threads dedicated to executing tasks, launched when the scheduler is created.
+    size_t                     MaxWorkerThreadCount; /// The maximum number of worker threads that can be active at once. If zero, WorkerThreadCount is used and the worker count cannot grow.
     size_t                     GlobalMemorySize;     /// The size of the global memory arena, in bytes. Global memory is shared between all task pools. This value may be zero.
+    size_t                     GlobalMemoryChunkSize;/// The number of bytes of global memory handed out to each thread at once, or zero to use OS_CONCURRENT_ARENA::DEFAULT_CHUNK_SIZE.
     size_t                     PoolTypeCount;        /// The number of items in the TaskPoolTypes array.
     OS_TASK_POOL_INIT         *TaskPoolTypes;        /// An array of one or more OS_TASK_POOL_INIT structures used to define the task pools.
     OS_IO_THREAD_POOL         *IoThreadPool;         /// The thread pool to use for executing I/O requests.
     uintptr_t                  TaskContextData;      /// An opaque value to be passed through to each task when it executes.
+    bool                       PrefaultMemory;       /// If true, global memory is populated with physical pages when the scheduler is created, and each worker populates its local memory when it starts.
+};
+
+/// @summary Define the parameters of the automatic worker scaling policy applied by OsUpdateWorkerThreadCount.
+/// At most one worker is added or retired per call, unless the active count is outside of the policy limits, and no decision is made until MinIntervalMs has elapsed since the previous one.
+struct OS_TASK_SCHEDULER_SCALING_POLICY
+{
+    size_t                     MinWorkerThreads;     /// The minimum number of active worker threads. Values less than one are treated as one, and values greater than the maximum are treated as the maximum.
+    size_t                     MaxWorkerThreads;     /// The maximum number of active worker threads, or zero to use OS_TASK_SCHEDULER::MaxWorkerThreadCount. This value is clamped to OS_TASK_SCHEDULER::MaxWorkerThreadCount.
+    uint32_t                   GrowQueueDepth;       /// Add a worker when the number of ready-to-run tasks per active worker exceeds this value...
+    uint32_t                   GrowIdlePercent;      /// ...and the active workers were idle for less than this percentage of the sample interval.
+    uint32_t                   ShrinkIdlePercent;    /// Retire a worker when no tasks are ready-to-run and the active workers were idle for more than this percentage of the sample interval.
+    uint32_t                   MinIntervalMs;        /// The minimum sample interval, in milliseconds.
 };
 
 /// @summary Define a scope-based object used for reporting the execution duration for a task.
@@ -781,9 +1402,34 @@ struct OS_WORKER_THREAD
     void                 *PoolContext;               /// The opaque, application-specific data passed through to the thread.
     void                 *ThreadContext;             /// The opaque, application-specific data created by the OS_WORKER_INIT callback for the thread.
     size_t                ArenaSize;                 /// The size of the thread-local memory arena, in bytes.
+    size_t                WorkerIndex;               /// The zero-based index of the worker within the pool. This is also the index of the worker's local work item queue.
     unsigned int          ThreadId;                  /// The operating system identifier for the thread.
 };
 
+/// @summary Define a single slot in a worker-local work item queue.
+struct OS_WORKER_QUEUE_CELL
+{   typedef std::atomic<size_t>        atomic_size_t;/// An unsigned size_t value that can be read and written atomically.
+    atomic_size_t       Sequence;                    /// The sequence number used to determine whether the cell is available for writing (== position) or reading (== position + 1).
+    uintptr_t           WorkItem;                    /// The application-defined work item value stored in the cell.
+};
+
+/// @summary Define the data associated with a bounded queue of work items owned by a single thread pool worker.
+/// Any thread may enqueue items, and any worker may dequeue items; the owning worker drains its own queue first and other workers steal from it when their own queues are empty.
+#pragma warning(push)
+#pragma warning(disable:4324)                        /// Structure was padded due to __declspec(align())
+struct OS_CACHELINE_ALIGN OS_WORKER_QUEUE
+{   typedef std::atomic<size_t>        atomic_size_t;/// An unsigned size_t value that can be read and written atomically.
+    static size_t const DEFAULT_CAPACITY = 256;      /// The capacity of each worker queue when OS_THREAD_POOL_INIT::QueueCapacity is OS_WORKER_QUEUE_CAPACITY_DEFAULT.
+    static size_t const PADDING_BYTES  = OS_CACHELINE_SIZE - sizeof(atomic_size_t);
+    atomic_size_t       EnqueuePos;                  /// The position of the next cell to be written, updated by submitting threads.
+    uint8_t             Pad0[PADDING_BYTES];         /// Padding separating the producer and consumer ends of the queue.
+    atomic_size_t       DequeuePos;                  /// The position of the next cell to be read, updated by the owning worker and stealing workers.
+    uint8_t             Pad1[PADDING_BYTES];         /// Padding separating the consumer end and shared data.
+    size_t              Mask;                        /// The bitmask used to map the EnqueuePos and DequeuePos values into the storage array.
+    OS_WORKER_QUEUE_CELL *Cells;                     /// The storage array, of Mask+1 cells.
+};
+#pragma warning(pop)
+
 /// @summary Define the signature for the callback invoked during worker thread initialization to allow the application to create any per-thread resources.
 /// @param thread_args An OS_WORKER_THREAD instance specifying worker thread data. The callback should set the ThreadContext field to its private data.
 /// @return Zero if initialization was successful, or -1 to terminate the worker thread.
@@ -809,13 +1455,20 @@ struct OS_WORKER_THREAD_INIT
     void               *PoolContext;                 /// Opaque application-supplied data to pass through to AppThreadMain.
     size_t              StackSize;                   /// The stack size of the worker thread, in bytes, or OS_WORKER_THREAD_STACK_DEFAULT.
     size_t              ArenaSize;                   /// The size of the thread-local memory arena, in bytes.
+    size_t              WorkerIndex;                 /// The zero-based index of the worker within the pool.
     uint32_t            NUMAGroup;                   /// The zero-based index of the NUMA processor group on which the worker thread will be scheduled.
 };
 
 /// @summary Define the data maintained by a pool of worker threads.
 struct OS_THREAD_POOL
-{
+{   typedef std::atomic<size_t>        atomic_size_t;/// An unsigned size_t value that can be read and written atomically.
+    typedef std::atomic<uint32_t>      atomic_u32_t; /// A 32-bit unsigned integer value that can be read and written atomically.
     size_t              ActiveThreads;               /// The number of currently active threads in the pool.
+    size_t              QueueCount;                  /// The number of worker-local work item queues. This is the number of worker threads the pool was created with.
+    OS_WORKER_QUEUE    *WorkerQueues;                /// The local work item queue for each worker thread.
+    atomic_size_t       IdleThreads;                 /// The number of workers blocked (or about to block) on the completion port that have not yet been claimed by a submitter.
+    atomic_size_t       NextQueue;                   /// The index of the worker queue that receives the next batch submitted from outside the pool.
+    atomic_u32_t        Terminating;                 /// Set to non-zero when the pool begins shutting down. Workers stop draining their queues once this is set.
     unsigned int       *OSThreadIds;                 /// The operating system thread identifier for each active worker thread.
     HANDLE             *OSThreadHandle;              /// The operating system thread handle for each active worker thread.
     HANDLE             *WorkerReady;                 /// The manual-reset event signaled by each active worker to indicate that it is ready to run.
@@ -835,6 +1488,7 @@ struct OS_THREAD_POOL_INIT
     size_t              ThreadCount;                 /// The number of worker threads to create.
     size_t              StackSize;                   /// The stack size for each worker thread, in bytes, or OS_WORKER_THREAD_STACK_DEFAULT.
     size_t              ArenaSize;                   /// The size of the per-thread memory arena, in bytes.
+    size_t              QueueCapacity;               /// The capacity of each worker-local work item queue. This value must be a power of two, or OS_WORKER_QUEUE_CAPACITY_DEFAULT.
     uint32_t            NUMAGroup;                   /// The zero-based index of the NUMA processor group on which the worker threads will be scheduled. Set to 0.
 };
 
@@ -885,7 +1539,46 @@ struct OS_FILE_DATA
     int64_t             DataSize;                    /// The number of bytes in Buffer that are valid.
     uint32_t            Flags;                       /// One or more of OS_FILE_DATA_FLAGS describing the allocation attributes of the OS_FILE_DATA.
 };
+#endif /* !defined(__linux__) */
+
+/// @summary Define a pointer stored as a signed byte offset from its own address. Data structures built in an OS_HOST_MEMORY_ARENA 
+/// that link their nodes with OS_RELATIVE_PTR instead of raw pointers remain valid wherever the arena contents are mapped, so they 
+/// can be written with OsWriteArenaSnapshot and used in place after OsLoadArenaSnapshot, without a fix-up pass.
+/// @typeparam T The type of the object pointed to.
+template <typename T>
+struct OS_RELATIVE_PTR
+{
+    int64_t             Offset;                      /// The byte offset from the address of this field to the target object, or zero for a NULL pointer.
+};
+
+/// @summary Define the header written at the start of an arena snapshot file. All fields are validated before the snapshot data is used.
+struct OS_ARENA_SNAPSHOT_HEADER
+{
+    uint32_t            Magic;                       /// The value OS_ARENA_SNAPSHOT_MAGIC. This field is written last, so an incomplete file is never accepted.
+    uint16_t            Version;                     /// The value OS_ARENA_SNAPSHOT_VERSION at the time the file was written.
+    uint16_t            HeaderSize;                  /// The size of the OS_ARENA_SNAPSHOT_HEADER, in bytes.
+    uint16_t            PointerSize;                 /// The size of a pointer in the process that wrote the file, in bytes.
+    uint16_t            Reserved;                    /// Reserved for future use. Set to zero.
+    uint32_t            ByteOrder;                   /// The value 0x01020304, as stored by the process that wrote the file.
+    uint64_t            DataOffset;                  /// The byte offset of the arena data from the start of the file. This is a multiple of OS_ARENA_SNAPSHOT_DATA_ALIGNMENT.
+    uint64_t            DataSize;                    /// The number of bytes of arena data. The file size is DataOffset + DataSize.
+    uint64_t            RootOffset;                  /// The byte offset of the root object from the start of the arena data, or OS_ARENA_SNAPSHOT_NO_ROOT.
+    uint64_t            UserTag;                     /// An application-defined value identifying the layout of the data, which must match when the snapshot is loaded.
+    uint64_t            Checksum;                    /// The value returned by OsArenaSnapshotChecksum for the arena data.
+};
+
+/// @summary Define the data associated with an arena snapshot mapped into the process address space.
+struct OS_ARENA_SNAPSHOT
+{
+    void               *MapPtr;                      /// The address returned by MapViewOfFile, which is also the address of the OS_ARENA_SNAPSHOT_HEADER.
+    uint8_t            *BaseAddress;                 /// The address of the first byte of arena data. Arena offset zero maps to this address.
+    void               *Root;                        /// The address of the root object, or NULL if no root object was specified when the snapshot was written.
+    size_t              DataSize;                    /// The number of bytes of arena data.
+    uint64_t            UserTag;                     /// The application-defined value stored with the snapshot.
+    uint32_t            Flags;                       /// One or more of OS_ARENA_SNAPSHOT_FLAGS specified when the snapshot was loaded.
+};
 
+#if !defined(__linux__)
 /// @summary Define the data used to execute a low-level I/O operation. Not all data is used by all operations.
 struct OS_IO_OPERATION
 {
@@ -1459,6 +2152,7 @@ enum OS_TASK_POOL_ERROR               : int32_t
     OS_TASK_POOL_ERROR_INVALID_THREAD = 4,           /// The task could not be defined because the thread calling DefineTask does not match the thread that allocated the task pool.
     OS_TASK_POOL_ERROR_INVALID_PARENT = 5,           /// The task could not be defined because the parent task ID is invalid.
     OS_TASK_POOL_ERROR_INVALID_DATA   = 6,           /// The task could not be defined because no per-task parameter data was supplied.
+    OS_TASK_POOL_ERROR_INVALID_TARGET = 7,           /// The task could not be defined because the target task pool index is invalid, or the target task pool is not owned by a thread.
 };
 
 /// @summary Define the valid values for a task data slot marker.
@@ -1488,6 +2182,12 @@ enum OS_WORKER_THREAD_STACK_SIZE     : size_t
     OS_WORKER_THREAD_STACK_DEFAULT   = 0,            /// Use the default stack size for each worker thread.
 };
 
+/// @summary Define constants for specifying the capacity of the worker-local work item queues in a thread pool.
+enum OS_WORKER_QUEUE_CAPACITY        : size_t
+{
+    OS_WORKER_QUEUE_CAPACITY_DEFAULT = 0,            /// Use OS_WORKER_QUEUE::DEFAULT_CAPACITY items per worker.
+};
+
 /// @summary Define the set of return codes expected from the OS_WORKER_INIT callback.
 enum OS_WORKER_THREAD_INIT_RESULT    : int
 {
@@ -1554,6 +2254,7 @@ enum OS_VULKAN_LOADER_RESULT         : int
     OS_VULKAN_LOADER_RESULT_NOENTRY  =-3,            /// One or more required Vulkan API entry points are missing.
     OS_VULKAN_LOADER_RESULT_VKERROR  =-4,            /// A Vulkan API call returned an error.
 };
+#endif /* !defined(__linux__) */
 
 /// @summary Define flags that can be bitwise OR'd to specify the attributes of a host memory allocation.
 enum OS_HOST_MEMORY_ALLOCATION_FLAGS  : uint32_t
@@ -1563,9 +2264,62 @@ enum OS_HOST_MEMORY_ALLOCATION_FLAGS  : uint32_t
     OS_HOST_MEMORY_ALLOCATION_FLAG_WRITE         = (1 << 1), /// The memory is writable by the host.
     OS_HOST_MEMORY_ALLOCATION_FLAG_EXECUTE       = (1 << 2), /// The memory is will contain dynamically-generated executable code.
     OS_HOST_MEMORY_ALLOCATION_FLAG_NO_GUARD_PAGE = (1 << 3), /// The memory allocation will not end with a trailing guard page.
+    OS_HOST_MEMORY_ALLOCATION_FLAG_LARGE_PAGES   = (1 << 4), /// The memory allocation should be backed by large (huge) pages if possible. Check OS_HOST_MEMORY_ALLOCATION::PageSize.
     OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE    = OS_HOST_MEMORY_ALLOCATION_FLAG_READ | OS_HOST_MEMORY_ALLOCATION_FLAG_WRITE,
 };
 
+/// @summary Define the policies controlling the NUMA node(s) from which the physical memory backing a host memory allocation is taken.
+enum OS_HOST_MEMORY_NUMA_POLICY       : uint32_t
+{
+    OS_HOST_MEMORY_NUMA_POLICY_DEFAULT    = 0,       /// Use the operating system default, which typically places each page on the node of the first thread to touch it.
+    OS_HOST_MEMORY_NUMA_POLICY_BIND       = 1,       /// Place physical memory on a specific NUMA node. On Windows, the node is preferred but not guaranteed.
+    OS_HOST_MEMORY_NUMA_POLICY_INTERLEAVE = 2,       /// Interleave physical memory page-by-page across all NUMA nodes. On Windows, this behaves like OS_HOST_MEMORY_NUMA_POLICY_DEFAULT.
+};
+
+/// @summary Define the instruction set extensions that can be used by the bulk memory kernels.
+enum OS_MEMORY_ISA                     : int32_t
+{
+    OS_MEMORY_ISA_AUTO                    =-1,       /// Select the most capable instruction set supported by the host CPU and operating system.
+    OS_MEMORY_ISA_SSE2                    = 0,       /// Use 128-bit SSE2 kernels. Supported by every x64 CPU.
+    OS_MEMORY_ISA_AVX2                    = 1,       /// Use 256-bit AVX2 kernels.
+    OS_MEMORY_ISA_AVX512                  = 2,       /// Use 512-bit AVX-512F/BW kernels.
+};
+
+/// @summary Define the types of events recorded in an OS_ALLOCATION_TRACE.
+enum OS_ALLOCATION_EVENT               : uint32_t
+{
+    OS_ALLOCATION_EVENT_ALLOCATE          = 0,       /// A block was allocated. Offset and Size describe the block.
+    OS_ALLOCATION_EVENT_FREE              = 1,       /// A block was freed. Offset and Size describe the block.
+    OS_ALLOCATION_EVENT_REALLOCATE        = 2,       /// A block was resized in-place. Offset and Size describe the resized block.
+    OS_ALLOCATION_EVENT_COMMIT            = 3,       /// Additional memory was committed. Offset is the base address and Size is the new commit size.
+    OS_ALLOCATION_EVENT_RESET             = 4,       /// All allocations after Offset were invalidated.
+};
+
+/// @summary Define flags that can be specified when creating an OS_HASH_SET or OS_HASH_MAP.
+enum OS_HASH_TABLE_FLAGS               : uint32_t
+{
+    OS_HASH_TABLE_FLAGS_NONE              = (0 << 0), /// The table grows as needed.
+    OS_HASH_TABLE_FLAG_FIXED_CAPACITY     = (1 << 0), /// The table never grows beyond the capacity reserved when it is created or by an explicit reserve; inserts fail instead.
+};
+
+/// @summary Define the memory pressure levels reported by an OS_MEMORY_BUDGET.
+enum OS_MEMORY_PRESSURE_LEVEL          : uint32_t
+{
+    OS_MEMORY_PRESSURE_LEVEL_NONE         = 0,       /// Estimated usage is below the moderate threshold.
+    OS_MEMORY_PRESSURE_LEVEL_MODERATE     = 1,       /// Estimated usage has reached the moderate threshold. Trim caches and discard speculative data.
+    OS_MEMORY_PRESSURE_LEVEL_CRITICAL     = 2,       /// Estimated usage has reached the critical threshold. Release everything possible and shrink arenas.
+};
+
+/// @summary Define the places from which an OS_MEMORY_BUDGET can obtain its limit.
+enum OS_MEMORY_BUDGET_SOURCE           : uint32_t
+{
+    OS_MEMORY_BUDGET_SOURCE_PHYSICAL      = 0,       /// No container limit applies; the limit is the amount of installed physical memory.
+    OS_MEMORY_BUDGET_SOURCE_OVERRIDE      = 1,       /// The limit was specified by OS_MEMORY_BUDGET_INIT::LimitOverride.
+    OS_MEMORY_BUDGET_SOURCE_CGROUP        = 2,       /// The limit is the smallest cgroup v2 memory.max of the cgroup containing the process and its ancestors.
+    OS_MEMORY_BUDGET_SOURCE_JOB_OBJECT    = 3,       /// The limit is the process or job memory limit of the job object containing the process.
+};
+
+#if !defined(__linux__)
 /// @summary Define the valid flags that can be specified to define the usage for an OS_TASK_POOL. Valid combinations are:
 /// OS_TASK_POOL_USAGE_FLAG_DEFINE | OS_TASK_USAGE_FLAG_PUBLISH: The thread defines tasks to be stolen and executed on worker threads.
 /// OS_TASK_POOL_USAGE_FLAG_DEFINE | OS_TASK_USAGE_FLAG_EXECUTE: The thread defines tasks and can also execute tasks manually.
@@ -1601,7 +2355,17 @@ enum OS_FILE_DATA_FLAGS              : uint32_t
     OS_FILE_DATA_FLAG_COMMITTED      = (1 << 0),      /// The OS_FILE_DATA buffer is an explicitly allocated region of memory.
     OS_FILE_DATA_FLAG_MAPPED_REGION  = (1 << 1),      /// The OS_FILE_DATA represents a mapped region of a file.
 };
+#endif /* !defined(__linux__) */
+
+/// @summary Define flags controlling how an arena snapshot is mapped into memory.
+enum OS_ARENA_SNAPSHOT_FLAGS         : uint32_t
+{
+    OS_ARENA_SNAPSHOT_FLAGS_NONE           = (0 << 0),/// The arena data is mapped read-only. Writes to the data raise an access violation.
+    OS_ARENA_SNAPSHOT_FLAG_COPY_ON_WRITE   = (1 << 0),/// The arena data is mapped copy-on-write. Modified pages are private to the process and are never written back to the file.
+    OS_ARENA_SNAPSHOT_FLAG_VERIFY_CHECKSUM = (1 << 1),/// Verify the checksum of the arena data. This reads every page of the file, so it is best reserved for untrusted or newly-written files.
+};
 
+#if !defined(__linux__)
 /// @summary Define flags used to optimize asynchronous I/O operations. The usage hints are specified when the file is opened.
 enum OS_IO_HINT_FLAGS                : uint32_t
 {
@@ -1754,10 +2518,12 @@ OS_LAYER_DECLARE_RUNTIME_FUNCTION(DWORD, WINAPI, XInputGetState             , DW
 OS_LAYER_DECLARE_RUNTIME_FUNCTION(DWORD, WINAPI, XInputSetState             , DWORD, XINPUT_VIBRATION*);                  // XInput1_4.dll
 OS_LAYER_DECLARE_RUNTIME_FUNCTION(DWORD, WINAPI, XInputGetCapabilities      , DWORD, DWORD, XINPUT_CAPABILITIES*);        // XInput1_4.dll
 //OS_LAYER_DECLARE_RUNTIME_FUNCTION(DWORD, WINAPI, XInputGetBatteryInformation, DWORD, BYTE , XINPUT_BATTERY_INFORMATION*); // XInput1_4.dll
+#endif /* !defined(__linux__) */
 
 /*///////////////
 //   Globals   //
 ///////////////*/
+#if !defined(__linux__)
 /// @summary Function pointers for the set of functions resolved at runtime.
 OS_LAYER_DEFINE_RUNTIME_FUNCTION(XInputEnable);
 OS_LAYER_DEFINE_RUNTIME_FUNCTION(XInputGetState);
@@ -1771,8 +2537,45 @@ global_variable HMODULE         XInputDll = NULL;
 /// @summary OVERLAPPED_ENTRY::lpCompletionKey is set to OS_IO_COMPLETION_KEY_SHUTDOWN to terminate the asynchronous I/O thread loop.
 global_variable ULONG_PTR const OS_COMPLETION_KEY_SHUTDOWN = ~ULONG_PTR(0);
 
+/// @summary OVERLAPPED_ENTRY::lpCompletionKey is set to OS_COMPLETION_KEY_WORK_QUEUED to wake an idle thread pool worker after work items are added to the worker queues.
+global_variable ULONG_PTR const OS_COMPLETION_KEY_WORK_QUEUED = ~ULONG_PTR(1);
+
+/// @summary OVERLAPPED_ENTRY::lpCompletionKey is set to OS_COMPLETION_KEY_TASK_MAILBOX to wake a task scheduler worker after a thread-affine task is delivered to its mailbox.
+global_variable ULONG_PTR const OS_COMPLETION_KEY_TASK_MAILBOX = ~ULONG_PTR(2);
+
+/// @summary OVERLAPPED_ENTRY::lpCompletionKey is set to OS_COMPLETION_KEY_RETIRE to retire a single task scheduler worker. The worker returns its task pool once every task defined in the pool has completed.
+global_variable ULONG_PTR const OS_COMPLETION_KEY_RETIRE = ~ULONG_PTR(3);
+
 /// @summary The GUID of the Win32 OS Layer task profiler provider {349CE0E9-6DF5-4C25-AC5B-C84F529BC0CE}.
 global_variable GUID      const TaskProfilerGUID = { 0x349ce0e9, 0x6df5, 0x4c25, { 0xac, 0x5b, 0xc8, 0x4f, 0x52, 0x9b, 0xc0, 0xce } };
+#endif /* !defined(__linux__) */
+
+/// @summary The allocation trace receiving allocator events, or NULL if allocation tracing is disabled.
+global_variable OS_ALLOCATION_TRACE *AllocationTrace = NULL;
+
+/// @summary The memory budget charged for commits made through the host memory APIs, or NULL if no budget is active.
+global_variable OS_MEMORY_BUDGET    *MemoryBudget = NULL;
+
+/// @summary The number of slots in an OS_HASH_SET or OS_HASH_MAP group. The control bytes of a group are compared with a single SSE2 instruction.
+global_variable size_t  const        OS_HASH_GROUP_WIDTH   = 16;
+
+/// @summary The control byte value marking a hash table slot that has never been filled since the table was last cleared or rehashed.
+global_variable uint8_t const        OS_HASH_CONTROL_EMPTY = 0x80;
+
+/// @summary The control byte value marking a hash table slot whose key was removed. Full slots store seven bits of the hash, with the high bit clear.
+global_variable uint8_t const        OS_HASH_CONTROL_DELETED = 0xFE;
+
+/// @summary The value stored in OS_ARENA_SNAPSHOT_HEADER::Magic, the characters 'ASNP' read as a little-endian integer.
+global_variable uint32_t const       OS_ARENA_SNAPSHOT_MAGIC = 0x504E5341UL;
+
+/// @summary The current version of the arena snapshot file format.
+global_variable uint16_t const       OS_ARENA_SNAPSHOT_VERSION = 1;
+
+/// @summary The alignment of the arena data within a snapshot file. Arena allocations aligned to at most this value remain aligned when the snapshot is mapped.
+global_variable uint64_t const       OS_ARENA_SNAPSHOT_DATA_ALIGNMENT = 4096;
+
+/// @summary The value stored in OS_ARENA_SNAPSHOT_HEADER::RootOffset when the snapshot has no root object.
+global_variable uint64_t const       OS_ARENA_SNAPSHOT_NO_ROOT = ~0ULL;
 
 /*////////////////////////////
 //   Forward Declarations   //
@@ -1782,18 +2585,39 @@ public_function void                       OsSecureZeroMemory(void *dst, size_t
 public_function void                       OsCopyMemory(void * __restrict dst, void const * __restrict src, size_t len);
 public_function void                       OsMoveMemory(void *dst, void const *src, size_t len);
 public_function void                       OsFillMemory(void *dst, size_t len, uint8_t val);
+public_function int                        OsCompareMemory(void const *a, void const *b, size_t len);
+public_function int32_t                    OsSelectMemoryRoutines(int32_t instruction_set, size_t streaming_threshold);
+public_function void                       OsQueryMemoryRoutines(OS_MEMORY_ROUTINES *routines);
 public_function size_t                     OsAlignUp(size_t size, size_t pow2);
 public_function OS_MEMORY_RANGE            OsInitHostMemoryRange(void *addr, size_t size);
 public_function OS_MEMORY_RANGE            OsInitHostMemoryRange(OS_HOST_MEMORY_ALLOCATION *memory);
 public_function int                        OsCreateHostMemoryPool(OS_HOST_MEMORY_POOL *pool, OS_HOST_MEMORY_POOL_INIT *init);
 public_function void                       OsDeleteHostMemoryPool(OS_HOST_MEMORY_POOL *pool);
 public_function OS_HOST_MEMORY_ALLOCATION* OsHostMemoryPoolAllocate(OS_HOST_MEMORY_POOL *pool, size_t reserve_size, size_t commit_size, uint32_t alloc_flags);
+public_function OS_HOST_MEMORY_ALLOCATION* OsHostMemoryPoolAllocate(OS_HOST_MEMORY_POOL *pool, size_t reserve_size, size_t commit_size, uint32_t alloc_flags, uint32_t numa_policy, uint32_t numa_node);
 public_function void                       OsHostMemoryPoolRelease(OS_HOST_MEMORY_POOL *pool, OS_HOST_MEMORY_ALLOCATION *alloc);
 public_function void                       OsHostMemoryPoolReset(OS_HOST_MEMORY_POOL *pool);
 public_function int                        OsHostMemoryReserveAndCommit(OS_HOST_MEMORY_ALLOCATION *alloc, size_t reserve_size, size_t commit_size, uint32_t alloc_flags);
+public_function int                        OsHostMemoryReserveAndCommit(OS_HOST_MEMORY_ALLOCATION *alloc, size_t reserve_size, size_t commit_size, uint32_t alloc_flags, uint32_t numa_policy, uint32_t numa_node);
 public_function int                        OsHostMemoryIncreaseCommitment(OS_HOST_MEMORY_ALLOCATION *alloc, size_t commit_size);
 public_function void                       OsHostMemoryFlush(OS_HOST_MEMORY_ALLOCATION *alloc);
 public_function void                       OsHostMemoryRelease(OS_HOST_MEMORY_ALLOCATION *alloc);
+public_function void                       OsHostMemoryPoolQueryStats(OS_HOST_MEMORY_POOL *pool, OS_ALLOCATOR_STATS *stats);
+public_function int32_t                    OsHostMemoryQueryNumaNode(void const *address);
+public_function bool                       OsHostMemoryPrefault(void *address, size_t size);
+public_function bool                       OsHostMemoryPrefaultParallel(void *address, size_t size, size_t thread_count, int32_t numa_node);
+public_function bool                       OsHostMemoryPrefaultParallel(OS_HOST_MEMORY_ALLOCATION *alloc, size_t thread_count);
+public_function int                        OsCreateAllocationTrace(OS_ALLOCATION_TRACE *trace, size_t capacity);
+public_function void                       OsDeleteAllocationTrace(OS_ALLOCATION_TRACE *trace);
+public_function OS_ALLOCATION_TRACE*       OsSetAllocationTrace(OS_ALLOCATION_TRACE *trace);
+public_function size_t                     OsAllocationTraceRead(OS_ALLOCATION_TRACE *trace, uint64_t &read_index, OS_ALLOCATION_TRACE_RECORD *records, size_t max_records);
+public_function int                        OsCreateMemoryBudget(OS_MEMORY_BUDGET *budget, OS_MEMORY_BUDGET_INIT const *init);
+public_function void                       OsDeleteMemoryBudget(OS_MEMORY_BUDGET *budget);
+public_function OS_MEMORY_BUDGET*          OsSetMemoryBudget(OS_MEMORY_BUDGET *budget);
+public_function int                        OsMemoryBudgetRegisterCallback(OS_MEMORY_BUDGET *budget, uint32_t level, OS_MEMORY_PRESSURE_FUNC callback, void *context);
+public_function void                       OsMemoryBudgetUnregisterCallback(OS_MEMORY_BUDGET *budget, OS_MEMORY_PRESSURE_FUNC callback, void *context);
+public_function uint32_t                   OsMemoryBudgetUpdate(OS_MEMORY_BUDGET *budget);
+public_function void                       OsMemoryBudgetQuery(OS_MEMORY_BUDGET *budget, OS_MEMORY_BUDGET_STATUS *status);
 public_function int                        OsCreateArenaAllocator(OS_ARENA_ALLOCATOR *alloc, size_t size_in_bytes);
 public_function void                       OsDeleteArenaAllocator(OS_ARENA_ALLOCATOR *alloc);
 public_function bool                       OsArenaAllocatorCanSatisfyAllocation(OS_ARENA_ALLOCATOR *alloc, size_t size, size_t alignment);
@@ -1801,13 +2625,32 @@ public_function bool                       OsArenaAllocate(OS_ARENA_ALLOCATOR *a
 public_function os_arena_marker_t          OsArenaMark(OS_ARENA_ALLOCATOR *alloc);
 public_function void                       OsArenaResetToMarker(OS_ARENA_ALLOCATOR *alloc, os_arena_marker_t marker);
 public_function void                       OsArenaReset(OS_ARENA_ALLOCATOR *alloc);
+public_function void                       OsArenaAllocatorQueryStats(OS_ARENA_ALLOCATOR *alloc, OS_ALLOCATOR_STATS *stats);
 public_function int                        OsCreateBuddyAllocator(OS_BUDDY_ALLOCATOR *alloc, OS_BUDDY_ALLOCATOR_INIT *init);
 public_function void                       OsDeleteBuddyAllocator(OS_BUDDY_ALLOCATOR *alloc);
 public_function bool                       OsBuddyAllocate(OS_BUDDY_ALLOCATOR *alloc, size_t size, size_t alignment, OS_MEMORY_RANGE &range);
-public_function bool                       OsBuddyReallocate(OS_BUDDY_ALLOCATOR *alloc, OS_MEMORY_RANGE existing, size_t required_size, OS_MEMORY_RANGE &range);
+public_function bool                       OsBuddyReallocate(OS_BUDDY_ALLOCATOR *alloc, OS_MEMORY_RANGE existing, size_t new_size, size_t alignment, OS_MEMORY_RANGE &range);
+public_function bool                       OsBuddyAllocatorBlockInfo(OS_BUDDY_BLOCK_INFO *info, OS_BUDDY_ALLOCATOR *alloc, uint64_t block_offset);
 public_function size_t                     OsBuddyBlockSize(OS_BUDDY_ALLOCATOR *alloc, size_t block_offset);
 public_function void                       OsBuddyFree(OS_BUDDY_ALLOCATOR *alloc, OS_MEMORY_RANGE range);
 public_function void                       OsBuddyReset(OS_BUDDY_ALLOCATOR *alloc);
+public_function void                       OsBuddyAllocatorQueryStats(OS_BUDDY_ALLOCATOR *alloc, OS_ALLOCATOR_STATS *stats);
+public_function bool                       OsBuddyCompact(OS_BUDDY_ALLOCATOR *alloc, OS_BUDDY_RELOCATE_FUNC relocate, void *context, uint64_t max_bytes, OS_BUDDY_COMPACT_RESULT *result);
+public_function int                        OsCreateConcurrentBuddyAllocator(OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, OS_BUDDY_ALLOCATOR_INIT *init);
+public_function void                       OsDeleteConcurrentBuddyAllocator(OS_CONCURRENT_BUDDY_ALLOCATOR *alloc);
+public_function bool                       OsConcurrentBuddyAllocate(OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, OS_BUDDY_THREAD_CACHE *cache, size_t size, size_t alignment, OS_MEMORY_RANGE &range);
+public_function bool                       OsConcurrentBuddyReallocate(OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, OS_BUDDY_THREAD_CACHE *cache, OS_MEMORY_RANGE existing, size_t new_size, size_t alignment, OS_MEMORY_RANGE &range);
+public_function void                       OsConcurrentBuddyFree(OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, OS_BUDDY_THREAD_CACHE *cache, OS_MEMORY_RANGE range);
+public_function void                       OsConcurrentBuddyFlushCache(OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, OS_BUDDY_THREAD_CACHE *cache);
+public_function void                       OsConcurrentBuddyTrim(OS_CONCURRENT_BUDDY_ALLOCATOR *alloc);
+public_function void                       OsConcurrentBuddyReset(OS_CONCURRENT_BUDDY_ALLOCATOR *alloc);
+public_function int                        OsCreateTlsfAllocator(OS_TLSF_ALLOCATOR *alloc, OS_MEMORY_RANGE host_memory);
+public_function bool                       OsTlsfAllocate(OS_TLSF_ALLOCATOR *alloc, size_t size, size_t alignment, OS_MEMORY_RANGE &range);
+public_function bool                       OsTlsfReallocate(OS_TLSF_ALLOCATOR *alloc, OS_MEMORY_RANGE existing, size_t new_size, size_t alignment, OS_MEMORY_RANGE &range);
+public_function size_t                     OsTlsfBlockSize(OS_TLSF_ALLOCATOR *alloc, size_t block_offset);
+public_function void                       OsTlsfFree(OS_TLSF_ALLOCATOR *alloc, OS_MEMORY_RANGE range);
+public_function void                       OsTlsfReset(OS_TLSF_ALLOCATOR *alloc);
+public_function void                       OsTlsfAllocatorQueryStats(OS_TLSF_ALLOCATOR *alloc, OS_ALLOCATOR_STATS *stats);
 public_function int                        OsCreateHostMemoryArena(OS_HOST_MEMORY_ARENA *arena, OS_MEMORY_RANGE host_memory);
 public_function void                       OsDeleteHostMemoryArena(OS_HOST_MEMORY_ARENA *arena);
 public_function bool                       OsHostMemoryArenaCanSatisfyAllocation(OS_HOST_MEMORY_ARENA *arena, size_t size, size_t alignment);
@@ -1815,6 +2658,54 @@ public_function void*                      OsHostMemoryArenaAllocate(OS_HOST_MEM
 public_function os_arena_marker_t          OsHostMemoryArenaMark(OS_HOST_MEMORY_ARENA *arena);
 public_function void                       OsHostMemoryArenaResetToMarker(OS_HOST_MEMORY_ARENA *arena, os_arena_marker_t arena_marker);
 public_function void                       OsHostMemoryArenaReset(OS_HOST_MEMORY_ARENA *arena);
+public_function size_t                     OsHostMemoryArenaHighWaterMark(OS_HOST_MEMORY_ARENA *arena);
+public_function size_t                     OsHostMemoryArenaTrim(OS_HOST_MEMORY_ARENA *arena, size_t watermark, size_t hysteresis);
+public_function size_t                     OsHostMemoryArenaTrimToHighWaterMark(OS_HOST_MEMORY_ARENA *arena, size_t hysteresis);
+public_function void                       OsHostMemoryArenaQueryStats(OS_HOST_MEMORY_ARENA *arena, OS_ALLOCATOR_STATS *stats);
+public_function uint64_t                   OsHashKey(uint64_t key);
+public_function uint64_t                   OsHashKey(int64_t key);
+public_function uint64_t                   OsHashKey(uint32_t key);
+public_function uint64_t                   OsHashKey(int32_t key);
+public_function uint64_t                   OsHashKey(void const *key);
+public_function uint64_t                   OsHashKey(char const *key);
+public_function bool                       OsHashKeyEqual(char const * const &a, char const * const &b);
+public_function int                        OsCreateFrameArena(OS_FRAME_ARENA *arena, OS_MEMORY_RANGE host_memory, uint32_t generation_count);
+public_function void                       OsDeleteFrameArena(OS_FRAME_ARENA *arena);
+public_function bool                       OsFrameArenaBeginFrame(OS_FRAME_ARENA *arena, uint64_t timeout_ns);
+#if !defined(__linux__)
+public_function void                       OsFrameArenaEndFrame(OS_FRAME_ARENA *arena, OS_TASK_FENCE *fence);
+#endif /* !defined(__linux__) */
+public_function void                       OsFrameArenaEndFrame(OS_FRAME_ARENA *arena, OS_FRAME_FENCE_WAIT fence_wait, void *fence_context);
+public_function void*                      OsFrameArenaAllocate(OS_FRAME_ARENA *arena, size_t size, size_t alignment);
+public_function bool                       OsFrameArenaQueryStats(OS_FRAME_ARENA *arena, uint32_t frames_ago, OS_ALLOCATOR_STATS *stats);
+public_function int                        OsCreateChainedArena(OS_CHAINED_ARENA *arena, OS_HOST_MEMORY_POOL *pool, size_t block_size, uint32_t alloc_flags);
+public_function void                       OsDeleteChainedArena(OS_CHAINED_ARENA *arena);
+public_function void*                      OsChainedArenaAllocate(OS_CHAINED_ARENA *arena, size_t size, size_t alignment);
+public_function os_arena_marker_t          OsChainedArenaMark(OS_CHAINED_ARENA *arena);
+public_function void                       OsChainedArenaResetToMarker(OS_CHAINED_ARENA *arena, os_arena_marker_t arena_marker);
+public_function void                       OsChainedArenaReset(OS_CHAINED_ARENA *arena);
+public_function void                       OsChainedArenaQueryStats(OS_CHAINED_ARENA *arena, OS_ALLOCATOR_STATS *stats);
+
+public_function int                        OsCreateConcurrentArena(OS_CONCURRENT_ARENA *arena, OS_MEMORY_RANGE host_memory, size_t chunk_size);
+public_function void                       OsDeleteConcurrentArena(OS_CONCURRENT_ARENA *arena);
+public_function void*                      OsConcurrentArenaAllocate(OS_CONCURRENT_ARENA *arena, size_t size, size_t alignment);
+public_function void*                      OsConcurrentArenaAllocate(OS_CONCURRENT_ARENA *arena, OS_CONCURRENT_ARENA_CHUNK *chunk, size_t size, size_t alignment);
+public_function os_arena_marker_t          OsConcurrentArenaMark(OS_CONCURRENT_ARENA *arena);
+public_function void                       OsConcurrentArenaResetToMarker(OS_CONCURRENT_ARENA *arena, os_arena_marker_t arena_marker);
+public_function void                       OsConcurrentArenaReset(OS_CONCURRENT_ARENA *arena);
+public_function int                        OsCreateSlabAllocator(OS_SLAB_ALLOCATOR *alloc, OS_SLAB_ALLOCATOR_INIT *init);
+public_function void                       OsDeleteSlabAllocator(OS_SLAB_ALLOCATOR *alloc);
+public_function void*                      OsSlabAllocate(OS_SLAB_ALLOCATOR *alloc, OS_SLAB_THREAD_CACHE *cache, size_t size);
+public_function void                       OsSlabFree(OS_SLAB_ALLOCATOR *alloc, OS_SLAB_THREAD_CACHE *cache, void *object);
+public_function void                       OsSlabFlushCache(OS_SLAB_ALLOCATOR *alloc, OS_SLAB_THREAD_CACHE *cache);
+public_function int                        OsCreateMagicRingBuffer(OS_MAGIC_RING_BUFFER *ring, size_t capacity);
+public_function void                       OsDeleteMagicRingBuffer(OS_MAGIC_RING_BUFFER *ring);
+public_function void*                      OsMagicRingBufferWriteBegin(OS_MAGIC_RING_BUFFER *ring, size_t &bytes_free);
+public_function void                       OsMagicRingBufferWriteEnd(OS_MAGIC_RING_BUFFER *ring, size_t bytes_written);
+public_function void*                      OsMagicRingBufferReserve(OS_MAGIC_RING_BUFFER *ring, size_t size, uint64_t &cursor);
+public_function void                       OsMagicRingBufferCommit(OS_MAGIC_RING_BUFFER *ring, uint64_t cursor, size_t size);
+public_function void*                      OsMagicRingBufferReadBegin(OS_MAGIC_RING_BUFFER *ring, size_t &bytes_available);
+public_function void                       OsMagicRingBufferReadEnd(OS_MAGIC_RING_BUFFER *ring, size_t bytes_read);
 public_function int                        OsCreateHostMemoryAllocator(OS_HOST_MEMORY_ALLOCATOR *alloc, OS_MEMORY_RANGE host_memory);
 public_function void                       OsDeleteHostMemoryAllocator(OS_HOST_MEMORY_ALLOCATOR *alloc);
 public_function void                       OsHostMemoryAllocatorReset(OS_HOST_MEMORY_ALLOCATOR *alloc);
@@ -1831,9 +2722,12 @@ public_function uint64_t                   OsNanosecondSliceOfSecond(uint64_t fr
 public_function uint64_t                   OsElapsedNanoseconds(uint64_t start_ticks, uint64_t end_ticks);
 public_function uint64_t                   OsMillisecondsToNanoseconds(uint32_t milliseconds);
 public_function uint32_t                   OsNanosecondsToWholeMilliseconds(uint64_t nanoseconds);
+#if !defined(__linux__)
 public_function bool                       OsQueryHostCpuLayout(OS_CPU_INFO *cpu_info, OS_MEMORY_RANGE scratch_mem);
+#endif /* !defined(__linux__) */
 
 public_function uint32_t                   OsThreadId(void);
+#if !defined(__linux__)
 public_function os_task_id_t               OsMakeTaskId(uint32_t type, uint32_t pool, uint32_t index, uint32_t valid);
 public_function bool                       OsIsValidTask(os_task_id_t task_id);
 public_function bool                       OsIsExternalTask(os_task_id_t task_id);
@@ -1841,14 +2735,22 @@ public_function bool                       OsIsInternalTask(os_task_id_t task_id
 public_function unsigned int __cdecl       OsTaskSchedulerThreadMain(void *argp);
 public_function int                        OsCreateTaskScheduler(OS_TASK_SCHEDULER *scheduler, OS_TASK_SCHEDULER_INIT *init, char const *name);
 public_function void                       OsDestroyTaskScheduler(OS_TASK_SCHEDULER *scheduler);
+public_function int                        OsAddWorkerThreads(OS_TASK_SCHEDULER *scheduler, size_t thread_count);
+public_function int                        OsRemoveWorkerThreads(OS_TASK_SCHEDULER *scheduler, size_t thread_count);
+public_function size_t                     OsTaskSchedulerReadyTaskCount(OS_TASK_SCHEDULER *scheduler);
+public_function size_t                     OsUpdateWorkerThreadCount(OS_TASK_SCHEDULER *scheduler, OS_TASK_SCHEDULER_SCALING_POLICY const *policy);
 public_function int                        OsAllocateTaskPool(OS_TASK_ENVIRONMENT *taskenv, OS_TASK_SCHEDULER *scheduler, uint32_t pool_type, uint32_t thread_id);
 public_function void                       OsReturnTaskPool(OS_TASK_ENVIRONMENT *taskenv);
 public_function int                        OsGetTaskPoolError(OS_TASK_ENVIRONMENT *taskenv);
+public_function uint32_t                   OsGetTaskPoolIndex(OS_TASK_ENVIRONMENT *taskenv);
+public_function void                       OsSetTaskMailboxEvent(OS_TASK_ENVIRONMENT *taskenv, HANDLE wake_event);
+public_function size_t                     OsExecuteMailboxTasks(OS_TASK_ENVIRONMENT *taskenv);
 public_function void                       OsSetTaskPoolError(OS_TASK_ENVIRONMENT *taskenv, int last_error);
 public_function void                       OsPublishTasks(OS_TASK_ENVIRONMENT *taskenv, size_t task_count);
 public_function size_t                     OsCompleteTask(OS_TASK_ENVIRONMENT *taskenv, os_task_id_t task_id);
 public_function size_t                     OsFinishTaskDefinition(OS_TASK_ENVIRONMENT *taskenv, os_task_id_t task_id);
 public_function os_task_id_t               OsDefineTask(OS_TASK_ENVIRONMENT *taskenv, uint32_t const task_type, OS_TASK_ENTRYPOINT task_main, void const *task_args, size_t const args_size, os_task_id_t const *dependency_list, size_t const dependency_count);
+public_function os_task_id_t               OsDefineAffineTask(OS_TASK_ENVIRONMENT *taskenv, uint32_t const task_type, OS_TASK_ENTRYPOINT task_main, void const *task_args, size_t const args_size, uint32_t const target_pool, os_task_id_t const *dependency_list, size_t const dependency_count);
 public_function os_task_id_t               OsDefineChildTask(OS_TASK_ENVIRONMENT *taskenv, uint32_t const task_type, OS_TASK_ENTRYPOINT task_main, void const *task_args, size_t const args_size, os_task_id_t const parent_id, os_task_id_t const *dependency_list, size_t const dependency_count);
 public_function void                       OsWaitForTask(OS_TASK_ENVIRONMENT *taskenv, os_task_id_t wait_task);
 public_function int                        OsAllocateTaskFence(OS_TASK_FENCE *fence);
@@ -1858,13 +2760,15 @@ public_function bool                       OsWaitTaskFence(OS_TASK_FENCE *fence,
 public_function os_task_id_t               OsCreateTaskFence(OS_TASK_ENVIRONMENT *taskenv, OS_TASK_FENCE *fence, os_task_id_t const *dependency_list, size_t const dependency_count);
 
 public_function unsigned int __cdecl       OsWorkerThreadMain(void *argp);
-public_function size_t                     OsAllocationSizeForThreadPool(size_t thread_count);
+public_function size_t                     OsAllocationSizeForThreadPool(size_t thread_count, size_t queue_capacity);
 public_function int                        OsCreateThreadPool(OS_THREAD_POOL *pool, OS_THREAD_POOL_INIT *init, OS_HOST_MEMORY_ARENA *arena, char const *name);
 public_function void                       OsLaunchThreadPool(OS_THREAD_POOL *pool);
 public_function void                       OsTerminateThreadPool(OS_THREAD_POOL *pool);
 public_function void                       OsDestroyThreadPool(OS_THREAD_POOL *pool);
 public_function bool                       OsSignalWorkerThreads(OS_WORKER_THREAD *sender, uintptr_t signal_arg, size_t thread_count);
 public_function bool                       OsSignalWorkerThreads(OS_THREAD_POOL *pool, uintptr_t signal_arg, size_t thread_count);
+public_function bool                       OsSubmitWorkItems(OS_WORKER_THREAD *sender, uintptr_t const *work_items, size_t item_count);
+public_function bool                       OsSubmitWorkItems(OS_THREAD_POOL *pool, uintptr_t const *work_items, size_t item_count);
 
 public_function void                       OsResetInputSystem(OS_INPUT_SYSTEM *system);
 public_function void                       OsPushRawInput(OS_INPUT_SYSTEM *system, RAWINPUT const *input);
@@ -1923,6 +2827,10 @@ public_function int                        OsOpenFileMapping(OS_FILE_MAPPING *fi
 public_function void                       OsCloseFileMapping(OS_FILE_MAPPING *filemap);
 public_function int                        OsMapFileRegion(OS_FILE_DATA *data, int64_t offset, int64_t size, OS_FILE_MAPPING *filemap);
 public_function void                       OsFreeFileData(OS_FILE_DATA *data);
+public_function uint64_t                   OsArenaSnapshotChecksum(void const *data, size_t size);
+public_function int                        OsWriteArenaSnapshot(OS_HOST_MEMORY_ARENA *arena, void const *root, uint64_t user_tag, WCHAR const *path);
+public_function int                        OsLoadArenaSnapshot(OS_ARENA_SNAPSHOT *snapshot, WCHAR const *path, uint64_t user_tag, uint32_t flags);
+public_function void                       OsCloseArenaSnapshot(OS_ARENA_SNAPSHOT *snapshot);
 
 public_function size_t                     OsAllocationSizeForIoThreadPool(size_t thread_count);
 public_function int                        OsCreateIoThreadPool(OS_IO_THREAD_POOL *pool, OS_IO_THREAD_POOL_INIT *init, OS_HOST_MEMORY_ARENA *arena, char const *name);
@@ -1932,10 +2840,12 @@ public_function size_t                     OsAllocationSizeForIoRequestPool(size
 public_function int                        OsCreateIoRequestPool(OS_IO_REQUEST_POOL *pool, OS_HOST_MEMORY_ARENA *arena, size_t pool_capacity);
 public_function OS_IO_REQUEST*             OsAllocateIoRequest(OS_IO_REQUEST_POOL *pool);
 public_function bool                       OsSubmitIoRequest(OS_IO_THREAD_POOL *pool, OS_IO_REQUEST *request);
+#endif /* !defined(__linux__) */
 
 /*//////////////////////////
 //   Internal Functions   //
 //////////////////////////*/
+#if !defined(__linux__)
 /// @summary No-op stub function for XInputEnable.
 /// @param enable If enable is FALSE XInput will only send neutral data in response to XInputGetState.
 internal_function void WINAPI
@@ -2016,6 +2926,159 @@ XInputGetBatteryInformation_Stub
     UNREFERENCED_PARAMETER(pBatteryInformation);
     return ERROR_DEVICE_NOT_CONNECTED;
 }*/
+#endif /* !defined(__linux__) */
+
+#if defined(__linux__)
+/// @summary Write a formatted message to a stream, translating the MSVC-specific conversion specifiers used throughout the OS layer.
+/// %S (narrow string from wide printf) becomes %s, %Iu/%Id/%Ix become %zu/%zd/%zx and %I64 becomes %ll.
+/// @param stream The stream to write to, typically stdout or stderr.
+/// @param fmt The nul-terminated printf-style format string.
+/// @param ... Substitution arguments for the format string.
+internal_function void
+OsLayerPrint
+(
+    FILE       *stream, 
+    char const    *fmt, 
+    ...
+)
+{
+    char    buf[1024];
+    size_t  n = 0;
+    va_list args;
+    while (*fmt != '\0' && n < sizeof(buf) - 4)
+    {
+        if (fmt[0] != '%')
+        {
+            buf[n++] = *fmt++;
+            continue;
+        }
+        buf[n++] = *fmt++;
+        while (*fmt != '\0' && strchr("-+ #0123456789.", *fmt) != NULL && n < sizeof(buf) - 4)
+        {   // copy flags, width and precision.
+            buf[n++] = *fmt++;
+        }
+        if (fmt[0] == 'I' && fmt[1] == '6' && fmt[2] == '4')
+        {
+            buf[n++] = 'l'; buf[n++] = 'l'; fmt += 3;
+        }
+        else if (fmt[0] == 'I')
+        {
+            buf[n++] = 'z'; fmt += 1;
+        }
+        else if (fmt[0] == 'S')
+        {
+            buf[n++] = 's'; fmt += 1;
+        }
+    }
+    buf[n] = '\0';
+    va_start(args, fmt);
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#endif
+    vfprintf(stream, buf, args);
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+    va_end(args);
+}
+#endif /* defined(__linux__) */
+
+/// @summary Initialize a recursive lock used by the memory subsystem.
+/// @param mutex The OS_MUTEX to initialize.
+/// @param spin_count The number of times to spin before blocking, where supported.
+/// @return Zero if the lock is initialized, or -1 if an error occurred.
+internal_function int
+OsCreateMutex
+(
+    OS_MUTEX     *mutex, 
+    uint32_t spin_count
+)
+{
+#if defined(__linux__)
+    pthread_mutexattr_t attr;
+    int                  res;
+    UNREFERENCED_PARAMETER(spin_count);
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    res = pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    if (res != 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to initialize mutex (%d).\n", __FUNCTION__, OsThreadId(), res);
+        return -1;
+    }
+    return 0;
+#else
+    if (!InitializeCriticalSectionAndSpinCount(mutex, spin_count))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to initialize critical section (%08X).\n", __FUNCTION__, OsThreadId(), GetLastError());
+        return -1;
+    }
+    return 0;
+#endif
+}
+
+/// @summary Free the resources associated with a lock initialized by OsCreateMutex.
+/// @param mutex The OS_MUTEX to delete. The lock must not be held by any thread.
+internal_function void
+OsDeleteMutex
+(
+    OS_MUTEX *mutex
+)
+{
+#if defined(__linux__)
+    pthread_mutex_destroy(mutex);
+#else
+    DeleteCriticalSection(mutex);
+#endif
+}
+
+/// @summary Acquire a lock, blocking the calling thread until it becomes available.
+/// @param mutex The OS_MUTEX to acquire.
+internal_function inline void
+OsLockMutex
+(
+    OS_MUTEX *mutex
+)
+{
+#if defined(__linux__)
+    pthread_mutex_lock(mutex);
+#else
+    EnterCriticalSection(mutex);
+#endif
+}
+
+/// @summary Attempt to acquire a lock without blocking.
+/// @param mutex The OS_MUTEX to acquire.
+/// @return true if the lock was acquired by the calling thread.
+internal_function inline bool
+OsTryLockMutex
+(
+    OS_MUTEX *mutex
+)
+{
+#if defined(__linux__)
+    return pthread_mutex_trylock(mutex) == 0;
+#else
+    return TryEnterCriticalSection(mutex) != FALSE;
+#endif
+}
+
+/// @summary Release a lock held by the calling thread.
+/// @param mutex The OS_MUTEX to release.
+internal_function inline void
+OsUnlockMutex
+(
+    OS_MUTEX *mutex
+)
+{
+#if defined(__linux__)
+    pthread_mutex_unlock(mutex);
+#else
+    LeaveCriticalSection(mutex);
+#endif
+}
 
 /// @summary Make a signed 64-bit integer from two DWORDs.
 /// @param high32 The upper 32 bits of the 64-bit value.
@@ -2062,4108 +3125,10930 @@ OsNextPowerOfTwoGreaterOrEqual
     return n+1;
 }
 
-/// @summary Given two timestamp values, calculate the number of nanoseconds between them.
-/// @param start_ticks The TimestampInTicks at the beginning of the measured interval.
-/// @param end_ticks The TimestampInTicks at the end of the measured interval.
-/// @param frequency The number of ticks-per-second of the clock used to capture the timestamp values.
-/// @return The elapsed time between the timestamps, specified in nanoseconds.
-internal_function uint64_t
-OsElapsedNanoseconds
+/// @summary Retrieve the zero-based index of the least-significant set bit in a 64-bit value.
+/// @param value The input value. This value must be non-zero.
+/// @return The zero-based index of the least-significant set bit.
+internal_function inline uint32_t
+OsBitScanForward64
 (
-    uint64_t start_ticks, 
-    uint64_t   end_ticks, 
-    int64_t    frequency
+    uint64_t value
 )
-{   // scale the tick value by the nanoseconds-per-second multiplier
-    // before scaling back down by ticks-per-second to avoid loss of precision.
-    return (1000000000ULL * (end_ticks - start_ticks)) / uint64_t(frequency);
+{   assert(value != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (uint32_t) index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long) value))
+        return (uint32_t) index;
+    _BitScanForward(&index, (unsigned long)(value >> 32));
+    return (uint32_t) index + 32;
+#else
+    return (uint32_t) __builtin_ctzll(value);
+#endif
 }
 
-/// @summary Enable or disable a process privilege.
-/// @param token The privilege token of the process to modify.
-/// @param privilege_name The name of the privilege to enable or disable.
-/// @param should_enable Specify TRUE to request the privilege, or FALSE to disable the privilege.
-internal_function bool
-OsEnableProcessPrivilege
+/// @summary Retrieve the zero-based index of the most-significant set bit in a 64-bit value.
+/// @param value The input value. This value must be non-zero.
+/// @return The zero-based index of the most-significant set bit.
+internal_function inline uint32_t
+OsBitScanReverse64
 (
-    HANDLE           token, 
-    LPCTSTR privilege_name,
-    BOOL     should_enable
+    uint64_t value
+)
+{   assert(value != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (uint32_t) index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanReverse(&index, (unsigned long)(value >> 32)))
+        return (uint32_t) index + 32;
+    _BitScanReverse(&index, (unsigned long) value);
+    return (uint32_t) index;
+#else
+    return (uint32_t)(63 - __builtin_clzll(value));
+#endif
+}
+
+/// @summary Execute the CPUID instruction for a given leaf and sub-leaf.
+/// @param regs On return, the values of the EAX, EBX, ECX and EDX registers.
+/// @param leaf The CPUID function to execute.
+/// @param subleaf The value to load into ECX before executing CPUID.
+internal_function void
+OsCpuidEx
+(
+    int    regs[4], 
+    int       leaf, 
+    int    subleaf
 )
 {
-    TOKEN_PRIVILEGES tp;
-    LUID           luid;
+#if defined(_MSC_VER)
+    __cpuidex(regs, leaf, subleaf);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count((unsigned int) leaf, (unsigned int) subleaf, a, b, c, d);
+    regs[0] = (int) a; regs[1] = (int) b;
+    regs[2] = (int) c; regs[3] = (int) d;
+#endif
+}
 
-    if (LookupPrivilegeValue(NULL, privilege_name, &luid))
-    {
-        tp.PrivilegeCount           = 1;
-        tp.Privileges[0].Luid       = luid;
-        tp.Privileges[0].Attributes = should_enable ? SE_PRIVILEGE_ENABLED : 0;
-        if (AdjustTokenPrivileges(token, FALSE, &tp, sizeof(TOKEN_PRIVILEGES), NULL, NULL))
-        {   // the requested privilege adjustment was made successfully.
-            return (GetLastError() != ERROR_NOT_ALL_ASSIGNED);
-        }
-    }
-    return false;
+/// @summary Read the XCR0 extended control register, which indicates the register state saved and restored by the operating system.
+/// The caller must have checked that CPUID.1:ECX.OSXSAVE is set.
+/// @return The value of XCR0.
+internal_function uint64_t
+OsReadXCR0
+(
+    void
+)
+{
+#if defined(_MSC_VER)
+    return (uint64_t) _xgetbv(0);
+#else
+    uint32_t lo = 0, hi = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t) hi << 32) | lo;
+#endif
 }
 
-/// @summary Request any privilege elevations for the current process.
-/// @return true if the necessary privileges have been obtained.
-internal_function bool
-OsElevateProcessPrivileges
+/// @summary Determine the most capable instruction set usable by the bulk memory kernels on the host. The CPU must support the 
+/// instructions and the operating system must save and restore the corresponding register state on context switches.
+/// @return One of OS_MEMORY_ISA, never OS_MEMORY_ISA_AUTO.
+internal_function int32_t
+OsDetectMemoryInstructionSet
 (
     void
 )
 {
-    HANDLE token;
-    if (OpenProcessToken(GetCurrentProcess(), TOKEN_ALL_ACCESS, &token))
-    {   // request elevated privileges one at a time.
-        bool se_debug       = OsEnableProcessPrivilege(token, SE_DEBUG_NAME, TRUE);
-        bool se_volume_name = OsEnableProcessPrivilege(token, SE_MANAGE_VOLUME_NAME, TRUE);
-        // ...
-        CloseHandle(token);
-        return (se_debug && se_volume_name);
+    int      regs[4] = {0, 0, 0, 0};
+    uint64_t    xcr0 = 0;
+
+    OsCpuidEx(regs, 0, 0);
+    if (regs[0] < 7)
+    {   // CPUID leaf 7 is required to report AVX2 and AVX-512 support.
+        return OS_MEMORY_ISA_SSE2;
     }
-    return false;
+    OsCpuidEx(regs, 1, 0);
+    if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+    {   // either OSXSAVE or AVX is not available.
+        return OS_MEMORY_ISA_SSE2;
+    }
+    if (((xcr0 = OsReadXCR0()) & 0x06) != 0x06)
+    {   // the OS does not preserve the XMM and YMM register state.
+        return OS_MEMORY_ISA_SSE2;
+    }
+    OsCpuidEx(regs, 7, 0);
+    if ((regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0 && (xcr0 & 0xE6) == 0xE6)
+    {   // AVX-512F and AVX-512BW are supported, and the OS preserves the opmask and ZMM register state.
+        return OS_MEMORY_ISA_AVX512;
+    }
+    if ((regs[1] & (1 << 5)) != 0)
+    {   // AVX2 is supported.
+        return OS_MEMORY_ISA_AVX2;
+    }
+    return OS_MEMORY_ISA_SSE2;
 }
 
-/// @summary Load the latest version of XInput into the process address space and resolve the required API functions.
-/// @param missing_entry_points On return, set to true if any entry points are missing.
-/// @return true if the XInput DLL was loaded into the process address space.
-internal_function bool
-OsLoadXInput
+/// @summary Determine the transfer size above which copies and fills should bypass the cache. A transfer larger than half of 
+/// the last-level cache would evict most of the working set of every thread sharing that cache without ever being re-read from it.
+/// @return The streaming store threshold, in bytes.
+internal_function size_t
+OsDetectStreamingThreshold
 (
-    bool *missing_entry_points
+    void
 )
-{   // start by trying to load the most recent version of the DLL, which ships with the Windows 8 SDK.
-    HMODULE xinput_dll = NULL;
-    if ((xinput_dll = LoadLibrary(_T("xinput1_4.dll"))) == NULL)
-    {   // try with XInput 9.1.0, which shipped starting with Windows Vista.
-        if ((xinput_dll = LoadLibrary(_T("xinput9_1_0.dll"))) == NULL)
-        {   // try for XInput 1.3, which shipped in the June 2010 DirectX SDK.
-            if ((xinput_dll = LoadLibrary(_T("xinput1_3.dll"))) == NULL)
-            {   // no XInput is available, so resolve everything to the stub functions.
-                if (missing_entry_points) *missing_entry_points = true;
-                return false;
-            }
+{
+    int      regs[4] = {0, 0, 0, 0};
+    int         leaf = 0;
+    size_t  llc_size = 0;
+    uint32_t   level = 0;
+
+    OsCpuidEx(regs, 0, 0);
+    if (regs[1] == 0x756E6547 && regs[0] >= 4)
+    {   // GenuineIntel - deterministic cache parameters are reported by leaf 4.
+        leaf = 4;
+    }
+    else
+    {   // AuthenticAMD and HygonGenuine report the same data from leaf 0x8000001D.
+        OsCpuidEx(regs, (int) 0x80000000, 0);
+        if ((uint32_t) regs[0] >= 0x8000001DU)
+            leaf = (int) 0x8000001D;
+    }
+    for (int i = 0; leaf != 0 && i < 16; ++i)
+    {
+        uint32_t cache_type;
+        uint32_t cache_level;
+        OsCpuidEx(regs, leaf, i);
+        if ((cache_type = (uint32_t) regs[0] & 0x1F) == 0)
+            break;
+        if ((cache_level = ((uint32_t) regs[0] >> 5) & 0x07) >= level && cache_type == 3)
+        {   // a unified cache at the outermost level seen so far.
+            size_t ways       = (((uint32_t) regs[1] >> 22) & 0x3FF) + 1;
+            size_t partitions = (((uint32_t) regs[1] >> 12) & 0x3FF) + 1;
+            size_t line_size  = (((uint32_t) regs[1]      ) & 0xFFF) + 1;
+            size_t sets       = (size_t)(uint32_t) regs[2] + 1;
+            level    = cache_level;
+            llc_size = ways * partitions * line_size * sets;
         }
     }
+    if (llc_size < Megabytes(2))
+    {   // the cache hierarchy could not be determined, or the LLC is small; don't stream moderately-sized transfers.
+        return Megabytes(4);
+    }
+    return llc_size / 2;
+}
 
-    // perform runtime resolution of all required API functions.
-    OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputEnable);
-    OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputGetState);
-    OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputSetState);
-    OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputGetCapabilities);
-    //OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputGetBatteryInformation);
-
-    // check for any entry points that got set to their stub functions.
-    if (OS_LAYER_RUNTIME_STUB(XInputEnable))                goto missing_entry_point;
-    if (OS_LAYER_RUNTIME_STUB(XInputGetState))              goto missing_entry_point;
-    if (OS_LAYER_RUNTIME_STUB(XInputSetState))              goto missing_entry_point;
-    if (OS_LAYER_RUNTIME_STUB(XInputGetCapabilities))       goto missing_entry_point;
-    //if (OS_LAYER_RUNTIME_STUB(XInputGetBatteryInformation)) goto missing_entry_point;
-
-    // save the DLL handle.
-    XInputDll = xinput_dll;
-    return true;
-
-missing_entry_point:
-    if (missing_entry_points) *missing_entry_points = true;
-    XInputDll = xinput_dll;
-    return true;
+/// @summary Copy fewer than 16 bytes between two non-overlapping blocks using overlapping scalar loads and stores.
+/// @param dst The address of the destination block.
+/// @param src The address of the source block.
+/// @param len The number of bytes to copy, in [0, 16).
+internal_function inline void
+OsCopyMemorySmall
+(
+    uint8_t       * __restrict dst, 
+    uint8_t const * __restrict src, 
+    size_t                     len
+)
+{
+    if (len >= 8)
+    {
+        uint64_t head, tail;
+        memcpy(&head, src, 8);
+        memcpy(&tail, src + len - 8, 8);
+        memcpy(dst, &head, 8);
+        memcpy(dst + len - 8, &tail, 8);
+    }
+    else if (len >= 4)
+    {
+        uint32_t head, tail;
+        memcpy(&head, src, 4);
+        memcpy(&tail, src + len - 4, 4);
+        memcpy(dst, &head, 4);
+        memcpy(dst + len - 4, &tail, 4);
+    }
+    else if (len > 0)
+    {   // 1, 2 or 3 bytes.
+        dst[0]        = src[0];
+        dst[len >> 1] = src[len >> 1];
+        dst[len  - 1] = src[len  - 1];
+    }
 }
 
-/// @summary Search a device list for a device with a given handle.
-/// @param device_list The device list to search.
-/// @param device_handle The handle of the device to locate.
-/// @return The zero-based index of the device in the device list, or OS_INPUT_DEVICE_NOT_FOUND.
-template <typename T>
-internal_function size_t 
-OsFindInputDeviceForHandle
+/// @summary Fill fewer than 16 bytes with a byte value using overlapping scalar stores.
+/// @param dst The address of the destination block.
+/// @param len The number of bytes to write, in [0, 16).
+/// @param val The value to write to each byte.
+internal_function inline void
+OsFillMemorySmall
 (
-    OS_INPUT_DEVICE_LIST<T> *device_list, 
-    HANDLE                 device_handle
+    uint8_t *dst, 
+    size_t   len, 
+    uint8_t  val
 )
 {
-    for (size_t i = 0, n = device_list->DeviceCount; i < n; ++i)
+    uint64_t v64 = uint64_t(val) * 0x0101010101010101ULL;
+    if (len >= 8)
     {
-        if (device_list->DeviceHandle[i] == device_handle)
-            return i;
+        memcpy(dst, &v64, 8);
+        memcpy(dst + len - 8, &v64, 8);
+    }
+    else if (len >= 4)
+    {
+        uint32_t v32 = (uint32_t) v64;
+        memcpy(dst, &v32, 4);
+        memcpy(dst + len - 4, &v32, 4);
+    }
+    else if (len > 0)
+    {   // 1, 2 or 3 bytes.
+        dst[0]        = val;
+        dst[len >> 1] = val;
+        dst[len  - 1] = val;
     }
-    return OS_INPUT_DEVICE_NOT_FOUND;
 }
 
-/// @summary Adds a device to a device list.
-/// @param devices The list of devices to search.
-/// @param device The handle of the device to insert.
-/// @param default_state The initial device state to associate with the device, if the device was not already present in the device list.
-/// @return The zero-based index of the device in the list, or OS_INPUT_DEVICE_TOO_MANY.
-template <typename T>
-internal_function size_t
-OsDeviceAttached
+/// @summary Copy memory between two non-overlapping blocks using 128-bit SSE2 loads and stores.
+/// The first and last 16 bytes are copied with unaligned accesses; the interior is copied with aligned stores.
+/// @param dst The address of the destination block.
+/// @param src The address of the source block.
+/// @param len The number of bytes to copy.
+/// @param nt_threshold Copies of at least this many bytes use non-temporal stores.
+internal_function void
+OsCopyMemory_SSE2
 (
-    OS_INPUT_DEVICE_LIST<T> *devices,
-    HANDLE                    device,
-    T const           &default_state
+    void       * __restrict dst, 
+    void const * __restrict src, 
+    size_t                  len, 
+    size_t         nt_threshold
 )
 {
-    size_t index = 0;
+    uint8_t       *d = (uint8_t      *) dst;
+    uint8_t const *s = (uint8_t const*) src;
 
-    // search for the device in the device list to avoid duplicate devices.
-    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+    if (len < 16)
     {
-        if (devices->DeviceHandle[i] == device)
-        {   // the device is already present in the device list. don't modify its state.
-            return i;
-        }
+        OsCopyMemorySmall(d, s, len);
+        return;
     }
-    // the device isn't present in the device list, so add it.
-    if (devices->DeviceCount == OS_INPUT_DEVICE_LIST<T>::MAX_DEVICES)
-    {   // there are too many devices of the specified type attached; cannot add.
-        return OS_INPUT_DEVICE_TOO_MANY;
+    if (len <= 32)
+    {
+        __m128i head = _mm_loadu_si128((__m128i const*) s);
+        __m128i tail = _mm_loadu_si128((__m128i const*)(s + len - 16));
+        _mm_storeu_si128((__m128i*) d, head);
+        _mm_storeu_si128((__m128i*)(d + len - 16), tail);
+        return;
+    }
+    else
+    {
+        __m128i         head = _mm_loadu_si128((__m128i const*) s);
+        __m128i         tail = _mm_loadu_si128((__m128i const*)(s + len - 16));
+        size_t          skip = 16 - ((uintptr_t) d & 15);
+        uint8_t          *dp = d + skip;
+        uint8_t const    *sp = s + skip;
+        size_t             n = len - skip;
+        if (len >= nt_threshold)
+        {
+            for ( ; n >= 64; n -= 64, dp += 64, sp += 64)
+            {
+                __m128i r0 = _mm_loadu_si128((__m128i const*)(sp +  0));
+                __m128i r1 = _mm_loadu_si128((__m128i const*)(sp + 16));
+                __m128i r2 = _mm_loadu_si128((__m128i const*)(sp + 32));
+                __m128i r3 = _mm_loadu_si128((__m128i const*)(sp + 48));
+                _mm_stream_si128((__m128i*)(dp +  0), r0);
+                _mm_stream_si128((__m128i*)(dp + 16), r1);
+                _mm_stream_si128((__m128i*)(dp + 32), r2);
+                _mm_stream_si128((__m128i*)(dp + 48), r3);
+            }
+            _mm_sfence();
+        }
+        for ( ; n >= 64; n -= 64, dp += 64, sp += 64)
+        {
+            __m128i r0 = _mm_loadu_si128((__m128i const*)(sp +  0));
+            __m128i r1 = _mm_loadu_si128((__m128i const*)(sp + 16));
+            __m128i r2 = _mm_loadu_si128((__m128i const*)(sp + 32));
+            __m128i r3 = _mm_loadu_si128((__m128i const*)(sp + 48));
+            _mm_store_si128((__m128i*)(dp +  0), r0);
+            _mm_store_si128((__m128i*)(dp + 16), r1);
+            _mm_store_si128((__m128i*)(dp + 32), r2);
+            _mm_store_si128((__m128i*)(dp + 48), r3);
+        }
+        for ( ; n >= 16; n -= 16, dp += 16, sp += 16)
+        {
+            _mm_store_si128((__m128i*) dp, _mm_loadu_si128((__m128i const*) sp));
+        }
+        // the head covers the bytes skipped to align the destination; the tail covers any remainder.
+        _mm_storeu_si128((__m128i*) d, head);
+        _mm_storeu_si128((__m128i*)(d + len - 16), tail);
     }
-    index = devices->DeviceCount++;
-    devices->DeviceHandle[index] = device;
-    devices->DeviceState [index] = default_state;
-    return index;
 }
 
-/// @summary Removes a device from a device list.
-/// @param devices The list of devices to search.
-/// @param device The handle of the device to remove.
-/// @return true if the device was found in the device list.
-template <typename T>
-internal_function bool
-OsDeviceRemoved
+/// @summary Fill a block of memory with a byte value using 128-bit SSE2 stores.
+/// @param dst The address of the destination block.
+/// @param len The number of bytes to write.
+/// @param val The value to write to each byte.
+/// @param nt_threshold Fills of at least this many bytes use non-temporal stores.
+internal_function void
+OsFillMemory_SSE2
 (
-    OS_INPUT_DEVICE_LIST<T> *devices,
-    HANDLE                    device 
+    void                *dst, 
+    size_t               len, 
+    uint8_t              val, 
+    size_t      nt_threshold
 )
-{   // locate the device in the device list.
-    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+{
+    uint8_t *d = (uint8_t*) dst;
+    __m128i  v;
+
+    if (len < 16)
     {
-        if (devices->DeviceHandle[i] == device)
-        {   // the device has been located. swap the last item into its slot.
-            size_t   last_index = devices->DeviceCount - 1;
-            if (i != last_index)
+        OsFillMemorySmall(d, len, val);
+        return;
+    }
+    v = _mm_set1_epi8((char) val);
+    _mm_storeu_si128((__m128i*) d, v);
+    _mm_storeu_si128((__m128i*)(d + len - 16), v);
+    if (len > 32)
+    {
+        size_t skip = 16 - ((uintptr_t) d & 15);
+        uint8_t *dp = d + skip;
+        size_t    n = len - skip;
+        if (len >= nt_threshold)
+        {
+            for ( ; n >= 64; n -= 64, dp += 64)
             {
-                devices->DeviceHandle[i] = devices->DeviceHandle[last_index];
-                devices->DeviceState [i] = devices->DeviceState [last_index];
+                _mm_stream_si128((__m128i*)(dp +  0), v);
+                _mm_stream_si128((__m128i*)(dp + 16), v);
+                _mm_stream_si128((__m128i*)(dp + 32), v);
+                _mm_stream_si128((__m128i*)(dp + 48), v);
             }
-            devices->DeviceCount--;
-            return true;
+            _mm_sfence();
+        }
+        for ( ; n >= 64; n -= 64, dp += 64)
+        {
+            _mm_store_si128((__m128i*)(dp +  0), v);
+            _mm_store_si128((__m128i*)(dp + 16), v);
+            _mm_store_si128((__m128i*)(dp + 32), v);
+            _mm_store_si128((__m128i*)(dp + 48), v);
+        }
+        for ( ; n >= 16; n -= 16, dp += 16)
+        {
+            _mm_store_si128((__m128i*) dp, v);
         }
     }
-    return false;
 }
 
-/// @summary Given a Raw Input keyboard packet, retrieve the virtual key code and scan code values.
-/// @param key The Raw Input keyboard packet to process.
-/// @param vkey_code On return, stores the virtual key code identifier (always less than or equal to 255.)
-/// @param scan_code On return, stores the scan code value, suitable for passing to CopyKeyDisplayName.
-/// @return true if vkey_code and scan_code were set, or false if the packet was part of an escape sequence.
-internal_function bool
-OsGetVirtualKeyAndScanCode
+/// @summary Lexicographically compare two blocks of memory using 128-bit SSE2 comparisons.
+/// @param a The address of the first block.
+/// @param b The address of the second block.
+/// @param len The number of bytes to compare.
+/// @return Zero if the blocks are equal, or the difference between the first pair of mismatched bytes, interpreted as unsigned.
+internal_function int
+OsCompareMemory_SSE2
 (
-    RAWKEYBOARD const &key, 
-    uint32_t    &vkey_code, 
-    uint32_t    &scan_code
+    void const *a, 
+    void const *b, 
+    size_t    len
 )
 {
-    uint32_t vkey =  key.VKey;
-    uint32_t scan =  key.MakeCode;
-    bool       e0 =((key.Flags & RI_KEY_E0) != 0);
+    uint8_t const *pa = (uint8_t const*) a;
+    uint8_t const *pb = (uint8_t const*) b;
+    size_t          i = 0;
 
-    if (vkey == 255)
-    {   // discard fake keys; these are just part of an escaped sequence.
-        vkey_code = 0; scan_code = 0;
-        return false;
+    if (len < 16)
+    {
+        for ( ; i < len; ++i)
+        {
+            if (pa[i] != pb[i])
+                return int(pa[i]) - int(pb[i]);
+        }
+        return 0;
     }
-    if (vkey == VK_SHIFT)
-    {   // correct left/right shift.
-        vkey  = MapVirtualKey(scan, MAPVK_VSC_TO_VK_EX);
+    for ( ; i + 64 <= len; i += 64)
+    {   // check a full cacheline at a time; fall through to the 16-byte loop to locate a mismatch.
+        __m128i e0 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)(pa + i +  0)), _mm_loadu_si128((__m128i const*)(pb + i +  0)));
+        __m128i e1 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)(pa + i + 16)), _mm_loadu_si128((__m128i const*)(pb + i + 16)));
+        __m128i e2 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)(pa + i + 32)), _mm_loadu_si128((__m128i const*)(pb + i + 32)));
+        __m128i e3 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)(pa + i + 48)), _mm_loadu_si128((__m128i const*)(pb + i + 48)));
+        if (_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(e0, e1), _mm_and_si128(e2, e3))) != 0xFFFF)
+            break;
     }
-    if (vkey == VK_NUMLOCK)
-    {   // correct PAUSE/BREAK and NUMLOCK. set the extended bit.
-        scan  = MapVirtualKey(vkey, MAPVK_VK_TO_VSC) | 0x100;
+    for ( ; ; i += 16)
+    {
+        uint32_t diff;
+        if (i + 16 > len)
+        {   // re-check the last 16 bytes; any overlap with previous blocks is already known to be equal.
+            if (i >= len) break;
+            i = len - 16;
+        }
+        diff = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)(pa + i)), _mm_loadu_si128((__m128i const*)(pb + i)))) ^ 0xFFFFU;
+        if (diff != 0)
+        {
+            size_t k = i + OsBitScanForward64(diff);
+            return int(pa[k]) - int(pb[k]);
+        }
+        if (i + 16 == len)
+            break;
     }
-    if (key.Flags & RI_KEY_E1)
-    {   // for escaped sequences, turn the virtual key into the correct scan code.
-        // unfortunately, MapVirtualKey can't handle VK_PAUSE, so do that manually.
-        if (vkey != VK_PAUSE) scan = MapVirtualKey(vkey, MAPVK_VK_TO_VSC);
-        else scan = 0x45;
-    }
-    switch (vkey)
-    {   // map left/right versions of various keys.
-        case VK_CONTROL:  /* left/right CTRL */
-            vkey =  e0 ? VK_RCONTROL : VK_LCONTROL;
-            break;
-        case VK_MENU:     /* left/right ALT  */
-            vkey =  e0 ? VK_RMENU : VK_LMENU;
-            break;
-        case VK_RETURN:
-            vkey =  e0 ? VK_SEPARATOR : VK_RETURN;
-            break;
-        case VK_INSERT:
-            vkey = !e0 ? VK_NUMPAD0 : VK_INSERT;
-            break;
-        case VK_DELETE:
-            vkey = !e0 ? VK_DECIMAL : VK_DELETE;
-            break;
-        case VK_HOME:
-            vkey = !e0 ? VK_NUMPAD7 : VK_HOME;
-            break;
-        case VK_END:
-            vkey = !e0 ? VK_NUMPAD1 : VK_END;
-            break;
-        case VK_PRIOR:
-            vkey = !e0 ? VK_NUMPAD9 : VK_PRIOR;
-            break;
-        case VK_NEXT:
-            vkey = !e0 ? VK_NUMPAD3 : VK_NEXT;
-            break;
-        case VK_LEFT:
-            vkey = !e0 ? VK_NUMPAD4 : VK_LEFT;
-            break;
-        case VK_RIGHT:
-            vkey = !e0 ? VK_NUMPAD6 : VK_RIGHT;
-            break;
-        case VK_UP:
-            vkey = !e0 ? VK_NUMPAD8 : VK_UP;
-            break;
-        case VK_DOWN:
-            vkey = !e0 ? VK_NUMPAD2 : VK_DOWN;
-            break;
-        case VK_CLEAR:
-            vkey = !e0 ? VK_NUMPAD5 : VK_CLEAR;
-            break;
-    }
-
-    // return the processed codes back to the caller.
-    vkey_code = vkey;
-    scan_code = scan;
-    return true;
+    return 0;
 }
 
-/// @summary Retrieve the localized display name for a keyboard scan code.
-/// @param scan_code The key scan code, as returned by ProcessKeyboardPacket.
-/// @param ri_flags The RAWKEYBOARD::Flags field from the input packet.
-/// @param buffer The caller-managed buffer into which the display name will be copied.
-/// @param buffer_size The maximum number of characters that can be written to the buffer.
-/// @return The number of characters written to the buffer, not including the zero codepoint, or 0.
-internal_function size_t
-OsCopyKeyDisplayName
+/// @summary Copy memory between two non-overlapping blocks using 256-bit AVX2 loads and stores.
+/// @param dst The address of the destination block.
+/// @param src The address of the source block.
+/// @param len The number of bytes to copy.
+/// @param nt_threshold Copies of at least this many bytes use non-temporal stores.
+internal_function OS_TARGET_AVX2 void
+OsCopyMemory_AVX2
 (
-    uint32_t   scan_code, 
-    uint32_t    ri_flags, 
-    TCHAR        *buffer, 
-    size_t   buffer_size
+    void       * __restrict dst, 
+    void const * __restrict src, 
+    size_t                  len, 
+    size_t         nt_threshold
 )
 {
-    LONG key_code = (scan_code << 16) | (((ri_flags & RI_KEY_E0) ? 1 : 0) << 24);
-    return (size_t)  GetKeyNameText(key_code, buffer, (int) buffer_size);
+    uint8_t       *d = (uint8_t      *) dst;
+    uint8_t const *s = (uint8_t const*) src;
+
+    if (len < 32)
+    {
+        OsCopyMemory_SSE2(dst, src, len, nt_threshold);
+        return;
+    }
+    if (len <= 64)
+    {
+        __m256i head = _mm256_loadu_si256((__m256i const*) s);
+        __m256i tail = _mm256_loadu_si256((__m256i const*)(s + len - 32));
+        _mm256_storeu_si256((__m256i*) d, head);
+        _mm256_storeu_si256((__m256i*)(d + len - 32), tail);
+        return;
+    }
+    else
+    {
+        __m256i         head = _mm256_loadu_si256((__m256i const*) s);
+        __m256i         tail = _mm256_loadu_si256((__m256i const*)(s + len - 32));
+        size_t          skip = 32 - ((uintptr_t) d & 31);
+        uint8_t          *dp = d + skip;
+        uint8_t const    *sp = s + skip;
+        size_t             n = len - skip;
+        if (len >= nt_threshold)
+        {
+            for ( ; n >= 128; n -= 128, dp += 128, sp += 128)
+            {
+                __m256i r0 = _mm256_loadu_si256((__m256i const*)(sp +  0));
+                __m256i r1 = _mm256_loadu_si256((__m256i const*)(sp + 32));
+                __m256i r2 = _mm256_loadu_si256((__m256i const*)(sp + 64));
+                __m256i r3 = _mm256_loadu_si256((__m256i const*)(sp + 96));
+                _mm256_stream_si256((__m256i*)(dp +  0), r0);
+                _mm256_stream_si256((__m256i*)(dp + 32), r1);
+                _mm256_stream_si256((__m256i*)(dp + 64), r2);
+                _mm256_stream_si256((__m256i*)(dp + 96), r3);
+            }
+            _mm_sfence();
+        }
+        for ( ; n >= 128; n -= 128, dp += 128, sp += 128)
+        {
+            __m256i r0 = _mm256_loadu_si256((__m256i const*)(sp +  0));
+            __m256i r1 = _mm256_loadu_si256((__m256i const*)(sp + 32));
+            __m256i r2 = _mm256_loadu_si256((__m256i const*)(sp + 64));
+            __m256i r3 = _mm256_loadu_si256((__m256i const*)(sp + 96));
+            _mm256_store_si256((__m256i*)(dp +  0), r0);
+            _mm256_store_si256((__m256i*)(dp + 32), r1);
+            _mm256_store_si256((__m256i*)(dp + 64), r2);
+            _mm256_store_si256((__m256i*)(dp + 96), r3);
+        }
+        for ( ; n >= 32; n -= 32, dp += 32, sp += 32)
+        {
+            _mm256_store_si256((__m256i*) dp, _mm256_loadu_si256((__m256i const*) sp));
+        }
+        _mm256_storeu_si256((__m256i*) d, head);
+        _mm256_storeu_si256((__m256i*)(d + len - 32), tail);
+    }
 }
 
-/// @summary Process a Raw Input keyboard packet to update the state of a keyboard device.
-/// @param input The Raw Input keyboard packet to process.
-/// @param devices The list of keyboard devices to update.
-/// @return The zero-based index of the input device in the device list, or OS_INPUT_DEVICE_TOO_MANY.
-internal_function size_t
-OsProcessKeyboardPacket
+/// @summary Fill a block of memory with a byte value using 256-bit AVX2 stores.
+/// @param dst The address of the destination block.
+/// @param len The number of bytes to write.
+/// @param val The value to write to each byte.
+/// @param nt_threshold Fills of at least this many bytes use non-temporal stores.
+internal_function OS_TARGET_AVX2 void
+OsFillMemory_AVX2
 (
-    RAWINPUT const     *input,
-    OS_KEYBOARD_LIST *devices
+    void                *dst, 
+    size_t               len, 
+    uint8_t              val, 
+    size_t      nt_threshold
 )
 {
-    RAWINPUTHEADER const  &header =  input->header;
-    RAWKEYBOARD    const     &key =  input->data.keyboard;
-    OS_KEYBOARD_STATE      *state =  NULL;
-    size_t                  index =  0;
-    uint32_t                 vkey =  0;
-    uint32_t                 scan =  0;
+    uint8_t *d = (uint8_t*) dst;
+    __m256i  v;
 
-    // locate the keyboard in the current state buffer by device handle.
-    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+    if (len < 32)
     {
-        if (devices->DeviceHandle[i] == header.hDevice)
-        {   // found the matching device.
-            index = i;
-            state =&devices->DeviceState[i];
-            break;
-        }
+        OsFillMemory_SSE2(dst, len, val, nt_threshold);
+        return;
     }
-    if (state == NULL)
-    {   // this device was newly attached.
-        if (devices->DeviceCount == OS_KEYBOARD_LIST::MAX_DEVICES)
-        {   // there are too many devices of the specified type attached.
-            return OS_INPUT_DEVICE_TOO_MANY;
+    v = _mm256_set1_epi8((char) val);
+    _mm256_storeu_si256((__m256i*) d, v);
+    _mm256_storeu_si256((__m256i*)(d + len - 32), v);
+    if (len > 64)
+    {
+        size_t skip = 32 - ((uintptr_t) d & 31);
+        uint8_t *dp = d + skip;
+        size_t    n = len - skip;
+        if (len >= nt_threshold)
+        {
+            for ( ; n >= 128; n -= 128, dp += 128)
+            {
+                _mm256_stream_si256((__m256i*)(dp +  0), v);
+                _mm256_stream_si256((__m256i*)(dp + 32), v);
+                _mm256_stream_si256((__m256i*)(dp + 64), v);
+                _mm256_stream_si256((__m256i*)(dp + 96), v);
+            }
+            _mm_sfence();
+        }
+        for ( ; n >= 128; n -= 128, dp += 128)
+        {
+            _mm256_store_si256((__m256i*)(dp +  0), v);
+            _mm256_store_si256((__m256i*)(dp + 32), v);
+            _mm256_store_si256((__m256i*)(dp + 64), v);
+            _mm256_store_si256((__m256i*)(dp + 96), v);
+        }
+        for ( ; n >= 32; n -= 32, dp += 32)
+        {
+            _mm256_store_si256((__m256i*) dp, v);
         }
-        index  = devices->DeviceCount++;
-        state  =&devices->DeviceState[index];
-        devices->DeviceHandle[index] = header.hDevice;
-        devices->DeviceState [index] = OS_KEYBOARD_STATE_STATIC_INIT;
-    }
-    if (!OsGetVirtualKeyAndScanCode(key, vkey, scan))
-    {   // discard fake keys; these are just part of an escaped sequence.
-        return index;
-    }
-    if ((key.Flags & RI_KEY_BREAK) == 0)
-    {   // the key is currently pressed; set the bit corresponding to the virtual key code.
-        state->KeyState[vkey >> 5] |= (1UL << (vkey & 0x1F));
-    }
-    else
-    {   // the key was just released; clear the bit corresponding to the virtual key code.
-        state->KeyState[vkey >> 5] &=~(1UL << (vkey & 0x1F));
     }
-    return index;
 }
 
-/// @summary Process a Raw Input mouse packet to update the state of a pointing device.
-/// @param input The Raw Input mouse packet to process.
-/// @param devices The list of pointing devices to update.
-/// @return The zero-based index of the input device in the device list, or OS_INPUT_DEVICE_TOO_MANY.
-internal_function size_t
-OsProcessPointerPacket
+/// @summary Lexicographically compare two blocks of memory using 256-bit AVX2 comparisons.
+/// @param a The address of the first block.
+/// @param b The address of the second block.
+/// @param len The number of bytes to compare.
+/// @return Zero if the blocks are equal, or the difference between the first pair of mismatched bytes, interpreted as unsigned.
+internal_function OS_TARGET_AVX2 int
+OsCompareMemory_AVX2
 (
-    RAWINPUT const    *input,
-    OS_POINTER_LIST *devices
+    void const *a, 
+    void const *b, 
+    size_t    len
 )
 {
-    RAWINPUTHEADER const &header = input->header;
-    RAWMOUSE       const  &mouse = input->data.mouse;
-    OS_POINTER_STATE      *state = NULL;
-    size_t                 index = 0;
-    POINT                 cursor = {};
+    uint8_t const *pa = (uint8_t const*) a;
+    uint8_t const *pb = (uint8_t const*) b;
+    size_t          i = 0;
 
-    // locate the pointer in the current state buffer by device handle.
-    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+    if (len < 32)
     {
-        if (devices->DeviceHandle[i] == header.hDevice)
-        {   // found the matching device.
-            index = i;
-            state =&devices->DeviceState[i];
+        return OsCompareMemory_SSE2(a, b, len);
+    }
+    for ( ; i + 128 <= len; i += 128)
+    {
+        __m256i e0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*)(pa + i +  0)), _mm256_loadu_si256((__m256i const*)(pb + i +  0)));
+        __m256i e1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*)(pa + i + 32)), _mm256_loadu_si256((__m256i const*)(pb + i + 32)));
+        __m256i e2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*)(pa + i + 64)), _mm256_loadu_si256((__m256i const*)(pb + i + 64)));
+        __m256i e3 = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*)(pa + i + 96)), _mm256_loadu_si256((__m256i const*)(pb + i + 96)));
+        if ((uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(e0, e1), _mm256_and_si256(e2, e3))) != 0xFFFFFFFFU)
             break;
-        }
     }
-    if (state == NULL)
-    {   // this device was newly attached.
-        if (devices->DeviceCount == OS_POINTER_LIST::MAX_DEVICES)
-        {   // there are too many devices of the specified type attached.
-            return OS_INPUT_DEVICE_TOO_MANY;
+    for ( ; ; i += 32)
+    {
+        uint32_t diff;
+        if (i + 32 > len)
+        {
+            if (i >= len) break;
+            i = len - 32;
         }
-        index  = devices->DeviceCount++;
-        state  =&devices->DeviceState[index];
-        devices->DeviceHandle[index] = header.hDevice;
-        devices->DeviceState [index] = OS_POINTER_STATE_STATIC_INIT;
+        diff = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*)(pa + i)), _mm256_loadu_si256((__m256i const*)(pb + i)))) ^ 0xFFFFFFFFU;
+        if (diff != 0)
+        {
+            size_t k = i + OsBitScanForward64(diff);
+            return int(pa[k]) - int(pb[k]);
+        }
+        if (i + 32 == len)
+            break;
     }
+    return 0;
+}
 
-    // grab the current mouse pointer position, in pixels.
-    GetCursorPos(&cursor);
-    state->Pointer[0] = cursor.x;
-    state->Pointer[1] = cursor.y;
+/// @summary Copy memory between two non-overlapping blocks using 512-bit AVX-512 loads and stores.
+/// @param dst The address of the destination block.
+/// @param src The address of the source block.
+/// @param len The number of bytes to copy.
+/// @param nt_threshold Copies of at least this many bytes use non-temporal stores.
+internal_function OS_TARGET_AVX512 void
+OsCopyMemory_AVX512
+(
+    void       * __restrict dst, 
+    void const * __restrict src, 
+    size_t                  len, 
+    size_t         nt_threshold
+)
+{
+    uint8_t       *d = (uint8_t      *) dst;
+    uint8_t const *s = (uint8_t const*) src;
 
-    if (mouse.usFlags & MOUSE_MOVE_ABSOLUTE)
-    {   // the device is a pen, touchscreen, etc. and specifies absolute coordinates.
-        state->Relative[0]  = mouse.lLastX;
-        state->Relative[1]  = mouse.lLastY;
-        state->Flags = OS_POINTER_FLAGS_ABSOLUTE;
-    }
-    else
-    {   // the device has specified relative coordinates in mickeys.
-        state->Relative[0] += mouse.lLastX;
-        state->Relative[1] += mouse.lLastY;
-        state->Flags = OS_POINTER_FLAGS_NONE;
+    if (len < 64)
+    {
+        OsCopyMemory_AVX2(dst, src, len, nt_threshold);
+        return;
     }
-    if (mouse.usButtonFlags & RI_MOUSE_WHEEL)
-    {   // mouse wheel data was supplied with the packet.
-        state->Relative[2] = (int16_t) mouse.usButtonData;
+    if (len <= 128)
+    {
+        __m512i head = _mm512_loadu_si512((void const*) s);
+        __m512i tail = _mm512_loadu_si512((void const*)(s + len - 64));
+        _mm512_storeu_si512((void*) d, head);
+        _mm512_storeu_si512((void*)(d + len - 64), tail);
+        return;
     }
     else
-    {   // no mouse wheel data was supplied with the packet.
-        state->Relative[2] = 0;
+    {
+        __m512i         head = _mm512_loadu_si512((void const*) s);
+        __m512i         tail = _mm512_loadu_si512((void const*)(s + len - 64));
+        size_t          skip = 64 - ((uintptr_t) d & 63);
+        uint8_t          *dp = d + skip;
+        uint8_t const    *sp = s + skip;
+        size_t             n = len - skip;
+        if (len >= nt_threshold)
+        {
+            for ( ; n >= 256; n -= 256, dp += 256, sp += 256)
+            {
+                __m512i r0 = _mm512_loadu_si512((void const*)(sp +   0));
+                __m512i r1 = _mm512_loadu_si512((void const*)(sp +  64));
+                __m512i r2 = _mm512_loadu_si512((void const*)(sp + 128));
+                __m512i r3 = _mm512_loadu_si512((void const*)(sp + 192));
+                _mm512_stream_si512((__m512i*)(dp +   0), r0);
+                _mm512_stream_si512((__m512i*)(dp +  64), r1);
+                _mm512_stream_si512((__m512i*)(dp + 128), r2);
+                _mm512_stream_si512((__m512i*)(dp + 192), r3);
+            }
+            _mm_sfence();
+        }
+        for ( ; n >= 256; n -= 256, dp += 256, sp += 256)
+        {
+            __m512i r0 = _mm512_loadu_si512((void const*)(sp +   0));
+            __m512i r1 = _mm512_loadu_si512((void const*)(sp +  64));
+            __m512i r2 = _mm512_loadu_si512((void const*)(sp + 128));
+            __m512i r3 = _mm512_loadu_si512((void const*)(sp + 192));
+            _mm512_store_si512((void*)(dp +   0), r0);
+            _mm512_store_si512((void*)(dp +  64), r1);
+            _mm512_store_si512((void*)(dp + 128), r2);
+            _mm512_store_si512((void*)(dp + 192), r3);
+        }
+        for ( ; n >= 64; n -= 64, dp += 64, sp += 64)
+        {
+            _mm512_store_si512((void*) dp, _mm512_loadu_si512((void const*) sp));
+        }
+        _mm512_storeu_si512((void*) d, head);
+        _mm512_storeu_si512((void*)(d + len - 64), tail);
     }
-
-    // rebuild the button state vector. Raw Input supports up to 5 buttons.
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_1_DOWN) state->Buttons |=  MK_LBUTTON;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_1_UP  ) state->Buttons &= ~MK_LBUTTON;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_2_DOWN) state->Buttons |=  MK_RBUTTON;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_2_UP  ) state->Buttons &= ~MK_RBUTTON;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_3_DOWN) state->Buttons |=  MK_MBUTTON;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_3_UP  ) state->Buttons &= ~MK_MBUTTON;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_4_DOWN) state->Buttons |=  MK_XBUTTON1;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_4_UP  ) state->Buttons &= ~MK_XBUTTON1;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_5_DOWN) state->Buttons |=  MK_XBUTTON2;
-    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_5_UP  ) state->Buttons &= ~MK_XBUTTON2;
-    return index;
 }
 
-/// @summary Apply scaled radial deadzone logic to an analog stick input.
-/// @param stick_x The x-axis component of the analog input.
-/// @param stick_y The y-axis component of the analog input.
-/// @param deadzone The deadzone size as a percentage of the total input range.
-/// @param stick_xymn A four-element array that will store the normalized x- and y-components of the input direction, the magnitude, and the normalized magnitude.
-internal_function void
-OsScaledRadialDeadzone
+/// @summary Fill a block of memory with a byte value using 512-bit AVX-512 stores.
+/// @param dst The address of the destination block.
+/// @param len The number of bytes to write.
+/// @param val The value to write to each byte.
+/// @param nt_threshold Fills of at least this many bytes use non-temporal stores.
+internal_function OS_TARGET_AVX512 void
+OsFillMemory_AVX512
 (
-    int16_t    stick_x, 
-    int16_t    stick_y, 
-    float     deadzone, 
-    float  *stick_xymn
+    void                *dst, 
+    size_t               len, 
+    uint8_t              val, 
+    size_t      nt_threshold
 )
 {
-    float  x = stick_x;
-    float  y = stick_y;
-    float  m = sqrtf(x * x + y * y);
-    float nx = x / m;
-    float ny = y / m;
+    uint8_t *d = (uint8_t*) dst;
+    __m512i  v;
 
-    if (m < deadzone)
-    {   // drop the input; it falls within the deadzone.
-        stick_xymn[0] = 0;
-        stick_xymn[1] = 0;
-        stick_xymn[2] = 0;
-        stick_xymn[3] = 0;
+    if (len < 64)
+    {
+        OsFillMemory_AVX2(dst, len, val, nt_threshold);
+        return;
     }
-    else
-    {   // rescale the input into the non-dead space.
-        float n = (m - deadzone) / (1.0f - deadzone);
-        stick_xymn[0] = nx * n;
-        stick_xymn[1] = ny * n;
-        stick_xymn[2] = m;
-        stick_xymn[3] = n;
+    v = _mm512_set1_epi8((char) val);
+    _mm512_storeu_si512((void*) d, v);
+    _mm512_storeu_si512((void*)(d + len - 64), v);
+    if (len > 128)
+    {
+        size_t skip = 64 - ((uintptr_t) d & 63);
+        uint8_t *dp = d + skip;
+        size_t    n = len - skip;
+        if (len >= nt_threshold)
+        {
+            for ( ; n >= 256; n -= 256, dp += 256)
+            {
+                _mm512_stream_si512((__m512i*)(dp +   0), v);
+                _mm512_stream_si512((__m512i*)(dp +  64), v);
+                _mm512_stream_si512((__m512i*)(dp + 128), v);
+                _mm512_stream_si512((__m512i*)(dp + 192), v);
+            }
+            _mm_sfence();
+        }
+        for ( ; n >= 256; n -= 256, dp += 256)
+        {
+            _mm512_store_si512((void*)(dp +   0), v);
+            _mm512_store_si512((void*)(dp +  64), v);
+            _mm512_store_si512((void*)(dp + 128), v);
+            _mm512_store_si512((void*)(dp + 192), v);
+        }
+        for ( ; n >= 64; n -= 64, dp += 64)
+        {
+            _mm512_store_si512((void*) dp, v);
+        }
     }
 }
 
-/// @summary Process an XInput gamepad packet to apply deadzone logic and update button states.
-/// @param input The XInput gamepad packet to process.
-/// @param port_index The zero-based index of the port to which the gamepad is connected.
-/// @param devices The list of gamepad devices to update.
-/// @return The zero-based index of the input device in the device list, or OS_INPUT_DEVICE_TOO_MANY.
-internal_function size_t
-OsProcessGamepadPacket
+/// @summary Lexicographically compare two blocks of memory using 512-bit AVX-512BW comparisons.
+/// @param a The address of the first block.
+/// @param b The address of the second block.
+/// @param len The number of bytes to compare.
+/// @return Zero if the blocks are equal, or the difference between the first pair of mismatched bytes, interpreted as unsigned.
+internal_function OS_TARGET_AVX512 int
+OsCompareMemory_AVX512
 (
-    XINPUT_STATE const *input, 
-    DWORD          port_index, 
-    OS_GAMEPAD_LIST  *devices
+    void const *a, 
+    void const *b, 
+    size_t    len
 )
 {
-    OS_GAMEPAD_STATE *state = NULL;
-    uintptr_t       pDevice =(uintptr_t) port_index;
-    HANDLE          hDevice =(HANDLE) pDevice;
-    size_t            index = 0;
+    uint8_t const *pa = (uint8_t const*) a;
+    uint8_t const *pb = (uint8_t const*) b;
+    size_t          i = 0;
 
-    // locate the pointer in the current state buffer by port index.
-    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+    if (len < 64)
     {
-        if (devices->DeviceHandle[i] == hDevice)
-        {   // found the matching device.
-            index = i;
-            state =&devices->DeviceState[i];
+        return OsCompareMemory_AVX2(a, b, len);
+    }
+    for ( ; i + 256 <= len; i += 256)
+    {
+        __mmask64 n0 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((void const*)(pa + i +   0)), _mm512_loadu_si512((void const*)(pb + i +   0)));
+        __mmask64 n1 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((void const*)(pa + i +  64)), _mm512_loadu_si512((void const*)(pb + i +  64)));
+        __mmask64 n2 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((void const*)(pa + i + 128)), _mm512_loadu_si512((void const*)(pb + i + 128)));
+        __mmask64 n3 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((void const*)(pa + i + 192)), _mm512_loadu_si512((void const*)(pb + i + 192)));
+        if ((n0 | n1 | n2 | n3) != 0)
             break;
-        }
     }
-    if (state == NULL)
-    {   // this device was newly attached.
-        if (devices->DeviceCount == OS_GAMEPAD_LIST::MAX_DEVICES)
-        {   // there are too many devices of the specified type attached.
-            return OS_INPUT_DEVICE_TOO_MANY;
+    for ( ; ; i += 64)
+    {
+        uint64_t diff;
+        if (i + 64 > len)
+        {
+            if (i >= len) break;
+            i = len - 64;
         }
-        index  = devices->DeviceCount++;
-        state  =&devices->DeviceState[index];
-        devices->DeviceHandle[index] = hDevice;
-        devices->DeviceState [index] = OS_GAMEPAD_STATE_STATIC_INIT;
+        diff = (uint64_t) _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((void const*)(pa + i)), _mm512_loadu_si512((void const*)(pb + i)));
+        if (diff != 0)
+        {
+            size_t k = i + OsBitScanForward64(diff);
+            return int(pa[k]) - int(pb[k]);
+        }
+        if (i + 64 == len)
+            break;
     }
-
-    // apply deadzone filtering to the trigger inputs.
-    state->LTrigger = input->Gamepad.bLeftTrigger  > XINPUT_GAMEPAD_TRIGGER_THRESHOLD ? input->Gamepad.bLeftTrigger  : 0;
-    state->RTrigger = input->Gamepad.bRightTrigger > XINPUT_GAMEPAD_TRIGGER_THRESHOLD ? input->Gamepad.bRightTrigger : 0;
-    // copy over the button state bits as-is.
-    state->Buttons  = input->Gamepad.wButtons;
-    // apply deadzone filtering to the analog stick inputs.
-    float const l_deadzone = XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE  / 32767.0f;
-    float const r_deadzone = XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE / 32767.0f;
-    OsScaledRadialDeadzone(input->Gamepad.sThumbLX, input->Gamepad.sThumbLY, l_deadzone, state->LStick);
-    OsScaledRadialDeadzone(input->Gamepad.sThumbRX, input->Gamepad.sThumbRY, r_deadzone, state->RStick);
-    return index;
+    return 0;
 }
 
-/// @summary Poll XInput gamepads attached to the system and update the input device state.
-/// @param devices The list of gamepad devices to update.
-/// @param ports_in A bitvector specifying the gamepad ports to poll. Specify OS_ALL_GAMEPAD_PORTS to poll all possible ports. MSDN recommends against polling unattached ports each frame.
-/// @param ports_out A bitvector specifying the attached gamepad ports. Bit x is set if port x has an attached gamepad.
-/// @return The number of gamepads attached to the system (the number of bits set in ports_out.)
-internal_function size_t
-OsPollGamepads
+/// @summary Build the set of bulk memory kernels for a given instruction set.
+/// @param instruction_set One of OS_MEMORY_ISA. The value is clamped to the most capable instruction set supported by the host.
+/// @param streaming_threshold The minimum transfer size, in bytes, that uses non-temporal stores, or 0 to derive the threshold from the host cache size.
+/// @return The kernel set.
+internal_function OS_MEMORY_ROUTINES
+OsResolveMemoryRoutines
 (
-    OS_GAMEPAD_LIST *devices,
-    uint32_t        ports_in,
-    uint32_t      &ports_out
+    int32_t     instruction_set, 
+    size_t  streaming_threshold
 )
 {
-    size_t   const max_gamepads = 4;
-    size_t         num_gamepads = 0;
-    uint32_t const port_bits[4] = {
-        (1UL << 0UL), 
-        (1UL << 1UL), 
-        (1UL << 2UL), 
-        (1UL << 3UL)
-    };
-    // clear all attached port bits in the output:
-    ports_out = 0;
-    // poll any ports whose corresponding bit is set in ports_in.
-    for (size_t i = 0; i < max_gamepads; ++i)
+    OS_MEMORY_ROUTINES routines = {};
+    int32_t             max_isa = OsDetectMemoryInstructionSet();
+
+    if (instruction_set == OS_MEMORY_ISA_AUTO || instruction_set > max_isa)
+        instruction_set  = max_isa;
+    if (streaming_threshold == 0)
+        streaming_threshold = OsDetectStreamingThreshold();
+
+    switch (instruction_set)
     {
-        if (ports_in & port_bits[i])
-        {
-            XINPUT_STATE state = {};
-            DWORD       result = XInputGetState_Func((DWORD) i, &state);
-            if (result == ERROR_SUCCESS)
-            {   // gamepad port i is attached and in use.
-                ports_out |= port_bits[i];
-                // update the corresponding input state.
-                OsProcessGamepadPacket(&state, (DWORD) i, devices);
-                num_gamepads++;
-            }
-        }
+        case OS_MEMORY_ISA_AVX512:
+            { routines.CopyMemory    = OsCopyMemory_AVX512;
+              routines.FillMemory    = OsFillMemory_AVX512;
+              routines.CompareMemory = OsCompareMemory_AVX512;
+            } break;
+        case OS_MEMORY_ISA_AVX2:
+            { routines.CopyMemory    = OsCopyMemory_AVX2;
+              routines.FillMemory    = OsFillMemory_AVX2;
+              routines.CompareMemory = OsCompareMemory_AVX2;
+            } break;
+        default:
+            { routines.CopyMemory    = OsCopyMemory_SSE2;
+              routines.FillMemory    = OsFillMemory_SSE2;
+              routines.CompareMemory = OsCompareMemory_SSE2;
+              instruction_set        = OS_MEMORY_ISA_SSE2;
+            } break;
     }
-    return num_gamepads;
+    routines.StreamingThreshold = streaming_threshold;
+    routines.InstructionSet     = instruction_set;
+    return routines;
 }
 
-/// @summary Given a two device list snapshots, populate a device set specifying whether a given device is in none, one or both snapshots.
-/// @param set The device set to populate. This set should be initialized with OS_INPUT_DEVICE_SET_STATIC_INIT prior to calling this function.
-/// @param prev The device list from the previous state snapshot.
-/// @param curr The device list from the current state snapshot.
-template <typename T>
-internal_function void
-OsDetermineDeviceSet
+/// @summary Retrieve the active set of bulk memory kernels. The kernels are selected for the host CPU the first time this function is called.
+/// @return A pointer to the active kernel set.
+internal_function inline OS_MEMORY_ROUTINES*
+OsMemoryRoutines
 (
-    OS_INPUT_DEVICE_SET      *set, 
-    OS_INPUT_DEVICE_LIST<T> *prev,
-    OS_INPUT_DEVICE_LIST<T> *curr
+    void
 )
-{   assert(set->DeviceCount == 0);
-    // build a table of 'unique' devices and which set(s) they belong to.
-    set->DeviceCount = prev->DeviceCount;
-    for (size_t i = 0, n = prev->DeviceCount; i < n; ++i)
-    {   // the table starts out empty, so this step is just a simple copy.
-        set->DeviceIds [i] = prev->DeviceHandle[i];
-        set->Membership[i] = OS_INPUT_DEVICE_MEMBERSHIP_PREV;
-        set->PrevIndex [i] =(uint8_t) i;
-    }
-    for (size_t i = 0, n = curr->DeviceCount; i < n; ++i)
-    {   // the table may not be empty, so filter out duplicate devices.
-        HANDLE id = curr->DeviceHandle[i];
-        size_t ix = set->DeviceCount;
-        size_t in = 1;
-        for (size_t j = 0, m = set->DeviceCount; j < m; ++j)
+{
+    local_persist OS_MEMORY_ROUTINES routines = OsResolveMemoryRoutines(OS_MEMORY_ISA_AUTO, 0);
+    return &routines;
+}
+
+/// @summary Record an allocator event in the active allocation trace, if any.
+/// @param allocator The address of the allocator object generating the event.
+/// @param caller The return address of the public allocator function, as returned by OS_RETURN_ADDRESS().
+/// @param event One of OS_ALLOCATION_EVENT.
+/// @param offset The byte offset or address of the block.
+/// @param size The size of the block, in bytes.
+/// @param alignment The requested alignment, in bytes, or zero if not applicable.
+internal_function inline void
+OsAllocationTraceRecord
+(
+    void const *allocator, 
+    void const    *caller, 
+    uint32_t        event, 
+    uint64_t       offset, 
+    uint64_t         size, 
+    size_t      alignment
+)
+{
+    OS_ALLOCATION_TRACE *trace = AllocationTrace;
+    if (trace != NULL)
+    {   // claim an index, then claim the slot by marking it as being written.
+        // writers from different laps of the ring can map to the same slot, so 
+        // the slot is claimed with a CAS; only one writer fills it at a time.
+        uint64_t                 index = trace->WriteIndex.fetch_add(1, std::memory_order_relaxed);
+        OS_ALLOCATION_TRACE_SLOT *slot = &trace->Slots[index & (trace->Capacity - 1)];
+        uint64_t               writing = (index * 2) + 1;
+        uint64_t              sequence = slot->Sequence.load(std::memory_order_relaxed);
+        uint32_t            spin_count = 0;
+        for ( ; ; )
         {
-            if (set->DeviceIds[j] == id)
-            {   // found an existing entry with the same handle.
-                ix = j; // update the existing entry.
-                in = 0; // don't increment the device count.
+            if (sequence >= writing)
+            {   // a writer from a later lap has claimed the slot; this record would be overwritten anyway.
+                return;
+            }
+            if (sequence & 1)
+            {   // a writer from an earlier lap is still filling the slot. yield if it appears to be descheduled.
+                if (++spin_count < 64)
+                {
+                    _mm_pause();
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+                sequence = slot->Sequence.load(std::memory_order_relaxed);
+            }
+            else if (slot->Sequence.compare_exchange_weak(sequence, writing, std::memory_order_relaxed, std::memory_order_relaxed))
+            {   // the slot is claimed.
                 break;
             }
         }
-        set->DeviceIds [ix]  = id;
-        set->Membership[ix] |= OS_INPUT_DEVICE_MEMBERSHIP_CURR;
-        set->CurrIndex [ix]  =(uint8_t) i;
-        set->DeviceCount    += in;
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->Record.Timestamp = OsTimestampInTicks();
+        slot->Record.Allocator = allocator;
+        slot->Record.Caller    = caller;
+        slot->Record.Offset    = offset;
+        slot->Record.Size      = size;
+        slot->Record.Alignment =(uint32_t) alignment;
+        slot->Record.Event     = event;
+        slot->Record.ThreadId  = OsThreadId();
+        slot->Sequence.store(writing + 1, std::memory_order_release);
     }
 }
 
-/// @summary Given two keyboard state snapshots, generate keyboard events for keys down, pressed and released.
-/// @param keys The keyboard events data to populate.
-/// @param prev The previous keyboard state snapshot.
-/// @param curr The current keyboard state snapshot.
-internal_function void
-OsGenerateKeyboardInputEvents
+/// @summary Read a small text file, such as a cgroup interface file, into a nul-terminated buffer.
+/// @param path The nul-terminated path of the file to read.
+/// @param buffer The buffer receiving the file contents.
+/// @param buffer_size The maximum number of bytes that can be written to buffer, including the nul terminator.
+/// @return true if at least one byte was read from the file.
+internal_function bool
+OsReadTextFile
 (
-    OS_KEYBOARD_EVENTS      *keys,
-    OS_KEYBOARD_STATE const *prev, 
-    OS_KEYBOARD_STATE const *curr
+    char const   *path, 
+    char       *buffer, 
+    size_t buffer_size
 )
 {
-    keys->DownCount     = 0;
-    keys->PressedCount  = 0;
-    keys->ReleasedCount = 0;
-    for (size_t i = 0; i < 8; ++i)
+#if defined(__linux__)
+    int      fd = open(path, O_RDONLY | O_CLOEXEC);
+    ssize_t  nb = 0;
+    if (fd < 0)
+    {   // the file does not exist, or is not accessible. not an error.
+        return false;
+    }
+    nb = read(fd, buffer, buffer_size - 1);
+    close(fd);
+    if (nb <= 0)
     {
-        uint32_t curr_state = curr->KeyState[i];
-        uint32_t prev_state = prev->KeyState[i];
-        uint32_t    changes =(curr_state ^  prev_state);
-        uint32_t      downs =(changes    &  curr_state);
-        uint32_t        ups =(changes    & ~curr_state);
+        return false;
+    }
+    buffer[nb] = '\0';
+    return true;
+#else
+    UNREFERENCED_PARAMETER(path);
+    UNREFERENCED_PARAMETER(buffer);
+    UNREFERENCED_PARAMETER(buffer_size);
+    return false;
+#endif
+}
 
-        for (uint32_t j = 0; j < 32; ++j)
-        {
-            uint32_t mask = (1 << j);
-            uint8_t  vkey = (uint8_t) ((i << 5) + j);
+/// @summary Parse an unsigned decimal value at the start of a string, as written to cgroup interface files.
+/// @param text The nul-terminated string to parse. The string "max" is interpreted as no limit.
+/// @param value On return, the parsed value, or UINT64_MAX if text is "max".
+/// @return true if the string started with a value.
+internal_function bool
+OsParseMemoryValue
+(
+    char const  *text, 
+    uint64_t   &value
+)
+{
+    if (text[0] == 'm' && text[1] == 'a' && text[2] == 'x')
+    {
+        value = UINT64_MAX;
+        return true;
+    }
+    if (text[0] < '0' || text[0] > '9')
+    {
+        return false;
+    }
+    for (value = 0; *text >= '0' && *text <= '9'; ++text)
+    {
+        value = (value * 10) + uint64_t(*text - '0');
+    }
+    return true;
+}
 
-            if ((curr_state & mask) != 0 && keys->DownCount < OS_KEYBOARD_EVENTS::MAX_KEYS)
-            {   // this key is currently pressed.
-                keys->Down[keys->DownCount++] = vkey;
+/// @summary Determine the memory limit that applies to the calling process, and where usage against that limit can be read.
+/// On Linux, the limit is the smallest cgroup v2 memory.max of the cgroup containing the process and all of its ancestors. 
+/// On Windows, the limit is the smaller of the process and job memory limits of the job object containing the process.
+/// If neither applies, the limit is the amount of installed physical memory.
+/// @param budget The OS_MEMORY_BUDGET whose Limit, LimitSource and UsagePath fields are set.
+internal_function void
+OsMemoryBudgetDetectLimit
+(
+    OS_MEMORY_BUDGET *budget
+)
+{
+    uint64_t limit = UINT64_MAX;
+    budget->UsagePath[0] = '\0';
+#if defined(__linux__)
+    char   cgroup[OS_MEMORY_BUDGET::MAX_PATH_CHARS];
+    char     path[OS_MEMORY_BUDGET::MAX_PATH_CHARS];
+    char    value[64];
+    char const  *root = "/sys/fs/cgroup";
+    size_t  root_len  = strlen(root);
+    if (OsReadTextFile("/proc/self/cgroup", cgroup, sizeof(cgroup)))
+    {   // a process in the cgroup v2 hierarchy has a line of the form 0::/path. 
+        char *line = cgroup;
+        while (*line != '\0' && !(line[0] == '0' && line[1] == ':' && line[2] == ':' && line[3] == '/'))
+        {   // skip cgroup v1 controller lines.
+            while (*line != '\0' && *line != '\n') ++line;
+            if   (*line == '\n') ++line;
+        }
+        if (*line != '\0')
+        {   // build the path of the cgroup directory, without a trailing slash.
+            char const *rel = line + 3;
+            size_t      len = root_len;
+            OsCopyMemory(path, root, root_len);
+            while (*rel != '\0' && *rel != '\n' && len < sizeof(path) - 16)
+            {
+                path[len++] = *rel++;
             }
-            if ((downs & mask) != 0 && keys->PressedCount < OS_KEYBOARD_EVENTS::MAX_KEYS)
-            {   // this key was just pressed.
-                keys->Pressed[keys->PressedCount++] = vkey;
+            while (len > root_len && path[len - 1] == '/')
+            {
+                len--;
             }
-            if ((ups & mask) != 0 && keys->ReleasedCount < OS_KEYBOARD_EVENTS::MAX_KEYS)
-            {   // this key was just released.
-                keys->Released[keys->ReleasedCount++] = vkey;
+            path[len] = '\0';
+            if (len + 16 < sizeof(path))
+            {   // usage is read from the cgroup containing the process.
+                OsCopyMemory(budget->UsagePath, path, len);
+                OsCopyMemory(budget->UsagePath + len, "/memory.current", 16);
+                // any ancestor may impose a lower limit, so walk up to the root of the mounted hierarchy.
+                for ( ; ; )
+                {
+                    uint64_t max_bytes = 0;
+                    OsCopyMemory(path + len, "/memory.max", 12);
+                    if (OsReadTextFile(path, value, sizeof(value)) && OsParseMemoryValue(value, max_bytes) && max_bytes < limit)
+                    {
+                        limit = max_bytes;
+                    }
+                    if (len <= root_len)
+                        break;
+                    while (len > root_len && path[len - 1] != '/')
+                        len--;
+                    if (len > root_len)
+                        len--;
+                }
             }
         }
     }
+    if (limit != UINT64_MAX)
+    {
+        budget->Limit       = limit;
+        budget->LimitSource = OS_MEMORY_BUDGET_SOURCE_CGROUP;
+        return;
+    }
+    budget->UsagePath[0] = '\0';
+    budget->Limit        = uint64_t(sysconf(_SC_PHYS_PAGES)) * uint64_t(sysconf(_SC_PAGESIZE));
+    budget->LimitSource  = OS_MEMORY_BUDGET_SOURCE_PHYSICAL;
+#else
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION job;
+    MEMORYSTATUSEX                    status;
+    ZeroMemory(&job, sizeof(job));
+    // a NULL handle queries the job object containing the calling process, if any.
+    if (QueryInformationJobObject(NULL, JobObjectExtendedLimitInformation, &job, sizeof(job), NULL))
+    {
+        if ((job.BasicLimitInformation.LimitFlags & JOB_OBJECT_LIMIT_PROCESS_MEMORY) && job.ProcessMemoryLimit < limit)
+            limit = job.ProcessMemoryLimit;
+        if ((job.BasicLimitInformation.LimitFlags & JOB_OBJECT_LIMIT_JOB_MEMORY) && job.JobMemoryLimit < limit)
+            limit = job.JobMemoryLimit;
+    }
+    if (limit != UINT64_MAX)
+    {
+        budget->Limit       = limit;
+        budget->LimitSource = OS_MEMORY_BUDGET_SOURCE_JOB_OBJECT;
+        return;
+    }
+    status.dwLength = sizeof(status);
+    GlobalMemoryStatusEx(&status);
+    budget->Limit       = status.ullTotalPhys;
+    budget->LimitSource = OS_MEMORY_BUDGET_SOURCE_PHYSICAL;
+#endif
 }
 
-/// @summary Generate keyboard device and input events for all keyboard devices given two device list snapshots.
-/// @param events The input events structure to populate.
-/// @param prev The device list from the previous tick.
-/// @param curr The device list from the current tick.
-internal_function void
-OsGenerateKeyboardEvents
+/// @summary Read the memory usage of the process, as charged against its limit by the operating system.
+/// On Linux this is the cgroup memory.current, which counts pages as they are first touched and includes the page cache, 
+/// or the resident set size if the process has no cgroup limit. On Windows this is the private commit charge of the process.
+/// @param budget The OS_MEMORY_BUDGET specifying where usage is read from.
+/// @param usage On return, the usage in bytes.
+/// @return true if the usage was read successfully.
+internal_function bool
+OsMemoryBudgetReadUsage
 (
-    OS_INPUT_EVENTS *events, 
-    OS_KEYBOARD_LIST  *prev,
-    OS_KEYBOARD_LIST  *curr
+    OS_MEMORY_BUDGET *budget, 
+    uint64_t          &usage
 )
 {
-    OS_INPUT_DEVICE_SET device_set = OS_INPUT_DEVICE_SET_STATIC_INIT;
-
-    // determine the device set, which is used to determine whether devices were added or removed, 
-    // and also whether or not (or how) to generate state-based input events for a given device.
-    OsDetermineDeviceSet(&device_set, prev, curr);
-
-    // loop through each individual device and emit events.
-    events->KeyboardAttachCount = 0;
-    events->KeyboardRemoveCount = 0;
-    events->KeyboardCount       = 0;
-    for (size_t i = 0, n = device_set.DeviceCount; i < n; ++i)
+#if defined(__linux__)
+    char value[128];
+    if (budget->UsagePath[0] != '\0')
     {
-        switch (device_set.Membership[i])
-        {
-            case OS_INPUT_DEVICE_MEMBERSHIP_PREV:
-                {   // this input device was just removed. no device state events are generated.
-                    events->KeyboardRemove[events->KeyboardRemoveCount] = device_set.DeviceIds[i];
-                    events->KeyboardRemoveCount++;
-                } break;
-
-            case OS_INPUT_DEVICE_MEMBERSHIP_CURR:
-                {   // this input device was just attached. no device state events are generated.
-                    events->KeyboardAttach[events->KeyboardAttachCount] = device_set.DeviceIds[i];
-                    events->KeyboardAttachCount++;
-                } break;
-
-            case OS_INPUT_DEVICE_MEMBERSHIP_BOTH:
-                {   // this input device was present in both snapshots.
-                    OS_KEYBOARD_EVENTS *input_ev = &events->KeyboardEvents[events->KeyboardCount];
-                    OS_KEYBOARD_STATE  *state_pp = &prev->DeviceState[device_set.PrevIndex[i]];
-                    OS_KEYBOARD_STATE  *state_cp = &curr->DeviceState[device_set.CurrIndex[i]];
-                    events->KeyboardIds[events->KeyboardCount] = device_set.DeviceIds[i];
-                    OsGenerateKeyboardInputEvents(input_ev, state_pp, state_cp);
-                    events->KeyboardCount++;
-                } break;
-        }
+        return OsReadTextFile(budget->UsagePath, value, sizeof(value)) && OsParseMemoryValue(value, usage);
+    }
+    else
+    {   // /proc/self/statm reports sizes in pages; the second field is the resident set size.
+        char const *text = value;
+        if (!OsReadTextFile("/proc/self/statm", value, sizeof(value)))
+            return false;
+        while (*text != '\0' && *text != ' ') ++text;
+        while (*text == ' ') ++text;
+        if (!OsParseMemoryValue(text, usage))
+            return false;
+        usage *= uint64_t(sysconf(_SC_PAGESIZE));
+        return true;
+    }
+#else
+    PROCESS_MEMORY_COUNTERS_EX counters;
+    UNREFERENCED_PARAMETER(budget);
+    ZeroMemory(&counters, sizeof(counters));
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*) &counters, sizeof(counters)))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to query process memory usage (%08X).\n", __FUNCTION__, OsThreadId(), GetLastError());
+        return false;
     }
+    usage = counters.PrivateUsage;
+    return true;
+#endif
 }
 
-/// @summary Given two pointer device state snapshots, generate events for buttons down, pressed and released.
-/// @param pointer The pointer device events data to populate.
-/// @param prev The previous pointer device state snapshot.
-/// @param curr The current pointer device state snapshot.
+/// @summary Re-read the usage reported by the operating system, and discard the charges made since the previous read.
+/// @param budget The OS_MEMORY_BUDGET to refresh.
+/// @param wait Specify true to wait for a refresh in progress on another thread, or false to skip the refresh in that case.
 internal_function void
-OsGeneratePointerInputEvents
+OsMemoryBudgetRefresh
 (
-    OS_POINTER_EVENTS   *pointer, 
-    OS_POINTER_STATE const *prev, 
-    OS_POINTER_STATE const *curr
+    OS_MEMORY_BUDGET *budget, 
+    bool                wait
 )
-{   // copy cursor and wheel data, and generate relative data.
-    pointer->Cursor[0]  = curr->Pointer[0];
-    pointer->Cursor[1]  = curr->Pointer[1];
-    pointer->WheelDelta = curr->Relative[2];
-    if (curr->Flags & OS_POINTER_FLAGS_ABSOLUTE)
-    {   // calculate relative values as the delta between states.
-        pointer->Mickeys[0] = curr->Relative[0] - prev->Relative[0];
-        pointer->Mickeys[1] = curr->Relative[1] - prev->Relative[1];
+{
+    if (wait)
+    {
+        OsLockMutex(&budget->Lock);
     }
-    else
-    {   // the driver specified relative values; copy them as-is.
-        pointer->Mickeys[0] = curr->Relative[0];
-        pointer->Mickeys[1] = curr->Relative[1];
+    else if (!OsTryLockMutex(&budget->Lock))
+    {   // another thread is refreshing or dispatching; its result will do.
+        return;
     }
-
-    uint32_t curr_state = curr->Buttons;
-    uint32_t prev_state = prev->Buttons;
-    uint32_t    changes =(curr_state ^  prev_state);
-    uint32_t      downs =(changes    &  curr_state);
-    uint32_t        ups =(changes    & ~curr_state);
-
-    // generate the button events. check each bit in the buttons mask.
-    pointer->DownCount     = 0;
-    pointer->PressedCount  = 0;
-    pointer->ReleasedCount = 0;
-    for (uint32_t i = 0; i < 16; ++i)
+    // charges made after the load are kept, and are counted twice if the operating system already sees them, which errs on the safe side.
+    int64_t  charged = budget->ChargedSinceRefresh.load(std::memory_order_relaxed);
+    uint64_t   usage = 0;
+    if (OsMemoryBudgetReadUsage(budget, usage))
     {
-        uint32_t mask   = (1UL << i);
-        uint16_t button = (uint16_t) mask;
-
-        if ((curr_state & mask) != 0 && pointer->DownCount < OS_POINTER_EVENTS::MAX_BUTTONS)
-        {   // this button is currently pressed.
-            pointer->Down[pointer->DownCount++] = button;
-        }
-        if ((downs & mask) != 0 && pointer->PressedCount < OS_POINTER_EVENTS::MAX_BUTTONS)
-        {   // this button was just pressed.
-            pointer->Pressed[pointer->PressedCount++] = button;
-        }
-        if ((ups & mask) != 0 && pointer->ReleasedCount < OS_POINTER_EVENTS::MAX_BUTTONS)
-        {   // this button was just released.
-            pointer->Released[pointer->ReleasedCount++] = button;
-        }
+        budget->SystemUsage.store(usage, std::memory_order_relaxed);
+        budget->ChargedSinceRefresh.fetch_sub(charged, std::memory_order_relaxed);
+        budget->RefreshCount.fetch_add(1, std::memory_order_relaxed);
     }
+    OsUnlockMutex(&budget->Lock);
 }
 
-/// @summary Generate pointer device and input events for all pointer devices given two device list snapshots.
-/// @param events The input events structure to populate.
-/// @param prev The device list from the previous tick.
-/// @param curr The device list from the current tick.
-internal_function void
-OsGeneratePointerEvents
+/// @summary Calculate the estimated memory usage for a budget.
+/// @param budget The OS_MEMORY_BUDGET to query.
+/// @param pending The number of bytes about to be committed, or zero.
+/// @return The estimated usage, in bytes.
+internal_function inline uint64_t
+OsMemoryBudgetEstimateUsage
 (
-    OS_INPUT_EVENTS *events, 
-    OS_POINTER_LIST   *prev,
-    OS_POINTER_LIST   *curr
+    OS_MEMORY_BUDGET *budget, 
+    uint64_t         pending
 )
 {
-    OS_INPUT_DEVICE_SET device_set = OS_INPUT_DEVICE_SET_STATIC_INIT;
-
-    // determine the device set, which is used to determine whether devices were added or removed, 
-    // and also whether or not (or how) to generate state-based input events for a given device.
-    OsDetermineDeviceSet(&device_set, prev, curr);
-
-    // loop through each individual device and emit events.
-    events->PointerAttachCount = 0;
-    events->PointerRemoveCount = 0;
-    events->PointerCount       = 0;
-    for (size_t i = 0, n = device_set.DeviceCount; i < n; ++i)
-    {
-        switch (device_set.Membership[i])
-        {
-            case OS_INPUT_DEVICE_MEMBERSHIP_PREV:
-                {   // this input device was just removed. no device state events are generated.
-                    events->PointerRemove[events->PointerRemoveCount] = device_set.DeviceIds[i];
-                    events->PointerRemoveCount++;
-                } break;
-
-            case OS_INPUT_DEVICE_MEMBERSHIP_CURR:
-                {   // this input device was just attached. no device state events are generated.
-                    events->PointerAttach[events->PointerAttachCount] = device_set.DeviceIds[i];
-                    events->PointerAttachCount++;
-                } break;
-
-            case OS_INPUT_DEVICE_MEMBERSHIP_BOTH:
-                {   // this input device was present in both snapshots.
-                    OS_POINTER_EVENTS *input_ev = &events->PointerEvents[events->PointerCount];
-                    OS_POINTER_STATE  *state_pp = &prev->DeviceState[device_set.PrevIndex[i]];
-                    OS_POINTER_STATE  *state_cp = &curr->DeviceState[device_set.CurrIndex[i]];
-                    events->PointerIds[events->PointerCount] = device_set.DeviceIds[i];
-                    OsGeneratePointerInputEvents(input_ev, state_pp, state_cp);
-                    events->PointerCount++;
-                } break;
-        }
-    }
+    int64_t usage = (int64_t) budget->SystemUsage.load(std::memory_order_relaxed) + budget->ChargedSinceRefresh.load(std::memory_order_relaxed);
+    return (usage > 0 ? uint64_t(usage) : 0) + pending;
 }
 
-/// @summary Given two gamepad device state snapshots, generate events for buttons down, pressed and released.
-/// @param pointer The gamepad device events data to populate.
-/// @param prev The previous gamepad device state snapshot.
-/// @param curr The current gamepad device state snapshot.
-internal_function void
-OsGenerateGamepadInputEvents
+/// @summary Determine the pressure level for a given amount of memory usage.
+/// @param budget The OS_MEMORY_BUDGET defining the thresholds.
+/// @param usage The memory usage, in bytes.
+/// @return One of OS_MEMORY_PRESSURE_LEVEL.
+internal_function inline uint32_t
+OsMemoryBudgetPressureLevel
 (
-    OS_GAMEPAD_EVENTS   *gamepad, 
-    OS_GAMEPAD_STATE const *prev,
-    OS_GAMEPAD_STATE const *curr
+    OS_MEMORY_BUDGET *budget, 
+    uint64_t           usage
 )
 {
-    gamepad->LeftTrigger         = (float) curr->LTrigger / (float) (255 - XINPUT_GAMEPAD_TRIGGER_THRESHOLD);
-    gamepad->RightTrigger        = (float) curr->RTrigger / (float) (255 - XINPUT_GAMEPAD_TRIGGER_THRESHOLD);
-    gamepad->LeftStick[0]        =  curr->LStick[0];
-    gamepad->LeftStick[1]        =  curr->LStick[1];
-    gamepad->LeftStickMagnitude  =  curr->LStick[3];
-    gamepad->RightStick[0]       =  curr->RStick[0];
-    gamepad->RightStick[1]       =  curr->RStick[1];
-    gamepad->RightStickMagnitude =  curr->RStick[3];
-
-    uint32_t curr_state = curr->Buttons;
-    uint32_t prev_state = prev->Buttons;
-    uint32_t    changes =(curr_state ^  prev_state);
-    uint32_t      downs =(changes    &  curr_state);
-    uint32_t        ups =(changes    & ~curr_state);
-
-    // generate the button events. check each bit in the buttons mask.
-    gamepad->DownCount     = 0;
-    gamepad->PressedCount  = 0;
-    gamepad->ReleasedCount = 0;
-    for (uint32_t i = 0; i < 16; ++i)
-    {
-        uint32_t mask   = (1UL << i);
-        uint16_t button = (uint16_t) mask;
+    if (usage >= budget->Thresholds[OS_MEMORY_PRESSURE_LEVEL_CRITICAL])
+        return OS_MEMORY_PRESSURE_LEVEL_CRITICAL;
+    if (usage >= budget->Thresholds[OS_MEMORY_PRESSURE_LEVEL_MODERATE])
+        return OS_MEMORY_PRESSURE_LEVEL_MODERATE;
+    return OS_MEMORY_PRESSURE_LEVEL_NONE;
+}
 
-        if ((curr_state & mask) != 0 && gamepad->DownCount < OS_GAMEPAD_EVENTS::MAX_BUTTONS)
-        {   // this button is currently pressed.
-            gamepad->Down[gamepad->DownCount++] = button;
+/// @summary Update the pressure level of a budget, invoking the registered callbacks if the level rises.
+/// @param budget The OS_MEMORY_BUDGET to evaluate.
+/// @param pending The number of bytes about to be committed, or zero.
+/// @return One of OS_MEMORY_PRESSURE_LEVEL specifying the updated pressure level.
+internal_function uint32_t
+OsMemoryBudgetEvaluate
+(
+    OS_MEMORY_BUDGET *budget, 
+    uint64_t         pending
+)
+{
+    uint64_t usage = OsMemoryBudgetEstimateUsage(budget, pending);
+    uint32_t level = OsMemoryBudgetPressureLevel(budget, usage);
+    uint32_t  curr = budget->Level.load(std::memory_order_acquire);
+    if (level < curr)
+    {   // only drop the level once usage is comfortably below the threshold, so callbacks don't fire repeatedly at the boundary.
+        uint32_t drop = OsMemoryBudgetPressureLevel(budget, usage + budget->Hysteresis);
+        if (drop < curr)
+        {
+            budget->Level.compare_exchange_strong(curr, drop, std::memory_order_release, std::memory_order_relaxed);
         }
-        if ((downs & mask) != 0 && gamepad->PressedCount < OS_GAMEPAD_EVENTS::MAX_BUTTONS)
-        {   // this button was just pressed.
-            gamepad->Pressed[gamepad->PressedCount++] = button;
+        return budget->Level.load(std::memory_order_relaxed);
+    }
+    if (level > curr)
+    {   // the level rose. only one thread dispatches a given transition.
+        OS_MEMORY_PRESSURE_CALLBACK callbacks[OS_MEMORY_BUDGET::MAX_CALLBACKS];
+        size_t                          count = 0;
+        OsLockMutex(&budget->Lock);
+        curr = budget->Level.load(std::memory_order_relaxed);
+        if (level > curr)
+        {   // publish the new level before running callbacks, so commits made by the callbacks do not dispatch again.
+            budget->Level.store(level, std::memory_order_release);
+            budget->DispatchCount.fetch_add(1, std::memory_order_relaxed);
+            for (size_t i = 0, n = budget->CallbackCount; i < n; ++i)
+            {
+                if (budget->Callbacks[i].Level <= level)
+                {
+                    callbacks[count++] = budget->Callbacks[i];
+                }
+            }
+            if (count > 0)
+            {   // counted while the lock is held, so an unregister that removes one of these callbacks waits for the dispatch.
+                budget->DispatchActive.fetch_add(1, std::memory_order_acquire);
+            }
         }
-        if ((ups & mask) != 0 && gamepad->ReleasedCount < OS_GAMEPAD_EVENTS::MAX_BUTTONS)
-        {   // this button was just released.
-            gamepad->Released[gamepad->ReleasedCount++] = button;
+        OsUnlockMutex(&budget->Lock);
+        if (count > 0)
+        {   // run the callbacks without the lock, so they can release memory and other threads can keep committing.
+            for (size_t i = 0; i < count; ++i)
+            {
+                callbacks[i].Callback(callbacks[i].Context, level, usage, budget->Limit);
+            }
+            budget->DispatchActive.fetch_sub(1, std::memory_order_release);
         }
+        return budget->Level.load(std::memory_order_relaxed);
     }
+    return curr;
 }
 
-/// @summary Generate gamepad device and input events for all gamepad devices given two device list snapshots.
-/// @param events The input events structure to populate.
-/// @param prev The device list from the previous tick.
-/// @param curr The device list from the current tick.
-internal_function void
-OsGenerateGamepadEvents
+/// @summary Charge a change in committed memory against the active memory budget, if any. Called by the host memory APIs.
+/// @param bytes The number of bytes being committed, or a negative value for bytes being released.
+/// @return true if the commit may proceed, or false if it would exceed the refuse threshold of the active budget.
+internal_function bool
+OsMemoryBudgetCharge
 (
-    OS_INPUT_EVENTS *events, 
-    OS_GAMEPAD_LIST   *prev,
-    OS_GAMEPAD_LIST   *curr
+    int64_t bytes
 )
 {
-    OS_INPUT_DEVICE_SET device_set = OS_INPUT_DEVICE_SET_STATIC_INIT;
-
-    // determine the device set, which is used to determine whether devices were added or removed, 
-    // and also whether or not (or how) to generate state-based input events for a given device.
-    OsDetermineDeviceSet(&device_set, prev, curr);
-
-    // loop through each individual device and emit events.
-    events->GamepadAttachCount = 0;
-    events->GamepadRemoveCount = 0;
-    events->GamepadCount       = 0;
-    for (size_t i = 0, n = device_set.DeviceCount; i < n; ++i)
-    {
-        DWORD   device_id = (DWORD) ((uintptr_t) device_set.DeviceIds[i]);
-        switch (device_set.Membership[i])
+    OS_MEMORY_BUDGET *budget = MemoryBudget;
+    if (budget == NULL || bytes == 0)
+    {   // no budget is active.
+        return true;
+    }
+    if (bytes > 0 && budget->RefuseThreshold != 0 && OsMemoryBudgetEstimateUsage(budget, uint64_t(bytes)) > budget->RefuseThreshold)
+    {   // get an accurate reading, and give the callbacks a chance to release memory before refusing the commit.
+        OsMemoryBudgetRefresh(budget, true);
+        OsMemoryBudgetEvaluate(budget, uint64_t(bytes));
+        if (OsMemoryBudgetEstimateUsage(budget, uint64_t(bytes)) > budget->RefuseThreshold)
         {
-            case OS_INPUT_DEVICE_MEMBERSHIP_PREV:
-                {   // this input device was just removed. no device state events are generated.
-                    events->GamepadRemove[events->GamepadRemoveCount] = device_id;
-                    events->GamepadRemoveCount++;
-                } break;
-
-            case OS_INPUT_DEVICE_MEMBERSHIP_CURR:
-                {   // this input device was just attached. no device state events are generated.
-                    events->GamepadAttach[events->GamepadAttachCount] = device_id;
-                    events->GamepadAttachCount++;
-                } break;
-
-            case OS_INPUT_DEVICE_MEMBERSHIP_BOTH:
-                {   // this input device was present in both snapshots.
-                    OS_GAMEPAD_EVENTS *input_ev = &events->GamepadEvents[events->GamepadCount];
-                    OS_GAMEPAD_STATE  *state_pp = &prev->DeviceState[device_set.PrevIndex[i]];
-                    OS_GAMEPAD_STATE  *state_cp = &curr->DeviceState[device_set.CurrIndex[i]];
-                    events->GamepadIds[events->GamepadCount] = device_id;
-                    OsGenerateGamepadInputEvents(input_ev, state_pp, state_cp);
-                    events->GamepadCount++;
-                } break;
+            OsLayerError("ERROR: %S(%u): Commit of %I64d bytes refused; memory budget of %I64u bytes exhausted.\n", __FUNCTION__, OsThreadId(), bytes, budget->Limit);
+            budget->RefusedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
     }
+    int64_t since = budget->ChargedSinceRefresh.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    budget->BytesCharged.fetch_add(bytes, std::memory_order_relaxed);
+    if (uint64_t(since < 0 ? -since : since) >= budget->RefreshInterval)
+    {   // enough has changed that the estimate may have drifted from what the operating system sees.
+        OsMemoryBudgetRefresh(budget, false);
+    }
+    OsMemoryBudgetEvaluate(budget, 0);
+    return true;
 }
 
-/// @summary Copy keyboard devices and state from the current 'current' buffer to the next 'current' buffer.
-/// @param dst The 'current' buffer for the next tick.
-/// @param src The 'current' buffer for the current tick.
-internal_function void
-OsForwardKeyboardBuffer
+/// @summary Given two timestamp values, calculate the number of nanoseconds between them.
+/// @param start_ticks The TimestampInTicks at the beginning of the measured interval.
+/// @param end_ticks The TimestampInTicks at the end of the measured interval.
+/// @param frequency The number of ticks-per-second of the clock used to capture the timestamp values.
+/// @return The elapsed time between the timestamps, specified in nanoseconds.
+internal_function uint64_t
+OsElapsedNanoseconds
 (
-    OS_KEYBOARD_LIST *dst, 
-    OS_KEYBOARD_LIST *src
+    uint64_t start_ticks, 
+    uint64_t   end_ticks, 
+    int64_t    frequency
 )
-{   // copy over the device list and key state.
-    CopyMemory(dst, src, sizeof(OS_KEYBOARD_LIST));
+{   // scale the tick value by the nanoseconds-per-second multiplier
+    // before scaling back down by ticks-per-second to avoid loss of precision.
+    return (1000000000ULL * (end_ticks - start_ticks)) / uint64_t(frequency);
 }
 
-/// @summary Copy pointer devices and state from the current 'current' buffer to the next 'current' buffer.
-/// @param dst The 'current' buffer for the next tick.
-/// @param src The 'current' buffer for the current tick.
-internal_function void
-OsForwardPointerBuffer
+/// @summary Determine the page protection applied to the committed pages of a host memory allocation.
+/// @param alloc_flags One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS.
+/// @return The PAGE_* protection value passed to VirtualAlloc, or on Linux, the PROT_* value passed to mprotect.
+internal_function uint32_t
+OsVmmPageProtection
 (
-    OS_POINTER_LIST *dst, 
-    OS_POINTER_LIST *src
+    uint32_t alloc_flags
 )
-{   // copy over the device list, but zero out the relative fields of the state.
-    CopyMemory(dst, src, sizeof(OS_POINTER_LIST));
-    for (size_t i = 0, n = dst->DeviceCount; i < n; ++i)
-    {
-        dst->DeviceState[i].Relative[0] = 0;
-        dst->DeviceState[i].Relative[1] = 0;
-        dst->DeviceState[i].Flags = OS_POINTER_FLAGS_NONE;
+{
+#if defined(__linux__)
+    uint32_t access = PROT_NONE;
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_READ)
+    {   // assume read-only access. access is upgraded if additional flags are set.
+        access = PROT_READ;
+    }
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_WRITE)
+    {   // write access implies read access to the memory.
+        access = PROT_READ | PROT_WRITE;
+    }
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_EXECUTE)
+    {   // execute implies read and write access to the memory.
+        access = PROT_READ | PROT_WRITE | PROT_EXEC;
+    }
+    if (alloc_flags == OS_HOST_MEMORY_ALLOCATION_FLAGS_NONE)
+    {   // use the default access; the memory is readable and writable.
+        access = PROT_READ | PROT_WRITE;
     }
+    return access;
+#else
+    uint32_t access = PAGE_NOACCESS;
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_READ)
+    {   // assume read-only access. access is upgraded if additional flags are set.
+        access = PAGE_READONLY;
+    }
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_WRITE)
+    {   // write access implies read access to the memory.
+        access = PAGE_READWRITE;
+    }
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_EXECUTE)
+    {   // execute implies read and write access to the memory.
+        access = PAGE_EXECUTE_READWRITE;
+    }
+    if (alloc_flags == OS_HOST_MEMORY_ALLOCATION_FLAGS_NONE)
+    {   // use the default access; the memory is readable and writable.
+        access = PAGE_READWRITE;
+    }
+    return access;
+#endif
 }
 
-/// @summary Copy gamepad devices and state from the current 'current' buffer to the next 'current' buffer.
-/// @param dst The 'current' buffer for the next tick.
-/// @param src The 'current' buffer for the current tick.
+/// @summary Retrieve the virtual memory page size and allocation granularity of the host operating system.
+/// @param page_size On return, set to the size of a VMM page, in bytes.
+/// @param granularity On return, set to the alignment of the base address of a reservation, in bytes.
 internal_function void
-OsForwardGamepadBuffer
+OsVmmQueryPageSize
 (
-    OS_GAMEPAD_LIST *dst, 
-    OS_GAMEPAD_LIST *src
+    size_t   &page_size, 
+    size_t &granularity
 )
 {
-    UNREFERENCED_PARAMETER(dst);
-    UNREFERENCED_PARAMETER(src);
+#if defined(__linux__)
+    long size = sysconf(_SC_PAGESIZE);
+    page_size = size > 0 ? size_t(size) : size_t(4096);
+    granularity = page_size;
+#else
+    SYSTEM_INFO sysinfo = {};
+    GetNativeSystemInfo(&sysinfo);
+    page_size = sysinfo.dwPageSize;
+    granularity = sysinfo.dwAllocationGranularity;
+#endif
 }
 
-/// @summary Push an item onto the private end of a task queue. This function can only be called by the thread that owns the queue, and may execute concurrently with one or more steal operations.
-/// @param queue The queue to receive the item.
-/// @param task_id The identifier of the task that is ready to run.
-/// @return true if the task was written to the queue.
-internal_function inline bool
-OsTaskQueuePush
+/// @summary Apply a NUMA memory policy to a range of reserved address space. The policy takes effect as pages are first touched.
+/// Only Linux applies the policy after reservation; on Windows, the preferred node is specified when the address space is reserved.
+/// @param base The base address of the range.
+/// @param size The size of the range, in bytes.
+/// @param numa_policy One of OS_HOST_MEMORY_NUMA_POLICY specifying how physical memory is placed.
+/// @param numa_node The zero-based index of the NUMA node, for OS_HOST_MEMORY_NUMA_POLICY_BIND.
+/// @return true if the policy was applied.
+internal_function bool
+OsVmmSetNumaPolicy
 (
-    OS_TASK_QUEUE *queue, 
-    os_task_id_t task_id
+    void           *base, 
+    size_t          size, 
+    uint32_t numa_policy, 
+    uint32_t   numa_node
 )
 {
-    int64_t b = queue->Private.load(std::memory_order_relaxed);      // atomically load the private end of the queue. only Push and Take may modify the private end.
-    queue->TaskIds[b & queue->Mask] = task_id;                       // store the new item at the end of the Tasks array.
-    std::atomic_thread_fence(std::memory_order_release);             // ensure that the task ID is written to the Tasks array.
-    queue->Private.store(b+1,std::memory_order_relaxed);             // make the new item visible to a concurrent steal/subsequent take operation (push to private end.)
+#if defined(__linux__)
+    unsigned long      nodemask[16] = {};
+    unsigned long const BITS = sizeof(unsigned long) * 8;
+    unsigned long const MAX_NODES = sizeof(nodemask) * 8;
+    unsigned long const MAX_NODE_ARG = MAX_NODES + 1; // the kernel reads maxnode - 1 bits of the mask.
+    int                      mode = MPOL_DEFAULT;
+    switch (numa_policy)
+    {
+        case OS_HOST_MEMORY_NUMA_POLICY_DEFAULT:
+            return true;
+        case OS_HOST_MEMORY_NUMA_POLICY_BIND:
+            {
+                if (numa_node >= MAX_NODES)
+                {
+                    OsLayerError("ERROR: %S(%u): Invalid NUMA node %u.\n", __FUNCTION__, OsThreadId(), numa_node);
+                    return false;
+                }
+                nodemask[numa_node / BITS] |= 1UL << (numa_node % BITS);
+                mode = MPOL_BIND;
+            } break;
+        case OS_HOST_MEMORY_NUMA_POLICY_INTERLEAVE:
+            {   // interleave across all of the nodes the process is allowed to allocate from.
+                if (syscall(SYS_get_mempolicy, NULL, nodemask, MAX_NODE_ARG, NULL, MPOL_F_MEMS_ALLOWED) != 0)
+                {
+                    OsLayerError("ERROR: %S(%u): Failed to query allowed NUMA nodes (errno = %d).\n", __FUNCTION__, OsThreadId(), errno);
+                    return false;
+                }
+                mode = MPOL_INTERLEAVE;
+            } break;
+        default:
+            {
+                OsLayerError("ERROR: %S(%u): Invalid NUMA policy %u.\n", __FUNCTION__, OsThreadId(), numa_policy);
+            } return false;
+    }
+    if (syscall(SYS_mbind, base, size, mode, nodemask, MAX_NODE_ARG, 0) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): mbind for %Iu bytes failed (errno = %d).\n", __FUNCTION__, OsThreadId(), size, errno);
+        return false;
+    }
+    return true;
+#else
+    UNREFERENCED_PARAMETER(base);
+    UNREFERENCED_PARAMETER(size);
+    UNREFERENCED_PARAMETER(numa_policy);
+    UNREFERENCED_PARAMETER(numa_node);
     return true;
+#endif
 }
 
-/// @summary Take an item from the private end of a task queue. This function can only be called by the thread that owns the queue, and may execute concurrently with one or more steal operations.
-/// @param queue The queue from which the item will be removed.
-/// @param more_items On return, this value is set to true if there was at least one additional item in the queue after the returned item was claimed.
-/// @return The task identifier, or OS_INVALID_TASK_ID if the queue is empty.
-internal_function os_task_id_t
-OsTaskQueueTake
+/// @summary Reserve a contiguous range of process address space, commit a leading portion of it, and optionally follow it with a guard page.
+/// Only the committed portion is charged against the system commit limit; the remainder is committed on demand with OsVmmCommit.
+/// @param reserve_size The number of bytes of address space to reserve, not including the guard page. This value must be a multiple of the page size.
+/// @param commit_size The number of bytes at the start of the range to commit. This value must be a multiple of the page size, and not more than reserve_size.
+/// @param guard_size The size of the trailing guard page, in bytes, or zero if no guard page is required.
+/// @param protection The page protection returned by OsVmmPageProtection.
+/// @param numa_policy One of OS_HOST_MEMORY_NUMA_POLICY specifying how physical memory is placed.
+/// @param numa_node The zero-based index of the NUMA node, for OS_HOST_MEMORY_NUMA_POLICY_BIND.
+/// @return The base address of the reserved range, or NULL if an error occurred.
+internal_function void*
+OsVmmReserve
 (
-    OS_TASK_QUEUE   *queue,
-    bool       &more_items
+    size_t reserve_size, 
+    size_t  commit_size, 
+    size_t   guard_size, 
+    uint32_t protection, 
+    uint32_t numa_policy, 
+    uint32_t   numa_node
 )
 {
-    int64_t b = queue->Private.load(std::memory_order_relaxed) - 1; // safe since no concurrent Push operation is allowed.
-    queue->Private.store(b , std::memory_order_relaxed);            // complete the 'pop' from the private end (LIFO).
-    std::atomic_thread_fence(std::memory_order_seq_cst);            // make the 'pop' visible to a concurrent steal.
-    int64_t t = queue->Public.load(std::memory_order_relaxed);
-
-    if (t <= b)
-    {   // the task queue is non-empty.
-        os_task_id_t task_id = queue->TaskIds[b & queue->Mask];
-        if (t != b)
-        {   // there's at least one more item in the queue; no need to race.
-            more_items = true;
-            return task_id;
-        }
-        // this was the last item in the queue. race to claim it.
-        if (!queue->Public.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed))
-        {   // this thread lost the race.
-            task_id = OS_INVALID_TASK_ID;
-        }
-        queue->Private.store(t + 1, std::memory_order_relaxed);
-        more_items = false;
-        return task_id;
+#if defined(__linux__)
+    // reserve inaccessible address space. MAP_NORESERVE prevents the kernel from 
+    // charging the whole range against swap; pages are committed with mprotect.
+    void *base = mmap(NULL, reserve_size + guard_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        OsLayerError("ERROR: %S(%u): mmap for %Iu bytes failed (errno = %d).\n", __FUNCTION__, OsThreadId(), reserve_size + guard_size, errno);
+        return NULL;
+    }
+    if (!OsVmmSetNumaPolicy(base, reserve_size, numa_policy, numa_node))
+    {   // OsVmmSetNumaPolicy output error information already.
+        munmap(base, reserve_size + guard_size);
+        return NULL;
+    }
+    if (commit_size > 0 && mprotect(base, commit_size, (int) protection) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): mprotect to commit %Iu bytes failed (errno = %d).\n", __FUNCTION__, OsThreadId(), commit_size, errno);
+        munmap(base, reserve_size + guard_size);
+        return NULL;
+    }
+    // the guard page keeps PROT_NONE. unlike PAGE_GUARD, it faults on every access, not just the first.
+    return base;
+#else
+    void *base = NULL;
+    if (numa_policy == OS_HOST_MEMORY_NUMA_POLICY_BIND)
+    {   // the preferred node is associated with the region at reservation time, and applies as pages are committed.
+        base = VirtualAllocExNuma(GetCurrentProcess(), NULL, reserve_size + guard_size, MEM_RESERVE, PAGE_NOACCESS, numa_node);
     }
     else
-    {   // the queue is currently empty.
-        more_items = false;
-        queue->Private.store(t, std::memory_order_relaxed);
-        return OS_INVALID_TASK_ID;
+    {   // Windows has no interleave policy, so use the default placement.
+        base = VirtualAlloc(NULL, reserve_size + guard_size, MEM_RESERVE, PAGE_NOACCESS);
+    }
+    if (base == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): VirtualAlloc for %Iu bytes failed (%08X).\n", __FUNCTION__, OsThreadId(), reserve_size + guard_size, GetLastError());
+        return NULL;
+    }
+    if (commit_size > 0 && VirtualAlloc(base, commit_size, MEM_COMMIT, protection) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): VirtualAlloc to commit %Iu bytes failed (%08X).\n", __FUNCTION__, OsThreadId(), commit_size, GetLastError());
+        VirtualFree(base, 0, MEM_RELEASE);
+        return NULL;
+    }
+    if (guard_size > 0 && VirtualAlloc((uint8_t*) base + reserve_size, guard_size, MEM_COMMIT, protection | PAGE_GUARD) == NULL)
+    {   // change the protection flags for the guard page only.
+        OsLayerError("ERROR: %S(%u): Failed to create guard page (%08X).\n", __FUNCTION__, OsThreadId(), GetLastError());
+        VirtualFree(base, 0, MEM_RELEASE);
+        return NULL;
     }
+    return base;
+#endif
 }
 
-/// @summary Attempt to steal an item from the public end of the queue. This function can be called by any thread EXCEPT the thread that owns the queue, and may execute concurrently with a push or take operation, and one or more steal operations.
-/// @param queue The queue from which the item will be removed.
-/// @param more_items On return, this value is set to true if there was at least one additional item in the queue after the returned item was claimed.
-/// @return The task identifier, or OS_INVALID_TASK_ID if the queue is empty or the calling thread lost the race for the last item.
-internal_function os_task_id_t
-OsTaskQueueSteal
+/// @summary Retrieve the size of a large (huge) VMM page on the host operating system.
+/// @return The large page size, in bytes, or zero if the host does not support large pages.
+internal_function size_t
+OsVmmQueryLargePageSize
 (
-    OS_TASK_QUEUE  *queue, 
-    bool      &more_items
+    void
 )
 {
-    int64_t t = queue->Public.load(std::memory_order_acquire);
-    std::atomic_thread_fence(std::memory_order_seq_cst);
-    int64_t b = queue->Private.load(std::memory_order_acquire);
-
-    if (t < b)
-    {   // the task queue is non-empty. save the task ID.
-        os_task_id_t task_id = queue->TaskIds[t & queue->Mask];
-        // race with other threads to claim the item.
-        if (queue->Public.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed))
-        {   // the calling thread won the race and claimed the item.
-            more_items = (t != b);
-            return task_id;
+#if defined(__linux__)
+    // the default huge page size is reported by the kernel in /proc/meminfo.
+    FILE    *fp = NULL;
+    char line[128];
+    size_t size_kb = 0;
+    if ((fp = fopen("/proc/meminfo", "r")) == NULL)
+    {   // procfs is unavailable; large pages cannot be used.
+        return 0;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        unsigned long value = 0;
+        if (sscanf(line, "Hugepagesize: %lu kB", &value) == 1)
+        {
+            size_kb = size_t(value);
+            break;
         }
-        else
-        {   // the calling thread lost the race and should try again.
-            more_items = false;
-            return OS_INVALID_TASK_ID;
+    }
+    fclose(fp);
+    return size_kb * 1024;
+#else
+    return GetLargePageMinimum();
+#endif
+}
+
+/// @summary Attempt to reserve a range of address space backed by large VMM pages.
+/// On Linux, pages are taken from the reserved hugetlbfs pool (MAP_HUGETLB) if possible, and the range is fully committed with no guard page.
+/// Otherwise, a range aligned to the large page size is reserved and marked as eligible for transparent huge pages, and retains its guard page.
+/// On Windows, the range is fully committed with MEM_LARGE_PAGES, which requires SeLockMemoryPrivilege, and has no guard page.
+/// @param reserve_size The number of bytes of address space to reserve, not including the guard page. On return, set to the actual number of bytes reserved.
+/// @param commit_size The number of bytes at the start of the range to commit. On return, set to the actual number of bytes committed.
+/// @param guard_size The size of the trailing guard page, in bytes, or zero if no guard page is required. On return, set to the actual size of the guard page.
+/// @param page_size On return, set to the size of the VMM pages backing the range.
+/// @param protection The page protection returned by OsVmmPageProtection.
+/// @param numa_policy One of OS_HOST_MEMORY_NUMA_POLICY specifying how physical memory is placed.
+/// @param numa_node The zero-based index of the NUMA node, for OS_HOST_MEMORY_NUMA_POLICY_BIND.
+/// @return The base address of the reserved range, or NULL if large pages are not available. The caller should fall back to OsVmmReserve.
+internal_function void*
+OsVmmReserveLargePages
+(
+    size_t &reserve_size, 
+    size_t  &commit_size, 
+    size_t   &guard_size, 
+    size_t    &page_size, 
+    uint32_t  protection, 
+    uint32_t numa_policy, 
+    uint32_t   numa_node
+)
+{
+    size_t large_page = OsVmmQueryLargePageSize();
+    size_t large_size = 0;
+    if (large_page == 0)
+    {   // the host does not support large pages.
+        return NULL;
+    }
+    large_size = OsAlignUp(reserve_size, large_page);
+
+#if defined(__linux__)
+    void *base = mmap(NULL, large_size, (int) protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base != MAP_FAILED && !OsVmmSetNumaPolicy(base, large_size, numa_policy, numa_node))
+    {   // the huge pages are not faulted in until first touch, so the policy can still be applied.
+        munmap(base, large_size);
+        return NULL;
+    }
+    if (base != MAP_FAILED)
+    {   // hugetlbfs pages are committed at mapping time, and the mapping cannot be split at small page granularity.
+        reserve_size = large_size;
+        commit_size  = large_size;
+        guard_size   = 0;
+        page_size    = large_page;
+        return base;
+    }
+    // no reserved huge pages are available - fall back to transparent huge pages.
+    // over-reserve so the range can be aligned to a large page boundary, then trim the excess.
+    size_t   map_size = large_size + guard_size + large_page;
+    uint8_t *map_addr = NULL;
+    uint8_t *aligned  = NULL;
+    size_t   head     = 0;
+    size_t   tail     = 0;
+    char     thp[128];
+    if (!OsReadTextFile("/sys/kernel/mm/transparent_hugepage/enabled", thp, sizeof(thp)) || strstr(thp, "[never]") != NULL)
+    {   // madvise(MADV_HUGEPAGE) succeeds even when transparent huge pages are disabled, so check the mode explicitly.
+        return NULL;
+    }
+    if ((base = mmap(NULL, map_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0)) == MAP_FAILED)
+    {
+        return NULL;
+    }
+    map_addr = (uint8_t*) base;
+    aligned  = (uint8_t*) OsAlignUp((size_t) map_addr, large_page);
+    head     = size_t(aligned - map_addr);
+    tail     = map_size - head - (large_size + guard_size);
+    if (head > 0) munmap(map_addr, head);
+    if (tail > 0) munmap(aligned + large_size + guard_size, tail);
+    if (madvise(aligned, large_size, MADV_HUGEPAGE) != 0)
+    {   // transparent huge pages are disabled on this host.
+        munmap(aligned, large_size + guard_size);
+        return NULL;
+    }
+    if (!OsVmmSetNumaPolicy(aligned, large_size, numa_policy, numa_node))
+    {
+        munmap(aligned, large_size + guard_size);
+        return NULL;
+    }
+    if (commit_size > 0)
+    {   // commit whole large pages so that they can be backed by huge pages.
+        commit_size = OsAlignUp(commit_size, large_page);
+        if (mprotect(aligned, commit_size, (int) protection) != 0)
+        {
+            munmap(aligned, large_size + guard_size);
+            return NULL;
         }
     }
+    reserve_size = large_size;
+    page_size    = large_page;
+    return aligned;
+#else
+    void *base = NULL;
+    if (numa_policy == OS_HOST_MEMORY_NUMA_POLICY_BIND)
+    {   // large pages are allocated immediately, so the preferred node must be specified here.
+        base = VirtualAllocExNuma(GetCurrentProcess(), NULL, large_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, protection, numa_node);
+    }
     else
-    {   // the queue is currently empty.
-        more_items = false;
-        return OS_INVALID_TASK_ID;
+    {
+        base = VirtualAlloc(NULL, large_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, protection);
+    }
+    if (base == NULL)
+    {   // typically ERROR_PRIVILEGE_NOT_HELD, or insufficient contiguous physical memory.
+        return NULL;
     }
+    // large pages are locked in physical memory and must be committed at reservation time.
+    reserve_size = large_size;
+    commit_size  = large_size;
+    guard_size   = 0;
+    page_size    = large_page;
+    return base;
+#endif
 }
 
-/// @summary Reset a task queue to empty.
-/// @param queue The queue to clear.
-internal_function inline void
-OsTaskQueueClear
+/// @summary Commit a leading portion of a range of address space previously reserved with OsVmmReserve.
+/// @param base The base address returned by OsVmmReserve.
+/// @param commit_size The total number of bytes at the start of the range that should be committed. This value must be a multiple of the page size.
+/// @param protection The page protection returned by OsVmmPageProtection.
+/// @return true if the range [base, base+commit_size) is committed.
+internal_function bool
+OsVmmCommit
 (
-    OS_TASK_QUEUE *queue
+    void         *base, 
+    size_t commit_size, 
+    uint32_t protection
 )
 {
-    queue->Public.store(0, std::memory_order_relaxed);
-    queue->Private.store(0, std::memory_order_relaxed);
-    std::atomic_thread_fence(std::memory_order_seq_cst);
+#if defined(__linux__)
+    if (mprotect(base, commit_size, (int) protection) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): mprotect to commit %Iu bytes failed (errno = %d).\n", __FUNCTION__, OsThreadId(), commit_size, errno);
+        return false;
+    }
+    return true;
+#else
+    if (VirtualAlloc(base, commit_size, MEM_COMMIT, protection) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): VirtualAlloc to commit %Iu bytes failed (%08X).\n", __FUNCTION__, OsThreadId(), commit_size, GetLastError());
+        return false;
+    }
+    return true;
+#endif
 }
 
-/// @summary Allocate the memory for a task queue and initialize the queue to empty.
-/// @param queue The task queue to initialize.
-/// @param capacity The capacity of the queue. This value must be a power of two greater than zero.
-/// @param arena The memory arena to allocate from. The caller should ensure that sufficient memory is available.
-/// @return Zero if the queue is created successfully, or -1 if an error occurred.
-internal_function int
-OsCreateTaskQueue
+/// @summary Release a range of address space previously reserved with OsVmmReserve.
+/// @param base The base address returned by OsVmmReserve.
+/// @param total_size The total size of the reservation, including any guard page, in bytes.
+internal_function void
+OsVmmRelease
 (
-    OS_TASK_QUEUE        *queue, 
-    size_t             capacity, 
-    OS_HOST_MEMORY_ARENA *arena
+    void       *base, 
+    size_t total_size
 )
-{   // the capacity must be a power of two.
-    assert((capacity & (capacity - 1)) == 0);
-    queue->Public.store(0, std::memory_order_relaxed);
-    queue->Private.store(0, std::memory_order_relaxed);
-    queue->Mask = int64_t(capacity) - 1;
-    queue->TaskIds = (os_task_id_t*) OsHostMemoryArenaAllocate(arena, capacity * sizeof(os_task_id_t), std::alignment_of<os_task_id_t>::value);
-    return queue->TaskIds != NULL ? 0 : -1;
+{
+#if defined(__linux__)
+    munmap(base, total_size);
+#else
+    UNREFERENCED_PARAMETER(total_size);
+    VirtualFree(base, 0, MEM_RELEASE);
+#endif
 }
 
-/// @summary Send an application-defined signal from one worker thread to one or more other worker threads in the same pool.
-/// @param iocp The I/O completion port handle for the thread pool.
-/// @param signal_arg The application-defined data to send as the signal.
-/// @param thread_count The number of waiting threads to signal.
-/// @param last_error If the function returns false, the system error code is stored in this location.
-/// @return true if the specified number of signal notifications were successfully posted to the thread pool.
-internal_function bool
-OsSignalWorkerThreads
+/// @summary Reserve and commit a block of read-write memory used internally by an allocator or diagnostic facility, charging it against the active memory budget.
+/// @param size The number of bytes to allocate. This value must be a multiple of the page size.
+/// @return The base address of the zero-initialized block, or NULL if the commit was refused or an error occurred.
+internal_function void*
+OsVmmAllocateMetadata
 (
-    HANDLE          iocp, 
-    uintptr_t signal_arg, 
-    size_t  thread_count, 
-    DWORD    &last_error
+    size_t size
 )
 {
-    for (size_t i = 0; i < thread_count; ++i)
-    {
-        if (!PostQueuedCompletionStatus(iocp, 0, signal_arg, NULL))
-        {   // only report the first failure.
-            if (last_error == ERROR_SUCCESS)
-            {   // save the error code.
-                last_error  = GetLastError();
-            } return false;
-        }
+    void *base = NULL;
+    if (!OsMemoryBudgetCharge((int64_t) size))
+    {   // OsMemoryBudgetCharge output error information already.
+        return NULL;
     }
-    return true;
+    if ((base = OsVmmReserve(size, size, 0, OsVmmPageProtection(OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE), OS_HOST_MEMORY_NUMA_POLICY_DEFAULT, 0)) == NULL)
+    {   // OsVmmReserve output error information already.
+        OsMemoryBudgetCharge(-(int64_t) size);
+        return NULL;
+    }
+    return base;
 }
 
-/// @summary Call from a thread pool worker only. Puts the worker thread to sleep until a signal is received on the pool, or the pool is shutting down.
-/// @param iocp The handle of the I/O completion port used to signal the thread pool.
-/// @param term The handle of the manual-reset event used to signal worker threads to terminate.
-/// @param tid The operating system thread identifier of the calling worker thread.
-/// @param key The location to receive the pointer value sent with the wake signal.
-/// @return One of OS_WORKER_THREAD_WAKE_REASON.
-internal_function int
-OsWorkerThreadWaitForWakeup
+/// @summary Release a block of memory returned by OsVmmAllocateMetadata, crediting it back to the active memory budget.
+/// @param base The base address returned by OsVmmAllocateMetadata.
+/// @param size The size passed to OsVmmAllocateMetadata.
+internal_function void
+OsVmmReleaseMetadata
 (
-    HANDLE    iocp,
-    HANDLE    term, 
-    uint32_t   tid,
-    uintptr_t &key
+    void *base, 
+    size_t size
 )
 {
-    OVERLAPPED *ov_addr = NULL;
-    DWORD        nbytes = 0;
-    DWORD        termrc = 0;
+    OsVmmRelease(base, size);
+    OsMemoryBudgetCharge(-(int64_t) size);
+}
 
-    // prior to entering the wait state, check the termination signal.
-    if ((termrc = WaitForSingleObject(term, 0)) != WAIT_TIMEOUT)
-    {   // either termination was signaled, or an error occurred.
-        // either way, exit prior to entering the wait state.
-        if (termrc != WAIT_OBJECT_0)
-        {   // an error occurred while checking the termination signal.
-            OsLayerError("ERROR: %S(%u): Checking termination signal failed with result 0x%08X (0x%08X).\n", __FUNCTION__, tid, termrc, GetLastError());
-        }
-        return OS_WORKER_THREAD_WAKE_FOR_EXIT;
+/// @summary Create a block of shared memory and map it twice into adjacent ranges of process address space.
+/// @param size The size of the shared memory block, in bytes. This value must be a multiple of the allocation granularity.
+/// @return The base address of the first mapping, or NULL if an error occurred. The second mapping begins at base + size.
+internal_function void*
+OsVmmReserveMirrored
+(
+    size_t size
+)
+{
+#if defined(__linux__)
+    // the memfd is only needed while establishing the mappings; they keep the pages alive after it is closed.
+    int     fd = (int) syscall(SYS_memfd_create, "oslayer_ring", MFD_CLOEXEC);
+    void *base = MAP_FAILED;
+    if (fd < 0)
+    {
+        OsLayerError("ERROR: %S(%u): memfd_create failed (errno = %d).\n", __FUNCTION__, OsThreadId(), errno);
+        return NULL;
     }
-    if (GetQueuedCompletionStatus(iocp, &nbytes, &key, &ov_addr, INFINITE))
-    {   // check the termination signal before possibly dispatching work.
-        int      rc = key != 0 ? OS_WORKER_THREAD_WAKE_FOR_RUN : OS_WORKER_THREAD_WAKE_FOR_SIGNAL;
-        if ((termrc = WaitForSingleObject(term, 0)) != WAIT_TIMEOUT)
+    if (ftruncate(fd, (off_t) size) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): ftruncate to %Iu bytes failed (errno = %d).\n", __FUNCTION__, OsThreadId(), size, errno);
+        close(fd);
+        return NULL;
+    }
+    if ((base = mmap(NULL, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0)) == MAP_FAILED)
+    {
+        OsLayerError("ERROR: %S(%u): mmap for %Iu bytes failed (errno = %d).\n", __FUNCTION__, OsThreadId(), size * 2, errno);
+        close(fd);
+        return NULL;
+    }
+    // replace both halves of the reservation with views of the same pages.
+    if (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED || 
+        mmap((uint8_t*) base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to map %Iu byte view (errno = %d).\n", __FUNCTION__, OsThreadId(), size, errno);
+        munmap(base, size * 2);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+    return base;
+#else
+    size_t const MAX_ATTEMPTS = 16;
+    HANDLE            mapping = NULL;
+    DWORD             size_hi = (DWORD)(((uint64_t) size) >> 32);
+    DWORD             size_lo = (DWORD)(((uint64_t) size) & 0xFFFFFFFFUL);
+    if ((mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, size_hi, size_lo, NULL)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): CreateFileMapping for %Iu bytes failed (%08X).\n", __FUNCTION__, OsThreadId(), size, GetLastError());
+        return NULL;
+    }
+    for (size_t i = 0; i < MAX_ATTEMPTS; ++i)
+    {   // find a free range large enough for both views, release it, then map into it.
+        // another thread may claim the range in between, in which case try again.
+        uint8_t *base = (uint8_t*) VirtualAlloc(NULL, size * 2, MEM_RESERVE, PAGE_NOACCESS);
+        void   *view0 = NULL;
+        void   *view1 = NULL;
+        if (base == NULL)
         {
-            if (termrc != WAIT_OBJECT_0)
-            {   // an error occurred while checking the termination signal.
-                OsLayerError("ERROR: %S(%u): Checking termination signal failed with result 0x%08X (0x%08X).\n", __FUNCTION__, tid, termrc, GetLastError());
-            }
-            rc = OS_WORKER_THREAD_WAKE_FOR_EXIT;
+            OsLayerError("ERROR: %S(%u): VirtualAlloc for %Iu bytes failed (%08X).\n", __FUNCTION__, OsThreadId(), size * 2, GetLastError());
+            break;
         }
-        return rc;
-    }
-    else
-    {   // the call to GetQueuedCompletionStatus failed.
-        OsLayerError("ERROR: %S(%u): GetQueuedCompletionStatus failed with result 0x%08X.\n", __FUNCTION__, tid, GetLastError());
-        return OS_WORKER_THREAD_WAKE_FOR_ERROR;
+        VirtualFree(base, 0, MEM_RELEASE);
+        if ((view0 = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base)) == NULL)
+            continue;
+        if ((view1 = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base + size)) == NULL)
+        {
+            UnmapViewOfFile(view0);
+            continue;
+        }
+        // the views keep the section alive after the mapping handle is closed.
+        CloseHandle(mapping);
+        return base;
     }
+    OsLayerError("ERROR: %S(%u): Failed to map adjacent %Iu byte views.\n", __FUNCTION__, OsThreadId(), size);
+    CloseHandle(mapping);
+    return NULL;
+#endif
 }
 
-/// @summary Convert a lowercase ASCII character 'a'-'z' to the corresponding uppercase character.
-/// @param ch The input character.
-/// @return The uppercase version of the input character.
-internal_function inline int
-OsToUpper
+/// @summary Unmap both views of a block of shared memory created with OsVmmReserveMirrored.
+/// @param base The base address returned by OsVmmReserveMirrored.
+/// @param size The size of the shared memory block, in bytes, as passed to OsVmmReserveMirrored.
+internal_function void
+OsVmmReleaseMirrored
 (
-    char ch
+    void *base, 
+    size_t size
 )
-{   // TODO(rlk): this works only for C locale. if locale support is needed, use toupper in ctype.h.
-    return (ch >= 'a' && ch <= 'z') ? (ch - 'a' + 'A') : ch;
+{
+#if defined(__linux__)
+    munmap(base, size * 2);
+#else
+    UnmapViewOfFile((uint8_t*) base + size);
+    UnmapViewOfFile(base);
+#endif
 }
 
-/// @summary Convert a lowercase ASCII character 'a'-'z' to the corresponding uppercase character.
-/// @param ch The input character.
-/// @return The uppercase version of the input character.
-internal_function inline int
-OsToUpper
+/// @summary Flush the CPU instruction cache for a range of memory containing dynamically-generated code.
+/// @param base The address of the first byte of code.
+/// @param size The number of bytes of code.
+/// @return true if the instruction cache was flushed.
+internal_function bool
+OsVmmFlushInstructionCache
 (
-    WCHAR ch
+    void  *base, 
+    size_t size
 )
-{   // TODO(rlk): this works only for C locale. if locale support is needed, use towupper in ctype.h.
-    return (ch >= L'a' && ch <= L'z') ? (ch - L'a' + L'A') : ch;
+{
+#if defined(__linux__)
+    __builtin___clear_cache((char*) base, (char*) base + size);
+    return true;
+#else
+    if (!FlushInstructionCache(GetCurrentProcess(), base, size))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to flush instruction cache (%08X).\n", __FUNCTION__, OsThreadId(), GetLastError());
+        return false;
+    }
+    return true;
+#endif
 }
 
-/// @summary Convert an uppercase ASCII character 'A'-'Z' to the corresponding lowercase character.
-/// @param ch The input character.
-/// @return The lowercase version of the input character.
-internal_function inline int
-OsToLower
+/// @summary Return the physical pages backing a committed range of address space to the operating system, without decommitting the range.
+/// The range remains accessible; the contents of discarded pages are undefined (typically zero) the next time they are touched.
+/// @param base The address of the first byte in the range. This must be a multiple of the page size.
+/// @param size The number of bytes in the range. This must be a multiple of the page size.
+/// @return true if the pages were discarded.
+internal_function bool
+OsVmmDiscard
 (
-    char ch
+    void  *base, 
+    size_t size
 )
-{   // TODO(rlk): this works only for C locale. if locale support is needed, use tolower in ctype.h.
-    return (ch >= 'A' && ch <= 'Z') ? (ch - 'A' + 'a') : ch;
+{
+#if defined(__linux__)
+#ifdef MADV_FREE
+    // MADV_FREE lets the kernel reclaim pages lazily, under memory pressure, avoiding a fault if the pages are reused first.
+    if (madvise(base, size, MADV_FREE) == 0)
+        return true;
+#endif
+    if (madvise(base, size, MADV_DONTNEED) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): madvise to discard %Iu bytes failed (errno = %d).\n", __FUNCTION__, OsThreadId(), size, errno);
+        return false;
+    }
+    return true;
+#else
+    // MEM_RESET keeps the commit charge but allows the pages to be dropped from the working set without being written to the page file.
+    if (VirtualAlloc(base, size, MEM_RESET, PAGE_NOACCESS) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): VirtualAlloc to discard %Iu bytes failed (%08X).\n", __FUNCTION__, OsThreadId(), size, GetLastError());
+        return false;
+    }
+    return true;
+#endif
 }
 
-/// @summary Convert an uppercase ASCII character 'A'-'Z' to the corresponding lowercase character.
-/// @param ch The input character.
-/// @return The lowercase version of the input character.
-internal_function inline int
-OsToLower
+/// @summary Populate a range of committed address space with physical pages, so that later accesses do not incur a page fault.
+/// Pages are written using an atomic OR of zero, which preserves their contents, so the range may already be in use by other threads.
+/// @param base The base address of the range. This must be aligned to the page size.
+/// @param size The number of bytes in the range. This must be a multiple of the page size.
+/// @param page_size The VMM page size, in bytes.
+/// @return true if the pages were populated.
+internal_function bool
+OsVmmPrefault
 (
-    WCHAR ch
+    void        *base, 
+    size_t       size, 
+    size_t  page_size
 )
-{   // TODO(rlk): this works only for C locale. if locale support is needed, use towlower in ctype.h.
-    return (ch >= L'A' && ch <= L'Z') ? (ch - L'A' + L'a') : ch;
+{
+#if defined(__linux__)
+    // MADV_POPULATE_WRITE (Linux 5.14+) faults in the whole range with a single call.
+    if (madvise(base, size, MADV_POPULATE_WRITE) == 0)
+        return true;
+    if (errno != EINVAL)
+    {
+        OsLayerError("ERROR: %S(%u): madvise to populate %Iu bytes failed (errno = %d).\n", __FUNCTION__, OsThreadId(), size, errno);
+        return false;
+    }
+    // older kernels: fall back to touching each page.
+    for (size_t offset = 0; offset < size; offset += page_size)
+    {
+        __atomic_fetch_or((uint8_t*) base + offset, (uint8_t) 0, __ATOMIC_RELAXED);
+    }
+    return true;
+#else
+    // a read would only map the shared zero page, so each page must be written.
+    for (size_t offset = 0; offset < size; offset += page_size)
+    {
+        _InterlockedOr8((char volatile*)((uint8_t*) base + offset), 0);
+    }
+    return true;
+#endif
 }
 
-/// @summary Normalize path separators for a character.
-/// @param ch The character to inspect.
-/// @return The forward slash if ch is a backslash, otherwise ch.
-internal_function inline uint32_t 
-OsNormalizePathSeparator
+/// @summary Restrict the calling thread to the processors of a NUMA node.
+/// @param numa_node The zero-based index of the NUMA node.
+/// @return true if the thread affinity was changed.
+internal_function bool
+OsVmmBindThreadToNumaNode
 (
-    char ch
+    uint32_t numa_node
 )
 {
-    return ch != '\\' ? uint32_t(OsToLower(ch)) : uint32_t('/');
+#if defined(__linux__)
+    // the node's pages are placed by the mbind policy of the allocation, so the faulting thread need not run on the node.
+    UNREFERENCED_PARAMETER(numa_node);
+    return false;
+#else
+    GROUP_AFFINITY affinity = {};
+    if (!GetNumaNodeProcessorMaskEx((USHORT) numa_node, &affinity) || affinity.Mask == 0)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to query processors of NUMA node %u (%08X).\n", __FUNCTION__, OsThreadId(), numa_node, GetLastError());
+        return false;
+    }
+    if (!SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to bind thread to NUMA node %u (%08X).\n", __FUNCTION__, OsThreadId(), numa_node, GetLastError());
+        return false;
+    }
+    return true;
+#endif
 }
 
-/// @summary Normalize path separators for a character.
-/// @param ch The character to inspect.
-/// @return The forward slash if ch is a backslash, otherwise ch.
-internal_function inline uint32_t
-OsNormalizePathSeparator
+#if !defined(__linux__)
+/// @summary Enable or disable a process privilege.
+/// @param token The privilege token of the process to modify.
+/// @param privilege_name The name of the privilege to enable or disable.
+/// @param should_enable Specify TRUE to request the privilege, or FALSE to disable the privilege.
+internal_function bool
+OsEnableProcessPrivilege
 (
-    WCHAR ch
+    HANDLE           token, 
+    LPCTSTR privilege_name,
+    BOOL     should_enable
 )
 {
-    return ch != L'\\' ? uint32_t(OsToLower(ch)) : uint32_t(L'/');
+    TOKEN_PRIVILEGES tp;
+    LUID           luid;
+
+    if (LookupPrivilegeValue(NULL, privilege_name, &luid))
+    {
+        tp.PrivilegeCount           = 1;
+        tp.Privileges[0].Luid       = luid;
+        tp.Privileges[0].Attributes = should_enable ? SE_PRIVILEGE_ENABLED : 0;
+        if (AdjustTokenPrivileges(token, FALSE, &tp, sizeof(TOKEN_PRIVILEGES), NULL, NULL))
+        {   // the requested privilege adjustment was made successfully.
+            return (GetLastError() != ERROR_NOT_ALL_ASSIGNED);
+        }
+    }
+    return false;
 }
 
-/// @summary Calculates a 32-bit hash value for a path string. Forward and backslashes are treated as equivalent.
-/// @param path A NULL-terminated UTF-8 path string.
-/// @return The hash of the specified string.
-internal_function uint32_t 
-OsHashPath
+/// @summary Request any privilege elevations for the current process.
+/// @return true if the necessary privileges have been obtained.
+internal_function bool
+OsElevateProcessPrivileges
 (
-    char const *path
+    void
 )
 {
-    if (path != NULL && path[0] != 0)
-    {
-        uint32_t    code = 0;
-        uint32_t    hash = 0;
-        char const *iter = path;
-        do {
-            code = OsNormalizePathSeparator(*iter++);
-            hash = _lrotl(hash, 7) + code;
-        } while (code != 0);
-        return hash;
+    HANDLE token;
+    if (OpenProcessToken(GetCurrentProcess(), TOKEN_ALL_ACCESS, &token))
+    {   // request elevated privileges one at a time.
+        bool se_debug       = OsEnableProcessPrivilege(token, SE_DEBUG_NAME, TRUE);
+        bool se_volume_name = OsEnableProcessPrivilege(token, SE_MANAGE_VOLUME_NAME, TRUE);
+        // SeLockMemoryPrivilege is optional; without it, large page allocations fall back to normal pages.
+        OsEnableProcessPrivilege(token, SE_LOCK_MEMORY_NAME, TRUE);
+        // ...
+        CloseHandle(token);
+        return (se_debug && se_volume_name);
     }
-    else return 0;
+    return false;
 }
 
-/// @summary Calculates a 32-bit hash value for a path string. Forward and backslashes are treated as equivalent.
-/// @param path A NULL-terminated UTF-8 path string.
-/// @return The hash of the specified string.
-internal_function uint32_t
-OsHashPath
+/// @summary Load the latest version of XInput into the process address space and resolve the required API functions.
+/// @param missing_entry_points On return, set to true if any entry points are missing.
+/// @return true if the XInput DLL was loaded into the process address space.
+internal_function bool
+OsLoadXInput
 (
-    WCHAR const *path
+    bool *missing_entry_points
 )
-{
-    if (path != NULL && path[0] != 0)
-    {
-        uint32_t     code = 0;
-        uint32_t     hash = 0;
-        WCHAR const *iter = path;
-        do {
-            code = OsNormalizePathSeparator(*iter++);
-            hash = _lrotl(hash, 7) + code;
-        } while (code != 0);
-        return hash;
+{   // start by trying to load the most recent version of the DLL, which ships with the Windows 8 SDK.
+    HMODULE xinput_dll = NULL;
+    if ((xinput_dll = LoadLibrary(_T("xinput1_4.dll"))) == NULL)
+    {   // try with XInput 9.1.0, which shipped starting with Windows Vista.
+        if ((xinput_dll = LoadLibrary(_T("xinput9_1_0.dll"))) == NULL)
+        {   // try for XInput 1.3, which shipped in the June 2010 DirectX SDK.
+            if ((xinput_dll = LoadLibrary(_T("xinput1_3.dll"))) == NULL)
+            {   // no XInput is available, so resolve everything to the stub functions.
+                if (missing_entry_points) *missing_entry_points = true;
+                return false;
+            }
+        }
     }
-    else return 0;
+
+    // perform runtime resolution of all required API functions.
+    OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputEnable);
+    OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputGetState);
+    OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputSetState);
+    OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputGetCapabilities);
+    //OS_LAYER_RESOLVE_RUNTIME_FUNCTION(xinput_dll, XInputGetBatteryInformation);
+
+    // check for any entry points that got set to their stub functions.
+    if (OS_LAYER_RUNTIME_STUB(XInputEnable))                goto missing_entry_point;
+    if (OS_LAYER_RUNTIME_STUB(XInputGetState))              goto missing_entry_point;
+    if (OS_LAYER_RUNTIME_STUB(XInputSetState))              goto missing_entry_point;
+    if (OS_LAYER_RUNTIME_STUB(XInputGetCapabilities))       goto missing_entry_point;
+    //if (OS_LAYER_RUNTIME_STUB(XInputGetBatteryInformation)) goto missing_entry_point;
+
+    // save the DLL handle.
+    XInputDll = xinput_dll;
+    return true;
+
+missing_entry_point:
+    if (missing_entry_points) *missing_entry_points = true;
+    XInputDll = xinput_dll;
+    return true;
 }
 
-/// @summary Locate one substring within another, ignoring case.
-/// @param search The zero-terminated ASCII string to search.
-/// @param find The zero-terminated ASCII string to locate within the search string.
-/// @return A pointer to the start of the first match, or NULL.
-internal_function char const*
-OsStringSearch
+/// @summary Search a device list for a device with a given handle.
+/// @param device_list The device list to search.
+/// @param device_handle The handle of the device to locate.
+/// @return The zero-based index of the device in the device list, or OS_INPUT_DEVICE_NOT_FOUND.
+template <typename T>
+internal_function size_t 
+OsFindInputDeviceForHandle
 (
-    char const *search, 
-    char const *find
+    OS_INPUT_DEVICE_LIST<T> *device_list, 
+    HANDLE                 device_handle
 )
 {
-    if (search == NULL)
-    {   // invalid search string.
-        return NULL;
-    }
-    if (*search == 0 && *find == 0)
-    {   // both are empty strings.
-        return search;
-    }
-    else if (*search == 0)
-    {   // search is an empty string, but find is not.
-        return NULL;
-    }
-    else
-    {   // both search and find are non-NULL, non-empty strings.
-        char const *si = search;
-        int  const  ff = OsToLower(*find++);
-        for ( ; ; )
-        {
-            int const sc = OsToLower(*si++);
-            if (sc == ff)
-            {   // first character of find matches this character of search.
-                char const *ss = si;   // si points to one after the match.
-                char const *fi = find; // find points to the second character.
-                for ( ; ; )
-                {
-                    int const s = OsToLower(*ss++);
-                    int const f = OsToLower(*fi++);
-                    if (f == 0) return si-1;
-                    if (s == 0) return NULL;
-                    if (s != f) break;
-                }
-            }
-            if (sc == 0) break;
-        }
+    for (size_t i = 0, n = device_list->DeviceCount; i < n; ++i)
+    {
+        if (device_list->DeviceHandle[i] == device_handle)
+            return i;
     }
-    return NULL;
+    return OS_INPUT_DEVICE_NOT_FOUND;
 }
 
-/// @summary Figure out the starting and ending points of the directory path, filename and extension information in a path string.
-/// @param buf The zero-terminated path string to parse. Any forward slashes are converted to backslashes.
-/// @param buf_end A pointer to the zero terminator character of the input path string. This value must be valid.
-/// @param parts The OS_PATH_PARTS to update. The Root, RootEnd and PathFlags fields must be set.
-/// @return This function always returns zero to indicate success.
-internal_function int
-OsExtractNativePathParts
+/// @summary Adds a device to a device list.
+/// @param devices The list of devices to search.
+/// @param device The handle of the device to insert.
+/// @param default_state The initial device state to associate with the device, if the device was not already present in the device list.
+/// @return The zero-based index of the device in the list, or OS_INPUT_DEVICE_TOO_MANY.
+template <typename T>
+internal_function size_t
+OsDeviceAttached
 (
-    WCHAR           *buf, 
-    WCHAR       *buf_end, 
-    OS_PATH_PARTS *parts
+    OS_INPUT_DEVICE_LIST<T> *devices,
+    HANDLE                    device,
+    T const           &default_state
 )
-{   // initialize the components of the path parts to known values.
-    parts->Path         = parts->RootEnd;
-    parts->PathEnd      = parts->RootEnd;
-    parts->Filename     = parts->RootEnd;
-    parts->FilenameEnd  = parts->RootEnd;
-    parts->Extension    = buf_end;
-    parts->ExtensionEnd = buf_end;
+{
+    size_t index = 0;
 
-    while (parts->FilenameEnd < buf_end)
+    // search for the device in the device list to avoid duplicate devices.
+    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
     {
-        if (parts->FilenameEnd[0] == L'/')
-            parts->FilenameEnd[0]  = L'\\';
-        if (parts->FilenameEnd[0] == L'\\')
-        {   // encountered a path separator.
-            // update the end of the directory path string.
-            // reset the filename string to be zero-length.
-            parts->PathEnd     = parts->FilenameEnd;
-            parts->PathFlags  |= OS_PATH_FLAG_PATH;
-            parts->Filename    = parts->FilenameEnd + 1;
-            parts->FilenameEnd = parts->FilenameEnd + 1;
-        }
-        else
-        {   // this is a regular character; consider it part of the filename.
-            parts->FilenameEnd++;
+        if (devices->DeviceHandle[i] == device)
+        {   // the device is already present in the device list. don't modify its state.
+            return i;
         }
     }
-    if (parts->Path[0] == L'\\')
-    {   // skip the leading path separator.
-        if (parts->Path == parts->PathEnd)
-        {   // there is no actual path component; this is something like "C:\".
-            parts->PathFlags &= ~OS_PATH_FLAG_PATH;
-            parts->PathEnd++;
-        }
-        parts->Path++;
+    // the device isn't present in the device list, so add it.
+    if (devices->DeviceCount == OS_INPUT_DEVICE_LIST<T>::MAX_DEVICES)
+    {   // there are too many devices of the specified type attached; cannot add.
+        return OS_INPUT_DEVICE_TOO_MANY;
     }
+    index = devices->DeviceCount++;
+    devices->DeviceHandle[index] = device;
+    devices->DeviceState [index] = default_state;
+    return index;
+}
 
-    if (parts->Filename != parts->FilenameEnd)
-    {   // figure out whether this last bit is a filename or part of the directory path.
-        WCHAR *iter  = buf_end;
-        while (iter >= parts->Filename)
-        {   // consider 'a.b', '.a.b' and 'a.' to be a filename, but not '.a'.
-            if (*iter == L'.' && iter != parts->Filename)
+/// @summary Removes a device from a device list.
+/// @param devices The list of devices to search.
+/// @param device The handle of the device to remove.
+/// @return true if the device was found in the device list.
+template <typename T>
+internal_function bool
+OsDeviceRemoved
+(
+    OS_INPUT_DEVICE_LIST<T> *devices,
+    HANDLE                    device 
+)
+{   // locate the device in the device list.
+    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+    {
+        if (devices->DeviceHandle[i] == device)
+        {   // the device has been located. swap the last item into its slot.
+            size_t   last_index = devices->DeviceCount - 1;
+            if (i != last_index)
             {
-                parts->FilenameEnd = iter;
-                parts->Extension   = iter + 1;
-                parts->PathFlags  |= OS_PATH_FLAG_FILENAME;
-                parts->PathFlags  |= OS_PATH_FLAG_EXTENSION;
+                devices->DeviceHandle[i] = devices->DeviceHandle[last_index];
+                devices->DeviceState [i] = devices->DeviceState [last_index];
             }
-            iter--;
-        }
-        if ((parts->PathFlags & OS_PATH_FLAG_FILENAME) == 0)
-        {   // consider 'a' and '.a' to be part of the directory path information.
-            parts->PathEnd     = parts->FilenameEnd;
-            parts->PathFlags  |= OS_PATH_FLAG_PATH;
-            parts->Filename    = buf_end;
-            parts->FilenameEnd = buf_end;
+            devices->DeviceCount--;
+            return true;
         }
     }
-    else
-    {   // if there's no filename present, make sure that it points to an empty string.
-        parts->Filename    = buf_end;
-        parts->FilenameEnd = buf_end;
-    }
-    UNREFERENCED_PARAMETER(buf);
-    return 0;
+    return false;
 }
 
-/// @summary Enumerate all files in a directory (and possibly its subdirectories.)
-/// @param buf The native path to search. The buffer contents are overwritten during enumeration.
-/// @param buf_bytes The maximum number of bytes that can be written to the path string buffer.
-/// @param buf_end A pointer to the zero-terminator codepoint within the path string buffer.
-/// @param filter A zero-terminated string specifying the filter to use when locating files. The filter supports wildcards. Specify a filter of * to include all files in the search.
-/// @param recurse Specify true to include files located in subdirectories in the search results.
-/// @param total_files This value is updated to include the total number of files returned by the search.
-/// @param alloc The OS_FILE_INFO_CHUNK allocator to use for allocating blocks of file information to store the search results.
-/// @param chunk The OS_FILE_INFO_CHUNK to which search results will be written, or NULL if no search results have been returned yet. New chunks are allocated as-needed.
-/// @return A pointer to the OS_FILE_INFO_CHUNK containing the search results.
-internal_function OS_FILE_INFO_CHUNK*
-OsEnumerateDirectory
+/// @summary Given a Raw Input keyboard packet, retrieve the virtual key code and scan code values.
+/// @param key The Raw Input keyboard packet to process.
+/// @param vkey_code On return, stores the virtual key code identifier (always less than or equal to 255.)
+/// @param scan_code On return, stores the scan code value, suitable for passing to CopyKeyDisplayName.
+/// @return true if vkey_code and scan_code were set, or false if the packet was part of an escape sequence.
+internal_function bool
+OsGetVirtualKeyAndScanCode
 (
-    WCHAR                *buf, 
-    size_t          buf_bytes, 
-    WCHAR            *buf_end,
-    WCHAR const       *filter, 
-    bool              recurse, 
-    size_t       &total_files, 
-    OS_FSIC_ALLOCATOR  *alloc, 
-    OS_FILE_INFO_CHUNK *chunk
+    RAWKEYBOARD const &key, 
+    uint32_t    &vkey_code, 
+    uint32_t    &scan_code
 )
-{   size_t const MAX_UTF8 = 1024; // maximum of 1024 bytes of UTF-8 data returned for filename.
-    HANDLE    find_handle = INVALID_HANDLE_VALUE;
-    WCHAR       *base_end = buf_end;
-    WCHAR     *filter_end = buf_end;
-    size_t   filter_chars = 0;
+{
+    uint32_t vkey =  key.VKey;
+    uint32_t scan =  key.MakeCode;
+    bool       e0 =((key.Flags & RI_KEY_E0) != 0);
+
+    if (vkey == 255)
+    {   // discard fake keys; these are just part of an escaped sequence.
+        vkey_code = 0; scan_code = 0;
+        return false;
+    }
+    if (vkey == VK_SHIFT)
+    {   // correct left/right shift.
+        vkey  = MapVirtualKey(scan, MAPVK_VSC_TO_VK_EX);
+    }
+    if (vkey == VK_NUMLOCK)
+    {   // correct PAUSE/BREAK and NUMLOCK. set the extended bit.
+        scan  = MapVirtualKey(vkey, MAPVK_VK_TO_VSC) | 0x100;
+    }
+    if (key.Flags & RI_KEY_E1)
+    {   // for escaped sequences, turn the virtual key into the correct scan code.
+        // unfortunately, MapVirtualKey can't handle VK_PAUSE, so do that manually.
+        if (vkey != VK_PAUSE) scan = MapVirtualKey(vkey, MAPVK_VK_TO_VSC);
+        else scan = 0x45;
+    }
+    switch (vkey)
+    {   // map left/right versions of various keys.
+        case VK_CONTROL:  /* left/right CTRL */
+            vkey =  e0 ? VK_RCONTROL : VK_LCONTROL;
+            break;
+        case VK_MENU:     /* left/right ALT  */
+            vkey =  e0 ? VK_RMENU : VK_LMENU;
+            break;
+        case VK_RETURN:
+            vkey =  e0 ? VK_SEPARATOR : VK_RETURN;
+            break;
+        case VK_INSERT:
+            vkey = !e0 ? VK_NUMPAD0 : VK_INSERT;
+            break;
+        case VK_DELETE:
+            vkey = !e0 ? VK_DECIMAL : VK_DELETE;
+            break;
+        case VK_HOME:
+            vkey = !e0 ? VK_NUMPAD7 : VK_HOME;
+            break;
+        case VK_END:
+            vkey = !e0 ? VK_NUMPAD1 : VK_END;
+            break;
+        case VK_PRIOR:
+            vkey = !e0 ? VK_NUMPAD9 : VK_PRIOR;
+            break;
+        case VK_NEXT:
+            vkey = !e0 ? VK_NUMPAD3 : VK_NEXT;
+            break;
+        case VK_LEFT:
+            vkey = !e0 ? VK_NUMPAD4 : VK_LEFT;
+            break;
+        case VK_RIGHT:
+            vkey = !e0 ? VK_NUMPAD6 : VK_RIGHT;
+            break;
+        case VK_UP:
+            vkey = !e0 ? VK_NUMPAD8 : VK_UP;
+            break;
+        case VK_DOWN:
+            vkey = !e0 ? VK_NUMPAD2 : VK_DOWN;
+            break;
+        case VK_CLEAR:
+            vkey = !e0 ? VK_NUMPAD5 : VK_CLEAR;
+            break;
+    }
+
+    // return the processed codes back to the caller.
+    vkey_code = vkey;
+    scan_code = scan;
+    return true;
+}
+
+/// @summary Retrieve the localized display name for a keyboard scan code.
+/// @param scan_code The key scan code, as returned by ProcessKeyboardPacket.
+/// @param ri_flags The RAWKEYBOARD::Flags field from the input packet.
+/// @param buffer The caller-managed buffer into which the display name will be copied.
+/// @param buffer_size The maximum number of characters that can be written to the buffer.
+/// @return The number of characters written to the buffer, not including the zero codepoint, or 0.
+internal_function size_t
+OsCopyKeyDisplayName
+(
+    uint32_t   scan_code, 
+    uint32_t    ri_flags, 
+    TCHAR        *buffer, 
+    size_t   buffer_size
+)
+{
+    LONG key_code = (scan_code << 16) | (((ri_flags & RI_KEY_E0) ? 1 : 0) << 24);
+    return (size_t)  GetKeyNameText(key_code, buffer, (int) buffer_size);
+}
+
+/// @summary Process a Raw Input keyboard packet to update the state of a keyboard device.
+/// @param input The Raw Input keyboard packet to process.
+/// @param devices The list of keyboard devices to update.
+/// @return The zero-based index of the input device in the device list, or OS_INPUT_DEVICE_TOO_MANY.
+internal_function size_t
+OsProcessKeyboardPacket
+(
+    RAWINPUT const     *input,
+    OS_KEYBOARD_LIST *devices
+)
+{
+    RAWINPUTHEADER const  &header =  input->header;
+    RAWKEYBOARD    const     &key =  input->data.keyboard;
+    OS_KEYBOARD_STATE      *state =  NULL;
+    size_t                  index =  0;
+    uint32_t                 vkey =  0;
+    uint32_t                 scan =  0;
+
+    // locate the keyboard in the current state buffer by device handle.
+    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+    {
+        if (devices->DeviceHandle[i] == header.hDevice)
+        {   // found the matching device.
+            index = i;
+            state =&devices->DeviceState[i];
+            break;
+        }
+    }
+    if (state == NULL)
+    {   // this device was newly attached.
+        if (devices->DeviceCount == OS_KEYBOARD_LIST::MAX_DEVICES)
+        {   // there are too many devices of the specified type attached.
+            return OS_INPUT_DEVICE_TOO_MANY;
+        }
+        index  = devices->DeviceCount++;
+        state  =&devices->DeviceState[index];
+        devices->DeviceHandle[index] = header.hDevice;
+        devices->DeviceState [index] = OS_KEYBOARD_STATE_STATIC_INIT;
+    }
+    if (!OsGetVirtualKeyAndScanCode(key, vkey, scan))
+    {   // discard fake keys; these are just part of an escaped sequence.
+        return index;
+    }
+    if ((key.Flags & RI_KEY_BREAK) == 0)
+    {   // the key is currently pressed; set the bit corresponding to the virtual key code.
+        state->KeyState[vkey >> 5] |= (1UL << (vkey & 0x1F));
+    }
+    else
+    {   // the key was just released; clear the bit corresponding to the virtual key code.
+        state->KeyState[vkey >> 5] &=~(1UL << (vkey & 0x1F));
+    }
+    return index;
+}
+
+/// @summary Process a Raw Input mouse packet to update the state of a pointing device.
+/// @param input The Raw Input mouse packet to process.
+/// @param devices The list of pointing devices to update.
+/// @return The zero-based index of the input device in the device list, or OS_INPUT_DEVICE_TOO_MANY.
+internal_function size_t
+OsProcessPointerPacket
+(
+    RAWINPUT const    *input,
+    OS_POINTER_LIST *devices
+)
+{
+    RAWINPUTHEADER const &header = input->header;
+    RAWMOUSE       const  &mouse = input->data.mouse;
+    OS_POINTER_STATE      *state = NULL;
+    size_t                 index = 0;
+    POINT                 cursor = {};
+
+    // locate the pointer in the current state buffer by device handle.
+    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+    {
+        if (devices->DeviceHandle[i] == header.hDevice)
+        {   // found the matching device.
+            index = i;
+            state =&devices->DeviceState[i];
+            break;
+        }
+    }
+    if (state == NULL)
+    {   // this device was newly attached.
+        if (devices->DeviceCount == OS_POINTER_LIST::MAX_DEVICES)
+        {   // there are too many devices of the specified type attached.
+            return OS_INPUT_DEVICE_TOO_MANY;
+        }
+        index  = devices->DeviceCount++;
+        state  =&devices->DeviceState[index];
+        devices->DeviceHandle[index] = header.hDevice;
+        devices->DeviceState [index] = OS_POINTER_STATE_STATIC_INIT;
+    }
+
+    // grab the current mouse pointer position, in pixels.
+    GetCursorPos(&cursor);
+    state->Pointer[0] = cursor.x;
+    state->Pointer[1] = cursor.y;
+
+    if (mouse.usFlags & MOUSE_MOVE_ABSOLUTE)
+    {   // the device is a pen, touchscreen, etc. and specifies absolute coordinates.
+        state->Relative[0]  = mouse.lLastX;
+        state->Relative[1]  = mouse.lLastY;
+        state->Flags = OS_POINTER_FLAGS_ABSOLUTE;
+    }
+    else
+    {   // the device has specified relative coordinates in mickeys.
+        state->Relative[0] += mouse.lLastX;
+        state->Relative[1] += mouse.lLastY;
+        state->Flags = OS_POINTER_FLAGS_NONE;
+    }
+    if (mouse.usButtonFlags & RI_MOUSE_WHEEL)
+    {   // mouse wheel data was supplied with the packet.
+        state->Relative[2] = (int16_t) mouse.usButtonData;
+    }
+    else
+    {   // no mouse wheel data was supplied with the packet.
+        state->Relative[2] = 0;
+    }
+
+    // rebuild the button state vector. Raw Input supports up to 5 buttons.
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_1_DOWN) state->Buttons |=  MK_LBUTTON;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_1_UP  ) state->Buttons &= ~MK_LBUTTON;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_2_DOWN) state->Buttons |=  MK_RBUTTON;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_2_UP  ) state->Buttons &= ~MK_RBUTTON;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_3_DOWN) state->Buttons |=  MK_MBUTTON;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_3_UP  ) state->Buttons &= ~MK_MBUTTON;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_4_DOWN) state->Buttons |=  MK_XBUTTON1;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_4_UP  ) state->Buttons &= ~MK_XBUTTON1;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_5_DOWN) state->Buttons |=  MK_XBUTTON2;
+    if (mouse.usButtonFlags & RI_MOUSE_BUTTON_5_UP  ) state->Buttons &= ~MK_XBUTTON2;
+    return index;
+}
+
+/// @summary Apply scaled radial deadzone logic to an analog stick input.
+/// @param stick_x The x-axis component of the analog input.
+/// @param stick_y The y-axis component of the analog input.
+/// @param deadzone The deadzone size as a percentage of the total input range.
+/// @param stick_xymn A four-element array that will store the normalized x- and y-components of the input direction, the magnitude, and the normalized magnitude.
+internal_function void
+OsScaledRadialDeadzone
+(
+    int16_t    stick_x, 
+    int16_t    stick_y, 
+    float     deadzone, 
+    float  *stick_xymn
+)
+{
+    float  x = stick_x;
+    float  y = stick_y;
+    float  m = sqrtf(x * x + y * y);
+    float nx = x / m;
+    float ny = y / m;
+
+    if (m < deadzone)
+    {   // drop the input; it falls within the deadzone.
+        stick_xymn[0] = 0;
+        stick_xymn[1] = 0;
+        stick_xymn[2] = 0;
+        stick_xymn[3] = 0;
+    }
+    else
+    {   // rescale the input into the non-dead space.
+        float n = (m - deadzone) / (1.0f - deadzone);
+        stick_xymn[0] = nx * n;
+        stick_xymn[1] = ny * n;
+        stick_xymn[2] = m;
+        stick_xymn[3] = n;
+    }
+}
+
+/// @summary Process an XInput gamepad packet to apply deadzone logic and update button states.
+/// @param input The XInput gamepad packet to process.
+/// @param port_index The zero-based index of the port to which the gamepad is connected.
+/// @param devices The list of gamepad devices to update.
+/// @return The zero-based index of the input device in the device list, or OS_INPUT_DEVICE_TOO_MANY.
+internal_function size_t
+OsProcessGamepadPacket
+(
+    XINPUT_STATE const *input, 
+    DWORD          port_index, 
+    OS_GAMEPAD_LIST  *devices
+)
+{
+    OS_GAMEPAD_STATE *state = NULL;
+    uintptr_t       pDevice =(uintptr_t) port_index;
+    HANDLE          hDevice =(HANDLE) pDevice;
+    size_t            index = 0;
+
+    // locate the pointer in the current state buffer by port index.
+    for (size_t i = 0, n = devices->DeviceCount; i < n; ++i)
+    {
+        if (devices->DeviceHandle[i] == hDevice)
+        {   // found the matching device.
+            index = i;
+            state =&devices->DeviceState[i];
+            break;
+        }
+    }
+    if (state == NULL)
+    {   // this device was newly attached.
+        if (devices->DeviceCount == OS_GAMEPAD_LIST::MAX_DEVICES)
+        {   // there are too many devices of the specified type attached.
+            return OS_INPUT_DEVICE_TOO_MANY;
+        }
+        index  = devices->DeviceCount++;
+        state  =&devices->DeviceState[index];
+        devices->DeviceHandle[index] = hDevice;
+        devices->DeviceState [index] = OS_GAMEPAD_STATE_STATIC_INIT;
+    }
+
+    // apply deadzone filtering to the trigger inputs.
+    state->LTrigger = input->Gamepad.bLeftTrigger  > XINPUT_GAMEPAD_TRIGGER_THRESHOLD ? input->Gamepad.bLeftTrigger  : 0;
+    state->RTrigger = input->Gamepad.bRightTrigger > XINPUT_GAMEPAD_TRIGGER_THRESHOLD ? input->Gamepad.bRightTrigger : 0;
+    // copy over the button state bits as-is.
+    state->Buttons  = input->Gamepad.wButtons;
+    // apply deadzone filtering to the analog stick inputs.
+    float const l_deadzone = XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE  / 32767.0f;
+    float const r_deadzone = XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE / 32767.0f;
+    OsScaledRadialDeadzone(input->Gamepad.sThumbLX, input->Gamepad.sThumbLY, l_deadzone, state->LStick);
+    OsScaledRadialDeadzone(input->Gamepad.sThumbRX, input->Gamepad.sThumbRY, r_deadzone, state->RStick);
+    return index;
+}
+
+/// @summary Poll XInput gamepads attached to the system and update the input device state.
+/// @param devices The list of gamepad devices to update.
+/// @param ports_in A bitvector specifying the gamepad ports to poll. Specify OS_ALL_GAMEPAD_PORTS to poll all possible ports. MSDN recommends against polling unattached ports each frame.
+/// @param ports_out A bitvector specifying the attached gamepad ports. Bit x is set if port x has an attached gamepad.
+/// @return The number of gamepads attached to the system (the number of bits set in ports_out.)
+internal_function size_t
+OsPollGamepads
+(
+    OS_GAMEPAD_LIST *devices,
+    uint32_t        ports_in,
+    uint32_t      &ports_out
+)
+{
+    size_t   const max_gamepads = 4;
+    size_t         num_gamepads = 0;
+    uint32_t const port_bits[4] = {
+        (1UL << 0UL), 
+        (1UL << 1UL), 
+        (1UL << 2UL), 
+        (1UL << 3UL)
+    };
+    // clear all attached port bits in the output:
+    ports_out = 0;
+    // poll any ports whose corresponding bit is set in ports_in.
+    for (size_t i = 0; i < max_gamepads; ++i)
+    {
+        if (ports_in & port_bits[i])
+        {
+            XINPUT_STATE state = {};
+            DWORD       result = XInputGetState_Func((DWORD) i, &state);
+            if (result == ERROR_SUCCESS)
+            {   // gamepad port i is attached and in use.
+                ports_out |= port_bits[i];
+                // update the corresponding input state.
+                OsProcessGamepadPacket(&state, (DWORD) i, devices);
+                num_gamepads++;
+            }
+        }
+    }
+    return num_gamepads;
+}
+
+/// @summary Given a two device list snapshots, populate a device set specifying whether a given device is in none, one or both snapshots.
+/// @param set The device set to populate. This set should be initialized with OS_INPUT_DEVICE_SET_STATIC_INIT prior to calling this function.
+/// @param prev The device list from the previous state snapshot.
+/// @param curr The device list from the current state snapshot.
+template <typename T>
+internal_function void
+OsDetermineDeviceSet
+(
+    OS_INPUT_DEVICE_SET      *set, 
+    OS_INPUT_DEVICE_LIST<T> *prev,
+    OS_INPUT_DEVICE_LIST<T> *curr
+)
+{   assert(set->DeviceCount == 0);
+    // build a table of 'unique' devices and which set(s) they belong to.
+    set->DeviceCount = prev->DeviceCount;
+    for (size_t i = 0, n = prev->DeviceCount; i < n; ++i)
+    {   // the table starts out empty, so this step is just a simple copy.
+        set->DeviceIds [i] = prev->DeviceHandle[i];
+        set->Membership[i] = OS_INPUT_DEVICE_MEMBERSHIP_PREV;
+        set->PrevIndex [i] =(uint8_t) i;
+    }
+    for (size_t i = 0, n = curr->DeviceCount; i < n; ++i)
+    {   // the table may not be empty, so filter out duplicate devices.
+        HANDLE id = curr->DeviceHandle[i];
+        size_t ix = set->DeviceCount;
+        size_t in = 1;
+        for (size_t j = 0, m = set->DeviceCount; j < m; ++j)
+        {
+            if (set->DeviceIds[j] == id)
+            {   // found an existing entry with the same handle.
+                ix = j; // update the existing entry.
+                in = 0; // don't increment the device count.
+                break;
+            }
+        }
+        set->DeviceIds [ix]  = id;
+        set->Membership[ix] |= OS_INPUT_DEVICE_MEMBERSHIP_CURR;
+        set->CurrIndex [ix]  =(uint8_t) i;
+        set->DeviceCount    += in;
+    }
+}
+
+/// @summary Given two keyboard state snapshots, generate keyboard events for keys down, pressed and released.
+/// @param keys The keyboard events data to populate.
+/// @param prev The previous keyboard state snapshot.
+/// @param curr The current keyboard state snapshot.
+internal_function void
+OsGenerateKeyboardInputEvents
+(
+    OS_KEYBOARD_EVENTS      *keys,
+    OS_KEYBOARD_STATE const *prev, 
+    OS_KEYBOARD_STATE const *curr
+)
+{
+    keys->DownCount     = 0;
+    keys->PressedCount  = 0;
+    keys->ReleasedCount = 0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        uint32_t curr_state = curr->KeyState[i];
+        uint32_t prev_state = prev->KeyState[i];
+        uint32_t    changes =(curr_state ^  prev_state);
+        uint32_t      downs =(changes    &  curr_state);
+        uint32_t        ups =(changes    & ~curr_state);
+
+        for (uint32_t j = 0; j < 32; ++j)
+        {
+            uint32_t mask = (1 << j);
+            uint8_t  vkey = (uint8_t) ((i << 5) + j);
+
+            if ((curr_state & mask) != 0 && keys->DownCount < OS_KEYBOARD_EVENTS::MAX_KEYS)
+            {   // this key is currently pressed.
+                keys->Down[keys->DownCount++] = vkey;
+            }
+            if ((downs & mask) != 0 && keys->PressedCount < OS_KEYBOARD_EVENTS::MAX_KEYS)
+            {   // this key was just pressed.
+                keys->Pressed[keys->PressedCount++] = vkey;
+            }
+            if ((ups & mask) != 0 && keys->ReleasedCount < OS_KEYBOARD_EVENTS::MAX_KEYS)
+            {   // this key was just released.
+                keys->Released[keys->ReleasedCount++] = vkey;
+            }
+        }
+    }
+}
+
+/// @summary Generate keyboard device and input events for all keyboard devices given two device list snapshots.
+/// @param events The input events structure to populate.
+/// @param prev The device list from the previous tick.
+/// @param curr The device list from the current tick.
+internal_function void
+OsGenerateKeyboardEvents
+(
+    OS_INPUT_EVENTS *events, 
+    OS_KEYBOARD_LIST  *prev,
+    OS_KEYBOARD_LIST  *curr
+)
+{
+    OS_INPUT_DEVICE_SET device_set = OS_INPUT_DEVICE_SET_STATIC_INIT;
+
+    // determine the device set, which is used to determine whether devices were added or removed, 
+    // and also whether or not (or how) to generate state-based input events for a given device.
+    OsDetermineDeviceSet(&device_set, prev, curr);
+
+    // loop through each individual device and emit events.
+    events->KeyboardAttachCount = 0;
+    events->KeyboardRemoveCount = 0;
+    events->KeyboardCount       = 0;
+    for (size_t i = 0, n = device_set.DeviceCount; i < n; ++i)
+    {
+        switch (device_set.Membership[i])
+        {
+            case OS_INPUT_DEVICE_MEMBERSHIP_PREV:
+                {   // this input device was just removed. no device state events are generated.
+                    events->KeyboardRemove[events->KeyboardRemoveCount] = device_set.DeviceIds[i];
+                    events->KeyboardRemoveCount++;
+                } break;
+
+            case OS_INPUT_DEVICE_MEMBERSHIP_CURR:
+                {   // this input device was just attached. no device state events are generated.
+                    events->KeyboardAttach[events->KeyboardAttachCount] = device_set.DeviceIds[i];
+                    events->KeyboardAttachCount++;
+                } break;
+
+            case OS_INPUT_DEVICE_MEMBERSHIP_BOTH:
+                {   // this input device was present in both snapshots.
+                    OS_KEYBOARD_EVENTS *input_ev = &events->KeyboardEvents[events->KeyboardCount];
+                    OS_KEYBOARD_STATE  *state_pp = &prev->DeviceState[device_set.PrevIndex[i]];
+                    OS_KEYBOARD_STATE  *state_cp = &curr->DeviceState[device_set.CurrIndex[i]];
+                    events->KeyboardIds[events->KeyboardCount] = device_set.DeviceIds[i];
+                    OsGenerateKeyboardInputEvents(input_ev, state_pp, state_cp);
+                    events->KeyboardCount++;
+                } break;
+        }
+    }
+}
+
+/// @summary Given two pointer device state snapshots, generate events for buttons down, pressed and released.
+/// @param pointer The pointer device events data to populate.
+/// @param prev The previous pointer device state snapshot.
+/// @param curr The current pointer device state snapshot.
+internal_function void
+OsGeneratePointerInputEvents
+(
+    OS_POINTER_EVENTS   *pointer, 
+    OS_POINTER_STATE const *prev, 
+    OS_POINTER_STATE const *curr
+)
+{   // copy cursor and wheel data, and generate relative data.
+    pointer->Cursor[0]  = curr->Pointer[0];
+    pointer->Cursor[1]  = curr->Pointer[1];
+    pointer->WheelDelta = curr->Relative[2];
+    if (curr->Flags & OS_POINTER_FLAGS_ABSOLUTE)
+    {   // calculate relative values as the delta between states.
+        pointer->Mickeys[0] = curr->Relative[0] - prev->Relative[0];
+        pointer->Mickeys[1] = curr->Relative[1] - prev->Relative[1];
+    }
+    else
+    {   // the driver specified relative values; copy them as-is.
+        pointer->Mickeys[0] = curr->Relative[0];
+        pointer->Mickeys[1] = curr->Relative[1];
+    }
+
+    uint32_t curr_state = curr->Buttons;
+    uint32_t prev_state = prev->Buttons;
+    uint32_t    changes =(curr_state ^  prev_state);
+    uint32_t      downs =(changes    &  curr_state);
+    uint32_t        ups =(changes    & ~curr_state);
+
+    // generate the button events. check each bit in the buttons mask.
+    pointer->DownCount     = 0;
+    pointer->PressedCount  = 0;
+    pointer->ReleasedCount = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        uint32_t mask   = (1UL << i);
+        uint16_t button = (uint16_t) mask;
+
+        if ((curr_state & mask) != 0 && pointer->DownCount < OS_POINTER_EVENTS::MAX_BUTTONS)
+        {   // this button is currently pressed.
+            pointer->Down[pointer->DownCount++] = button;
+        }
+        if ((downs & mask) != 0 && pointer->PressedCount < OS_POINTER_EVENTS::MAX_BUTTONS)
+        {   // this button was just pressed.
+            pointer->Pressed[pointer->PressedCount++] = button;
+        }
+        if ((ups & mask) != 0 && pointer->ReleasedCount < OS_POINTER_EVENTS::MAX_BUTTONS)
+        {   // this button was just released.
+            pointer->Released[pointer->ReleasedCount++] = button;
+        }
+    }
+}
+
+/// @summary Generate pointer device and input events for all pointer devices given two device list snapshots.
+/// @param events The input events structure to populate.
+/// @param prev The device list from the previous tick.
+/// @param curr The device list from the current tick.
+internal_function void
+OsGeneratePointerEvents
+(
+    OS_INPUT_EVENTS *events, 
+    OS_POINTER_LIST   *prev,
+    OS_POINTER_LIST   *curr
+)
+{
+    OS_INPUT_DEVICE_SET device_set = OS_INPUT_DEVICE_SET_STATIC_INIT;
+
+    // determine the device set, which is used to determine whether devices were added or removed, 
+    // and also whether or not (or how) to generate state-based input events for a given device.
+    OsDetermineDeviceSet(&device_set, prev, curr);
+
+    // loop through each individual device and emit events.
+    events->PointerAttachCount = 0;
+    events->PointerRemoveCount = 0;
+    events->PointerCount       = 0;
+    for (size_t i = 0, n = device_set.DeviceCount; i < n; ++i)
+    {
+        switch (device_set.Membership[i])
+        {
+            case OS_INPUT_DEVICE_MEMBERSHIP_PREV:
+                {   // this input device was just removed. no device state events are generated.
+                    events->PointerRemove[events->PointerRemoveCount] = device_set.DeviceIds[i];
+                    events->PointerRemoveCount++;
+                } break;
+
+            case OS_INPUT_DEVICE_MEMBERSHIP_CURR:
+                {   // this input device was just attached. no device state events are generated.
+                    events->PointerAttach[events->PointerAttachCount] = device_set.DeviceIds[i];
+                    events->PointerAttachCount++;
+                } break;
+
+            case OS_INPUT_DEVICE_MEMBERSHIP_BOTH:
+                {   // this input device was present in both snapshots.
+                    OS_POINTER_EVENTS *input_ev = &events->PointerEvents[events->PointerCount];
+                    OS_POINTER_STATE  *state_pp = &prev->DeviceState[device_set.PrevIndex[i]];
+                    OS_POINTER_STATE  *state_cp = &curr->DeviceState[device_set.CurrIndex[i]];
+                    events->PointerIds[events->PointerCount] = device_set.DeviceIds[i];
+                    OsGeneratePointerInputEvents(input_ev, state_pp, state_cp);
+                    events->PointerCount++;
+                } break;
+        }
+    }
+}
+
+/// @summary Given two gamepad device state snapshots, generate events for buttons down, pressed and released.
+/// @param pointer The gamepad device events data to populate.
+/// @param prev The previous gamepad device state snapshot.
+/// @param curr The current gamepad device state snapshot.
+internal_function void
+OsGenerateGamepadInputEvents
+(
+    OS_GAMEPAD_EVENTS   *gamepad, 
+    OS_GAMEPAD_STATE const *prev,
+    OS_GAMEPAD_STATE const *curr
+)
+{
+    gamepad->LeftTrigger         = (float) curr->LTrigger / (float) (255 - XINPUT_GAMEPAD_TRIGGER_THRESHOLD);
+    gamepad->RightTrigger        = (float) curr->RTrigger / (float) (255 - XINPUT_GAMEPAD_TRIGGER_THRESHOLD);
+    gamepad->LeftStick[0]        =  curr->LStick[0];
+    gamepad->LeftStick[1]        =  curr->LStick[1];
+    gamepad->LeftStickMagnitude  =  curr->LStick[3];
+    gamepad->RightStick[0]       =  curr->RStick[0];
+    gamepad->RightStick[1]       =  curr->RStick[1];
+    gamepad->RightStickMagnitude =  curr->RStick[3];
+
+    uint32_t curr_state = curr->Buttons;
+    uint32_t prev_state = prev->Buttons;
+    uint32_t    changes =(curr_state ^  prev_state);
+    uint32_t      downs =(changes    &  curr_state);
+    uint32_t        ups =(changes    & ~curr_state);
+
+    // generate the button events. check each bit in the buttons mask.
+    gamepad->DownCount     = 0;
+    gamepad->PressedCount  = 0;
+    gamepad->ReleasedCount = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        uint32_t mask   = (1UL << i);
+        uint16_t button = (uint16_t) mask;
+
+        if ((curr_state & mask) != 0 && gamepad->DownCount < OS_GAMEPAD_EVENTS::MAX_BUTTONS)
+        {   // this button is currently pressed.
+            gamepad->Down[gamepad->DownCount++] = button;
+        }
+        if ((downs & mask) != 0 && gamepad->PressedCount < OS_GAMEPAD_EVENTS::MAX_BUTTONS)
+        {   // this button was just pressed.
+            gamepad->Pressed[gamepad->PressedCount++] = button;
+        }
+        if ((ups & mask) != 0 && gamepad->ReleasedCount < OS_GAMEPAD_EVENTS::MAX_BUTTONS)
+        {   // this button was just released.
+            gamepad->Released[gamepad->ReleasedCount++] = button;
+        }
+    }
+}
+
+/// @summary Generate gamepad device and input events for all gamepad devices given two device list snapshots.
+/// @param events The input events structure to populate.
+/// @param prev The device list from the previous tick.
+/// @param curr The device list from the current tick.
+internal_function void
+OsGenerateGamepadEvents
+(
+    OS_INPUT_EVENTS *events, 
+    OS_GAMEPAD_LIST   *prev,
+    OS_GAMEPAD_LIST   *curr
+)
+{
+    OS_INPUT_DEVICE_SET device_set = OS_INPUT_DEVICE_SET_STATIC_INIT;
+
+    // determine the device set, which is used to determine whether devices were added or removed, 
+    // and also whether or not (or how) to generate state-based input events for a given device.
+    OsDetermineDeviceSet(&device_set, prev, curr);
+
+    // loop through each individual device and emit events.
+    events->GamepadAttachCount = 0;
+    events->GamepadRemoveCount = 0;
+    events->GamepadCount       = 0;
+    for (size_t i = 0, n = device_set.DeviceCount; i < n; ++i)
+    {
+        DWORD   device_id = (DWORD) ((uintptr_t) device_set.DeviceIds[i]);
+        switch (device_set.Membership[i])
+        {
+            case OS_INPUT_DEVICE_MEMBERSHIP_PREV:
+                {   // this input device was just removed. no device state events are generated.
+                    events->GamepadRemove[events->GamepadRemoveCount] = device_id;
+                    events->GamepadRemoveCount++;
+                } break;
+
+            case OS_INPUT_DEVICE_MEMBERSHIP_CURR:
+                {   // this input device was just attached. no device state events are generated.
+                    events->GamepadAttach[events->GamepadAttachCount] = device_id;
+                    events->GamepadAttachCount++;
+                } break;
+
+            case OS_INPUT_DEVICE_MEMBERSHIP_BOTH:
+                {   // this input device was present in both snapshots.
+                    OS_GAMEPAD_EVENTS *input_ev = &events->GamepadEvents[events->GamepadCount];
+                    OS_GAMEPAD_STATE  *state_pp = &prev->DeviceState[device_set.PrevIndex[i]];
+                    OS_GAMEPAD_STATE  *state_cp = &curr->DeviceState[device_set.CurrIndex[i]];
+                    events->GamepadIds[events->GamepadCount] = device_id;
+                    OsGenerateGamepadInputEvents(input_ev, state_pp, state_cp);
+                    events->GamepadCount++;
+                } break;
+        }
+    }
+}
+
+/// @summary Copy keyboard devices and state from the current 'current' buffer to the next 'current' buffer.
+/// @param dst The 'current' buffer for the next tick.
+/// @param src The 'current' buffer for the current tick.
+internal_function void
+OsForwardKeyboardBuffer
+(
+    OS_KEYBOARD_LIST *dst, 
+    OS_KEYBOARD_LIST *src
+)
+{   // copy over the device list and key state.
+    CopyMemory(dst, src, sizeof(OS_KEYBOARD_LIST));
+}
+
+/// @summary Copy pointer devices and state from the current 'current' buffer to the next 'current' buffer.
+/// @param dst The 'current' buffer for the next tick.
+/// @param src The 'current' buffer for the current tick.
+internal_function void
+OsForwardPointerBuffer
+(
+    OS_POINTER_LIST *dst, 
+    OS_POINTER_LIST *src
+)
+{   // copy over the device list, but zero out the relative fields of the state.
+    CopyMemory(dst, src, sizeof(OS_POINTER_LIST));
+    for (size_t i = 0, n = dst->DeviceCount; i < n; ++i)
+    {
+        dst->DeviceState[i].Relative[0] = 0;
+        dst->DeviceState[i].Relative[1] = 0;
+        dst->DeviceState[i].Flags = OS_POINTER_FLAGS_NONE;
+    }
+}
+
+/// @summary Copy gamepad devices and state from the current 'current' buffer to the next 'current' buffer.
+/// @param dst The 'current' buffer for the next tick.
+/// @param src The 'current' buffer for the current tick.
+internal_function void
+OsForwardGamepadBuffer
+(
+    OS_GAMEPAD_LIST *dst, 
+    OS_GAMEPAD_LIST *src
+)
+{
+    UNREFERENCED_PARAMETER(dst);
+    UNREFERENCED_PARAMETER(src);
+}
+
+/// @summary Push an item onto the private end of a task queue. This function can only be called by the thread that owns the queue, and may execute concurrently with one or more steal operations.
+/// @param queue The queue to receive the item.
+/// @param task_id The identifier of the task that is ready to run.
+/// @return true if the task was written to the queue.
+internal_function inline bool
+OsTaskQueuePush
+(
+    OS_TASK_QUEUE *queue, 
+    os_task_id_t task_id
+)
+{
+    int64_t b = queue->Private.load(std::memory_order_relaxed);      // atomically load the private end of the queue. only Push and Take may modify the private end.
+    queue->TaskIds[b & queue->Mask] = task_id;                       // store the new item at the end of the Tasks array.
+    std::atomic_thread_fence(std::memory_order_release);             // ensure that the task ID is written to the Tasks array.
+    queue->Private.store(b+1,std::memory_order_relaxed);             // make the new item visible to a concurrent steal/subsequent take operation (push to private end.)
+    return true;
+}
+
+/// @summary Take an item from the private end of a task queue. This function can only be called by the thread that owns the queue, and may execute concurrently with one or more steal operations.
+/// @param queue The queue from which the item will be removed.
+/// @param more_items On return, this value is set to true if there was at least one additional item in the queue after the returned item was claimed.
+/// @return The task identifier, or OS_INVALID_TASK_ID if the queue is empty.
+internal_function os_task_id_t
+OsTaskQueueTake
+(
+    OS_TASK_QUEUE   *queue,
+    bool       &more_items
+)
+{
+    int64_t b = queue->Private.load(std::memory_order_relaxed) - 1; // safe since no concurrent Push operation is allowed.
+    queue->Private.store(b , std::memory_order_relaxed);            // complete the 'pop' from the private end (LIFO).
+    std::atomic_thread_fence(std::memory_order_seq_cst);            // make the 'pop' visible to a concurrent steal.
+    int64_t t = queue->Public.load(std::memory_order_relaxed);
+
+    if (t <= b)
+    {   // the task queue is non-empty.
+        os_task_id_t task_id = queue->TaskIds[b & queue->Mask];
+        if (t != b)
+        {   // there's at least one more item in the queue; no need to race.
+            more_items = true;
+            return task_id;
+        }
+        // this was the last item in the queue. race to claim it.
+        if (!queue->Public.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {   // this thread lost the race.
+            task_id = OS_INVALID_TASK_ID;
+        }
+        queue->Private.store(t + 1, std::memory_order_relaxed);
+        more_items = false;
+        return task_id;
+    }
+    else
+    {   // the queue is currently empty.
+        more_items = false;
+        queue->Private.store(t, std::memory_order_relaxed);
+        return OS_INVALID_TASK_ID;
+    }
+}
+
+/// @summary Attempt to steal an item from the public end of the queue. This function can be called by any thread EXCEPT the thread that owns the queue, and may execute concurrently with a push or take operation, and one or more steal operations.
+/// @param queue The queue from which the item will be removed.
+/// @param more_items On return, this value is set to true if there was at least one additional item in the queue after the returned item was claimed.
+/// @return The task identifier, or OS_INVALID_TASK_ID if the queue is empty or the calling thread lost the race for the last item.
+internal_function os_task_id_t
+OsTaskQueueSteal
+(
+    OS_TASK_QUEUE  *queue, 
+    bool      &more_items
+)
+{
+    int64_t t = queue->Public.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = queue->Private.load(std::memory_order_acquire);
+
+    if (t < b)
+    {   // the task queue is non-empty. save the task ID.
+        os_task_id_t task_id = queue->TaskIds[t & queue->Mask];
+        // race with other threads to claim the item.
+        if (queue->Public.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {   // the calling thread won the race and claimed the item.
+            more_items = (t != b);
+            return task_id;
+        }
+        else
+        {   // the calling thread lost the race and should try again.
+            more_items = false;
+            return OS_INVALID_TASK_ID;
+        }
+    }
+    else
+    {   // the queue is currently empty.
+        more_items = false;
+        return OS_INVALID_TASK_ID;
+    }
+}
+
+/// @summary Reset a task queue to empty.
+/// @param queue The queue to clear.
+internal_function inline void
+OsTaskQueueClear
+(
+    OS_TASK_QUEUE *queue
+)
+{
+    queue->Public.store(0, std::memory_order_relaxed);
+    queue->Private.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+/// @summary Allocate the memory for a task queue and initialize the queue to empty.
+/// @param queue The task queue to initialize.
+/// @param capacity The capacity of the queue. This value must be a power of two greater than zero.
+/// @param arena The memory arena to allocate from. The caller should ensure that sufficient memory is available.
+/// @return Zero if the queue is created successfully, or -1 if an error occurred.
+internal_function int
+OsCreateTaskQueue
+(
+    OS_TASK_QUEUE        *queue, 
+    size_t             capacity, 
+    OS_HOST_MEMORY_ARENA *arena
+)
+{   // the capacity must be a power of two.
+    assert((capacity & (capacity - 1)) == 0);
+    queue->Public.store(0, std::memory_order_relaxed);
+    queue->Private.store(0, std::memory_order_relaxed);
+    queue->Mask = int64_t(capacity) - 1;
+    queue->TaskIds = (os_task_id_t*) OsHostMemoryArenaAllocate(arena, capacity * sizeof(os_task_id_t), std::alignment_of<os_task_id_t>::value);
+    return queue->TaskIds != NULL ? 0 : -1;
+}
+
+/// @summary Execute a single ready-to-run task on the calling thread and mark it complete.
+/// The thread-local memory arena is treated as a stack of per-task scopes. A marker is taken on entry and the arena is reset back to it on exit, so a task executed while another task on the same thread is blocked in OsWaitForTask does not invalidate the outer task's local allocations.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread.
+/// @param task_id The identifier of the task to execute.
+/// @return The number of ready-to-run tasks added to the thread's local ready-to-run queue when the task completed.
+internal_function size_t
+OsExecuteTask
+(
+    OS_TASK_ENVIRONMENT *taskenv,
+    os_task_id_t         task_id
+)
+{
+    uint32_t const     tsrc = (task_id & OS_TASK_ID_MASK_POOL ) >> OS_TASK_ID_SHIFT_POOL;
+    uint32_t const     tidx = (task_id & OS_TASK_ID_MASK_INDEX) >> OS_TASK_ID_SHIFT_INDEX;
+    OS_TASK_DATA      *task = &taskenv->TaskPool->TaskPoolList[tsrc].TaskPoolData[tidx];
+    os_arena_marker_t scope =  OsHostMemoryArenaMark(taskenv->LocalMemory);
+    task->TaskMain(task_id, task->TaskData, taskenv);
+    OsHostMemoryArenaResetToMarker(taskenv->LocalMemory, scope);
+    return OsCompleteTask(taskenv, task_id);
+}
+
+/// @summary Deliver a ready-to-run thread-affine task to the mailbox of its target task pool, and wake the owning thread if the mailbox was empty.
+/// Any thread may deliver to any mailbox. Tasks in a mailbox are never visible to stealing threads.
+/// @param target The OS_TASK_POOL whose owning thread must execute the task.
+/// @param task The OS_TASK_DATA for the task being delivered.
+/// @param task_id The identifier of the task being delivered.
+/// @return true if the task was delivered, or false if the target pool is not owned by a thread, in which case the task cannot run.
+internal_function bool
+OsTaskMailboxPost
+(
+    OS_TASK_POOL *target, 
+    OS_TASK_DATA   *task,
+    os_task_id_t task_id
+)
+{   // the owner does not return the pool while a delivery is in progress, so the wake handles remain valid.
+    target->PostActive.fetch_add(1, std::memory_order_seq_cst);
+    os_task_id_t head = target->Mailbox.load(std::memory_order_seq_cst);
+    do
+    {
+        if (head == OS_TASK_MAILBOX_CLOSED)
+        {   // the pool has been returned, or was never allocated.
+            target->PostActive.fetch_sub(1, std::memory_order_seq_cst);
+            return false;
+        }
+        // link the task in front of the current head of the mailbox.
+        task->MailboxNext = head;
+    } while (!target->Mailbox.compare_exchange_weak(head, task_id, std::memory_order_seq_cst, std::memory_order_seq_cst));
+
+    if (head == OS_INVALID_TASK_ID)
+    {   // the mailbox transitioned from empty to non-empty, so the owner may be asleep.
+        // if the mailbox was already non-empty, a wakeup is already pending or the owner is draining it.
+        HANDLE port  = target->WakePort.load(std::memory_order_acquire);
+        HANDLE event = target->WakeEvent.load(std::memory_order_acquire);
+        if (port != NULL)
+        {
+            PostQueuedCompletionStatus(port, 0, OS_COMPLETION_KEY_TASK_MAILBOX, NULL);
+        }
+        else if (event != NULL)
+        {
+            SetEvent(event);
+        }
+    }
+    target->PostActive.fetch_sub(1, std::memory_order_seq_cst);
+    return true;
+}
+
+/// @summary Stop accepting thread-affine tasks for the task pool bound to the calling thread. Tasks already in the mailbox, and any work they produce, are executed first.
+/// After this function returns, OsTaskMailboxPost rejects tasks targeting the pool until the pool is allocated again.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread, which must own the task pool.
+internal_function void
+OsTaskMailboxClose
+(
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_TASK_POOL *self = taskenv->TaskPool;
+    os_task_id_t empty = OS_INVALID_TASK_ID;
+    os_task_id_t  work = OS_INVALID_TASK_ID;
+    uint32_t     spins = 0;
+    bool     more_work = false;
+
+    if (self->Mailbox.load(std::memory_order_seq_cst) == OS_TASK_MAILBOX_CLOSED)
+    {   // the mailbox was already closed by OsDrainTaskPool.
+        return;
+    }
+    // the thread is about to drain the mailbox, so the application event no longer needs to be signaled.
+    self->WakeEvent.store(NULL, std::memory_order_seq_cst);
+    do
+    {   // the drained tasks may deliver further thread-affine tasks to this pool, 
+        // so repeat until the mailbox can be closed while it is empty.
+        OsExecuteMailboxTasks(taskenv);
+        while ((work = OsTaskQueueTake(&self->WorkQueue, more_work)) != OS_INVALID_TASK_ID)
+        {
+            OsExecuteTask(taskenv, work);
+        }
+        empty = OS_INVALID_TASK_ID;
+    } while (!self->Mailbox.compare_exchange_strong(empty, OS_TASK_MAILBOX_CLOSED, std::memory_order_seq_cst, std::memory_order_relaxed));
+    self->WakePort.store(NULL, std::memory_order_seq_cst);
+
+    while (self->PostActive.load(std::memory_order_seq_cst) != 0)
+    {   // wait for threads that delivered a task before the mailbox was closed to finish waking this thread.
+        if (++spins < 64)
+        {
+            _mm_pause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/// @summary Determine whether any task defined in a task pool has not yet completed. 
+/// @param pool The OS_TASK_POOL to check.
+/// @return true if every task slot in the pool is free.
+internal_function bool
+OsTaskPoolIsIdle
+(
+    OS_TASK_POOL *pool
+)
+{
+    for (size_t i = 0, n = size_t(pool->IndexMask) + 1; i < n; ++i)
+    {
+        if (pool->SlotStatus[i].load(std::memory_order_acquire) != OS_TASK_SLOT_STATUS_FREE)
+            return false;
+    }
+    return true;
+}
+
+/// @summary Prepare the task pool bound to the calling thread to be returned while other threads continue to run tasks. The mailbox is closed, and the calling thread executes ready-to-run tasks from its own queue or stolen from other pools until every task defined in the pool has completed.
+/// Without this, a task defined in the pool that is still waiting on its dependencies, or running on another thread, would be left in the pool's task data when the pool is re-allocated.
+/// Tasks waiting on an external task keep the calling thread in this function until the external task is completed.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread, which must own the task pool.
+/// @return The number of tasks executed.
+internal_function size_t
+OsDrainTaskPool
+(
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    OS_TASK_POOL      *self = taskenv->TaskPool;
+    OS_TASK_POOL *pool_list = self->TaskPoolList;
+    size_t       pool_count = taskenv->TaskScheduler->TaskPoolCount;
+    size_t      steal_index = self->PoolIndex;
+    size_t            count = 0;
+    uint32_t          spins = 0;
+    os_task_id_t       work = OS_INVALID_TASK_ID;
+    bool          more_work = false;
+
+    // thread-affine tasks delivered after this point are cancelled by the thread that makes them ready-to-run.
+    OsTaskMailboxClose(taskenv);
+    while (!OsTaskPoolIsIdle(self))
+    {   // the outstanding tasks may be waiting on work in any pool, so help to run it.
+        if ((work = OsTaskQueueTake(&self->WorkQueue, more_work)) == OS_INVALID_TASK_ID)
+        {
+            steal_index = (steal_index + 1) % pool_count;
+            work = OsTaskQueueSteal(&pool_list[steal_index].WorkQueue, more_work);
+        }
+        if (work != OS_INVALID_TASK_ID)
+        {
+            OsExecuteTask(taskenv, work);
+            spins = 0;
+            count++;
+        }
+        else if (++spins < 64)
+        {
+            _mm_pause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    return count;
+}
+
+/// @summary Launch a task scheduler worker thread into a specific worker slot and wait for it to finish initializing.
+/// The per-slot events and I/O completion port are created on first use and retained until the scheduler is destroyed, so that a slot can be reused after its worker is retired.
+/// @param scheduler The OS_TASK_SCHEDULER that owns the worker slot.
+/// @param worker_index The zero-based index of the worker slot. This value must be less than MaxWorkerThreadCount.
+/// @return Zero if the worker thread was launched and is waiting for work, or -1 if an error occurred.
+internal_function int
+OsLaunchTaskSchedulerWorker
+(
+    OS_TASK_SCHEDULER *scheduler, 
+    size_t          worker_index
+)
+{
+    OS_TASK_SCHEDULER_THREAD_INIT winit = {};
+    const DWORD            THREAD_READY = 0;
+    const DWORD            THREAD_ERROR = 1;
+    const DWORD              WAIT_COUNT = 2;
+    HANDLE              wset[WAIT_COUNT]={};
+    DWORD                        waitrc = 0;
+    size_t                     nthreads = scheduler->MaxWorkerThreadCount;
+
+    assert(worker_index < scheduler->MaxWorkerThreadCount);
+    assert(scheduler->WorkerThreadHandle[worker_index] == NULL);
+
+    // create the manual-reset events signaled by the worker to indicate that it is ready.
+    if (scheduler->WorkerThreadReady[worker_index] == NULL && (scheduler->WorkerThreadReady[worker_index] = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to create ready signal for worker %Iu of %Iu (%08X).\n", __FUNCTION__, GetCurrentThreadId(), worker_index, nthreads, GetLastError());
+        return -1;
+    }
+    if (scheduler->WorkerThreadError[worker_index] == NULL && (scheduler->WorkerThreadError[worker_index] = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to create error signal for worker %Iu of %Iu (%08X).\n", __FUNCTION__, GetCurrentThreadId(), worker_index, nthreads, GetLastError());
+        return -1;
+    }
+    if (scheduler->WorkerThreadPort[worker_index] == NULL && (scheduler->WorkerThreadPort[worker_index] = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to create I/O completion port for worker %Iu of %Iu (%08X).\n", __FUNCTION__, GetCurrentThreadId(), worker_index, nthreads, GetLastError());
+        return -1;
+    }
+    // the events may have been signaled by a previous worker in this slot.
+    ResetEvent(scheduler->WorkerThreadReady[worker_index]);
+    ResetEvent(scheduler->WorkerThreadError[worker_index]);
+    scheduler->WorkerThreadStats[worker_index].IdleSince.store(0, std::memory_order_relaxed);
+
+    // populate the OS_TASK_SCHEDULER_THREAD_INIT and then spawn the worker thread.
+    // the worker thread will need to copy this structure if it wants to access it 
+    // past the point where it signals the wready event.
+    winit.TaskScheduler   = scheduler;
+    winit.HostCpuInfo     = scheduler->HostCpuInfo;
+    winit.CompletionPort  = scheduler->WorkerThreadPort [worker_index];
+    winit.ReadySignal     = scheduler->WorkerThreadReady[worker_index];
+    winit.ErrorSignal     = scheduler->WorkerThreadError[worker_index];
+    winit.TaskContextData = scheduler->TaskContextData;
+    winit.IoThreadPool    = scheduler->IoThreadPool;
+    winit.WorkerIndex     =(uint32_t) worker_index;
+    winit.PoolId          = scheduler->WorkerPoolId;
+    if ((scheduler->WorkerThreadHandle[worker_index] = (HANDLE) _beginthreadex(NULL, 0, OsTaskSchedulerThreadMain, &winit, 0, &scheduler->WorkerThreadIds[worker_index])) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to spawn worker %Iu of %Iu (errno = %d).\n", __FUNCTION__, GetCurrentThreadId(), worker_index, nthreads, errno);
+        return -1;
+    }
+
+    // wait for the thread to become ready.
+    wset[THREAD_READY] = scheduler->WorkerThreadReady[worker_index]; 
+    wset[THREAD_ERROR] = scheduler->WorkerThreadError[worker_index];
+    if ((waitrc = WaitForMultipleObjects(WAIT_COUNT, wset, FALSE, INFINITE)) != (WAIT_OBJECT_0+THREAD_READY))
+    {   // thread initialization failed, or the wait failed.
+        // a worker that signals its error event exits immediately afterward; any 
+        // other worker is told to shut down so that the slot can be cleaned up.
+        OsLayerError("ERROR: %S(%u): Failed to initialize worker %Iu of %Iu (%08X).\n", __FUNCTION__, GetCurrentThreadId(), worker_index, nthreads, waitrc);
+        if (waitrc != (WAIT_OBJECT_0+THREAD_ERROR))
+        {
+            PostQueuedCompletionStatus(scheduler->WorkerThreadPort[worker_index], 0, OS_COMPLETION_KEY_SHUTDOWN, NULL);
+        }
+        WaitForSingleObject(scheduler->WorkerThreadHandle[worker_index], INFINITE);
+        CloseHandle(scheduler->WorkerThreadHandle[worker_index]);
+        scheduler->WorkerThreadHandle[worker_index] = NULL;
+        scheduler->WorkerThreadIds[worker_index] = 0;
+        return -1;
+    }
+    // SetThreadGroupAffinity, eventually.
+    return 0;
+}
+
+/// @summary Send an application-defined signal from one worker thread to one or more other worker threads in the same pool.
+/// @param iocp The I/O completion port handle for the thread pool.
+/// @param signal_arg The application-defined data to send as the signal.
+/// @param thread_count The number of waiting threads to signal.
+/// @param last_error If the function returns false, the system error code is stored in this location.
+/// @return true if the specified number of signal notifications were successfully posted to the thread pool.
+internal_function bool
+OsSignalWorkerThreads
+(
+    HANDLE          iocp, 
+    uintptr_t signal_arg, 
+    size_t  thread_count, 
+    DWORD    &last_error
+)
+{
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        if (!PostQueuedCompletionStatus(iocp, 0, signal_arg, NULL))
+        {   // only report the first failure.
+            if (last_error == ERROR_SUCCESS)
+            {   // save the error code.
+                last_error  = GetLastError();
+            } return false;
+        }
+    }
+    return true;
+}
+
+/// @summary Allocate the memory for a worker-local work item queue and initialize the queue to empty.
+/// @param queue The work item queue to initialize.
+/// @param capacity The capacity of the queue. This value must be a power of two greater than zero.
+/// @param arena The memory arena to allocate from. The caller should ensure that sufficient memory is available.
+/// @return Zero if the queue is created successfully, or -1 if an error occurred.
+internal_function int
+OsCreateWorkerQueue
+(
+    OS_WORKER_QUEUE *queue, 
+    size_t        capacity, 
+    OS_MEMORY_ARENA *arena
+)
+{   // the capacity must be a power of two.
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    queue->EnqueuePos.store(0, std::memory_order_relaxed);
+    queue->DequeuePos.store(0, std::memory_order_relaxed);
+    queue->Mask  = capacity - 1;
+    if ((queue->Cells = OsMemoryArenaAllocateArray<OS_WORKER_QUEUE_CELL>(arena, capacity)) == NULL)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < capacity; ++i)
+    {   // each cell is initially available for writing at position i.
+        queue->Cells[i].Sequence.store(i, std::memory_order_relaxed);
+        queue->Cells[i].WorkItem = 0;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    return 0;
+}
+
+/// @summary Attempt to add a work item to a worker queue. This function can be called by any thread, and may execute concurrently with other push and pop operations.
+/// @param queue The queue to receive the item.
+/// @param work_item The application-defined work item value.
+/// @return true if the item was written to the queue, or false if the queue is full.
+internal_function bool
+OsWorkerQueuePush
+(
+    OS_WORKER_QUEUE *queue, 
+    uintptr_t    work_item
+)
+{
+    OS_WORKER_QUEUE_CELL *cell = NULL;
+    size_t                 pos = queue->EnqueuePos.load(std::memory_order_relaxed);
+    for ( ; ; )
+    {
+        cell = &queue->Cells[pos & queue->Mask];
+        size_t   seq = cell->Sequence.load(std::memory_order_acquire);
+        intptr_t dif =(intptr_t) seq - (intptr_t) pos;
+        if (dif == 0)
+        {   // the cell is free; race other producers to claim it.
+            if (queue->EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+        {   // the cell still holds an item from the previous lap; the queue is full.
+            return false;
+        }
+        else
+        {   // another producer claimed the cell; reload and try again.
+            pos = queue->EnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->WorkItem = work_item;
+    cell->Sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+/// @summary Attempt to remove the oldest work item from a worker queue. This function can be called by the owning worker or any stealing worker, and may execute concurrently with other push and pop operations.
+/// @param queue The queue from which the item will be removed.
+/// @param work_item On return, if the function returns true, this location stores the application-defined work item value.
+/// @return true if an item was removed from the queue, or false if the queue is empty.
+internal_function bool
+OsWorkerQueuePop
+(
+    OS_WORKER_QUEUE *queue, 
+    uintptr_t   &work_item
+)
+{
+    OS_WORKER_QUEUE_CELL *cell = NULL;
+    size_t                 pos = queue->DequeuePos.load(std::memory_order_relaxed);
+    for ( ; ; )
+    {
+        cell = &queue->Cells[pos & queue->Mask];
+        size_t   seq = cell->Sequence.load(std::memory_order_acquire);
+        intptr_t dif =(intptr_t) seq - (intptr_t)(pos + 1);
+        if (dif == 0)
+        {   // the cell holds an item; race other consumers to claim it.
+            if (queue->DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+        {   // the cell has not been written yet; the queue is empty.
+            return false;
+        }
+        else
+        {   // another consumer claimed the cell; reload and try again.
+            pos = queue->DequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    work_item = cell->WorkItem;
+    cell->Sequence.store(pos + queue->Mask + 1, std::memory_order_release);
+    return true;
+}
+
+/// @summary Take a work item for a thread pool worker, first from the worker's own queue and then by stealing from the queues of the other workers in the pool.
+/// @param pool The OS_THREAD_POOL that owns the worker queues.
+/// @param worker_index The zero-based index of the calling worker.
+/// @param work_item On return, if the function returns true, this location stores the application-defined work item value.
+/// @return true if a work item was taken, or false if all worker queues are empty.
+internal_function bool
+OsThreadPoolTakeWorkItem
+(
+    OS_THREAD_POOL    *pool, 
+    size_t     worker_index, 
+    uintptr_t    &work_item
+)
+{
+    size_t const nqueue = pool->QueueCount;
+    if (OsWorkerQueuePop(&pool->WorkerQueues[worker_index], work_item))
+    {   // the common case - the worker drains its own queue.
+        return true;
+    }
+    for (size_t i = 1; i < nqueue; ++i)
+    {   // steal from the other workers, starting with the next worker in the pool.
+        if (OsWorkerQueuePop(&pool->WorkerQueues[(worker_index + i) % nqueue], work_item))
+            return true;
+    }
+    return false;
+}
+
+/// @summary Determine whether any worker queue in a thread pool has a work item that has been claimed by a submitter but not yet taken by a worker.
+/// @param pool The OS_THREAD_POOL to check.
+/// @return true if at least one worker queue is non-empty.
+internal_function bool
+OsThreadPoolHasQueuedWork
+(
+    OS_THREAD_POOL *pool
+)
+{
+    for (size_t i = 0, n = pool->QueueCount; i < n; ++i)
+    {
+        OS_WORKER_QUEUE *queue = &pool->WorkerQueues[i];
+        if (queue->EnqueuePos.load(std::memory_order_seq_cst) != queue->DequeuePos.load(std::memory_order_seq_cst))
+            return true;
+    }
+    return false;
+}
+
+/// @summary Remove the calling worker from the idle count of a thread pool, unless a submitter has already claimed it.
+/// @param pool The OS_THREAD_POOL managing the calling worker.
+/// @return true if the idle count was decremented, or false if a submitter has claimed the worker and a wakeup is pending on the completion port.
+internal_function bool
+OsThreadPoolCancelIdle
+(
+    OS_THREAD_POOL *pool
+)
+{
+    size_t idle = pool->IdleThreads.load(std::memory_order_relaxed);
+    while (idle > 0)
+    {
+        if (pool->IdleThreads.compare_exchange_weak(idle, idle - 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+/// @summary Submit a batch of work items to the worker queues of a thread pool, and wake at most one idle worker per queued item.
+/// Items that do not fit in any worker queue are posted directly to the pool completion port.
+/// @param pool The OS_THREAD_POOL that will execute the work items.
+/// @param queue_index The zero-based index of the first worker queue to receive items.
+/// @param spread Specify true to distribute items round-robin across the worker queues, or false to fill the queue at queue_index before spilling to the next queue.
+/// @param work_items The set of non-zero, application-defined work item values to submit.
+/// @param item_count The number of items in the work_items array.
+/// @param last_error If the function returns false, the system error code is stored in this location.
+/// @return true if all work items were submitted and any required wakeups were posted.
+internal_function bool
+OsSubmitWorkItems
+(
+    OS_THREAD_POOL        *pool, 
+    size_t          queue_index, 
+    bool                 spread, 
+    uintptr_t const *work_items, 
+    size_t           item_count, 
+    DWORD           &last_error
+)
+{
+    size_t const nqueue = pool->QueueCount;
+    size_t      nqueued = 0;
+    size_t        nwake = 0;
+    size_t         idle = 0;
+
+    for (nqueued = 0; nqueued < item_count; ++nqueued)
+    {
+        uintptr_t item = work_items[nqueued];
+        size_t   nfull = 0;
+        assert(item != 0 && item != OS_COMPLETION_KEY_WORK_QUEUED && item != OS_COMPLETION_KEY_SHUTDOWN);
+        for (nfull = 0; nfull < nqueue; ++nfull)
+        {   // try each queue at most once before falling back to the completion port.
+            if (OsWorkerQueuePush(&pool->WorkerQueues[queue_index], item))
+                break;
+            queue_index = (queue_index + 1) % nqueue;
+        }
+        if (nfull == nqueue)
+        {   // every worker queue is full.
+            break;
+        }
+        if (spread)
+        {   // the next item goes to the next worker.
+            queue_index = (queue_index + 1) % nqueue;
+        }
+    }
+
+    // make the queued items visible before sampling the idle count.
+    // a worker increments the idle count before checking the queues, so 
+    // either the worker sees the new items or this thread sees the worker.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    idle = pool->IdleThreads.load(std::memory_order_relaxed);
+    while (nwake < nqueued && idle > 0)
+    {   // claim one idle worker for each queued item.
+        if (pool->IdleThreads.compare_exchange_weak(idle, idle - 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            nwake++;
+            idle--;
+        }
+    }
+    if (nwake > 0 && !OsSignalWorkerThreads(pool->CompletionPort, OS_COMPLETION_KEY_WORK_QUEUED, nwake, last_error))
+    {   // the claimed workers may not wake up, but another worker will drain their queues.
+        return false;
+    }
+    for (size_t i = nqueued; i < item_count; ++i)
+    {   // the worker queues are full; fall back to one completion packet per item.
+        if (!OsSignalWorkerThreads(pool->CompletionPort, work_items[i], 1, last_error))
+            return false;
+    }
+    return true;
+}
+
+/// @summary Call from a thread pool worker only. Puts the worker thread to sleep until a signal is received on the pool, or the pool is shutting down.
+/// @param iocp The handle of the I/O completion port used to signal the thread pool.
+/// @param term The handle of the manual-reset event used to signal worker threads to terminate.
+/// @param tid The operating system thread identifier of the calling worker thread.
+/// @param key The location to receive the pointer value sent with the wake signal.
+/// @return One of OS_WORKER_THREAD_WAKE_REASON.
+internal_function int
+OsWorkerThreadWaitForWakeup
+(
+    HANDLE    iocp,
+    HANDLE    term, 
+    uint32_t   tid,
+    uintptr_t &key
+)
+{
+    OVERLAPPED *ov_addr = NULL;
+    DWORD        nbytes = 0;
+    DWORD        termrc = 0;
+
+    // prior to entering the wait state, check the termination signal.
+    if ((termrc = WaitForSingleObject(term, 0)) != WAIT_TIMEOUT)
+    {   // either termination was signaled, or an error occurred.
+        // either way, exit prior to entering the wait state.
+        if (termrc != WAIT_OBJECT_0)
+        {   // an error occurred while checking the termination signal.
+            OsLayerError("ERROR: %S(%u): Checking termination signal failed with result 0x%08X (0x%08X).\n", __FUNCTION__, tid, termrc, GetLastError());
+        }
+        return OS_WORKER_THREAD_WAKE_FOR_EXIT;
+    }
+    if (GetQueuedCompletionStatus(iocp, &nbytes, &key, &ov_addr, INFINITE))
+    {   // check the termination signal before possibly dispatching work.
+        int      rc = key != 0 ? OS_WORKER_THREAD_WAKE_FOR_RUN : OS_WORKER_THREAD_WAKE_FOR_SIGNAL;
+        if ((termrc = WaitForSingleObject(term, 0)) != WAIT_TIMEOUT)
+        {
+            if (termrc != WAIT_OBJECT_0)
+            {   // an error occurred while checking the termination signal.
+                OsLayerError("ERROR: %S(%u): Checking termination signal failed with result 0x%08X (0x%08X).\n", __FUNCTION__, tid, termrc, GetLastError());
+            }
+            rc = OS_WORKER_THREAD_WAKE_FOR_EXIT;
+        }
+        return rc;
+    }
+    else
+    {   // the call to GetQueuedCompletionStatus failed.
+        OsLayerError("ERROR: %S(%u): GetQueuedCompletionStatus failed with result 0x%08X.\n", __FUNCTION__, tid, GetLastError());
+        return OS_WORKER_THREAD_WAKE_FOR_ERROR;
+    }
+}
+
+/// @summary Convert a lowercase ASCII character 'a'-'z' to the corresponding uppercase character.
+/// @param ch The input character.
+/// @return The uppercase version of the input character.
+internal_function inline int
+OsToUpper
+(
+    char ch
+)
+{   // TODO(rlk): this works only for C locale. if locale support is needed, use toupper in ctype.h.
+    return (ch >= 'a' && ch <= 'z') ? (ch - 'a' + 'A') : ch;
+}
+
+/// @summary Convert a lowercase ASCII character 'a'-'z' to the corresponding uppercase character.
+/// @param ch The input character.
+/// @return The uppercase version of the input character.
+internal_function inline int
+OsToUpper
+(
+    WCHAR ch
+)
+{   // TODO(rlk): this works only for C locale. if locale support is needed, use towupper in ctype.h.
+    return (ch >= L'a' && ch <= L'z') ? (ch - L'a' + L'A') : ch;
+}
+
+/// @summary Convert an uppercase ASCII character 'A'-'Z' to the corresponding lowercase character.
+/// @param ch The input character.
+/// @return The lowercase version of the input character.
+internal_function inline int
+OsToLower
+(
+    char ch
+)
+{   // TODO(rlk): this works only for C locale. if locale support is needed, use tolower in ctype.h.
+    return (ch >= 'A' && ch <= 'Z') ? (ch - 'A' + 'a') : ch;
+}
+
+/// @summary Convert an uppercase ASCII character 'A'-'Z' to the corresponding lowercase character.
+/// @param ch The input character.
+/// @return The lowercase version of the input character.
+internal_function inline int
+OsToLower
+(
+    WCHAR ch
+)
+{   // TODO(rlk): this works only for C locale. if locale support is needed, use towlower in ctype.h.
+    return (ch >= L'A' && ch <= L'Z') ? (ch - L'A' + L'a') : ch;
+}
+
+/// @summary Normalize path separators for a character.
+/// @param ch The character to inspect.
+/// @return The forward slash if ch is a backslash, otherwise ch.
+internal_function inline uint32_t 
+OsNormalizePathSeparator
+(
+    char ch
+)
+{
+    return ch != '\\' ? uint32_t(OsToLower(ch)) : uint32_t('/');
+}
+
+/// @summary Normalize path separators for a character.
+/// @param ch The character to inspect.
+/// @return The forward slash if ch is a backslash, otherwise ch.
+internal_function inline uint32_t
+OsNormalizePathSeparator
+(
+    WCHAR ch
+)
+{
+    return ch != L'\\' ? uint32_t(OsToLower(ch)) : uint32_t(L'/');
+}
+
+/// @summary Calculates a 32-bit hash value for a path string. Forward and backslashes are treated as equivalent.
+/// @param path A NULL-terminated UTF-8 path string.
+/// @return The hash of the specified string.
+internal_function uint32_t 
+OsHashPath
+(
+    char const *path
+)
+{
+    if (path != NULL && path[0] != 0)
+    {
+        uint32_t    code = 0;
+        uint32_t    hash = 0;
+        char const *iter = path;
+        do {
+            code = OsNormalizePathSeparator(*iter++);
+            hash = _lrotl(hash, 7) + code;
+        } while (code != 0);
+        return hash;
+    }
+    else return 0;
+}
+
+/// @summary Calculates a 32-bit hash value for a path string. Forward and backslashes are treated as equivalent.
+/// @param path A NULL-terminated UTF-8 path string.
+/// @return The hash of the specified string.
+internal_function uint32_t
+OsHashPath
+(
+    WCHAR const *path
+)
+{
+    if (path != NULL && path[0] != 0)
+    {
+        uint32_t     code = 0;
+        uint32_t     hash = 0;
+        WCHAR const *iter = path;
+        do {
+            code = OsNormalizePathSeparator(*iter++);
+            hash = _lrotl(hash, 7) + code;
+        } while (code != 0);
+        return hash;
+    }
+    else return 0;
+}
+
+/// @summary Locate one substring within another, ignoring case.
+/// @param search The zero-terminated ASCII string to search.
+/// @param find The zero-terminated ASCII string to locate within the search string.
+/// @return A pointer to the start of the first match, or NULL.
+internal_function char const*
+OsStringSearch
+(
+    char const *search, 
+    char const *find
+)
+{
+    if (search == NULL)
+    {   // invalid search string.
+        return NULL;
+    }
+    if (*search == 0 && *find == 0)
+    {   // both are empty strings.
+        return search;
+    }
+    else if (*search == 0)
+    {   // search is an empty string, but find is not.
+        return NULL;
+    }
+    else
+    {   // both search and find are non-NULL, non-empty strings.
+        char const *si = search;
+        int  const  ff = OsToLower(*find++);
+        for ( ; ; )
+        {
+            int const sc = OsToLower(*si++);
+            if (sc == ff)
+            {   // first character of find matches this character of search.
+                char const *ss = si;   // si points to one after the match.
+                char const *fi = find; // find points to the second character.
+                for ( ; ; )
+                {
+                    int const s = OsToLower(*ss++);
+                    int const f = OsToLower(*fi++);
+                    if (f == 0) return si-1;
+                    if (s == 0) return NULL;
+                    if (s != f) break;
+                }
+            }
+            if (sc == 0) break;
+        }
+    }
+    return NULL;
+}
+
+/// @summary Figure out the starting and ending points of the directory path, filename and extension information in a path string.
+/// @param buf The zero-terminated path string to parse. Any forward slashes are converted to backslashes.
+/// @param buf_end A pointer to the zero terminator character of the input path string. This value must be valid.
+/// @param parts The OS_PATH_PARTS to update. The Root, RootEnd and PathFlags fields must be set.
+/// @return This function always returns zero to indicate success.
+internal_function int
+OsExtractNativePathParts
+(
+    WCHAR           *buf, 
+    WCHAR       *buf_end, 
+    OS_PATH_PARTS *parts
+)
+{   // initialize the components of the path parts to known values.
+    parts->Path         = parts->RootEnd;
+    parts->PathEnd      = parts->RootEnd;
+    parts->Filename     = parts->RootEnd;
+    parts->FilenameEnd  = parts->RootEnd;
+    parts->Extension    = buf_end;
+    parts->ExtensionEnd = buf_end;
+
+    while (parts->FilenameEnd < buf_end)
+    {
+        if (parts->FilenameEnd[0] == L'/')
+            parts->FilenameEnd[0]  = L'\\';
+        if (parts->FilenameEnd[0] == L'\\')
+        {   // encountered a path separator.
+            // update the end of the directory path string.
+            // reset the filename string to be zero-length.
+            parts->PathEnd     = parts->FilenameEnd;
+            parts->PathFlags  |= OS_PATH_FLAG_PATH;
+            parts->Filename    = parts->FilenameEnd + 1;
+            parts->FilenameEnd = parts->FilenameEnd + 1;
+        }
+        else
+        {   // this is a regular character; consider it part of the filename.
+            parts->FilenameEnd++;
+        }
+    }
+    if (parts->Path[0] == L'\\')
+    {   // skip the leading path separator.
+        if (parts->Path == parts->PathEnd)
+        {   // there is no actual path component; this is something like "C:\".
+            parts->PathFlags &= ~OS_PATH_FLAG_PATH;
+            parts->PathEnd++;
+        }
+        parts->Path++;
+    }
+
+    if (parts->Filename != parts->FilenameEnd)
+    {   // figure out whether this last bit is a filename or part of the directory path.
+        WCHAR *iter  = buf_end;
+        while (iter >= parts->Filename)
+        {   // consider 'a.b', '.a.b' and 'a.' to be a filename, but not '.a'.
+            if (*iter == L'.' && iter != parts->Filename)
+            {
+                parts->FilenameEnd = iter;
+                parts->Extension   = iter + 1;
+                parts->PathFlags  |= OS_PATH_FLAG_FILENAME;
+                parts->PathFlags  |= OS_PATH_FLAG_EXTENSION;
+            }
+            iter--;
+        }
+        if ((parts->PathFlags & OS_PATH_FLAG_FILENAME) == 0)
+        {   // consider 'a' and '.a' to be part of the directory path information.
+            parts->PathEnd     = parts->FilenameEnd;
+            parts->PathFlags  |= OS_PATH_FLAG_PATH;
+            parts->Filename    = buf_end;
+            parts->FilenameEnd = buf_end;
+        }
+    }
+    else
+    {   // if there's no filename present, make sure that it points to an empty string.
+        parts->Filename    = buf_end;
+        parts->FilenameEnd = buf_end;
+    }
+    UNREFERENCED_PARAMETER(buf);
+    return 0;
+}
+
+/// @summary Enumerate all files in a directory (and possibly its subdirectories.)
+/// @param buf The native path to search. The buffer contents are overwritten during enumeration.
+/// @param buf_bytes The maximum number of bytes that can be written to the path string buffer.
+/// @param buf_end A pointer to the zero-terminator codepoint within the path string buffer.
+/// @param filter A zero-terminated string specifying the filter to use when locating files. The filter supports wildcards. Specify a filter of * to include all files in the search.
+/// @param recurse Specify true to include files located in subdirectories in the search results.
+/// @param total_files This value is updated to include the total number of files returned by the search.
+/// @param alloc The OS_FILE_INFO_CHUNK allocator to use for allocating blocks of file information to store the search results.
+/// @param chunk The OS_FILE_INFO_CHUNK to which search results will be written, or NULL if no search results have been returned yet. New chunks are allocated as-needed.
+/// @return A pointer to the OS_FILE_INFO_CHUNK containing the search results.
+internal_function OS_FILE_INFO_CHUNK*
+OsEnumerateDirectory
+(
+    WCHAR                *buf, 
+    size_t          buf_bytes, 
+    WCHAR            *buf_end,
+    WCHAR const       *filter, 
+    bool              recurse, 
+    size_t       &total_files, 
+    OS_FSIC_ALLOCATOR  *alloc, 
+    OS_FILE_INFO_CHUNK *chunk
+)
+{   size_t const MAX_UTF8 = 1024; // maximum of 1024 bytes of UTF-8 data returned for filename.
+    HANDLE    find_handle = INVALID_HANDLE_VALUE;
+    WCHAR       *base_end = buf_end;
+    WCHAR     *filter_end = buf_end;
+    size_t   filter_chars = 0;
     size_t   bytes_needed = 0;
     int       fname_bytes = 0;
     WIN32_FIND_DATA    fd;
     char utf8buf[MAX_UTF8];
 
-    if (recurse)
-    {   // if recursion is enabled, filter with *, and recurse into all subdirectories.
-        if ((filter_chars = OsNativePathAppend(buf, buf_bytes, &filter_end, bytes_needed, L"*")) == 0)
+    if (recurse)
+    {   // if recursion is enabled, filter with *, and recurse into all subdirectories.
+        if ((filter_chars = OsNativePathAppend(buf, buf_bytes, &filter_end, bytes_needed, L"*")) == 0)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to construct * filter string for path %s.\n", __FUNCTION__, GetCurrentThreadId(), buf);
+            return chunk;
+        }
+        if ((find_handle = FindFirstFileEx(buf, FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH)) == INVALID_HANDLE_VALUE)
+        {
+            OsLayerError("ERROR: %S(%u): Search filter %s failed (%08X).\n", __FUNCTION__, GetCurrentThreadId(), buf, GetLastError());
+            return chunk;
+        }
+        do
+        {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                if ((fd.cFileName[0] == L'.' && fd.cFileName[1] == 0) || (fd.cFileName[0] == L'.' && fd.cFileName[1] == L'.' && fd.cFileName[2] == 0))
+                {   // skip the current directory and parent directory links.
+                    continue;
+                }
+                else
+                {   // build the path string for the subdirectory.
+                    *base_end = 0; filter_end = base_end;
+                    if ((filter_chars = OsNativePathAppend(buf, buf_bytes, &filter_end, bytes_needed, fd.cFileName)) == 0)
+                    {
+                        *base_end = 0; filter_end = base_end;
+                        OsLayerError("ERROR: %S(%u): Unable to recurse into subdirectory %s of path %s.\n", __FUNCTION__, GetCurrentThreadId(), fd.cFileName, buf);
+                    }
+                    // recurse into the subdirectory.
+                    chunk = OsEnumerateDirectory(buf, buf_bytes, filter_end, filter, recurse, total_files, alloc, chunk);
+                }
+            }
+        } 
+        while (FindNextFile(find_handle, &fd));
+        FindClose(find_handle); find_handle = INVALID_HANDLE_VALUE;
+    }
+
+    // now search with the actual filter applied, and look at files only.
+    *base_end = 0; filter_end = base_end;
+    if ((filter_chars = OsNativePathAppend(buf, buf_bytes, &filter_end, bytes_needed, filter)) == 0)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to construct filter string from %s and %s.\n", __FUNCTION__, GetCurrentThreadId(), buf, filter);
+        return chunk;
+    }
+    if ((find_handle = FindFirstFileEx(buf, FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH)) == INVALID_HANDLE_VALUE)
+    {
+        OsLayerError("ERROR: %S(%u): Search filter %s failed (%08X).\n", __FUNCTION__, GetCurrentThreadId(), buf, GetLastError());
+        return chunk;
+    }
+    do
+    {   // skip over anything that's not a proper file or symlink.
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DEVICE)
+            continue;
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_VIRTUAL)
+            continue;
+
+        // build the absolute path of the file.
+        *base_end = 0; filter_end = base_end;
+        if ((filter_chars = OsNativePathAppend(buf, buf_bytes, &filter_end, bytes_needed, fd.cFileName)) == 0)
+        {
+            OsLayerError("ERROR: %S(%u): Failed to build filename for path %s, file %s.\n", __FUNCTION__, GetCurrentThreadId(), buf, fd.cFileName);
+            continue;
+        }
+        if (chunk == NULL || chunk->RecordCount == OS_FILE_INFO_CHUNK::CAPACITY)
+        {   // allocate a new chunk; the current chunk is full.
+            OS_FILE_INFO_CHUNK *new_chunk = OsNewFileInfoChunk(alloc);
+            if (new_chunk == NULL)
+            {
+                OsLayerError("ERROR: %S(%u): Failed to allocate OS_FILE_INFO_CHUNK for file %s.\n", __FUNCTION__, GetCurrentThreadId(), buf);
+                continue;
+            }
+            // entries higher up in the tree appear first.
+            new_chunk->NextChunk = chunk;
+            chunk = new_chunk;
+        }
+        // fill out the information for the file in the current chunk.
+        chunk->PathHash[chunk->RecordCount]            = OsHashPath(buf);
+        chunk->FileInfo[chunk->RecordCount].FileSize   = OsMakeInt64(fd.nFileSizeHigh, fd.nFileSizeLow);
+        chunk->FileInfo[chunk->RecordCount].BaseOffset = 0;
+        chunk->FileInfo[chunk->RecordCount].LastWrite  = fd.ftLastWriteTime;
+        chunk->FileInfo[chunk->RecordCount].Attributes = fd.dwFileAttributes;
+        // convert the filename from file system native to UTF-8.
+        // this data will be used for collision resolution and extension searching.
+        if ((fname_bytes = WideCharToMultiByte(CP_UTF8, 0, fd.cFileName, -1, utf8buf, MAX_UTF8, NULL, NULL)) == 0)
+        {
+            OsLayerError("ERROR: %S(%u): Failed to convert filename %s to UTF-8 (%08X).\n", __FUNCTION__, GetCurrentThreadId(), fd.cFileName, GetLastError());
+            continue;
+        }
+        // copy as much data as possible to the filename buffer.
+        // fname_bytes includes one byte for the zero-terminator.
+        size_t fnmax = OS_FILE_INFO::MAX_STRING_BYTES - 1;
+        char  *fndst = chunk->FileInfo[chunk->RecordCount].FileName;
+        char  *fnend = utf8buf + fname_bytes;
+        char  *fnsrc = utf8buf;
+        char  *fnext = NULL;
+        if (fnmax >= size_t(fname_bytes - 1))
+            fnmax  = size_t(fname_bytes - 1);
+        CopyMemory(fndst, fnsrc, fnmax);
+        fndst[fnmax] = 0;
+        // find the file extension and copy as much as possible into the extension buffer.
+        // note that the first character is intentionally NOT included.
+        while (fnend > fnsrc)
+        {
+            if(*fnend == '.')
+                fnext = fnend;
+            fnend--;
+        }
+        if (fnext != NULL)
+        {   // copy the file extension data.
+            fndst  = chunk->FileInfo[chunk->RecordCount].Extension;
+            fnmax  = OS_FILE_INFO::MAX_STRING_BYTES - 1;
+            fnend  = utf8buf + fname_bytes;
+            if (fnmax >= size_t(fnend - fnext - 1))
+                fnmax  = size_t(fnend - fnext - 1);
+            CopyMemory(fndst, fnext, fnmax);
+            fndst[fnmax] = 0;
+        }
+        else
+        {   // there is no file extension.
+            chunk->FileInfo[chunk->RecordCount].Extension[0] = 0;
+        }
+        // all data has been written to the new record. make it visible.
+        chunk->RecordCount++;
+        total_files++;
+    } 
+    while (FindNextFile(find_handle, &fd));
+
+    // finished searching; clean up and return.
+    FindClose(find_handle); find_handle = INVALID_HANDLE_VALUE;
+    return chunk;
+}
+
+/// @summary Helper function to convert a UTF-8 encoded string to the system native WCHAR. Free the returned buffer using the standard C library free() call.
+/// @param str The NULL-terminated UTF-8 string to convert.
+/// @param size_chars On return, stores the length of the string in characters, not including NULL-terminator.
+/// @param size_bytes On return, stores the length of the string in bytes, including the NULL-terminator.
+/// @return The WCHAR string buffer, or NULL if the string could not be converted.
+internal_function WCHAR*
+OsUtf8ToNativeMalloc
+(
+    char const    *str, 
+    size_t &size_chars, 
+    size_t &size_bytes
+)
+{   // figure out how much memory needs to be allocated, including NULL terminator.
+    int nchars = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, -1, NULL, 0);
+    if (nchars == 0)
+    {   // the path cannot be converted from UTF-8 to UCS-2.
+        size_chars = 0;
+        size_bytes = 0;
+        return NULL;
+    }
+    // store output values for the caller.
+    size_chars = nchars - 1;
+    size_bytes = nchars * sizeof(WCHAR);
+    // allocate buffer space for the wide character string.
+    WCHAR *pathbuf = NULL;
+    if   ((pathbuf = (WCHAR*) malloc(size_bytes)) == NULL)
+    {   // unable to allocate temporary memory for UCS-2 path.
+        OsLayerError("ERROR: %S(%u): Memory allocation for %Iu bytes failed.\n", __FUNCTION__, GetCurrentThreadId(), size_bytes);
+        return NULL;
+    }
+    if (MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, -1, pathbuf, nchars) == 0)
+    {   // the path cannot be converted from UTF-8 to UCS-2.
+        OsLayerError("ERROR: %S(%u): Cannot convert from UTF8 to UCS2 (%08X).\n", __FUNCTION__, GetCurrentThreadId(), GetLastError());
+        free(pathbuf);
+        return NULL;
+    }
+    return pathbuf;
+}
+
+/// @summary Generate a Windows API-ready file path for a given virtual path specified relative to the mount point root.
+/// @param mount_local_path A zero-terminated buffer specifying the filesystem mount point local path.
+/// @param local_path_length The number of characters in the mount_local_path string, not including the zero terminator.
+/// @param relative_path The portion of the virtual path specified relative to the mount point root.
+/// @return The API-ready system path, or NULL. Free the returned buffer using free().
+internal_function WCHAR* 
+OsMakeSystemPathMalloc
+(
+    WCHAR        *mount_local_path, 
+    size_t const local_path_length,
+    char   const    *relative_path
+)
+{
+    WCHAR  *pathbuf = NULL;
+    int     nchars  = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, relative_path, -1, NULL, 0);
+    // convert the virtual_path from UTF-8 to UCS-2, which Windows requires.
+    if (nchars == 0)
+    {   // the path cannot be converted from UTF-8 to UCS-2.
+        return NULL;
+    }
+    if ((pathbuf = (WCHAR*) malloc((nchars + local_path_length + 1) * sizeof(WCHAR))) == NULL)
+    {   // unable to allocate memory for UCS-2 path.
+        return NULL;
+    }
+    // start with the local root, and then append the relative path portion.
+    memcpy(pathbuf, mount_local_path, local_path_length * sizeof(WCHAR));
+    pathbuf[local_path_length] = L'\\';
+    if (MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, relative_path, -1, &pathbuf[local_path_length+1], nchars) == 0)
+    {   // the path cannot be converted from UTF-8 to UCS-2.
+        free(pathbuf);
+        return NULL;
+    }
+    // normalize the directory separator characters to the system default.
+    // on Windows, this is not strictly necessary, but on other OS's it is.
+    for (size_t i = local_path_length + 1, n = local_path_length + nchars; i < n; ++i)
+    {
+        if (pathbuf[i] == L'/')
+            pathbuf[i]  = L'\\';
+    }
+    return pathbuf;
+}
+
+/// @summary Retrieve the fully-resolved absolute path for a file or directory.
+/// @param handle The handle of the opened file or directory.
+/// @param length On return, the number of characters in the returned path string is stored here, not including the zero terminator.
+/// @return The zero-terminated, fully-resolved absolute path of the file system entity, or NULL. Free the returned buffer using free().
+internal_function WCHAR*
+OsResolvePathForHandleMalloc
+(
+    HANDLE  handle, 
+    size_t &length
+)
+{
+    WCHAR *pathbuf = NULL;
+    DWORD    flags = VOLUME_NAME_DOS | FILE_NAME_NORMALIZED;
+    DWORD  pathlen = GetFinalPathNameByHandleW(handle, NULL, 0, flags);
+    // GetFinalPathNameByHandle returns the buffer length, in TCHARs, including zero terminator.
+    if (pathlen == 0)
+    {
+        length  = 0;
+        return NULL;
+    }
+    if ((pathbuf = (WCHAR*) malloc(pathlen * sizeof(WCHAR))) == NULL)
+    {
+        length  = 0;
+        return NULL;
+    }
+    // GetFinalPathNameByHandle returns the number of TCHARs written, not including zero terminator.
+    if (GetFinalPathNameByHandleW(handle, pathbuf, pathlen-1, flags) != (pathlen-1))
+    {
+        free(pathbuf);
+        length  = 0;
+        return NULL;
+    }
+    pathbuf[pathlen-1] = 0;
+    length = pathlen-1;
+    return pathbuf;
+}
+
+/// @summary Execute a low-level file open operation.
+/// @param args Information about the file to open. The FilePath and IoHintFlags fields must be set.
+/// @param result Information returned from the operation specifying the file handle and whether the operation completed successfully.
+/// @param file_info If this argument is not NULL, information about the file is stored here on return.
+/// @param sector_size If this argument is not NULL, the physical device sector size is stored here on return.
+internal_function void
+OsIoExecuteOpen
+(
+    OS_IO_OPERATION          &args, 
+    OS_IO_OPERATION_RESULT &result, 
+    FILE_STANDARD_INFO  *file_info, 
+    size_t            *sector_size
+)
+{
+    HANDLE    fd = INVALID_HANDLE_VALUE;
+    DWORD access = 0; // dwDesiredAccess
+    DWORD share  = 0; // dwShareMode
+    DWORD create = 0; // dwCreationDisposition
+    DWORD flags  = 0; // dwFlagsAndAttributes
+
+    if (args.IoHintFlags & OS_IO_HINT_FLAG_OVERWRITE)
+    {   // this implies write access.
+        args.IoHintFlags |= OS_IO_HINT_FLAG_WRITE;
+    }
+    if (args.IoHintFlags & OS_IO_HINT_FLAG_READ)
+    {
+        access |= GENERIC_READ;
+        share   = FILE_SHARE_READ;
+        create  = OPEN_EXISTING;
+        flags   = FILE_FLAG_OVERLAPPED;
+    }
+    if (args.IoHintFlags & OS_IO_HINT_FLAG_WRITE)
+    {
+        access |= GENERIC_WRITE;
+        flags   = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED;
+        if (args.IoHintFlags & OS_IO_HINT_FLAG_OVERWRITE)
+        {   // opening the file will always succeed.
+            create = CREATE_ALWAYS;
+        }
+        else
+        {   // opening the file will always succeed, but existing contents are preserved.
+            create = OPEN_ALWAYS;
+        }
+        if (args.IoHintFlags & OS_IO_HINT_FLAG_TEMPORARY)
+        {   // temporary files are deleted on close, and the cache manager will try to prevent writes to disk.
+            flags |= FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE;
+            share |= FILE_SHARE_DELETE;
+        }
+        else
+        {   // standard persistent file, data will eventually end up on disk.
+            flags |= FILE_ATTRIBUTE_NORMAL;
+        }
+    }
+    if (args.IoHintFlags & OS_IO_HINT_FLAG_SEQUENTIAL)
+    {   // tell the cache manager to optimize for sequential access.
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    }
+    else
+    {   // assume the file will be accessed randomly.
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+    if (args.IoHintFlags & OS_IO_HINT_FLAG_UNCACHED)
+    {   // use unbuffered I/O, reads must be performed in sector size multiples to 
+        // a buffer whose address is also a multiple of the physical disk sector size.
+        flags |= FILE_FLAG_NO_BUFFERING;
+    }
+    if (args.IoHintFlags & OS_IO_HINT_FLAG_WRITE_THROUGH)
+    {   // writes are immediately flushed to disk, if possible.
+        flags |= FILE_FLAG_WRITE_THROUGH;
+    }
+    if ((fd = CreateFile(args.FilePath, access, share, NULL, create, flags, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to open file \"%s\" (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, GetLastError());
+        result.FileHandle = INVALID_HANDLE_VALUE;
+        result.ResultCode = GetLastError();
+        result.TransferAmount = 0;
+        result.CompletedSynchronously = true;
+        result.WasSuccessful = false;
+        return;
+    }
+    if (args.CompletionPort != NULL && CreateIoCompletionPort(fd, args.CompletionPort, 0, 0) != args.CompletionPort)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to associate file \"%s\" with I/O completion port (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, GetLastError());
+        result.FileHandle = INVALID_HANDLE_VALUE;
+        result.ResultCode = GetLastError();
+        result.TransferAmount = 0;
+        result.CompletedSynchronously = true;
+        result.WasSuccessful = false;
+        CloseHandle(fd);
+        return;
+    }
+    if (args.CompletionPort != NULL)
+    {   // immediately complete requests that execute synchronously; don't post completion port notification.
+        // this reduces traffic on the completion port and improves performance for asynchronous requests.
+        SetFileCompletionNotificationModes(fd, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS);
+    }
+    if ((args.IoHintFlags & OS_IO_HINT_FLAG_PREALLOCATE) && args.PreallocationSize > 0)
+    {   // preallocate storage space for the file data, which can significantly improve performance when writing large files.
+        // this can be slower for large files if the file is not written sequentially.
+        LARGE_INTEGER new_ptr; new_ptr.QuadPart = args.PreallocationSize;
+        if (SetFilePointerEx(fd, new_ptr, NULL, FILE_BEGIN))
+        {   // set the end-of-file marker to the new location.
+            if (SetEndOfFile(fd))
+            {   // move the file pointer back to the start of the file.
+                new_ptr.QuadPart = 0;
+                SetFilePointerEx(fd, new_ptr, NULL, FILE_BEGIN);
+            }
+            else
+            {   // this is a non-fatal error since preallocation is an optimization.
+                OsLayerError("ERROR: %S(%u): Failed to preallocate file \"%s\" to %I64d bytes. SetEndOfFile failed (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, args.PreallocationSize, GetLastError()); 
+            }
+        }
+        else
+        {   // this is a non-fatal error since preallocation is an optimization.
+            OsLayerError("ERROR: %S(%u): Failed to preallocate file \"%s\" to %I64d bytes. SetFilePointerEx failed (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, args.PreallocationSize, GetLastError()); 
+        }
+    }
+    if (file_info != NULL)
+    {   // retrieve the end-of-file (logical file size) and allocation size (physical size).
+        ZeroMemory(file_info, sizeof(FILE_STANDARD_INFO));
+        if (!GetFileInformationByHandleEx(fd, FileStandardInfo, file_info, sizeof(FILE_STANDARD_INFO)))
+        {   // this is a non-fatal error since it's just an information request.
+            OsLayerError("ERROR: %S(%u): Failed to retrieve attributes for file \"%s\" (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, GetLastError());
+        }
+    }
+    if (sector_size != NULL)
+    {   // retrieve the physical device sector size. this value is necessary for unbuffered I/O operations, 
+        // where the buffer address and transfer size must be a multiple of the physical device sector size.
+        // TODO(rlk): for this to work, it needs the DEVICE path, ie. \\.\C:, and then you have to open a handle.
+        // TODO(rlk): GetFileInformationByHandleEx could also be used, but that is Windows 8+ for the property we need.
+        // TODO(rlk): for now, just hard-code to 4096.
+        /*STORAGE_ACCESS_ALIGNMENT_DESCRIPTOR desc;
+        STORAGE_PROPERTY_QUERY query;
+        DWORD bytes = 0;
+        ZeroMemory(&desc , sizeof(STORAGE_ACCESS_ALIGNMENT_DESCRIPTOR));
+        ZeroMemory(&query, sizeof(STORAGE_PROPERTY_QUERY));
+        query.QueryType  = PropertyStandardQuery;
+        query.PropertyId = StorageAccessAlignmentProperty;
+        if (DeviceIoControl(fd, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query), &desc, sizeof(desc), &bytes, NULL))
+        {   // save the physical device sector size.
+           *sector_size  = desc.BytesPerPhysicalSector; 
+        }
+        else
+        {   // this is a non-fatal error; return a default that will work for all common disks.
+            OsLayerError("ERROR: %S(%u): Failed to retrieve physical device sector size for file \"%s\" (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, GetLastError());
+           *sector_size = 4096;
+        }*/
+        *sector_size = 4096;
+    }
+    result.FileHandle = fd;
+    result.ResultCode = GetLastError();
+    result.TransferAmount = 0;
+    result.CompletedSynchronously = true;
+    result.WasSuccessful = true;
+}
+
+/// @summary Execute a synchronous or asynchronous read operation.
+/// @param args Information about the read operation. The FileHandle, DataBuffer and TransferAmount fields must be set.
+/// @param result Information returned from the operation specifying the number of bytes transferred and whether the operation completed successfully.
+internal_function void
+OsIoExecuteRead
+(
+    OS_IO_OPERATION          &args,
+    OS_IO_OPERATION_RESULT &result
+)
+{   
+    DWORD transferred = 0;
+    // the request is submitted to be performed asynchronously, but can complete
+    // either synchronously or asynchronously. this routine hides that complexity.
+    if (args.Overlapped)
+    {   // populate the required fields of the OVERLAPPED strucure for an asynchronous request.
+        args.Overlapped->Internal     = 0;
+        args.Overlapped->InternalHigh = 0;
+        args.Overlapped->Offset       =(DWORD) (args.FileOffset        & 0xFFFFFFFFUL);
+        args.Overlapped->OffsetHigh   =(DWORD)((args.FileOffset >> 32) & 0xFFFFFFFFUL);
+    }
+    else if (args.FileOffset >= 0)
+    {   // for synchronous I/O, support implicit seeking within the file.
+        LARGE_INTEGER new_ptr; new_ptr.QuadPart = args.FileOffset;
+        if (!SetFilePointerEx(args.FileHandle, new_ptr, NULL, FILE_BEGIN))
+        {   // the seek operation failed - fail the read operation.
+            result.FileHandle = args.FileHandle;
+            result.ResultCode = GetLastError();
+            result.CompletedSynchronously = true;
+            result.WasSuccessful = false;
+            return;
+        }
+    }
+    if (ReadFile(args.FileHandle, args.DataBuffer, args.TransferAmount, &transferred, args.Overlapped))
+    {   // the read operation completed synchronously (likely the data was in-cache.)
+        result.FileHandle = args.FileHandle;
+        result.ResultCode = GetLastError();
+        result.TransferAmount = transferred;
+        result.CompletedSynchronously = true;
+        result.WasSuccessful = true;
+    }
+    else
+    {   // the operation could have failed, or it could be completing asynchronously.
+        // it could also be the case that end-of-file was reached.
+        switch ((result.ResultCode = GetLastError()))
+        {
+            case ERROR_IO_PENDING:
+                { // the request will complete asynchronously.
+                  result.FileHandle = args.FileHandle;
+                  result.TransferAmount = 0;
+                  result.CompletedSynchronously = false;
+                  result.WasSuccessful = true;
+                } break;
+            case ERROR_HANDLE_EOF:
+                { // attempt to read past end-of-file; result.TransferAmount is set to the number of bytes available.
+                  result.FileHandle = args.FileHandle;
+                  result.TransferAmount = transferred;
+                  result.CompletedSynchronously = true;
+                  result.WasSuccessful = true;
+                } break;
+            default:
+                { // an actual error occurred.
+                  result.FileHandle = args.FileHandle;
+                  result.TransferAmount = transferred;
+                  result.CompletedSynchronously = true;
+                  result.WasSuccessful = false;
+                } break;
+        }
+    }
+}
+
+/// @summary Execute a synchronous or asynchronous write operation.
+/// @param args Information about the write operation. The FileHandle, DataBuffer and TransferAmount fields must be set.
+/// @param result Information returned from the operation specifying the number of bytes transferred and whether the operation completed successfully.
+internal_function void
+OsIoExecuteWrite
+(
+    OS_IO_OPERATION          &args, 
+    OS_IO_OPERATION_RESULT &result
+)
+{   
+    DWORD transferred = 0;
+    // the request is submitted to be performed asynchronously, but can complete
+    // either synchronously or asynchronously. this routine hides that complexity.
+    if (args.Overlapped)
+    {   // populate the required fields of the OVERLAPPED strucure for an asynchronous request.
+        args.Overlapped->Internal     = 0;
+        args.Overlapped->InternalHigh = 0;
+        args.Overlapped->Offset       =(DWORD) (args.FileOffset        & 0xFFFFFFFFUL);
+        args.Overlapped->OffsetHigh   =(DWORD)((args.FileOffset >> 32) & 0xFFFFFFFFUL);
+    }
+    else if (args.FileOffset >= 0)
+    {   // for synchronous I/O, support implicit seeking within the file.
+        LARGE_INTEGER new_ptr; new_ptr.QuadPart = args.FileOffset;
+        if (!SetFilePointerEx(args.FileHandle, new_ptr, NULL, FILE_BEGIN))
+        {   // the seek operation failed - fail the write operation.
+            result.FileHandle = args.FileHandle;
+            result.ResultCode = GetLastError();
+            result.CompletedSynchronously = true;
+            result.WasSuccessful = false;
+            return;
+        }
+    }
+    if (WriteFile(args.FileHandle, args.DataBuffer, args.TransferAmount, &transferred, args.Overlapped))
+    {   // the write operation completed synchronously.
+        result.FileHandle = args.FileHandle;
+        result.ResultCode = GetLastError();
+        result.TransferAmount = transferred;
+        result.CompletedSynchronously = true;
+        result.WasSuccessful = true;
+    }
+    else
+    {   // the operation could have failed, or it could be completing asynchronously.
+        // it could also be the case that end-of-file was reached.
+        switch ((result.ResultCode = GetLastError()))
+        {
+            case ERROR_IO_PENDING:
+                { // the request will complete asynchronously.
+                  result.FileHandle = args.FileHandle;
+                  result.TransferAmount = 0;
+                  result.CompletedSynchronously = false;
+                  result.WasSuccessful = true;
+                } break;
+            default:
+                { // an actual error occurred.
+                  result.FileHandle = args.FileHandle;
+                  result.TransferAmount = transferred;
+                  result.CompletedSynchronously = true;
+                  result.WasSuccessful = false;
+                } break;
+        }
+    }
+}
+
+/// @summary Execute a synchronous flush operation.
+/// @param args Information about the flush operation. The FileHandle field must be set.
+/// @param result Information returned from the operation specifying whether the operation completed successfully.
+internal_function void
+OsIoExecuteFlush
+(
+    OS_IO_OPERATION          &args, 
+    OS_IO_OPERATION_RESULT &result
+)
+{
+    if (FlushFileBuffers(args.FileHandle))
+    {
+        result.FileHandle = args.FileHandle;
+        result.ResultCode = GetLastError();
+        result.TransferAmount = 0;
+        result.CompletedSynchronously = true;
+        result.WasSuccessful = true;
+    }
+    else
+    {
+        result.FileHandle = args.FileHandle;
+        result.ResultCode = GetLastError();
+        result.TransferAmount = 0;
+        result.CompletedSynchronously = true;
+        result.WasSuccessful = false;
+    }
+}
+
+/// @summary Execute a synchronous file close operation.
+/// @param args Information about the close operation. The FileHandle field must be set.
+/// @param result Information returned from the operation specifying whether the operation completed successfully.
+internal_function void
+OsIoExecuteClose
+(
+    OS_IO_OPERATION          &args, 
+    OS_IO_OPERATION_RESULT &result
+)
+{
+    if (CloseHandle(args.FileHandle))
+    {
+        result.FileHandle = args.FileHandle;
+        result.ResultCode = GetLastError();
+        result.TransferAmount = 0;
+        result.CompletedSynchronously = true;
+        result.WasSuccessful = true;
+    }
+    else
+    {
+        result.FileHandle = args.FileHandle;
+        result.ResultCode = GetLastError();
+        result.TransferAmount = 0;
+        result.CompletedSynchronously = true;
+        result.WasSuccessful = false;
+    }
+}
+
+/// @summary Prepare an OS_IO_RESULT to pass to the I/O completion callback after executing an I/O operation.
+/// @param result The OS_IO_RESULT structure to populate.
+/// @param request The OS_IO_REQUEST describing the I/O operation.
+/// @param opres The OS_IO_OPERATION_RESULT describing the completion of the I/O operation.
+internal_function void
+OsIoPrepareResult
+(
+    OS_IO_RESULT          &result,
+    OS_IO_REQUEST        *request, 
+    OS_IO_OPERATION_RESULT &opres
+)
+{   // NOTE: this routine intentionally prepares the result to pass through as much
+    // data as possible, even if that data might not have been needed for the request.
+    result.RequestType = request->RequestType;
+    result.ResultCode  = opres.ResultCode;
+    result.UserContext = request->UserContext;
+    result.FileHandle  = opres.FileHandle;
+    result.PathBuffer  = request->PathBuffer;
+    result.DataBuffer  = request->DataBuffer;
+    result.DataAmount  = opres.TransferAmount;
+    result.BaseOffset  = request->BaseOffset;
+    result.FileOffset  = request->FileOffset;
+}
+
+/// @summary Execute an I/O request. The request may complete synchronously or asynchronously.
+/// @param request The I/O request to execute.
+/// @param completion_port The I/O completion port to associate with the request.
+/// @param opres The structure to populate with the result of the I/O operation.
+/// @param result The structure to populate with the result of the I/O request.
+internal_function void
+OsIoExecuteRequest
+(
+    OS_IO_REQUEST         *request, 
+    HANDLE         completion_port,
+    OS_IO_OPERATION_RESULT  &opres, 
+    OS_IO_RESULT           &result
+)
+{
+    switch (request->RequestType)
+    {
+        case OS_IO_REQUEST_NOOP:
+            { // there's no actual I/O operation to perform.
+              opres.FileHandle             = request->FileHandle;
+              opres.ResultCode             = ERROR_SUCCESS;
+              opres.TransferAmount         = 0;
+              opres.CompletedSynchronously = true;
+              opres.WasSuccessful          = true;
+              OsIoPrepareResult(result, request, opres);
+            } break;
+        case OS_IO_REQUEST_OPEN_FILE:
+            { // populate the operation request for the file open operation.
+              // open operations return more data than most requests, and are always performed synchronously.
+              FILE_STANDARD_INFO  fsi = {};
+              OS_IO_OPERATION   opreq = {};
+              size_t      sector_size = 0;
+              opreq.FilePath          = request->PathBuffer;
+              opreq.FileHandle        = INVALID_HANDLE_VALUE;
+              opreq.CompletionPort    = completion_port;
+              opreq.Overlapped        = NULL;
+              opreq.DataBuffer        = NULL;
+              opreq.FileOffset        = 0;
+              opreq.PreallocationSize = request->DataAmount;
+              opreq.TransferAmount    = 0;
+              opreq.IoHintFlags       = request->IoHintFlags;
+              OsIoExecuteOpen(opreq, opres, &fsi, &sector_size);
+              OsIoPrepareResult(result, request, opres);
+              result.FileSize = fsi.EndOfFile.QuadPart;
+              result.PhysicalSectorSize = sector_size;
+            } break;
+        case OS_IO_REQUEST_READ_FILE:
+            { // read requests may complete asynchronously.
+              OS_IO_OPERATION   opreq = {};
+              opreq.FilePath          = NULL;
+              opreq.FileHandle        = request->FileHandle;
+              opreq.CompletionPort    = NULL;
+              opreq.Overlapped        =&request->Overlapped;
+              opreq.DataBuffer        = request->DataBuffer;
+              opreq.FileOffset        = request->BaseOffset + request->FileOffset;
+              opreq.PreallocationSize = 0;
+              opreq.TransferAmount    =(uint32_t) request->DataAmount;
+              opreq.IoHintFlags       = OS_IO_HINT_FLAGS_NONE;
+              OsIoExecuteRead(opreq, opres);
+              OsIoPrepareResult(result, request, opres);
+            } break;
+        case OS_IO_REQUEST_WRITE_FILE:
+            { // write requests may complete asynchronously.
+              OS_IO_OPERATION   opreq = {};
+              opreq.FilePath          = NULL;
+              opreq.FileHandle        = request->FileHandle;
+              opreq.CompletionPort    = NULL;
+              opreq.Overlapped        =&request->Overlapped;
+              opreq.DataBuffer        = request->DataBuffer;
+              opreq.FileOffset        = request->BaseOffset + request->FileOffset;
+              opreq.PreallocationSize = 0;
+              opreq.TransferAmount    =(uint32_t) request->DataAmount;
+              opreq.IoHintFlags       = OS_IO_HINT_FLAGS_NONE;
+              OsIoExecuteWrite(opreq, opres);
+              OsIoPrepareResult(result, request, opres);
+            } break;
+        case OS_IO_REQUEST_FLUSH_FILE:
+            { // populate the operation request for the flush operation.
+              // flush operations are always performed synchronously.
+              OS_IO_OPERATION   opreq = {};
+              opreq.FilePath          = NULL;
+              opreq.FileHandle        = request->FileHandle;
+              opreq.CompletionPort    = NULL;
+              opreq.Overlapped        = NULL;
+              opreq.DataBuffer        = NULL;
+              opreq.FileOffset        = 0;
+              opreq.PreallocationSize = 0;
+              opreq.TransferAmount    = 0;
+              opreq.IoHintFlags       = OS_IO_HINT_FLAGS_NONE;
+              OsIoExecuteFlush(opreq, opres);
+              OsIoPrepareResult(result, request, opres);
+            } break;
+        case OS_IO_REQUEST_CLOSE_FILE:
+            { // populate the operation request for the close operation.
+              // close operations are always performed synchronously.
+              OS_IO_OPERATION   opreq = {};
+              opreq.FilePath          = NULL;
+              opreq.FileHandle        = request->FileHandle;
+              opreq.CompletionPort    = NULL;
+              opreq.Overlapped        = NULL;
+              opreq.DataBuffer        = NULL;
+              opreq.FileOffset        = 0;
+              opreq.PreallocationSize = 0;
+              opreq.TransferAmount    = 0;
+              opreq.IoHintFlags       = OS_IO_HINT_FLAGS_NONE;
+              OsIoExecuteClose(opreq, opres);
+              OsIoPrepareResult(result, request, opres);
+            } break;
+        default:
+            { // don't know what this is - just pass through data.
+              opres.FileHandle             = request->FileHandle;
+              opres.ResultCode             = ERROR_SUCCESS;
+              opres.TransferAmount         = 0;
+              opres.CompletedSynchronously = true;
+              opres.WasSuccessful          = true;
+              OsIoPrepareResult(result, request, opres);
+            } break;
+    }
+}
+
+/// @summary Return an I/O request to the pool it was allocated from.
+/// @param request The I/O request to return.
+internal_function void
+OsReturnIoRequest
+(
+    OS_IO_REQUEST *request
+)
+{
+    EnterCriticalSection(&request->RequestPool->ListLock);
+    {   // remove the node from the live list.
+        if (request->NextRequest != NULL)
+            request->NextRequest->PrevRequest = request->PrevRequest;
+        if (request->PrevRequest != NULL)
+            request->PrevRequest->NextRequest = request->NextRequest;
+        // push the node into the front of the free list.
+        request->NextRequest = request->RequestPool->FreeRequest;
+        request->PrevRequest = NULL;
+        request->RequestPool->FreeRequest = request;
+    }
+    LeaveCriticalSection(&request->RequestPool->ListLock);
+}
+
+/// @summary Retrieve the OS_IO_REQUEST for an OVERLAPPED address passed back from GetQueuedCompletionStatus.
+/// @param overlapped The OVERLAPPED instance corresponding to a completed request.
+/// @return The associated OS_IO_REQUEST.
+internal_function inline OS_IO_REQUEST*
+OsIoRequestForOVERLAPPED
+(
+    OVERLAPPED *overlapped
+)
+{
+    return ((OS_IO_REQUEST*)(((uint8_t*) overlapped) - offsetof(OS_IO_REQUEST, Overlapped)));
+}
+
+/// @summary Implement the entry point of an I/O worker thread.
+/// @param argp An OS_IO_THREAD_INIT instance specifying data that should be copied to thread-local memory.
+/// @return The function always returns 1.
+internal_function unsigned int __cdecl
+OsIoThreadMain
+(
+    void *argp
+)
+{
+    OS_IO_THREAD_INIT   init = {};
+    OS_IO_THREAD_POOL  *pool = NULL;
+    OVERLAPPED           *ov = NULL;
+    uintptr_t thread_context = 0;
+    uintptr_t        context = 0;
+    uintptr_t            key = 0;
+    HANDLE       term_signal = NULL;
+    HANDLE              iocp = NULL;
+    LARGE_INTEGER  frequency = {};
+    DWORD                tid = GetCurrentThreadId();
+    DWORD             nbytes = 0;
+    DWORD             termrc = 0;
+    unsigned int   exit_code = 1;
+
+    // copy the initialization data into local stack memory.
+    // argp may have been allocated on the stack of the caller 
+    // and is only guaranteed to remain valid until ReadySignal is set.
+    CopyMemory(&init, argp, sizeof(OS_IO_THREAD_INIT));
+    term_signal = init.TerminateSignal;
+    context     = init.PoolContext;
+    iocp        = init.CompletionPort;
+    pool        = init.ThreadPool;
+
+    // retrieve the system clock frequency for converting ticks to nanoseconds.
+    QueryPerformanceFrequency(&frequency);
+
+    // spit out a message just prior to initialization:
+    OsLayerOutput("START: %S(%u): I/O thread starting on pool 0x%p.\n", __FUNCTION__, tid, pool);
+
+    // perform application-level per-thread initialization.
+    if (init.ThreadInit(pool, context, tid, &thread_context) < 0)
+    {
+        OsLayerError("ERROR: %S(%u): I/O thread initialization failed on pool 0x%p.\n", __FUNCTION__, tid, pool);
+        OsLayerError("DEATH: %S(%u): I/O thread terminating in pool 0x%p.\n", __FUNCTION__, tid, pool);
+        SetEvent(init.ErrorSignal);
+        return 0;
+    }
+
+    // signal the main thread that this thread is ready to run.
+    SetEvent(init.ReadySignal);
+
+    __try
+    {   // enter the main I/O loop. the thread waits for an event to be available on the completion port.
+        for ( ; ; )
+        {   // prior to possibly entering a wait state, check the termination signal.
+            if ((termrc = WaitForSingleObject(term_signal, 0)) != WAIT_TIMEOUT)
+            {   // either termination was signaled, or an error occurred.
+                // either way, exit prior to entering the wait state.
+                if (termrc != WAIT_OBJECT_0)
+                {   // an error occurred while checking the termination signal.
+                    OsLayerError("ERROR: %S(%u): Checking termination signal failed with result 0x%08X (0x%08X).\n", __FUNCTION__, tid, termrc, GetLastError());
+                }
+                break;
+            }
+            // wait for an event on the completion port.
+            if (GetQueuedCompletionStatus(iocp, &nbytes, &key, &ov, INFINITE))
+            {   // check the termination signal prior to processing the request.
+                if ((termrc = WaitForSingleObject(term_signal, 0)) != WAIT_TIMEOUT)
+                {   // either termination was signaled, or an error occurred.
+                    if (termrc != WAIT_OBJECT_0)
+                    {   // an error occurred while checking the termination signal.
+                        OsLayerError("ERROR: %S(%u): Checking termination signal failed with result 0x%08X (0x%08X).\n", __FUNCTION__, tid, termrc, GetLastError());
+                    }
+                    break;
+                }
+                if (key == OS_COMPLETION_KEY_SHUTDOWN)
+                {
+                    OsLayerOutput("EVENT: %S(%u): I/O worker received shutdown signal.\n", __FUNCTION__, tid);
+                    break;
+                }
+
+                OS_IO_REQUEST *request = OsIoRequestForOVERLAPPED(ov);
+                while (request != NULL)
+                {
+                    switch (request->RequestState)
+                    {
+                        case OS_IO_REQUEST_STATE_CHAINED:
+                        case OS_IO_REQUEST_STATE_SUBMITTED:
+                            { // launch the I/O operation. it may complete asynchronously.
+                              OS_IO_RESULT result;
+                              OS_IO_OPERATION_RESULT opres;
+                              OS_IO_REQUEST *chained = NULL;
+                              request->RequestState  = OS_IO_REQUEST_STATE_LAUNCHED;
+                              request->IoLaunchTime  = OsTimestampInTicks();
+                              OsIoExecuteRequest(request, iocp, opres, result);
+                              if (opres.CompletedSynchronously)
+                              {   // update the request state and execute the completion callback.
+                                  // there should be no additional events reported for this request.
+                                  request->RequestState = OS_IO_REQUEST_STATE_COMPLETED;
+                                  request->IoFinishTime = OsTimestampInTicks();
+                                  if (request->IoComplete != NULL)
+                                  {   // the request may return a chained request from its completion callback.
+                                      OS_IO_REQUEST_CONTEXT ctx;
+                                      OS_IO_PROFILE     profile;
+                                      ctx.RequestPool          = request->RequestPool;
+                                      ctx.ThreadPool           = pool;
+                                      ctx.PoolContext          = context;
+                                      ctx.ThreadContext        = thread_context;
+                                      profile.QueueDelay       = OsElapsedNanoseconds(request->IoSubmitTime, request->IoLaunchTime, frequency.QuadPart);
+                                      profile.ExecutionTime    = OsElapsedNanoseconds(request->IoLaunchTime, request->IoFinishTime, frequency.QuadPart);
+                                      profile.OsThreadId       = tid;
+                                      chained = request->IoComplete(opres.WasSuccessful, &result, &ctx, &profile);
+                                  }
+                                  OsReturnIoRequest(request);
+                                  request = chained;
+                              }
+                              else
+                              {   // since the request hasn't completed, there is no chained request.
+                                  // don't return the request until it completes.
+                                  request = NULL;
+                              }
+                            } break;
+                        case OS_IO_REQUEST_STATE_LAUNCHED:
+                            { // the asynchronous read or write operation has completed.
+                              OS_IO_RESULT    result;
+                              OS_IO_REQUEST *chained = NULL;
+                              DWORD      result_code = ERROR_SUCCESS;
+                              bool    was_successful = true;
+                              if (!GetOverlappedResult(request->FileHandle, ov, &nbytes, FALSE))
+                              {   // the I/O request may have completed unsuccessfully.
+                                  if ((result_code   = GetLastError()) != ERROR_HANDLE_EOF)
+                                      was_successful = false;
+                              }
+                              request->RequestState  = OS_IO_REQUEST_STATE_COMPLETED;
+                              request->IoFinishTime  = OsTimestampInTicks();
+                              result.RequestType     = request->RequestType;
+                              result.ResultCode      = result_code;
+                              result.UserContext     = request->UserContext;
+                              result.FileHandle      = request->FileHandle;
+                              result.PathBuffer      = request->PathBuffer;
+                              result.DataBuffer      = request->DataBuffer;
+                              result.DataAmount      = nbytes;
+                              result.BaseOffset      = request->BaseOffset;
+                              result.FileOffset      = request->FileOffset;
+                              if (request->IoComplete != NULL)
+                              {   // the request may return a chained request from its completion callback.
+                                  OS_IO_REQUEST_CONTEXT ctx;
+                                  OS_IO_PROFILE     profile;
+                                  ctx.RequestPool          = request->RequestPool;
+                                  ctx.ThreadPool           = pool;
+                                  ctx.PoolContext          = context;
+                                  ctx.ThreadContext        = thread_context;
+                                  profile.QueueDelay       = OsElapsedNanoseconds(request->IoSubmitTime, request->IoLaunchTime, frequency.QuadPart);
+                                  profile.ExecutionTime    = OsElapsedNanoseconds(request->IoLaunchTime, request->IoFinishTime, frequency.QuadPart);
+                                  profile.OsThreadId       = tid;
+                                  chained = request->IoComplete(was_successful, &result, &ctx, &profile);
+                              }
+                              OsReturnIoRequest(request);
+                              request = chained;
+                            } break;
+                        case OS_IO_REQUEST_STATE_COMPLETED:
+                            { OsLayerError("ERROR: %S(%u): I/O thread received already completed request %p from pool %p.\n", __FUNCTION__, GetCurrentThreadId(), request, request->RequestPool);
+                              OsReturnIoRequest(request);
+                            } break;
+                        default:
+                            { OsLayerError("ERROR: %S(%u): I/O thread received request %p from pool %p with unknown state %d.\n", __FUNCTION__, GetCurrentThreadId(), request, request->RequestPool, request->RequestState);
+                            } break;
+                    }
+                }
+            }
+        }
+    }
+    __finally
+    {   // the I/O thread is terminating - clean up thread-local resources.
+        // ...
+        // spit out a message just prior to termination.
+        OsLayerError("DEATH: %S(%u): I/O thread terminating in pool 0x%p.\n", __FUNCTION__, tid, init.ThreadPool);
+        return exit_code;
+    }
+}
+
+/// @summary Search a list of layers for a given layer name to determine if a layer is supported.
+/// @param layer_name A zero-terminated ASCII string specifying the registered name of the layer to locate.
+/// @param layer_list The list of layer properties to search.
+/// @param layer_count The number of layer properties to search.
+/// @param layer_index If non-NULL, and the named layer is supported, this location is updated with the zero-based index of the layer in the list.
+/// @return The layer name string (of the associated VkLayerProperties), if supported; otherwise, NULL.
+internal_function char const*
+OsSupportsVulkanLayer
+(
+    char              const *layer_name,
+    VkLayerProperties const *layer_list, 
+    size_t                   layer_count, 
+    size_t                  *layer_index=NULL
+)
+{
+    char const *s = NULL;
+    for (size_t i = 0; i < layer_count; ++i)
+    {
+        if ((s = OsStringSearch(layer_list[i].layerName, layer_name)) != NULL)
+        {
+            if (layer_index != NULL) *layer_index = i;
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/// @summary Search a list of extensions for a given extension name to determine if an extension is supported.
+/// @param extension_name A zero-terminated ASCII string specifying the registered name of the extension to locate.
+/// @param extension_list The list of extension properties to search.
+/// @param extension_count The number of extension properties to search.
+/// @param extension_index If non-NULL, and the named extension is supported, this location is updated with the zero-based index of the extension in the list.
+/// @return The extension name string (of the associated VkExtensionProperties), if supported; otherwise, NULL.
+internal_function char const*
+OsSupportsVulkanExtension
+(
+    char                  const *extension_name,
+    VkExtensionProperties const *extension_list, 
+    size_t                       extension_count, 
+    size_t                      *extension_index=NULL
+)
+{
+    char const *s = NULL;
+    for (size_t i = 0; i < extension_count; ++i)
+    {
+        if ((s = OsStringSearch(extension_list[i].extensionName, extension_name)) != NULL)
+        {
+            if (extension_index != NULL) *extension_index = i;
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/// @summary Search a list of extension names for a specific extension name string.
+/// @param extension_name A zero-terminated ASCII string specifying the registered name of the extension to locate.
+/// @param extension_list The list of zero-terminated ASCII extension name strings to search.
+/// @param extension_count The number of zero-terminated ASCII strings in the extension_list.
+/// @return true if the named extension was found in the specified extension list.
+internal_function bool
+OsSupportsNamedExtension
+(
+    char   const         *extension_name, 
+    char   const * const *extension_list, 
+    size_t const          extension_count
+)
+{
+    for (size_t i = 0; i < extension_count; ++i)
+    {
+        if (OsStringSearch(extension_list[i], extension_name) != NULL)
+            return true;
+    }
+    return false;
+}
+
+/// @summary Determine whether the application has enabled an instance-level extension.
+/// @param extension_name A zero-terminated ASCII string specifying the registered name of the extension to locate.
+/// @param create_info The application-provided VkInstanceCreateInfo being supplied to vkCreateInstance.
+/// @return true if the application has enabled the specified extension.
+internal_function inline bool
+OsVulkanInstanceExtensionEnabled
+(
+    char                 const *extension_name, 
+    VkInstanceCreateInfo const    *create_info
+)
+{
+    return OsSupportsNamedExtension(extension_name, create_info->ppEnabledExtensionNames, create_info->enabledExtensionCount);
+}
+
+/// @summary Determine whether the application has enabled a device-level extension.
+/// @param extension_name A zero-terminated ASCII string specifying the registered name of the extension to locate.
+/// @param create_info The application-provided VkDeviceCreateInfo being supplied to vkCreateDevice.
+/// @return true if the application has enabled the specified extension.
+internal_function inline bool
+OsVulkanDeviceExtensionEnabled
+(
+    char               const *extension_name, 
+    VkDeviceCreateInfo const *create_info
+)
+{
+    return OsSupportsNamedExtension(extension_name, create_info->ppEnabledExtensionNames, create_info->enabledExtensionCount);
+}
+
+/// @summary Resolve functions exported directly from a Vulkan ICD.
+/// @param runtime The OS_VULKAN_RUNTIME_DISPATCH instance, with the LoaderHandle field set.
+/// @return VK_SUCCESS if all exported functions were resolved successfully.
+internal_function VkResult
+OsResolveVulkanExportFunctions
+(
+    OS_VULKAN_RUNTIME_DISPATCH *runtime
+)
+{
+    OS_LAYER_RESOLVE_VULKAN_ICD_FUNCTION(runtime, vkGetInstanceProcAddr);
+    return VK_SUCCESS;
+}
+
+/// @summary Resolve global functions exported by a Vulkan ICD.
+/// @param runtime The OS_VULKAN_RUNTIME_DISPATCH instance, with the LoaderHandle field set.
+/// @return VK_SUCCESS if all global functions were resolved successfully.
+internal_function VkResult
+OsResolveVulkanGlobalFunctions
+(
+    OS_VULKAN_RUNTIME_DISPATCH *runtime
+)
+{
+    OS_LAYER_RESOLVE_VULKAN_GLOBAL_FUNCTION(runtime, vkCreateInstance);
+    OS_LAYER_RESOLVE_VULKAN_GLOBAL_FUNCTION(runtime, vkEnumerateInstanceLayerProperties);
+    OS_LAYER_RESOLVE_VULKAN_GLOBAL_FUNCTION(runtime, vkEnumerateInstanceExtensionProperties);
+    return VK_SUCCESS;
+}
+
+/// @summary Resolve instance-level functions exported by a Vulkan runtime.
+/// @param runtime The OS_VULKAN_RUNTIME_DISPATCH object, with the vkGetInstanceProcAddr entry point set.
+/// @param instance The OS_VULKAN_INSTANCE_DISPATCH object, with the InstanceHandle field set.
+/// @param create_info The VkInstanceCreateInfo being used to initialize the instance. Used here to resolve instance-level function pointers for extensions.
+/// @return VK_SUCCESS if all instance-level functions were resolved successfully.
+internal_function VkResult
+OsResolveVulkanInstanceFunctions
+(
+    OS_VULKAN_RUNTIME_DISPATCH      *runtime,
+    OS_VULKAN_INSTANCE_DISPATCH    *instance,
+    VkInstanceCreateInfo  const *create_info 
+)
+{
+    OS_LAYER_COPY_VULKAN_FUNCTION(instance, runtime, vkGetInstanceProcAddr);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkCreateDevice);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkDestroyInstance);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkEnumeratePhysicalDevices);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkEnumerateDeviceExtensionProperties);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetDeviceProcAddr);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceFeatures);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceFormatProperties);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceImageFormatProperties);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceMemoryProperties);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceProperties);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceQueueFamilyProperties);
+    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSparseImageFormatProperties);
+    if (OsVulkanInstanceExtensionEnabled(VK_KHR_SURFACE_EXTENSION_NAME, create_info))
+    {   // resolve entry points for VK_KHR_surface.
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkDestroySurfaceKHR);
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSurfaceSupportKHR);
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSurfaceFormatsKHR);
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSurfacePresentModesKHR);
+    }
+    if (OsVulkanInstanceExtensionEnabled(VK_KHR_WIN32_SURFACE_EXTENSION_NAME, create_info))
+    {   // resolve entry points for VK_KHR_win32_surface.
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkCreateWin32SurfaceKHR);
+    }
+    if (OsVulkanInstanceExtensionEnabled(VK_EXT_DEBUG_REPORT_EXTENSION_NAME, create_info))
+    {   // resolve entry points for VK_EXT_debug_report.
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkCreateDebugReportCallbackEXT);
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkDebugReportMessageEXT);
+        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkDestroyDebugReportCallbackEXT);
+    }
+    return VK_SUCCESS;
+}
+
+/// @summary Resolve device-level functions exported by the Vulkan ICD.
+/// @param vkinstance The OS_VULKAN_INSTANCE_DISPATCH object, with the vkGetDeviceProcAddr entry point set.
+/// @param vkdevice The OS_VULKAN_DEVICE_DISPATCH object, with the LogicalDevice field set.
+/// @param create_info The VkDeviceCreateInfo being used to initialize the logical device. Used here to resolve device-level function pointers for extensions.
+/// @return VkResult if all device-level functions were resolved successfully.
+internal_function VkResult
+OsResolveVulkanDeviceFunctions
+(
+    OS_VULKAN_INSTANCE_DISPATCH *instance,
+    OS_VULKAN_DEVICE_DISPATCH     *device, 
+    VkDeviceCreateInfo const *create_info
+)
+{
+    OS_LAYER_COPY_VULKAN_FUNCTION(device, instance, vkGetDeviceProcAddr);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkAllocateCommandBuffers);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkAllocateMemory);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkBeginCommandBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkBindBufferMemory);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkBindImageMemory);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBeginQuery);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBeginRenderPass);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBindDescriptorSets);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBindIndexBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBindPipeline);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBindVertexBuffers);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBlitImage);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdClearAttachments);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdClearColorImage);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdClearDepthStencilImage);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyBufferToImage);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyImage);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyImageToBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyQueryPoolResults);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDispatch);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDispatchIndirect);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDraw);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDrawIndexed);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDrawIndexedIndirect);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDrawIndirect);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdEndQuery);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdEndRenderPass);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdExecuteCommands);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdFillBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdNextSubpass);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdPipelineBarrier);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdPushConstants);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdResetEvent);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdResetQueryPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdResolveImage);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetBlendConstants);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetDepthBias);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetDepthBounds);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetEvent);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetLineWidth);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetScissor);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetStencilCompareMask);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetStencilReference);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetStencilWriteMask);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetViewport);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdUpdateBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdWaitEvents);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdWriteTimestamp);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateBufferView);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateCommandPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateComputePipelines);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateDescriptorPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateDescriptorSetLayout);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateEvent);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateFence);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateFramebuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateGraphicsPipelines);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateImage);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateImageView);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreatePipelineCache);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreatePipelineLayout);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateQueryPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateRenderPass);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateSampler);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateSemaphore);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateShaderModule);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyBufferView);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyCommandPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyDescriptorPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyDescriptorSetLayout);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyDevice);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyEvent);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyFence);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyFramebuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyImage);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyImageView);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyPipeline);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyPipelineCache);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyPipelineLayout);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyQueryPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyRenderPass);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroySampler);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroySemaphore);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyShaderModule);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDeviceWaitIdle);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkEndCommandBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkFlushMappedMemoryRanges);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkFreeCommandBuffers);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkFreeDescriptorSets);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkFreeMemory);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetBufferMemoryRequirements);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetDeviceMemoryCommitment);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetDeviceQueue);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetEventStatus);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetFenceStatus);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetImageMemoryRequirements);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetImageSparseMemoryRequirements);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetImageSubresourceLayout);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetPipelineCacheData);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetQueryPoolResults);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetRenderAreaGranularity);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkInvalidateMappedMemoryRanges);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkMapMemory);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkMergePipelineCaches);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkQueueBindSparse);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkQueueSubmit);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkQueueWaitIdle);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetCommandBuffer);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetCommandPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetDescriptorPool);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetEvent);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetFences);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkSetEvent);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkUnmapMemory);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkUpdateDescriptorSets);
+    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkWaitForFences);
+    if (OsVulkanDeviceExtensionEnabled(VK_KHR_SWAPCHAIN_EXTENSION_NAME, create_info))
+    {   // resolve entry points for VK_KHR_swapchain.
+        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkAcquireNextImageKHR);
+        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateSharedSwapchainsKHR);
+        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateSwapchainKHR);
+        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroySwapchainKHR);
+        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetSwapchainImagesKHR);
+        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkQueuePresentKHR);
+    }
+    return VK_SUCCESS;
+}
+#endif /* !defined(__linux__) */
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @param Zero-fill a memory block.
+/// @param dst The address of the block to zero-fill.
+/// @param len The number of bytes to set to zero.
+public_function void
+OsZeroMemory
+(
+    void  *dst, 
+    size_t len
+)
+{
+    OS_MEMORY_ROUTINES *routines = OsMemoryRoutines();
+    routines->FillMemory(dst, len, 0, routines->StreamingThreshold);
+}
+
+/// @summary Zero-fill a memory block in a way that is guaranteed not to be optimized out by the compiler.
+/// @param dst The address of the block to zero-fill.
+/// @param len The number of bytes to set to zero.
+public_function void
+OsSecureZeroMemory
+(
+    void  *dst,
+    size_t len
+)
+{
+#if defined(__linux__)
+    explicit_bzero(dst, len);
+#else
+    (void) SecureZeroMemory(dst, len);
+#endif
+}
+
+/// @summary Copy memory from one block to another, where it is known that the source and destination address ranges do not overlap.
+/// @param dst The address of the destination block.
+/// @param src The address of the source block.
+/// @param len The number of bytes to copy.
+public_function void
+OsCopyMemory
+(
+    void       * __restrict dst,
+    void const * __restrict src, 
+    size_t                  len
+)
+{
+    OS_MEMORY_ROUTINES *routines = OsMemoryRoutines();
+    routines->CopyMemory(dst, src, len, routines->StreamingThreshold);
+}
+
+/// @summary Copy memory from one block to another, where the source and destination address ranges may overlap.
+/// @param dst The address of the destination block.
+/// @param src The address of the source block.
+/// @param len The number of bytes to copy.
+public_function void
+OsMoveMemory
+(
+    void       *dst, 
+    void const *src, 
+    size_t      len
+)
+{
+    memmove(dst, src, len);
+}
+
+/// @summary Fill a block of memory with a given value.
+/// @param dst The address of the start of the block to fill.
+/// @param len The number of bytes to write.
+/// @param val The value to write to each byte in the destination block.
+public_function void
+OsFillMemory
+(
+    void   *dst, 
+    size_t  len, 
+    uint8_t val
+)
+{
+    OS_MEMORY_ROUTINES *routines = OsMemoryRoutines();
+    routines->FillMemory(dst, len, val, routines->StreamingThreshold);
+}
+
+/// @summary Lexicographically compare two blocks of memory, with the same semantics as memcmp.
+/// @param a The address of the first block.
+/// @param b The address of the second block.
+/// @param len The number of bytes to compare.
+/// @return Zero if the blocks are equal, a negative value if the first mismatched byte in a is less than the corresponding byte in b, or a positive value otherwise.
+public_function int
+OsCompareMemory
+(
+    void const *a, 
+    void const *b, 
+    size_t    len
+)
+{
+    return OsMemoryRoutines()->CompareMemory(a, b, len);
+}
+
+/// @summary Override the kernels used by OsCopyMemory, OsZeroMemory, OsFillMemory and OsCompareMemory. By default, the most capable 
+/// kernels supported by the host are selected on first use. This function is intended for benchmarking and must not be called while 
+/// other threads may be using the bulk memory functions.
+/// @param instruction_set One of OS_MEMORY_ISA specifying the kernels to use. The value is clamped to the instruction sets supported by the host.
+/// @param streaming_threshold The minimum transfer size, in bytes, that bypasses the cache using non-temporal stores. Specify 0 to derive 
+/// the threshold from the size of the last-level cache, or SIZE_MAX to disable non-temporal stores.
+/// @return The OS_MEMORY_ISA value identifying the kernels that were selected.
+public_function int32_t
+OsSelectMemoryRoutines
+(
+    int32_t     instruction_set, 
+    size_t  streaming_threshold
+)
+{
+    OS_MEMORY_ROUTINES *routines = OsMemoryRoutines();
+   *routines = OsResolveMemoryRoutines(instruction_set, streaming_threshold);
+    return routines->InstructionSet;
+}
+
+/// @summary Retrieve the kernels and configuration used by the bulk memory functions.
+/// @param routines On return, a copy of the active kernel set.
+public_function void
+OsQueryMemoryRoutines
+(
+    OS_MEMORY_ROUTINES *routines
+)
+{
+   *routines = *OsMemoryRoutines();
+}
+
+/// @summary Rounds a size up to the nearest even multiple of a given power-of-two.
+/// @param size The size value to round up.
+/// @param pow2 The power-of-two alignment.
+/// @return The input size, rounded up to the nearest even multiple of pow2.
+public_function size_t 
+OsAlignUp
+(
+    size_t size, 
+    size_t pow2
+)
+{
+    return (size == 0) ? pow2 : ((size + (pow2-1)) & ~(pow2-1));
+}
+
+/// @summary Retrieve the alignment required for a given type.
+/// @typeparam T The type for which the required alignment is being queried.
+/// @return The required alignment for the specified type, in bytes. This value is always a power of two.
+template <typename T>
+public_function inline size_t
+OsAlignmentOfType
+(
+    void
+)
+{
+    return std::alignment_of<T>::value;
+}
+
+/// @summary For a given address, return the address aligned for the specified type. The type T must be aligned to a power-of-two.
+/// @param addr The unaligned address.
+/// @return The address aligned to access elements of type T, or NULL if addr is NULL.
+template <typename T>
+public_function void* 
+OsAlignFor
+(
+    void *addr
+)
+{
+    const size_t a = std::alignment_of<T>::value;
+    const size_t m = std::alignment_of<T>::value - 1;
+    uint8_t     *p =(uint8_t*)addr;
+    return  (addr != NULL) ? (void*) ((uintptr_t(p) + m) & ~m) : NULL;
+}
+
+/// @summary Calculate the worst-case requirement for allocating an instance of a structure, including padding.
+/// @typeparam T The type being allocated. This type is used to determine the required alignment.
+/// @return The number of bytes required to allocate an instance, including worst-case padding.
+template <typename T>
+public_function size_t
+OsAllocationSizeForStruct
+(
+    void
+)
+{
+    return sizeof(T) + (std::alignment_of<T>::value - 1);
+}
+
+/// @summary Calculate the worst-case requirement for allocating an array, including padding.
+/// @typeparam T The type being allocated. This type is used to determine the required alignment.
+/// @param n The number of items of type T in the array.
+/// @return The number of bytes required to allocate an array of count items, including worst-case padding.
+template <typename T>
+public_function size_t
+OsAllocationSizeForArray
+(
+    size_t n
+)
+{
+    return (sizeof(T) * n) + (std::alignment_of<T>::value - 1);
+}
+
+/// @summary Initialize an OS_MEMORY_RANGE object for a committed block of memory.
+/// @param addr The base address of the host-visible allocation.
+/// @param size The size of the host-visible range, in bytes.
+/// @return An OS_MEMORY_RANGE initialized with the specified memory block.
+public_function inline OS_MEMORY_RANGE
+OsInitHostMemoryRange
+(
+    void  *addr, 
+    size_t size
+)
+{   assert(addr != NULL && size > 0);
+    OS_MEMORY_RANGE r;
+    r.HostAddress =(uint8_t*) addr;
+    r.SizeInBytes = size;
+    return r;
+}
+
+/// @summary Initialized an OS_MEMORY_RANGE to wrap an entire host memory allocation.
+/// @param memory The host memory allocation to wrap.
+/// @return An OS_MEMORY_RANGE initialized with the specified memory block.
+public_function inline OS_MEMORY_RANGE
+OsInitHostMemoryRange
+(
+    OS_HOST_MEMORY_ALLOCATION *memory
+)
+{   assert(memory->BaseAddress != NULL && memory->BytesCommitted > 0);
+    OS_MEMORY_RANGE r;
+    r.HostAddress = memory->BaseAddress;
+    r.SizeInBytes = memory->BytesCommitted;
+    return r;
+}
+
+/// @summary Atomically raise a statistics counter to at least a given value.
+/// @param peak The counter to update.
+/// @param value The candidate peak value.
+internal_function inline void
+OsAtomicUpdatePeak
+(
+    std::atomic<uint64_t> &peak, 
+    uint64_t              value
+)
+{
+    uint64_t current = peak.load(std::memory_order_relaxed);
+    while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed, std::memory_order_relaxed))
+    {   // current was reloaded; retry while the new value is still larger.
+    }
+}
+
+/// @summary Push a node onto the free list of a host memory pool. Safe to call from any thread.
+/// @param pool The OS_HOST_MEMORY_POOL that owns the node.
+/// @param alloc The OS_HOST_MEMORY_ALLOCATION to push. The node must not currently be on the free list.
+internal_function void
+OsHostMemoryPoolPushNode
+(
+    OS_HOST_MEMORY_POOL        *pool, 
+    OS_HOST_MEMORY_ALLOCATION *alloc
+)
+{
+    uint32_t node = (uint32_t) (alloc - pool->NodeList) + 1;
+    uint64_t head = pool->FreeHead.load(std::memory_order_relaxed);
+    uint64_t next;
+    do
+    {   // link the node to the current head, and bump the tag so a stale pop cannot succeed.
+        pool->FreeLinks[node - 1].store((uint32_t) head, std::memory_order_relaxed);
+        next = ((head & 0xFFFFFFFF00000000ULL) + 0x100000000ULL) | node;
+    } while (!pool->FreeHead.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+}
+
+/// @summary Pop a node from the free list of a host memory pool. Safe to call from any thread.
+/// @param pool The OS_HOST_MEMORY_POOL from which the node will be taken.
+/// @return The OS_HOST_MEMORY_ALLOCATION taken from the free list, or NULL if every node is in use.
+internal_function OS_HOST_MEMORY_ALLOCATION*
+OsHostMemoryPoolPopNode
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    uint64_t head = pool->FreeHead.load(std::memory_order_acquire);
+    uint64_t next;
+    do
+    {   // the link read may be stale if another thread pops the node first, but then the tag has changed and the exchange fails.
+        uint32_t node = (uint32_t) head;
+        if (node == 0)
+            return NULL;
+        next = ((head & 0xFFFFFFFF00000000ULL) + 0x100000000ULL) | pool->FreeLinks[node - 1].load(std::memory_order_relaxed);
+    } while (!pool->FreeHead.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire));
+    return &pool->NodeList[(uint32_t) head - 1];
+}
+
+/// @summary Rebuild the free list of a host memory pool so that it contains every node, in order. Not safe to call while other threads are using the pool.
+/// @param pool The OS_HOST_MEMORY_POOL whose free list will be rebuilt.
+internal_function void
+OsHostMemoryPoolResetFreeList
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{
+    size_t capacity = pool->Capacity;
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        pool->NodeList[i].SourcePool     = pool;
+        pool->NodeList[i].NextAllocation = NULL;
+        pool->FreeLinks[i].store((i + 1) < capacity ? (uint32_t)(i + 2) : 0, std::memory_order_relaxed);
+    }
+    // the tag carries over so that the head value never repeats.
+    uint64_t tag = (pool->FreeHead.load(std::memory_order_relaxed) & 0xFFFFFFFF00000000ULL) + 0x100000000ULL;
+    pool->FreeHead.store(tag | (capacity > 0 ? 1 : 0), std::memory_order_release);
+    pool->NodesInUse.store(0, std::memory_order_relaxed);
+}
+
+/// @summary Initialize a pool of memory allocations.
+/// @param pool The OS_HOST_MEMORY_POOL to initialize.
+/// @param init The attributes of the pool.
+/// @return Zero if the pool is successfully initialized, or -1 if an error occurred.
+public_function int
+OsCreateHostMemoryPool
+(
+    OS_HOST_MEMORY_POOL      *pool, 
+    OS_HOST_MEMORY_POOL_INIT *init
+)
+{
+    size_t       page_size = 0;
+    size_t     granularity = 0;
+    size_t      total_size = 0;
+    size_t      node_bytes = 0;
+    size_t actual_capacity = 0;
+    void            *array = NULL;
+
+    // retrieve the OS page size and allocation granularity.
+    OsVmmQueryPageSize(page_size, granularity);
+
+    // node indices are stored in 32 bits within the tagged free list head.
+    if (init->PoolCapacity >= 0xFFFFFFFFU)
+    {
+        OsLayerError("ERROR: %S(%u): Pool %S capacity %Iu exceeds the maximum.\n", __FUNCTION__, OsThreadId(), init->PoolName, init->PoolCapacity);
+        return -1;
+    }
+
+    // figure out how many bytes to allocate. the node storage is followed by the free list links.
+    node_bytes = OsAlignUp(init->PoolCapacity * sizeof(OS_HOST_MEMORY_ALLOCATION), page_size);
+    actual_capacity = node_bytes / sizeof(OS_HOST_MEMORY_ALLOCATION);
+    total_size = node_bytes + OsAlignUp(actual_capacity * sizeof(OS_HOST_MEMORY_POOL::atomic_u32_t), page_size);
+
+    // allocate committed storage for all of the OS_HOST_MEMORY_ALLOCATION objects.
+    if ((array = OsVmmAllocateMetadata(total_size)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to allocate %Iu bytes for pool %S of %Iu items.\n", __FUNCTION__, OsThreadId(), total_size, init->PoolName, actual_capacity);
+        return -1;
+    }
+
+    // initialize the fields of the OS_HOST_MEMORY_POOL object.
+    pool->Name              = init->PoolName;
+    pool->FreeLinks         =(OS_HOST_MEMORY_POOL::atomic_u32_t*)((uint8_t*) array + node_bytes);
+    pool->NodeList          =(OS_HOST_MEMORY_ALLOCATION*) array;
+    pool->Capacity          = actual_capacity;
+    pool->MinAllocationSize = init->MinAllocationSize;
+    pool->MinCommitIncrease = init->MinCommitIncrease;
+    pool->PageSize          =(uint32_t) page_size;
+    pool->Granularity       =(uint32_t) granularity;
+    pool->NumaPolicy        = init->NumaPolicy;
+    pool->NumaNode          = init->NumaNode;
+    pool->FreeHead.store(0, std::memory_order_relaxed);
+    pool->AllocationCount.store(0, std::memory_order_relaxed);
+    pool->ReleaseCount.store(0, std::memory_order_relaxed);
+    pool->FailedCount.store(0, std::memory_order_relaxed);
+    pool->ExhaustedCount.store(0, std::memory_order_relaxed);
+    pool->CommitCount.store(0, std::memory_order_relaxed);
+    pool->NodesInUsePeak.store(0, std::memory_order_relaxed);
+    pool->BytesReserved.store(0, std::memory_order_relaxed);
+    pool->BytesCommitted.store(0, std::memory_order_relaxed);
+    pool->BytesCommittedPeak.store(0, std::memory_order_relaxed);
+
+    // initialize the pool free list.
+    OsHostMemoryPoolResetFreeList(pool);
+    return 0;
+}
+
+/// @summary Free all memory associated with an OS_HOST_MEMORY_POOL object. All allocations are invalidated.
+/// @param pool The OS_HOST_MEMORY_POOL to delete.
+public_function void
+OsDeleteHostMemoryPool
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{   // release all of the individual memory allocations.
+    for (size_t i = 0, n = pool->Capacity; i < n; ++i)
+    {
+        OsHostMemoryRelease(&pool->NodeList[i]);
+    }
+    // release the memory allocated for the pool itself.
+    if (pool->NodeList != NULL)
+    {
+        size_t node_bytes = OsAlignUp(pool->Capacity * sizeof(OS_HOST_MEMORY_ALLOCATION), pool->PageSize);
+        size_t link_bytes = OsAlignUp(pool->Capacity * sizeof(OS_HOST_MEMORY_POOL::atomic_u32_t), pool->PageSize);
+        OsVmmReleaseMetadata(pool->NodeList, node_bytes + link_bytes);
+    }
+    pool->FreeHead.store(0, std::memory_order_relaxed);
+    pool->FreeLinks = NULL;
+    pool->NodeList  = NULL;
+    pool->Capacity  = 0;
+}
+
+/// @summary Reserve, and optionally commit, address space within a process.
+/// @param pool The OS_HOST_MEMORY_POOL from which the OS_HOST_MEMORY_ALLOCATION will be acquired.
+/// @param reserve_size The number of bytes of process address space to reserve. This value is rounded up to the nearest even multiple of the operating system page size.
+/// @param commit_size The number of bytes of process address space to commit. This value is rounded up to the nearest even multiple of the operating system page size.
+/// @param alloc_flags One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS, or 0 if no special behavior is desired in which case the memory is readable, writable and has a guard page.
+/// @return Zero if the address space is successfully reserved, or -1 if an error occurred.
+public_function OS_HOST_MEMORY_ALLOCATION*
+OsHostMemoryPoolAllocate
+(
+    OS_HOST_MEMORY_POOL *pool, 
+    size_t       reserve_size, 
+    size_t        commit_size, 
+    uint32_t      alloc_flags
+)
+{
+    return OsHostMemoryPoolAllocate(pool, reserve_size, commit_size, alloc_flags, pool->NumaPolicy, pool->NumaNode);
+}
+
+/// @summary Reserve, and optionally commit, address space within a process, overriding the NUMA placement policy of the pool.
+/// @param pool The OS_HOST_MEMORY_POOL from which the OS_HOST_MEMORY_ALLOCATION will be acquired.
+/// @param reserve_size The number of bytes of process address space to reserve. This value is rounded up to the nearest even multiple of the operating system page size.
+/// @param commit_size The number of bytes of process address space to commit. This value is rounded up to the nearest even multiple of the operating system page size.
+/// @param alloc_flags One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS, or 0 if no special behavior is desired in which case the memory is readable, writable and has a guard page.
+/// @param numa_policy One of OS_HOST_MEMORY_NUMA_POLICY specifying how the physical memory backing the allocation is placed.
+/// @param numa_node The zero-based index of the NUMA node, used with OS_HOST_MEMORY_NUMA_POLICY_BIND.
+/// @return Zero if the address space is successfully reserved, or -1 if an error occurred.
+public_function OS_HOST_MEMORY_ALLOCATION*
+OsHostMemoryPoolAllocate
+(
+    OS_HOST_MEMORY_POOL *pool, 
+    size_t       reserve_size, 
+    size_t        commit_size, 
+    uint32_t      alloc_flags, 
+    uint32_t      numa_policy, 
+    uint32_t        numa_node
+)
+{
+    OS_HOST_MEMORY_ALLOCATION *alloc = NULL;
+
+    if ((alloc = OsHostMemoryPoolPopNode(pool)) != NULL)
+    {   // the node is owned by this thread; attempt to initialize it with the requested attributes.
+        if (OsHostMemoryReserveAndCommit(alloc, reserve_size, commit_size, alloc_flags, numa_policy, numa_node) < 0)
+        {   // allocation failed. the error was already output. return the node to the free list.
+            OsHostMemoryPoolPushNode(pool, alloc);
+            pool->FailedCount.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+        alloc->NextAllocation = NULL;
+        pool->AllocationCount.fetch_add(1, std::memory_order_relaxed);
+        OsAtomicUpdatePeak(pool->NodesInUsePeak, pool->NodesInUse.fetch_add(1, std::memory_order_relaxed) + 1);
+        OsAllocationTraceRecord(pool, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_ALLOCATE, (uint64_t)(uintptr_t) alloc->BaseAddress, alloc->BytesReserved, 0);
+        return alloc;
+    }
+    else
+    {   // the pool capacity needs to be increased; there are no free OS_HOST_MEMORY_ALLOCATION objects.
+        OsLayerError("ERROR: %S(%u): No free OS_HOST_MEMORY_ALLOCATION objects in pool %S.\n", __FUNCTION__, OsThreadId(), pool->Name);
+        pool->ExhaustedCount.fetch_add(1, std::memory_order_relaxed);
+        pool->FailedCount.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+}
+
+/// @summary Release all address space reserved and/or committed for an OS_HOST_MEMORY_ALLOCATION and return it to the free pool.
+/// @param pool The pool to which the OS_HOST_MEMORY_ALLOCATION will be returned. This must be the same pool the allocation was acquired from.
+/// @param alloc The OS_HOST_MEMORY_ALLOCATION to return.
+public_function void
+OsHostMemoryPoolRelease
+(
+    OS_HOST_MEMORY_POOL        *pool, 
+    OS_HOST_MEMORY_ALLOCATION *alloc
+)
+{
+    if (alloc->SourcePool != pool)
+    {
+        OsLayerError("ERROR: %S(%u): Returning allocation to incorrect pool %S.\n", __FUNCTION__, OsThreadId(), pool->Name);
+        assert(alloc->SourcePool == pool && "OS_HOST_MEMORY_ALLOCATION released to wrong pool");
+    }
+    if (alloc->BaseAddress != NULL)
+    {   // release all of the address space and return the chunk to the free pool.
+        OsAllocationTraceRecord(pool, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_FREE, (uint64_t)(uintptr_t) alloc->BaseAddress, alloc->BytesReserved, 0);
+        pool->ReleaseCount.fetch_add(1, std::memory_order_relaxed);
+        pool->NodesInUse.fetch_sub(1, std::memory_order_relaxed);
+        OsHostMemoryRelease(alloc);
+        OsHostMemoryPoolPushNode(pool, alloc);
+    }
+}
+
+/// @summary Reset a host memory pool to empty. All allocations and reservations are invalidated.
+/// @param pool The OS_HOST_MEMORY_POOL to reset.
+public_function void
+OsHostMemoryPoolReset
+(
+    OS_HOST_MEMORY_POOL *pool
+)
+{   // release all memory allocations, then return them to the free list.
+    for (size_t i = 0, n = pool->Capacity; i < n; ++i)
+    {
+        OsHostMemoryRelease(&pool->NodeList[i]);
+    }
+    OsHostMemoryPoolResetFreeList(pool);
+}
+
+/// @summary Retrieve statistics for a host memory pool. BytesLive and BytesPeak report committed memory.
+/// @param pool The OS_HOST_MEMORY_POOL to query.
+/// @param stats On return, the statistics for the pool.
+public_function void
+OsHostMemoryPoolQueryStats
+(
+    OS_HOST_MEMORY_POOL *pool, 
+    OS_ALLOCATOR_STATS *stats
+)
+{
+    stats->AllocationCount  = pool->AllocationCount.load(std::memory_order_relaxed);
+    stats->FreeCount        = pool->ReleaseCount.load(std::memory_order_relaxed);
+    stats->FailedCount      = pool->FailedCount.load(std::memory_order_relaxed);
+    stats->BytesLive        = pool->BytesCommitted.load(std::memory_order_relaxed);
+    stats->BytesPeak        = pool->BytesCommittedPeak.load(std::memory_order_relaxed);
+    stats->BytesFree        = 0;
+    stats->LargestFreeBlock = 0;
+    stats->BytesReserved    = pool->BytesReserved.load(std::memory_order_relaxed);
+    stats->BytesCommitted   = pool->BytesCommitted.load(std::memory_order_relaxed);
+    stats->CommitCount      = pool->CommitCount.load(std::memory_order_relaxed);
+}
+
+/// @summary Reserve, and optionally commit, address space within a process. Call OsHostMemoryRelease first if the allocation currently holds a memory reservation.
+/// @param alloc The OS_HOST_MEMORY_ALLOCATION to initialize. The OS_HOST_MEMORY_ALLOCTION::SourcePool and OS_HOST_MEMORY_ALLOCATION::NextAllocation fields are expected to be set by the caller.
+/// @param reserve_size The number of bytes of process address space to reserve. This value is rounded up to the nearest even multiple of the operating system page size.
+/// @param commit_size The number of bytes of process address space to commit. This value is rounded up to the nearest even multiple of the operating system page size.
+/// @param alloc_flags One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS, or 0 if no special behavior is desired in which case the memory is readable, writable and has a guard page.
+/// @return Zero if the address space is successfully reserved, or -1 if an error occurred.
+public_function int
+OsHostMemoryReserveAndCommit
+(
+    OS_HOST_MEMORY_ALLOCATION *alloc, 
+    size_t              reserve_size, 
+    size_t               commit_size, 
+    uint32_t             alloc_flags
+)
+{   assert(alloc->SourcePool != NULL);
+    return OsHostMemoryReserveAndCommit(alloc, reserve_size, commit_size, alloc_flags, alloc->SourcePool->NumaPolicy, alloc->SourcePool->NumaNode);
+}
+
+/// @summary Reserve, and optionally commit, address space within a process, placing the physical memory according to a NUMA policy. Call OsHostMemoryRelease first if the allocation currently holds a memory reservation.
+/// @param alloc The OS_HOST_MEMORY_ALLOCATION to initialize. The OS_HOST_MEMORY_ALLOCTION::SourcePool and OS_HOST_MEMORY_ALLOCATION::NextAllocation fields are expected to be set by the caller.
+/// @param reserve_size The number of bytes of process address space to reserve. This value is rounded up to the nearest even multiple of the operating system page size.
+/// @param commit_size The number of bytes of process address space to commit. This value is rounded up to the nearest even multiple of the operating system page size.
+/// @param alloc_flags One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS, or 0 if no special behavior is desired in which case the memory is readable, writable and has a guard page.
+/// @param numa_policy One of OS_HOST_MEMORY_NUMA_POLICY specifying how the physical memory backing the allocation is placed.
+/// @param numa_node The zero-based index of the NUMA node, used with OS_HOST_MEMORY_NUMA_POLICY_BIND.
+/// @return Zero if the address space is successfully reserved, or -1 if an error occurred.
+public_function int
+OsHostMemoryReserveAndCommit
+(
+    OS_HOST_MEMORY_ALLOCATION *alloc, 
+    size_t              reserve_size, 
+    size_t               commit_size, 
+    uint32_t             alloc_flags, 
+    uint32_t             numa_policy, 
+    uint32_t               numa_node
+)
+{   assert(alloc->SourcePool != NULL);
+    void   *base = NULL;
+    size_t  page = alloc->SourcePool->PageSize;
+    size_t extra = 0;
+    uint32_t access = OsVmmPageProtection(alloc_flags);
+
+    if (commit_size > reserve_size)
+    {
+        OsLayerError("ERROR: %S(%u): Requested commit size %Iu exceeds reserve size %Iu.\n", __FUNCTION__, OsThreadId(), commit_size, reserve_size);
+        return -1;
+    }
+
+    // VMM allocations are rounded up to the next even multiple of the system 
+    // page size, and have a starting address that is an even multiple of the
+    // allocation granularity (typically 64KB.)
+    reserve_size = OsAlignUp(reserve_size, page);
+
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_EXECUTE)
+    {   // executable allocations force the entire reservation to be committed.
+        commit_size = reserve_size;
+    }
+
+    // determine whether a guard page will be allocated for this allocation.
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_NO_GUARD_PAGE)
+    {   // don't include a guard page.
+        extra = 0;
+    }
+    else
+    {   // include an extra page at the end of the reserved address space range.
+        extra = page;
+    }
+
+    if (commit_size > 0)
+    {   // only the leading commit_size bytes are committed; the rest is committed on demand.
+        commit_size = OsAlignUp(commit_size, page);
+    }
+    if (!OsMemoryBudgetCharge((int64_t) commit_size))
+    {   // OsMemoryBudgetCharge output error information already.
+        return -1;
+    }
+
+    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_LARGE_PAGES)
+    {   // attempt to use large pages. if they're unavailable, silently fall back to normal pages.
+        size_t large_reserve = reserve_size;
+        size_t large_commit  = commit_size;
+        size_t large_guard   = extra;
+        size_t large_page    = 0;
+        if ((base = OsVmmReserveLargePages(large_reserve, large_commit, large_guard, large_page, access, numa_policy, numa_node)) != NULL)
+        {   // large pages round the commit size up further; the difference cannot be refused, since the memory is already committed.
+            OsMemoryBudgetCharge((int64_t) large_commit - (int64_t) commit_size);
+            reserve_size = large_reserve;
+            commit_size  = large_commit;
+            extra        = large_guard;
+            page         = large_page;
+        }
+    }
+    if (base == NULL)
+    {   // reserve contiguous virtual address space and commit the leading portion.
+        if ((base = OsVmmReserve(reserve_size, commit_size, extra, access, numa_policy, numa_node)) == NULL)
+        {   // OsVmmReserve output error information already.
+            OsMemoryBudgetCharge(-(int64_t) commit_size);
+            return -1;
+        }
+    }
+
+    // initialize the OS_HOST_MEMORY_ALLOCATION fields.
+    alloc->BaseAddress     =(uint8_t*) base;
+    alloc->BytesReserved   = reserve_size;
+    alloc->BytesCommitted  = commit_size;
+    alloc->PageSize        = page;
+    alloc->GuardSize       = extra;
+    alloc->AllocationFlags = alloc_flags;
+    alloc->NumaPolicy      = numa_policy;
+    alloc->NumaNode        = numa_node;
+
+    // update the pool statistics.
+    alloc->SourcePool->BytesReserved.fetch_add(reserve_size, std::memory_order_relaxed);
+    alloc->SourcePool->CommitCount.fetch_add(commit_size > 0 ? 1 : 0, std::memory_order_relaxed);
+    OsAtomicUpdatePeak(alloc->SourcePool->BytesCommittedPeak, alloc->SourcePool->BytesCommitted.fetch_add(commit_size, std::memory_order_relaxed) + commit_size);
+    return 0;
+}
+
+/// @summary Increase the amount of committed memory within an allocation. The commit size cannot exceed the reserve size.
+/// @param alloc The OS_HOST_MEMORY_ALLOCATION having its commit size increased.
+/// @param commit_size The total amount of memory within the allocation that should be committed.
+/// @return Zero if at least the specified amount of address space is successfully committed, or -1 if an error occurred.
+public_function int
+OsHostMemoryIncreaseCommitment
+(
+    OS_HOST_MEMORY_ALLOCATION *alloc, 
+    size_t               commit_size
+)
+{
+    if (alloc->BytesCommitted < commit_size)
+    {   // VMM calls are expensive, so enforce a minimum commit increase.
+        size_t const MIN_COMMIT_INCREASE = alloc->SourcePool->MinCommitIncrease;
+        size_t const max_commit_increase = alloc->BytesReserved - alloc->BytesCommitted;
+        size_t       req_commit_increase = commit_size          - alloc->BytesCommitted;
+        if (req_commit_increase < MIN_COMMIT_INCREASE)
+        {   // request the minimum commit increase.
+            req_commit_increase = MIN_COMMIT_INCREASE;
+        }
+        if (req_commit_increase > max_commit_increase)
+        {   // limit to the maximum possible commit increase.
+            req_commit_increase = max_commit_increase;
+        }
+        size_t new_bytes_commit = OsAlignUp(alloc->BytesCommitted + req_commit_increase, alloc->PageSize);
+        size_t     commit_delta = new_bytes_commit - alloc->BytesCommitted;
+        if (!OsMemoryBudgetCharge((int64_t) commit_delta))
+        {   // OsMemoryBudgetCharge output error information already.
+            return -1;
+        }
+        // request that an additional portion of the pre-reserved address space be committed.
+        // executable allocations are entirely committed up-front, so no need to worry about that case here.
+        if (!OsVmmCommit(alloc->BaseAddress, new_bytes_commit, OsVmmPageProtection(alloc->AllocationFlags)))
+        {
+            OsLayerError("ERROR: %S(%u): Failed to increase commit size to %Iu from %Iu.\n", __FUNCTION__, OsThreadId(), new_bytes_commit, alloc->BytesCommitted);
+            OsMemoryBudgetCharge(-(int64_t) commit_delta);
+            return -1;
+        }
+        // the commitment amount was increased successfully.
+        alloc->SourcePool->CommitCount.fetch_add(1, std::memory_order_relaxed);
+        OsAtomicUpdatePeak(alloc->SourcePool->BytesCommittedPeak, alloc->SourcePool->BytesCommitted.fetch_add(commit_delta, std::memory_order_relaxed) + commit_delta);
+        alloc->BytesCommitted = new_bytes_commit;
+        OsAllocationTraceRecord(alloc->SourcePool, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_COMMIT, (uint64_t)(uintptr_t) alloc->BaseAddress, new_bytes_commit, 0);
+        return 0;
+    }
+    else
+    {   // the requested commitment has already been met.
+        return 0;
+    }
+}
+
+/// @summary Flush the CPU instruction cache after dynamically generated code has been written to a memory allocation with the EXECUTE flag set.
+/// @param alloc The OS_HOST_MEMORY_ALLOCATION containing the dynamically-generated code.
+public_function void
+OsHostMemoryFlush
+(
+    OS_HOST_MEMORY_ALLOCATION *alloc
+)
+{
+    if (alloc->AllocationFlags & OS_HOST_MEMORY_ALLOCATION_FLAG_EXECUTE)
+    {   // OsVmmFlushInstructionCache outputs its own error information.
+        OsVmmFlushInstructionCache(alloc->BaseAddress, alloc->BytesCommitted);
+    }
+}
+
+/// @summary Release the process address space associated with a host memory allocation.
+/// @param alloc The OS_HOST_MEMORY_ALLOCATION to release.
+public_function void
+OsHostMemoryRelease
+(
+    OS_HOST_MEMORY_ALLOCATION *alloc
+)
+{
+    if (alloc->BaseAddress != NULL)
+    {   // free the entire reserved range of virtual address space, including the guard page.
+        OsVmmRelease(alloc->BaseAddress, alloc->BytesReserved + alloc->GuardSize);
+        OsMemoryBudgetCharge(-(int64_t) alloc->BytesCommitted);
+        if (alloc->SourcePool != NULL)
+        {   // update the pool statistics.
+            alloc->SourcePool->BytesReserved.fetch_sub(alloc->BytesReserved, std::memory_order_relaxed);
+            alloc->SourcePool->BytesCommitted.fetch_sub(alloc->BytesCommitted, std::memory_order_relaxed);
+        }
+    }
+    alloc->BaseAddress    = NULL;
+    alloc->BytesReserved  = 0;
+    alloc->BytesCommitted = 0;
+    alloc->PageSize       = 0;
+    alloc->GuardSize      = 0;
+}
+
+/// @summary Determine the NUMA node on which the physical page containing a given address resides.
+/// @param address An address within a committed region of a host memory allocation. On Linux, the page is faulted in if it is not yet resident.
+/// @return The zero-based index of the NUMA node, or -1 if the page is not resident or the node cannot be determined.
+public_function int32_t
+OsHostMemoryQueryNumaNode
+(
+    void const *address
+)
+{
+#if defined(__linux__)
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0, address, MPOL_F_NODE | MPOL_F_ADDR) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): get_mempolicy for address %p failed (errno = %d).\n", __FUNCTION__, OsThreadId(), address, errno);
+        return -1;
+    }
+    return int32_t(node);
+#else
+    PSAPI_WORKING_SET_EX_INFORMATION info = {};
+    info.VirtualAddress = (PVOID) address;
+    if (!QueryWorkingSetEx(GetCurrentProcess(), &info, sizeof(info)))
+    {
+        OsLayerError("ERROR: %S(%u): QueryWorkingSetEx for address %p failed (%08X).\n", __FUNCTION__, OsThreadId(), address, GetLastError());
+        return -1;
+    }
+    if (!info.VirtualAttributes.Valid)
+    {   // the page is not resident in the working set of the process.
+        return -1;
+    }
+    return int32_t(info.VirtualAttributes.Node);
+#endif
+}
+
+/// @summary Populate a range of committed host memory with physical pages ahead of use, so that first access does not incur a page fault.
+/// The range is expanded to whole pages. Contents are preserved, so the range may contain live data.
+/// @param address The address of the first byte of the range. The range must lie within committed memory.
+/// @param size The number of bytes in the range.
+/// @return true if the range was populated.
+public_function bool
+OsHostMemoryPrefault
+(
+    void *address, 
+    size_t   size
+)
+{
+    size_t   page_size = 0;
+    size_t granularity = 0;
+    size_t       start = 0;
+    size_t         end = 0;
+    if (size == 0)
+    {   // nothing to populate.
+        return true;
+    }
+    OsVmmQueryPageSize(page_size, granularity);
+    start = (size_t) address & ~(page_size - 1);
+    end   = OsAlignUp((size_t) address + size, page_size);
+    return OsVmmPrefault((void*) start, end - start, page_size);
+}
+
+/// @summary Implement the entry point of a helper thread started by OsHostMemoryPrefaultParallel.
+/// @param base The page-aligned base address of the share of the range populated by the thread.
+/// @param size The number of bytes in the share. This must be a multiple of the page size.
+/// @param page_size The VMM page size, in bytes.
+/// @param numa_node The zero-based index of the NUMA node the thread should run on, or -1 to run on any processor.
+/// @param success Set to false if the share could not be populated.
+internal_function void
+OsHostMemoryPrefaultThreadMain
+(
+    uint8_t                  *base, 
+    size_t                    size, 
+    size_t               page_size, 
+    int32_t              numa_node, 
+    std::atomic<bool>     *success
+)
+{
+    if (numa_node >= 0)
+    {   // a failure to bind is not fatal; the pages are still populated.
+        OsVmmBindThreadToNumaNode((uint32_t) numa_node);
+    }
+    if (!OsVmmPrefault(base, size, page_size))
+    {
+        success->store(false, std::memory_order_relaxed);
+    }
+}
+
+/// @summary Populate a range of committed host memory with physical pages, dividing the work between several threads.
+/// Helper threads are started for the duration of the call; the calling thread populates one share of the range.
+/// Ranges too small to benefit from parallelism are populated on the calling thread only.
+/// @param address The address of the first byte of the range. The range must lie within committed memory.
+/// @param size The number of bytes in the range.
+/// @param thread_count The maximum number of threads, including the calling thread, used to populate the range.
+/// @param numa_node The zero-based index of the NUMA node whose processors the helper threads should run on, or -1 to run on any processor.
+/// @return true if the range was populated.
+public_function bool
+OsHostMemoryPrefaultParallel
+(
+    void       *address, 
+    size_t         size, 
+    size_t thread_count, 
+    int32_t   numa_node
+)
+{
+    size_t const MIN_BYTES_PER_THREAD = 4 * 1024 * 1024;
+    size_t const   MAX_HELPER_THREADS = 63;
+    std::thread helpers[MAX_HELPER_THREADS];
+    std::atomic<bool>     success(true);
+    size_t              page_size = 0;
+    size_t            granularity = 0;
+    size_t             share_size = 0;
+    size_t           helper_count = 0;
+    size_t             total_size = 0;
+    uint8_t                 *base = NULL;
+
+    if (size == 0)
+    {   // nothing to populate.
+        return true;
+    }
+    OsVmmQueryPageSize(page_size, granularity);
+    base       = (uint8_t*)((size_t) address & ~(page_size - 1));
+    total_size = OsAlignUp((size_t) address + size, page_size) - (size_t) base;
+    if (thread_count > total_size / MIN_BYTES_PER_THREAD)
+        thread_count = total_size / MIN_BYTES_PER_THREAD;
+    if (thread_count > MAX_HELPER_THREADS + 1)
+        thread_count = MAX_HELPER_THREADS + 1;
+    if (thread_count <= 1)
+    {   // not worth the cost of starting threads.
+        return OsVmmPrefault(base, total_size, page_size);
+    }
+
+    // each thread populates a contiguous, page-aligned share. the calling thread takes the last share.
+    share_size = OsAlignUp(total_size / thread_count, page_size);
+    for (helper_count = 0; helper_count < thread_count - 1 && (helper_count + 1) * share_size < total_size; ++helper_count)
+    {
+        uint8_t *share_base = base + (helper_count * share_size);
+        helpers[helper_count] = std::thread(OsHostMemoryPrefaultThreadMain, share_base, share_size, page_size, numa_node, &success);
+    }
+    if (!OsVmmPrefault(base + (helper_count * share_size), total_size - (helper_count * share_size), page_size))
+    {
+        success.store(false, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < helper_count; ++i)
+    {
+        helpers[i].join();
+    }
+    return success.load(std::memory_order_relaxed);
+}
+
+/// @summary Populate the committed portion of a host memory allocation with physical pages, dividing the work between several threads.
+/// If the allocation is bound to a NUMA node, the helper threads run on the processors of that node.
+/// @param alloc The OS_HOST_MEMORY_ALLOCATION to populate.
+/// @param thread_count The maximum number of threads, including the calling thread, used to populate the allocation.
+/// @return true if the committed range was populated.
+public_function bool
+OsHostMemoryPrefaultParallel
+(
+    OS_HOST_MEMORY_ALLOCATION *alloc, 
+    size_t              thread_count
+)
+{
+    int32_t numa_node = -1;
+    if (alloc->NumaPolicy == OS_HOST_MEMORY_NUMA_POLICY_BIND)
+    {   // populate the memory from threads running on the node that holds it.
+        numa_node = (int32_t) alloc->NumaNode;
+    }
+    return OsHostMemoryPrefaultParallel(alloc->BaseAddress, alloc->BytesCommitted, thread_count, numa_node);
+}
+
+/// @summary Initialize an allocation trace ring buffer.
+/// @param trace The OS_ALLOCATION_TRACE to initialize.
+/// @param capacity The number of records the ring can hold. This value is rounded up to the next power of two.
+/// @return Zero if the trace is initialized successfully, or -1 if an error occurred.
+public_function int
+OsCreateAllocationTrace
+(
+    OS_ALLOCATION_TRACE *trace, 
+    size_t            capacity
+)
+{
+    size_t     page_size = 0;
+    size_t   granularity = 0;
+    size_t  storage_size = 0;
+    void        *storage = NULL;
+    if (capacity < 2)
+    {   // ensure the capacity is a non-zero power of two.
+        capacity = 2;
+    }
+    capacity = OsNextPowerOfTwoGreaterOrEqual(capacity);
+    OsVmmQueryPageSize(page_size, granularity);
+    storage_size = OsAlignUp(capacity * sizeof(OS_ALLOCATION_TRACE_SLOT), page_size);
+    if ((storage = OsVmmAllocateMetadata(storage_size)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to allocate %Iu bytes for allocation trace storage.\n", __FUNCTION__, OsThreadId(), storage_size);
+        return -1;
+    }
+    // the VMM returns zeroed memory, so every slot Sequence starts at zero (empty).
+    trace->Slots       =(OS_ALLOCATION_TRACE_SLOT*) storage;
+    trace->Capacity    = capacity;
+    trace->StorageSize = storage_size;
+    trace->WriteIndex.store(0, std::memory_order_relaxed);
+    return 0;
+}
+
+/// @summary Free resources associated with an allocation trace. The trace must not be the active trace.
+/// @param trace The OS_ALLOCATION_TRACE to delete.
+public_function void
+OsDeleteAllocationTrace
+(
+    OS_ALLOCATION_TRACE *trace
+)
+{   assert(AllocationTrace != trace);
+    if (trace->Slots != NULL)
+    {
+        OsVmmReleaseMetadata(trace->Slots, trace->StorageSize);
+    }
+    trace->Slots       = NULL;
+    trace->Capacity    = 0;
+    trace->StorageSize = 0;
+}
+
+/// @summary Set the allocation trace receiving events from all allocators. Call while no other thread is using an allocator.
+/// @param trace The OS_ALLOCATION_TRACE to receive events, or NULL to disable tracing.
+/// @return The previously active OS_ALLOCATION_TRACE, or NULL.
+public_function OS_ALLOCATION_TRACE*
+OsSetAllocationTrace
+(
+    OS_ALLOCATION_TRACE *trace
+)
+{
+    OS_ALLOCATION_TRACE *prev = AllocationTrace;
+    AllocationTrace = trace;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return prev;
+}
+
+/// @summary Copy records out of an allocation trace. Records that were overwritten or are still being written are skipped.
+/// @param trace The OS_ALLOCATION_TRACE to read.
+/// @param read_index On entry, the index of the first record to read. On return, the index of the next record to read.
+/// @param records The array of records to populate.
+/// @param max_records The maximum number of records to write to the records array.
+/// @return The number of records written to the records array.
+public_function size_t
+OsAllocationTraceRead
+(
+    OS_ALLOCATION_TRACE        *trace, 
+    uint64_t              &read_index, 
+    OS_ALLOCATION_TRACE_RECORD *records, 
+    size_t                max_records
+)
+{
+    uint64_t write_index = trace->WriteIndex.load(std::memory_order_acquire);
+    size_t         count = 0;
+    if (write_index - read_index > trace->Capacity)
+    {   // records before write_index - Capacity have been overwritten.
+        read_index = write_index - trace->Capacity;
+    }
+    while (read_index < write_index && count < max_records)
+    {
+        OS_ALLOCATION_TRACE_SLOT *slot = &trace->Slots[read_index & (trace->Capacity - 1)];
+        uint64_t             published = (read_index + 1) * 2;
+        if (slot->Sequence.load(std::memory_order_acquire) == published)
+        {   // copy the record, then make sure no writer claimed the slot during the copy.
+            OS_ALLOCATION_TRACE_RECORD record = slot->Record;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->Sequence.load(std::memory_order_relaxed) == published)
+                records[count++] = record;
+        }
+        read_index++;
+    }
+    return count;
+}
+
+/// @summary Initialize a memory budget. The limit is detected from the cgroup or job object containing the process, and the current usage is read.
+/// @param budget The OS_MEMORY_BUDGET to initialize.
+/// @param init The thresholds and limit override for the budget, or NULL to use the defaults.
+/// @return Zero if the budget is initialized successfully, or -1 if an error occurred.
+public_function int
+OsCreateMemoryBudget
+(
+    OS_MEMORY_BUDGET            *budget, 
+    OS_MEMORY_BUDGET_INIT const   *init
+)
+{
+    OS_MEMORY_BUDGET_INIT defaults = {};
+    uint64_t                 usage = 0;
+    if (init == NULL)
+    {   // use the default thresholds and detect the limit.
+        init = &defaults;
+    }
+    uint32_t moderate_percent = init->ModeratePercent   != 0 ? init->ModeratePercent   : 75;
+    uint32_t critical_percent = init->CriticalPercent   != 0 ? init->CriticalPercent   : 90;
+    uint32_t   hyster_percent = init->HysteresisPercent != 0 ? init->HysteresisPercent :  5;
+    if (moderate_percent > critical_percent || critical_percent > 100 || init->RefusePercent > 100 || hyster_percent > 100)
+    {
+        OsLayerError("ERROR: %S(%u): Invalid memory budget thresholds (moderate %u%%, critical %u%%, refuse %u%%).\n", __FUNCTION__, OsThreadId(), moderate_percent, critical_percent, init->RefusePercent);
+        return -1;
+    }
+    OsZeroMemory(budget->Callbacks, sizeof(budget->Callbacks));
+    budget->CallbackCount = 0;
+    // detect the limit even when it is overridden, since detection also determines where usage is read from.
+    OsMemoryBudgetDetectLimit(budget);
+    if (init->LimitOverride != 0)
+    {
+        budget->Limit       = init->LimitOverride;
+        budget->LimitSource = OS_MEMORY_BUDGET_SOURCE_OVERRIDE;
+    }
+    budget->Thresholds[OS_MEMORY_PRESSURE_LEVEL_NONE    ] = 0;
+    budget->Thresholds[OS_MEMORY_PRESSURE_LEVEL_MODERATE] = (budget->Limit / 100) * moderate_percent;
+    budget->Thresholds[OS_MEMORY_PRESSURE_LEVEL_CRITICAL] = (budget->Limit / 100) * critical_percent;
+    budget->RefuseThreshold = (budget->Limit / 100) * init->RefusePercent;
+    budget->Hysteresis      = (budget->Limit / 100) * hyster_percent;
+    budget->RefreshInterval = init->RefreshInterval != 0 ? init->RefreshInterval : Megabytes(16);
+    if (!OsMemoryBudgetReadUsage(budget, usage))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to read the initial memory usage.\n", __FUNCTION__, OsThreadId());
+        return -1;
+    }
+    budget->SystemUsage.store(usage, std::memory_order_relaxed);
+    budget->ChargedSinceRefresh.store(0, std::memory_order_relaxed);
+    budget->BytesCharged.store(0, std::memory_order_relaxed);
+    budget->Level.store(OsMemoryBudgetPressureLevel(budget, usage), std::memory_order_relaxed);
+    budget->RefreshCount.store(1, std::memory_order_relaxed);
+    budget->DispatchCount.store(0, std::memory_order_relaxed);
+    budget->DispatchActive.store(0, std::memory_order_relaxed);
+    budget->RefusedCount.store(0, std::memory_order_relaxed);
+    OsCreateMutex(&budget->Lock, 0x1000);
+    return 0;
+}
+
+/// @summary Free resources associated with a memory budget. The budget must not be the active budget.
+/// @param budget The OS_MEMORY_BUDGET to delete.
+public_function void
+OsDeleteMemoryBudget
+(
+    OS_MEMORY_BUDGET *budget
+)
+{   assert(MemoryBudget != budget);
+    OsDeleteMutex(&budget->Lock);
+    budget->CallbackCount = 0;
+}
+
+/// @summary Set the memory budget charged for commits made through the host memory APIs. Call while no other thread is committing host memory.
+/// Memory committed before the budget becomes active is not charged when it is released, but is included in the usage reported by the operating system.
+/// @param budget The OS_MEMORY_BUDGET to charge, or NULL to disable budget enforcement.
+/// @return The previously active OS_MEMORY_BUDGET, or NULL.
+public_function OS_MEMORY_BUDGET*
+OsSetMemoryBudget
+(
+    OS_MEMORY_BUDGET *budget
+)
+{
+    OS_MEMORY_BUDGET *prev = MemoryBudget;
+    MemoryBudget = budget;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return prev;
+}
+
+/// @summary Register a callback to be invoked when memory usage rises to a pressure level or higher.
+/// If the budget is already at or above the level, the callback is invoked, without the budget lock held, before the function returns.
+/// @param budget The OS_MEMORY_BUDGET to monitor.
+/// @param level One of OS_MEMORY_PRESSURE_LEVEL_MODERATE or OS_MEMORY_PRESSURE_LEVEL_CRITICAL.
+/// @param callback The function to invoke.
+/// @param context Opaque data passed through to the callback.
+/// @return Zero if the callback is registered, or -1 if the maximum number of callbacks are already registered.
+public_function int
+OsMemoryBudgetRegisterCallback
+(
+    OS_MEMORY_BUDGET          *budget, 
+    uint32_t                    level, 
+    OS_MEMORY_PRESSURE_FUNC  callback, 
+    void                     *context
+)
+{
+    if (level == OS_MEMORY_PRESSURE_LEVEL_NONE || level > OS_MEMORY_PRESSURE_LEVEL_CRITICAL)
+    {
+        OsLayerError("ERROR: %S(%u): Invalid memory pressure level %u.\n", __FUNCTION__, OsThreadId(), level);
+        return -1;
+    }
+    OsLockMutex(&budget->Lock);
+    if (budget->CallbackCount == OS_MEMORY_BUDGET::MAX_CALLBACKS)
+    {
+        OsUnlockMutex(&budget->Lock);
+        OsLayerError("ERROR: %S(%u): Too many memory pressure callbacks; the maximum is %Iu.\n", __FUNCTION__, OsThreadId(), OS_MEMORY_BUDGET::MAX_CALLBACKS);
+        return -1;
+    }
+    OS_MEMORY_PRESSURE_CALLBACK *entry = &budget->Callbacks[budget->CallbackCount++];
+    entry->Callback = callback;
+    entry->Context  = context;
+    entry->Level    = level;
+    uint32_t current = budget->Level.load(std::memory_order_relaxed);
+    if (current >= level)
+    {   // the transition has already been dispatched; don't leave the new callback waiting for the next one.
+        budget->DispatchActive.fetch_add(1, std::memory_order_acquire);
+    }
+    OsUnlockMutex(&budget->Lock);
+    if (current >= level)
+    {
+        callback(context, current, OsMemoryBudgetEstimateUsage(budget, 0), budget->Limit);
+        budget->DispatchActive.fetch_sub(1, std::memory_order_release);
+    }
+    return 0;
+}
+
+/// @summary Remove a callback registered with OsMemoryBudgetRegisterCallback. The callback is not invoked after the function returns.
+/// If another thread is dispatching callbacks, the function waits for the dispatch to finish. Do not call from a pressure callback.
+/// @param budget The OS_MEMORY_BUDGET being monitored.
+/// @param callback The function supplied when the callback was registered.
+/// @param context The context supplied when the callback was registered.
+public_function void
+OsMemoryBudgetUnregisterCallback
+(
+    OS_MEMORY_BUDGET          *budget, 
+    OS_MEMORY_PRESSURE_FUNC  callback, 
+    void                     *context
+)
+{
+    OsLockMutex(&budget->Lock);
+    for (size_t i = 0; i < budget->CallbackCount; ++i)
+    {
+        if (budget->Callbacks[i].Callback == callback && budget->Callbacks[i].Context == context)
+        {   // preserve registration order, so callbacks keep running in the order they were registered.
+            OsMoveMemory(&budget->Callbacks[i], &budget->Callbacks[i+1], (budget->CallbackCount - i - 1) * sizeof(OS_MEMORY_PRESSURE_CALLBACK));
+            budget->CallbackCount--;
+            break;
+        }
+    }
+    OsUnlockMutex(&budget->Lock);
+    while (budget->DispatchActive.load(std::memory_order_acquire) != 0)
+    {   // a dispatch that copied the callback list before it was removed may still invoke the callback.
+        std::this_thread::yield();
+    }
+}
+
+/// @summary Re-read the memory usage reported by the operating system and update the pressure level, invoking callbacks if it rises.
+/// Call periodically, for example once per frame or from a timer, to catch growth in memory that is not committed through the host memory APIs.
+/// @param budget The OS_MEMORY_BUDGET to update.
+/// @return One of OS_MEMORY_PRESSURE_LEVEL specifying the current pressure level.
+public_function uint32_t
+OsMemoryBudgetUpdate
+(
+    OS_MEMORY_BUDGET *budget
+)
+{
+    OsMemoryBudgetRefresh(budget, true);
+    return OsMemoryBudgetEvaluate(budget, 0);
+}
+
+/// @summary Retrieve the current state of a memory budget.
+/// @param budget The OS_MEMORY_BUDGET to query.
+/// @param status On return, the state of the budget.
+public_function void
+OsMemoryBudgetQuery
+(
+    OS_MEMORY_BUDGET        *budget, 
+    OS_MEMORY_BUDGET_STATUS *status
+)
+{
+    status->Limit          = budget->Limit;
+    status->SystemUsage    = budget->SystemUsage.load(std::memory_order_relaxed);
+    status->EstimatedUsage = OsMemoryBudgetEstimateUsage(budget, 0);
+    status->BytesCharged   = budget->BytesCharged.load(std::memory_order_relaxed);
+    status->RefreshCount   = budget->RefreshCount.load(std::memory_order_relaxed);
+    status->DispatchCount  = budget->DispatchCount.load(std::memory_order_relaxed);
+    status->RefusedCount   = budget->RefusedCount.load(std::memory_order_relaxed);
+    status->Level          = budget->Level.load(std::memory_order_relaxed);
+    status->LimitSource    = budget->LimitSource;
+}
+
+/// @summary Initialize an OS_ARENA_ALLOCATOR.
+/// @param alloc The OS_ARENA_ALLOCATOR to initialize.
+/// @param size_in_bytes The number of bytes from which the arena will sub-allocate.
+/// @return Zero if the allocator is successfully initialized, or -1 if an error occurred.
+public_function int
+OsCreateArenaAllocator
+(
+    OS_ARENA_ALLOCATOR *alloc, 
+    size_t      size_in_bytes
+)
+{
+    alloc->NextOffset      = 0;
+    alloc->SizeInBytes     = size_in_bytes;
+    alloc->HighWaterMark   = 0;
+    alloc->AllocationCount = 0;
+    alloc->FailedCount     = 0;
+    alloc->ResetCount      = 0;
+    return 0;
+}
+
+/// @summary Free resources associated with an arena allocator.
+/// @param alloc The OS_ARENA_ALLOCATOR to delete.
+public_function void
+OsDeleteArenaAllocator
+(
+    OS_ARENA_ALLOCATOR *alloc
+)
+{
+    alloc->NextOffset      = 0;
+    alloc->SizeInBytes     = 0;
+    alloc->HighWaterMark   = 0;
+    alloc->AllocationCount = 0;
+    alloc->FailedCount     = 0;
+    alloc->ResetCount      = 0;
+}
+
+/// @summary Determine whether an arena allocator can satisfy an allocation request.
+/// @param alloc The OS_ARENA_ALLOCATOR to query.
+/// @param size The minimum number of bytes to reserve.
+/// @param alignment The required alignment of the returned block offset.
+/// @return true if the arena can satisfy the allocation request.
+public_function bool
+OsArenaAllocatorCanSatisfyAllocation
+(
+    OS_ARENA_ALLOCATOR *alloc, 
+    size_t               size, 
+    size_t          alignment
+)
+{
+    size_t aligned_address = OsAlignUp(alloc->NextOffset, alignment);
+    size_t     alloc_bytes = size + (aligned_address - alloc->NextOffset);
+    size_t      new_offset = alloc_bytes + alloc->NextOffset;
+    return (new_offset <= alloc->SizeInBytes);
+}
+
+/// @summary Reserve space from an arena allocator.
+/// @param alloc The OS_ARENA_ALLOCATOR to update.
+/// @param size The minimum number of bytes to reserve.
+/// @param alignment The required alignment of the returned memory block offset.
+/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region.
+/// @return true if the arena satisfied the allocation request.
+public_function bool
+OsArenaAllocate
+(
+    OS_ARENA_ALLOCATOR *alloc, 
+    size_t               size, 
+    size_t          alignment, 
+    OS_MEMORY_RANGE    &range
+)
+{
+    size_t aligned_address = OsAlignUp(alloc->NextOffset, alignment);
+    size_t     alloc_bytes = size + (aligned_address - alloc->NextOffset);
+    size_t      new_offset = alloc_bytes + alloc->NextOffset;
+    if (new_offset <= alloc->SizeInBytes)
+    {   // the allocation was satisfied, return the new info.
+        range.ByteOffset   = aligned_address;
+        range.SizeInBytes  = size;
+        alloc->NextOffset  = new_offset;
+        if (new_offset > alloc->HighWaterMark)
+            alloc->HighWaterMark = new_offset;
+        alloc->AllocationCount++;
+        OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_ALLOCATE, aligned_address, size, alignment);
+        return true;
+    }
+    else
+    {   // not enough space to satisfy the allocation.
+        range.ByteOffset   = 0;
+        range.SizeInBytes  = 0;
+        alloc->FailedCount++;
+        return false;
+    }
+}
+
+/// @summary Retrieve a marker representing the state of the arena allocator at the current point in time.
+/// @param alloc The OS_ARENA_ALLOCATOR to query.
+/// @return A marker that can be passed to OsArenaResetToMarker to reset the allocator back to its current state.
+public_function os_arena_marker_t 
+OsArenaMark
+(
+    OS_ARENA_ALLOCATOR *alloc
+)
+{
+    return alloc->NextOffset;
+}
+
+/// @summary Reset an arena allocator back to a past point in time, invalidating all allocations made from that point forward.
+/// @param alloc The OS_ARENA_ALLOCATOR to reset.
+/// @param marker A marker returned by a previous call to OsArenaMark.
+public_function void
+OsArenaResetToMarker
+(
+    OS_ARENA_ALLOCATOR *alloc, 
+    os_arena_marker_t  marker
+)
+{   assert(marker <= alloc->NextOffset);
+    alloc->NextOffset = marker;
+    alloc->ResetCount++;
+    OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_RESET, marker, 0, 0);
+}
+
+/// @summary Reset an arena allocator to empty.
+/// @param alloc The OS_ARENA_ALLOCATOR to reset.
+public_function void
+OsArenaReset
+(
+    OS_ARENA_ALLOCATOR *alloc
+)
+{
+    alloc->NextOffset = 0;
+    alloc->ResetCount++;
+    OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_RESET, 0, 0, 0);
+}
+
+/// @summary Retrieve statistics for an arena allocator. FreeCount reports the number of resets.
+/// @param alloc The OS_ARENA_ALLOCATOR to query.
+/// @param stats On return, the statistics for the allocator.
+public_function void
+OsArenaAllocatorQueryStats
+(
+    OS_ARENA_ALLOCATOR *alloc, 
+    OS_ALLOCATOR_STATS *stats
+)
+{
+    stats->AllocationCount  = alloc->AllocationCount;
+    stats->FreeCount        = alloc->ResetCount;
+    stats->FailedCount      = alloc->FailedCount;
+    stats->BytesLive        = alloc->NextOffset;
+    stats->BytesPeak        = alloc->HighWaterMark;
+    stats->BytesFree        = alloc->SizeInBytes - alloc->NextOffset;
+    stats->LargestFreeBlock = alloc->SizeInBytes - alloc->NextOffset;
+    stats->BytesReserved    = alloc->SizeInBytes;
+    stats->BytesCommitted   = 0;
+    stats->CommitCount      = 0;
+}
+
+/// @summary Determine the number of 64-bit words required to store a hierarchical bitset.
+/// @param bit_count The number of bits in the leaf tier of the bitset.
+/// @param tier_count On return, set to the number of tiers in the bitset.
+/// @return The total number of 64-bit words required to store all tiers of the bitset.
+internal_function size_t
+OsBuddyBitsetWordCount
+(
+    uint64_t  bit_count, 
+    uint32_t &tier_count
+)
+{
+    size_t   total = 0;
+    uint64_t words = 0;
+    tier_count = 0;
+    do
+    {   // each tier has one bit for each word in the tier below it.
+        words      = (bit_count + 63) / 64;
+        total     += (size_t) words;
+        bit_count  = words;
+        tier_count++;
+    } while (words > 1);
+    return total;
+}
+
+/// @summary Initialize a hierarchical bitset to use caller-supplied, zero-initialized storage.
+/// @param bitset The OS_BUDDY_BITSET to initialize.
+/// @param bit_count The number of bits in the leaf tier of the bitset.
+/// @param storage The storage for the bitset, of at least OsBuddyBitsetWordCount(bit_count) words.
+/// @return The number of 64-bit words of storage used by the bitset.
+internal_function size_t
+OsBuddyBitsetInit
+(
+    OS_BUDDY_BITSET *bitset, 
+    uint64_t      bit_count, 
+    uint64_t       *storage
+)
+{
+    size_t   total = 0;
+    uint64_t words = 0;
+    bitset->TierCount = 0;
+    do
+    {
+        words     = (bit_count + 63) / 64;
+        bitset->Tiers[bitset->TierCount++] = storage + total;
+        total    += (size_t) words;
+        bit_count = words;
+    } while (words > 1);
+    assert(bitset->TierCount <= OS_BUDDY_BITSET::MAX_TIERS);
+    return total;
+}
+
+/// @summary Set a bit in a hierarchical bitset, updating the summary tiers.
+/// @param bitset The OS_BUDDY_BITSET to update.
+/// @param index The zero-based index of the bit to set.
+internal_function inline void
+OsBuddyBitsetSet
+(
+    OS_BUDDY_BITSET *bitset, 
+    uint64_t          index
+)
+{
+    for (uint32_t tier = 0; tier < bitset->TierCount; ++tier)
+    {
+        uint64_t &word = bitset->Tiers[tier][index >> 6];
+        uint64_t   old = word;
+        word |= 1ULL << (index & 63);
+        if (old != 0)
+        {   // the word was already non-zero, so the higher tiers are already set.
+            break;
+        }
+        index >>= 6;
+    }
+}
+
+/// @summary Clear a bit in a hierarchical bitset, updating the summary tiers.
+/// @param bitset The OS_BUDDY_BITSET to update.
+/// @param index The zero-based index of the bit to clear.
+internal_function inline void
+OsBuddyBitsetClear
+(
+    OS_BUDDY_BITSET *bitset, 
+    uint64_t          index
+)
+{
+    for (uint32_t tier = 0; tier < bitset->TierCount; ++tier)
+    {
+        uint64_t &word = bitset->Tiers[tier][index >> 6];
+        word &= ~(1ULL << (index & 63));
+        if (word != 0)
+        {   // the word is still non-zero, so the higher tiers remain set.
+            break;
+        }
+        index >>= 6;
+    }
+}
+
+/// @summary Determine whether a bit is set in a hierarchical bitset.
+/// @param bitset The OS_BUDDY_BITSET to query.
+/// @param index The zero-based index of the bit to test.
+/// @return true if the bit is set.
+internal_function inline bool
+OsBuddyBitsetTest
+(
+    OS_BUDDY_BITSET *bitset, 
+    uint64_t          index
+)
+{
+    return (bitset->Tiers[0][index >> 6] & (1ULL << (index & 63))) != 0;
+}
+
+/// @summary Locate the lowest set bit in a hierarchical bitset, using one bit scan per tier.
+/// @param bitset The OS_BUDDY_BITSET to search.
+/// @param index On return, set to the zero-based index of the lowest set bit.
+/// @return true if a set bit was found, or false if the bitset is empty.
+internal_function inline bool
+OsBuddyBitsetFindFirst
+(
+    OS_BUDDY_BITSET *bitset, 
+    uint64_t         &index
+)
+{
+    uint32_t tier = bitset->TierCount - 1;
+    uint64_t word = bitset->Tiers[tier][0];
+    if (word == 0)
+    {   // the bitset is empty.
+        return false;
+    }
+    index = OsBitScanForward64(word);
+    while (tier > 0)
+    {   // descend into the first non-zero word of the next-lower tier.
+        tier--;
+        word  = bitset->Tiers[tier][index];
+        index =(index << 6) | OsBitScanForward64(word);
+    }
+    return true;
+}
+
+/// @summary Determine whether a word of a hierarchical bitset may be non-zero, by checking its summary bits from the top tier down.
+/// Only the top tier, and words whose summary bit is set, are read, so the bitset storage may be committed lazily.
+/// @param bitset The OS_BUDDY_BITSET to query.
+/// @param tier The zero-based index of the tier containing the word.
+/// @param word_index The zero-based index of the word within the tier.
+/// @return true if the summary bits of the word are set, or the word is in the top tier.
+internal_function inline bool
+OsBuddyBitsetWordInUse
+(
+    OS_BUDDY_BITSET *bitset, 
+    uint32_t           tier, 
+    uint64_t     word_index
+)
+{
+    for (uint32_t check = bitset->TierCount - 1; check > tier; --check)
+    {   // bit b of tier t summarizes word b of tier t-1.
+        uint64_t bit = word_index >> (6 * (check - tier - 1));
+        if ((bitset->Tiers[check][bit >> 6] & (1ULL << (bit & 63))) == 0)
+            return false;
+    }
+    return true;
+}
+
+/// @summary Locate the highest set bit below a given index in a hierarchical bitset, using at most two bit scans per tier.
+/// Words are only read if their summary bits are set, so the search never touches storage that has not been written.
+/// @param bitset The OS_BUDDY_BITSET to search.
+/// @param limit The exclusive upper bound of the search. Only bits with an index less than this value are considered.
+/// @param index On return, set to the zero-based index of the highest set bit below limit.
+/// @return true if a set bit was found, or false if no bit below limit is set.
+internal_function inline bool
+OsBuddyBitsetFindLastBefore
+(
+    OS_BUDDY_BITSET *bitset, 
+    uint64_t          limit, 
+    uint64_t         &index
+)
+{
+    uint32_t tier = 0;
+    for ( ; ; )
+    {   // look for a set bit below limit in the same word; otherwise, search the preceding words using the next tier.
+        uint64_t last;
+        uint64_t word;
+        if (limit == 0)
+            return false;
+        last = limit - 1;
+        word = OsBuddyBitsetWordInUse(bitset, tier, last >> 6) ? bitset->Tiers[tier][last >> 6] & (~0ULL >> (63 - (last & 63))) : 0;
+        if (word != 0)
+        {
+            index = (last & ~63ULL) | OsBitScanReverse64(word);
+            break;
+        }
+        if (++tier == bitset->TierCount)
+            return false;
+        limit = last >> 6;
+    }
+    while (tier > 0)
+    {   // descend into the last non-zero word of the next-lower tier.
+        tier--;
+        index = (index << 6) | OsBitScanReverse64(bitset->Tiers[tier][index]);
+    }
+    return true;
+}
+
+/// @summary Determine whether the page of buddy allocator metadata containing a given address is committed.
+/// @param alloc The OS_BUDDY_ALLOCATOR to query.
+/// @param addr An address within the metadata storage.
+/// @return true if the page is committed and can be read. Pages that are not committed hold only zero bits.
+internal_function inline bool
+OsBuddyAllocatorIsCommitted
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    void const          *addr
+)
+{
+    size_t page = (size_t)((uint8_t const*) addr - alloc->MetadataBase) >> alloc->MetadataPageShift;
+    return (alloc->MetadataCommitMap[page >> 6] & (1ULL << (page & 63))) != 0;
+}
+
+/// @summary Commit the page of buddy allocator metadata containing a given address, if it is not already committed, and charge it against the active memory budget.
+/// @param alloc The OS_BUDDY_ALLOCATOR to update.
+/// @param addr An address within the metadata storage.
+/// @return true if the page is committed.
+internal_function bool
+OsBuddyAllocatorCommit
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    void const          *addr
+)
+{
+    size_t      page = (size_t)((uint8_t const*) addr - alloc->MetadataBase) >> alloc->MetadataPageShift;
+    size_t page_size = (size_t) 1 << alloc->MetadataPageShift;
+    if ((alloc->MetadataCommitMap[page >> 6] & (1ULL << (page & 63))) != 0)
+    {   // the page is already committed.
+        return true;
+    }
+    if (!OsMemoryBudgetCharge((int64_t) page_size))
+    {   // OsMemoryBudgetCharge output error information already.
+        return false;
+    }
+    if (!OsVmmCommit(alloc->MetadataBase + (page << alloc->MetadataPageShift), page_size, OsVmmPageProtection(OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE)))
+    {   // OsVmmCommit output error information already.
+        OsMemoryBudgetCharge(-(int64_t) page_size);
+        return false;
+    }
+    alloc->MetadataCommitMap[page >> 6] |= 1ULL << (page & 63);
+    alloc->MetadataCommitted += page_size;
+    return true;
+}
+
+/// @summary Commit the metadata written when a block is split repeatedly down to a smaller level, keeping the half that contains a given offset at each step.
+/// Call before the first split, so that a failure leaves the allocator unchanged.
+/// @param alloc The OS_BUDDY_ALLOCATOR to update.
+/// @param block_offset The byte offset of the block that will be kept at target_level.
+/// @param level The zero-based index of the level of the free block being split.
+/// @param target_level The zero-based index of the level of the block being kept.
+/// @return true if all of the metadata is committed.
+internal_function bool
+OsBuddyAllocatorCommitSplits
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint64_t     block_offset, 
+    uint32_t            level, 
+    uint32_t     target_level
+)
+{
+    for ( ; level < target_level; ++level)
+    {   // each split sets a split bit at this level, and a free bit for one of the two halves at the next level.
+        OS_BUDDY_BITSET *bitset = &alloc->FreeBlocks[level + 1];
+        uint64_t          index = block_offset >> alloc->LevelBits[level];
+        uint64_t          child = block_offset >> alloc->LevelBits[level + 1];
+        if (!OsBuddyAllocatorCommit(alloc, &alloc->SplitBlocks[level][index >> 6]))
+            return false;
+        for (uint32_t tier = 0; tier < bitset->TierCount; ++tier, child >>= 6)
+        {   // both halves share a word in every tier.
+            if (!OsBuddyAllocatorCommit(alloc, &bitset->Tiers[tier][child >> 6]))
+                return false;
+        }
+    }
+    return true;
+}
+
+/// @summary Determine whether a block is free, where the metadata for the block may not have been committed.
+/// @param alloc The OS_BUDDY_ALLOCATOR to query.
+/// @param level The zero-based index of the level to which the block belongs.
+/// @param index The zero-based index of the block within the level.
+/// @return true if the block is free.
+internal_function inline bool
+OsBuddyAllocatorIsFree
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint32_t            level, 
+    uint64_t            index
+)
+{
+    OS_BUDDY_BITSET *bitset = &alloc->FreeBlocks[level];
+    return OsBuddyAllocatorIsCommitted(alloc, &bitset->Tiers[0][index >> 6]) && OsBuddyBitsetTest(bitset, index);
+}
+
+/// @summary Mark a block as free and make it available for allocation. The metadata for the block must be committed.
+/// @param alloc The OS_BUDDY_ALLOCATOR to update.
+/// @param level The zero-based index of the level to which the block belongs.
+/// @param index The zero-based index of the block within the level.
+internal_function inline void
+OsBuddyAllocatorPushFreeBlock
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint32_t            level, 
+    uint64_t            index
+)
+{
+    OsBuddyBitsetSet(&alloc->FreeBlocks[level], index);
+    alloc->LevelMask  |= 1ULL << level;
+    alloc->LevelsUsed |= 1ULL << level;
+}
+
+/// @summary Mark a free block as no longer being available for allocation.
+/// @param alloc The OS_BUDDY_ALLOCATOR to update.
+/// @param level The zero-based index of the level to which the block belongs.
+/// @param index The zero-based index of the block within the level.
+internal_function inline void
+OsBuddyAllocatorRemoveFreeBlock
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint32_t            level, 
+    uint64_t            index
+)
+{
+    OS_BUDDY_BITSET *bitset = &alloc->FreeBlocks[level];
+    OsBuddyBitsetClear(bitset, index);
+    if (bitset->Tiers[bitset->TierCount-1][0] == 0)
+    {   // the level has no remaining free blocks.
+        alloc->LevelMask &= ~(1ULL << level);
+    }
+}
+
+/// @summary Determine whether a block has been split into two smaller blocks.
+/// @param alloc The OS_BUDDY_ALLOCATOR to query.
+/// @param level The zero-based index of the level to which the block belongs. This must not be the smallest level.
+/// @param index The zero-based index of the block within the level.
+/// @return true if the block has been split.
+internal_function inline bool
+OsBuddyAllocatorIsSplit
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint32_t            level, 
+    uint64_t            index
+)
+{
+    uint64_t *word = &alloc->SplitBlocks[level][index >> 6];
+    return OsBuddyAllocatorIsCommitted(alloc, word) && (*word & (1ULL << (index & 63))) != 0;
+}
+
+/// @summary Split a block into two smaller blocks, marking the right-hand block as free. The metadata must have been committed with OsBuddyAllocatorCommitSplits.
+/// @param alloc The OS_BUDDY_ALLOCATOR to update.
+/// @param level The zero-based index of the level to which the block belongs. This must not be the smallest level.
+/// @param index The zero-based index of the block within the level.
+/// @return The zero-based index of the left-hand block within level+1.
+internal_function inline uint64_t
+OsBuddyAllocatorSplitBlock
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint32_t            level, 
+    uint64_t            index
+)
+{
+    alloc->SplitBlocks[level][index >> 6] |= (1ULL << (index & 63));
+    alloc->LevelsUsed |= 1ULL << level;
+    OsBuddyAllocatorPushFreeBlock(alloc, level + 1, (index << 1) + 1);
+    return (index << 1);
+}
+
+/// @summary Clear the split status of a block after its two halves have been merged.
+/// @param alloc The OS_BUDDY_ALLOCATOR to update.
+/// @param level The zero-based index of the level to which the block belongs. This must not be the smallest level.
+/// @param index The zero-based index of the block within the level.
+internal_function inline void
+OsBuddyAllocatorMergeBlock
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint32_t            level, 
+    uint64_t            index
+)
+{
+    alloc->SplitBlocks[level][index >> 6] &= ~(1ULL << (index & 63));
+}
+
+/// @summary Return an allocated block to the free set, merging it with its buddy for as long as the buddy is also free.
+/// @param alloc The OS_BUDDY_ALLOCATOR to update.
+/// @param level The zero-based index of the level to which the block belongs.
+/// @param index The zero-based index of the block within the level.
+/// @return The zero-based index of the level of the free block after merging.
+internal_function uint32_t
+OsBuddyAllocatorReleaseBlock
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint32_t            level, 
+    uint64_t            index
+)
+{
+    while (level > 0 && OsBuddyBitsetTest(&alloc->FreeBlocks[level], index ^ 1))
+    {
+        OsBuddyAllocatorRemoveFreeBlock(alloc, level, index ^ 1);
+        index >>= 1;
+        level  -= 1;
+        OsBuddyAllocatorMergeBlock(alloc, level, index);
+    }
+    OsBuddyAllocatorPushFreeBlock(alloc, level, index);
+    return level;
+}
+
+/// @summary Convert a power-of-two block size into the corresponding level index.
+/// @param alloc The OS_BUDDY_ALLOCATOR to query.
+/// @param pow2_size The block size, which must be a power of two between AllocationSizeMin and AllocationSizeMax.
+/// @return The zero-based index of the level with the specified block size.
+internal_function inline uint32_t
+OsBuddyAllocatorLevelForSize
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint64_t        pow2_size
+)
+{
+    return alloc->LevelBits[0] - OsBitScanReverse64(pow2_size);
+}
+
+/// @summary Retrieve information about a memory block where the corresponding level index is known.
+/// @param info The OS_BUDDY_BLOCK_INFO to populate.
+/// @param alloc The OS_BUDDY_ALLOCATOR from which the block was allocated.
+/// @param block_offset The offset of the allocation from the start of the memory range, as returned by a prior call to OsBuddyAllocate.
+/// @param level The zero-based index of the level from which the block was allocated.
+internal_function void
+OsBuddyAllocatorBlockInfo
+(
+    OS_BUDDY_BLOCK_INFO *info, 
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint64_t     block_offset,
+    uint32_t            level
+)
+{
+    uint32_t level_shift = alloc->LevelBits[level];
+    uint64_t block_index = block_offset >> level_shift;
+    info->LevelIndex     = level;
+    info->BitIndex       = level_shift;
+    info->BlockSize      = 1ULL << level_shift;
+    info->BlockOffset    = block_index << level_shift;
+    info->BlockIndex     = block_index;
+    info->BuddyIndex     = block_index ^ 1;
+}
+
+/// @summary Allocate a specific block, splitting the free block that contains it as necessary. Used to mark reserved ranges.
+/// @param alloc The OS_BUDDY_ALLOCATOR to update.
+/// @param block_offset The byte offset of the block to allocate. The block must be free or part of a larger free block.
+/// @param level The zero-based index of the level of the block to allocate.
+/// @return true if the block was allocated, or false if the metadata for the splits could not be committed.
+internal_function bool
+OsBuddyAllocatorAllocateBlockAt
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint64_t     block_offset, 
+    uint32_t            level
+)
+{   // locate the free block containing block_offset by walking down the split blocks.
+    uint32_t check = 0;
+    while (check < level && OsBuddyAllocatorIsSplit(alloc, check, block_offset >> alloc->LevelBits[check]))
+    {
+        check++;
+    }
+    uint64_t index = block_offset >> alloc->LevelBits[check];
+    assert(OsBuddyAllocatorIsFree(alloc, check, index));
+    if (!OsBuddyAllocatorCommitSplits(alloc, block_offset, check, level))
+    {   // OsBuddyAllocatorCommit output error information already.
+        return false;
+    }
+    OsBuddyAllocatorRemoveFreeBlock(alloc, check, index);
+    while (check < level)
+    {   // split the block, keeping whichever half contains block_offset.
+        uint64_t left = OsBuddyAllocatorSplitBlock(alloc, check, index);
+        uint64_t want = block_offset >> alloc->LevelBits[check+1];
+        if (want != left)
+        {   // keep the right half, and return the left half to the free set.
+            OsBuddyAllocatorRemoveFreeBlock(alloc, check + 1, want);
+            OsBuddyAllocatorPushFreeBlock(alloc, check + 1, left);
+        }
+        index = want;
+        check++;
+    }
+    return true;
+}
+
+/// @summary Initialize a buddy allocator instance.
+/// @param alloc The OS_BUDDY_ALLOCATOR to initialize.
+/// @param init Data specifying the allocator configuration.
+/// @return Zero if the allocator is initialized successfully, or -1 if an error occurred.
+public_function int
+OsCreateBuddyAllocator
+(
+    OS_BUDDY_ALLOCATOR     *alloc, 
+    OS_BUDDY_ALLOCATOR_INIT *init
+)
+{
+    if ((init->AllocationSizeMin & (init->AllocationSizeMin-1)) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): Buddy allocator requires Pow2 AllocationSizeMin.\n", __FUNCTION__, OsThreadId());
+        assert((init->AllocationSizeMin & (init->AllocationSizeMin-1)) == 0);
+        return -1;
+    }
+    if ((init->AllocationSizeMax & (init->AllocationSizeMax-1)) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): Buddy allocator requires Pow2 AllocationSizeMax.\n", __FUNCTION__, OsThreadId());
+        assert((init->AllocationSizeMax & (init->AllocationSizeMax-1)) == 0);
+        return -1;
+    }
+    if (init->AllocationSizeMin < 16)
+    {
+        OsLayerError("ERROR: %S(%u): Buddy allocator requires AllocationSizeMin >= 16 bytes.\n", __FUNCTION__, OsThreadId());
+        assert(init->AllocationSizeMin >= 16);
+        return -1;
+    }
+    if (init->AllocationSizeMax <= init->AllocationSizeMin)
+    {
+        OsLayerError("ERROR: %S(%u): Maximum allocation size %I64u must be larger than minimum size %I64u.\n", __FUNCTION__, OsThreadId(), init->AllocationSizeMax, init->AllocationSizeMin);
+        assert(init->AllocationSizeMax > init->AllocationSizeMin);
+        return -1;
+    }
+    if (init->BytesReserved >= init->AllocationSizeMax)
+    {
+        OsLayerError("ERROR: %S(%u): Bytes reserved %I64u exceeds maximum allocation size %I64u.\n", __FUNCTION__, OsThreadId(), init->BytesReserved, init->AllocationSizeMax);
+        assert(init->BytesReserved < init->AllocationSizeMax);
+        return -1;
+    }
+
+    // figure out the number of levels and ensure the count doesn't exceed the limit.
+    uint32_t     min_bit = OsBitScanReverse64(init->AllocationSizeMin);
+    uint32_t     max_bit = OsBitScanReverse64(init->AllocationSizeMax);
+    uint32_t level_count = max_bit - min_bit + 1;
+    if (level_count > OS_BUDDY_ALLOCATOR::MAX_LEVELS)
+    {   // need to adjust AllocationSizeMax/AllocationSizeMin.
+        OsLayerError("ERROR: %S(%u): Level count %u exceeds maximum %Iu.\n", __FUNCTION__, OsThreadId(), level_count, OS_BUDDY_ALLOCATOR::MAX_LEVELS);
+        assert(level_count <= OS_BUDDY_ALLOCATOR::MAX_LEVELS);
+        return -1;
+    }
+
+    // determine the required size of the allocator metadata, and reserve it as one contiguous chunk.
+    // level i has 1 << i blocks, each with a free bit and, for all but the smallest level, a split bit.
+    // the metadata is preceded by a bitmap with one bit per page, tracking which pages have been committed.
+    size_t       page_size = 0;
+    size_t     granularity = 0;
+    size_t     metadata_nw = 0;
+    size_t      metadata_n = 0;
+    size_t       commit_nw = 0;
+    size_t       commit_n  = 0;
+    uint64_t     *metadata = NULL;
+    for (uint32_t level_index = 0; level_index < level_count; ++level_index)
+    {
+        uint64_t block_count = 1ULL << level_index;
+        uint32_t  tier_count = 0;
+        metadata_nw += OsBuddyBitsetWordCount(block_count, tier_count);
+        if (level_index != level_count - 1)
+            metadata_nw += (size_t)((block_count + 63) / 64);
+    }
+    OsVmmQueryPageSize(page_size, granularity);
+    for ( ; ; )
+    {   // the commit bitmap covers its own pages, so grow it until it is large enough.
+        size_t page_count;
+        metadata_n = OsAlignUp((commit_nw + metadata_nw) * sizeof(uint64_t), page_size);
+        page_count = metadata_n / page_size;
+        if (commit_nw * 64 >= page_count)
+            break;
+        commit_nw  = (page_count + 63) / 64;
+    }
+    commit_n = OsAlignUp(commit_nw * sizeof(uint64_t), page_size);
+    if (!OsMemoryBudgetCharge((int64_t) commit_n))
+    {   // OsMemoryBudgetCharge output error information already.
+        return -1;
+    }
+    if ((metadata = (uint64_t*) OsVmmReserve(metadata_n, commit_n, 0, OsVmmPageProtection(OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE), OS_HOST_MEMORY_NUMA_POLICY_DEFAULT, 0)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to reserve %Iu bytes for buddy allocator metadata.\n", __FUNCTION__, OsThreadId(), metadata_n);
+        OsMemoryBudgetCharge(-(int64_t) commit_n);
+        return -1;
+    }
+
+    // initialize the simple allocator properties.
+    alloc->AllocationSizeMin = init->AllocationSizeMin;
+    alloc->AllocationSizeMax = init->AllocationSizeMax;
+    alloc->BytesReserved     = init->BytesReserved;
+    alloc->MetadataBase      =(uint8_t *) metadata;
+    alloc->MetadataSize      = metadata_n;
+    alloc->MetadataCommitted = commit_n;
+    alloc->MetadataCommitMap = metadata;
+    alloc->MetadataPageShift = OsBitScanReverse64(page_size);
+    alloc->LevelsUsed        = 0;
+    alloc->LevelMask         = 0;
+    alloc->LevelCount        = level_count;
+    alloc->AllocationCount   = 0;
+    alloc->FreeCount         = 0;
+    alloc->FailedCount       = 0;
+
+    // mark the pages holding the commit bitmap as committed.
+    for (size_t page = 0; page < commit_n / page_size; ++page)
+    {
+        alloc->MetadataCommitMap[page >> 6] |= 1ULL << (page & 63);
+    }
+
+    // carve the per-level bitsets out of the metadata storage.
+    metadata += commit_nw;
+    for (uint32_t level_index = 0; level_index < OS_BUDDY_ALLOCATOR::MAX_LEVELS; ++level_index)
+    {
+        if (level_index < level_count)
+        {
+            uint64_t block_count = 1ULL << level_index;
+            alloc->LevelBits[level_index] = max_bit - level_index;
+            metadata += OsBuddyBitsetInit(&alloc->FreeBlocks[level_index], block_count, metadata);
+            if (level_index != level_count - 1)
+            {
+                alloc->SplitBlocks[level_index] = metadata;
+                metadata += (size_t)((block_count + 63) / 64);
+            }
+            else alloc->SplitBlocks[level_index] = NULL;
+        }
+        else
+        {
+            OsZeroMemory(&alloc->FreeBlocks[level_index], sizeof(OS_BUDDY_BITSET));
+            alloc->LevelBits  [level_index] = 0;
+            alloc->SplitBlocks[level_index] = NULL;
+        }
+    }
+
+    // the single word in the top tier of each bitset is read without checking whether it is committed.
+    for (uint32_t level_index = 0; level_index < level_count; ++level_index)
+    {
+        OS_BUDDY_BITSET *bitset = &alloc->FreeBlocks[level_index];
+        if (!OsBuddyAllocatorCommit(alloc, bitset->Tiers[bitset->TierCount - 1]))
+        {   // OsBuddyAllocatorCommit output error information already.
+            OsDeleteBuddyAllocator(alloc);
+            return -1;
+        }
+    }
+
+    // establish the initial state - a single free block at level 0.
+    OsBuddyReset(alloc);
+    if (alloc->LevelMask == 0)
+    {   // OsBuddyReset output error information already.
+        OsDeleteBuddyAllocator(alloc);
+        return -1;
+    }
+    return 0;
+}
+
+/// @summary Free all resources associated with an OS_BUDDY_ALLOCATOR instance.
+/// @param alloc The OS_BUDDY_ALLOCATOR to delete.
+public_function void
+OsDeleteBuddyAllocator
+(
+    OS_BUDDY_ALLOCATOR *alloc
+)
+{
+    if (alloc->MetadataBase != NULL)
+    {
+        OsVmmRelease(alloc->MetadataBase, alloc->MetadataSize);
+        OsMemoryBudgetCharge(-(int64_t) alloc->MetadataCommitted);
+    }
+    OsZeroMemory(alloc, sizeof(OS_BUDDY_ALLOCATOR));
+}
+
+/// @summary Retrieve information about a memory block where the corresponding level is not known.
+/// @param info The OS_BUDDY_BLOCK_INFO to populate.
+/// @param alloc The OS_BUDDY_ALLOCATOR from which the block was allocated.
+/// @param block_offset The offset of the allocation from the start of the memory range, as returned by a prior call to OsBuddyAllocate.
+/// @return true if the offset block_offset specifies the start of an allocated block and info was populated with data.
+public_function bool
+OsBuddyAllocatorBlockInfo
+(
+    OS_BUDDY_BLOCK_INFO *info, 
+    OS_BUDDY_ALLOCATOR *alloc, 
+    uint64_t     block_offset
+)
+{
+    if (block_offset >= alloc->AllocationSizeMax)
+    {   // the offset is outside of the managed range.
+        return false;
+    }
+    // the block level is the first level, starting from the largest, at which the containing block is not split.
+    uint32_t level_index = 0;
+    while   (level_index < alloc->LevelCount - 1 && OsBuddyAllocatorIsSplit(alloc, level_index, block_offset >> alloc->LevelBits[level_index]))
+    {
+        level_index++;
+    }
+    OsBuddyAllocatorBlockInfo(info, alloc, block_offset, level_index);
+    if (info->BlockOffset != block_offset || OsBuddyAllocatorIsFree(alloc, level_index, info->BlockIndex))
+    {   // the offset doesn't specify the start of an allocated block.
+        return false;
+    }
+    return true;
+}
+
+/// @summary Allocate memory from a buddy allocator.
+/// @param alloc The OS_BUDDY_ALLOCATOR managing the memory.
+/// @param size The number of bytes being requested.
+/// @param alignment The required alignment of the returned block offset.
+/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region.
+/// @return true if the allocator satisfied the request.
+public_function bool
+OsBuddyAllocate
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    size_t               size, 
+    size_t          alignment, 
+    OS_MEMORY_RANGE    &range
+)
+{
+    if (size < alignment)
+    {   // round upwards to the requested alignment. blocks are aligned to their size.
+        size = alignment;
+    }
+    if (size < alloc->AllocationSizeMin)
+    {   // round up to the minimum possible block size.
+        size =(size_t) alloc->AllocationSizeMin;
+    }
+    if (size > alloc->AllocationSizeMax)
+    {
+        OsLayerError("ERROR: %S(%u): Allocation request for %Iu bytes exceeds maximum of %I64u bytes.\n", __FUNCTION__, OsThreadId(), size, alloc->AllocationSizeMax);
+        assert(size <= alloc->AllocationSizeMax);
+        range.ByteOffset  = 0;
+        range.SizeInBytes = 0;
+        alloc->FailedCount++;
+        return false;
+    }
+
+    uint64_t pow2_size = OsNextPowerOfTwoGreaterOrEqual(size);
+    uint32_t level_idx = OsBuddyAllocatorLevelForSize(alloc, pow2_size);
+    // select the smallest free block at least as large as the request - the 
+    // highest-numbered level with a free block, at or above level_idx.
+    uint64_t level_set = alloc->LevelMask & ((2ULL << level_idx) - 1);
+    if (level_set != 0)
+    {   // take the first free block from the level with the smallest suitable blocks.
+        uint32_t check_idx = OsBitScanReverse64(level_set);
+        uint64_t block_idx = 0;
+        OsBuddyBitsetFindFirst(&alloc->FreeBlocks[check_idx], block_idx);
+        if (!OsBuddyAllocatorCommitSplits(alloc, block_idx << alloc->LevelBits[check_idx], check_idx, level_idx))
+        {   // OsBuddyAllocatorCommit output error information already.
+            range.ByteOffset  = 0;
+            range.SizeInBytes = 0;
+            alloc->FailedCount++;
+            return false;
+        }
+        OsBuddyAllocatorRemoveFreeBlock(alloc, check_idx, block_idx);
+        while (check_idx < level_idx)
+        {   // split the block, keeping the left half and freeing the right half.
+            block_idx = OsBuddyAllocatorSplitBlock(alloc, check_idx, block_idx);
+            check_idx++;
+        }
+        range.ByteOffset  =(size_t)(block_idx << alloc->LevelBits[level_idx]);
+        range.SizeInBytes =(size_t) pow2_size;
+        alloc->AllocationCount++;
+        alloc->BytesLive += pow2_size;
+        if (alloc->BytesLive > alloc->BytesPeak)
+            alloc->BytesPeak = alloc->BytesLive;
+        OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_ALLOCATE, range.ByteOffset, pow2_size, alignment);
+        return true;
+    }
+    // there is no free block that can satisfy the allocation.
+    range.ByteOffset  = 0;
+    range.SizeInBytes = 0;
+    alloc->FailedCount++;
+    return false;
+}
+
+/// @summary Grow or shrink a memory block to meet a desired size.
+/// @param alloc The OS_BUDDY_ALLOCATOR managing the allocated range.
+/// @param existing An OS_MEMORY_RANGE describing the existing allocation.
+/// @param new_size The new required minimum allocation size, in bytes.
+/// @param alignment The required alignment of the returned block offset.
+/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region, which may or may not be the same as the existing region.
+/// @return true if the allocator satisfied the request.
+public_function bool
+OsBuddyReallocate
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    OS_MEMORY_RANGE  existing, 
+    size_t           new_size, 
+    size_t          alignment,
+    OS_MEMORY_RANGE    &range
+)
+{
+    if (existing.SizeInBytes == 0)
+    {   // there is no existing allocation, so this is equivalent to calling OsBuddyAllocate.
+        return OsBuddyAllocate(alloc, new_size, alignment, range);
+    }
+    if (new_size < alignment)
+    {   // round upwards to the requested alignment.
+        new_size = alignment;
+    }
+    if (new_size < alloc->AllocationSizeMin)
+    {   // round up to the minimum possible block size.
+        new_size =(size_t) alloc->AllocationSizeMin;
+    }
+    if (new_size > alloc->AllocationSizeMax)
+    {
+        OsLayerError("ERROR: %S(%u): Reallocation request for %Iu bytes exceeds maximum of %I64u bytes.\n", __FUNCTION__, OsThreadId(), new_size, alloc->AllocationSizeMax);
+        assert(new_size <= alloc->AllocationSizeMax);
+        range.ByteOffset  = 0;
+        range.SizeInBytes = 0;
+        alloc->FailedCount++;
+        return false;
+    }
+
+    // there are four scenarios this routine has to account for:
+    // 1. The new_size still fits in the same block. No re-allocation is performed.
+    // 2. The new_size fits in a block one level larger, the existing block is the left half of its parent, and the buddy block is free. The buddy block is allocated, and the buddy pair is merged. No copying is required.
+    // 3. The new_size is smaller than the old size by one or more levels. The existing block is demoted to a smaller block. No copying is required.
+    // 4. Otherwise, a new, larger block is allocated and the existing block is freed. The caller must copy the data from the old to the new block.
+    uint64_t existing_size = existing.SizeInBytes < alloc->AllocationSizeMin ? alloc->AllocationSizeMin : existing.SizeInBytes;
+    uint64_t pow2_size_old = OsNextPowerOfTwoGreaterOrEqual((size_t) existing_size);
+    uint64_t pow2_size_new = OsNextPowerOfTwoGreaterOrEqual(new_size);
+    uint32_t level_idx_old = OsBuddyAllocatorLevelForSize(alloc, pow2_size_old);
+    uint32_t level_idx_new = OsBuddyAllocatorLevelForSize(alloc, pow2_size_new);
+    uint64_t block_idx     = existing.ByteOffset >> alloc->LevelBits[level_idx_old];
+    
+    if (level_idx_new == level_idx_old)
+    {   // case 1: the new_size fits in the same block. don't do anything.
+        range.ByteOffset  = existing.ByteOffset;
+        range.SizeInBytes =(size_t) pow2_size_new;
+        return true;
+    }
+    if (level_idx_new == (level_idx_old - 1) && (block_idx & 1) == 0)
+    {   // case 2: see if the buddy is free, and if so, promote the existing block.
+        if (OsBuddyBitsetTest(&alloc->FreeBlocks[level_idx_old], block_idx + 1))
+        {   // the buddy block is free - merge it with the existing block.
+            OsBuddyAllocatorRemoveFreeBlock(alloc, level_idx_old, block_idx + 1);
+            OsBuddyAllocatorMergeBlock(alloc, level_idx_new, block_idx >> 1);
+            range.ByteOffset  = existing.ByteOffset;
+            range.SizeInBytes =(size_t) pow2_size_new;
+            alloc->BytesLive += pow2_size_new - pow2_size_old;
+            if (alloc->BytesLive > alloc->BytesPeak)
+                alloc->BytesPeak = alloc->BytesLive;
+            OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_REALLOCATE, range.ByteOffset, pow2_size_new, alignment);
+            return true;
+        }
+    }
+    if (level_idx_new > level_idx_old)
+    {   // case 3: demote the existing block to a smaller size, freeing the right half at each level.
+        if (!OsBuddyAllocatorCommitSplits(alloc, existing.ByteOffset, level_idx_old, level_idx_new))
+        {   // the existing block is large enough, so keep it as-is.
+            range.ByteOffset  = existing.ByteOffset;
+            range.SizeInBytes =(size_t) pow2_size_old;
+            return true;
+        }
+        while (level_idx_old < level_idx_new)
+        {
+            block_idx = OsBuddyAllocatorSplitBlock(alloc, level_idx_old, block_idx);
+            level_idx_old++;
+        }
+        range.ByteOffset  = existing.ByteOffset;
+        range.SizeInBytes =(size_t) pow2_size_new;
+        alloc->BytesLive -= pow2_size_old - pow2_size_new;
+        OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_REALLOCATE, range.ByteOffset, pow2_size_new, alignment);
+        return true;
+    }
+
+    // case 4: no choice but to allocate a new block and free the old block.
+    if (OsBuddyAllocate(alloc, new_size, alignment, range))
+    {   // the new block was successfully allocated, so mark the old block as free.
+        OsBuddyFree(alloc, existing);
+        return true;
+    }
+    // else, there is no free block that can satisfy the allocation.
+    range.ByteOffset  = 0;
+    range.SizeInBytes = 0;
+    return false;
+}
+
+/// @summary Retrieve the size for a given byte offset returned by the allocator.
+/// @param alloc The OS_BUDDY_ALLOCATOR from which the memory was allocated.
+/// @param block_offset A memory block offset returned by a prior call to OsBuddyAllocate or OsBuddyReallocate.
+/// @return The size of the specified block, in bytes, or 0 if the specified block offset is invalid.
+public_function size_t
+OsBuddyBlockSize
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    size_t       block_offset
+)
+{
+    OS_BUDDY_BLOCK_INFO info;
+    if (OsBuddyAllocatorBlockInfo(&info, alloc, (uint64_t) block_offset))
+        return (size_t) info.BlockSize;
+    else
+        return 0;
+}
+
+/// @summary Free a previously allocated memory range.
+/// @param alloc The OS_BUDDY_ALLOCATOR that returned the memory range.
+/// @param range The block offset and size returned by a prior call to OsBuddyAllocate or OsBuddyReallocate.
+public_function void
+OsBuddyFree
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    OS_MEMORY_RANGE     range
+)
+{
+    if (range.SizeInBytes > 0)
+    {   // ensure that the specified size is at least the minimum allocation size.
+        if (range.SizeInBytes < alloc->AllocationSizeMin)
+            range.SizeInBytes =(size_t) alloc->AllocationSizeMin;
+
+        // convert the supplied size to a level index.
+        uint64_t pow2_size = OsNextPowerOfTwoGreaterOrEqual(range.SizeInBytes);
+        uint32_t level_idx = OsBuddyAllocatorLevelForSize(alloc, pow2_size);
+        uint64_t block_idx = range.ByteOffset >> alloc->LevelBits[level_idx];
+        assert(!OsBuddyBitsetTest(&alloc->FreeBlocks[level_idx], block_idx) && "Double free in OsBuddyFree");
+        alloc->FreeCount++;
+        alloc->BytesLive -= pow2_size;
+        OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_FREE, range.ByteOffset, pow2_size, 0);
+        OsBuddyAllocatorReleaseBlock(alloc, level_idx, block_idx);
+    }
+}
+
+/// @summary Reset a buddy allocator back to its initial state, invalidating all existing allocations.
+/// Only the committed metadata of levels written since the last reset is cleared. Committed metadata is retained for reuse.
+/// @param alloc The OS_BUDDY_ALLOCATOR to reset.
+public_function void
+OsBuddyReset
+(
+    OS_BUDDY_ALLOCATOR *alloc
+)
+{   // return the free and split bitsets to their initial state.
+    size_t   page_size = (size_t) 1 << alloc->MetadataPageShift;
+    uint64_t levels    = alloc->LevelsUsed;
+    uint8_t *metadata_end = alloc->MetadataBase + alloc->MetadataSize;
+    while (levels != 0)
+    {   // the metadata for a level extends from its free bitset to the free bitset of the next level.
+        uint32_t level = OsBitScanForward64(levels);
+        uint8_t *start =(uint8_t*) alloc->FreeBlocks[level].Tiers[0];
+        uint8_t *end   =(level + 1 < alloc->LevelCount) ? (uint8_t*) alloc->FreeBlocks[level + 1].Tiers[0] : metadata_end;
+        while (start < end)
+        {   // pages that were never committed contain only zero bits.
+            uint8_t *page_end = alloc->MetadataBase + OsAlignUp((size_t)(start - alloc->MetadataBase) + 1, page_size);
+            uint8_t *run_end  = page_end < end ? page_end : end;
+            if (OsBuddyAllocatorIsCommitted(alloc, start))
+            {
+                OsZeroMemory(start, (size_t)(run_end - start));
+            }
+            start = run_end;
+        }
+        levels &= levels - 1;
+    }
+    alloc->LevelsUsed = 0;
+    alloc->LevelMask  = 0;
+    alloc->BytesLive  = 0;
+    alloc->BytesPeak  = 0;
+
+    // mark the single block at level 0 (the largest level) as free.
+    OsBuddyAllocatorPushFreeBlock(alloc, 0, 0);
+
+    // sometimes the requirement of AllocationSizeMax being a power-of-two leads 
+    // to signficant memory waste, so allow the caller to specify a BytesReserved
+    // value to mark a portion of the memory as unusable.
+    if (alloc->BytesReserved > 0)
+    {   // cover [0, BytesReserved) with the fewest possible blocks, largest first.
+        uint32_t leaf_level = alloc->LevelCount - 1;
+        uint64_t reserve_end= OsAlignUp((size_t) alloc->BytesReserved, (size_t) alloc->AllocationSizeMin);
+        uint64_t offset     = 0;
+        while   (offset < reserve_end)
+        {
+            uint32_t level  = leaf_level;
+            while   (level  > 0)
+            {   // try the next-larger block; it must start at offset and end within the reserved range.
+                uint64_t parent_size = 1ULL << alloc->LevelBits[level-1];
+                if ((offset & (parent_size - 1)) != 0 || (offset + parent_size) > reserve_end)
+                    break;
+                level--;
+            }
+            if (!OsBuddyAllocatorAllocateBlockAt(alloc, offset, level))
+            {   // the reserved range could not be covered; leave nothing available for allocation.
+                OsLayerError("ERROR: %S(%u): Failed to commit buddy allocator metadata to mark %I64u reserved bytes.\n", __FUNCTION__, OsThreadId(), alloc->BytesReserved);
+                alloc->LevelMask = 0;
+                return;
+            }
+            offset += 1ULL << alloc->LevelBits[level];
+        }
+    }
+}
+
+/// @summary Retrieve statistics for a buddy allocator.
+/// @param alloc The OS_BUDDY_ALLOCATOR to query.
+/// @param stats On return, the statistics for the allocator.
+public_function void
+OsBuddyAllocatorQueryStats
+(
+    OS_BUDDY_ALLOCATOR *alloc, 
+    OS_ALLOCATOR_STATS *stats
+)
+{
+    uint64_t reserved = alloc->BytesReserved > 0 ? OsAlignUp((size_t) alloc->BytesReserved, (size_t) alloc->AllocationSizeMin) : 0;
+    stats->AllocationCount  = alloc->AllocationCount;
+    stats->FreeCount        = alloc->FreeCount;
+    stats->FailedCount      = alloc->FailedCount;
+    stats->BytesLive        = alloc->BytesLive;
+    stats->BytesPeak        = alloc->BytesPeak;
+    stats->BytesFree        = alloc->AllocationSizeMax - reserved - alloc->BytesLive;
+    stats->LargestFreeBlock = alloc->LevelMask != 0 ? (1ULL << alloc->LevelBits[OsBitScanForward64(alloc->LevelMask)]) : 0;
+    stats->BytesReserved    = alloc->AllocationSizeMax;
+    stats->BytesCommitted   = 0;
+    stats->CommitCount      = 0;
+}
+
+/// @summary Move every live block within a buddy block to the mirrored position within a free block of the same size, so that the source block becomes free.
+/// Each live block is moved individually, and the allocator state is consistent after each move, so the operation can stop at any point.
+/// @param alloc The OS_BUDDY_ALLOCATOR being compacted.
+/// @param level The zero-based index of the level of the source and destination blocks.
+/// @param src_idx The zero-based index of the source block within the level. The block may be live or split.
+/// @param dst_idx The zero-based index of the free destination block within the level.
+/// @param relocate The callback invoked to move each live block.
+/// @param context Opaque data passed through to the relocate callback.
+/// @param max_bytes The maximum number of bytes to move during the current compaction pass.
+/// @param result The statistics for the current compaction pass, updated as blocks are moved.
+/// @param probes The number of blocks examined during the current compaction pass, updated as blocks are examined.
+/// @return Zero if the source block is now free, 1 if the callback declined to move a block, or -1 if the budget for the pass was exhausted or the metadata for a move could not be committed.
+internal_function int
+OsBuddyCompactBlock
+(
+    OS_BUDDY_ALLOCATOR          *alloc, 
+    uint32_t                     level, 
+    uint64_t                   src_idx, 
+    uint64_t                   dst_idx, 
+    OS_BUDDY_RELOCATE_FUNC    relocate, 
+    void                      *context, 
+    uint64_t                 max_bytes, 
+    OS_BUDDY_COMPACT_RESULT    *result, 
+    size_t                     &probes
+)
+{
+    uint32_t leaf_level = alloc->LevelCount - 1;
+    uint32_t level_bits = alloc->LevelBits[level];
+    uint64_t   src_base = src_idx << level_bits;
+    uint64_t   dst_base = dst_idx << level_bits;
+    uint64_t    src_end = src_base + (1ULL << level_bits);
+    uint64_t     offset = src_base;
+
+    while (offset < src_end)
+    {   // locate the block containing offset - the first level at which the block is not split.
+        uint32_t sub_level = level;
+        while   (sub_level < leaf_level && OsBuddyAllocatorIsSplit(alloc, sub_level, offset >> alloc->LevelBits[sub_level]))
+        {
+            sub_level++;
+        }
+        uint32_t  sub_bits = alloc->LevelBits[sub_level];
+        uint64_t  sub_size = 1ULL << sub_bits;
+        uint64_t   sub_idx = offset >> sub_bits;
+        if (!OsBuddyAllocatorIsFree(alloc, sub_level, sub_idx))
+        {   // the block is live; claim the mirrored block in the destination and move it there.
+            uint64_t target = dst_base + ((sub_idx << sub_bits) - src_base);
+            if (++probes > OS_BUDDY_ALLOCATOR::MAX_COMPACT_PROBES)
+                return -1;
+            if (result->BlocksMoved > 0 && (result->BytesMoved + sub_size) > max_bytes)
+                return -1;
+            if (!OsBuddyAllocatorAllocateBlockAt(alloc, target, sub_level))
+                return -1;
+            if (!relocate(context, sub_idx << sub_bits, target, sub_size))
+            {   // the block is pinned. return the destination block to the free set.
+                OsBuddyAllocatorReleaseBlock(alloc, sub_level, target >> sub_bits);
+                result->BlocksPinned++;
+                return 1;
+            }
+            OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_ALLOCATE, target, sub_size, 0);
+            OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_FREE    , sub_idx << sub_bits, sub_size, 0);
+            result->BlocksMoved++;
+            result->BytesMoved += sub_size;
+            if (OsBuddyAllocatorReleaseBlock(alloc, sub_level, sub_idx) <= level)
+            {   // the last live block was moved, and the source block has merged into a free block.
+                return 0;
+            }
+        }
+        // advance to the end of the block. releasing the block may have merged it into a larger free block, which is skipped when next examined.
+        offset = (sub_idx + 1) << sub_bits;
+    }
+    return 0;
+}
+
+/// @summary Perform a bounded, incremental compaction pass over a buddy allocator, moving live blocks so that free blocks can merge.
+/// Each level is processed from the smallest block size to the largest. Within a level, the live contents of the buddy of the highest 
+/// free block are moved into the lowest free block, after which the vacated buddy merges with the free block. Blocks only ever move 
+/// towards lower offsets, so repeated passes converge, with free space accumulating in large blocks at the end of the range. Call 
+/// repeatedly, for example once per frame from a background task, until the function returns true. The allocator must not be used 
+/// by other threads during the call.
+/// @param alloc The OS_BUDDY_ALLOCATOR to compact.
+/// @param relocate The callback invoked to move each live block.
+/// @param context Opaque data passed through to the relocate callback.
+/// @param max_bytes The maximum number of bytes to move during this call. At least one block is always moved if a move is possible.
+/// @param result On return, the statistics for the pass.
+/// @return true if the pass completed without moving any blocks, meaning no further compaction is possible, or false if more work remains.
+public_function bool
+OsBuddyCompact
+(
+    OS_BUDDY_ALLOCATOR         *alloc, 
+    OS_BUDDY_RELOCATE_FUNC   relocate, 
+    void                     *context, 
+    uint64_t                max_bytes, 
+    OS_BUDDY_COMPACT_RESULT   *result
+)
+{
+    size_t probes = 0;
+
+    OsZeroMemory(result, sizeof(OS_BUDDY_COMPACT_RESULT));
+    for (uint32_t level = alloc->LevelCount - 1; level > 0; --level)
+    {   // level 0 is a single block, which has no buddy to merge with.
+        OS_BUDDY_BITSET *free_set = &alloc->FreeBlocks[level];
+        uint64_t            limit = 1ULL << level;
+        uint64_t          dst_idx = 0;
+        uint64_t         hole_idx = 0;
+        while (OsBuddyBitsetFindFirst(free_set, dst_idx) && OsBuddyBitsetFindLastBefore(free_set, limit, hole_idx) && hole_idx > dst_idx)
+        {   // the buddy of a free block is never free, or the two would have merged.
+            if (++probes > OS_BUDDY_ALLOCATOR::MAX_COMPACT_PROBES)
+                return false;
+            if (OsBuddyCompactBlock(alloc, level, hole_idx ^ 1, dst_idx, relocate, context, max_bytes, result, probes) < 0)
+                return false;
+            limit = hole_idx;
+        }
+    }
+    result->Complete = result->BlocksMoved == 0;
+    return result->Complete;
+}
+
+/// @summary Discard the contents of a thread cache if the allocator has been reset since the cache was last filled.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR associated with the cache.
+/// @param cache The OS_BUDDY_THREAD_CACHE to validate.
+internal_function inline void
+OsConcurrentBuddyValidateCache
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    OS_BUDDY_THREAD_CACHE         *cache
+)
+{
+    uint32_t generation = alloc->Generation.load(std::memory_order_acquire);
+    if (cache->Generation != generation)
+    {   // the allocator was reset; any cached blocks are no longer valid.
+        OsZeroMemory(cache->Count, sizeof(cache->Count));
+        cache->Generation = generation;
+    }
+}
+
+/// @summary Return a set of blocks held in a cache or depot to the underlying buddy allocator, merging them with their buddies where possible.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR that owns the blocks.
+/// @param level_index The zero-based index of the level the blocks belong to.
+/// @param blocks The byte offsets of the blocks to return.
+/// @param block_count The number of blocks to return.
+internal_function void
+OsConcurrentBuddyMergeBlocks
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    uint32_t                 level_index, 
+    uint64_t const               *blocks, 
+    size_t                   block_count
+)
+{
+    OS_MEMORY_RANGE range;
+    range.SizeInBytes  =(size_t)(1ULL << alloc->Tree.LevelBits[level_index]);
+    OsLockMutex(&alloc->TreeLock);
+    {
+        for (size_t i = 0; i < block_count; ++i)
+        {
+            range.ByteOffset = (size_t) blocks[i];
+            OsBuddyFree(&alloc->Tree, range);
+        }
+    }
+    OsUnlockMutex(&alloc->TreeLock);
+}
+
+/// @summary Move a set of free blocks into the depot for a level. If the depot would overflow, half of its contents are returned to the underlying allocator.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR that owns the blocks.
+/// @param cache_slot The zero-based index of the cached level, such that the level index is FirstCachedLevel + cache_slot.
+/// @param blocks The byte offsets of the blocks to store.
+/// @param block_count The number of blocks to store. This value must not exceed OS_BUDDY_LEVEL_DEPOT::CAPACITY / 2.
+internal_function void
+OsConcurrentBuddyDepotPush
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    uint32_t                  cache_slot, 
+    uint64_t const               *blocks, 
+    size_t                   block_count
+)
+{
+    OS_BUDDY_LEVEL_DEPOT *depot = &alloc->Depots[cache_slot];
+    uint64_t              evict[OS_BUDDY_LEVEL_DEPOT::CAPACITY / 2];
+    size_t          evict_count = 0;
+    assert(block_count <= OS_BUDDY_LEVEL_DEPOT::CAPACITY / 2);
+    OsLockMutex(&depot->Lock);
+    {
+        if (depot->Count + block_count > OS_BUDDY_LEVEL_DEPOT::CAPACITY)
+        {   // evict the oldest blocks; they're merged outside of the depot lock.
+            evict_count   = OS_BUDDY_LEVEL_DEPOT::CAPACITY / 2;
+            OsCopyMemory(evict, depot->Blocks, evict_count * sizeof(uint64_t));
+            OsMoveMemory(depot->Blocks, depot->Blocks + evict_count, (depot->Count - evict_count) * sizeof(uint64_t));
+            depot->Count -=(uint32_t) evict_count;
+        }
+        OsCopyMemory(depot->Blocks + depot->Count, blocks, block_count * sizeof(uint64_t));
+        depot->Count += (uint32_t) block_count;
+    }
+    OsUnlockMutex(&depot->Lock);
+
+    if (evict_count > 0)
+    {   // perform the deferred merge of the evicted blocks.
+        OsConcurrentBuddyMergeBlocks(alloc, alloc->FirstCachedLevel + cache_slot, evict, evict_count);
+    }
+}
+
+/// @summary Remove up to a given number of free blocks from the depot for a level.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR that owns the depot.
+/// @param cache_slot The zero-based index of the cached level, such that the level index is FirstCachedLevel + cache_slot.
+/// @param blocks On return, the byte offsets of the blocks removed from the depot are written here.
+/// @param max_blocks The maximum number of blocks to remove.
+/// @return The number of blocks written to the blocks array.
+internal_function size_t
+OsConcurrentBuddyDepotPop
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    uint32_t                  cache_slot, 
+    uint64_t                     *blocks, 
+    size_t                    max_blocks
+)
+{
+    OS_BUDDY_LEVEL_DEPOT *depot = &alloc->Depots[cache_slot];
+    size_t                count = 0;
+    OsLockMutex(&depot->Lock);
+    {   // take the most recently returned blocks first.
+        count = depot->Count < max_blocks ? depot->Count : max_blocks;
+        depot->Count -= (uint32_t) count;
+        OsCopyMemory(blocks, depot->Blocks + depot->Count, count * sizeof(uint64_t));
+    }
+    OsUnlockMutex(&depot->Lock);
+    return count;
+}
+
+/// @summary Return all blocks held in the level depots to the underlying buddy allocator, merging them with their buddies where possible.
+/// The caller must hold TreeLock.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR to drain.
+/// @return The number of blocks returned to the underlying allocator.
+internal_function size_t
+OsConcurrentBuddyDrainDepots
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc
+)
+{
+    OS_MEMORY_RANGE range;
+    size_t          total = 0;
+    for (uint32_t slot = 0; slot < alloc->CachedLevelCount; ++slot)
+    {
+        OS_BUDDY_LEVEL_DEPOT *depot = &alloc->Depots[slot];
+        range.SizeInBytes =(size_t)(1ULL << alloc->Tree.LevelBits[alloc->FirstCachedLevel + slot]);
+        OsLockMutex(&depot->Lock);
         {
-            OsLayerError("ERROR: %S(%u): Unable to construct * filter string for path %s.\n", __FUNCTION__, GetCurrentThreadId(), buf);
-            return chunk;
+            for (uint32_t i = 0; i < depot->Count; ++i)
+            {
+                range.ByteOffset = (size_t) depot->Blocks[i];
+                OsBuddyFree(&alloc->Tree, range);
+            }
+            total       += depot->Count;
+            depot->Count = 0;
         }
-        if ((find_handle = FindFirstFileEx(buf, FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH)) == INVALID_HANDLE_VALUE)
-        {
-            OsLayerError("ERROR: %S(%u): Search filter %s failed (%08X).\n", __FUNCTION__, GetCurrentThreadId(), buf, GetLastError());
-            return chunk;
+        OsUnlockMutex(&depot->Lock);
+    }
+    return total;
+}
+
+/// @summary Allocate a block from the underlying buddy allocator. If no block is available, the level depots are drained and the allocation is retried.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR managing the memory.
+/// @param size The number of bytes being requested.
+/// @param alignment The required alignment of the returned block offset.
+/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region.
+/// @return true if the allocator satisfied the request.
+internal_function bool
+OsConcurrentBuddyTreeAllocate
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    size_t                          size, 
+    size_t                     alignment, 
+    OS_MEMORY_RANGE               &range
+)
+{
+    bool result = false;
+    OsLockMutex(&alloc->TreeLock);
+    {
+        if ((result = OsBuddyAllocate(&alloc->Tree, size, alignment, range)) == false)
+        {   // free blocks may be sitting in the depots, unmerged.
+            if (OsConcurrentBuddyDrainDepots(alloc) > 0)
+                result = OsBuddyAllocate(&alloc->Tree, size, alignment, range);
         }
-        do
+    }
+    OsUnlockMutex(&alloc->TreeLock);
+    return result;
+}
+
+/// @summary Refill a thread cache for a level, first from the depot for the level, and then from the underlying buddy allocator.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR managing the memory.
+/// @param cache The OS_BUDDY_THREAD_CACHE to refill.
+/// @param cache_slot The zero-based index of the cached level, such that the level index is FirstCachedLevel + cache_slot.
+/// @return The number of blocks in the thread cache for the level.
+internal_function uint32_t
+OsConcurrentBuddyRefillCache
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    OS_BUDDY_THREAD_CACHE         *cache, 
+    uint32_t                  cache_slot
+)
+{
+    size_t count = OsConcurrentBuddyDepotPop(alloc, cache_slot, cache->Blocks[cache_slot], OS_BUDDY_THREAD_CACHE::BATCH_SIZE);
+    if (count == 0)
+    {   // the depot is empty - carve a batch of blocks from the underlying allocator.
+        OS_MEMORY_RANGE range;
+        size_t     block_size =(size_t)(1ULL << alloc->Tree.LevelBits[alloc->FirstCachedLevel + cache_slot]);
+        OsLockMutex(&alloc->TreeLock);
         {
-            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            while (count < OS_BUDDY_THREAD_CACHE::BATCH_SIZE && OsBuddyAllocate(&alloc->Tree, block_size, block_size, range))
             {
-                if ((fd.cFileName[0] == L'.' && fd.cFileName[1] == 0) || (fd.cFileName[0] == L'.' && fd.cFileName[1] == L'.' && fd.cFileName[2] == 0))
-                {   // skip the current directory and parent directory links.
-                    continue;
-                }
-                else
-                {   // build the path string for the subdirectory.
-                    *base_end = 0; filter_end = base_end;
-                    if ((filter_chars = OsNativePathAppend(buf, buf_bytes, &filter_end, bytes_needed, fd.cFileName)) == 0)
-                    {
-                        *base_end = 0; filter_end = base_end;
-                        OsLayerError("ERROR: %S(%u): Unable to recurse into subdirectory %s of path %s.\n", __FUNCTION__, GetCurrentThreadId(), fd.cFileName, buf);
-                    }
-                    // recurse into the subdirectory.
-                    chunk = OsEnumerateDirectory(buf, buf_bytes, filter_end, filter, recurse, total_files, alloc, chunk);
-                }
+                cache->Blocks[cache_slot][count++] = range.ByteOffset;
             }
-        } 
-        while (FindNextFile(find_handle, &fd));
-        FindClose(find_handle); find_handle = INVALID_HANDLE_VALUE;
+        }
+        OsUnlockMutex(&alloc->TreeLock);
     }
+    cache->Count[cache_slot] = (uint32_t) count;
+    return (uint32_t) count;
+}
 
-    // now search with the actual filter applied, and look at files only.
-    *base_end = 0; filter_end = base_end;
-    if ((filter_chars = OsNativePathAppend(buf, buf_bytes, &filter_end, bytes_needed, filter)) == 0)
+/// @summary Initialize a concurrent buddy allocator instance.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR to initialize.
+/// @param init Data specifying the allocator configuration.
+/// @return Zero if the allocator is initialized successfully, or -1 if an error occurred.
+public_function int
+OsCreateConcurrentBuddyAllocator
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    OS_BUDDY_ALLOCATOR_INIT        *init
+)
+{
+    if (OsCreateBuddyAllocator(&alloc->Tree, init) != 0)
     {
-        OsLayerError("ERROR: %S(%u): Unable to construct filter string from %s and %s.\n", __FUNCTION__, GetCurrentThreadId(), buf, filter);
-        return chunk;
+        OsLayerError("ERROR: %S(%u): Failed to initialize the underlying buddy allocator.\n", __FUNCTION__, OsThreadId());
+        return -1;
     }
-    if ((find_handle = FindFirstFileEx(buf, FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH)) == INVALID_HANDLE_VALUE)
+    // cache the smallest levels, but never level 0 - that block is the entire range.
+    uint32_t cached_levels = alloc->Tree.LevelCount - 1;
+    if (cached_levels > OS_CONCURRENT_BUDDY_ALLOCATOR::MAX_CACHED_LEVELS)
+        cached_levels =(uint32_t) OS_CONCURRENT_BUDDY_ALLOCATOR::MAX_CACHED_LEVELS;
+
+    OsCreateMutex(&alloc->TreeLock, 0x1000);
+    alloc->FirstCachedLevel = alloc->Tree.LevelCount - cached_levels;
+    alloc->CachedLevelCount = cached_levels;
+    alloc->Generation.store(0, std::memory_order_relaxed);
+    for (size_t slot = 0; slot < OS_CONCURRENT_BUDDY_ALLOCATOR::MAX_CACHED_LEVELS; ++slot)
     {
-        OsLayerError("ERROR: %S(%u): Search filter %s failed (%08X).\n", __FUNCTION__, GetCurrentThreadId(), buf, GetLastError());
-        return chunk;
+        OsCreateMutex(&alloc->Depots[slot].Lock, 0x1000);
+        alloc->Depots[slot].Count = 0;
     }
-    do
-    {   // skip over anything that's not a proper file or symlink.
-        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-            continue;
-        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DEVICE)
-            continue;
-        if (fd.dwFileAttributes & FILE_ATTRIBUTE_VIRTUAL)
-            continue;
+    return 0;
+}
 
-        // build the absolute path of the file.
-        *base_end = 0; filter_end = base_end;
-        if ((filter_chars = OsNativePathAppend(buf, buf_bytes, &filter_end, bytes_needed, fd.cFileName)) == 0)
+/// @summary Free all resources associated with an OS_CONCURRENT_BUDDY_ALLOCATOR instance. No other thread may be accessing the allocator.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR to delete.
+public_function void
+OsDeleteConcurrentBuddyAllocator
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc
+)
+{
+    for (size_t slot = 0; slot < OS_CONCURRENT_BUDDY_ALLOCATOR::MAX_CACHED_LEVELS; ++slot)
+    {
+        OsDeleteMutex(&alloc->Depots[slot].Lock);
+        alloc->Depots[slot].Count = 0;
+    }
+    OsDeleteMutex(&alloc->TreeLock);
+    OsDeleteBuddyAllocator(&alloc->Tree);
+    alloc->FirstCachedLevel = 0;
+    alloc->CachedLevelCount = 0;
+}
+
+/// @summary Allocate memory from a concurrent buddy allocator. This function is safe to call from multiple threads concurrently.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR managing the memory.
+/// @param cache The OS_BUDDY_THREAD_CACHE owned by the calling thread, or NULL.
+/// @param size The number of bytes being requested.
+/// @param alignment The required alignment of the returned block offset.
+/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region.
+/// @return true if the allocator satisfied the request.
+public_function bool
+OsConcurrentBuddyAllocate
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    OS_BUDDY_THREAD_CACHE         *cache, 
+    size_t                          size, 
+    size_t                     alignment, 
+    OS_MEMORY_RANGE               &range
+)
+{
+    if (size < alignment)
+    {   // round upwards to the requested alignment. blocks are aligned to their size.
+        size = alignment;
+    }
+    if (size < alloc->Tree.AllocationSizeMin)
+    {   // round up to the minimum possible block size.
+        size =(size_t) alloc->Tree.AllocationSizeMin;
+    }
+    if (size > alloc->Tree.AllocationSizeMax)
+    {
+        OsLayerError("ERROR: %S(%u): Allocation request for %Iu bytes exceeds maximum of %I64u bytes.\n", __FUNCTION__, OsThreadId(), size, alloc->Tree.AllocationSizeMax);
+        range.ByteOffset  = 0;
+        range.SizeInBytes = 0;
+        return false;
+    }
+
+    uint64_t pow2_size = OsNextPowerOfTwoGreaterOrEqual(size);
+    uint32_t level_idx = OsBuddyAllocatorLevelForSize(&alloc->Tree, pow2_size);
+    if (level_idx >= alloc->FirstCachedLevel && alloc->CachedLevelCount > 0)
+    {   // small blocks are satisfied from the thread cache or the depot without touching TreeLock.
+        uint32_t cache_slot = level_idx - alloc->FirstCachedLevel;
+        uint64_t block_offset;
+        if (cache != NULL)
         {
-            OsLayerError("ERROR: %S(%u): Failed to build filename for path %s, file %s.\n", __FUNCTION__, GetCurrentThreadId(), buf, fd.cFileName);
-            continue;
-        }
-        if (chunk == NULL || chunk->RecordCount == OS_FILE_INFO_CHUNK::CAPACITY)
-        {   // allocate a new chunk; the current chunk is full.
-            OS_FILE_INFO_CHUNK *new_chunk = OsNewFileInfoChunk(alloc);
-            if (new_chunk == NULL)
+            OsConcurrentBuddyValidateCache(alloc, cache);
+            if (cache->Count[cache_slot] > 0 || OsConcurrentBuddyRefillCache(alloc, cache, cache_slot) > 0)
             {
-                OsLayerError("ERROR: %S(%u): Failed to allocate OS_FILE_INFO_CHUNK for file %s.\n", __FUNCTION__, GetCurrentThreadId(), buf);
-                continue;
+                range.ByteOffset  =(size_t) cache->Blocks[cache_slot][--cache->Count[cache_slot]];
+                range.SizeInBytes =(size_t) pow2_size;
+                return true;
             }
-            // entries higher up in the tree appear first.
-            new_chunk->NextChunk = chunk;
-            chunk = new_chunk;
-        }
-        // fill out the information for the file in the current chunk.
-        chunk->PathHash[chunk->RecordCount]            = OsHashPath(buf);
-        chunk->FileInfo[chunk->RecordCount].FileSize   = OsMakeInt64(fd.nFileSizeHigh, fd.nFileSizeLow);
-        chunk->FileInfo[chunk->RecordCount].BaseOffset = 0;
-        chunk->FileInfo[chunk->RecordCount].LastWrite  = fd.ftLastWriteTime;
-        chunk->FileInfo[chunk->RecordCount].Attributes = fd.dwFileAttributes;
-        // convert the filename from file system native to UTF-8.
-        // this data will be used for collision resolution and extension searching.
-        if ((fname_bytes = WideCharToMultiByte(CP_UTF8, 0, fd.cFileName, -1, utf8buf, MAX_UTF8, NULL, NULL)) == 0)
-        {
-            OsLayerError("ERROR: %S(%u): Failed to convert filename %s to UTF-8 (%08X).\n", __FUNCTION__, GetCurrentThreadId(), fd.cFileName, GetLastError());
-            continue;
         }
-        // copy as much data as possible to the filename buffer.
-        // fname_bytes includes one byte for the zero-terminator.
-        size_t fnmax = OS_FILE_INFO::MAX_STRING_BYTES - 1;
-        char  *fndst = chunk->FileInfo[chunk->RecordCount].FileName;
-        char  *fnend = utf8buf + fname_bytes;
-        char  *fnsrc = utf8buf;
-        char  *fnext = NULL;
-        if (fnmax >= size_t(fname_bytes - 1))
-            fnmax  = size_t(fname_bytes - 1);
-        CopyMemory(fndst, fnsrc, fnmax);
-        fndst[fnmax] = 0;
-        // find the file extension and copy as much as possible into the extension buffer.
-        // note that the first character is intentionally NOT included.
-        while (fnend > fnsrc)
+        else if (OsConcurrentBuddyDepotPop(alloc, cache_slot, &block_offset, 1) > 0)
         {
-            if(*fnend == '.')
-                fnext = fnend;
-            fnend--;
-        }
-        if (fnext != NULL)
-        {   // copy the file extension data.
-            fndst  = chunk->FileInfo[chunk->RecordCount].Extension;
-            fnmax  = OS_FILE_INFO::MAX_STRING_BYTES - 1;
-            fnend  = utf8buf + fname_bytes;
-            if (fnmax >= size_t(fnend - fnext - 1))
-                fnmax  = size_t(fnend - fnext - 1);
-            CopyMemory(fndst, fnext, fnmax);
-            fndst[fnmax] = 0;
-        }
-        else
-        {   // there is no file extension.
-            chunk->FileInfo[chunk->RecordCount].Extension[0] = 0;
+            range.ByteOffset  =(size_t) block_offset;
+            range.SizeInBytes =(size_t) pow2_size;
+            return true;
         }
-        // all data has been written to the new record. make it visible.
-        chunk->RecordCount++;
-        total_files++;
-    } 
-    while (FindNextFile(find_handle, &fd));
-
-    // finished searching; clean up and return.
-    FindClose(find_handle); find_handle = INVALID_HANDLE_VALUE;
-    return chunk;
+    }
+    return OsConcurrentBuddyTreeAllocate(alloc, size, alignment, range);
 }
 
-/// @summary Helper function to convert a UTF-8 encoded string to the system native WCHAR. Free the returned buffer using the standard C library free() call.
-/// @param str The NULL-terminated UTF-8 string to convert.
-/// @param size_chars On return, stores the length of the string in characters, not including NULL-terminator.
-/// @param size_bytes On return, stores the length of the string in bytes, including the NULL-terminator.
-/// @return The WCHAR string buffer, or NULL if the string could not be converted.
-internal_function WCHAR*
-OsUtf8ToNativeMalloc
+/// @summary Grow or shrink a memory block to meet a desired size. This function is safe to call from multiple threads concurrently.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR managing the allocated range.
+/// @param cache The OS_BUDDY_THREAD_CACHE owned by the calling thread, or NULL.
+/// @param existing An OS_MEMORY_RANGE describing the existing allocation.
+/// @param new_size The new required minimum allocation size, in bytes.
+/// @param alignment The required alignment of the returned block offset.
+/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region, which may or may not be the same as the existing region.
+/// @return true if the allocator satisfied the request.
+public_function bool
+OsConcurrentBuddyReallocate
 (
-    char const    *str, 
-    size_t &size_chars, 
-    size_t &size_bytes
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    OS_BUDDY_THREAD_CACHE         *cache, 
+    OS_MEMORY_RANGE             existing, 
+    size_t                      new_size, 
+    size_t                     alignment, 
+    OS_MEMORY_RANGE               &range
 )
-{   // figure out how much memory needs to be allocated, including NULL terminator.
-    int nchars = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, -1, NULL, 0);
-    if (nchars == 0)
-    {   // the path cannot be converted from UTF-8 to UCS-2.
-        size_chars = 0;
-        size_bytes = 0;
-        return NULL;
-    }
-    // store output values for the caller.
-    size_chars = nchars - 1;
-    size_bytes = nchars * sizeof(WCHAR);
-    // allocate buffer space for the wide character string.
-    WCHAR *pathbuf = NULL;
-    if   ((pathbuf = (WCHAR*) malloc(size_bytes)) == NULL)
-    {   // unable to allocate temporary memory for UCS-2 path.
-        OsLayerError("ERROR: %S(%u): Memory allocation for %Iu bytes failed.\n", __FUNCTION__, GetCurrentThreadId(), size_bytes);
-        return NULL;
+{
+    if (existing.SizeInBytes == 0)
+    {   // there is no existing allocation, so this is equivalent to calling OsConcurrentBuddyAllocate.
+        return OsConcurrentBuddyAllocate(alloc, cache, new_size, alignment, range);
+    }
+
+    size_t   req_size = new_size < alignment ? alignment : new_size;
+    size_t   old_size = existing.SizeInBytes;
+    if (req_size < alloc->Tree.AllocationSizeMin)
+        req_size =(size_t) alloc->Tree.AllocationSizeMin;
+    if (old_size < alloc->Tree.AllocationSizeMin)
+        old_size =(size_t) alloc->Tree.AllocationSizeMin;
+    if (req_size <= alloc->Tree.AllocationSizeMax && OsNextPowerOfTwoGreaterOrEqual(req_size) == OsNextPowerOfTwoGreaterOrEqual(old_size))
+    {   // the new size still fits in the same block - no locks are required.
+        range.ByteOffset  = existing.ByteOffset;
+        range.SizeInBytes = OsNextPowerOfTwoGreaterOrEqual(old_size);
+        return true;
     }
-    if (MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, -1, pathbuf, nchars) == 0)
-    {   // the path cannot be converted from UTF-8 to UCS-2.
-        OsLayerError("ERROR: %S(%u): Cannot convert from UTF8 to UCS2 (%08X).\n", __FUNCTION__, GetCurrentThreadId(), GetLastError());
-        free(pathbuf);
-        return NULL;
+
+    // the block must be promoted, demoted or moved, all of which modify the tree.
+    bool result = false;
+    OsLockMutex(&alloc->TreeLock);
+    {
+        if ((result = OsBuddyReallocate(&alloc->Tree, existing, new_size, alignment, range)) == false && new_size <= alloc->Tree.AllocationSizeMax)
+        {   // free blocks may be sitting in the depots, unmerged.
+            if (OsConcurrentBuddyDrainDepots(alloc) > 0)
+                result = OsBuddyReallocate(&alloc->Tree, existing, new_size, alignment, range);
+        }
     }
-    return pathbuf;
+    OsUnlockMutex(&alloc->TreeLock);
+    return result;
 }
 
-/// @summary Generate a Windows API-ready file path for a given virtual path specified relative to the mount point root.
-/// @param mount_local_path A zero-terminated buffer specifying the filesystem mount point local path.
-/// @param local_path_length The number of characters in the mount_local_path string, not including the zero terminator.
-/// @param relative_path The portion of the virtual path specified relative to the mount point root.
-/// @return The API-ready system path, or NULL. Free the returned buffer using free().
-internal_function WCHAR* 
-OsMakeSystemPathMalloc
+/// @summary Free a previously allocated memory range. This function is safe to call from multiple threads concurrently.
+/// Small blocks are retained in the thread cache or level depot, and are merged with their buddies later.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR that returned the memory range.
+/// @param cache The OS_BUDDY_THREAD_CACHE owned by the calling thread, or NULL.
+/// @param range The block offset and size returned by a prior call to OsConcurrentBuddyAllocate or OsConcurrentBuddyReallocate.
+public_function void
+OsConcurrentBuddyFree
 (
-    WCHAR        *mount_local_path, 
-    size_t const local_path_length,
-    char   const    *relative_path
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    OS_BUDDY_THREAD_CACHE         *cache, 
+    OS_MEMORY_RANGE                range
 )
 {
-    WCHAR  *pathbuf = NULL;
-    int     nchars  = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, relative_path, -1, NULL, 0);
-    // convert the virtual_path from UTF-8 to UCS-2, which Windows requires.
-    if (nchars == 0)
-    {   // the path cannot be converted from UTF-8 to UCS-2.
-        return NULL;
+    if (range.SizeInBytes == 0)
+    {   // nothing to free.
+        return;
     }
-    if ((pathbuf = (WCHAR*) malloc((nchars + local_path_length + 1) * sizeof(WCHAR))) == NULL)
-    {   // unable to allocate memory for UCS-2 path.
-        return NULL;
+    if (range.SizeInBytes < alloc->Tree.AllocationSizeMin)
+    {   // ensure that the specified size is at least the minimum allocation size.
+        range.SizeInBytes =(size_t) alloc->Tree.AllocationSizeMin;
     }
-    // start with the local root, and then append the relative path portion.
-    memcpy(pathbuf, mount_local_path, local_path_length * sizeof(WCHAR));
-    pathbuf[local_path_length] = L'\\';
-    if (MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, relative_path, -1, &pathbuf[local_path_length+1], nchars) == 0)
-    {   // the path cannot be converted from UTF-8 to UCS-2.
-        free(pathbuf);
-        return NULL;
+
+    uint64_t pow2_size = OsNextPowerOfTwoGreaterOrEqual(range.SizeInBytes);
+    uint32_t level_idx = OsBuddyAllocatorLevelForSize(&alloc->Tree, pow2_size);
+    if (level_idx >= alloc->FirstCachedLevel && alloc->CachedLevelCount > 0)
+    {   // small blocks go to the thread cache or depot; merging is deferred.
+        uint32_t cache_slot = level_idx - alloc->FirstCachedLevel;
+        uint64_t block_offset = range.ByteOffset;
+        if (cache != NULL)
+        {
+            OsConcurrentBuddyValidateCache(alloc, cache);
+            if (cache->Count[cache_slot] == OS_BUDDY_THREAD_CACHE::CAPACITY)
+            {   // move the oldest half of the cached blocks to the depot.
+                uint32_t const batch = (uint32_t) OS_BUDDY_THREAD_CACHE::BATCH_SIZE;
+                OsConcurrentBuddyDepotPush(alloc, cache_slot, cache->Blocks[cache_slot], batch);
+                OsMoveMemory(cache->Blocks[cache_slot], cache->Blocks[cache_slot] + batch, (OS_BUDDY_THREAD_CACHE::CAPACITY - batch) * sizeof(uint64_t));
+                cache->Count[cache_slot] -= batch;
+            }
+            cache->Blocks[cache_slot][cache->Count[cache_slot]++] = block_offset;
+        }
+        else
+        {
+            OsConcurrentBuddyDepotPush(alloc, cache_slot, &block_offset, 1);
+        }
+        return;
     }
-    // normalize the directory separator characters to the system default.
-    // on Windows, this is not strictly necessary, but on other OS's it is.
-    for (size_t i = local_path_length + 1, n = local_path_length + nchars; i < n; ++i)
+    OsLockMutex(&alloc->TreeLock);
     {
-        if (pathbuf[i] == L'/')
-            pathbuf[i]  = L'\\';
+        OsBuddyFree(&alloc->Tree, range);
     }
-    return pathbuf;
+    OsUnlockMutex(&alloc->TreeLock);
 }
 
-/// @summary Retrieve the fully-resolved absolute path for a file or directory.
-/// @param handle The handle of the opened file or directory.
-/// @param length On return, the number of characters in the returned path string is stored here, not including the zero terminator.
-/// @return The zero-terminated, fully-resolved absolute path of the file system entity, or NULL. Free the returned buffer using free().
-internal_function WCHAR*
-OsResolvePathForHandleMalloc
+/// @summary Return all blocks held in a thread cache to the allocator. Call this before the thread owning the cache exits.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR associated with the cache.
+/// @param cache The OS_BUDDY_THREAD_CACHE to flush.
+public_function void
+OsConcurrentBuddyFlushCache
 (
-    HANDLE  handle, 
-    size_t &length
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc, 
+    OS_BUDDY_THREAD_CACHE         *cache
 )
 {
-    WCHAR *pathbuf = NULL;
-    DWORD    flags = VOLUME_NAME_DOS | FILE_NAME_NORMALIZED;
-    DWORD  pathlen = GetFinalPathNameByHandleW(handle, NULL, 0, flags);
-    // GetFinalPathNameByHandle returns the buffer length, in TCHARs, including zero terminator.
-    if (pathlen == 0)
+    OsConcurrentBuddyValidateCache(alloc, cache);
+    for (uint32_t slot = 0; slot < alloc->CachedLevelCount; ++slot)
     {
-        length  = 0;
-        return NULL;
+        uint32_t count = cache->Count[slot];
+        uint32_t index = 0;
+        while   (index < count)
+        {
+            uint32_t batch = count - index;
+            if (batch > OS_BUDDY_THREAD_CACHE::BATCH_SIZE)
+                batch =(uint32_t) OS_BUDDY_THREAD_CACHE::BATCH_SIZE;
+            OsConcurrentBuddyDepotPush(alloc, slot, cache->Blocks[slot] + index, batch);
+            index += batch;
+        }
+        cache->Count[slot] = 0;
     }
-    if ((pathbuf = (WCHAR*) malloc(pathlen * sizeof(WCHAR))) == NULL)
+}
+
+/// @summary Perform all deferred merges by returning the blocks held in the level depots to the underlying allocator.
+/// Blocks held in thread caches are not affected.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR to trim.
+public_function void
+OsConcurrentBuddyTrim
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc
+)
+{
+    OsLockMutex(&alloc->TreeLock);
     {
-        length  = 0;
-        return NULL;
+        OsConcurrentBuddyDrainDepots(alloc);
     }
-    // GetFinalPathNameByHandle returns the number of TCHARs written, not including zero terminator.
-    if (GetFinalPathNameByHandleW(handle, pathbuf, pathlen-1, flags) != (pathlen-1))
+    OsUnlockMutex(&alloc->TreeLock);
+}
+
+/// @summary Reset a concurrent buddy allocator back to its initial state, invalidating all existing allocations and thread caches.
+/// No other thread may be accessing the allocator.
+/// @param alloc The OS_CONCURRENT_BUDDY_ALLOCATOR to reset.
+public_function void
+OsConcurrentBuddyReset
+(
+    OS_CONCURRENT_BUDDY_ALLOCATOR *alloc
+)
+{
+    OsLockMutex(&alloc->TreeLock);
     {
-        free(pathbuf);
-        length  = 0;
-        return NULL;
+        for (uint32_t slot = 0; slot < alloc->CachedLevelCount; ++slot)
+        {
+            alloc->Depots[slot].Count = 0;
+        }
+        OsBuddyReset(&alloc->Tree);
+        alloc->Generation.fetch_add(1, std::memory_order_release);
     }
-    pathbuf[pathlen-1] = 0;
-    length = pathlen-1;
-    return pathbuf;
+    OsUnlockMutex(&alloc->TreeLock);
 }
 
-/// @summary Execute a low-level file open operation.
-/// @param args Information about the file to open. The FilePath and IoHintFlags fields must be set.
-/// @param result Information returned from the operation specifying the file handle and whether the operation completed successfully.
-/// @param file_info If this argument is not NULL, information about the file is stored here on return.
-/// @param sector_size If this argument is not NULL, the physical device sector size is stored here on return.
-internal_function void
-OsIoExecuteOpen
+/// @summary Retrieve a pointer to the header of a block managed by a TLSF allocator.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the block.
+/// @param block_offset The offset of the block header from the start of the managed memory range.
+/// @return A pointer to the block header.
+internal_function inline OS_TLSF_BLOCK_HEADER*
+OsTlsfBlockAt
 (
-    OS_IO_OPERATION          &args, 
-    OS_IO_OPERATION_RESULT &result, 
-    FILE_STANDARD_INFO  *file_info, 
-    size_t            *sector_size
+    OS_TLSF_ALLOCATOR *alloc, 
+    uint64_t    block_offset
 )
 {
-    HANDLE    fd = INVALID_HANDLE_VALUE;
-    DWORD access = 0; // dwDesiredAccess
-    DWORD share  = 0; // dwShareMode
-    DWORD create = 0; // dwCreationDisposition
-    DWORD flags  = 0; // dwFlagsAndAttributes
+    return (OS_TLSF_BLOCK_HEADER*)(alloc->HostMemory.HostAddress + block_offset);
+}
 
-    if (args.IoHintFlags & OS_IO_HINT_FLAG_OVERWRITE)
-    {   // this implies write access.
-        args.IoHintFlags |= OS_IO_HINT_FLAG_WRITE;
+/// @summary Retrieve the payload size of a block, excluding the flag bits.
+/// @param block The block header.
+/// @return The size of the block payload, in bytes.
+internal_function inline uint64_t
+OsTlsfPayloadSize
+(
+    OS_TLSF_BLOCK_HEADER *block
+)
+{
+    return block->SizeAndFlags & ~(OS_TLSF_ALLOCATOR::BLOCK_FREE | OS_TLSF_ALLOCATOR::BLOCK_PREV_FREE);
+}
+
+/// @summary Set the payload size of a block, preserving the flag bits.
+/// @param block The block header.
+/// @param size The size of the block payload, in bytes. This value must be a multiple of OS_TLSF_ALLOCATOR::ALIGN_SIZE.
+internal_function inline void
+OsTlsfSetPayloadSize
+(
+    OS_TLSF_BLOCK_HEADER *block, 
+    uint64_t               size
+)
+{
+    block->SizeAndFlags = size | (block->SizeAndFlags & (OS_TLSF_ALLOCATOR::BLOCK_FREE | OS_TLSF_ALLOCATOR::BLOCK_PREV_FREE));
+}
+
+/// @summary Retrieve the offset of the block physically following a given block.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the block.
+/// @param block_offset The offset of the block header.
+/// @return The offset of the header of the next physical block.
+internal_function inline uint64_t
+OsTlsfNextPhysical
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    uint64_t    block_offset
+)
+{
+    return block_offset + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OsTlsfPayloadSize(OsTlsfBlockAt(alloc, block_offset));
+}
+
+/// @summary Compute the first- and second-level list indices for a block of a given size.
+/// @param size The block payload size, in bytes.
+/// @param fl On return, the first-level index.
+/// @param sl On return, the second-level index.
+internal_function inline void
+OsTlsfMappingInsert
+(
+    uint64_t  size, 
+    uint32_t   &fl, 
+    uint32_t   &sl
+)
+{
+    if (size < OS_TLSF_ALLOCATOR::SMALL_BLOCK_SIZE)
+    {   // small blocks are stored in first-level class 0, linearly subdivided.
+        fl = 0;
+        sl = (uint32_t)(size / (OS_TLSF_ALLOCATOR::SMALL_BLOCK_SIZE / OS_TLSF_ALLOCATOR::SL_INDEX_COUNT));
     }
-    if (args.IoHintFlags & OS_IO_HINT_FLAG_READ)
+    else
     {
-        access |= GENERIC_READ;
-        share   = FILE_SHARE_READ;
-        create  = OPEN_EXISTING;
-        flags   = FILE_FLAG_OVERLAPPED;
+        uint32_t bit = OsBitScanReverse64(size);
+        sl = (uint32_t)(size >> (bit - OS_TLSF_ALLOCATOR::SL_INDEX_COUNT_LOG2)) ^ OS_TLSF_ALLOCATOR::SL_INDEX_COUNT;
+        fl = bit - (OS_TLSF_ALLOCATOR::FL_INDEX_SHIFT - 1);
     }
-    if (args.IoHintFlags & OS_IO_HINT_FLAG_WRITE)
+}
+
+/// @summary Compute the first- and second-level list indices to search for a block of a given size.
+/// The size is rounded up to the next list boundary, so that any block in the resulting list is large enough.
+/// @param size The requested payload size, in bytes.
+/// @param fl On return, the first-level index.
+/// @param sl On return, the second-level index.
+internal_function inline void
+OsTlsfMappingSearch
+(
+    uint64_t  size, 
+    uint32_t   &fl, 
+    uint32_t   &sl
+)
+{
+    if (size >= OS_TLSF_ALLOCATOR::SMALL_BLOCK_SIZE)
     {
-        access |= GENERIC_WRITE;
-        flags   = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED;
-        if (args.IoHintFlags & OS_IO_HINT_FLAG_OVERWRITE)
-        {   // opening the file will always succeed.
-            create = CREATE_ALWAYS;
-        }
-        else
-        {   // opening the file will always succeed, but existing contents are preserved.
-            create = OPEN_ALWAYS;
-        }
-        if (args.IoHintFlags & OS_IO_HINT_FLAG_TEMPORARY)
-        {   // temporary files are deleted on close, and the cache manager will try to prevent writes to disk.
-            flags |= FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE;
-            share |= FILE_SHARE_DELETE;
-        }
-        else
-        {   // standard persistent file, data will eventually end up on disk.
-            flags |= FILE_ATTRIBUTE_NORMAL;
-        }
-    }
-    if (args.IoHintFlags & OS_IO_HINT_FLAG_SEQUENTIAL)
-    {   // tell the cache manager to optimize for sequential access.
-        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
-    }
-    else
-    {   // assume the file will be accessed randomly.
-        flags |= FILE_FLAG_RANDOM_ACCESS;
-    }
-    if (args.IoHintFlags & OS_IO_HINT_FLAG_UNCACHED)
-    {   // use unbuffered I/O, reads must be performed in sector size multiples to 
-        // a buffer whose address is also a multiple of the physical disk sector size.
-        flags |= FILE_FLAG_NO_BUFFERING;
-    }
-    if (args.IoHintFlags & OS_IO_HINT_FLAG_WRITE_THROUGH)
-    {   // writes are immediately flushed to disk, if possible.
-        flags |= FILE_FLAG_WRITE_THROUGH;
+        size += (1ULL << (OsBitScanReverse64(size) - OS_TLSF_ALLOCATOR::SL_INDEX_COUNT_LOG2)) - 1;
     }
-    if ((fd = CreateFile(args.FilePath, access, share, NULL, create, flags, NULL)) == INVALID_HANDLE_VALUE)
+    OsTlsfMappingInsert(size, fl, sl);
+}
+
+/// @summary Add a free block to the free list for its size.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the block.
+/// @param block_offset The offset of the block header.
+internal_function void
+OsTlsfInsertFreeBlock
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    uint64_t    block_offset
+)
+{
+    OS_TLSF_BLOCK_HEADER *block = OsTlsfBlockAt(alloc, block_offset);
+    uint64_t              size  = OsTlsfPayloadSize(block);
+    uint32_t              fl, sl;
+    OsTlsfMappingInsert(size, fl, sl);
+    uint64_t              head  = alloc->FreeBlocks[fl][sl];
+    block->NextFree = head;
+    block->PrevFree = OS_TLSF_ALLOCATOR::NULL_OFFSET;
+    if (head != OS_TLSF_ALLOCATOR::NULL_OFFSET)
     {
-        OsLayerError("ERROR: %S(%u): Failed to open file \"%s\" (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, GetLastError());
-        result.FileHandle = INVALID_HANDLE_VALUE;
-        result.ResultCode = GetLastError();
-        result.TransferAmount = 0;
-        result.CompletedSynchronously = true;
-        result.WasSuccessful = false;
-        return;
+        OsTlsfBlockAt(alloc, head)->PrevFree = block_offset;
     }
-    if (args.CompletionPort != NULL && CreateIoCompletionPort(fd, args.CompletionPort, 0, 0) != args.CompletionPort)
+    alloc->FreeBlocks[fl][sl] = block_offset;
+    alloc->FlBitmap          |= 1U << fl;
+    alloc->SlBitmap[fl]      |= 1U << sl;
+    alloc->BytesFree         += size;
+}
+
+/// @summary Remove a free block from the free list for its size.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the block.
+/// @param block_offset The offset of the block header.
+internal_function void
+OsTlsfRemoveFreeBlock
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    uint64_t    block_offset
+)
+{
+    OS_TLSF_BLOCK_HEADER *block = OsTlsfBlockAt(alloc, block_offset);
+    uint64_t              size  = OsTlsfPayloadSize(block);
+    uint32_t              fl, sl;
+    OsTlsfMappingInsert(size, fl, sl);
+    if (block->NextFree != OS_TLSF_ALLOCATOR::NULL_OFFSET)
     {
-        OsLayerError("ERROR: %S(%u): Unable to associate file \"%s\" with I/O completion port (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, GetLastError());
-        result.FileHandle = INVALID_HANDLE_VALUE;
-        result.ResultCode = GetLastError();
-        result.TransferAmount = 0;
-        result.CompletedSynchronously = true;
-        result.WasSuccessful = false;
-        CloseHandle(fd);
-        return;
+        OsTlsfBlockAt(alloc, block->NextFree)->PrevFree = block->PrevFree;
     }
-    if (args.CompletionPort != NULL)
-    {   // immediately complete requests that execute synchronously; don't post completion port notification.
-        // this reduces traffic on the completion port and improves performance for asynchronous requests.
-        SetFileCompletionNotificationModes(fd, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS);
+    if (block->PrevFree != OS_TLSF_ALLOCATOR::NULL_OFFSET)
+    {
+        OsTlsfBlockAt(alloc, block->PrevFree)->NextFree = block->NextFree;
     }
-    if ((args.IoHintFlags & OS_IO_HINT_FLAG_PREALLOCATE) && args.PreallocationSize > 0)
-    {   // preallocate storage space for the file data, which can significantly improve performance when writing large files.
-        // this can be slower for large files if the file is not written sequentially.
-        LARGE_INTEGER new_ptr; new_ptr.QuadPart = args.PreallocationSize;
-        if (SetFilePointerEx(fd, new_ptr, NULL, FILE_BEGIN))
-        {   // set the end-of-file marker to the new location.
-            if (SetEndOfFile(fd))
-            {   // move the file pointer back to the start of the file.
-                new_ptr.QuadPart = 0;
-                SetFilePointerEx(fd, new_ptr, NULL, FILE_BEGIN);
-            }
-            else
-            {   // this is a non-fatal error since preallocation is an optimization.
-                OsLayerError("ERROR: %S(%u): Failed to preallocate file \"%s\" to %I64d bytes. SetEndOfFile failed (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, args.PreallocationSize, GetLastError()); 
-            }
-        }
-        else
-        {   // this is a non-fatal error since preallocation is an optimization.
-            OsLayerError("ERROR: %S(%u): Failed to preallocate file \"%s\" to %I64d bytes. SetFilePointerEx failed (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, args.PreallocationSize, GetLastError()); 
+    else
+    {   // the block is the head of its list.
+        alloc->FreeBlocks[fl][sl] = block->NextFree;
+        if (block->NextFree == OS_TLSF_ALLOCATOR::NULL_OFFSET)
+        {   // the list is now empty.
+            alloc->SlBitmap[fl] &= ~(1U << sl);
+            if (alloc->SlBitmap[fl] == 0)
+                alloc->FlBitmap &= ~(1U << fl);
         }
     }
-    if (file_info != NULL)
-    {   // retrieve the end-of-file (logical file size) and allocation size (physical size).
-        ZeroMemory(file_info, sizeof(FILE_STANDARD_INFO));
-        if (!GetFileInformationByHandleEx(fd, FileStandardInfo, file_info, sizeof(FILE_STANDARD_INFO)))
-        {   // this is a non-fatal error since it's just an information request.
-            OsLayerError("ERROR: %S(%u): Failed to retrieve attributes for file \"%s\" (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, GetLastError());
-        }
+    alloc->BytesFree -= size;
+}
+
+/// @summary Split a block into a leading block of a given size and a trailing remainder block. The remainder is neither free nor on a free list.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the block.
+/// @param block_offset The offset of the block header.
+/// @param size The payload size of the leading block, in bytes. The block must be large enough to hold a remainder of at least BLOCK_SIZE_MIN bytes.
+/// @return The offset of the remainder block header.
+internal_function uint64_t
+OsTlsfSplitBlock
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    uint64_t    block_offset, 
+    uint64_t            size
+)
+{
+    OS_TLSF_BLOCK_HEADER *block = OsTlsfBlockAt(alloc, block_offset);
+    uint64_t        remain_size = OsTlsfPayloadSize(block) - size - OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD;
+    uint64_t      remain_offset = block_offset + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + size;
+    OS_TLSF_BLOCK_HEADER*remain = OsTlsfBlockAt(alloc, remain_offset);
+    assert(OsTlsfPayloadSize(block) >= size + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OS_TLSF_ALLOCATOR::BLOCK_SIZE_MIN);
+    remain->PrevPhysical = block_offset;
+    remain->SizeAndFlags = remain_size;
+    OsTlsfSetPayloadSize(block, size);
+    OsTlsfBlockAt(alloc, OsTlsfNextPhysical(alloc, remain_offset))->PrevPhysical = remain_offset;
+    return remain_offset;
+}
+
+/// @summary Mark a block as in-use and clear the BLOCK_PREV_FREE flag of the following block.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the block.
+/// @param block_offset The offset of the block header.
+internal_function inline void
+OsTlsfMarkBlockUsed
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    uint64_t    block_offset
+)
+{
+    OsTlsfBlockAt(alloc, block_offset)->SizeAndFlags &= ~OS_TLSF_ALLOCATOR::BLOCK_FREE;
+    OsTlsfBlockAt(alloc, OsTlsfNextPhysical(alloc, block_offset))->SizeAndFlags &= ~OS_TLSF_ALLOCATOR::BLOCK_PREV_FREE;
+}
+
+/// @summary Return an in-use block to the allocator, merging it with free physical neighbors.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the block.
+/// @param block_offset The offset of the block header.
+internal_function void
+OsTlsfReleaseBlock
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    uint64_t    block_offset
+)
+{
+    OS_TLSF_BLOCK_HEADER *block = OsTlsfBlockAt(alloc, block_offset);
+    uint64_t        next_offset;
+    assert((block->SizeAndFlags & OS_TLSF_ALLOCATOR::BLOCK_FREE) == 0 && "Double free in OsTlsfFree");
+    if (block->SizeAndFlags & OS_TLSF_ALLOCATOR::BLOCK_PREV_FREE)
+    {   // merge with the preceding block.
+        uint64_t              prev_offset = block->PrevPhysical;
+        OS_TLSF_BLOCK_HEADER *prev        = OsTlsfBlockAt(alloc, prev_offset);
+        OsTlsfRemoveFreeBlock(alloc, prev_offset);
+        OsTlsfSetPayloadSize(prev, OsTlsfPayloadSize(prev) + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OsTlsfPayloadSize(block));
+        block_offset = prev_offset;
+        block        = prev;
+    }
+    next_offset = OsTlsfNextPhysical(alloc, block_offset);
+    if (OsTlsfBlockAt(alloc, next_offset)->SizeAndFlags & OS_TLSF_ALLOCATOR::BLOCK_FREE)
+    {   // merge with the following block.
+        OS_TLSF_BLOCK_HEADER *next = OsTlsfBlockAt(alloc, next_offset);
+        OsTlsfRemoveFreeBlock(alloc, next_offset);
+        OsTlsfSetPayloadSize(block, OsTlsfPayloadSize(block) + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OsTlsfPayloadSize(next));
+        next_offset = OsTlsfNextPhysical(alloc, block_offset);
+    }
+    block->SizeAndFlags |= OS_TLSF_ALLOCATOR::BLOCK_FREE;
+    OsTlsfBlockAt(alloc, next_offset)->PrevPhysical  = block_offset;
+    OsTlsfBlockAt(alloc, next_offset)->SizeAndFlags |= OS_TLSF_ALLOCATOR::BLOCK_PREV_FREE;
+    OsTlsfInsertFreeBlock(alloc, block_offset);
+}
+
+/// @summary Trim any excess space from the end of an in-use block, returning it to the allocator.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the block.
+/// @param block_offset The offset of the block header.
+/// @param size The required payload size, in bytes.
+internal_function inline void
+OsTlsfTrimBlock
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    uint64_t    block_offset, 
+    uint64_t            size
+)
+{
+    if (OsTlsfPayloadSize(OsTlsfBlockAt(alloc, block_offset)) >= size + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OS_TLSF_ALLOCATOR::BLOCK_SIZE_MIN)
+    {
+        OsTlsfReleaseBlock(alloc, OsTlsfSplitBlock(alloc, block_offset, size));
     }
-    if (sector_size != NULL)
-    {   // retrieve the physical device sector size. this value is necessary for unbuffered I/O operations, 
-        // where the buffer address and transfer size must be a multiple of the physical device sector size.
-        // TODO(rlk): for this to work, it needs the DEVICE path, ie. \\.\C:, and then you have to open a handle.
-        // TODO(rlk): GetFileInformationByHandleEx could also be used, but that is Windows 8+ for the property we need.
-        // TODO(rlk): for now, just hard-code to 4096.
-        /*STORAGE_ACCESS_ALIGNMENT_DESCRIPTOR desc;
-        STORAGE_PROPERTY_QUERY query;
-        DWORD bytes = 0;
-        ZeroMemory(&desc , sizeof(STORAGE_ACCESS_ALIGNMENT_DESCRIPTOR));
-        ZeroMemory(&query, sizeof(STORAGE_PROPERTY_QUERY));
-        query.QueryType  = PropertyStandardQuery;
-        query.PropertyId = StorageAccessAlignmentProperty;
-        if (DeviceIoControl(fd, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query), &desc, sizeof(desc), &bytes, NULL))
-        {   // save the physical device sector size.
-           *sector_size  = desc.BytesPerPhysicalSector; 
-        }
-        else
-        {   // this is a non-fatal error; return a default that will work for all common disks.
-            OsLayerError("ERROR: %S(%u): Failed to retrieve physical device sector size for file \"%s\" (%08X).\n", __FUNCTION__, GetCurrentThreadId(), args.FilePath, GetLastError());
-           *sector_size = 4096;
-        }*/
-        *sector_size = 4096;
+}
+
+/// @summary Convert a requested allocation size into a block payload size.
+/// @param size The requested size, in bytes.
+/// @return The block payload size, in bytes, or 0 if the request is too large.
+internal_function inline uint64_t
+OsTlsfAdjustRequestSize
+(
+    size_t size
+)
+{
+    if (size < OS_TLSF_ALLOCATOR::BLOCK_SIZE_MIN)
+        size =(size_t) OS_TLSF_ALLOCATOR::BLOCK_SIZE_MIN;
+    if (size > OS_TLSF_ALLOCATOR::BLOCK_SIZE_MAX)
+        return 0;
+    return OsAlignUp(size, OS_TLSF_ALLOCATOR::ALIGN_SIZE);
+}
+
+/// @summary Initialize a TLSF allocator to manage a range of host memory.
+/// @param alloc The OS_TLSF_ALLOCATOR to initialize.
+/// @param host_memory The address and size of the committed host-visible memory block to sub-allocate from. The address must be aligned to OS_TLSF_ALLOCATOR::ALIGN_SIZE.
+/// @return Zero if the allocator is initialized successfully, or -1 if an error occurred.
+public_function int
+OsCreateTlsfAllocator
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    OS_MEMORY_RANGE host_memory
+)
+{
+    if (((uintptr_t) host_memory.HostAddress & (OS_TLSF_ALLOCATOR::ALIGN_SIZE - 1)) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): TLSF allocator memory must be aligned to %u bytes.\n", __FUNCTION__, OsThreadId(), OS_TLSF_ALLOCATOR::ALIGN_SIZE);
+        return -1;
     }
-    result.FileHandle = fd;
-    result.ResultCode = GetLastError();
-    result.TransferAmount = 0;
-    result.CompletedSynchronously = true;
-    result.WasSuccessful = true;
+    if (host_memory.SizeInBytes < (2 * OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD) + OS_TLSF_ALLOCATOR::BLOCK_SIZE_MIN)
+    {
+        OsLayerError("ERROR: %S(%u): TLSF allocator memory range of %Iu bytes is too small.\n", __FUNCTION__, OsThreadId(), host_memory.SizeInBytes);
+        return -1;
+    }
+    alloc->HostMemory      = host_memory;
+    alloc->AllocationCount = 0;
+    alloc->FreeCount       = 0;
+    alloc->FailedCount     = 0;
+    OsTlsfReset(alloc);
+    return 0;
 }
 
-/// @summary Execute a synchronous or asynchronous read operation.
-/// @param args Information about the read operation. The FileHandle, DataBuffer and TransferAmount fields must be set.
-/// @param result Information returned from the operation specifying the number of bytes transferred and whether the operation completed successfully.
-internal_function void
-OsIoExecuteRead
+/// @summary Allocate memory from a TLSF allocator.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the memory.
+/// @param size The number of bytes being requested.
+/// @param alignment The required alignment of the returned block offset. This must be a power of two.
+/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region.
+/// @return true if the allocator satisfied the request.
+public_function bool
+OsTlsfAllocate
 (
-    OS_IO_OPERATION          &args,
-    OS_IO_OPERATION_RESULT &result
+    OS_TLSF_ALLOCATOR *alloc, 
+    size_t              size, 
+    size_t         alignment, 
+    OS_MEMORY_RANGE   &range
 )
-{   
-    DWORD transferred = 0;
-    // the request is submitted to be performed asynchronously, but can complete
-    // either synchronously or asynchronously. this routine hides that complexity.
-    if (args.Overlapped)
-    {   // populate the required fields of the OVERLAPPED strucure for an asynchronous request.
-        args.Overlapped->Internal     = 0;
-        args.Overlapped->InternalHigh = 0;
-        args.Overlapped->Offset       =(DWORD) (args.FileOffset        & 0xFFFFFFFFUL);
-        args.Overlapped->OffsetHigh   =(DWORD)((args.FileOffset >> 32) & 0xFFFFFFFFUL);
+{
+    uint64_t adjust_size = OsTlsfAdjustRequestSize(size);
+    uint64_t search_size = adjust_size;
+    uint64_t block_offset;
+    uint32_t fl, sl;
+
+    if (adjust_size == 0)
+    {
+        OsLayerError("ERROR: %S(%u): Allocation request for %Iu bytes exceeds maximum of %I64u bytes.\n", __FUNCTION__, OsThreadId(), size, OS_TLSF_ALLOCATOR::BLOCK_SIZE_MAX);
+        goto no_free_block;
     }
-    else if (args.FileOffset >= 0)
-    {   // for synchronous I/O, support implicit seeking within the file.
-        LARGE_INTEGER new_ptr; new_ptr.QuadPart = args.FileOffset;
-        if (!SetFilePointerEx(args.FileHandle, new_ptr, NULL, FILE_BEGIN))
-        {   // the seek operation failed - fail the read operation.
-            result.FileHandle = args.FileHandle;
-            result.ResultCode = GetLastError();
-            result.CompletedSynchronously = true;
-            result.WasSuccessful = false;
-            return;
-        }
+    assert((alignment & (alignment - 1)) == 0);
+    if (alignment > OS_TLSF_ALLOCATOR::ALIGN_SIZE)
+    {   // allow room to split off a leading free block to reach the requested alignment.
+        search_size += alignment + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OS_TLSF_ALLOCATOR::BLOCK_SIZE_MIN;
     }
-    if (ReadFile(args.FileHandle, args.DataBuffer, args.TransferAmount, &transferred, args.Overlapped))
-    {   // the read operation completed synchronously (likely the data was in-cache.)
-        result.FileHandle = args.FileHandle;
-        result.ResultCode = GetLastError();
-        result.TransferAmount = transferred;
-        result.CompletedSynchronously = true;
-        result.WasSuccessful = true;
+
+    // locate a list containing blocks at least as large as search_size.
+    OsTlsfMappingSearch(search_size, fl, sl);
+    if (fl >= OS_TLSF_ALLOCATOR::FL_INDEX_COUNT)
+    {   // the request cannot be satisfied by any block.
+        goto no_free_block;
     }
     else
-    {   // the operation could have failed, or it could be completing asynchronously.
-        // it could also be the case that end-of-file was reached.
-        switch ((result.ResultCode = GetLastError()))
+    {
+        uint32_t sl_map = alloc->SlBitmap[fl] & (~0U << sl);
+        if (sl_map == 0)
+        {   // no suitable block in the second-level lists for fl; move to a larger first-level class.
+            uint32_t fl_map = fl + 1 < 32 ? alloc->FlBitmap & (~0U << (fl + 1)) : 0;
+            if (fl_map == 0)
+                goto no_free_block;
+            fl     = OsBitScanForward64(fl_map);
+            sl_map = alloc->SlBitmap[fl];
+        }
+        sl = OsBitScanForward64(sl_map);
+    }
+    block_offset = alloc->FreeBlocks[fl][sl];
+    OsTlsfRemoveFreeBlock(alloc, block_offset);
+
+    if (alignment > OS_TLSF_ALLOCATOR::ALIGN_SIZE)
+    {   // split off a leading free block so that the payload is aligned.
+        uint64_t payload = block_offset + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD;
+        uint64_t address =(uint64_t)(uintptr_t) alloc->HostMemory.HostAddress + payload;
+        uint64_t     gap = OsAlignUp((size_t) address, alignment) - address;
+        if (gap != 0 && gap < OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OS_TLSF_ALLOCATOR::BLOCK_SIZE_MIN)
+        {   // the gap is too small to hold a free block; move to the next aligned address.
+            gap = OsAlignUp((size_t)(address + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OS_TLSF_ALLOCATOR::BLOCK_SIZE_MIN), alignment) - address;
+        }
+        if (gap != 0)
         {
-            case ERROR_IO_PENDING:
-                { // the request will complete asynchronously.
-                  result.FileHandle = args.FileHandle;
-                  result.TransferAmount = 0;
-                  result.CompletedSynchronously = false;
-                  result.WasSuccessful = true;
-                } break;
-            case ERROR_HANDLE_EOF:
-                { // attempt to read past end-of-file; result.TransferAmount is set to the number of bytes available.
-                  result.FileHandle = args.FileHandle;
-                  result.TransferAmount = transferred;
-                  result.CompletedSynchronously = true;
-                  result.WasSuccessful = true;
-                } break;
-            default:
-                { // an actual error occurred.
-                  result.FileHandle = args.FileHandle;
-                  result.TransferAmount = transferred;
-                  result.CompletedSynchronously = true;
-                  result.WasSuccessful = false;
-                } break;
+            uint64_t aligned_offset = OsTlsfSplitBlock(alloc, block_offset, gap - OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD);
+            OsTlsfBlockAt(alloc, aligned_offset)->SizeAndFlags |= OS_TLSF_ALLOCATOR::BLOCK_PREV_FREE;
+            OsTlsfInsertFreeBlock(alloc, block_offset);
+            block_offset = aligned_offset;
         }
     }
+    OsTlsfMarkBlockUsed(alloc, block_offset);
+    OsTlsfTrimBlock(alloc, block_offset, adjust_size);
+    range.ByteOffset  =(size_t)(block_offset + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD);
+    range.SizeInBytes =(size_t) OsTlsfPayloadSize(OsTlsfBlockAt(alloc, block_offset));
+    alloc->AllocationCount++;
+    alloc->BytesLive += range.SizeInBytes;
+    if (alloc->BytesLive > alloc->BytesPeak)
+        alloc->BytesPeak = alloc->BytesLive;
+    OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_ALLOCATE, range.ByteOffset, range.SizeInBytes, alignment);
+    return true;
+
+no_free_block:
+    range.ByteOffset  = 0;
+    range.SizeInBytes = 0;
+    alloc->FailedCount++;
+    return false;
 }
 
-/// @summary Execute a synchronous or asynchronous write operation.
-/// @param args Information about the write operation. The FileHandle, DataBuffer and TransferAmount fields must be set.
-/// @param result Information returned from the operation specifying the number of bytes transferred and whether the operation completed successfully.
-internal_function void
-OsIoExecuteWrite
+/// @summary Grow or shrink a memory block to meet a desired size.
+/// @param alloc The OS_TLSF_ALLOCATOR managing the allocated range.
+/// @param existing An OS_MEMORY_RANGE describing the existing allocation.
+/// @param new_size The new required minimum allocation size, in bytes.
+/// @param alignment The required alignment of the returned block offset.
+/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region, which may or may not be the same as the existing region.
+/// If the block cannot be resized in-place, the contents of the existing block are copied to the new block and the existing block is freed.
+/// @return true if the allocator satisfied the request.
+public_function bool
+OsTlsfReallocate
 (
-    OS_IO_OPERATION          &args, 
-    OS_IO_OPERATION_RESULT &result
+    OS_TLSF_ALLOCATOR *alloc, 
+    OS_MEMORY_RANGE existing, 
+    size_t          new_size, 
+    size_t         alignment, 
+    OS_MEMORY_RANGE   &range
 )
-{   
-    DWORD transferred = 0;
-    // the request is submitted to be performed asynchronously, but can complete
-    // either synchronously or asynchronously. this routine hides that complexity.
-    if (args.Overlapped)
-    {   // populate the required fields of the OVERLAPPED strucure for an asynchronous request.
-        args.Overlapped->Internal     = 0;
-        args.Overlapped->InternalHigh = 0;
-        args.Overlapped->Offset       =(DWORD) (args.FileOffset        & 0xFFFFFFFFUL);
-        args.Overlapped->OffsetHigh   =(DWORD)((args.FileOffset >> 32) & 0xFFFFFFFFUL);
-    }
-    else if (args.FileOffset >= 0)
-    {   // for synchronous I/O, support implicit seeking within the file.
-        LARGE_INTEGER new_ptr; new_ptr.QuadPart = args.FileOffset;
-        if (!SetFilePointerEx(args.FileHandle, new_ptr, NULL, FILE_BEGIN))
-        {   // the seek operation failed - fail the write operation.
-            result.FileHandle = args.FileHandle;
-            result.ResultCode = GetLastError();
-            result.CompletedSynchronously = true;
-            result.WasSuccessful = false;
-            return;
+{
+    if (existing.SizeInBytes == 0)
+    {   // there is no existing allocation, so this is equivalent to calling OsTlsfAllocate.
+        return OsTlsfAllocate(alloc, new_size, alignment, range);
+    }
+
+    uint64_t   adjust_size = OsTlsfAdjustRequestSize(new_size);
+    uint64_t  block_offset = existing.ByteOffset - OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD;
+    OS_TLSF_BLOCK_HEADER *block = OsTlsfBlockAt(alloc, block_offset);
+    uint8_t       *address = alloc->HostMemory.HostAddress + existing.ByteOffset;
+    if (adjust_size != 0 && ((uintptr_t) address & (alignment - 1)) == 0)
+    {   // the existing block satisfies the alignment requirement, so try to resize in-place.
+        uint64_t  block_size = OsTlsfPayloadSize(block);
+        uint64_t    old_size = block_size;
+        uint64_t next_offset = OsTlsfNextPhysical(alloc, block_offset);
+        OS_TLSF_BLOCK_HEADER *next = OsTlsfBlockAt(alloc, next_offset);
+        if (adjust_size > block_size && (next->SizeAndFlags & OS_TLSF_ALLOCATOR::BLOCK_FREE) && (block_size + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OsTlsfPayloadSize(next)) >= adjust_size)
+        {   // absorb the following free block.
+            OsTlsfRemoveFreeBlock(alloc, next_offset);
+            OsTlsfSetPayloadSize(block, block_size + OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + OsTlsfPayloadSize(next));
+            OsTlsfMarkBlockUsed(alloc, block_offset);
+            OsTlsfBlockAt(alloc, OsTlsfNextPhysical(alloc, block_offset))->PrevPhysical = block_offset;
+            block_size = OsTlsfPayloadSize(block);
+        }
+        if (adjust_size <= block_size)
+        {   // the block is large enough; return any excess space to the allocator.
+            OsTlsfTrimBlock(alloc, block_offset, adjust_size);
+            range.ByteOffset  = existing.ByteOffset;
+            range.SizeInBytes =(size_t) OsTlsfPayloadSize(block);
+            alloc->BytesLive  =  alloc->BytesLive - old_size + range.SizeInBytes;
+            if (alloc->BytesLive > alloc->BytesPeak)
+                alloc->BytesPeak = alloc->BytesLive;
+            OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_REALLOCATE, range.ByteOffset, range.SizeInBytes, alignment);
+            return true;
         }
     }
-    if (WriteFile(args.FileHandle, args.DataBuffer, args.TransferAmount, &transferred, args.Overlapped))
-    {   // the write operation completed synchronously.
-        result.FileHandle = args.FileHandle;
-        result.ResultCode = GetLastError();
-        result.TransferAmount = transferred;
-        result.CompletedSynchronously = true;
-        result.WasSuccessful = true;
+    // no choice but to allocate a new block, copy the data and free the old block.
+    // the block headers are in-band, so the data must be copied before the old block is freed.
+    if (OsTlsfAllocate(alloc, new_size, alignment, range))
+    {
+        size_t copy_size = (size_t) OsTlsfPayloadSize(block);
+        if (copy_size > range.SizeInBytes)
+            copy_size = range.SizeInBytes;
+        OsCopyMemory(alloc->HostMemory.HostAddress + range.ByteOffset, address, copy_size);
+        alloc->FreeCount++;
+        alloc->BytesLive -= OsTlsfPayloadSize(block);
+        OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_FREE, existing.ByteOffset, OsTlsfPayloadSize(block), 0);
+        OsTlsfReleaseBlock(alloc, block_offset);
+        return true;
     }
-    else
-    {   // the operation could have failed, or it could be completing asynchronously.
-        // it could also be the case that end-of-file was reached.
-        switch ((result.ResultCode = GetLastError()))
+    return false;
+}
+
+/// @summary Retrieve the usable size of a block returned by the allocator.
+/// @param alloc The OS_TLSF_ALLOCATOR from which the memory was allocated.
+/// @param block_offset A memory block offset returned by a prior call to OsTlsfAllocate or OsTlsfReallocate.
+/// @return The usable size of the specified block, in bytes.
+public_function size_t
+OsTlsfBlockSize
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    size_t      block_offset
+)
+{
+    return (size_t) OsTlsfPayloadSize(OsTlsfBlockAt(alloc, block_offset - OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD));
+}
+
+/// @summary Free a previously allocated memory range.
+/// @param alloc The OS_TLSF_ALLOCATOR that returned the memory range.
+/// @param range The block offset and size returned by a prior call to OsTlsfAllocate or OsTlsfReallocate.
+public_function void
+OsTlsfFree
+(
+    OS_TLSF_ALLOCATOR *alloc, 
+    OS_MEMORY_RANGE    range
+)
+{
+    if (range.SizeInBytes > 0)
+    {
+        uint64_t block_offset = range.ByteOffset - OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD;
+        uint64_t   block_size = OsTlsfPayloadSize(OsTlsfBlockAt(alloc, block_offset));
+        alloc->FreeCount++;
+        alloc->BytesLive -= block_size;
+        OsAllocationTraceRecord(alloc, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_FREE, range.ByteOffset, block_size, 0);
+        OsTlsfReleaseBlock(alloc, block_offset);
+    }
+}
+
+/// @summary Reset a TLSF allocator back to its initial state, invalidating all existing allocations.
+/// @param alloc The OS_TLSF_ALLOCATOR to reset.
+public_function void
+OsTlsfReset
+(
+    OS_TLSF_ALLOCATOR *alloc
+)
+{   // the range holds one free block followed by a zero-size, permanently in-use sentinel block.
+    uint64_t usable_size = ((uint64_t) alloc->HostMemory.SizeInBytes & ~((uint64_t) OS_TLSF_ALLOCATOR::ALIGN_SIZE - 1)) - (2 * OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD);
+    if (usable_size > OS_TLSF_ALLOCATOR::BLOCK_SIZE_MAX)
+    {   // the remainder of the range is unused.
+        usable_size = OS_TLSF_ALLOCATOR::BLOCK_SIZE_MAX;
+    }
+    OS_TLSF_BLOCK_HEADER *block    = OsTlsfBlockAt(alloc, 0);
+    OS_TLSF_BLOCK_HEADER *sentinel = OsTlsfBlockAt(alloc, OS_TLSF_ALLOCATOR::BLOCK_OVERHEAD + usable_size);
+    alloc->BytesFree = 0;
+    alloc->BytesLive = 0;
+    alloc->BytesPeak = 0;
+    alloc->FlBitmap  = 0;
+    for (uint32_t fl = 0; fl < OS_TLSF_ALLOCATOR::FL_INDEX_COUNT; ++fl)
+    {
+        alloc->SlBitmap[fl] = 0;
+        for (uint32_t sl = 0; sl < OS_TLSF_ALLOCATOR::SL_INDEX_COUNT; ++sl)
         {
-            case ERROR_IO_PENDING:
-                { // the request will complete asynchronously.
-                  result.FileHandle = args.FileHandle;
-                  result.TransferAmount = 0;
-                  result.CompletedSynchronously = false;
-                  result.WasSuccessful = true;
-                } break;
-            default:
-                { // an actual error occurred.
-                  result.FileHandle = args.FileHandle;
-                  result.TransferAmount = transferred;
-                  result.CompletedSynchronously = true;
-                  result.WasSuccessful = false;
-                } break;
+            alloc->FreeBlocks[fl][sl] = OS_TLSF_ALLOCATOR::NULL_OFFSET;
         }
     }
+    block->PrevPhysical    = OS_TLSF_ALLOCATOR::NULL_OFFSET;
+    block->SizeAndFlags    = usable_size | OS_TLSF_ALLOCATOR::BLOCK_FREE;
+    sentinel->PrevPhysical = 0;
+    sentinel->SizeAndFlags = OS_TLSF_ALLOCATOR::BLOCK_PREV_FREE;
+    OsTlsfInsertFreeBlock(alloc, 0);
+}
+
+/// @summary Retrieve statistics for a TLSF allocator. LargestFreeBlock is the size of a block in the largest non-empty free list.
+/// @param alloc The OS_TLSF_ALLOCATOR to query.
+/// @param stats On return, the statistics for the allocator.
+public_function void
+OsTlsfAllocatorQueryStats
+(
+    OS_TLSF_ALLOCATOR  *alloc, 
+    OS_ALLOCATOR_STATS *stats
+)
+{
+    stats->AllocationCount  = alloc->AllocationCount;
+    stats->FreeCount        = alloc->FreeCount;
+    stats->FailedCount      = alloc->FailedCount;
+    stats->BytesLive        = alloc->BytesLive;
+    stats->BytesPeak        = alloc->BytesPeak;
+    stats->BytesFree        = alloc->BytesFree;
+    stats->LargestFreeBlock = 0;
+    stats->BytesReserved    = alloc->HostMemory.SizeInBytes;
+    stats->BytesCommitted   = alloc->HostMemory.SizeInBytes;
+    stats->CommitCount      = 0;
+    if (alloc->FlBitmap != 0)
+    {
+        uint32_t fl = OsBitScanReverse64(alloc->FlBitmap);
+        uint32_t sl = OsBitScanReverse64(alloc->SlBitmap[fl]);
+        stats->LargestFreeBlock = OsTlsfPayloadSize(OsTlsfBlockAt(alloc, alloc->FreeBlocks[fl][sl]));
+    }
+}
+
+/// @summary Reserve process address space for a memory arena. By default, no address space is committed.
+/// @param arena The OS_HOST_MEMORY_ARENA to initialize.
+/// @param host_memory The address and size of the host-visible memory block to sub-allocate from.
+/// @return Zero if the arena is initialized, or -1 if an error occurred.
+public_function inline int
+OsCreateHostMemoryArena
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    OS_MEMORY_RANGE host_memory
+)
+{   assert(host_memory.HostAddress != NULL);
+    assert(host_memory.SizeInBytes >  0);
+    size_t page_size = 0;
+    size_t granularity = 0;
+    OsVmmQueryPageSize(page_size, granularity);
+    arena->HostMemory   = host_memory;
+    arena->ResidentSize = 0;
+    arena->PageSize     = page_size;
+    return OsCreateArenaAllocator(&arena->Allocator, host_memory.SizeInBytes);
+}
+
+/// @summary Release process address space reserved for a memory arena. All allocations are invalidated.
+/// @param arena The memory arena to delete.
+public_function inline void
+OsDeleteHostMemoryArena
+(
+    OS_HOST_MEMORY_ARENA *arena
+)
+{
+    OsDeleteArenaAllocator(&arena->Allocator);
+    OsZeroMemory(arena, sizeof(OS_HOST_MEMORY_ARENA));
+}
+
+/// @summary Determine whether a memory allocation request can be satisfied.
+/// @param arena The memory arena to query.
+/// @param size The size of the allocation request, in bytes.
+/// @param alignment The desired alignment of the returned address. This must be a power of two greater than zero.
+/// @return true if the specified allocation will succeed.
+public_function inline bool
+OsHostMemoryArenaCanSatisfyAllocation
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t                 size,
+    size_t            alignment
+)
+{
+    return OsArenaAllocatorCanSatisfyAllocation(&arena->Allocator, size, alignment);
+}
+
+/// @summary Determine whether a memory allocation request can be satisfied.
+/// @typeparam T The type being allocated. This type is used to determine the required alignment.
+/// @param arena The memory arena to query.
+/// @return true if the specified allocation will succeed.
+template <typename T>
+public_function inline bool
+OsHostMemoryArenaCanAllocate
+(
+    OS_HOST_MEMORY_ARENA *arena
+)
+{
+    return OsArenaAllocatorCanSatisfyAllocation(&arena->Allocator, sizeof(T), std::alignment_of<T>::value);
+}
+
+/// @summary Determine whether a memory allocation request for an array can be satisfied.
+/// @typeparam T The type of array element. This type is used to determine the required alignment.
+/// @param arena The memory arena to query.
+/// @param count The number of items in the array.
+/// @return true if the specified allocation will succeed.
+template <typename T>
+public_function inline bool
+OsHostMemoryArenaCanAllocateArray
+(
+    OS_HOST_MEMORY_ARENA *arena,
+    size_t                count
+)
+{
+    return OsArenaAllocatorCanSatisfyAllocation(&arena->Allocator, sizeof(T) * count, std::alignment_of<T>::value);
 }
 
-/// @summary Execute a synchronous flush operation.
-/// @param args Information about the flush operation. The FileHandle field must be set.
-/// @param result Information returned from the operation specifying whether the operation completed successfully.
-internal_function void
-OsIoExecuteFlush
+/// @summary Allocate memory from an arena. Additional address space is committed up to the initial reservation size.
+/// @param arena The memory arena to allocate from.
+/// @param size The minimum number of bytes to allocate.
+/// @param alignment A power-of-two, greater than or equal to 1, specifying the alignment of the returned address.
+/// @return A pointer to the start of the allocated block, or NULL if the request could not be satisfied.
+public_function inline void*
+OsHostMemoryArenaAllocate
 (
-    OS_IO_OPERATION          &args, 
-    OS_IO_OPERATION_RESULT &result
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t                 size, 
+    size_t            alignment
 )
 {
-    if (FlushFileBuffers(args.FileHandle))
-    {
-        result.FileHandle = args.FileHandle;
-        result.ResultCode = GetLastError();
-        result.TransferAmount = 0;
-        result.CompletedSynchronously = true;
-        result.WasSuccessful = true;
-    }
-    else
-    {
-        result.FileHandle = args.FileHandle;
-        result.ResultCode = GetLastError();
-        result.TransferAmount = 0;
-        result.CompletedSynchronously = true;
-        result.WasSuccessful = false;
+    OS_MEMORY_RANGE r;
+    if (OsArenaAllocate(&arena->Allocator, size, alignment, r))
+    {   // the allocation was successful. convert offset to address.
+        return (uint8_t*) arena->HostMemory.HostAddress + r.ByteOffset;
     }
+    return NULL;
 }
 
-/// @summary Execute a synchronous file close operation.
-/// @param args Information about the close operation. The FileHandle field must be set.
-/// @param result Information returned from the operation specifying whether the operation completed successfully.
-internal_function void
-OsIoExecuteClose
+/// @summary Allocate memory for a structure.
+/// @typeparam T The type being allocated. This type is used to determine the required alignment.
+/// @param arena The memory arena to allocate from.
+/// @return A pointer to the new structure, or nullptr if the arena could not satisfy the allocation request.
+template <typename T>
+public_function inline T*
+OsHostMemoryArenaAllocate
 (
-    OS_IO_OPERATION          &args, 
-    OS_IO_OPERATION_RESULT &result
+    OS_HOST_MEMORY_ARENA *arena
 )
 {
-    if (CloseHandle(args.FileHandle))
-    {
-        result.FileHandle = args.FileHandle;
-        result.ResultCode = GetLastError();
-        result.TransferAmount = 0;
-        result.CompletedSynchronously = true;
-        result.WasSuccessful = true;
-    }
-    else
-    {
-        result.FileHandle = args.FileHandle;
-        result.ResultCode = GetLastError();
-        result.TransferAmount = 0;
-        result.CompletedSynchronously = true;
-        result.WasSuccessful = false;
-    }
+    return (T*) OsHostMemoryArenaAllocate(arena, sizeof(T), std::alignment_of<T>::value);
 }
 
-/// @summary Prepare an OS_IO_RESULT to pass to the I/O completion callback after executing an I/O operation.
-/// @param result The OS_IO_RESULT structure to populate.
-/// @param request The OS_IO_REQUEST describing the I/O operation.
-/// @param opres The OS_IO_OPERATION_RESULT describing the completion of the I/O operation.
-internal_function void
-OsIoPrepareResult
+/// @summary Allocate memory for an array of structures.
+/// @typeparam T The type of array element. This type is used to determine the required alignment.
+/// @param arena The memory arena to allocate from.
+/// @param count The number of items to allocate.
+/// @return A pointer to the start of the array, or nullptr if the arena could not satisfy the allocation request.
+template <typename T>
+public_function inline T*
+OsHostMemoryArenaAllocateArray
 (
-    OS_IO_RESULT          &result,
-    OS_IO_REQUEST        *request, 
-    OS_IO_OPERATION_RESULT &opres
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t                count
 )
-{   // NOTE: this routine intentionally prepares the result to pass through as much
-    // data as possible, even if that data might not have been needed for the request.
-    result.RequestType = request->RequestType;
-    result.ResultCode  = opres.ResultCode;
-    result.UserContext = request->UserContext;
-    result.FileHandle  = opres.FileHandle;
-    result.PathBuffer  = request->PathBuffer;
-    result.DataBuffer  = request->DataBuffer;
-    result.DataAmount  = opres.TransferAmount;
-    result.BaseOffset  = request->BaseOffset;
-    result.FileOffset  = request->FileOffset;
+{
+    return (T*) OsHostMemoryArenaAllocate(arena, sizeof(T) * count, std::alignment_of<T>::value);
 }
 
-/// @summary Execute an I/O request. The request may complete synchronously or asynchronously.
-/// @param request The I/O request to execute.
-/// @param completion_port The I/O completion port to associate with the request.
-/// @param opres The structure to populate with the result of the I/O operation.
-/// @param result The structure to populate with the result of the I/O request.
-internal_function void
-OsIoExecuteRequest
+/// @summary Retrieve an exact marker that can be used to reset or decommit the arena, preserving all current allocations.
+/// @param arena The memory arena to query.
+/// @return The marker representing the byte offset of the next allocation.
+public_function inline os_arena_marker_t
+OsHostMemoryArenaMark
 (
-    OS_IO_REQUEST         *request, 
-    HANDLE         completion_port,
-    OS_IO_OPERATION_RESULT  &opres, 
-    OS_IO_RESULT           &result
+    OS_HOST_MEMORY_ARENA *arena
 )
 {
-    switch (request->RequestType)
-    {
-        case OS_IO_REQUEST_NOOP:
-            { // there's no actual I/O operation to perform.
-              opres.FileHandle             = request->FileHandle;
-              opres.ResultCode             = ERROR_SUCCESS;
-              opres.TransferAmount         = 0;
-              opres.CompletedSynchronously = true;
-              opres.WasSuccessful          = true;
-              OsIoPrepareResult(result, request, opres);
-            } break;
-        case OS_IO_REQUEST_OPEN_FILE:
-            { // populate the operation request for the file open operation.
-              // open operations return more data than most requests, and are always performed synchronously.
-              FILE_STANDARD_INFO  fsi = {};
-              OS_IO_OPERATION   opreq = {};
-              size_t      sector_size = 0;
-              opreq.FilePath          = request->PathBuffer;
-              opreq.FileHandle        = INVALID_HANDLE_VALUE;
-              opreq.CompletionPort    = completion_port;
-              opreq.Overlapped        = NULL;
-              opreq.DataBuffer        = NULL;
-              opreq.FileOffset        = 0;
-              opreq.PreallocationSize = request->DataAmount;
-              opreq.TransferAmount    = 0;
-              opreq.IoHintFlags       = request->IoHintFlags;
-              OsIoExecuteOpen(opreq, opres, &fsi, &sector_size);
-              OsIoPrepareResult(result, request, opres);
-              result.FileSize = fsi.EndOfFile.QuadPart;
-              result.PhysicalSectorSize = sector_size;
-            } break;
-        case OS_IO_REQUEST_READ_FILE:
-            { // read requests may complete asynchronously.
-              OS_IO_OPERATION   opreq = {};
-              opreq.FilePath          = NULL;
-              opreq.FileHandle        = request->FileHandle;
-              opreq.CompletionPort    = NULL;
-              opreq.Overlapped        =&request->Overlapped;
-              opreq.DataBuffer        = request->DataBuffer;
-              opreq.FileOffset        = request->BaseOffset + request->FileOffset;
-              opreq.PreallocationSize = 0;
-              opreq.TransferAmount    =(uint32_t) request->DataAmount;
-              opreq.IoHintFlags       = OS_IO_HINT_FLAGS_NONE;
-              OsIoExecuteRead(opreq, opres);
-              OsIoPrepareResult(result, request, opres);
-            } break;
-        case OS_IO_REQUEST_WRITE_FILE:
-            { // write requests may complete asynchronously.
-              OS_IO_OPERATION   opreq = {};
-              opreq.FilePath          = NULL;
-              opreq.FileHandle        = request->FileHandle;
-              opreq.CompletionPort    = NULL;
-              opreq.Overlapped        =&request->Overlapped;
-              opreq.DataBuffer        = request->DataBuffer;
-              opreq.FileOffset        = request->BaseOffset + request->FileOffset;
-              opreq.PreallocationSize = 0;
-              opreq.TransferAmount    =(uint32_t) request->DataAmount;
-              opreq.IoHintFlags       = OS_IO_HINT_FLAGS_NONE;
-              OsIoExecuteWrite(opreq, opres);
-              OsIoPrepareResult(result, request, opres);
-            } break;
-        case OS_IO_REQUEST_FLUSH_FILE:
-            { // populate the operation request for the flush operation.
-              // flush operations are always performed synchronously.
-              OS_IO_OPERATION   opreq = {};
-              opreq.FilePath          = NULL;
-              opreq.FileHandle        = request->FileHandle;
-              opreq.CompletionPort    = NULL;
-              opreq.Overlapped        = NULL;
-              opreq.DataBuffer        = NULL;
-              opreq.FileOffset        = 0;
-              opreq.PreallocationSize = 0;
-              opreq.TransferAmount    = 0;
-              opreq.IoHintFlags       = OS_IO_HINT_FLAGS_NONE;
-              OsIoExecuteFlush(opreq, opres);
-              OsIoPrepareResult(result, request, opres);
-            } break;
-        case OS_IO_REQUEST_CLOSE_FILE:
-            { // populate the operation request for the close operation.
-              // close operations are always performed synchronously.
-              OS_IO_OPERATION   opreq = {};
-              opreq.FilePath          = NULL;
-              opreq.FileHandle        = request->FileHandle;
-              opreq.CompletionPort    = NULL;
-              opreq.Overlapped        = NULL;
-              opreq.DataBuffer        = NULL;
-              opreq.FileOffset        = 0;
-              opreq.PreallocationSize = 0;
-              opreq.TransferAmount    = 0;
-              opreq.IoHintFlags       = OS_IO_HINT_FLAGS_NONE;
-              OsIoExecuteClose(opreq, opres);
-              OsIoPrepareResult(result, request, opres);
-            } break;
-        default:
-            { // don't know what this is - just pass through data.
-              opres.FileHandle             = request->FileHandle;
-              opres.ResultCode             = ERROR_SUCCESS;
-              opres.TransferAmount         = 0;
-              opres.CompletedSynchronously = true;
-              opres.WasSuccessful          = true;
-              OsIoPrepareResult(result, request, opres);
-            } break;
-    }
+    return OsArenaMark(&arena->Allocator);
 }
 
-/// @summary Return an I/O request to the pool it was allocated from.
-/// @param request The I/O request to return.
-internal_function void
-OsReturnIoRequest
+/// @summary Resets the state of the arena back to a marker, without decommitting any memory.
+/// @param arena The memory arena to reset.
+/// @param arena_marker The marker value returned by OsHostMemoryArenaMark().
+public_function inline void
+OsHostMemoryArenaResetToMarker
+(
+    OS_HOST_MEMORY_ARENA    *arena,
+    os_arena_marker_t arena_marker
+)
+{
+    OsArenaResetToMarker(&arena->Allocator, arena_marker);
+}
+
+/// @summary Resets the state of the arena to empty, without decomitting any memory.
+/// @param arena The memory arena to reset.
+public_function inline void
+OsHostMemoryArenaReset
 (
-    OS_IO_REQUEST *request
+    OS_HOST_MEMORY_ARENA *arena
 )
 {
-    EnterCriticalSection(&request->RequestPool->ListLock);
-    {   // remove the node from the live list.
-        if (request->NextRequest != NULL)
-            request->NextRequest->PrevRequest = request->PrevRequest;
-        if (request->PrevRequest != NULL)
-            request->PrevRequest->NextRequest = request->NextRequest;
-        // push the node into the front of the free list.
-        request->NextRequest = request->RequestPool->FreeRequest;
-        request->PrevRequest = NULL;
-        request->RequestPool->FreeRequest = request;
-    }
-    LeaveCriticalSection(&request->RequestPool->ListLock);
+    OsArenaReset(&arena->Allocator);
 }
 
-/// @summary Retrieve the OS_IO_REQUEST for an OVERLAPPED address passed back from GetQueuedCompletionStatus.
-/// @param overlapped The OVERLAPPED instance corresponding to a completed request.
-/// @return The associated OS_IO_REQUEST.
-internal_function inline OS_IO_REQUEST*
-OsIoRequestForOVERLAPPED
+/// @summary Retrieve the largest number of bytes allocated from an arena since it was created or last trimmed.
+/// @param arena The memory arena to query.
+/// @return The high-water mark of the arena, in bytes.
+public_function inline size_t
+OsHostMemoryArenaHighWaterMark
 (
-    OVERLAPPED *overlapped
+    OS_HOST_MEMORY_ARENA *arena
 )
 {
-    return ((OS_IO_REQUEST*)(((uint8_t*) overlapped) - offsetof(OS_IO_REQUEST, Overlapped)));
+    return arena->Allocator.HighWaterMark;
 }
 
-/// @summary Implement the entry point of an I/O worker thread.
-/// @param argp An OS_IO_THREAD_INIT instance specifying data that should be copied to thread-local memory.
-/// @return The function always returns 1.
-internal_function unsigned int __cdecl
-OsIoThreadMain
+/// @summary Return physical pages above a watermark to the operating system. The address space remains committed and usable.
+/// Trimming only takes effect if the number of bytes that would be released is at least the hysteresis amount, so that 
+/// steady-state usage that fluctuates slightly around the watermark does not repeatedly pay for page faults.
+/// Only VMM pages lying entirely within the arena memory range are released, so arenas sub-allocated from a larger block are safe to trim.
+/// @param arena The memory arena to trim.
+/// @param watermark The number of bytes at the start of the arena to keep resident. Pages holding live allocations are never trimmed.
+/// @param hysteresis The minimum number of bytes that must be releasable for the trim to take place.
+/// @return The number of bytes returned to the operating system.
+public_function size_t
+OsHostMemoryArenaTrim
 (
-    void *argp
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t            watermark, 
+    size_t           hysteresis
 )
 {
-    OS_IO_THREAD_INIT   init = {};
-    OS_IO_THREAD_POOL  *pool = NULL;
-    OVERLAPPED           *ov = NULL;
-    uintptr_t thread_context = 0;
-    uintptr_t        context = 0;
-    uintptr_t            key = 0;
-    HANDLE       term_signal = NULL;
-    HANDLE              iocp = NULL;
-    LARGE_INTEGER  frequency = {};
-    DWORD                tid = GetCurrentThreadId();
-    DWORD             nbytes = 0;
-    DWORD             termrc = 0;
-    unsigned int   exit_code = 1;
-
-    // copy the initialization data into local stack memory.
-    // argp may have been allocated on the stack of the caller 
-    // and is only guaranteed to remain valid until ReadySignal is set.
-    CopyMemory(&init, argp, sizeof(OS_IO_THREAD_INIT));
-    term_signal = init.TerminateSignal;
-    context     = init.PoolContext;
-    iocp        = init.CompletionPort;
-    pool        = init.ThreadPool;
-
-    // retrieve the system clock frequency for converting ticks to nanoseconds.
-    QueryPerformanceFrequency(&frequency);
-
-    // spit out a message just prior to initialization:
-    OsLayerOutput("START: %S(%u): I/O thread starting on pool 0x%p.\n", __FUNCTION__, tid, pool);
-
-    // perform application-level per-thread initialization.
-    if (init.ThreadInit(pool, context, tid, &thread_context) < 0)
-    {
-        OsLayerError("ERROR: %S(%u): I/O thread initialization failed on pool 0x%p.\n", __FUNCTION__, tid, pool);
-        OsLayerError("DEATH: %S(%u): I/O thread terminating in pool 0x%p.\n", __FUNCTION__, tid, pool);
-        SetEvent(init.ErrorSignal);
+    uint8_t   *base = arena->HostMemory.HostAddress;
+    size_t resident = arena->ResidentSize;
+    size_t     keep = watermark;
+    uint8_t  *start = NULL;
+    uint8_t    *end = NULL;
+
+    // account for any pages touched since the last trim.
+    if (resident < arena->Allocator.HighWaterMark)
+        resident = arena->Allocator.HighWaterMark;
+    if (keep < arena->Allocator.NextOffset)
+        keep = arena->Allocator.NextOffset;
+    if (keep > arena->HostMemory.SizeInBytes)
+        keep = arena->HostMemory.SizeInBytes;
+
+    // only whole pages can be discarded.
+    start = (uint8_t*) OsAlignUp  ((size_t)(base + keep), arena->PageSize);
+    end   = (uint8_t*)((size_t)(base + resident) & ~(arena->PageSize - 1));
+    arena->ResidentSize = resident;
+    arena->Allocator.HighWaterMark = arena->Allocator.NextOffset;
+    if (start >= end || size_t(end - start) < hysteresis)
+    {   // there isn't enough above the watermark to be worth releasing.
+        return 0;
+    }
+    if (!OsVmmDiscard(start, size_t(end - start)))
+    {   // OsVmmDiscard output error information already.
         return 0;
     }
+    arena->ResidentSize = size_t(start - base);
+    return size_t(end - start);
+}
 
-    // signal the main thread that this thread is ready to run.
-    SetEvent(init.ReadySignal);
+/// @summary Return physical pages above the high-water mark of the arena to the operating system, and begin a new observation window.
+/// Call this periodically (for example, once every few hundred frames) so that pages committed during a one-off spike are released,
+/// while the peak usage of the most recent window remains resident.
+/// @param arena The memory arena to trim.
+/// @param hysteresis The minimum number of bytes that must be releasable for the trim to take place.
+/// @return The number of bytes returned to the operating system.
+public_function size_t
+OsHostMemoryArenaTrimToHighWaterMark
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t           hysteresis
+)
+{
+    return OsHostMemoryArenaTrim(arena, arena->Allocator.HighWaterMark, hysteresis);
+}
 
-    __try
-    {   // enter the main I/O loop. the thread waits for an event to be available on the completion port.
-        for ( ; ; )
-        {   // prior to possibly entering a wait state, check the termination signal.
-            if ((termrc = WaitForSingleObject(term_signal, 0)) != WAIT_TIMEOUT)
-            {   // either termination was signaled, or an error occurred.
-                // either way, exit prior to entering the wait state.
-                if (termrc != WAIT_OBJECT_0)
-                {   // an error occurred while checking the termination signal.
-                    OsLayerError("ERROR: %S(%u): Checking termination signal failed with result 0x%08X (0x%08X).\n", __FUNCTION__, tid, termrc, GetLastError());
-                }
-                break;
-            }
-            // wait for an event on the completion port.
-            if (GetQueuedCompletionStatus(iocp, &nbytes, &key, &ov, INFINITE))
-            {   // check the termination signal prior to processing the request.
-                if ((termrc = WaitForSingleObject(term_signal, 0)) != WAIT_TIMEOUT)
-                {   // either termination was signaled, or an error occurred.
-                    if (termrc != WAIT_OBJECT_0)
-                    {   // an error occurred while checking the termination signal.
-                        OsLayerError("ERROR: %S(%u): Checking termination signal failed with result 0x%08X (0x%08X).\n", __FUNCTION__, tid, termrc, GetLastError());
-                    }
-                    break;
-                }
-                if (key == OS_COMPLETION_KEY_SHUTDOWN)
-                {
-                    OsLayerOutput("EVENT: %S(%u): I/O worker received shutdown signal.\n", __FUNCTION__, tid);
-                    break;
-                }
+/// @summary Retrieve statistics for a memory arena. BytesCommitted reports the number of bytes that may be backed by physical pages.
+/// @param arena The memory arena to query.
+/// @param stats On return, the statistics for the arena.
+public_function void
+OsHostMemoryArenaQueryStats
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    OS_ALLOCATOR_STATS   *stats
+)
+{
+    OsArenaAllocatorQueryStats(&arena->Allocator, stats);
+    stats->BytesCommitted = arena->ResidentSize > arena->Allocator.HighWaterMark ? arena->ResidentSize : arena->Allocator.HighWaterMark;
+}
 
-                OS_IO_REQUEST *request = OsIoRequestForOVERLAPPED(ov);
-                while (request != NULL)
-                {
-                    switch (request->RequestState)
-                    {
-                        case OS_IO_REQUEST_STATE_CHAINED:
-                        case OS_IO_REQUEST_STATE_SUBMITTED:
-                            { // launch the I/O operation. it may complete asynchronously.
-                              OS_IO_RESULT result;
-                              OS_IO_OPERATION_RESULT opres;
-                              OS_IO_REQUEST *chained = NULL;
-                              request->RequestState  = OS_IO_REQUEST_STATE_LAUNCHED;
-                              request->IoLaunchTime  = OsTimestampInTicks();
-                              OsIoExecuteRequest(request, iocp, opres, result);
-                              if (opres.CompletedSynchronously)
-                              {   // update the request state and execute the completion callback.
-                                  // there should be no additional events reported for this request.
-                                  request->RequestState = OS_IO_REQUEST_STATE_COMPLETED;
-                                  request->IoFinishTime = OsTimestampInTicks();
-                                  if (request->IoComplete != NULL)
-                                  {   // the request may return a chained request from its completion callback.
-                                      OS_IO_REQUEST_CONTEXT ctx;
-                                      OS_IO_PROFILE     profile;
-                                      ctx.RequestPool          = request->RequestPool;
-                                      ctx.ThreadPool           = pool;
-                                      ctx.PoolContext          = context;
-                                      ctx.ThreadContext        = thread_context;
-                                      profile.QueueDelay       = OsElapsedNanoseconds(request->IoSubmitTime, request->IoLaunchTime, frequency.QuadPart);
-                                      profile.ExecutionTime    = OsElapsedNanoseconds(request->IoLaunchTime, request->IoFinishTime, frequency.QuadPart);
-                                      profile.OsThreadId       = tid;
-                                      chained = request->IoComplete(opres.WasSuccessful, &result, &ctx, &profile);
-                                  }
-                                  OsReturnIoRequest(request);
-                                  request = chained;
-                              }
-                              else
-                              {   // since the request hasn't completed, there is no chained request.
-                                  // don't return the request until it completes.
-                                  request = NULL;
-                              }
-                            } break;
-                        case OS_IO_REQUEST_STATE_LAUNCHED:
-                            { // the asynchronous read or write operation has completed.
-                              OS_IO_RESULT    result;
-                              OS_IO_REQUEST *chained = NULL;
-                              DWORD      result_code = ERROR_SUCCESS;
-                              bool    was_successful = true;
-                              if (!GetOverlappedResult(request->FileHandle, ov, &nbytes, FALSE))
-                              {   // the I/O request may have completed unsuccessfully.
-                                  if ((result_code   = GetLastError()) != ERROR_HANDLE_EOF)
-                                      was_successful = false;
-                              }
-                              request->RequestState  = OS_IO_REQUEST_STATE_COMPLETED;
-                              request->IoFinishTime  = OsTimestampInTicks();
-                              result.RequestType     = request->RequestType;
-                              result.ResultCode      = result_code;
-                              result.UserContext     = request->UserContext;
-                              result.FileHandle      = request->FileHandle;
-                              result.PathBuffer      = request->PathBuffer;
-                              result.DataBuffer      = request->DataBuffer;
-                              result.DataAmount      = nbytes;
-                              result.BaseOffset      = request->BaseOffset;
-                              result.FileOffset      = request->FileOffset;
-                              if (request->IoComplete != NULL)
-                              {   // the request may return a chained request from its completion callback.
-                                  OS_IO_REQUEST_CONTEXT ctx;
-                                  OS_IO_PROFILE     profile;
-                                  ctx.RequestPool          = request->RequestPool;
-                                  ctx.ThreadPool           = pool;
-                                  ctx.PoolContext          = context;
-                                  ctx.ThreadContext        = thread_context;
-                                  profile.QueueDelay       = OsElapsedNanoseconds(request->IoSubmitTime, request->IoLaunchTime, frequency.QuadPart);
-                                  profile.ExecutionTime    = OsElapsedNanoseconds(request->IoLaunchTime, request->IoFinishTime, frequency.QuadPart);
-                                  profile.OsThreadId       = tid;
-                                  chained = request->IoComplete(was_successful, &result, &ctx, &profile);
-                              }
-                              OsReturnIoRequest(request);
-                              request = chained;
-                            } break;
-                        case OS_IO_REQUEST_STATE_COMPLETED:
-                            { OsLayerError("ERROR: %S(%u): I/O thread received already completed request %p from pool %p.\n", __FUNCTION__, GetCurrentThreadId(), request, request->RequestPool);
-                              OsReturnIoRequest(request);
-                            } break;
-                        default:
-                            { OsLayerError("ERROR: %S(%u): I/O thread received request %p from pool %p with unknown state %d.\n", __FUNCTION__, GetCurrentThreadId(), request, request->RequestPool, request->RequestState);
-                            } break;
-                    }
-                }
-            }
-        }
-    }
-    __finally
-    {   // the I/O thread is terminating - clean up thread-local resources.
-        // ...
-        // spit out a message just prior to termination.
-        OsLayerError("DEATH: %S(%u): I/O thread terminating in pool 0x%p.\n", __FUNCTION__, tid, init.ThreadPool);
-        return exit_code;
-    }
+/// @summary Compute a 64-bit hash of an integer key for use with OS_HASH_SET and OS_HASH_MAP. This is the MurmurHash3 64-bit finalizer, 
+/// which spreads every input bit across the output so that sequential keys map to unrelated groups.
+/// @param key The key to hash.
+/// @return The hash value.
+public_function inline uint64_t
+OsHashKey
+(
+    uint64_t key
+)
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ULL;
+    key ^= key >> 33;
+    return key;
 }
 
-/// @summary Search a list of layers for a given layer name to determine if a layer is supported.
-/// @param layer_name A zero-terminated ASCII string specifying the registered name of the layer to locate.
-/// @param layer_list The list of layer properties to search.
-/// @param layer_count The number of layer properties to search.
-/// @param layer_index If non-NULL, and the named layer is supported, this location is updated with the zero-based index of the layer in the list.
-/// @return The layer name string (of the associated VkLayerProperties), if supported; otherwise, NULL.
-internal_function char const*
-OsSupportsVulkanLayer
+/// @summary Compute a 64-bit hash of an integer key for use with OS_HASH_SET and OS_HASH_MAP.
+/// @param key The key to hash.
+/// @return The hash value.
+public_function inline uint64_t
+OsHashKey
 (
-    char              const *layer_name,
-    VkLayerProperties const *layer_list, 
-    size_t                   layer_count, 
-    size_t                  *layer_index=NULL
+    int64_t key
 )
 {
-    char const *s = NULL;
-    for (size_t i = 0; i < layer_count; ++i)
-    {
-        if ((s = OsStringSearch(layer_list[i].layerName, layer_name)) != NULL)
-        {
-            if (layer_index != NULL) *layer_index = i;
-            return s;
-        }
-    }
-    return NULL;
+    return OsHashKey((uint64_t) key);
 }
 
-/// @summary Search a list of extensions for a given extension name to determine if an extension is supported.
-/// @param extension_name A zero-terminated ASCII string specifying the registered name of the extension to locate.
-/// @param extension_list The list of extension properties to search.
-/// @param extension_count The number of extension properties to search.
-/// @param extension_index If non-NULL, and the named extension is supported, this location is updated with the zero-based index of the extension in the list.
-/// @return The extension name string (of the associated VkExtensionProperties), if supported; otherwise, NULL.
-internal_function char const*
-OsSupportsVulkanExtension
+/// @summary Compute a 64-bit hash of an integer key for use with OS_HASH_SET and OS_HASH_MAP.
+/// @param key The key to hash.
+/// @return The hash value.
+public_function inline uint64_t
+OsHashKey
+(
+    uint32_t key
+)
+{
+    return OsHashKey((uint64_t) key);
+}
+
+/// @summary Compute a 64-bit hash of an integer key for use with OS_HASH_SET and OS_HASH_MAP.
+/// @param key The key to hash.
+/// @return The hash value.
+public_function inline uint64_t
+OsHashKey
+(
+    int32_t key
+)
+{
+    return OsHashKey((uint64_t)(uint32_t) key);
+}
+
+/// @summary Compute a 64-bit hash of a pointer key for use with OS_HASH_SET and OS_HASH_MAP. The address is hashed, not the data it points to.
+/// @param key The key to hash.
+/// @return The hash value.
+public_function inline uint64_t
+OsHashKey
 (
-    char                  const *extension_name,
-    VkExtensionProperties const *extension_list, 
-    size_t                       extension_count, 
-    size_t                      *extension_index=NULL
+    void const *key
 )
 {
-    char const *s = NULL;
-    for (size_t i = 0; i < extension_count; ++i)
-    {
-        if ((s = OsStringSearch(extension_list[i].extensionName, extension_name)) != NULL)
-        {
-            if (extension_index != NULL) *extension_index = i;
-            return s;
-        }
-    }
-    return NULL;
+    return OsHashKey((uint64_t)(uintptr_t) key);
 }
 
-/// @summary Search a list of extension names for a specific extension name string.
-/// @param extension_name A zero-terminated ASCII string specifying the registered name of the extension to locate.
-/// @param extension_list The list of zero-terminated ASCII extension name strings to search.
-/// @param extension_count The number of zero-terminated ASCII strings in the extension_list.
-/// @return true if the named extension was found in the specified extension list.
-internal_function bool
-OsSupportsNamedExtension
+/// @summary Compute a 64-bit hash of a nul-terminated string key for use with OS_HASH_SET and OS_HASH_MAP. The string contents are hashed.
+/// The string is hashed with 64-bit FNV-1a, and the result is mixed so that the low and high bits are both well distributed.
+/// @param key The nul-terminated string to hash.
+/// @return The hash value.
+public_function inline uint64_t
+OsHashKey
 (
-    char   const         *extension_name, 
-    char   const * const *extension_list, 
-    size_t const          extension_count
+    char const *key
 )
 {
-    for (size_t i = 0; i < extension_count; ++i)
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    while (*key != '\0')
     {
-        if (OsStringSearch(extension_list[i], extension_name) != NULL)
-            return true;
+        hash ^= (uint8_t) *key++;
+        hash *= 0x100000001B3ULL;
     }
-    return false;
+    return OsHashKey(hash);
 }
 
-/// @summary Determine whether the application has enabled an instance-level extension.
-/// @param extension_name A zero-terminated ASCII string specifying the registered name of the extension to locate.
-/// @param create_info The application-provided VkInstanceCreateInfo being supplied to vkCreateInstance.
-/// @return true if the application has enabled the specified extension.
-internal_function inline bool
-OsVulkanInstanceExtensionEnabled
+/// @summary Determine whether two hash table keys are equal. Specialize or overload for key types without a suitable operator==.
+/// @param a The first key.
+/// @param b The second key.
+/// @return true if the keys are equal.
+template <typename K>
+public_function inline bool
+OsHashKeyEqual
 (
-    char                 const *extension_name, 
-    VkInstanceCreateInfo const    *create_info
+    K const &a, 
+    K const &b
 )
 {
-    return OsSupportsNamedExtension(extension_name, create_info->ppEnabledExtensionNames, create_info->enabledExtensionCount);
+    return a == b;
 }
 
-/// @summary Determine whether the application has enabled a device-level extension.
-/// @param extension_name A zero-terminated ASCII string specifying the registered name of the extension to locate.
-/// @param create_info The application-provided VkDeviceCreateInfo being supplied to vkCreateDevice.
-/// @return true if the application has enabled the specified extension.
-internal_function inline bool
-OsVulkanDeviceExtensionEnabled
+/// @summary Determine whether two nul-terminated string hash table keys are equal. The string contents are compared.
+/// @param a The first key.
+/// @param b The second key.
+/// @return true if the strings are equal.
+public_function inline bool
+OsHashKeyEqual
 (
-    char               const *extension_name, 
-    VkDeviceCreateInfo const *create_info
+    char const * const &a, 
+    char const * const &b
 )
 {
-    return OsSupportsNamedExtension(extension_name, create_info->ppEnabledExtensionNames, create_info->enabledExtensionCount);
+    return strcmp(a, b) == 0;
 }
 
-/// @summary Resolve functions exported directly from a Vulkan ICD.
-/// @param runtime The OS_VULKAN_RUNTIME_DISPATCH instance, with the LoaderHandle field set.
-/// @return VK_SUCCESS if all exported functions were resolved successfully.
-internal_function VkResult
-OsResolveVulkanExportFunctions
+/// @summary Find the slots in a hash table group whose control byte matches a value.
+/// @param group The control bytes of the group. The address must be aligned to OS_HASH_GROUP_WIDTH.
+/// @param value The control byte value to search for.
+/// @return A bitmask with bit i set if slot i of the group matches.
+internal_function inline uint32_t
+OsHashGroupMatch
 (
-    OS_VULKAN_RUNTIME_DISPATCH *runtime
+    uint8_t const *group, 
+    uint8_t        value
 )
 {
-    OS_LAYER_RESOLVE_VULKAN_ICD_FUNCTION(runtime, vkGetInstanceProcAddr);
-    return VK_SUCCESS;
+    __m128i ctrl = _mm_load_si128((__m128i const*) group);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) value)));
 }
 
-/// @summary Resolve global functions exported by a Vulkan ICD.
-/// @param runtime The OS_VULKAN_RUNTIME_DISPATCH instance, with the LoaderHandle field set.
-/// @return VK_SUCCESS if all global functions were resolved successfully.
-internal_function VkResult
-OsResolveVulkanGlobalFunctions
+/// @summary Find the slots in a hash table group that are empty or deleted, and can therefore receive a new key.
+/// @param group The control bytes of the group. The address must be aligned to OS_HASH_GROUP_WIDTH.
+/// @return A bitmask with bit i set if slot i of the group is available.
+internal_function inline uint32_t
+OsHashGroupMatchAvailable
 (
-    OS_VULKAN_RUNTIME_DISPATCH *runtime
+    uint8_t const *group
 )
-{
-    OS_LAYER_RESOLVE_VULKAN_GLOBAL_FUNCTION(runtime, vkCreateInstance);
-    OS_LAYER_RESOLVE_VULKAN_GLOBAL_FUNCTION(runtime, vkEnumerateInstanceLayerProperties);
-    OS_LAYER_RESOLVE_VULKAN_GLOBAL_FUNCTION(runtime, vkEnumerateInstanceExtensionProperties);
-    return VK_SUCCESS;
+{   // only the empty and deleted markers have the high bit set.
+    return (uint32_t) _mm_movemask_epi8(_mm_load_si128((__m128i const*) group));
 }
 
-/// @summary Resolve instance-level functions exported by a Vulkan runtime.
-/// @param runtime The OS_VULKAN_RUNTIME_DISPATCH object, with the vkGetInstanceProcAddr entry point set.
-/// @param instance The OS_VULKAN_INSTANCE_DISPATCH object, with the InstanceHandle field set.
-/// @param create_info The VkInstanceCreateInfo being used to initialize the instance. Used here to resolve instance-level function pointers for extensions.
-/// @return VK_SUCCESS if all instance-level functions were resolved successfully.
-internal_function VkResult
-OsResolveVulkanInstanceFunctions
+/// @summary Calculate the number of slots a hash table needs to hold a given number of keys without exceeding the maximum load factor of 7/8.
+/// @param count The number of keys.
+/// @return The number of slots, a power of two no less than OS_HASH_GROUP_WIDTH.
+internal_function inline size_t
+OsHashTableCapacityForCount
 (
-    OS_VULKAN_RUNTIME_DISPATCH      *runtime,
-    OS_VULKAN_INSTANCE_DISPATCH    *instance,
-    VkInstanceCreateInfo  const *create_info 
+    size_t count
 )
 {
-    OS_LAYER_COPY_VULKAN_FUNCTION(instance, runtime, vkGetInstanceProcAddr);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkCreateDevice);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkDestroyInstance);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkEnumeratePhysicalDevices);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkEnumerateDeviceExtensionProperties);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetDeviceProcAddr);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceFeatures);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceFormatProperties);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceImageFormatProperties);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceMemoryProperties);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceProperties);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceQueueFamilyProperties);
-    OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSparseImageFormatProperties);
-    if (OsVulkanInstanceExtensionEnabled(VK_KHR_SURFACE_EXTENSION_NAME, create_info))
-    {   // resolve entry points for VK_KHR_surface.
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkDestroySurfaceKHR);
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSurfaceSupportKHR);
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSurfaceFormatsKHR);
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkGetPhysicalDeviceSurfacePresentModesKHR);
-    }
-    if (OsVulkanInstanceExtensionEnabled(VK_KHR_WIN32_SURFACE_EXTENSION_NAME, create_info))
-    {   // resolve entry points for VK_KHR_win32_surface.
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkCreateWin32SurfaceKHR);
-    }
-    if (OsVulkanInstanceExtensionEnabled(VK_EXT_DEBUG_REPORT_EXTENSION_NAME, create_info))
-    {   // resolve entry points for VK_EXT_debug_report.
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkCreateDebugReportCallbackEXT);
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkDebugReportMessageEXT);
-        OS_LAYER_RESOLVE_VULKAN_INSTANCE_FUNCTION(instance, runtime, vkDestroyDebugReportCallbackEXT);
+    size_t capacity = OS_HASH_GROUP_WIDTH;
+    while ((capacity - capacity / 8) < count)
+    {
+        capacity *= 2;
     }
-    return VK_SUCCESS;
+    return capacity;
 }
 
-/// @summary Resolve device-level functions exported by the Vulkan ICD.
-/// @param vkinstance The OS_VULKAN_INSTANCE_DISPATCH object, with the vkGetDeviceProcAddr entry point set.
-/// @param vkdevice The OS_VULKAN_DEVICE_DISPATCH object, with the LogicalDevice field set.
-/// @param create_info The VkDeviceCreateInfo being used to initialize the logical device. Used here to resolve device-level function pointers for extensions.
-/// @return VkResult if all device-level functions were resolved successfully.
-internal_function VkResult
-OsResolveVulkanDeviceFunctions
+/// @summary Locate the slot containing a key. The probe sequence visits groups in triangular order, which covers every group when the group count is a power of two.
+/// @param control The control bytes of the table.
+/// @param keys The key storage of the table.
+/// @param capacity The number of slots in the table.
+/// @param key The key to search for.
+/// @param hash The value returned by OsHashKey for the key.
+/// @return The zero-based index of the slot containing the key, or SIZE_MAX if the key is not present.
+template <typename K>
+internal_function inline size_t
+OsHashTableFind
 (
-    OS_VULKAN_INSTANCE_DISPATCH *instance,
-    OS_VULKAN_DEVICE_DISPATCH     *device, 
-    VkDeviceCreateInfo const *create_info
+    uint8_t const *control, 
+    K const          *keys, 
+    size_t        capacity, 
+    K const           &key, 
+    uint64_t          hash
 )
 {
-    OS_LAYER_COPY_VULKAN_FUNCTION(device, instance, vkGetDeviceProcAddr);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkAllocateCommandBuffers);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkAllocateMemory);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkBeginCommandBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkBindBufferMemory);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkBindImageMemory);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBeginQuery);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBeginRenderPass);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBindDescriptorSets);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBindIndexBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBindPipeline);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBindVertexBuffers);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdBlitImage);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdClearAttachments);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdClearColorImage);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdClearDepthStencilImage);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyBufferToImage);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyImage);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyImageToBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdCopyQueryPoolResults);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDispatch);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDispatchIndirect);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDraw);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDrawIndexed);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDrawIndexedIndirect);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdDrawIndirect);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdEndQuery);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdEndRenderPass);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdExecuteCommands);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdFillBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdNextSubpass);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdPipelineBarrier);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdPushConstants);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdResetEvent);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdResetQueryPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdResolveImage);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetBlendConstants);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetDepthBias);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetDepthBounds);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetEvent);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetLineWidth);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetScissor);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetStencilCompareMask);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetStencilReference);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetStencilWriteMask);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdSetViewport);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdUpdateBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdWaitEvents);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCmdWriteTimestamp);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateBufferView);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateCommandPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateComputePipelines);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateDescriptorPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateDescriptorSetLayout);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateEvent);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateFence);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateFramebuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateGraphicsPipelines);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateImage);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateImageView);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreatePipelineCache);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreatePipelineLayout);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateQueryPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateRenderPass);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateSampler);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateSemaphore);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateShaderModule);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyBufferView);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyCommandPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyDescriptorPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyDescriptorSetLayout);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyDevice);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyEvent);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyFence);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyFramebuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyImage);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyImageView);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyPipeline);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyPipelineCache);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyPipelineLayout);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyQueryPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyRenderPass);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroySampler);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroySemaphore);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroyShaderModule);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDeviceWaitIdle);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkEndCommandBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkFlushMappedMemoryRanges);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkFreeCommandBuffers);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkFreeDescriptorSets);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkFreeMemory);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetBufferMemoryRequirements);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetDeviceMemoryCommitment);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetDeviceQueue);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetEventStatus);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetFenceStatus);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetImageMemoryRequirements);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetImageSparseMemoryRequirements);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetImageSubresourceLayout);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetPipelineCacheData);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetQueryPoolResults);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetRenderAreaGranularity);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkInvalidateMappedMemoryRanges);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkMapMemory);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkMergePipelineCaches);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkQueueBindSparse);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkQueueSubmit);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkQueueWaitIdle);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetCommandBuffer);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetCommandPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetDescriptorPool);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetEvent);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkResetFences);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkSetEvent);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkUnmapMemory);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkUpdateDescriptorSets);
-    OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkWaitForFences);
-    if (OsVulkanDeviceExtensionEnabled(VK_KHR_SWAPCHAIN_EXTENSION_NAME, create_info))
-    {   // resolve entry points for VK_KHR_swapchain.
-        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkAcquireNextImageKHR);
-        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateSharedSwapchainsKHR);
-        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkCreateSwapchainKHR);
-        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkDestroySwapchainKHR);
-        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkGetSwapchainImagesKHR);
-        OS_LAYER_RESOLVE_VULKAN_DEVICE_FUNCTION(device, instance, vkQueuePresentKHR);
+    if (capacity == 0)
+        return SIZE_MAX;
+    size_t group_mask = (capacity / OS_HASH_GROUP_WIDTH) - 1;
+    size_t      group = (size_t)(hash >> 7) & group_mask;
+    uint8_t        h2 = (uint8_t)(hash & 0x7F);
+    for (size_t probe = 1; ; ++probe)
+    {
+        uint8_t const *ctrl = control + (group * OS_HASH_GROUP_WIDTH);
+        uint32_t      match = OsHashGroupMatch(ctrl, h2);
+        while (match != 0)
+        {
+            size_t slot = (group * OS_HASH_GROUP_WIDTH) + OsBitScanForward64(match);
+            if (OsHashKeyEqual(keys[slot], key))
+                return slot;
+            match &= match - 1;
+        }
+        if (OsHashGroupMatch(ctrl, OS_HASH_CONTROL_EMPTY) != 0)
+        {   // an empty slot ends the probe sequence; the key was never inserted past this group.
+            return SIZE_MAX;
+        }
+        group = (group + probe) & group_mask;
+    }
+}
+
+/// @summary Locate the first empty or deleted slot along the probe sequence for a hash value. The table must have at least one empty slot.
+/// @param control The control bytes of the table.
+/// @param capacity The number of slots in the table. Must be non-zero.
+/// @param hash The value returned by OsHashKey for the key being inserted.
+/// @return The zero-based index of the slot.
+internal_function inline size_t
+OsHashTableFindAvailable
+(
+    uint8_t const *control, 
+    size_t        capacity, 
+    uint64_t          hash
+)
+{
+    size_t group_mask = (capacity / OS_HASH_GROUP_WIDTH) - 1;
+    size_t      group = (size_t)(hash >> 7) & group_mask;
+    for (size_t probe = 1; ; ++probe)
+    {
+        uint32_t match = OsHashGroupMatchAvailable(control + (group * OS_HASH_GROUP_WIDTH));
+        if (match != 0)
+            return (group * OS_HASH_GROUP_WIDTH) + OsBitScanForward64(match);
+        group = (group + probe) & group_mask;
     }
-    return VK_SUCCESS;
 }
 
-/*////////////////////////
-//   Public Functions   //
-////////////////////////*/
-/// @param Zero-fill a memory block.
-/// @param dst The address of the block to zero-fill.
-/// @param len The number of bytes to set to zero.
-public_function void
-OsZeroMemory
+/// @summary Allocate the control bytes for a hash table from an arena and mark every slot empty.
+/// @param arena The arena to allocate from.
+/// @param capacity The number of slots.
+/// @return The control bytes, or NULL if the arena is exhausted.
+internal_function uint8_t*
+OsHashTableAllocateControl
 (
-    void  *dst, 
-    size_t len
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t             capacity
 )
 {
-    ZeroMemory(dst, len);
+    uint8_t *control = (uint8_t*) OsHostMemoryArenaAllocate(arena, capacity, OS_HASH_GROUP_WIDTH);
+    if (control != NULL)
+    {
+        OsFillMemory(control, capacity, OS_HASH_CONTROL_EMPTY);
+    }
+    return control;
 }
 
-/// @summary Zero-fill a memory block in a way that is guaranteed not to be optimized out by the compiler.
-/// @param dst The address of the block to zero-fill.
-/// @param len The number of bytes to set to zero.
-public_function void
-OsSecureZeroMemory
+/// @summary Move the keys of a hash set into new storage with a given number of slots, discarding deleted slots.
+/// @param set The OS_HASH_SET to rehash.
+/// @param capacity The new number of slots, as returned by OsHashTableCapacityForCount.
+/// @return Zero if the set was rehashed, or -1 if the arena is exhausted, in which case the set is unchanged.
+template <typename K>
+internal_function int
+OsHashTableRehash
 (
-    void  *dst,
-    size_t len
+    OS_HASH_SET<K> *set, 
+    size_t     capacity
 )
 {
-    (void) SecureZeroMemory(dst, len);
+    os_arena_marker_t marker = OsHostMemoryArenaMark(set->Arena);
+    uint8_t         *control = OsHashTableAllocateControl(set->Arena, capacity);
+    K                  *keys = OsHostMemoryArenaAllocateArray<K>(set->Arena, capacity);
+    if (control == NULL || keys == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to allocate %Iu hash set slots from the arena.\n", __FUNCTION__, OsThreadId(), capacity);
+        OsHostMemoryArenaResetToMarker(set->Arena, marker);
+        return -1;
+    }
+    for (size_t i = 0, n = set->Capacity; i < n; ++i)
+    {
+        if ((set->Control[i] & 0x80) == 0)
+        {
+            uint64_t hash = OsHashKey(set->Keys[i]);
+            size_t   slot = OsHashTableFindAvailable(control, capacity, hash);
+            control[slot] = (uint8_t)(hash & 0x7F);
+            keys   [slot] = set->Keys[i];
+        }
+    }
+    set->Control    = control;
+    set->Keys       = keys;
+    set->Capacity   = capacity;
+    set->GrowthLeft = capacity - (capacity / 8) - set->Count;
+    return 0;
 }
 
-/// @summary Copy memory from one block to another, where it is known that the source and destination address ranges do not overlap.
-/// @param dst The address of the destination block.
-/// @param src The address of the source block.
-/// @param len The number of bytes to copy.
-public_function void
-OsCopyMemory
+/// @summary Move the keys and values of a hash map into new storage with a given number of slots, discarding deleted slots.
+/// @param map The OS_HASH_MAP to rehash.
+/// @param capacity The new number of slots, as returned by OsHashTableCapacityForCount.
+/// @return Zero if the map was rehashed, or -1 if the arena is exhausted, in which case the map is unchanged.
+template <typename K, typename V>
+internal_function int
+OsHashTableRehash
 (
-    void       * __restrict dst,
-    void const * __restrict src, 
-    size_t                  len
+    OS_HASH_MAP<K, V> *map, 
+    size_t        capacity
 )
 {
-    CopyMemory(dst, src, len);
+    os_arena_marker_t marker = OsHostMemoryArenaMark(map->Arena);
+    uint8_t         *control = OsHashTableAllocateControl(map->Arena, capacity);
+    K                  *keys = OsHostMemoryArenaAllocateArray<K>(map->Arena, capacity);
+    V                *values = OsHostMemoryArenaAllocateArray<V>(map->Arena, capacity);
+    if (control == NULL || keys == NULL || values == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to allocate %Iu hash map slots from the arena.\n", __FUNCTION__, OsThreadId(), capacity);
+        OsHostMemoryArenaResetToMarker(map->Arena, marker);
+        return -1;
+    }
+    for (size_t i = 0, n = map->Capacity; i < n; ++i)
+    {
+        if ((map->Control[i] & 0x80) == 0)
+        {
+            uint64_t hash = OsHashKey(map->Keys[i]);
+            size_t   slot = OsHashTableFindAvailable(control, capacity, hash);
+            control[slot] = (uint8_t)(hash & 0x7F);
+            keys   [slot] = map->Keys  [i];
+            values [slot] = map->Values[i];
+        }
+    }
+    map->Control    = control;
+    map->Keys       = keys;
+    map->Values     = values;
+    map->Capacity   = capacity;
+    map->GrowthLeft = capacity - (capacity / 8) - map->Count;
+    return 0;
 }
 
-/// @summary Copy memory from one block to another, where the source and destination address ranges may overlap.
-/// @param dst The address of the destination block.
-/// @param src The address of the source block.
-/// @param len The number of bytes to copy.
-public_function void
-OsMoveMemory
+/// @summary Initialize an OS_HASH_SET or OS_HASH_MAP, optionally reserving storage up front.
+/// @param table The OS_HASH_SET or OS_HASH_MAP to initialize.
+/// @param arena The arena from which table storage is allocated.
+/// @param expected_count The number of keys to reserve storage for, or zero to allocate storage on the first insert.
+/// @param flags One or more of OS_HASH_TABLE_FLAGS.
+/// @return Zero if the table is initialized, or -1 if an error occurred.
+template <typename TABLE>
+internal_function int
+OsHashTableCreate
 (
-    void       *dst, 
-    void const *src, 
-    size_t      len
+    TABLE                *table, 
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t       expected_count, 
+    uint32_t              flags
 )
 {
-    MoveMemory(dst, src, len);
+    OsZeroMemory(table, sizeof(TABLE));
+    table->Arena = arena;
+    table->Flags = flags;
+    if ((flags & OS_HASH_TABLE_FLAG_FIXED_CAPACITY) && expected_count == 0)
+    {
+        OsLayerError("ERROR: %S(%u): A fixed-capacity hash table requires a non-zero expected count.\n", __FUNCTION__, OsThreadId());
+        return -1;
+    }
+    if (expected_count > 0)
+    {
+        return OsHashTableRehash(table, OsHashTableCapacityForCount(expected_count));
+    }
+    return 0;
 }
 
-/// @summary Fill a block of memory with a given value.
-/// @param dst The address of the start of the block to fill.
-/// @param len The number of bytes to write.
-/// @param val The value to write to each byte in the destination block.
+/// @summary Ensure an OS_HASH_SET or OS_HASH_MAP can hold a given number of keys without growing. Allowed for fixed-capacity tables.
+/// @param table The OS_HASH_SET or OS_HASH_MAP to update.
+/// @param count The total number of keys the table should be able to hold.
+/// @return Zero if the table can hold count keys, or -1 if the arena is exhausted.
+template <typename TABLE>
+internal_function int
+OsHashTableReserve
+(
+    TABLE *table, 
+    size_t count
+)
+{
+    size_t capacity = OsHashTableCapacityForCount(count);
+    if (capacity > table->Capacity)
+    {
+        return OsHashTableRehash(table, capacity);
+    }
+    return 0;
+}
+
+/// @summary Claim the slot for a new key in an OS_HASH_SET or OS_HASH_MAP, growing the table if necessary. The key must not already be present.
+/// @param table The OS_HASH_SET or OS_HASH_MAP receiving the key.
+/// @param hash The value returned by OsHashKey for the key.
+/// @return The zero-based index of the slot, whose control byte has been set, or SIZE_MAX if the table could not grow.
+template <typename TABLE>
+internal_function size_t
+OsHashTableClaimSlot
+(
+    TABLE   *table, 
+    uint64_t  hash
+)
+{
+    size_t slot = table->Capacity > 0 ? OsHashTableFindAvailable(table->Control, table->Capacity, hash) : SIZE_MAX;
+    if (slot == SIZE_MAX || (table->GrowthLeft == 0 && table->Control[slot] == OS_HASH_CONTROL_EMPTY))
+    {   // deleted slots can always be reused, but filling an empty slot would exceed the maximum load factor.
+        if (table->Flags & OS_HASH_TABLE_FLAG_FIXED_CAPACITY)
+        {
+            OsLayerError("ERROR: %S(%u): Fixed-capacity hash table with %Iu slots is full.\n", __FUNCTION__, OsThreadId(), table->Capacity);
+            return SIZE_MAX;
+        }
+        // size for 1.5x the live keys; when most slots hold deleted keys, this rehashes at the same or a smaller capacity.
+        if (OsHashTableRehash(table, OsHashTableCapacityForCount(table->Count + (table->Count / 2) + 1)) < 0)
+        {   // OsHashTableRehash output error information already.
+            return SIZE_MAX;
+        }
+        slot = OsHashTableFindAvailable(table->Control, table->Capacity, hash);
+    }
+    if (table->Control[slot] == OS_HASH_CONTROL_EMPTY)
+    {
+        table->GrowthLeft--;
+    }
+    table->Control[slot] = (uint8_t)(hash & 0x7F);
+    table->Count++;
+    return slot;
+}
+
+/// @summary Remove the key in a slot of an OS_HASH_SET or OS_HASH_MAP.
+/// @param table The OS_HASH_SET or OS_HASH_MAP containing the slot.
+/// @param slot The zero-based index of a full slot.
+template <typename TABLE>
+internal_function inline void
+OsHashTableEraseSlot
+(
+    TABLE *table, 
+    size_t  slot
+)
+{   // a group that still has an empty slot has never been full, so no probe sequence continues past it, and the slot can become empty.
+    // otherwise, a key inserted later may have probed past this group, so the slot must be marked deleted to keep the sequence intact.
+    if (OsHashGroupMatch(table->Control + (slot & ~(OS_HASH_GROUP_WIDTH - 1)), OS_HASH_CONTROL_EMPTY) != 0)
+    {
+        table->Control[slot] = OS_HASH_CONTROL_EMPTY;
+        table->GrowthLeft++;
+    }
+    else
+    {
+        table->Control[slot] = OS_HASH_CONTROL_DELETED;
+    }
+    table->Count--;
+}
+
+/// @summary Remove all keys from an OS_HASH_SET or OS_HASH_MAP. The storage is retained.
+/// @param table The OS_HASH_SET or OS_HASH_MAP to clear.
+template <typename TABLE>
+internal_function void
+OsHashTableClear
+(
+    TABLE *table
+)
+{
+    if (table->Capacity > 0)
+    {
+        OsFillMemory(table->Control, table->Capacity, OS_HASH_CONTROL_EMPTY);
+    }
+    table->Count      = 0;
+    table->GrowthLeft = table->Capacity - (table->Capacity / 8);
+}
+
+/// @summary Advance an iterator over the full slots of an OS_HASH_SET or OS_HASH_MAP.
+/// @param table The OS_HASH_SET or OS_HASH_MAP being iterated.
+/// @param iterator On entry, the zero-based index of the slot at which to resume. Start at zero. On return, the index of the slot after the one returned.
+/// @return The zero-based index of the next full slot, or SIZE_MAX if there are no more keys.
+template <typename TABLE>
+internal_function inline size_t
+OsHashTableNextSlot
+(
+    TABLE     *table, 
+    size_t &iterator
+)
+{
+    while (iterator < table->Capacity)
+    {
+        size_t slot = iterator++;
+        if ((table->Control[slot] & 0x80) == 0)
+            return slot;
+    }
+    return SIZE_MAX;
+}
+
+/// @summary Initialize a hash set whose storage is allocated from a host memory arena.
+/// @param set The OS_HASH_SET to initialize.
+/// @param arena The arena from which storage is allocated. For task-local sets, use OS_TASK_ENVIRONMENT::LocalMemory.
+/// @param expected_count The number of keys to reserve storage for up front, or zero to allocate storage on the first insert.
+/// @param flags One or more of OS_HASH_TABLE_FLAGS. Specify OS_HASH_TABLE_FLAG_FIXED_CAPACITY to never allocate beyond the reserved storage.
+/// @return Zero if the set is initialized, or -1 if an error occurred.
+template <typename K>
+public_function int
+OsCreateHashSet
+(
+    OS_HASH_SET<K>         *set, 
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t       expected_count, 
+    uint32_t              flags
+)
+{
+    static_assert(std::is_trivially_copyable<K>::value, "OS_HASH_SET keys must be trivially copyable");
+    return OsHashTableCreate(set, arena, expected_count, flags);
+}
+
+/// @summary Ensure a hash set can hold a given number of keys without growing.
+/// @param set The OS_HASH_SET to update.
+/// @param count The total number of keys the set should be able to hold.
+/// @return Zero if the set can hold count keys, or -1 if the arena is exhausted.
+template <typename K>
+public_function int
+OsHashSetReserve
+(
+    OS_HASH_SET<K> *set, 
+    size_t        count
+)
+{
+    return OsHashTableReserve(set, count);
+}
+
+/// @summary Determine whether a hash set contains a key.
+/// @param set The OS_HASH_SET to search.
+/// @param key The key to search for.
+/// @return true if the set contains the key.
+template <typename K>
+public_function inline bool
+OsHashSetContains
+(
+    OS_HASH_SET<K> *set, 
+    K const        &key
+)
+{
+    return OsHashTableFind(set->Control, set->Keys, set->Capacity, key, OsHashKey(key)) != SIZE_MAX;
+}
+
+/// @summary Add a key to a hash set.
+/// @param set The OS_HASH_SET to update.
+/// @param key The key to add.
+/// @return 1 if the key was added, 0 if the key was already present, or -1 if the set is full and cannot grow.
+template <typename K>
+public_function int
+OsHashSetInsert
+(
+    OS_HASH_SET<K> *set, 
+    K const        &key
+)
+{
+    uint64_t hash = OsHashKey(key);
+    size_t   slot = OsHashTableFind(set->Control, set->Keys, set->Capacity, key, hash);
+    if (slot != SIZE_MAX)
+        return 0;
+    if ((slot = OsHashTableClaimSlot(set, hash)) == SIZE_MAX)
+        return -1;
+    set->Keys[slot] = key;
+    return 1;
+}
+
+/// @summary Remove a key from a hash set.
+/// @param set The OS_HASH_SET to update.
+/// @param key The key to remove.
+/// @return true if the key was removed, or false if it was not present.
+template <typename K>
+public_function bool
+OsHashSetRemove
+(
+    OS_HASH_SET<K> *set, 
+    K const        &key
+)
+{
+    size_t slot = OsHashTableFind(set->Control, set->Keys, set->Capacity, key, OsHashKey(key));
+    if (slot == SIZE_MAX)
+        return false;
+    OsHashTableEraseSlot(set, slot);
+    return true;
+}
+
+/// @summary Remove all keys from a hash set. The storage is retained for reuse.
+/// @param set The OS_HASH_SET to clear.
+template <typename K>
 public_function void
-OsFillMemory
+OsHashSetClear
 (
-    void   *dst, 
-    size_t  len, 
-    uint8_t val
+    OS_HASH_SET<K> *set
 )
 {
-    FillMemory(dst, len, val);
+    OsHashTableClear(set);
 }
 
-/// @summary Rounds a size up to the nearest even multiple of a given power-of-two.
-/// @param size The size value to round up.
-/// @param pow2 The power-of-two alignment.
-/// @return The input size, rounded up to the nearest even multiple of pow2.
-public_function size_t 
-OsAlignUp
+/// @summary Retrieve the next key from a hash set. Keys are returned in slot order. The set must not be modified during iteration, except by OsHashSetRemove of the returned key.
+/// @param set The OS_HASH_SET to iterate over.
+/// @param iterator The iteration state. Set to zero before the first call.
+/// @param key On return, points to the key. The pointer is valid until the set is next modified.
+/// @return true if a key was returned, or false if iteration is complete.
+template <typename K>
+public_function bool
+OsHashSetIterate
 (
-    size_t size, 
-    size_t pow2
+    OS_HASH_SET<K> *set, 
+    size_t    &iterator, 
+    K        *&key
 )
 {
-    return (size == 0) ? pow2 : ((size + (pow2-1)) & ~(pow2-1));
+    size_t slot = OsHashTableNextSlot(set, iterator);
+    if (slot == SIZE_MAX)
+        return false;
+    key = &set->Keys[slot];
+    return true;
 }
 
-/// @summary Retrieve the alignment required for a given type.
-/// @typeparam T The type for which the required alignment is being queried.
-/// @return The required alignment for the specified type, in bytes. This value is always a power of two.
-template <typename T>
-public_function inline size_t
-OsAlignmentOfType
+/// @summary Initialize a hash map whose storage is allocated from a host memory arena.
+/// @param map The OS_HASH_MAP to initialize.
+/// @param arena The arena from which storage is allocated. For task-local maps, use OS_TASK_ENVIRONMENT::LocalMemory.
+/// @param expected_count The number of keys to reserve storage for up front, or zero to allocate storage on the first insert.
+/// @param flags One or more of OS_HASH_TABLE_FLAGS. Specify OS_HASH_TABLE_FLAG_FIXED_CAPACITY to never allocate beyond the reserved storage.
+/// @return Zero if the map is initialized, or -1 if an error occurred.
+template <typename K, typename V>
+public_function int
+OsCreateHashMap
 (
-    void
+    OS_HASH_MAP<K, V>      *map, 
+    OS_HOST_MEMORY_ARENA *arena, 
+    size_t       expected_count, 
+    uint32_t              flags
 )
 {
-    return std::alignment_of<T>::value;
+    static_assert(std::is_trivially_copyable<K>::value, "OS_HASH_MAP keys must be trivially copyable");
+    static_assert(std::is_trivially_copyable<V>::value, "OS_HASH_MAP values must be trivially copyable");
+    return OsHashTableCreate(map, arena, expected_count, flags);
 }
 
-/// @summary For a given address, return the address aligned for the specified type. The type T must be aligned to a power-of-two.
-/// @param addr The unaligned address.
-/// @return The address aligned to access elements of type T, or NULL if addr is NULL.
-template <typename T>
-public_function void* 
-OsAlignFor
+/// @summary Ensure a hash map can hold a given number of keys without growing.
+/// @param map The OS_HASH_MAP to update.
+/// @param count The total number of keys the map should be able to hold.
+/// @return Zero if the map can hold count keys, or -1 if the arena is exhausted.
+template <typename K, typename V>
+public_function int
+OsHashMapReserve
 (
-    void *addr
+    OS_HASH_MAP<K, V> *map, 
+    size_t           count
 )
 {
-    const size_t a = std::alignment_of<T>::value;
-    const size_t m = std::alignment_of<T>::value - 1;
-    uint8_t     *p =(uint8_t*)addr;
-    return  (addr != NULL) ? (void*) ((uintptr_t(p) + m) & ~m) : NULL;
+    return OsHashTableReserve(map, count);
 }
 
-/// @summary Calculate the worst-case requirement for allocating an instance of a structure, including padding.
-/// @typeparam T The type being allocated. This type is used to determine the required alignment.
-/// @return The number of bytes required to allocate an instance, including worst-case padding.
-template <typename T>
-public_function size_t
-OsAllocationSizeForStruct
+/// @summary Retrieve the value associated with a key in a hash map.
+/// @param map The OS_HASH_MAP to search.
+/// @param key The key to search for.
+/// @return A pointer to the value, valid until the map is next modified, or NULL if the key is not present.
+template <typename K, typename V>
+public_function inline V*
+OsHashMapFind
 (
-    void
+    OS_HASH_MAP<K, V> *map, 
+    K const           &key
 )
 {
-    return sizeof(T) + (std::alignment_of<T>::value - 1);
+    size_t slot = OsHashTableFind(map->Control, map->Keys, map->Capacity, key, OsHashKey(key));
+    return slot != SIZE_MAX ? &map->Values[slot] : NULL;
 }
 
-/// @summary Calculate the worst-case requirement for allocating an array, including padding.
-/// @typeparam T The type being allocated. This type is used to determine the required alignment.
-/// @param n The number of items of type T in the array.
-/// @return The number of bytes required to allocate an array of count items, including worst-case padding.
-template <typename T>
-public_function size_t
-OsAllocationSizeForArray
+/// @summary Retrieve the value associated with a key in a hash map, inserting the key with a zero-initialized value if it is not present.
+/// @param map The OS_HASH_MAP to update.
+/// @param key The key to search for.
+/// @param inserted On return, set to true if the key was inserted.
+/// @return A pointer to the value, valid until the map is next modified, or NULL if the map is full and cannot grow.
+template <typename K, typename V>
+public_function V*
+OsHashMapFindOrInsert
 (
-    size_t n
+    OS_HASH_MAP<K, V> *map, 
+    K const           &key, 
+    bool         &inserted
 )
 {
-    return (sizeof(T) * n) + (std::alignment_of<T>::value - 1);
+    uint64_t hash = OsHashKey(key);
+    size_t   slot = OsHashTableFind(map->Control, map->Keys, map->Capacity, key, hash);
+    inserted = false;
+    if (slot != SIZE_MAX)
+        return &map->Values[slot];
+    if ((slot = OsHashTableClaimSlot(map, hash)) == SIZE_MAX)
+        return NULL;
+    OsZeroMemory(&map->Values[slot], sizeof(V));
+    map->Keys[slot] = key;
+    inserted = true;
+    return &map->Values[slot];
 }
 
-/// @summary Initialize an OS_MEMORY_RANGE object for a committed block of memory.
-/// @param addr The base address of the host-visible allocation.
-/// @param size The size of the host-visible range, in bytes.
-/// @return An OS_MEMORY_RANGE initialized with the specified memory block.
-public_function inline OS_MEMORY_RANGE
-OsInitHostMemoryRange
+/// @summary Insert a key and value into a hash map, replacing the value if the key is already present.
+/// @param map The OS_HASH_MAP to update.
+/// @param key The key to insert.
+/// @param value The value to associate with the key.
+/// @return A pointer to the stored value, valid until the map is next modified, or NULL if the map is full and cannot grow.
+template <typename K, typename V>
+public_function V*
+OsHashMapInsert
 (
-    void  *addr, 
-    size_t size
+    OS_HASH_MAP<K, V> *map, 
+    K const           &key, 
+    V const         &value
 )
-{   assert(addr != NULL && size > 0);
-    OS_MEMORY_RANGE r;
-    r.HostAddress =(uint8_t*) addr;
-    r.SizeInBytes = size;
-    return r;
+{
+    bool inserted = false;
+    V      *store = OsHashMapFindOrInsert(map, key, inserted);
+    if (store != NULL)
+       *store = value;
+    return store;
 }
 
-/// @summary Initialized an OS_MEMORY_RANGE to wrap an entire host memory allocation.
-/// @param memory The host memory allocation to wrap.
-/// @return An OS_MEMORY_RANGE initialized with the specified memory block.
-public_function inline OS_MEMORY_RANGE
-OsInitHostMemoryRange
+/// @summary Remove a key and its value from a hash map.
+/// @param map The OS_HASH_MAP to update.
+/// @param key The key to remove.
+/// @return true if the key was removed, or false if it was not present.
+template <typename K, typename V>
+public_function bool
+OsHashMapRemove
 (
-    OS_HOST_MEMORY_ALLOCTION *memory
+    OS_HASH_MAP<K, V> *map, 
+    K const           &key
 )
-{   assert(memory->BaseAddress != NULL && memory->BytesCommitted > 0);
-    OS_MEMORY_RANGE r;
-    r.HostAddress = memory->BaseAddress;
-    r.SizeInBytes = memory->BytesCommitted;
-    return r;
+{
+    size_t slot = OsHashTableFind(map->Control, map->Keys, map->Capacity, key, OsHashKey(key));
+    if (slot == SIZE_MAX)
+        return false;
+    OsHashTableEraseSlot(map, slot);
+    return true;
 }
 
-/// @summary Initialize a pool of memory allocations.
-/// @param pool The OS_HOST_MEMORY_POOL to initialize.
-/// @param init The attributes of the pool.
-/// @return Zero if the pool is successfully initialized, or -1 if an error occurred.
+/// @summary Remove all keys from a hash map. The storage is retained for reuse.
+/// @param map The OS_HASH_MAP to clear.
+template <typename K, typename V>
+public_function void
+OsHashMapClear
+(
+    OS_HASH_MAP<K, V> *map
+)
+{
+    OsHashTableClear(map);
+}
+
+/// @summary Retrieve the next key and value from a hash map. Entries are returned in slot order. The map must not be modified during iteration, except by OsHashMapRemove of the returned key.
+/// @param map The OS_HASH_MAP to iterate over.
+/// @param iterator The iteration state. Set to zero before the first call.
+/// @param key On return, points to the key. The pointer is valid until the map is next modified.
+/// @param value On return, points to the value. The pointer is valid until the map is next modified.
+/// @return true if an entry was returned, or false if iteration is complete.
+template <typename K, typename V>
+public_function bool
+OsHashMapIterate
+(
+    OS_HASH_MAP<K, V> *map, 
+    size_t       &iterator, 
+    K           *&key, 
+    V         *&value
+)
+{
+    size_t slot = OsHashTableNextSlot(map, iterator);
+    if (slot == SIZE_MAX)
+        return false;
+    key   = &map->Keys  [slot];
+    value = &map->Values[slot];
+    return true;
+}
+
+/// @summary Initialize a frame arena, dividing a block of host memory evenly between generation_count generations.
+/// @param arena The OS_FRAME_ARENA to initialize.
+/// @param host_memory The address and size of the host-visible memory block to sub-allocate from.
+/// @param generation_count The number of frames whose allocations can be live at once, between 1 and OS_FRAME_ARENA::MAX_GENERATIONS.
+/// @return Zero if the arena is initialized, or -1 if an error occurred.
 public_function int
-OsCreateHostMemoryPool
+OsCreateFrameArena
 (
-    OS_HOST_MEMORY_POOL      *pool, 
-    OS_HOST_MEMORY_POOL_INIT *init
+    OS_FRAME_ARENA       *arena, 
+    OS_MEMORY_RANGE host_memory, 
+    uint32_t   generation_count
 )
 {
-    SYSTEM_INFO    sysinfo = {};
-    size_t      total_size = 0;
-    size_t actual_capacity = 0;
-    void            *array = NULL;
-
-    // retrieve the OS page size and allocation granularity.
-    GetNativeSystemInfo(&sysinfo);
-
-    // figure out how many bytes to allocate.
-    total_size = OsAlignUp(init->PoolCapacity * sizeof(OS_HOST_MEMORY_ALLOCATION), sysinfo.dwPageSize);
-    actual_capacity = total_size / sizeof(OS_HOST_MEMORY_ALLOCATION);
-
-    // VirtualAlloc storage for all of the OS_HOST_MEMORY_ALLOCATION objects.
-    if ((array = VirtualAlloc(NULL, total_size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE)) == NULL)
+    size_t   page_size = 0;
+    size_t granularity = 0;
+    size_t  slice_size = 0;
+    OsZeroMemory(arena, sizeof(OS_FRAME_ARENA));
+    if (generation_count < 1 || generation_count > OS_FRAME_ARENA::MAX_GENERATIONS)
     {
-        OsLayerError("ERROR: %S(%u): Failed to allocate %Iu bytes for pool %S of %Iu items (%08X).\n", __FUNCTION__, OsThreadId(), total_size, init->PoolName, actual_capacity, GetLastError());
+        OsLayerError("ERROR: %S(%u): Invalid generation count %u; must be between 1 and %u.\n", __FUNCTION__, OsThreadId(), generation_count, OS_FRAME_ARENA::MAX_GENERATIONS);
         return -1;
     }
-
-    // initialize the fields of the OS_HOST_MEMORY_POOL object.
-    pool->Name              = init->PoolName;
-    pool->FreeList          = NULL;
-    pool->NodeList          =(OS_HOST_MEMORY_ALLOCATION*) array;
-    pool->Capacity          = actual_capacity;
-    pool->MinAllocationSize = init->MinAllocationSize;
-    pool->MinCommitIncrease = init->MinCommitIncrease;
-    pool->PageSize          = sysinfo.dwPageSize;
-    pool->Granularity       = sysinfo.dwAllocationGranularity;
-
-    // initialize the pool free list.
-    for (size_t i = 0; i < actual_capacity; ++i)
+    // each generation starts on a page boundary so that it can be trimmed independently.
+    OsVmmQueryPageSize(page_size, granularity);
+    slice_size = (host_memory.SizeInBytes / generation_count) & ~(page_size - 1);
+    if (slice_size == 0)
     {
-        size_t ix = actual_capacity - i - 1;
-        pool->NodeList[ix].SourcePool     = pool;
-        pool->NodeList[ix].NextAllocation = pool->FreeList;
-        pool->FreeList = &pool->NodeList[ix];
+        OsLayerError("ERROR: %S(%u): Host memory block of %Iu bytes is too small for %u generations.\n", __FUNCTION__, OsThreadId(), host_memory.SizeInBytes, generation_count);
+        return -1;
+    }
+    for (uint32_t i = 0; i < generation_count; ++i)
+    {
+        OS_MEMORY_RANGE slice;
+        slice.HostAddress = host_memory.HostAddress + (i * slice_size);
+        slice.SizeInBytes = slice_size;
+        if (OsCreateHostMemoryArena(&arena->Generations[i].Arena, slice) != 0)
+        {
+            OsLayerError("ERROR: %S(%u): Failed to initialize arena for generation %u.\n", __FUNCTION__, OsThreadId(), i);
+            OsDeleteFrameArena(arena);
+            return -1;
+        }
     }
+    arena->GenerationCount   = generation_count;
+    arena->CurrentGeneration = 0;
+    arena->FrameIndex        = 0;
     return 0;
 }
 
-/// @summary Free all memory associated with an OS_HOST_MEMORY_POOL object. All allocations are invalidated.
-/// @param pool The OS_HOST_MEMORY_POOL to delete.
+/// @summary Free resources associated with a frame arena. The caller must ensure that no in-flight work references frame memory.
+/// @param arena The OS_FRAME_ARENA to delete.
 public_function void
-OsDeleteHostMemoryPool
+OsDeleteFrameArena
 (
-    OS_HOST_MEMORY_POOL *pool
+    OS_FRAME_ARENA *arena
 )
-{   // release all of the individual memory allocations.
-    for (size_t i = 0, n = pool->Capacity; i < n; ++i)
-    {
-        OsHostMemoryRelease(&pool->NodeList[i]);
-    }
-    // release the memory allocated for the pool itself.
-    if (pool->NodeList != NULL)
+{
+    for (uint32_t i = 0; i < OS_FRAME_ARENA::MAX_GENERATIONS; ++i)
     {
-        VirtualFree(pool->NodeList, 0, MEM_RELEASE);
+        if (arena->Generations[i].Arena.HostMemory.HostAddress != NULL)
+        {
+            OsDeleteHostMemoryArena(&arena->Generations[i].Arena);
+        }
     }
-    pool->FreeList = NULL;
-    pool->NodeList = NULL;
-    pool->Capacity = 0;
+    OsZeroMemory(arena, sizeof(OS_FRAME_ARENA));
 }
 
-/// @summary Reserve, and optionally commit, address space within a process.
-/// @param pool The OS_HOST_MEMORY_POOL from which the OS_HOST_MEMORY_ALLOCATION will be acquired.
-/// @param reserve_size The number of bytes of process address space to reserve. This value is rounded up to the nearest even multiple of the operating system page size.
-/// @param commit_size The number of bytes of process address space to commit. This value is rounded up to the nearest even multiple of the operating system page size.
-/// @param alloc_flags One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS, or 0 if no special behavior is desired in which case the memory is readable, writable and has a guard page.
-/// @return Zero if the address space is successfully reserved, or -1 if an error occurred.
-public_function OS_HOST_MEMORY_ALLOCATION*
-OsHostMemoryPoolAllocate
+/// @summary Begin a new frame, making the oldest generation current. The generation is reset only after the fence attached when it was last used has been signaled.
+/// @param arena The OS_FRAME_ARENA to update.
+/// @param timeout_ns The maximum amount of time to wait for the fence, specified in nanoseconds.
+/// @return true if the new frame has started, or false if the fence did not become signaled within the timeout. In this case, the current frame is unchanged.
+public_function bool
+OsFrameArenaBeginFrame
 (
-    OS_HOST_MEMORY_POOL *pool, 
-    size_t       reserve_size, 
-    size_t        commit_size, 
-    uint32_t      alloc_flags
+    OS_FRAME_ARENA *arena, 
+    uint64_t   timeout_ns
 )
 {
-    if (pool->FreeList != NULL)
-    {   // attempt to initialize the object at the head of the free list.
-        OS_HOST_MEMORY_ALLOCATION *alloc = pool->FreeList;
-        // attempt to initialize the object with the requested attributes.
-        if (OsHostMemoryReserveAndCommit(alloc, reserve_size, commit_size, alloc_flags) < 0)
-        {   // allocation failed. the error was already output.
-            return NULL;
-        }
-        // pop the object from the head of the free list.
-        pool->FreeList = alloc->NextAllocation;
-        alloc->NextAllocation = NULL;
-        return alloc;
+    uint32_t                  next =(arena->CurrentGeneration + 1) % arena->GenerationCount;
+    OS_FRAME_ARENA_GENERATION *gen = &arena->Generations[next];
+#if !defined(__linux__)
+    if (gen->TaskFence != NULL && !OsWaitTaskFence(gen->TaskFence, timeout_ns))
+    {   // work submitted during the frame that last used this generation is still running.
+        return false;
     }
-    else
-    {   // the pool capacity needs to be increased; there are no free OS_HOST_MEMORY_ALLOCATION objects.
-        OsLayerError("ERROR: %S(%u): No free OS_HOST_MEMORY_ALLOCATION objects in pool %S.\n", __FUNCTION__, OsThreadId(), pool->Name);
-        return NULL;
+#endif
+    if (gen->FenceWait != NULL && !gen->FenceWait(gen->FenceContext, timeout_ns))
+    {   // work submitted during the frame that last used this generation is still running.
+        return false;
     }
+    OsHostMemoryArenaReset(&gen->Arena);
+    gen->TaskFence    = NULL;
+    gen->FenceWait    = NULL;
+    gen->FenceContext = NULL;
+    gen->FrameIndex   = arena->FrameIndex + 1;
+    gen->BytesUsed    = 0;
+    arena->CurrentGeneration = next;
+    arena->FrameIndex++;
+    return true;
 }
 
-/// @summary Release all address space reserved and/or committed for an OS_HOST_MEMORY_ALLOCATION and return it to the free pool.
-/// @param pool The pool to which the OS_HOST_MEMORY_ALLOCATION will be returned. This must be the same pool the allocation was acquired from.
-/// @param alloc The OS_HOST_MEMORY_ALLOCATION to return.
+#if !defined(__linux__)
+/// @summary End the current frame, attaching a task fence that is signaled when work referencing the frame's allocations has completed.
+/// @param arena The OS_FRAME_ARENA to update.
+/// @param fence The OS_TASK_FENCE to wait on before the generation is reused, or NULL if the memory can be reused immediately.
 public_function void
-OsHostMemoryPoolRelease
+OsFrameArenaEndFrame
 (
-    OS_HOST_MEMORY_POOL        *pool, 
-    OS_HOST_MEMORY_ALLOCATION *alloc
+    OS_FRAME_ARENA *arena, 
+    OS_TASK_FENCE  *fence
 )
 {
-    if (alloc->SourcePool != pool)
-    {
-        OsLayerError("ERROR: %S(%u): Returning allocation to incorrect pool %S.\n", __FUNCTION__, OsThreadId(), pool->Name);
-        assert(alloc->SourcePool == pool && "OS_HOST_MEMORY_ALLOCATION released to wrong pool");
-    }
-    if (alloc->BaseAddress != NULL)
-    {   // release all of the address space and return the chunk to the free pool.
-        OsHostMemoryRelease(alloc);
-        alloc->NextAllocation = pool->FreeList;
-        pool->FreeList = alloc;
-    }
+    OS_FRAME_ARENA_GENERATION *gen = &arena->Generations[arena->CurrentGeneration];
+    gen->TaskFence    = fence;
+    gen->FenceWait    = NULL;
+    gen->FenceContext = NULL;
+    gen->BytesUsed    = gen->Arena.Allocator.NextOffset;
 }
+#endif /* !defined(__linux__) */
 
-/// @summary Reset a host memory pool to empty. All allocations and reservations are invalidated.
-/// @param pool The OS_HOST_MEMORY_POOL to reset.
+/// @summary End the current frame, attaching a caller-supplied fence that is signaled when work referencing the frame's allocations has completed.
+/// @param arena The OS_FRAME_ARENA to update.
+/// @param fence_wait The callback used to wait for the fence before the generation is reused, or NULL if the memory can be reused immediately.
+/// @param fence_context Opaque data passed through to fence_wait.
 public_function void
-OsHostMemoryPoolReset
+OsFrameArenaEndFrame
 (
-    OS_HOST_MEMORY_POOL *pool
+    OS_FRAME_ARENA             *arena, 
+    OS_FRAME_FENCE_WAIT    fence_wait, 
+    void               *fence_context
 )
-{   // empty the pool free list.
-    pool->FreeList = NULL;
-    // release all memory allocations and return them to the free list.
-    for (size_t i = 0, n = pool->Capacity; i < n; ++i)
-    {
-        size_t ix = n - i - 1;
-        OsHostMemoryRelease(&pool->NodeList[ix]);
-        pool->NodeList[ix].SourcePool     = pool;
-        pool->NodeList[ix].NextAllocation = pool->FreeList;
-        pool->FreeList = &pool->NodeList[ix];
-    }
+{
+    OS_FRAME_ARENA_GENERATION *gen = &arena->Generations[arena->CurrentGeneration];
+    gen->TaskFence    = NULL;
+    gen->FenceWait    = fence_wait;
+    gen->FenceContext = fence_context;
+    gen->BytesUsed    = gen->Arena.Allocator.NextOffset;
 }
 
-/// @summary Reserve, and optionally commit, address space within a process. Call OsHostMemoryRelease first if the allocation currently holds a memory reservation.
-/// @param alloc The OS_HOST_MEMORY_ALLOCATION to initialize. The OS_HOST_MEMORY_ALLOCTION::SourcePool and OS_HOST_MEMORY_ALLOCATION::NextAllocation fields are expected to be set by the caller.
-/// @param reserve_size The number of bytes of process address space to reserve. This value is rounded up to the nearest even multiple of the operating system page size.
-/// @param commit_size The number of bytes of process address space to commit. This value is rounded up to the nearest even multiple of the operating system page size.
-/// @param alloc_flags One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS, or 0 if no special behavior is desired in which case the memory is readable, writable and has a guard page.
-/// @return Zero if the address space is successfully reserved, or -1 if an error occurred.
-public_function int
-OsHostMemoryReserveAndCommit
+/// @summary Allocate memory for the current frame. The memory remains valid until the generation is reused.
+/// @param arena The OS_FRAME_ARENA to allocate from.
+/// @param size The minimum number of bytes to allocate.
+/// @param alignment A power-of-two, greater than or equal to 1, specifying the alignment of the returned address.
+/// @return A pointer to the start of the allocated block, or NULL if the request could not be satisfied.
+public_function inline void*
+OsFrameArenaAllocate
 (
-    OS_HOST_MEMORY_ALLOCATION *alloc, 
-    size_t              reserve_size, 
-    size_t               commit_size, 
-    uint32_t             alloc_flags
+    OS_FRAME_ARENA *arena, 
+    size_t           size, 
+    size_t      alignment
 )
-{   assert(alloc->SourcePool != NULL);
-    void   *base = NULL;
-    size_t  page = alloc->SourcePool->PageSize;
-    size_t extra = 0;
-    DWORD access = 0;
-    DWORD  flags = MEM_RESERVE;
+{
+    return OsHostMemoryArenaAllocate(&arena->Generations[arena->CurrentGeneration].Arena, size, alignment);
+}
 
-    if (commit_size > reserve_size)
-    {
-        OsLayerError("ERROR: %S(%u): Requested commit size %Iu exceeds reserve size %Iu.\n", __FUNCTION__, OsThreadId(), commit_size, reserve_size);
-        return -1;
-    }
+/// @summary Allocate memory for a structure for the current frame.
+/// @typeparam T The type being allocated. This type is used to determine the required alignment.
+/// @param arena The OS_FRAME_ARENA to allocate from.
+/// @return A pointer to the new structure, or nullptr if the arena could not satisfy the allocation request.
+template <typename T>
+public_function inline T*
+OsFrameArenaAllocate
+(
+    OS_FRAME_ARENA *arena
+)
+{
+    return (T*) OsFrameArenaAllocate(arena, sizeof(T), std::alignment_of<T>::value);
+}
 
-    // VMM allocations are rounded up to the next even multiple of the system 
-    // page size, and have a starting address that is an even multiple of the
-    // allocation granularity (typically 64KB.)
-    reserve_size = OsAlignUp(reserve_size, page);
+/// @summary Allocate memory for an array of structures for the current frame.
+/// @typeparam T The type of array element. This type is used to determine the required alignment.
+/// @param arena The OS_FRAME_ARENA to allocate from.
+/// @param count The number of items to allocate.
+/// @return A pointer to the start of the array, or nullptr if the arena could not satisfy the allocation request.
+template <typename T>
+public_function inline T*
+OsFrameArenaAllocateArray
+(
+    OS_FRAME_ARENA *arena, 
+    size_t          count
+)
+{
+    return (T*) OsFrameArenaAllocate(arena, sizeof(T) * count, std::alignment_of<T>::value);
+}
 
-    // determine the VirtualAlloc protection flags for the reserved range of address space.
-    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_READ)
-    {   // assume read-only access. access is upgraded if additional flags are set.
-        access = PAGE_READONLY;
+/// @summary Retrieve statistics for the generation used by the current frame or a recent frame.
+/// For the current frame, BytesLive reports the bytes allocated so far; for earlier frames, it reports the bytes allocated as of the end of the frame.
+/// @param arena The OS_FRAME_ARENA to query.
+/// @param frames_ago Zero to query the current frame, one to query the previous frame, and so on.
+/// @param stats On return, the statistics for the generation.
+/// @return true if stats was populated, or false if frames_ago is not less than the number of generations or the frame has not yet occurred.
+public_function bool
+OsFrameArenaQueryStats
+(
+    OS_FRAME_ARENA           *arena, 
+    uint32_t             frames_ago, 
+    OS_ALLOCATOR_STATS       *stats
+)
+{
+    OS_FRAME_ARENA_GENERATION *gen = NULL;
+    if (frames_ago >= arena->GenerationCount || frames_ago > arena->FrameIndex)
+    {   // the generation has been (or will be) reused by a more recent frame.
+        return false;
     }
-    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_WRITE)
-    {   // write access implies read access to the memory.
-        access = PAGE_READWRITE;
+    gen = &arena->Generations[(arena->CurrentGeneration + arena->GenerationCount - frames_ago) % arena->GenerationCount];
+    OsHostMemoryArenaQueryStats(&gen->Arena, stats);
+    if (frames_ago > 0)
+    {   // report usage as of the end of the frame.
+        stats->BytesLive = gen->BytesUsed;
     }
-    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_EXECUTE)
-    {   // execute implies read and write access to the memory.
-        // additionally, this forces the entire reservation to be committed.
-        access = PAGE_EXECUTE_READWRITE;
-        commit_size = reserve_size;
+    return true;
+}
+
+/// @summary Acquire a new block for a chained arena from its host memory pool. Only the block header is committed.
+/// @param arena The OS_CHAINED_ARENA requesting the block.
+/// @param min_size The minimum number of bytes that must be available following the block header.
+/// @return A pointer to the new block, which is not linked into the chain, or NULL.
+internal_function OS_CHAINED_ARENA_BLOCK*
+OsChainedArenaAcquireBlock
+(
+    OS_CHAINED_ARENA *arena, 
+    size_t         min_size
+)
+{
+    OS_HOST_MEMORY_ALLOCATION *alloc = NULL;
+    OS_CHAINED_ARENA_BLOCK    *block = NULL;
+    size_t                reserve_size = arena->BlockSize;
+    if (min_size > SIZE_MAX - OS_CHAINED_ARENA::BLOCK_HEADER_SIZE)
+    {   // the request can never be satisfied.
+        return NULL;
     }
-    if (alloc_flags == OS_HOST_MEMORY_ALLOCATION_FLAGS_NONE)
-    {   // use the default access; the memory is readable and writable.
-        access = PAGE_READWRITE;
+    if (reserve_size < OS_CHAINED_ARENA::BLOCK_HEADER_SIZE + min_size)
+    {   // oversized requests get a dedicated block.
+        reserve_size = OS_CHAINED_ARENA::BLOCK_HEADER_SIZE + min_size;
+    }
+    if ((alloc = OsHostMemoryPoolAllocate(arena->SourcePool, reserve_size, OS_CHAINED_ARENA::BLOCK_HEADER_SIZE, arena->AllocationFlags)) == NULL)
+    {   // OsHostMemoryPoolAllocate output error information already.
+        return NULL;
     }
+    block = (OS_CHAINED_ARENA_BLOCK*) alloc->BaseAddress;
+    block->Allocation  = alloc;
+    block->PrevBlock   = NULL;
+    block->BaseOffset  = 0;
+    block->NextOffset  = OS_CHAINED_ARENA::BLOCK_HEADER_SIZE;
+    block->SizeInBytes = alloc->BytesReserved;
+    return block;
+}
 
-    // determine whether a guard page will be allocated for this allocation.
-    if (alloc_flags & OS_HOST_MEMORY_ALLOCATION_FLAG_NO_GUARD_PAGE)
-    {   // don't include a guard page.
-        extra = 0;
+/// @summary Return blocks to the host memory pool, starting from the current block and working backwards, until a given block becomes current.
+/// @param arena The OS_CHAINED_ARENA to update.
+/// @param keep The block that should become the current block, or NULL to release all blocks.
+internal_function void
+OsChainedArenaReleaseBlocks
+(
+    OS_CHAINED_ARENA       *arena, 
+    OS_CHAINED_ARENA_BLOCK  *keep
+)
+{
+    while (arena->CurrentBlock != keep)
+    {   // the header lives in the block memory, so read it before releasing the block.
+        OS_CHAINED_ARENA_BLOCK     *block = arena->CurrentBlock;
+        OS_HOST_MEMORY_ALLOCATION  *alloc = block->Allocation;
+        arena->CurrentBlock = block->PrevBlock;
+        arena->BlockCount--;
+        OsHostMemoryPoolRelease(arena->SourcePool, alloc);
     }
-    else
-    {   // include an extra page at the end of the reserved address space range.
-        extra = page;
+    if (keep == NULL)
+    {   // the chain is now empty.
+        arena->FirstBlock = NULL;
     }
+}
 
-    if (commit_size > 0)
-    {   // memory will be both reserved and committed.
-        commit_size = OsAlignUp(commit_size, page);
-        flags |= MEM_COMMIT;
+/// @summary Initialize a chained arena and acquire its first block.
+/// @param arena The OS_CHAINED_ARENA to initialize.
+/// @param pool The OS_HOST_MEMORY_POOL from which blocks are acquired. Blocks are released back to this pool when the arena is reset or deleted.
+/// @param block_size The minimum number of bytes of address space to reserve for each block. Address space is committed as it is allocated.
+/// @param alloc_flags One or more of OS_HOST_MEMORY_ALLOCATION_FLAGS, or 0 to use OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE.
+/// @return Zero if the arena is initialized, or -1 if an error occurred.
+public_function int
+OsCreateChainedArena
+(
+    OS_CHAINED_ARENA      *arena, 
+    OS_HOST_MEMORY_POOL    *pool, 
+    size_t            block_size, 
+    uint32_t         alloc_flags
+)
+{
+    OsZeroMemory(arena, sizeof(OS_CHAINED_ARENA));
+    if (alloc_flags == 0)
+    {   // use the default access; the memory is readable and writable.
+        alloc_flags = OS_HOST_MEMORY_ALLOCATION_FLAGS_READWRITE;
     }
-
-    // reserve (and possibly commit) contiguous virtual address space.
-    if ((base = VirtualAlloc(NULL, reserve_size+extra, flags, access)) == NULL)
+    arena->SourcePool      = pool;
+    arena->BlockSize       = block_size;
+    arena->AllocationFlags = alloc_flags;
+    if ((arena->FirstBlock = OsChainedArenaAcquireBlock(arena, 0)) == NULL)
     {
-        OsLayerError("ERROR: %S(%u): VirtualAlloc for %Iu bytes failed (%08X).\n", __FUNCTION__, OsThreadId(), reserve_size+extra, GetLastError());
+        OsLayerError("ERROR: %S(%u): Failed to acquire initial %Iu byte block for chained arena.\n", __FUNCTION__, OsThreadId(), block_size);
         return -1;
     }
-    if (extra > 0)
-    {   // change the protection flags for the guard page only.
-        if (VirtualAlloc((uint8_t*) base+reserve_size, page, MEM_COMMIT, access | PAGE_GUARD) == NULL)
-        {
-            OsLayerError("ERROR: %S(%u): Failed to create guard page (%08X).\n", __FUNCTION__, OsThreadId(), GetLastError());
-            VirtualFree(base, 0, MEM_RELEASE);
-            return -1;
-        }
-    }
-
-    // initialize the OS_HOST_MEMORY_ALLOCATION fields.
-    alloc->BaseAddress     =(uint8_t*) base;
-    alloc->BytesReserved   = reserve_size;
-    alloc->BytesCommitted  = commit_size;
-    alloc->AllocationFlags = alloc_flags;
+    arena->CurrentBlock  = arena->FirstBlock;
+    arena->HighWaterMark = OS_CHAINED_ARENA::BLOCK_HEADER_SIZE;
+    arena->BlockCount    = 1;
     return 0;
 }
 
-/// @summary Increase the amount of committed memory within an allocation. The commit size cannot exceed the reserve size.
-/// @param alloc The OS_HOST_MEMORY_ALLOCATION having its commit size increased.
-/// @param commit_size The total amount of memory within the allocation that should be committed.
-/// @return Zero if at least the specified amount of address space is successfully committed, or -1 if an error occurred.
-public_function int
-OsHostMemoryIncreaseCommitment
+/// @summary Return all blocks owned by a chained arena to the host memory pool. All allocations are invalidated.
+/// @param arena The OS_CHAINED_ARENA to delete.
+public_function void
+OsDeleteChainedArena
 (
-    OS_HOST_MEMORY_ALLOCATION *alloc, 
-    size_t               commit_size
+    OS_CHAINED_ARENA *arena
 )
 {
-    if (alloc->BytesCommitted < commit_size)
-    {   // VMM calls are expensive, so enforce a minimum commit increase.
-        size_t const MIN_COMMIT_INCREASE = alloc->SourcePool->MinCommitIncrease;
-        size_t const max_commit_increase = alloc->BytesReserved - alloc->BytesCommitted;
-        size_t       req_commit_increase = commit_size          - alloc->BytesCommitted;
-        if (req_commit_increase < MIN_COMMIT_INCREASE)
-        {   // request the minimum commit increase.
-            req_commit_increase = MIN_COMMIT_INCREASE;
-        }
-        if (req_commit_increase > max_commit_increase)
-        {   // limit to the maximum possible commit increase.
-            req_commit_increase = max_commit_increase;
-        }
-        size_t new_bytes_commit = OsAlignUp(alloc->BytesCommitted + req_commit_increase, alloc->SourcePool->PageSize);
-        DWORD            access = 0;
-        if (alloc->AllocationFlags & OS_HOST_MEMORY_ALLOCATION_FLAG_READ)
-        {   // assume read-only access. access is upgraded if additional flags are set.
-            access = PAGE_READONLY;
-        }
-        if (alloc->AllocationFlags & OS_HOST_MEMORY_ALLOCATION_FLAG_WRITE)
-        {   // write access implies read access to the memory.
-            access = PAGE_READWRITE;
-        }
-        if (alloc->AllocationFlags & OS_HOST_MEMORY_ALLOCATION_FLAG_EXECUTE)
-        {   // execute implies read and write access to the memory.
-            access = PAGE_EXECUTE_READWRITE;
-        }
-        if (alloc->AllocationFlags == OS_HOST_MEMORY_ALLOCATION_FLAGS_NONE)
-        {   // use the default access; the memory is readable and writable.
-            access = PAGE_READWRITE;
+    OsChainedArenaReleaseBlocks(arena, NULL);
+    OsZeroMemory(arena, sizeof(OS_CHAINED_ARENA));
+}
+
+/// @summary Allocate memory from a chained arena. If the current block cannot satisfy the request, a new block is acquired from the host memory pool.
+/// @param arena The OS_CHAINED_ARENA to allocate from.
+/// @param size The minimum number of bytes to allocate.
+/// @param alignment A power-of-two, greater than or equal to 1, specifying the alignment of the returned address.
+/// @return A pointer to the start of the allocated block, or NULL if the request could not be satisfied.
+public_function void*
+OsChainedArenaAllocate
+(
+    OS_CHAINED_ARENA *arena, 
+    size_t             size, 
+    size_t        alignment
+)
+{
+    OS_CHAINED_ARENA_BLOCK *block = arena->CurrentBlock;
+    size_t                address = 0;
+    size_t             new_offset = 0;
+    if (block != NULL)
+    {
+        address = OsAlignUp((size_t) block + block->NextOffset, alignment);
+    }
+    if (block == NULL || size > block->SizeInBytes || address - (size_t) block > block->SizeInBytes - size)
+    {   // the current block is exhausted. link a new block to the end of the chain.
+        OS_CHAINED_ARENA_BLOCK *next = NULL;
+        if (size > SIZE_MAX - alignment || (next = OsChainedArenaAcquireBlock(arena, size + alignment - 1)) == NULL)
+        {
+            arena->FailedCount++;
+            return NULL;
         }
-        // request that an additional portion of the pre-reserved address space be committed.
-        // executable allocations are entirely committed up-front, so no need to worry about that case here.
-        if (VirtualAlloc((uint8_t*) alloc->BaseAddress, new_bytes_commit, MEM_COMMIT, access) == NULL)
+        if (block != NULL)
         {
-            OsLayerError("ERROR: %S(%u): Failed to increase commit size to %Iu from %Iu.\n", __FUNCTION__, OsThreadId(), new_bytes_commit, alloc->BytesCommitted);
-            return -1;
+            next->PrevBlock  = block;
+            next->BaseOffset = block->BaseOffset + block->SizeInBytes;
         }
-        // the commitment amount was increased successfully.
-        alloc->BytesCommitted = new_bytes_commit;
-        return 0;
-    }
-    else
-    {   // the requested commitment has already been met.
-        return 0;
+        else
+        {   // the arena has no blocks, for example after a failed reset.
+            arena->FirstBlock = next;
+        }
+        arena->CurrentBlock = next;
+        arena->BlockCount++;
+        arena->GrowCount++;
+        block   = next;
+        address = OsAlignUp((size_t) block + block->NextOffset, alignment);
+    }
+    new_offset = (address + size) - (size_t) block;
+    if (new_offset > block->Allocation->BytesCommitted && OsHostMemoryIncreaseCommitment(block->Allocation, new_offset) < 0)
+    {   // OsHostMemoryIncreaseCommitment output error information already.
+        arena->FailedCount++;
+        return NULL;
     }
+    block->NextOffset = new_offset;
+    if (block->BaseOffset + new_offset > arena->HighWaterMark)
+        arena->HighWaterMark = block->BaseOffset + new_offset;
+    arena->AllocationCount++;
+    OsAllocationTraceRecord(arena, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_ALLOCATE, (uint64_t) address, size, alignment);
+    return (void*) address;
 }
 
-/// @summary Flush the CPU instruction cache after dynamically generated code has been written to a memory allocation with the EXECUTE flag set.
-/// @param alloc The OS_HOST_MEMORY_ALLOCATION containing the dynamically-generated code.
-public_function void
-OsHostMemoryFlush
+/// @summary Allocate memory for a structure from a chained arena.
+/// @typeparam T The type being allocated. This type is used to determine the required alignment.
+/// @param arena The OS_CHAINED_ARENA to allocate from.
+/// @return A pointer to the new structure, or nullptr if the arena could not satisfy the allocation request.
+template <typename T>
+public_function inline T*
+OsChainedArenaAllocate
 (
-    OS_HOST_MEMORY_ALLOCATION *alloc
+    OS_CHAINED_ARENA *arena
 )
 {
-    if (alloc->AllocationFlags & OS_HOST_MEMORY_ALLOCATION_FLAG_EXECUTE)
-    {
-        if (!FlushInstructionCache(GetCurrentProcess(), alloc->BaseAddress, alloc->BytesCommitted))
-        {
-            OsLayerError("ERROR: %S(%u): Failed to flush instruction cache (%08X).\n", __FUNCTION__, OsThreadId(), GetLastError());
-        }
-    }
+    return (T*) OsChainedArenaAllocate(arena, sizeof(T), std::alignment_of<T>::value);
 }
 
-/// @summary Release the process address space associated with a host memory allocation.
-/// @param alloc The OS_HOST_MEMORY_ALLOCATION to release.
-public_function void
-OsHostMemoryRelease
+/// @summary Allocate memory for an array of structures from a chained arena.
+/// @typeparam T The type of array element. This type is used to determine the required alignment.
+/// @param arena The OS_CHAINED_ARENA to allocate from.
+/// @param count The number of items to allocate.
+/// @return A pointer to the start of the array, or nullptr if the arena could not satisfy the allocation request.
+template <typename T>
+public_function inline T*
+OsChainedArenaAllocateArray
 (
-    OS_HOST_MEMORY_ALLOCATION *alloc
+    OS_CHAINED_ARENA *arena, 
+    size_t            count
 )
 {
-    if (alloc->BaseAddress != NULL)
-    {   // free the entire reserved range of virtual address space.
-        VirtualFree(alloc->BaseAddress, 0, MEM_RELEASE);
-    }
-    alloc->BaseAddress    = NULL;
-    alloc->BytesReserved  = 0;
-    alloc->BytesCommitted = 0;
+    return (T*) OsChainedArenaAllocate(arena, sizeof(T) * count, std::alignment_of<T>::value);
 }
 
-/// @summary Initialize an OS_ARENA_ALLOCATOR.
-/// @param alloc The OS_ARENA_ALLOCATOR to initialize.
-/// @param size_in_bytes The number of bytes from which the arena will sub-allocate.
-/// @return Zero if the allocator is successfully initialized, or -1 if an error occurred.
-public_function int
-OsCreateArenaAllocator
+/// @summary Retrieve a marker that can be used to reset a chained arena, preserving all current allocations.
+/// @param arena The OS_CHAINED_ARENA to query.
+/// @return The marker representing the logical offset of the next allocation.
+public_function os_arena_marker_t
+OsChainedArenaMark
 (
-    OS_ARENA_ALLOCATOR *alloc, 
-    size_t      size_in_bytes
+    OS_CHAINED_ARENA *arena
 )
 {
-    alloc->NextOffset  = 0;
-    alloc->SizeInBytes = size_in_bytes;
-    return 0;
+    if (arena->CurrentBlock != NULL)
+        return arena->CurrentBlock->BaseOffset + arena->CurrentBlock->NextOffset;
+    else
+        return 0;
 }
 
-/// @summary Free resources associated with an arena allocator.
-/// @param alloc The OS_ARENA_ALLOCATOR to delete.
+/// @summary Reset a chained arena back to a marker. Blocks acquired after the marker was taken are returned to the host memory pool.
+/// @param arena The OS_CHAINED_ARENA to reset.
+/// @param arena_marker The marker value returned by OsChainedArenaMark().
 public_function void
-OsDeleteArenaAllocator
+OsChainedArenaResetToMarker
 (
-    OS_ARENA_ALLOCATOR *alloc
+    OS_CHAINED_ARENA        *arena, 
+    os_arena_marker_t arena_marker
 )
-{
-    alloc->NextOffset  = 0;
-    alloc->SizeInBytes = 0;
+{   assert(arena_marker <= OsChainedArenaMark(arena));
+    OS_CHAINED_ARENA_BLOCK *block = arena->CurrentBlock;
+    while (block != NULL && block != arena->FirstBlock && arena_marker < block->BaseOffset + OS_CHAINED_ARENA::BLOCK_HEADER_SIZE)
+    {   // the marker was taken before this block was acquired.
+        block = block->PrevBlock;
+    }
+    OsChainedArenaReleaseBlocks(arena, block);
+    if (block != NULL)
+    {
+        if (arena_marker > block->BaseOffset + OS_CHAINED_ARENA::BLOCK_HEADER_SIZE)
+            block->NextOffset = arena_marker - block->BaseOffset;
+        else
+            block->NextOffset = OS_CHAINED_ARENA::BLOCK_HEADER_SIZE;
+    }
+    arena->ResetCount++;
+    OsAllocationTraceRecord(arena, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_RESET, arena_marker, 0, 0);
 }
 
-/// @summary Determine whether an arena allocator can satisfy an allocation request.
-/// @param alloc The OS_ARENA_ALLOCATOR to query.
-/// @param size The minimum number of bytes to reserve.
-/// @param alignment The required alignment of the returned block offset.
-/// @return true if the arena can satisfy the allocation request.
-public_function bool
-OsArenaAllocatorCanSatisfyAllocation
+/// @summary Reset a chained arena to empty. If more than one block is in use, the blocks are coalesced into a single block large enough 
+/// to hold the high-water mark, so that a steady-state workload is satisfied from one block. The high-water mark is then reset.
+/// @param arena The OS_CHAINED_ARENA to reset.
+public_function void
+OsChainedArenaReset
 (
-    OS_ARENA_ALLOCATOR *alloc, 
-    size_t               size, 
-    size_t          alignment
+    OS_CHAINED_ARENA *arena
 )
 {
-    size_t aligned_address = OsAlignUp(alloc->NextOffset, alignment);
-    size_t     alloc_bytes = size + (aligned_address - alloc->NextOffset);
-    size_t      new_offset = alloc_bytes + alloc->NextOffset;
-    return (new_offset <= alloc->SizeInBytes);
+    if (arena->BlockCount > 1)
+    {   // acquire the coalesced block before releasing the chain, so a failure leaves the first block intact.
+        OS_CHAINED_ARENA_BLOCK *block = OsChainedArenaAcquireBlock(arena, arena->HighWaterMark);
+        if (block != NULL)
+        {
+            OsChainedArenaReleaseBlocks(arena, NULL);
+            arena->FirstBlock   = block;
+            arena->CurrentBlock = block;
+            arena->BlockCount   = 1;
+        }
+        else
+        {   // continue with the existing first block.
+            OsChainedArenaReleaseBlocks(arena, arena->FirstBlock);
+        }
+    }
+    if (arena->CurrentBlock != NULL)
+    {
+        arena->CurrentBlock->NextOffset = OS_CHAINED_ARENA::BLOCK_HEADER_SIZE;
+    }
+    arena->HighWaterMark = OS_CHAINED_ARENA::BLOCK_HEADER_SIZE;
+    arena->ResetCount++;
+    OsAllocationTraceRecord(arena, OS_RETURN_ADDRESS(), OS_ALLOCATION_EVENT_RESET, 0, 0, 0);
 }
 
-/// @summary Reserve space from an arena allocator.
-/// @param alloc The OS_ARENA_ALLOCATOR to update.
-/// @param size The minimum number of bytes to reserve.
-/// @param alignment The required alignment of the returned memory block offset.
-/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region.
-/// @return true if the arena satisfied the allocation request.
-public_function bool
-OsArenaAllocate
+/// @summary Retrieve statistics for a chained arena. BytesLive and BytesPeak are logical offsets, and include block headers and unused space at the end of each block.
+/// @param arena The OS_CHAINED_ARENA to query.
+/// @param stats On return, the statistics for the arena.
+public_function void
+OsChainedArenaQueryStats
 (
-    OS_ARENA_ALLOCATOR *alloc, 
-    size_t               size, 
-    size_t          alignment, 
-    OS_MEMORY_RANGE    &range
+    OS_CHAINED_ARENA   *arena, 
+    OS_ALLOCATOR_STATS *stats
 )
 {
-    size_t aligned_address = OsAlignUp(alloc->NextOffset, alignment);
-    size_t     alloc_bytes = size + (aligned_address - alloc->NextOffset);
-    size_t      new_offset = alloc_bytes + alloc->NextOffset;
-    if (new_offset <= alloc->SizeInBytes)
-    {   // the allocation was satisfied, return the new info.
-        range.ByteOffset   = aligned_address;
-        range.SizeInBytes  = size;
-        alloc->NextOffset  = new_offset;
-        return true;
+    stats->AllocationCount  = arena->AllocationCount;
+    stats->FreeCount        = arena->ResetCount;
+    stats->FailedCount      = arena->FailedCount;
+    stats->BytesLive        = OsChainedArenaMark(arena);
+    stats->BytesPeak        = arena->HighWaterMark;
+    stats->BytesFree        = 0;
+    stats->LargestFreeBlock = 0;
+    stats->BytesReserved    = 0;
+    stats->BytesCommitted   = 0;
+    stats->CommitCount      = 0;
+    if (arena->CurrentBlock != NULL)
+    {
+        stats->BytesFree        = arena->CurrentBlock->SizeInBytes - arena->CurrentBlock->NextOffset;
+        stats->LargestFreeBlock = stats->BytesFree;
     }
-    else
-    {   // not enough space to satisfy the allocation.
-        range.ByteOffset   = 0;
-        range.SizeInBytes  = 0;
-        return false;
+    for (OS_CHAINED_ARENA_BLOCK *block = arena->CurrentBlock; block != NULL; block = block->PrevBlock)
+    {
+        stats->BytesReserved   += block->SizeInBytes;
+        stats->BytesCommitted  += block->Allocation->BytesCommitted;
     }
 }
 
-/// @summary Retrieve a marker representing the state of the arena allocator at the current point in time.
-/// @param alloc The OS_ARENA_ALLOCATOR to query.
-/// @return A marker that can be passed to OsArenaResetToMarker to reset the allocator back to its current state.
-public_function os_arena_marker_t 
-OsArenaMark
+/// @summary Initialize a memory arena that can be allocated from by multiple threads concurrently.
+/// If the arena was previously deleted, its generation continues to advance, so chunks acquired before the delete are not reused.
+/// @param arena The OS_CONCURRENT_ARENA to initialize. Zero-initialize it before it is created for the first time.
+/// @param host_memory The address and size of the host-visible memory block to sub-allocate from. The size may be zero, in which case all allocations fail.
+/// @param chunk_size The number of bytes handed out to each thread-owned chunk at once, or zero to use OS_CONCURRENT_ARENA::DEFAULT_CHUNK_SIZE.
+/// @return Zero if the arena is initialized, or -1 if an error occurred.
+public_function int
+OsCreateConcurrentArena
 (
-    OS_ARENA_ALLOCATOR *alloc
+    OS_CONCURRENT_ARENA *arena, 
+    OS_MEMORY_RANGE host_memory, 
+    size_t           chunk_size
 )
 {
-    return alloc->NextOffset;
+    if (chunk_size == 0)
+    {   // use the default chunk size.
+        chunk_size = OS_CONCURRENT_ARENA::DEFAULT_CHUNK_SIZE;
+    }
+    uint32_t generation = arena->Generation.load(std::memory_order_relaxed) + 1;
+    arena->HostMemory = host_memory;
+    arena->ChunkSize  = chunk_size;
+    // generation zero is reserved for zero-initialized OS_CONCURRENT_ARENA_CHUNK instances.
+    arena->Generation.store(generation != 0 ? generation : 1, std::memory_order_relaxed);
+    arena->NextOffset.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return 0;
 }
 
-/// @summary Reset an arena allocator back to a past point in time, invalidating all allocations made from that point forward.
-/// @param alloc The OS_ARENA_ALLOCATOR to reset.
-/// @param marker A marker returned by a previous call to OsArenaMark.
+/// @summary Release resources associated with a concurrent memory arena. All allocations are invalidated.
+/// @param arena The memory arena to delete.
 public_function void
-OsArenaResetToMarker
+OsDeleteConcurrentArena
 (
-    OS_ARENA_ALLOCATOR *alloc, 
-    os_arena_marker_t  marker
+    OS_CONCURRENT_ARENA *arena
 )
-{   assert(marker <= alloc->NextOffset);
-    alloc->NextOffset = marker;
+{
+    arena->HostMemory.HostAddress = NULL;
+    arena->HostMemory.SizeInBytes = 0;
+    arena->ChunkSize = 0;
+    // chunks acquired from the deleted arena must not satisfy allocations if the arena is created again.
+    arena->Generation.fetch_add(1, std::memory_order_relaxed);
+    arena->NextOffset.store(0, std::memory_order_relaxed);
 }
 
-/// @summary Reset an arena allocator to empty.
-/// @param alloc The OS_ARENA_ALLOCATOR to reset.
-public_function void
-OsArenaReset
+/// @summary Allocate memory directly from a concurrent arena. This function is safe to call from multiple threads, and never blocks.
+/// @param arena The memory arena to allocate from.
+/// @param size The minimum number of bytes to allocate.
+/// @param alignment A power-of-two, greater than or equal to 1, specifying the alignment of the returned address.
+/// @return A pointer to the start of the allocated block, or NULL if the request could not be satisfied.
+public_function void*
+OsConcurrentArenaAllocate
 (
-    OS_ARENA_ALLOCATOR *alloc
+    OS_CONCURRENT_ARENA *arena, 
+    size_t                size, 
+    size_t           alignment
 )
-{
-    alloc->NextOffset = 0;
+{   // over-allocate by alignment-1 bytes so that the block can be aligned wherever it lands.
+    uint8_t     *base = arena->HostMemory.HostAddress;
+    size_t   capacity = arena->HostMemory.SizeInBytes;
+    size_t alloc_size = size + (alignment - 1);
+    size_t     offset = arena->NextOffset.load(std::memory_order_relaxed);
+    if (alloc_size < size)
+    {   // the request size overflows.
+        return NULL;
+    }
+    do
+    {
+        if (offset > capacity || alloc_size > capacity - offset)
+        {   // the request does not fit. NextOffset is left unchanged, so smaller requests can still succeed.
+            return NULL;
+        }
+    } while (!arena->NextOffset.compare_exchange_weak(offset, offset + alloc_size, std::memory_order_relaxed, std::memory_order_relaxed));
+    // align the address, rather than the offset, since the base address may be unaligned.
+    return (void*) OsAlignUp((size_t)(base + offset), alignment);
 }
 
-/// @summary Push a block offset onto the free list for a given level.
-/// @param alloc The OS_BUDDY_ALLOCATOR instance to which the free block is being returned.
-/// @param offset The byte offset of the start of the allocated block.
-/// @param level The zero-based index of the level to which the block belongs.
-internal_function inline void
-OsBuddyAllocatorPushFreeOffset
+/// @summary Allocate memory from a concurrent arena, using a thread-owned chunk to avoid contention on the shared arena state.
+/// A new chunk is acquired from the arena when the current chunk is exhausted or invalidated by a mark or reset operation.
+/// @param arena The memory arena to allocate from.
+/// @param chunk The OS_CONCURRENT_ARENA_CHUNK owned by the calling thread.
+/// @param size The minimum number of bytes to allocate.
+/// @param alignment A power-of-two, greater than or equal to 1, specifying the alignment of the returned address.
+/// @return A pointer to the start of the allocated block, or NULL if the request could not be satisfied.
+public_function void*
+OsConcurrentArenaAllocate
 (
-    OS_BUDDY_ALLOCATOR *alloc, 
-    uint32_t           offset, 
-    uint32_t            level
+    OS_CONCURRENT_ARENA       *arena, 
+    OS_CONCURRENT_ARENA_CHUNK *chunk,
+    size_t                      size, 
+    size_t                 alignment
 )
 {
-    uint32_t *freelist = alloc->FreeLists[level];
-    uint32_t    &count = alloc->FreeCount[level];
-    freelist[count++]  = offset;
+    uint8_t    *base = arena->HostMemory.HostAddress;
+    uint32_t     gen = arena->Generation.load(std::memory_order_relaxed);
+    size_t     start = 0;
+    size_t  required = 0;
+    size_t chunk_len = 0;
+    if (chunk->Generation == gen)
+    {   // attempt to satisfy the request from the current chunk.
+        start = OsAlignUp((size_t)(base + chunk->NextOffset), alignment) - (size_t) base;
+        if (start <= chunk->EndOffset && size <= chunk->EndOffset - start)
+        {
+            chunk->NextOffset = start + size;
+            return base + start;
+        }
+    }
+    // acquire a new chunk large enough to satisfy the request. the chunk is 
+    // clamped to the space remaining in the arena, so the tail isn't wasted.
+    // the remainder of the old chunk is abandoned until the arena is reset.
+    required  = size + (alignment - 1);
+    if (required < size)
+    {   // the request size overflows.
+        return NULL;
+    }
+    chunk_len = required > arena->ChunkSize ? required : arena->ChunkSize;
+    start     = arena->NextOffset.load(std::memory_order_relaxed);
+    do
+    {
+        size_t  capacity = arena->HostMemory.SizeInBytes;
+        size_t remaining = start < capacity ? capacity - start : 0;
+        if (remaining < required)
+        {   // the arena is exhausted.
+            chunk->Generation = 0;
+            return NULL;
+        }
+        if (chunk_len > remaining)
+            chunk_len = remaining;
+    } while (!arena->NextOffset.compare_exchange_weak(start, start + chunk_len, std::memory_order_relaxed, std::memory_order_relaxed));
+    chunk->EndOffset  = start + chunk_len;
+    chunk->Generation = gen;
+    start = OsAlignUp((size_t)(base + start), alignment) - (size_t) base;
+    chunk->NextOffset = start + size;
+    return base + start;
 }
 
-/// @summary Pop a block offset from the free list for a given level. The caller must ensure that the free list for the specified level is not empty.
-/// @param alloc The OS_BUDDY_ALLOCATOR instance from which the free block is being taken.
-/// @param level The zero-based index of the level to which the block belongs.
-/// @return The byte offset of a free block.
-internal_function inline uint32_t
-OsBuddyAllocatorPopFreeOffset
+/// @summary Allocate memory for a structure from a thread-owned chunk of a concurrent arena.
+/// @typeparam T The type being allocated. This type is used to determine the required alignment.
+/// @param arena The memory arena to allocate from.
+/// @param chunk The OS_CONCURRENT_ARENA_CHUNK owned by the calling thread.
+/// @return A pointer to the new structure, or nullptr if the arena could not satisfy the allocation request.
+template <typename T>
+public_function inline T*
+OsConcurrentArenaAllocate
 (
-    OS_BUDDY_ALLOCATOR *alloc, 
-    uint32_t            level
+    OS_CONCURRENT_ARENA       *arena, 
+    OS_CONCURRENT_ARENA_CHUNK *chunk
 )
 {
-    uint32_t *freelist = alloc->FreeLists[level];
-    uint32_t    &count = alloc->FreeCount[level];
-    return freelist[--count];
+    return (T*) OsConcurrentArenaAllocate(arena, chunk, sizeof(T), std::alignment_of<T>::value);
 }
 
-/// @summary Retrieve information about a memory block where the corresponding level index is known.
-/// @param info The OS_BUDDY_BLOCK_INFO to populate.
-/// @param alloc The OS_BUDDY_ALLOCATOR from which the block was allocated.
-/// @param block_offset The offset of the allocation from the start of the memory range, as returned by a prior call to OsBuddyAllocate.
-/// @param level The zero-based index of the level from which the block was allocated.
-internal_function void
-OsBuddyAllocatorBlockInfo
+/// @summary Allocate memory for an array of structures from a thread-owned chunk of a concurrent arena.
+/// @typeparam T The type of array element. This type is used to determine the required alignment.
+/// @param arena The memory arena to allocate from.
+/// @param chunk The OS_CONCURRENT_ARENA_CHUNK owned by the calling thread.
+/// @param count The number of items to allocate.
+/// @return A pointer to the start of the array, or nullptr if the arena could not satisfy the allocation request.
+template <typename T>
+public_function inline T*
+OsConcurrentArenaAllocateArray
 (
-    OS_BUDDY_BLOCK_INFO *info, 
-    OS_BUDDY_ALLOCATOR *alloc, 
-    uint32_t     block_offset,
-    uint32_t            level
+    OS_CONCURRENT_ARENA       *arena, 
+    OS_CONCURRENT_ARENA_CHUNK *chunk,
+    size_t                     count
 )
 {
-    uint32_t     level_shift = alloc->LevelBits[level];
-    uint32_t     block_count = 1 << level;
-    uint32_t     local_index = block_offset >> level_shift;
-    uint32_t       odd_index = local_index &  1;
-    int32_t     buddy_offset = odd_index   ? -1 : +1;
-    info->LevelIndex         = level;
-    info->BitIndex           = level_shift;
-    info->BlockSize          = 1 << level_shift;
-    info->BlockCount         = block_count;
-    info->IndexOffset        = block_count - 1;
-    info->LeftAbsoluteIndex  = block_count + (local_index - odd_index) - 1;
-    info->BlockAbsoluteIndex = block_count +  local_index - 1;
-    info->BuddyAbsoluteIndex = block_count + (local_index + buddy_offset) - 1;
-}
-
-/// @summary Retrieve the information necessary to look up the status bit in the buddy allocator merge index for a given block.
-/// @param info The OS_BUDDY_BLOCK_MERGE_INFO to populate.
-/// @param block Information about the memory block, retrieved by a prior call to OsBuddyAllocatorBlockInfo.
-internal_function inline void
-OsBuddyAllocatorMergeIndexInfo
+    return (T*) OsConcurrentArenaAllocate(arena, chunk, sizeof(T) * count, std::alignment_of<T>::value);
+}
+
+/// @summary Retrieve a marker that can be used to reset the arena, preserving all current allocations. 
+/// All thread-owned chunks are invalidated, so that allocations made after the mark are released by OsConcurrentArenaResetToMarker.
+/// This function must not be called while other threads are allocating from the arena.
+/// @param arena The memory arena to query.
+/// @return The marker representing the byte offset of the next allocation.
+public_function os_arena_marker_t
+OsConcurrentArenaMark
 (
-    OS_BUDDY_BLOCK_MERGE_INFO  *info, 
-    OS_BUDDY_BLOCK_INFO const &block
+    OS_CONCURRENT_ARENA *arena
 )
 {
-    info->WordIndex =  block.LeftAbsoluteIndex >> 5;
-    info->Mask = 1 << (block.LeftAbsoluteIndex & 31);
+    arena->Generation.fetch_add(1, std::memory_order_relaxed);
+    return (os_arena_marker_t) arena->NextOffset.load(std::memory_order_relaxed);
 }
 
-/// @summary Retrieve the information necessary to look up the status bit in the buddy allocator split index for a given block.
-/// @param info The OS_BUDDY_BLOCK_SPLIT_INFO to populate.
-/// @param block Information about the memory block, retrieved by a prior call to OsBuddyAllocatorBlockInfo.
-internal_function inline void
-OsBuddyAllocatorSplitIndexInfo
+/// @summary Reset the state of the arena back to a marker, invalidating all allocations made after the marker was obtained.
+/// This function must not be called while other threads are allocating from the arena.
+/// @param arena The memory arena to reset.
+/// @param arena_marker The marker value returned by OsConcurrentArenaMark().
+public_function void
+OsConcurrentArenaResetToMarker
 (
-    OS_BUDDY_BLOCK_SPLIT_INFO  *info, 
-    OS_BUDDY_BLOCK_INFO const &block
+    OS_CONCURRENT_ARENA    *arena,
+    os_arena_marker_t arena_marker
 )
-{
-    info->WordIndex =  block.BlockAbsoluteIndex >> 5;
-    info->Mask = 1 << (block.BlockAbsoluteIndex & 31);
+{   assert(arena_marker <= arena->NextOffset.load(std::memory_order_relaxed));
+    arena->Generation.fetch_add(1, std::memory_order_relaxed);
+    arena->NextOffset.store(arena_marker, std::memory_order_relaxed);
 }
 
-/// @summary Initialize a buddy allocator instance.
-/// @param alloc The OS_BUDDY_ALLOCATOR to initialize.
-/// @param init Data specifying the allocator configuration.
-/// @return Zero if the allocator is initialized successfully, or -1 if an error occurred.
-public_function int
-OsCreateBuddyAllocator
+/// @summary Reset the state of the arena to empty, invalidating all allocations.
+/// This function must not be called while other threads are allocating from the arena.
+/// @param arena The memory arena to reset.
+public_function void
+OsConcurrentArenaReset
 (
-    OS_BUDDY_ALLOCATOR     *alloc, 
-    OS_BUDDY_ALLOCATOR_INIT *init
+    OS_CONCURRENT_ARENA *arena
 )
 {
-    if ((init->AllocationSizeMin & (init->AllocationSizeMin-1)) != 0)
-    {
-        OsLayerError("ERROR: %S(%u): Buddy allocator requires Pow2 AllocationSizeMin.\n", __FUNCTION__, OsThreadId());
-        assert((init->AllocationSizeMin & (init->AllocationSizeMin-1)) == 0);
-        return -1;
-    }
-    if ((init->AllocationSizeMax & (init->AllocationSizeMax-1)) != 0)
-    {
-        OsLayerError("ERROR: %S(%u): Buddy allocator requires Pow2 AllocationSizeMax.\n", __FUNCTION__, OsThreadId());
-        assert((init->AllocationSizeMax & (init->AllocationSizeMax-1)) == 0);
-        return -1;
-    }
-    if (init->AllocationSizeMin < 16)
-    {
-        OsLayerError("ERROR: %S(%u): Buddy allocator requires AllocationSizeMin >= 16 bytes.\n", __FUNCTION__, OsThreadId());
-        assert(init->AllocationSizeMin >= 16);
-        return -1;
-    }
-    if (init->AllocationSizeMax <= init->AllocationSizeMin)
-    {
-        OsLayerError("ERROR: %S(%u): Maximum allocation size %Iu must be larger than minimum size %Iu.\n", __FUNCTION__, OsThreadId(), init->AllocationSizeMax, init->AllocationSizeMin);
-        assert(init->AllocationSizeMax > init->AllocationSizeMin);
-        return -1;
-    }
-    if (init->BytesReserved >= init->AllocationSizeMax)
-    {
-        OsLayerError("ERROR: %S(%u): Bytes reserved %Iu exceeds maximum allocation size %Iu.\n", __FUNCTION__, OsThreadId(), init->BytesReserved, init->AllocationSizeMax);
-        assert(init->BytesReserved < init->AllocationSizeMax);
-        return -1;
-    }
-
-    // figure out the number of levels and ensure the count doesn't exceed the limit (16).
-    unsigned long max_bit = 0;
-    unsigned long min_bit = 0;
-#ifdef _M_X64
-    _BitScanReverse64(&min_bit, init->AllocationSizeMin);
-    _BitScanReverse64(&max_bit, init->AllocationSizeMax);
-#else
-    _BitScanReverse  (&min_bit, init->AllocationSizeMin);
-    _BitScanReverse  (&max_bit, init->AllocationSizeMax);
-#endif
-    if ((max_bit - min_bit) > OS_BUDDY_ALLOCATOR::MAX_LEVELS)
-    {   // need to adjust AllocationSizeMax/AllocationSizeMin.
-        OsLayerError("ERROR: %S(%u): Level count %u exceeds maximum %Iu.\n", __FUNCTION__, OsThreadId(), (max_bit-min_bit), OS_BUDDY_ALLOCATOR::MAX_LEVELS);
-        assert((max_bit-min_bit) <= OS_BUDDY_ALLOCATOR::MAX_LEVELS);
-        return -1;
-    }
-
-    // determine the required size of the allocator metadata, and allocate it as one contiguous chunk.
-    size_t level_bit   = max_bit;
-    size_t level_count = max_bit - min_bit;
-    size_t free_list_n =(1 <<  level_count) * 4;     // 4 = sizeof(uint32_t)
-    size_t  ms_index_n =(1 << (level_count-1)) / 8;  // 8 = number of bits per-byte
-    size_t  metadata_n = free_list_n + (2 * ms_index_n);
-    void     *metadata = VirtualAlloc(NULL, metadata_n, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-    if (metadata == NULL)
-    {
-        OsLayerError("ERROR: %S(%u): Failed to allocate %Iu bytes for buddy allocator metadata.\n", __FUNCTION__, OsThreadId(), metadata_n);
-        return -1;
-    }
-
-    // initialize the simple allocator properties.
-    alloc->AllocationSizeMin = init->AllocationSizeMin;
-    alloc->AllocationSizeMax = init->AllocationSizeMax;
-    alloc->BytesReserved     = init->BytesReserved;
-    alloc->MetadataBase      =(uint8_t *) metadata;
-    alloc->MergeIndex        =(uint32_t*)((uint8_t*) metadata + (ms_index_n * 0));
-    alloc->SplitIndex        =(uint32_t*)((uint8_t*) metadata + (ms_index_n * 1));
-    alloc->FreeListData      =(uint32_t*)((uint8_t*) metadata + (ms_index_n * 2));
-    alloc->LevelCount        =(uint32_t) level_count;
-    alloc->Reserved          = 0;
-
-    // initialize the per-level allocator state data.
-    for (size_t level_index  = 0; level_index < level_count; ++level_index)
-    {
-        alloc->FreeCount[level_index] = 0;
-        alloc->LevelBits[level_index] =(uint32_t) level_bit--;
-        alloc->FreeLists[level_index] = alloc->FreeListData + ((1 << level_index) - 1);
-    }
-    
-    // push offset 0 onto the free list for level 0 (the largest level.)
-    OsBuddyAllocatorPushFreeOffset(alloc, 0, 0);
-
-    // sometimes the requirement of AllocationSizeMax being a power-of-two leads 
-    // to signficant memory waste, so allow the caller to specify a BytesReserved
-    // value to mark a portion of the memory as unusable.
-    if (init->BytesReserved > 0)
-    {   // allocate small blocks until BytesReserved is met.
-        // allocating the smallest block size ensures the least amount of waste.
-        // contiguous blocks will be allocated, starting from offset 0.
-        OS_MEMORY_RANGE   r;
-        uint32_t level_size  = 1 << (level_count - 1);
-        uint32_t block_count =(uint32_t)((init->BytesReserved + level_size) / level_size);
-        for (uint32_t block_index = 0; block_index < block_count;++block_index)
-        {
-            (void) OsBuddyAllocate(alloc, level_size, level_size, r);
-        }
-    }
-    return 0;
+    arena->Generation.fetch_add(1, std::memory_order_relaxed);
+    arena->NextOffset.store(0, std::memory_order_relaxed);
 }
 
-/// @summary Free all resources associated with an OS_BUDDY_ALLOCATOR instance.
-/// @param alloc The OS_BUDDY_ALLOCATOR to delete.
-public_function void
-OsDeleteBuddyAllocator
+/// @summary Determine the size class used to satisfy an allocation request.
+/// @param alloc The OS_SLAB_ALLOCATOR to query.
+/// @param size The requested object size, in bytes.
+/// @return The zero-based index of the smallest size class able to hold an object of the requested size, or -1 if the request is too large.
+internal_function inline int32_t
+OsSlabAllocatorSizeClassForSize
 (
-    OS_BUDDY_ALLOCATOR *alloc
+    OS_SLAB_ALLOCATOR *alloc, 
+    size_t              size
 )
 {
-    if (alloc->MetadataBase != NULL)
+    for (uint32_t i = 0, n = alloc->SizeClassCount; i < n; ++i)
     {
-        VirtualFree(alloc->MetadataBase, 0, MEM_RELEASE);
+        if (alloc->SizeClasses[i].ObjectSize >= size)
+            return (int32_t) i;
     }
-    OsZeroMemory(alloc, sizeof(OS_BUDDY_ALLOCATOR));
+    return -1;
 }
 
-/// @summary Retrieve information about a memory block where the corresponding level is not known.
-/// @param info The OS_BUDDY_BLOCK_INFO to populate.
-/// @param alloc The OS_BUDDY_ALLOCATOR from which the block was allocated.
-/// @param block_offset The offset of the allocation from the start of the memory range, as returned by a prior call to OsBuddyAllocate.
-/// @return true if the offset block_offset was valid and info was populated with data.
-public_function bool
-OsBuddyAllocatorBlockInfo
+/// @summary Acquire a new slab for a size class, committing additional memory as necessary.
+/// @param alloc The OS_SLAB_ALLOCATOR managing the memory.
+/// @param class_index The zero-based index of the size class that will own the slab.
+/// @return The base address of the slab, or NULL if no more slabs are available.
+internal_function uint8_t*
+OsSlabAllocatorAcquireSlab
 (
-    OS_BUDDY_BLOCK_INFO *info, 
-    OS_BUDDY_ALLOCATOR *alloc, 
-    size_t       block_offset
+    OS_SLAB_ALLOCATOR *alloc, 
+    uint32_t     class_index
 )
-{   assert(block_offset < alloc->AllocationSizeMax);
-    OS_BUDDY_BLOCK_INFO       block;
-    OS_BUDDY_BLOCK_SPLIT_INFO split;
-    uint32_t  offset_u32 =(uint32_t)block_offset;
-    uint32_t level_index = alloc->LevelCount - 1;
-    while   (level_index > 0)
-    {   // check the parent level to see if it has been split.
-        OsBuddyAllocatorBlockInfo(&block, alloc, offset_u32, level_index - 1);
-        OsBuddyAllocatorSplitIndexInfo(&split, block);
-        if ((alloc->SplitIndex[split.WordIndex] & split.Mask) != 0)
-        {   // reached a split parent; the block level is level_index.
-            OsBuddyAllocatorBlockInfo(info, alloc, offset_u32, level_index);
-            return true;
+{
+    uint8_t *slab = NULL;
+    OsLockMutex(&alloc->SlabLock);
+    {
+        if (alloc->SlabCount < alloc->SlabCapacity)
+        {
+            size_t slab_index  = alloc->SlabCount;
+            size_t commit_size =(slab_index + 1) << alloc->SlabShift;
+            if (OsHostMemoryIncreaseCommitment(alloc->HostMemory, commit_size) == 0)
+            {
+                alloc->SlabClass[slab_index] = (uint8_t) class_index;
+                alloc->SlabCount = slab_index + 1;
+                slab = alloc->HostMemory->BaseAddress + (slab_index << alloc->SlabShift);
+            }
+        }
+        else
+        {
+            OsLayerError("ERROR: %S(%u): Slab allocator exhausted all %Iu slabs.\n", __FUNCTION__, OsThreadId(), alloc->SlabCapacity);
         }
-        // the parent has not been split, so check the next-largest level.
-        level_index--;
     }
-    // this must be a level-0 allocation.
-    OsBuddyAllocatorBlockInfo(&block, alloc, offset_u32, 0);
-    return true;
+    OsUnlockMutex(&alloc->SlabLock);
+    return slab;
 }
 
-/// @summary Allocate memory from a buddy allocator.
-/// @param alloc The OS_BUDDY_ALLOCATOR managing the memory.
-/// @param size The number of bytes being requested.
-/// @param alignment The required alignment of the returned block offset.
-/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region.
-/// @return true if the allocator satisfied the request.
-public_function bool
-OsBuddyAllocate
+/// @summary Retrieve up to a given number of free objects from a size class. The caller must hold the size class lock.
+/// Objects are taken from the size class free list, then from the remote free list, and finally carved from a slab.
+/// @param alloc The OS_SLAB_ALLOCATOR managing the memory.
+/// @param class_index The zero-based index of the size class.
+/// @param objects On return, the addresses of the free objects are written here.
+/// @param max_objects The maximum number of objects to return.
+/// @return The number of objects written to the objects array.
+internal_function size_t
+OsSlabSizeClassRefill
 (
-    OS_BUDDY_ALLOCATOR *alloc, 
-    size_t               size, 
-    size_t          alignment, 
-    OS_MEMORY_RANGE    &range
+    OS_SLAB_ALLOCATOR *alloc, 
+    uint32_t     class_index, 
+    void            **objects, 
+    size_t        max_objects
 )
 {
-    if (size < alignment)
-    {   // round upwards to the requested alignment.
-        size = alignment;
-    }
-    if (size < alloc->AllocationSizeMin)
-    {   // round up to the minimum possible block size.
-        size = alloc->AllocationSizeMin;
+    OS_SLAB_SIZE_CLASS *sc = &alloc->SizeClasses[class_index];
+    size_t           count = 0;
+    if (sc->FreeList == NULL)
+    {   // claim everything freed remotely since the last refill. taking the entire list is ABA-safe.
+        sc->FreeList = sc->RemoteFree.exchange(NULL, std::memory_order_acquire);
     }
-    if (size > alloc->AllocationSizeMax)
+    while (count < max_objects && sc->FreeList != NULL)
     {
-        OsLayerError("ERROR: %S(%u): Allocation request for %Iu bytes exceeds maximum of %Iu bytes.\n", __FUNCTION__, OsThreadId(), size, alloc->AllocationSizeMax);
-        assert(size <= alloc->AllocationSizeMax);
-        goto no_free_block;
+        void  *object    = sc->FreeList;
+        sc->FreeList     = *(void**) object;
+        objects[count++] = object;
     }
-
-    uint32_t pow2_size = (uint32_t) OsNextPowerOfTwoGreaterOrEqual(size);
-    uint32_t bit_index;  _BitScanReverse((DWORD*) &bit_index, pow2_size);
-    uint32_t level_idx = alloc->LevelBits[0] - bit_index;
-    uint32_t check_idx = level_idx;
-    for ( ; ; )
-    {   // if the free list is not empty, the allocation can be satisfied.
-        if (alloc->FreeCount[check_idx] > 0)
-        {   // perform splits from check_idx (<= level_idx) to level_idx.
-            // this process splits larger blocks into smaller blocks.
-            while (check_idx < level_idx)
-            {   // pop an offset from the free list at the parent block level.
-                OS_BUDDY_BLOCK_INFO      parent_info;
-                OS_BUDDY_BLOCK_SPLIT_INFO split_info;
-                uint32_t  parent_offset = OsBuddyAllocatorPopFreeOffset(alloc, check_idx);
-                OsBuddyAllocatorBlockInfo(&parent_info, alloc, parent_offset, check_idx);
-                OsBuddyAllocatorSplitIndexInfo(&split_info, parent_info);
-
-                // mark the larger parent block as having been split.
-                alloc->SplitIndex[split_info.WordIndex] |= split_info.Mask;
-
-                // insert two blocks into the free list of the next-smaller level.
-                OsBuddyAllocatorPushFreeOffset(alloc, parent_offset                               , check_idx+1);
-                OsBuddyAllocatorPushFreeOffset(alloc, parent_offset + (parent_info.BlockSize >> 1), check_idx+1);
-                check_idx++;
-            }
-
-            // return a block from level_idx, which is now known to have at least one free block.
-            OS_BUDDY_BLOCK_INFO       block_info;
-            OS_BUDDY_BLOCK_MERGE_INFO merge_info;
-            uint32_t  return_offset = OsBuddyAllocatorPopFreeOffset(alloc, level_idx);
-            OsBuddyAllocatorBlockInfo(&block_info, alloc, return_offset, level_idx);
-            OsBuddyAllocatorMergeIndexInfo(&merge_info, block_info);
-
-            // toggle the buddy pair bit representing the pair allocation state.
-            // if both blocks are allocated, the corresponding bit will be set to 0.
-            // if only return_offset is allocated, the corresponding bit will be set to 1.
-            alloc->MergeIndex[merge_info.WordIndex] ^= merge_info.Mask;
-            range.ByteOffset  = return_offset;
-            range.SizeInBytes = pow2_size;
-            return true;
-        }
-        if (check_idx != 0)
-        {   // check the next larger level to see if there are any free blocks.
-            check_idx--;
+    while (count < max_objects)
+    {
+        if (sc->CarveNext == sc->CarveEnd)
+        {   // the current slab is exhausted.
+            uint8_t *slab = OsSlabAllocatorAcquireSlab(alloc, class_index);
+            if (slab == NULL) break;
+            sc->CarveNext = slab;
+            sc->CarveEnd  = slab + ((alloc->SlabSize / sc->ObjectSize) * sc->ObjectSize);
+            sc->SlabCount++;
         }
-        else break;
+        objects[count++] = sc->CarveNext;
+        sc->CarveNext   += sc->ObjectSize;
     }
-
-no_free_block:
-    // there is no free block that can satisfy the allocation.
-    range.ByteOffset  = 0;
-    range.SizeInBytes = 0;
-    return false;
+    sc->RefillCount++;
+    return count;
 }
 
-/// @summary Grow or shrink a memory block to meet a desired size.
-/// @param alloc The OS_BUDDY_ALLOCATOR managing the allocated range.
-/// @param existing An OS_MEMORY_RANGE describing the existing allocation.
-/// @param new_size The new required minimum allocation size, in bytes.
-/// @param alignment The required alignment of the returned block offset.
-/// @param range On return, the ByteOffset and SizeInBytes fields are set to the offset and size of the allocated region, which may or may not be the same as the existing region.
-/// @return true if the allocator satisfied the request.
-public_function bool
-OsBuddyReallocate
+/// @summary Initialize a slab allocator instance.
+/// @param alloc The OS_SLAB_ALLOCATOR to initialize.
+/// @param init Data specifying the allocator configuration.
+/// @return Zero if the allocator is initialized successfully, or -1 if an error occurred.
+public_function int
+OsCreateSlabAllocator
 (
-    OS_BUDDY_ALLOCATOR *alloc, 
-    OS_MEMORY_RANGE  existing, 
-    size_t           new_size, 
-    size_t          alignment,
-    OS_MEMORY_RANGE    &range
+    OS_SLAB_ALLOCATOR     *alloc, 
+    OS_SLAB_ALLOCATOR_INIT *init
 )
 {
-    if (existing.SizeInBytes == 0)
-    {   // there is no existing allocation, so this is equivalent to calling OsBuddyAllocate.
-        return OsBuddyAllocate(alloc, new_size, alignment, range);
+    size_t const DEFAULT_SIZE_CLASSES[] = { 16, 32, 64, 128, 256, 512, 1024, 2048 };
+    size_t const *size_classes = init->SizeClasses;
+    uint32_t       class_count = init->SizeClassCount;
+    size_t           slab_size = init->SlabSize;
+    size_t           page_size = 0;
+    size_t         granularity = 0;
+
+    if (size_classes == NULL || class_count == 0)
+    {   // use the default set of power-of-two size classes.
+        size_classes = DEFAULT_SIZE_CLASSES;
+        class_count  = sizeof(DEFAULT_SIZE_CLASSES) / sizeof(DEFAULT_SIZE_CLASSES[0]);
     }
-    if (new_size < alignment)
-    {   // round upwards to the requested alignment.
-        new_size = alignment;
+    if (slab_size == 0)
+    {   // use the default slab size.
+        slab_size = OS_SLAB_ALLOCATOR::DEFAULT_SLAB_SIZE;
     }
-    if (new_size < alloc->AllocationSizeMin)
-    {   // round up to the minimum possible block size.
-        new_size = alloc->AllocationSizeMin;
+    OsVmmQueryPageSize(page_size, granularity);
+    if ((slab_size & (slab_size - 1)) != 0 || (slab_size & (page_size - 1)) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): Slab size %Iu must be a power of two and a multiple of the page size %Iu.\n", __FUNCTION__, OsThreadId(), slab_size, page_size);
+        return -1;
     }
-    if (new_size > alloc->AllocationSizeMax)
+    if (class_count > OS_SLAB_ALLOCATOR::MAX_SIZE_CLASSES)
     {
-        OsLayerError("ERROR: %S(%u): Reallocation request for %Iu bytes exceeds maximum of %Iu bytes.\n", __FUNCTION__, OsThreadId(), new_size, alloc->AllocationSizeMax);
-        assert(new_size <= alloc->AllocationSizeMax);
-        goto no_free_block;
+        OsLayerError("ERROR: %S(%u): Size class count %u exceeds maximum %Iu.\n", __FUNCTION__, OsThreadId(), class_count, OS_SLAB_ALLOCATOR::MAX_SIZE_CLASSES);
+        return -1;
     }
-
-    // there are four scenarios this routine has to account for:
-    // 1. The new_size still fits in the same block. No re-allocation is performed.
-    // 2. The new_size is larger than the old size, but fits in a block one level larger, and the buddy block is free. The buddy block is allocated, and the buddy pair is merged. No copying is required.
-    // 3. The new_size is smaller than the old size by one or more levels. The existing block is demoted to a smaller block. No copying is required.
-    // 4. The new_size is larger than the old size by more than one level, or the buddy was not free. A new, larger block is allocated and the existing block is freed. The caller must copy the data from the old to the new block.
-    uint32_t pow2_size_old = (uint32_t) OsNextPowerOfTwoGreaterOrEqual(existing.SizeInBytes);
-    uint32_t pow2_size_new = (uint32_t) OsNextPowerOfTwoGreaterOrEqual(new_size);
-    uint32_t bit_index_old;  _BitScanReverse((DWORD*) &bit_index_old, pow2_size_old);
-    uint32_t bit_index_new;  _BitScanReverse((DWORD*) &bit_index_new, pow2_size_new);
-    uint32_t level_idx_old = alloc->LevelBits[0] - bit_index_old;
-    uint32_t level_idx_new = alloc->LevelBits[0] - bit_index_new;
-    
-    if (level_idx_new == level_idx_old)
-    {   // case 1: the new_size fits in the same block. don't do anything.
-        range.ByteOffset  = existing.ByteOffset;
-        range.SizeInBytes = pow2_size_new;
-        return true;
+    if (init->HostMemory == NULL || init->HostMemory->BytesReserved < slab_size)
+    {
+        OsLayerError("ERROR: %S(%u): Host memory allocation must reserve at least one slab of %Iu bytes.\n", __FUNCTION__, OsThreadId(), slab_size);
+        return -1;
     }
-    if (level_idx_new ==(level_idx_old-1))
-    {   // case 2: see if the buddy is free, and if so, promote the existing block.
-        OS_BUDDY_BLOCK_INFO        block_info;
-        OS_BUDDY_BLOCK_MERGE_INFO  merge_info;
-        OS_BUDDY_BLOCK_SPLIT_INFO  split_info;
-        OsBuddyAllocatorBlockInfo(&block_info, alloc, (uint32_t) existing.ByteOffset, level_idx_old);
-        OsBuddyAllocatorMergeIndexInfo(&merge_info, block_info);
-        if((alloc->MergeIndex[merge_info.WordIndex] & merge_info.Mask) != 0)
-        {   // the buddy block is free - merge it with the existing block.
-            // toggle the status bit to 0 - both blocks are allocated.
-            alloc->MergeIndex[merge_info.WordIndex] ^= merge_info.Mask;
-
-            // scan the free list to locate the buddy block offset, and remove it.
-            uint32_t merge_offset = (block_info.LeftAbsoluteIndex  - block_info.IndexOffset) * block_info.BlockSize;
-            uint32_t buddy_offset = (block_info.BuddyAbsoluteIndex - block_info.IndexOffset) * block_info.BlockSize;
-            uint32_t *free_offset =  alloc->FreeLists[level_idx_old];
-            for (size_t i = 0,  n =  alloc->FreeCount[level_idx_old]; i < n; ++i)
-            {
-                if (free_offset[i] == buddy_offset)
-                {   // found the matching offset. swap the last item into its place.
-                    free_offset[i] = free_offset[n-1];
-                    alloc->FreeCount[level_idx_old]--;
-                    break;
-                }
-            }
-
-            // retrieve the attributes of the parent block.
-            OsBuddyAllocatorBlockInfo(&block_info, alloc, merge_offset, level_idx_new);
-            OsBuddyAllocatorMergeIndexInfo(&merge_info, block_info);
-            OsBuddyAllocatorSplitIndexInfo(&split_info, block_info);
-
-            // mark the parent block as being allocated, and and clear its split status.
-            alloc->MergeIndex[merge_info.WordIndex] ^= merge_info.Mask;
-            alloc->SplitIndex[split_info.WordIndex] &=~split_info.Mask;
-
-            // return the merged block.
-            range.ByteOffset  = merge_offset;
-            range.SizeInBytes = block_info.BlockSize;
-            return true;
+    for (uint32_t i = 0; i < class_count; ++i)
+    {
+        size_t object_size = OsAlignUp(size_classes[i], OS_SLAB_ALLOCATOR::OBJECT_ALIGNMENT);
+        if (object_size == 0 || object_size > slab_size || (i > 0 && object_size <= OsAlignUp(size_classes[i-1], OS_SLAB_ALLOCATOR::OBJECT_ALIGNMENT)))
+        {
+            OsLayerError("ERROR: %S(%u): Invalid size class %u (%Iu bytes). Sizes must be ascending and not exceed the slab size.\n", __FUNCTION__, OsThreadId(), i, size_classes[i]);
+            return -1;
         }
     }
-    if (level_idx_new > level_idx_old)
-    {   // case 3: demote the existing block to a smaller size.
-        OS_BUDDY_BLOCK_INFO        block_info;
-        OS_BUDDY_BLOCK_MERGE_INFO  merge_info;
-        OS_BUDDY_BLOCK_SPLIT_INFO  split_info;
-        uint32_t                 existing_u32 = (uint32_t) existing.ByteOffset;
-        OsBuddyAllocatorBlockInfo(&block_info, alloc, existing_u32, level_idx_old);
-        OsBuddyAllocatorMergeIndexInfo(&merge_info, block_info);
-
-        // mark the current block as being free.
-        alloc->MergeIndex[merge_info.WordIndex] ^= merge_info.Mask;
-
-        // perform splits down to the necessary block size.
-        while (level_idx_old < level_idx_new)
-        {   // update the split index to mark the parent block as having been split.
-            OsBuddyAllocatorSplitIndexInfo(&split_info, block_info);
-            alloc->SplitIndex[split_info.WordIndex] |= split_info.Mask;
-            OsBuddyAllocatorBlockInfo(&block_info, alloc, existing_u32, block_info.LevelIndex + 1);
-            OsBuddyAllocatorPushFreeOffset(alloc, existing_u32 + block_info.BlockSize, block_info.LevelIndex);
-            level_idx_old++;
-        }
 
-        // mark the new smaller block as allocated in the merge index.
-        OsBuddyAllocatorMergeIndexInfo(&merge_info, block_info);
-        alloc->MergeIndex[merge_info.WordIndex] ^= merge_info.Mask;
-        range.ByteOffset  = existing.ByteOffset;
-        range.SizeInBytes = block_info.BlockSize;
-        return true;
+    // allocate storage for the slab-to-size class mapping.
+    size_t     slab_capacity = init->HostMemory->BytesReserved / slab_size;
+    size_t       class_bytes = OsAlignUp(slab_capacity, page_size);
+    uint8_t      *slab_class = NULL;
+    if ((slab_class = (uint8_t*) OsVmmAllocateMetadata(class_bytes)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to allocate %Iu bytes for slab allocator metadata.\n", __FUNCTION__, OsThreadId(), class_bytes);
+        return -1;
     }
 
-    // case 4: no choice but to allocate a new block and free the old block.
-    if (OsBuddyAllocate(alloc, new_size, alignment, range))
-    {   // the new block was successfully allocated, so mark the old block as free.
-        OsBuddyFree(alloc, existing);
-        return true;
+    OsCreateMutex(&alloc->SlabLock, 0x1000);
+    alloc->HostMemory     = init->HostMemory;
+    alloc->SlabSize       = slab_size;
+    alloc->SlabShift      =(uint32_t) OsBitScanReverse64(slab_size);
+    alloc->SizeClassCount = class_count;
+    alloc->SlabCount      = 0;
+    alloc->SlabCapacity   = slab_capacity;
+    alloc->SlabClass      = slab_class;
+    alloc->SlabClassSize  = class_bytes;
+    for (uint32_t i = 0; i < class_count; ++i)
+    {
+        OS_SLAB_SIZE_CLASS *sc = &alloc->SizeClasses[i];
+        OsCreateMutex(&sc->Lock, 0x1000);
+        sc->ObjectSize  = OsAlignUp(size_classes[i], OS_SLAB_ALLOCATOR::OBJECT_ALIGNMENT);
+        sc->FreeList    = NULL;
+        sc->CarveNext   = NULL;
+        sc->CarveEnd    = NULL;
+        sc->RemoteFree.store(NULL, std::memory_order_relaxed);
+        sc->RemoteFreeCount.store(0, std::memory_order_relaxed);
+        sc->SlabCount   = 0;
+        sc->RefillCount = 0;
     }
-    // else, fall through to no_free block.
-no_free_block:
-    range.ByteOffset  = 0;
-    range.SizeInBytes = 0;
-    return false;
+    return 0;
 }
 
-/// @summary Retrieve the size for a given byte offset returned by the allocator.
-/// @param alloc The OS_BUDDY_ALLOCATOR from which the memory was allocated.
-/// @param block_offset A memory block offset returned by a prior call to OsBuddyAllocate or OsBuddyReallocate.
-/// @return The size of the specified block, in bytes, or 0 if the specified block offset is invalid.
-public_function size_t
-OsBuddyBlockSize
+/// @summary Free all resources associated with an OS_SLAB_ALLOCATOR instance. The host memory allocation is not released. No other thread may be accessing the allocator.
+/// @param alloc The OS_SLAB_ALLOCATOR to delete.
+public_function void
+OsDeleteSlabAllocator
 (
-    OS_BUDDY_ALLOCATOR *alloc, 
-    size_t       block_offset
+    OS_SLAB_ALLOCATOR *alloc
 )
 {
-    OS_BUDDY_BLOCK_INFO info;
-    if (OsBuddyAllocatorBlockInfo(&info, alloc, block_offset))
-        return info.BlockSize;
-    else
-        return 0;
+    for (uint32_t i = 0; i < alloc->SizeClassCount; ++i)
+    {
+        OsDeleteMutex(&alloc->SizeClasses[i].Lock);
+    }
+    if (alloc->SlabClass != NULL)
+    {
+        OsVmmReleaseMetadata(alloc->SlabClass, alloc->SlabClassSize);
+    }
+    OsDeleteMutex(&alloc->SlabLock);
+    alloc->HostMemory     = NULL;
+    alloc->SlabClass      = NULL;
+    alloc->SlabClassSize  = 0;
+    alloc->SlabCount      = 0;
+    alloc->SlabCapacity   = 0;
+    alloc->SizeClassCount = 0;
 }
 
-/// @summary Free a previously allocated memory range.
-/// @param alloc The OS_BUDDY_ALLOCATOR that returned the memory range.
-/// @param range The block offset and size returned by a prior call to OsBuddyAllocate or OsBuddyReallocate.
-public_function void
-OsBuddyFree
+/// @summary Allocate an object from a slab allocator. This function is safe to call from multiple threads concurrently.
+/// @param alloc The OS_SLAB_ALLOCATOR managing the memory.
+/// @param cache The OS_SLAB_THREAD_CACHE owned by the calling thread, or NULL.
+/// @param size The size of the object, in bytes.
+/// @return A pointer to the object, aligned to OS_SLAB_ALLOCATOR::OBJECT_ALIGNMENT, or NULL.
+public_function void*
+OsSlabAllocate
 (
-    OS_BUDDY_ALLOCATOR *alloc, 
-    OS_MEMORY_RANGE     range
+    OS_SLAB_ALLOCATOR    *alloc, 
+    OS_SLAB_THREAD_CACHE *cache, 
+    size_t                 size
 )
 {
-    if (range.SizeInBytes > 0)
-    {   // ensure that the specified size is at least the minimum allocation size.
-        if (range.SizeInBytes < alloc->AllocationSizeMin)
-            range.SizeInBytes = alloc->AllocationSizeMin;
-
-        OS_BUDDY_BLOCK_INFO       block_info;
-        OS_BUDDY_BLOCK_MERGE_INFO merge_info;
-        OS_BUDDY_BLOCK_SPLIT_INFO split_info;
-
-        // convert the supplied size to a level index.
-        uint32_t offset_u32= (uint32_t) range.ByteOffset;
-        uint32_t pow2_size = (uint32_t) OsNextPowerOfTwoGreaterOrEqual(range.SizeInBytes);
-        uint32_t bit_index;  _BitScanReverse((DWORD*) &bit_index, pow2_size);
-        uint32_t level_idx = alloc->LevelBits[0] - bit_index;
-
-        // mark the block as free in the merge index.
-        OsBuddyAllocatorBlockInfo(&block_info, alloc, offset_u32, level_idx);
-        OsBuddyAllocatorMergeIndexInfo(&merge_info, block_info);
-        alloc->MergeIndex[merge_info.WordIndex] ^= merge_info.Mask;
-        do
-        {   // if the new state is 0, the block and its buddy can be merged.
-            // if the new state is 1, only the block is free, and we're done.
-            if ((block_info.LevelIndex == 0) || ((alloc->MergeIndex[merge_info.WordIndex] & merge_info.Mask) != 0))
-            {   // no additional merging can be performed.
-                break;
-            }
-
-            // a merge operation between a buddy pair can be performed.
-            // remove the buddy block from the free list.
-            // the merged block is the lowest offset of the pair.
-            uint32_t merge_offset = (block_info.LeftAbsoluteIndex  - block_info.IndexOffset) * block_info.BlockSize;
-            uint32_t buddy_offset = (block_info.BuddyAbsoluteIndex - block_info.IndexOffset) * block_info.BlockSize;
-            uint32_t *free_offset =  alloc->FreeLists[block_info.LevelIndex];
-            for (size_t i = 0,  n =  alloc->FreeCount[block_info.LevelIndex]; i < n; ++i)
+    int32_t class_index = OsSlabAllocatorSizeClassForSize(alloc, size);
+    if (class_index < 0)
+    {
+        OsLayerError("ERROR: %S(%u): Object size %Iu exceeds the largest size class.\n", __FUNCTION__, OsThreadId(), size);
+        return NULL;
+    }
+    OS_SLAB_SIZE_CLASS *sc = &alloc->SizeClasses[class_index];
+    void           *object = NULL;
+    if (cache != NULL)
+    {
+        if (cache->Count[class_index] == 0)
+        {   // refill the magazine from the size class.
+            OsLockMutex(&sc->Lock);
             {
-                if (free_offset[i] == buddy_offset)
-                {   // found the matching offset. swap the last item into its place.
-                    free_offset[i] = free_offset[n-1];
-                    alloc->FreeCount[block_info.LevelIndex]--;
-                    break;
-                }
+                cache->Count[class_index] = (uint32_t) OsSlabSizeClassRefill(alloc, class_index, cache->Objects[class_index], OS_SLAB_THREAD_CACHE::BATCH_SIZE);
             }
-
-            // clear the split status for the parent block.
-            OsBuddyAllocatorBlockInfo(&block_info, alloc, merge_offset, block_info.LevelIndex - 1);
-            OsBuddyAllocatorMergeIndexInfo(&merge_info, block_info);
-            OsBuddyAllocatorSplitIndexInfo(&split_info, block_info);
-            alloc->SplitIndex[split_info.WordIndex] &= ~split_info.Mask;
-
-            // continue trying to merge into larger blocks.
-            offset_u32 = merge_offset;
-        } while (block_info.LevelIndex != 0);
-        // return the possibly merged block to the free list for the level it was allocated from.
-        OsBuddyAllocatorPushFreeOffset(alloc, offset_u32, block_info.LevelIndex);
+            OsUnlockMutex(&sc->Lock);
+        }
+        if (cache->Count[class_index] > 0)
+        {
+            object = cache->Objects[class_index][--cache->Count[class_index]];
+        }
     }
-}
-
-/// @summary Reset a buddy allocator back to its initial state, invalidating all existing allocations.
-/// @param alloc The OS_BUDDY_ALLOCATOR to reset.
-public_function void
-OsBuddyReset
-(
-    OS_BUDDY_ALLOCATOR *alloc
-)
-{   // return the merge and split indexes to their initial state.
-    OsZeroMemory(alloc->MergeIndex, (1 << (alloc->LevelCount-1)) / 8);
-    OsZeroMemory(alloc->SplitIndex, (1 << (alloc->LevelCount-1)) / 8);
-
-    // remove all items from the per-level free lists.
-    OsZeroMemory(alloc->FreeCount, OS_BUDDY_ALLOCATOR::MAX_LEVELS * sizeof(uint32_t));
-    
-    // push offset 0 onto the free list for level 0 (the largest level.)
-    OsBuddyAllocatorPushFreeOffset(alloc, 0, 0);
-
-    // sometimes the requirement of AllocationSizeMax being a power-of-two leads 
-    // to signficant memory waste, so allow the caller to specify a BytesReserved
-    // value to mark a portion of the memory as unusable.
-    if (alloc->BytesReserved > 0)
-    {   // allocate small blocks until BytesReserved is met.
-        // allocating the smallest block size ensures the least amount of waste.
-        // contiguous blocks will be allocated, starting from offset 0.
-        OS_MEMORY_RANGE   r;
-        uint32_t level_size  = 1 << (alloc->LevelCount - 1);
-        uint32_t block_count =(uint32_t)((alloc->BytesReserved + level_size) / level_size);
-        for (uint32_t block_index = 0; block_index < block_count; ++block_index)
+    else
+    {
+        OsLockMutex(&sc->Lock);
         {
-            (void) OsBuddyAllocate(alloc, level_size, level_size, r);
+            OsSlabSizeClassRefill(alloc, class_index, &object, 1);
         }
+        OsUnlockMutex(&sc->Lock);
     }
+    return object;
 }
 
-/// @summary Reserve process address space for a memory arena. By default, no address space is committed.
-/// @param arena The OS_HOST_MEMORY_ARENA to initialize.
-/// @param host_memory The address and size of the host-visible memory block to sub-allocate from.
-/// @return Zero if the arena is initialized, or -1 if an error occurred.
-public_function inline int
-OsCreateHostMemoryArena
-(
-    OS_HOST_MEMORY_ARENA *arena, 
-    OS_MEMORY_RANGE host_memory
-)
-{   assert(host_memory.HostAddress != NULL);
-    assert(host_memory.SizeInBytes >  0);
-    arena->HostMemory = host_memory;
-    return OsCreateArenaAllocator(&arena->Allocator, host_memory.SizeInBytes);
-}
-
-/// @summary Release process address space reserved for a memory arena. All allocations are invalidated.
-/// @param arena The memory arena to delete.
-public_function inline void
-OsDeleteHostMemoryArena
+/// @summary Return an object to a slab allocator. This function is safe to call from multiple threads concurrently.
+/// When cache is NULL, the object is pushed onto a lock-free list, so threads that never allocate (such as I/O completion threads) can free without blocking.
+/// @param alloc The OS_SLAB_ALLOCATOR that returned the object.
+/// @param cache The OS_SLAB_THREAD_CACHE owned by the calling thread, or NULL.
+/// @param object The object to free, returned by a prior call to OsSlabAllocate. May be NULL.
+public_function void
+OsSlabFree
 (
-    OS_HOST_MEMORY_ARENA *arena
+    OS_SLAB_ALLOCATOR    *alloc, 
+    OS_SLAB_THREAD_CACHE *cache, 
+    void                *object
 )
 {
-    OsDeleteArenaAllocator(&arena->Allocator);
-    OsZeroMemory(arena, sizeof(OS_HOST_MEMORY_ARENA));
+    if (object == NULL)
+    {   // nothing to free.
+        return;
+    }
+    assert((uint8_t*) object >= alloc->HostMemory->BaseAddress);
+    assert((uint8_t*) object <  alloc->HostMemory->BaseAddress + (alloc->SlabCapacity << alloc->SlabShift));
+
+    size_t         slab_index =((uint8_t*) object - alloc->HostMemory->BaseAddress) >> alloc->SlabShift;
+    uint32_t      class_index = alloc->SlabClass[slab_index];
+    OS_SLAB_SIZE_CLASS    *sc =&alloc->SizeClasses[class_index];
+    if (cache != NULL)
+    {
+        if (cache->Count[class_index] == OS_SLAB_THREAD_CACHE::CAPACITY)
+        {   // return the oldest half of the magazine to the size class free list.
+            uint32_t const batch = (uint32_t) OS_SLAB_THREAD_CACHE::BATCH_SIZE;
+            void         **objs  = cache->Objects[class_index];
+            for (uint32_t i = 0; i < batch - 1; ++i)
+            {   // link the objects together outside of the lock.
+                *(void**) objs[i] = objs[i + 1];
+            }
+            OsLockMutex(&sc->Lock);
+            {
+                *(void**) objs[batch - 1] = sc->FreeList;
+                sc->FreeList = objs[0];
+            }
+            OsUnlockMutex(&sc->Lock);
+            OsMoveMemory(objs, objs + batch, (OS_SLAB_THREAD_CACHE::CAPACITY - batch) * sizeof(void*));
+            cache->Count[class_index] -= batch;
+        }
+        cache->Objects[class_index][cache->Count[class_index]++] = object;
+    }
+    else
+    {   // push onto the lock-free remote free list.
+        void *head = sc->RemoteFree.load(std::memory_order_relaxed);
+        do
+        {
+            *(void**) object = head;
+        } while (!sc->RemoteFree.compare_exchange_weak(head, object, std::memory_order_release, std::memory_order_relaxed));
+        sc->RemoteFreeCount.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
-/// @summary Determine whether a memory allocation request can be satisfied.
-/// @param arena The memory arena to query.
-/// @param size The size of the allocation request, in bytes.
-/// @param alignment The desired alignment of the returned address. This must be a power of two greater than zero.
-/// @return true if the specified allocation will succeed.
-public_function inline bool
-OsHostMemoryArenaCanSatisfyAllocation
+/// @summary Return all objects held in a thread cache to the allocator. Call this before the thread owning the cache exits.
+/// @param alloc The OS_SLAB_ALLOCATOR associated with the cache.
+/// @param cache The OS_SLAB_THREAD_CACHE to flush.
+public_function void
+OsSlabFlushCache
 (
-    OS_HOST_MEMORY_ARENA *arena, 
-    size_t                 size,
-    size_t            alignment
+    OS_SLAB_ALLOCATOR    *alloc, 
+    OS_SLAB_THREAD_CACHE *cache
 )
 {
-    return OsArenaAllocatorCanSatisfyAllocation(&arena->Allocator, size, alignment);
+    for (uint32_t class_index = 0; class_index < alloc->SizeClassCount; ++class_index)
+    {
+        uint32_t   count = cache->Count[class_index];
+        void      **objs = cache->Objects[class_index];
+        if (count == 0)
+            continue;
+        for (uint32_t i = 0; i < count - 1; ++i)
+        {   // link the objects together outside of the lock.
+            *(void**) objs[i] = objs[i + 1];
+        }
+        OsLockMutex(&alloc->SizeClasses[class_index].Lock);
+        {
+            *(void**) objs[count - 1] = alloc->SizeClasses[class_index].FreeList;
+            alloc->SizeClasses[class_index].FreeList = objs[0];
+        }
+        OsUnlockMutex(&alloc->SizeClasses[class_index].Lock);
+        cache->Count[class_index] = 0;
+    }
 }
 
-/// @summary Determine whether a memory allocation request can be satisfied.
-/// @typeparam T The type being allocated. This type is used to determine the required alignment.
-/// @param arena The memory arena to query.
-/// @return true if the specified allocation will succeed.
+/// @summary Allocate a single object of a given type from a slab allocator.
+/// @param alloc The OS_SLAB_ALLOCATOR managing the memory.
+/// @param cache The OS_SLAB_THREAD_CACHE owned by the calling thread, or NULL.
+/// @return A pointer to the uninitialized object, or NULL.
 template <typename T>
-public_function inline bool
-OsHostMemoryArenaCanAllocate
+public_function inline T*
+OsSlabAllocate
 (
-    OS_HOST_MEMORY_ARENA *arena
+    OS_SLAB_ALLOCATOR    *alloc, 
+    OS_SLAB_THREAD_CACHE *cache
 )
 {
-    return OsArenaAllocatorCanSatisfyAllocation(&arena->Allocator, sizeof(T), std::alignment_of<T>::value);
+    static_assert(std::alignment_of<T>::value <= OS_SLAB_ALLOCATOR::OBJECT_ALIGNMENT, "Type alignment exceeds OS_SLAB_ALLOCATOR::OBJECT_ALIGNMENT");
+    return (T*) OsSlabAllocate(alloc, cache, sizeof(T));
 }
 
-/// @summary Determine whether a memory allocation request for an array can be satisfied.
-/// @typeparam T The type of array element. This type is used to determine the required alignment.
-/// @param arena The memory arena to query.
-/// @param count The number of items in the array.
-/// @return true if the specified allocation will succeed.
-template <typename T>
-public_function inline bool
-OsHostMemoryArenaCanAllocateArray
+/// @summary Initialize a double-mapped ring buffer.
+/// @param ring The OS_MAGIC_RING_BUFFER to initialize.
+/// @param capacity The minimum size of the buffer, in bytes. This value is rounded up to a power of two that is a multiple of the allocation granularity.
+/// @return Zero if the ring buffer is successfully initialized, or -1 if an error occurred.
+public_function int
+OsCreateMagicRingBuffer
 (
-    OS_HOST_MEMORY_ARENA *arena,
-    size_t                count
+    OS_MAGIC_RING_BUFFER *ring, 
+    size_t            capacity
 )
 {
-    return OsArenaAllocatorCanSatisfyAllocation(&arena->Allocator, sizeof(T) * count, std::alignment_of<T>::value);
+    size_t   page_size = 0;
+    size_t granularity = 0;
+    void         *base = NULL;
+    OsVmmQueryPageSize(page_size, granularity);
+    if (capacity < granularity)
+    {   // each view must start on an allocation granularity boundary.
+        capacity = granularity;
+    }
+    capacity = OsNextPowerOfTwoGreaterOrEqual(capacity);
+    if (!OsMemoryBudgetCharge((int64_t) capacity))
+    {   // OsMemoryBudgetCharge output error information already.
+        ring->BaseAddress = NULL;
+        ring->Capacity    = 0;
+        ring->Mask        = 0;
+        return -1;
+    }
+    if ((base = OsVmmReserveMirrored(capacity)) == NULL)
+    {   // OsVmmReserveMirrored output error information already.
+        OsMemoryBudgetCharge(-(int64_t) capacity);
+        ring->BaseAddress = NULL;
+        ring->Capacity    = 0;
+        ring->Mask        = 0;
+        return -1;
+    }
+    ring->WriteCursor.store(0, std::memory_order_relaxed);
+    ring->ReserveCursor.store(0, std::memory_order_relaxed);
+    ring->ReadCursor.store(0, std::memory_order_relaxed);
+    ring->BaseAddress = (uint8_t*) base;
+    ring->Capacity    = capacity;
+    ring->Mask        = capacity - 1;
+    return 0;
 }
 
-/// @summary Allocate memory from an arena. Additional address space is committed up to the initial reservation size.
-/// @param arena The memory arena to allocate from.
-/// @param size The minimum number of bytes to allocate.
-/// @param alignment A power-of-two, greater than or equal to 1, specifying the alignment of the returned address.
-/// @return A pointer to the start of the allocated block, or NULL if the request could not be satisfied.
-public_function inline void*
-OsHostMemoryArenaAllocate
+/// @summary Unmap the storage associated with a double-mapped ring buffer.
+/// @param ring The OS_MAGIC_RING_BUFFER to delete.
+public_function void
+OsDeleteMagicRingBuffer
 (
-    OS_HOST_MEMORY_ARENA *arena, 
-    size_t                 size, 
-    size_t            alignment
+    OS_MAGIC_RING_BUFFER *ring
 )
 {
-    OS_MEMORY_RANGE r;
-    if (OsArenaAllocate(&arena->Allocator, size, alignment, r))
-    {   // the allocation was successful. convert offset to address.
-        return (uint8_t*) arena->HostMemory.HostAddress + r.ByteOffset;
+    if (ring->BaseAddress != NULL)
+    {
+        OsVmmReleaseMirrored(ring->BaseAddress, (size_t) ring->Capacity);
+        OsMemoryBudgetCharge(-(int64_t) ring->Capacity);
     }
-    return NULL;
+    ring->BaseAddress = NULL;
+    ring->Capacity    = 0;
+    ring->Mask        = 0;
 }
 
-/// @summary Allocate memory for a structure.
-/// @typeparam T The type being allocated. This type is used to determine the required alignment.
-/// @param arena The memory arena to allocate from.
-/// @return A pointer to the new structure, or nullptr if the arena could not satisfy the allocation request.
-template <typename T>
-public_function inline T*
-OsHostMemoryArenaAllocate
+/// @summary Retrieve the contiguous free space in a ring buffer. Call from the single producer thread only.
+/// @param ring The OS_MAGIC_RING_BUFFER to write to.
+/// @param bytes_free On return, set to the number of bytes that can be written starting at the returned address.
+/// @return The address at which the producer should write data. Call OsMagicRingBufferWriteEnd to make the data visible to the consumer.
+public_function void*
+OsMagicRingBufferWriteBegin
 (
-    OS_HOST_MEMORY_ARENA *arena
+    OS_MAGIC_RING_BUFFER *ring, 
+    size_t          &bytes_free
 )
 {
-    return (T*) OsHostMemoryArenaAllocate(arena, sizeof(T), std::alignment_of<T>::value);
+    uint64_t write = ring->WriteCursor.load(std::memory_order_relaxed);
+    uint64_t  read = ring->ReadCursor.load(std::memory_order_acquire);
+    bytes_free = (size_t)(ring->Capacity - (write - read));
+    return ring->BaseAddress + (write & ring->Mask);
 }
 
-/// @summary Allocate memory for an array of structures.
-/// @typeparam T The type of array element. This type is used to determine the required alignment.
-/// @param arena The memory arena to allocate from.
-/// @param count The number of items to allocate.
-/// @return A pointer to the start of the array, or nullptr if the arena could not satisfy the allocation request.
-template <typename T>
-public_function inline T*
-OsHostMemoryArenaAllocateArray
+/// @summary Make data written after a call to OsMagicRingBufferWriteBegin visible to the consumer. Call from the single producer thread only.
+/// @param ring The OS_MAGIC_RING_BUFFER to write to.
+/// @param bytes_written The number of bytes written. This value must not exceed the bytes_free value returned by OsMagicRingBufferWriteBegin.
+public_function void
+OsMagicRingBufferWriteEnd
 (
-    OS_HOST_MEMORY_ARENA *arena, 
-    size_t                count
+    OS_MAGIC_RING_BUFFER *ring, 
+    size_t        bytes_written
 )
 {
-    return (T*) OsHostMemoryArenaAllocate(arena, sizeof(T) * count, std::alignment_of<T>::value);
+    uint64_t write = ring->WriteCursor.load(std::memory_order_relaxed);
+    assert(write + bytes_written - ring->ReadCursor.load(std::memory_order_relaxed) <= ring->Capacity);
+    ring->WriteCursor.store(write + bytes_written, std::memory_order_release);
 }
 
-/// @summary Retrieve an exact marker that can be used to reset or decommit the arena, preserving all current allocations.
-/// @param arena The memory arena to query.
-/// @return The marker representing the byte offset of the next allocation.
-public_function inline os_arena_marker_t
-OsHostMemoryArenaMark
+/// @summary Reserve a contiguous range of a ring buffer for writing. Any number of producer threads may reserve space concurrently.
+/// @param ring The OS_MAGIC_RING_BUFFER to write to.
+/// @param size The number of bytes to reserve.
+/// @param cursor On return, set to the cursor value identifying the reservation. Pass this value to OsMagicRingBufferCommit.
+/// @return The address at which the producer should write size bytes, or NULL if insufficient space is available.
+public_function void*
+OsMagicRingBufferReserve
 (
-    OS_HOST_MEMORY_ARENA *arena
+    OS_MAGIC_RING_BUFFER *ring, 
+    size_t                size, 
+    uint64_t           &cursor
 )
 {
-    return OsArenaMark(&arena->Allocator);
+    uint64_t reserve = ring->ReserveCursor.load(std::memory_order_relaxed);
+    do
+    {
+        uint64_t read = ring->ReadCursor.load(std::memory_order_acquire);
+        if (reserve + size - read > ring->Capacity)
+        {   // the consumer has not freed enough space.
+            return NULL;
+        }
+    } while (!ring->ReserveCursor.compare_exchange_weak(reserve, reserve + size, std::memory_order_relaxed, std::memory_order_relaxed));
+    cursor = reserve;
+    return ring->BaseAddress + (reserve & ring->Mask);
 }
 
-/// @summary Resets the state of the arena back to a marker, without decommitting any memory.
-/// @param arena The memory arena to reset.
-/// @param arena_marker The marker value returned by OsHostMemoryArenaMark().
-public_function inline void
-OsHostMemoryArenaResetToMarker
+/// @summary Make data written into a range returned by OsMagicRingBufferReserve visible to the consumer.
+/// Reservations become visible in the order they were made, so this call waits until all earlier reservations have been committed.
+/// @param ring The OS_MAGIC_RING_BUFFER to write to.
+/// @param cursor The cursor value returned by OsMagicRingBufferReserve.
+/// @param size The number of bytes reserved, as passed to OsMagicRingBufferReserve.
+public_function void
+OsMagicRingBufferCommit
 (
-    OS_HOST_MEMORY_ARENA    *arena,
-    os_arena_marker_t arena_marker
+    OS_MAGIC_RING_BUFFER *ring, 
+    uint64_t            cursor, 
+    size_t                size
 )
 {
-    OsArenaResetToMarker(&arena->Allocator, arena_marker);
+    uint32_t spin_count = 0;
+    while (ring->WriteCursor.load(std::memory_order_acquire) != cursor)
+    {   // wait for producers holding earlier reservations. yield if they appear to be descheduled.
+        if (++spin_count < 64)
+        {
+            _mm_pause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    ring->WriteCursor.store(cursor + size, std::memory_order_release);
 }
 
-/// @summary Resets the state of the arena to empty, without decomitting any memory.
-/// @param arena The memory arena to reset.
-public_function inline void
-OsHostMemoryArenaReset
+/// @summary Retrieve the contiguous range of data available to the consumer. Call from the single consumer thread only.
+/// @param ring The OS_MAGIC_RING_BUFFER to read from.
+/// @param bytes_available On return, set to the number of bytes that can be read starting at the returned address.
+/// @return The address of the first byte of available data. Call OsMagicRingBufferReadEnd to return the space to the producers.
+public_function void*
+OsMagicRingBufferReadBegin
 (
-    OS_HOST_MEMORY_ARENA *arena
+    OS_MAGIC_RING_BUFFER *ring, 
+    size_t     &bytes_available
 )
 {
-    OsArenaReset(&arena->Allocator);
+    uint64_t  read = ring->ReadCursor.load(std::memory_order_relaxed);
+    uint64_t write = ring->WriteCursor.load(std::memory_order_acquire);
+    bytes_available = (size_t)(write - read);
+    return ring->BaseAddress + (read & ring->Mask);
+}
+
+/// @summary Return space consumed after a call to OsMagicRingBufferReadBegin to the producers. Call from the single consumer thread only.
+/// @param ring The OS_MAGIC_RING_BUFFER to read from.
+/// @param bytes_read The number of bytes consumed. This value must not exceed the bytes_available value returned by OsMagicRingBufferReadBegin.
+public_function void
+OsMagicRingBufferReadEnd
+(
+    OS_MAGIC_RING_BUFFER *ring, 
+    size_t           bytes_read
+)
+{
+    uint64_t read = ring->ReadCursor.load(std::memory_order_relaxed);
+    assert(read + bytes_read <= ring->WriteCursor.load(std::memory_order_relaxed));
+    ring->ReadCursor.store(read + bytes_read, std::memory_order_release);
 }
 
 /// @summary Retrieve a high-resolution timestamp value.
@@ -6174,9 +14059,16 @@ OsTimestampInTicks
     void
 )
 {
+#if defined(__linux__)
+    // on Linux, one tick is one nanosecond of CLOCK_MONOTONIC.
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t(ts.tv_sec) * 1000000000ULL) + uint64_t(ts.tv_nsec);
+#else
     LARGE_INTEGER ticks;
     QueryPerformanceCounter(&ticks);
     return (uint64_t) ticks.QuadPart;
+#endif
 }
 
 /// @summary Retrieve a nanosecond-resolution timestamp value.
@@ -6187,6 +14079,9 @@ OsTimestampInNanoseconds
     void
 )
 {
+#if defined(__linux__)
+    return OsTimestampInTicks();
+#else
     LARGE_INTEGER freq;
     LARGE_INTEGER ticks;
     QueryPerformanceCounter(&ticks);
@@ -6194,6 +14089,7 @@ OsTimestampInNanoseconds
     // scale the tick value by the nanoseconds-per-second multiplier
     // before scaling back down by ticks-per-second to avoid loss of precision.
     return (1000000000ULL * uint64_t(ticks.QuadPart)) / uint64_t(freq.QuadPart);
+#endif
 }
 
 /// @summary Calculates the number of whole nanoseconds in a fixed slice of a whole second.
@@ -6219,11 +14115,15 @@ OsElapsedNanoseconds
     uint64_t   end_ticks
 )
 {   
+#if defined(__linux__)
+    return (end_ticks - start_ticks);
+#else
     LARGE_INTEGER freq;
     QueryPerformanceFrequency(&freq);
     // scale the tick value by the nanoseconds-per-second multiplier
     // before scaling back down by ticks-per-second to avoid loss of precision.
     return (1000000000ULL * (end_ticks - start_ticks)) / uint64_t(freq.QuadPart);
+#endif
 }
 
 /// @summary Convert a time value specified in milliseconds to nanoseconds.
@@ -6250,6 +14150,7 @@ OsNanosecondsToWholeMilliseconds
     return (uint32_t)(nanoseconds / 1000000ULL);
 }
 
+#if !defined(__linux__)
 /// @summary Enumerate all CPU resources of the host system.
 /// @param cpu_info The structure to populate with information about host CPU resources.
 /// @param scratch_mem Temporary scratch memory to use while enumerating CPU resources.
@@ -6356,6 +14257,7 @@ OsQueryHostCpuLayout
     cpu_info->HardwareThreads = (smt_count * cpu_info->ThreadsPerCore) + (cpu_info->PhysicalCores - smt_count);
     return true;
 }
+#endif /* !defined(__linux__) */
 
 /// @summary Retrieve the operating system identifier of the calling thread.
 /// @return The operating system identifier of the calling thread.
@@ -6365,9 +14267,14 @@ OsThreadId
     void
 )
 {
+#if defined(__linux__)
+    return (uint32_t) syscall(SYS_gettid);
+#else
     return GetCurrentThreadId();
+#endif
 }
 
+#if !defined(__linux__)
 /// @summary Calculate the amount of memory required to create a ready-to-run task queue.
 /// @param max_active_tasks The maximum number of active tasks in the owning OS_TASK_POOL. This value must be a power of two.
 /// @return The number of bytes required to create an OS_TASK_QUEUE with the specified capacity.
@@ -6409,6 +14316,7 @@ OsAllocationSizeForTaskScheduler
     OS_TASK_POOL_INIT *pool_types = init->TaskPoolTypes;
     size_t              num_bytes = 0;
     size_t             pool_count = 0;
+    size_t            max_threads = init->MaxWorkerThreadCount > init->WorkerThreadCount ? init->MaxWorkerThreadCount : init->WorkerThreadCount;
 
     num_bytes += OsAllocationSizeForArray<uint32_t        >(init->PoolTypeCount);
     num_bytes += OsAllocationSizeForArray<OS_TASK_POOL*   >(init->PoolTypeCount);
@@ -6421,11 +14329,12 @@ OsAllocationSizeForTaskScheduler
     num_bytes += OsAllocationSizeForArray<OS_TASK_POOL        >(pool_count);
     num_bytes += OsAllocationSizeForArray<OS_HOST_MEMORY_ARENA>(pool_count);
     num_bytes += OsAllocationSizeForArray<OS_IO_REQUEST_POOL  >(pool_count);
-    num_bytes += OsAllocationSizeForArray<unsigned int>(init->WorkerThreadCount);
-    num_bytes += OsAllocationSizeForArray<HANDLE      >(init->WorkerThreadCount);
-    num_bytes += OsAllocationSizeForArray<HANDLE      >(init->WorkerThreadCount);
-    num_bytes += OsAllocationSizeForArray<HANDLE      >(init->WorkerThreadCount);
-    num_bytes += OsAllocationSizeForArray<HANDLE      >(init->WorkerThreadCount);
+    num_bytes += OsAllocationSizeForArray<unsigned int        >(max_threads);
+    num_bytes += OsAllocationSizeForArray<HANDLE              >(max_threads);
+    num_bytes += OsAllocationSizeForArray<HANDLE              >(max_threads);
+    num_bytes += OsAllocationSizeForArray<HANDLE              >(max_threads);
+    num_bytes += OsAllocationSizeForArray<HANDLE              >(max_threads);
+    num_bytes += OsAllocationSizeForArray<OS_TASK_WORKER_STATS>(max_threads);
     return num_bytes;
 }
 
@@ -6497,6 +14406,7 @@ OsTaskSchedulerThreadMain
 {
     OS_TASK_SCHEDULER_THREAD_INIT  init = {};
     OS_TASK_ENVIRONMENT         taskenv = {};
+    OS_TASK_WORKER_STATS         *stats = NULL;
     OS_TASK_POOL                *victim = NULL;
     HANDLE                         iocp = NULL;
     OVERLAPPED              *overlapped = NULL;
@@ -6512,7 +14422,8 @@ OsTaskSchedulerThreadMain
     // argp may have been allocated on the stack of the caller 
     // and is only guaranteed to remain valid until the ReadySignal is set.
     CopyMemory(&init, argp, sizeof(OS_TASK_SCHEDULER_THREAD_INIT));
-    iocp = init.CompletionPort;
+    iocp  = init.CompletionPort;
+    stats =&init.TaskScheduler->WorkerThreadStats[init.WorkerIndex];
 
     // spit out a message just prior to initialization:
     OsLayerOutput("START: %S(%u): Task scheduler worker thread starting.\n", __FUNCTION__, tid);
@@ -6526,22 +14437,57 @@ OsTaskSchedulerThreadMain
         return 1;
     }
 
+    // thread-affine tasks delivered to this worker's pool wake the worker through its completion port.
+    taskenv.TaskPool->WakePort.store(iocp, std::memory_order_release);
+
     // signal the main thread that this thread is ready to run.
     SetEvent(init.ReadySignal);
 
+    // populate the local memory after signaling, so that workers fault their pages in parallel.
+    // first touch from the worker thread places the pages on the worker's NUMA node.
+    if (init.TaskScheduler->PrefaultMemory && taskenv.LocalMemory->HostMemory.HostAddress != NULL)
+    {
+        OsHostMemoryPrefault(taskenv.LocalMemory->HostMemory.HostAddress, taskenv.LocalMemory->HostMemory.SizeInBytes);
+    }
+
     __try
     {
         while (keep_running)
         {   // enter a wait on the completion port. the thread will receive a notification 
             // when it has been assigned some work to steal (or to shut down), and wake up.
-            if (GetQueuedCompletionStatus(iocp, &num_bytes, &signal_arg, &overlapped, INFINITE))
+            // the time spent waiting is recorded for use by the worker scaling policy.
+            uint64_t idle_start = OsTimestampInTicks();
+            BOOL     got_packet = FALSE;
+            stats->IdleSince.store(idle_start, std::memory_order_relaxed);
+            got_packet = GetQueuedCompletionStatus(iocp, &num_bytes, &signal_arg, &overlapped, INFINITE);
+            stats->IdleNanoseconds.fetch_add(OsElapsedNanoseconds(idle_start, OsTimestampInTicks()), std::memory_order_relaxed);
+            stats->IdleSince.store(0, std::memory_order_relaxed);
+            if (got_packet)
             {   // did this thread receive a shutdown or steal notification?
                 if (signal_arg == OS_COMPLETION_KEY_SHUTDOWN)
                 {   // the task scheduler is being shut down gracefully.
+                    // returning the pool closes its mailbox, first running any thread-affine tasks that are
+                    // still in it, since no other thread will pick them up.
+                    OsReturnTaskPool(&taskenv);
+                    keep_running = false;
+                    exit_code = 0;
+                    break;
+                }
+                else if (signal_arg == OS_COMPLETION_KEY_RETIRE)
+                {   // this worker is being retired while the other workers keep running.
+                    // the pool is returned, and can be re-acquired by a worker launched into this slot later on,
+                    // so wait until nothing refers to the tasks defined in it before giving it up.
+                    stats->TasksExecuted.fetch_add(OsDrainTaskPool(&taskenv), std::memory_order_relaxed);
+                    OsReturnTaskPool(&taskenv);
                     keep_running = false;
                     exit_code = 0;
                     break;
                 }
+                else if (signal_arg == OS_COMPLETION_KEY_TASK_MAILBOX)
+                {   // one or more thread-affine tasks were delivered to this worker's mailbox.
+                    // there's no victim to steal from; the mailbox is checked first below.
+                    victim = taskenv.TaskPool;
+                }
                 else
                 {   // the completion key is the OS_TASK_POOL to steal from.
                     // num_bytes is set to the number of tasks to steal (for now, always 1.)
@@ -6554,8 +14500,21 @@ OsTaskSchedulerThreadMain
                 // stolen task, which may produce additional work in the local task queue.
                 // continue to execute work from the local task queue until it is empty.
                 for ( ; ; )
-                {   // first attempt to steal a task from the victim task pool that woke us.
-                    for (size_t steal_attempts = 0; steal_attempts < 4; ++steal_attempts)
+                {   // thread-affine tasks can only run on this thread, so run them before anything else.
+                    // then drain any work they produced in the local ready-to-run queue.
+                    size_t mailbox_count = OsExecuteMailboxTasks(&taskenv);
+                    if (mailbox_count > 0)
+                    {
+                        stats->TasksExecuted.fetch_add(mailbox_count, std::memory_order_relaxed);
+                        while ((work_item = OsTaskQueueTake(&taskenv.TaskPool->WorkQueue, more_work)) != OS_INVALID_TASK_ID)
+                        {
+                            OsExecuteTask(&taskenv, work_item);
+                            stats->TasksExecuted.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                    // attempt to steal a task from the victim task pool that woke us.
+                    work_item = OS_INVALID_TASK_ID;
+                    for (size_t steal_attempts = 0; steal_attempts < 4 && victim != taskenv.TaskPool; ++steal_attempts)
                     {   // due to queue contention, a steal attempt may fail even though 
                         // there's still a task available in the victim's ready-to-run queue.
                         if ((work_item = OsTaskQueueSteal(&victim->WorkQueue, more_work)) != OS_INVALID_TASK_ID)
@@ -6588,14 +14547,10 @@ OsTaskSchedulerThreadMain
                     // taking from the local ready-to-run queue for as long as possible.
                     do
                     {   // execute a single task, which may produce additional tasks in the thread-local ready-to-run queue.
-                        uint32_t const tsrc = (work_item & OS_TASK_ID_MASK_POOL) >> OS_TASK_ID_SHIFT_POOL;
-                        uint32_t const tidx = (work_item & OS_TASK_ID_MASK_INDEX) >> OS_TASK_ID_SHIFT_INDEX;
-                        OS_TASK_DATA  *task = &taskenv.TaskPool->TaskPoolList[tsrc].TaskPoolData[tidx];
-
-                        // set up the work environment and execute the task.
-                        OsHostMemoryArenaReset(taskenv.LocalMemory);
-                        task->TaskMain(work_item, task->TaskData, &taskenv);
-                        OsCompleteTask(&taskenv, work_item);
+                        // this is the outermost task scope, so the local memory arena should be empty.
+                        assert(OsHostMemoryArenaMark(taskenv.LocalMemory) == 0);
+                        OsExecuteTask(&taskenv, work_item);
+                        stats->TasksExecuted.fetch_add(1, std::memory_order_relaxed);
 
                         // and then attempt to grab another task from the thread-local ready-to-run queue.
                     } while ((work_item = OsTaskQueueTake(&taskenv.TaskPool->WorkQueue, more_work)) != OS_INVALID_TASK_ID);
@@ -6637,21 +14592,24 @@ OsCreateTaskScheduler
     HANDLE               *thread_ready = NULL;
     HANDLE               *thread_error = NULL;
     HANDLE                *thread_iocp = NULL;
+    OS_TASK_WORKER_STATS *thread_stats = NULL;
     CV_PROVIDER           *cv_provider = NULL;
     CV_MARKERSERIES         *cv_series = NULL;
     HRESULT                  cv_result = S_OK;
     char                   cv_name[64] = {};
-    OS_HOST_MEMORY_ARENA    global_mem = {};
+    OS_MEMORY_RANGE         global_mem = {};
     OS_HOST_MEMORY_ARENA scheduler_mem = {};
     OS_MEMORY_RANGE            all_mem = {};
     OS_CPU_INFO               cpu_info = {};
     size_t              bytes_required = 0;
     size_t                thread_count = 0;
+    size_t                 max_threads = init->WorkerThreadCount;
     size_t                  pool_count = 0;
     size_t                  pool_index = 0;
     size_t           worker_pool_index = 0;
     uint32_t            worker_pool_id = 0;
     bool             found_worker_pool = false;
+    bool              init_worker_lock = false;
 
     // initialize the fields of the OS_TASK_SCHEDULER object.
     OsZeroMemory(scheduler, sizeof(OS_TASK_SCHEDULER));
@@ -6699,11 +14657,20 @@ OsCreateTaskScheduler
         }
         pool_count += init->TaskPoolTypes[i].PoolCount;
     }
-    if (init->WorkerThreadCount > 0 && !found_worker_pool)
+    if (init->MaxWorkerThreadCount > max_threads)
+    {   // the scheduler can grow beyond its initial worker count.
+        max_threads = init->MaxWorkerThreadCount;
+    }
+    if (max_threads > 0 && !found_worker_pool)
     {
         OsLayerError("ERROR: %S(%u): No pool type found with OS_TASK_POOL_USAGE_FLAG_WORKER.\n", __FUNCTION__, GetCurrentThreadId());
         return -1;
     }
+    if (max_threads > 0 && init->TaskPoolTypes[worker_pool_index].PoolCount < max_threads)
+    {   // each worker thread, including those added at runtime, needs its own task pool.
+        OsLayerError("ERROR: %S(%u): Worker pool type %u has %Iu pools, but up to %Iu worker threads may be active.\n", __FUNCTION__, GetCurrentThreadId(), worker_pool_id, init->TaskPoolTypes[worker_pool_index].PoolCount, max_threads);
+        return -1;
+    }
     if (pool_count == 0)
     {
         OsLayerError("ERROR: %S(%u): Cannot create scheduler with zero task pools.\n", __FUNCTION__, GetCurrentThreadId());
@@ -6726,11 +14693,12 @@ OsCreateTaskScheduler
     bytes_required += OsAllocationSizeForArray<OS_TASK_POOL        >(pool_count);              // OS_TASK_SCHEDULER::TaskPoolList.
     bytes_required += OsAllocationSizeForArray<OS_HOST_MEMORY_ARENA>(pool_count);              // OS_TASK_SCHEDULER::TaskPoolArenas.
     bytes_required += OsAllocationSizeForArray<OS_IO_REQUEST_POOL  >(pool_count);              // OS_TASK_SCHEDULER::TaskIoRequestPools.
-    bytes_required += OsAllocationSizeForArray<unsigned int        >(init->WorkerThreadCount); // OS_TASK_SCHEDULER::WorkerThreadIds.
-    bytes_required += OsAllocationSizeForArray<HANDLE              >(init->WorkerThreadCount); // OS_TASK_SCHEDULER::WorkerThreadHandle.
-    bytes_required += OsAllocationSizeForArray<HANDLE              >(init->WorkerThreadCount); // OS_TASK_SCHEDULER::WorkerThreadReady.
-    bytes_required += OsAllocationSizeForArray<HANDLE              >(init->WorkerThreadCount); // OS_TASK_SCHEDULER::WorkerThreadError.
-    bytes_required += OsAllocationSizeForArray<HANDLE              >(init->WorkerThreadCount); // OS_TASK_SCHEDULER::WorkerThreadPort.
+    bytes_required += OsAllocationSizeForArray<unsigned int        >(max_threads);             // OS_TASK_SCHEDULER::WorkerThreadIds.
+    bytes_required += OsAllocationSizeForArray<HANDLE              >(max_threads);             // OS_TASK_SCHEDULER::WorkerThreadHandle.
+    bytes_required += OsAllocationSizeForArray<HANDLE              >(max_threads);             // OS_TASK_SCHEDULER::WorkerThreadReady.
+    bytes_required += OsAllocationSizeForArray<HANDLE              >(max_threads);             // OS_TASK_SCHEDULER::WorkerThreadError.
+    bytes_required += OsAllocationSizeForArray<HANDLE              >(max_threads);             // OS_TASK_SCHEDULER::WorkerThreadPort.
+    bytes_required += OsAllocationSizeForArray<OS_TASK_WORKER_STATS>(max_threads);             // OS_TASK_SCHEDULER::WorkerThreadStats.
     if (init->GlobalMemorySize > 0)
     {   // include the global memory in the total.
         // the global memory must have the same alignment as a VMM allocation (typically 64KB).
@@ -6798,11 +14766,8 @@ OsCreateTaskScheduler
             OsLayerError("ERROR: %S(%u): Failed to allocate global memory of %Iu bytes with alignment %Iu.\n", __FUNCTION__, GetCurrentThreadId(), init->GlobalMemorySize, vmalign);
             goto cleanup_and_fail;
         }
-        if (OsCreateHostMemoryArena(&global_mem, OsInitHostMemoryRange(gmem, init->GlobalMemorySize)) < 0)
-        {
-            OsLayerError("ERROR: %S(%u): Failed to initialize global memory arena.\n", __FUNCTION__, GetCurrentThreadId());
-            goto cleanup_and_fail;
-        }
+        // the concurrent arena is initialized in-place within the scheduler below.
+        global_mem = OsInitHostMemoryRange(gmem, init->GlobalMemorySize);
     }
 
     // allocate memory for the various scheduler lists.
@@ -6824,24 +14789,27 @@ OsCreateTaskScheduler
     ZeroMemory(arena_list, pool_count          * sizeof(OS_MEMORY_ARENA));
     ZeroMemory(iorp_list , pool_count          * sizeof(OS_IO_REQUEST_POOL));
 
-    // allocate memory for the worker thread pool.
-    if (init->WorkerThreadCount > 0)
+    // allocate memory for the worker thread pool. storage is reserved for the 
+    // maximum number of workers so that workers can be added at runtime.
+    if (max_threads > 0)
     {
-        thread_ids      = OsHostMemoryArenaAllocateArray<unsigned int>(&scheduler_mem, init->WorkerThreadCount);
-        thread_handles  = OsHostMemoryArenaAllocateArray<HANDLE>(&scheduler_mem, init->WorkerThreadCount);
-        thread_ready    = OsHostMemoryArenaAllocateArray<HANDLE>(&scheduler_mem, init->WorkerThreadCount);
-        thread_error    = OsHostMemoryArenaAllocateArray<HANDLE>(&scheduler_mem, init->WorkerThreadCount);
-        thread_iocp     = OsHostMemoryArenaAllocateArray<HANDLE>(&scheduler_mem, init->WorkerThreadCount);
-        if (thread_ids == NULL || thread_handles == NULL || thread_ready == NULL || thread_error == NULL || thread_iocp == NULL)
+        thread_ids      = OsHostMemoryArenaAllocateArray<unsigned int>(&scheduler_mem, max_threads);
+        thread_handles  = OsHostMemoryArenaAllocateArray<HANDLE>(&scheduler_mem, max_threads);
+        thread_ready    = OsHostMemoryArenaAllocateArray<HANDLE>(&scheduler_mem, max_threads);
+        thread_error    = OsHostMemoryArenaAllocateArray<HANDLE>(&scheduler_mem, max_threads);
+        thread_iocp     = OsHostMemoryArenaAllocateArray<HANDLE>(&scheduler_mem, max_threads);
+        thread_stats    = OsHostMemoryArenaAllocateArray<OS_TASK_WORKER_STATS>(&scheduler_mem, max_threads);
+        if (thread_ids == NULL || thread_handles == NULL || thread_ready == NULL || thread_error == NULL || thread_iocp == NULL || thread_stats == NULL)
         {
             OsLayerError("ERROR: %S(%u): Failed to allocate memory for task scheduler thread pool.\n", __FUNCTION__, GetCurrentThreadId());
             goto cleanup_and_fail;
         }
-        ZeroMemory(thread_ids    , init->WorkerThreadCount * sizeof(unsigned int));
-        ZeroMemory(thread_handles, init->WorkerThreadCount * sizeof(HANDLE));
-        ZeroMemory(thread_ready  , init->WorkerThreadCount * sizeof(HANDLE));
-        ZeroMemory(thread_error  , init->WorkerThreadCount * sizeof(HANDLE));
-        ZeroMemory(thread_iocp   , init->WorkerThreadCount * sizeof(HANDLE));
+        ZeroMemory(thread_ids    , max_threads * sizeof(unsigned int));
+        ZeroMemory(thread_handles, max_threads * sizeof(HANDLE));
+        ZeroMemory(thread_ready  , max_threads * sizeof(HANDLE));
+        ZeroMemory(thread_error  , max_threads * sizeof(HANDLE));
+        ZeroMemory(thread_iocp   , max_threads * sizeof(HANDLE));
+        ZeroMemory(thread_stats  , max_threads * sizeof(OS_TASK_WORKER_STATS));
     }
 
     // initialize all of the task pools and the associated free lists.
@@ -6862,8 +14830,11 @@ OsCreateTaskScheduler
             pool->LastError       = OS_TASK_POOL_ERROR_NONE;
             pool->PoolId          = pool_def.PoolId;
             pool->NextWorker      = 0;
-            pool->WorkerCount     =(uint16_t)  init->WorkerThreadCount;
             pool->TaskPoolList    = pool_list;
+            pool->WakePort.store(NULL, std::memory_order_relaxed);
+            pool->WakeEvent.store(NULL, std::memory_order_relaxed);
+            pool->PostActive.store(0, std::memory_order_relaxed);
+            pool->Mailbox.store(OS_TASK_MAILBOX_CLOSED, std::memory_order_relaxed);
             pool->TaskPoolData    = OsHostMemoryArenaAllocateArray<OS_TASK_DATA>(&scheduler_mem, pool_def.MaxActiveTasks);
             pool->NextFreePool    = free_lists[type_idx];
             free_lists[type_idx]  = pool;
@@ -6911,86 +14882,48 @@ OsCreateTaskScheduler
     scheduler->TaskPoolList              = pool_list;
     scheduler->TaskPoolArenas            = arena_list;
     scheduler->TaskIoRequestPools        = iorp_list;
-    scheduler->WorkerThreadCount         = init->WorkerThreadCount;
+    scheduler->MaxWorkerThreadCount      = max_threads;
+    scheduler->WorkerPoolId              = worker_pool_id;
     scheduler->WorkerThreadIds           = thread_ids;
     scheduler->WorkerThreadHandle        = thread_handles;
     scheduler->WorkerThreadReady         = thread_ready;
     scheduler->WorkerThreadError         = thread_error;
     scheduler->WorkerThreadPort          = thread_iocp;
-    scheduler->GlobalMemoryArena         = global_mem;
+    scheduler->WorkerThreadStats         = thread_stats;
+    scheduler->WorkerThreadCount.store(0, std::memory_order_relaxed);
+    InitializeCriticalSectionAndSpinCount(&scheduler->WorkerControlLock, 0x1000);
+    init_worker_lock = true;
+    OsCreateConcurrentArena(&scheduler->GlobalMemoryArena, global_mem, init->GlobalMemoryChunkSize);
     scheduler->IoThreadPool              = init->IoThreadPool;
     scheduler->HostCpuInfo               = cpu_info;
     scheduler->TaskContextData           = init->TaskContextData;
+    scheduler->PrefaultMemory            = init->PrefaultMemory;
     scheduler->TaskProfiler.Provider     = cv_provider;
     scheduler->TaskProfiler.MarkerSeries = cv_series;
     scheduler->SchedulerArena            = scheduler_mem;
     scheduler->SchedulerMemory           = memory;
     scheduler->SchedulerMemoryPool       = init->SchedulerMemoryPool;
 
-    // set up the worker init structure and spawn all worker threads in the pool.
-    for (size_t thread_idx = 0, nthreads = init->WorkerThreadCount; thread_idx < nthreads; ++thread_idx)
+    // populate global memory before any worker can allocate from it, spreading the page faults over 
+    // one thread per initial worker. local memory is populated by each worker, on its own thread.
+    if (init->PrefaultMemory && global_mem.SizeInBytes > 0)
     {
-        OS_TASK_SCHEDULER_THREAD_INIT winit = {};
-        const DWORD            THREAD_READY = 0;
-        const DWORD            THREAD_ERROR = 1;
-        const DWORD              WAIT_COUNT = 2;
-        HANDLE              wset[WAIT_COUNT]={};
-        DWORD                        waitrc = 0;
+        int32_t numa_node = -1;
+        if (memory->NumaPolicy == OS_HOST_MEMORY_NUMA_POLICY_BIND)
+            numa_node = (int32_t) memory->NumaNode;
+        OsHostMemoryPrefaultParallel(global_mem.HostAddress, global_mem.SizeInBytes, init->WorkerThreadCount, numa_node);
+    }
 
-        // create the manual-reset events signaled by the worker to indicate that it is ready.
-        if ((thread_ready[thread_idx] = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL)
-        {
-            OsLayerError("ERROR: %S(%u): Unable to create ready signal for worker %Iu of %Iu (%08X).\n", __FUNCTION__, GetCurrentThreadId(), thread_idx, nthreads, GetLastError());
-            goto cleanup_and_fail;
-        }
-        if ((thread_error[thread_idx] = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL)
-        {
-            OsLayerError("ERROR: %S(%u): Unable to create error signal for worker %Iu of %Iu (%08X).\n", __FUNCTION__, GetCurrentThreadId(), thread_idx, nthreads, GetLastError());
-            CloseHandle(thread_ready[thread_idx]); thread_ready[thread_idx] = NULL;
-            goto cleanup_and_fail;
-        }
-        if ((thread_iocp[thread_idx] = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1)) == NULL)
+    // spawn the initial set of worker threads. each worker becomes visible to 
+    // OsPublishTasks only once it has finished initializing.
+    for (size_t thread_idx = 0, nthreads = init->WorkerThreadCount; thread_idx < nthreads; ++thread_idx)
+    {
+        if (OsLaunchTaskSchedulerWorker(scheduler, thread_idx) < 0)
         {
-            OsLayerError("ERROR: %S(%u): Unable to create I/O completion port for worker %Iu of %Iu (%08X).\n", __FUNCTION__, GetCurrentThreadId(), thread_idx, nthreads, GetLastError());
-            CloseHandle(thread_error[thread_idx]); thread_error[thread_idx] = NULL;
-            CloseHandle(thread_ready[thread_idx]); thread_ready[thread_idx] = NULL;
-            goto cleanup_and_fail;
-        }
-
-        // populate the OS_TASK_SCHEDULER_THREAD_INIT and then spawn the worker thread.
-        // the worker thread will need to copy this structure if it wants to access it 
-        // past the point where it signals the wready event.
-        winit.TaskScheduler   = scheduler;
-        winit.HostCpuInfo     = cpu_info;
-        winit.CompletionPort  = thread_iocp [thread_idx];
-        winit.ReadySignal     = thread_ready[thread_idx];
-        winit.ErrorSignal     = thread_error[thread_idx];
-        winit.TaskContextData = init->TaskContextData;
-        winit.IoThreadPool    = init->IoThreadPool;
-        winit.WorkerIndex     =(uint32_t) thread_idx;
-        winit.PoolId          = worker_pool_id;
-        if ((thread_handles[thread_idx] = (HANDLE) _beginthreadex(NULL, 0, OsTaskSchedulerThreadMain, &winit, 0, &thread_ids[thread_idx])) == NULL)
-        {
-            OsLayerError("ERROR: %S(%u): Unable to spawn worker %Iu of %Iu (errno = %d).\n", __FUNCTION__, GetCurrentThreadId(), thread_idx, nthreads, errno);
-            CloseHandle(thread_error[thread_idx]); thread_error[thread_idx] = NULL;
-            CloseHandle(thread_ready[thread_idx]); thread_ready[thread_idx] = NULL;
-            CloseHandle(thread_iocp [thread_idx]); thread_iocp [thread_idx] = NULL;
-            goto cleanup_and_fail;
-        }
-
-        // wait for the thread to become ready.
-        wset[THREAD_READY] = thread_ready[thread_idx]; 
-        wset[THREAD_ERROR] = thread_error[thread_idx];
-        if ((waitrc = WaitForMultipleObjects(WAIT_COUNT, wset, FALSE, INFINITE)) != (WAIT_OBJECT_0+THREAD_READY))
-        {   // thread initialization failed, or the wait failed.
-            // events are already in the OS_THREAD_POOL arrays, so don't clean up here.
-            OsLayerError("ERROR: %S(%u): Failed to initialize worker %Iu of %Iu (%08X).\n", __FUNCTION__, GetCurrentThreadId(), thread_idx, nthreads, waitrc);
             goto cleanup_and_fail;
         }
-        // SetThreadGroupAffinity, eventually.
-
         // increment the number of threads successfully launched.
-        thread_count++;
+        scheduler->WorkerThreadCount.store(++thread_count, std::memory_order_seq_cst);
     }
 
     return 0;
@@ -7008,11 +14941,18 @@ cleanup_and_fail:
         for (size_t i = 0, n = thread_count; i < n; ++i)
         {
             CloseHandle(thread_handles[i]);
-            CloseHandle(thread_error[i]);
-            CloseHandle(thread_ready[i]);
-            CloseHandle(thread_iocp[i]);
         }
     }
+    for (size_t i = 0, n = (thread_iocp != NULL) ? max_threads : 0; i < n; ++i)
+    {   // close the per-slot objects, which may exist for a slot whose worker failed to launch.
+        if (thread_error[i] != NULL) CloseHandle(thread_error[i]);
+        if (thread_ready[i] != NULL) CloseHandle(thread_ready[i]);
+        if (thread_iocp [i] != NULL) CloseHandle(thread_iocp [i]);
+    }
+    if (init_worker_lock)
+    {
+        DeleteCriticalSection(&scheduler->WorkerControlLock);
+    }
     if (list_locks != NULL)
     {   // delete all of the pool type free list critical sections.
         for (size_t i = 0, n = init->PoolTypeCount; i < n; ++i)
@@ -7041,29 +14981,36 @@ OsDestroyTaskScheduler
     OS_TASK_SCHEDULER *scheduler
 )
 {
-    if (scheduler->WorkerThreadCount > 0)
-    {   // notify all threads to shut down. they will empty their local work queue first. 
-        DWORD  num_threads = 0;
-        for (size_t i = 0, n = scheduler->WorkerThreadCount; i < n; ++i)
+    if (scheduler->MaxWorkerThreadCount > 0)
+    {   // notify all active threads to shut down. they will empty their local work queue first. 
+        // workers that are still being retired exit once their task pools are idle.
+        EnterCriticalSection(&scheduler->WorkerControlLock);
+        for (size_t i = 0, n = scheduler->MaxWorkerThreadCount; i < n; ++i)
         {
-            if (scheduler->WorkerThreadPort[i] != NULL)
+            if (scheduler->WorkerThreadHandle[i] != NULL)
             {
                 PostQueuedCompletionStatus(scheduler->WorkerThreadPort[i], 0, OS_COMPLETION_KEY_SHUTDOWN, NULL);
-                num_threads++;
             }
         }
-        if (num_threads > 0)
+        for (size_t i = 0, n = scheduler->MaxWorkerThreadCount; i < n; ++i)
         {   // wait until all threads terminate. this may take some time.
-            WaitForMultipleObjects(num_threads, scheduler->WorkerThreadHandle, TRUE, INFINITE);
+            if (scheduler->WorkerThreadHandle[i] != NULL)
+            {
+                WaitForSingleObject(scheduler->WorkerThreadHandle[i], INFINITE);
+            }
         }
         // now that all threads have terminated, close their handles.
-        for (size_t i = 0, n = num_threads; i < n; ++i)
+        // the per-slot objects may also exist for slots whose workers were retired.
+        for (size_t i = 0, n = scheduler->MaxWorkerThreadCount; i < n; ++i)
         {
-            CloseHandle(scheduler->WorkerThreadHandle[i]);
-            CloseHandle(scheduler->WorkerThreadPort[i]);
-            CloseHandle(scheduler->WorkerThreadError[i]);
-            CloseHandle(scheduler->WorkerThreadReady[i]);
+            if (scheduler->WorkerThreadHandle[i] != NULL) CloseHandle(scheduler->WorkerThreadHandle[i]);
+            if (scheduler->WorkerThreadPort  [i] != NULL) CloseHandle(scheduler->WorkerThreadPort  [i]);
+            if (scheduler->WorkerThreadError [i] != NULL) CloseHandle(scheduler->WorkerThreadError [i]);
+            if (scheduler->WorkerThreadReady [i] != NULL) CloseHandle(scheduler->WorkerThreadReady [i]);
         }
+        scheduler->WorkerThreadCount.store(0, std::memory_order_seq_cst);
+        LeaveCriticalSection(&scheduler->WorkerControlLock);
+        DeleteCriticalSection(&scheduler->WorkerControlLock);
     }
     if (scheduler->PoolTypeCount > 0)
     {   // delete all of the task pool free list critical sections.
@@ -7084,6 +15031,217 @@ OsDestroyTaskScheduler
     ZeroMemory(scheduler, sizeof(OS_TASK_SCHEDULER));
 }
 
+/// @summary Launch additional task scheduler worker threads. The calling thread is blocked until the new workers are ready to run tasks.
+/// This function must not be called from a task scheduler worker thread.
+/// @param scheduler The OS_TASK_SCHEDULER to which workers will be added.
+/// @param thread_count The number of worker threads to add. The total is limited by OS_TASK_SCHEDULER::MaxWorkerThreadCount.
+/// @return Zero if all requested workers were launched, or -1 if the limit was reached, the next worker slot is still being retired, or a worker could not be launched. Workers launched before the failure remain active.
+public_function int
+OsAddWorkerThreads
+(
+    OS_TASK_SCHEDULER *scheduler, 
+    size_t          thread_count
+)
+{
+    int result = 0;
+    EnterCriticalSection(&scheduler->WorkerControlLock);
+    {
+        size_t active = scheduler->WorkerThreadCount.load(std::memory_order_seq_cst);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            if (active >= scheduler->MaxWorkerThreadCount)
+            {
+                OsLayerError("ERROR: %S(%u): Cannot add worker; scheduler is limited to %Iu worker threads.\n", __FUNCTION__, GetCurrentThreadId(), scheduler->MaxWorkerThreadCount);
+                result = -1;
+                break;
+            }
+            if (scheduler->WorkerThreadHandle[active] != NULL)
+            {   // OsRemoveWorkerThreads has not finished retiring the previous worker in this slot.
+                OsLayerError("ERROR: %S(%u): Cannot add worker; worker %Iu is still being retired.\n", __FUNCTION__, GetCurrentThreadId(), active);
+                result = -1;
+                break;
+            }
+            if (OsLaunchTaskSchedulerWorker(scheduler, active) < 0)
+            {
+                result = -1;
+                break;
+            }
+            // the new worker is fully initialized; make it visible to OsPublishTasks.
+            scheduler->WorkerThreadCount.store(++active, std::memory_order_seq_cst);
+        }
+    }
+    LeaveCriticalSection(&scheduler->WorkerControlLock);
+    return result;
+}
+
+/// @summary Retire active task scheduler worker threads. Workers are retired in the reverse order they were added. Each retiring worker helps to run tasks until every task defined in its task pool has completed, and then returns the pool before exiting. 
+/// The calling thread is blocked until the retired workers have exited, so this function must not be called from a task scheduler worker thread. The worker control lock is not held during the wait.
+/// @param scheduler The OS_TASK_SCHEDULER from which workers will be retired.
+/// @param thread_count The number of worker threads to retire. At least one worker always remains active.
+/// @return Zero if all requested workers were retired, or -1 if fewer workers were retired to keep one worker active.
+public_function int
+OsRemoveWorkerThreads
+(
+    OS_TASK_SCHEDULER *scheduler, 
+    size_t          thread_count
+)
+{
+    int    result = 0;
+    size_t  first = 0;
+    size_t    end = 0;
+    EnterCriticalSection(&scheduler->WorkerControlLock);
+    {
+        size_t active = scheduler->WorkerThreadCount.load(std::memory_order_seq_cst);
+        end = active;
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            if (active <= 1)
+            {   // tasks defined on pools without OS_TASK_POOL_USAGE_FLAG_EXECUTE need someone to run them.
+                result = -1;
+                break;
+            }
+            size_t worker_index = --active;
+            // stop publishing to the worker before telling it to exit. any steal notification 
+            // already in its completion port is dequeued ahead of the retire notification.
+            scheduler->WorkerThreadCount.store(active, std::memory_order_seq_cst);
+            PostQueuedCompletionStatus(scheduler->WorkerThreadPort[worker_index], 0, OS_COMPLETION_KEY_RETIRE, NULL);
+        }
+        first = active;
+    }
+    LeaveCriticalSection(&scheduler->WorkerControlLock);
+
+    // a retiring worker may run for some time before its task pool is idle, so wait without holding the lock.
+    // OsAddWorkerThreads does not launch into a slot until its handle has been closed below.
+    for (size_t i = first; i < end; ++i)
+    {
+        WaitForSingleObject(scheduler->WorkerThreadHandle[i], INFINITE);
+    }
+    EnterCriticalSection(&scheduler->WorkerControlLock);
+    {
+        for (size_t i = first; i < end; ++i)
+        {   // the completion port is retained; a notification posted by a publisher that 
+            // raced with the count update is consumed by the next worker in this slot.
+            CloseHandle(scheduler->WorkerThreadHandle[i]);
+            scheduler->WorkerThreadHandle[i] = NULL;
+            scheduler->WorkerThreadIds[i] = 0;
+        }
+    }
+    LeaveCriticalSection(&scheduler->WorkerControlLock);
+    return result;
+}
+
+/// @summary Retrieve an estimate of the number of ready-to-run tasks waiting in all task pool work queues.
+/// @param scheduler The OS_TASK_SCHEDULER to query.
+/// @return The approximate number of tasks waiting to be executed. The value may be stale by the time it is returned.
+public_function size_t
+OsTaskSchedulerReadyTaskCount
+(
+    OS_TASK_SCHEDULER *scheduler
+)
+{
+    size_t total = 0;
+    for (size_t i = 0, n = scheduler->TaskPoolCount; i < n; ++i)
+    {
+        OS_TASK_QUEUE *queue = &scheduler->TaskPoolList[i].WorkQueue;
+        int64_t       public_pos = queue->Public.load(std::memory_order_relaxed);
+        int64_t      private_pos = queue->Private.load(std::memory_order_relaxed);
+        if (private_pos > public_pos)
+        {
+            total += size_t(private_pos - public_pos);
+        }
+    }
+    return total;
+}
+
+/// @summary Apply an automatic scaling policy to the set of active worker threads. Call this function periodically from a thread that is not a task scheduler worker.
+/// The policy compares the number of ready-to-run tasks and the fraction of time the active workers spent idle since the previous sample, and adds or retires at most one worker per call, unless the active count is outside of the policy limits.
+/// Retiring a worker blocks the caller until the worker's task pool is idle. The worker control lock is only held while the decision is made.
+/// @param scheduler The OS_TASK_SCHEDULER to update.
+/// @param policy The scaling thresholds to apply.
+/// @return The number of active worker threads after the update.
+public_function size_t
+OsUpdateWorkerThreadCount
+(
+    OS_TASK_SCHEDULER                    *scheduler, 
+    OS_TASK_SCHEDULER_SCALING_POLICY const  *policy
+)
+{
+    size_t active = 0;
+    size_t    add = 0;
+    size_t remove = 0;
+    EnterCriticalSection(&scheduler->WorkerControlLock);
+    {
+        uint64_t   now_ticks = OsTimestampInTicks();
+        uint64_t  idle_total = 0;
+        uint64_t  elapsed_ns = 0;
+        uint64_t  idle_delta = 0;
+        uint64_t    idle_pct = 0;
+        size_t   ready_count = 0;
+        size_t   max_workers = scheduler->MaxWorkerThreadCount;
+        size_t   min_workers = policy->MinWorkerThreads < 1 ? 1 : policy->MinWorkerThreads;
+        if (policy->MaxWorkerThreads != 0 && policy->MaxWorkerThreads < max_workers)
+        {   // zero means that the policy doesn't set a limit of its own.
+            max_workers = policy->MaxWorkerThreads;
+        }
+        if (min_workers > max_workers)
+        {
+            min_workers = max_workers;
+        }
+
+        active = scheduler->WorkerThreadCount.load(std::memory_order_seq_cst);
+        for (size_t i = 0, n = scheduler->MaxWorkerThreadCount; i < n; ++i)
+        {   // include the in-progress wait of any worker that is currently blocked.
+            OS_TASK_WORKER_STATS *stats = &scheduler->WorkerThreadStats[i];
+            uint64_t         idle_since =  stats->IdleSince.load(std::memory_order_relaxed);
+            idle_total += stats->IdleNanoseconds.load(std::memory_order_relaxed);
+            if (idle_since != 0 && i < active)
+            {
+                idle_total += OsElapsedNanoseconds(idle_since, now_ticks);
+            }
+        }
+        if (scheduler->ScalingSampleTime == 0)
+        {   // this is the first sample; there's no interval to evaluate yet.
+            scheduler->ScalingSampleTime = now_ticks;
+            scheduler->ScalingIdleTotal  = idle_total;
+            goto update_done;
+        }
+        if ((elapsed_ns = OsElapsedNanoseconds(scheduler->ScalingSampleTime, now_ticks)) < OsMillisecondsToNanoseconds(policy->MinIntervalMs))
+        {   // not enough time has passed since the last decision.
+            goto update_done;
+        }
+        idle_delta  = idle_total > scheduler->ScalingIdleTotal ? idle_total - scheduler->ScalingIdleTotal : 0;
+        idle_pct    = active > 0 && elapsed_ns > 0 ? (idle_delta * 100) / (elapsed_ns * active) : 100;
+        ready_count = OsTaskSchedulerReadyTaskCount(scheduler);
+        scheduler->ScalingSampleTime = now_ticks;
+        scheduler->ScalingIdleTotal  = idle_total;
+
+        if (active < min_workers)
+        {
+            add = min_workers - active;
+        }
+        else if (active > max_workers)
+        {
+            remove = active - max_workers;
+        }
+        else if (active < max_workers && ready_count > (size_t(policy->GrowQueueDepth) * active) && idle_pct < policy->GrowIdlePercent)
+        {   // work is backing up and the current workers are saturated.
+            add = 1;
+        }
+        else if (active > min_workers && ready_count == 0 && idle_pct > policy->ShrinkIdlePercent)
+        {   // the current workers are mostly idle.
+            remove = 1;
+        }
+    }
+update_done:
+    LeaveCriticalSection(&scheduler->WorkerControlLock);
+    // OsRemoveWorkerThreads waits for the retired workers without holding the lock.
+    // the lock is recursive, so it must not be held by this function during the call.
+    if (add    > 0) OsAddWorkerThreads(scheduler, add);
+    if (remove > 0) OsRemoveWorkerThreads(scheduler, remove);
+    if (add    > 0 || remove > 0) active = scheduler->WorkerThreadCount.load(std::memory_order_seq_cst);
+    return active;
+}
+
 /// @summary Allocate a task pool and bind it to a thread.
 /// @param taskenv The OS_TASK_ENVIRONMENT to initialize with the allocated pool.
 /// @param scheduler The OS_TASK_SCHEDULER from which the pool will be allocated.
@@ -7130,6 +15288,11 @@ OsAllocateTaskPool
             pool->LastError        = OS_TASK_POOL_ERROR_NONE;
             pool->NextWorker       = 0;
             pool->NextFreePool     = NULL;
+            pool->WakePort.store(NULL, std::memory_order_relaxed);
+            pool->WakeEvent.store(NULL, std::memory_order_relaxed);
+            // the mailbox was closed when the pool was returned; open it to accept thread-affine tasks.
+            assert(pool->Mailbox.load(std::memory_order_relaxed) == OS_TASK_MAILBOX_CLOSED);
+            pool->Mailbox.store(OS_INVALID_TASK_ID, std::memory_order_seq_cst);
             // initialize the task execution environment for the caller.
             taskenv->TaskProfiler  =&scheduler->TaskProfiler;
             taskenv->TaskScheduler = scheduler;
@@ -7140,6 +15303,9 @@ OsAllocateTaskPool
             taskenv->ContextData   = scheduler->TaskContextData;
             taskenv->LocalMemory   =&scheduler->TaskPoolArenas[pool->PoolIndex];
             taskenv->GlobalMemory  =&scheduler->GlobalMemoryArena;
+            taskenv->GlobalMemoryChunk.NextOffset = 0;
+            taskenv->GlobalMemoryChunk.EndOffset  = 0;
+            taskenv->GlobalMemoryChunk.Generation = 0;
             taskenv->IoThreadPool  = scheduler->IoThreadPool;
             taskenv->IoRequestPool =&scheduler->TaskIoRequestPools[pool->PoolIndex];
             return 0;
@@ -7159,8 +15325,8 @@ OsAllocateTaskPool
     }
 }
 
-/// @summary Recycle a task pool, returning it for use by another thread.
-/// @param taskenv The OS_TASK_ENVIRONMENT initialized by OsAllocateTaskPool.
+/// @summary Recycle a task pool, returning it for use by another thread. Thread-affine tasks already delivered to the pool are executed first, and tasks delivered afterwards are cancelled.
+/// @param taskenv The OS_TASK_ENVIRONMENT initialized by OsAllocateTaskPool. This function must be called from the thread that owns the pool.
 public_function void
 OsReturnTaskPool
 (
@@ -7172,6 +15338,8 @@ OsReturnTaskPool
         OsLayerError("ERROR: %S(%u): Task pool double-free.\n", __FUNCTION__, GetCurrentThreadId());
         return;
     }
+    // close the mailbox so that nothing is left in it, or delivered to it, once the pool is on the free list.
+    OsTaskMailboxClose(taskenv);
     // locate the PoolId in the list of pool types defined on the scheduler.
     uint32_t const *pool_ids = taskenv->TaskScheduler->PoolIdList;
     size_t   pool_type_index = 0;
@@ -7213,26 +15381,41 @@ OsPublishTasks
     size_t            task_count
 )
 {
-    HANDLE         *iocp_list = taskenv->TaskScheduler->WorkerThreadPort;
-    OS_TASK_POOL   *task_pool = taskenv->TaskPool;
+    OS_TASK_SCHEDULER *scheduler = taskenv->TaskScheduler;
+    HANDLE             *iocp_list = scheduler->WorkerThreadPort;
+    OS_TASK_POOL       *task_pool = taskenv->TaskPool;
+    size_t           worker_count = scheduler->WorkerThreadCount.load(std::memory_order_seq_cst);
     if ((task_pool->PoolUsage & OS_TASK_POOL_USAGE_FLAG_PUBLISH) == 0)
     {
         OsLayerError("ERROR: %S(%u): Attempt to publish %Iu tasks from thread without OS_TASK_POOL_USAGE_FLAG_PUBLISH.\n", __FUNCTION__, task_pool->ThreadId, task_count);
         return;
     }
-    if (task_pool->WorkerCount == 0)
+    if (worker_count == 0)
     {
         OsLayerError("ERROR: %S(%u): Attempt to publish %Iu tasks, but scheduler has no worker threads.\n", __FUNCTION__, task_pool->ThreadId, task_count);
         return;
     }
     for (size_t i = 0; i < task_count; ++i)
     {   // just go round-robin through the worker threads. allow NextWorker to wrap-around.
-        uint16_t worker_index = (task_pool->NextWorker++) % task_pool->WorkerCount;
+        uint32_t worker_index = (uint32_t) ((task_pool->NextWorker++) % worker_count);
         if (PostQueuedCompletionStatus(iocp_list[worker_index], 1, (ULONG_PTR) task_pool, NULL) == FALSE)
         {
             OsLayerError("ERROR: %S(%u): Failed to publish steal notification to worker %u (%08X).\n", __FUNCTION__, task_pool->ThreadId, worker_index, GetLastError());
             return;
         }
+        // if the target worker was retired concurrently, it may have exited without seeing 
+        // the notification. the completion port remains valid, but post again to a worker 
+        // that is still active. OsRemoveWorkerThreads lowers the count before posting the 
+        // shutdown notification, so any notification posted before the count changed is 
+        // dequeued by the retiring worker ahead of the shutdown notification.
+        if ((worker_count = scheduler->WorkerThreadCount.load(std::memory_order_seq_cst)) == 0)
+        {   // the scheduler is being destroyed.
+            return;
+        }
+        if (worker_count <= worker_index)
+        {
+            PostQueuedCompletionStatus(iocp_list[worker_index % worker_count], 1, (ULONG_PTR) task_pool, NULL);
+        }
     }
 }
 
@@ -7257,6 +15440,7 @@ OsCompleteTask
     uint32_t          usage = task_pool->PoolUsage;
     size_t   ready_to_run_s = 0;
     size_t   ready_to_run_p = 0;
+    size_t   ready_to_run_c = 0;
     os_task_id_t   *permits = NULL;
     int32_t        npermits = 0;
     int32_t      work_count = 0;
@@ -7274,9 +15458,18 @@ OsCompleteTask
             uint32_t const pidx = (permits[i] & OS_TASK_ID_MASK_INDEX) >> OS_TASK_ID_SHIFT_INDEX;
             OS_TASK_DATA *ptask = &pool_list[psrc].TaskPoolData[pidx];
             if (ptask->WaitCount.fetch_add(1, std::memory_order_seq_cst) == -1)
-            {   // this task is ready-to-run; push it onto the front of the local RTR queue.
-                OsTaskQueuePush(&task_pool->WorkQueue, permits[i]);
-                ready_to_run_s++;
+            {   // this task is ready-to-run. thread-affine tasks go to the mailbox of their target pool.
+                if (ptask->TargetPool == OS_TASK_POOL_INDEX_ANY)
+                {   // push it onto the front of the local RTR queue.
+                    OsTaskQueuePush(&task_pool->WorkQueue, permits[i]);
+                    ready_to_run_s++;
+                }
+                else if (!OsTaskMailboxPost(&pool_list[ptask->TargetPool], ptask, permits[i]))
+                {   // the thread that owned the target pool has returned it, so the task can never run.
+                    // complete it without running it, so that tasks waiting on it are not stranded.
+                    OsLayerError("ERROR: %S(%u): Task %08X cancelled; target task pool %u is not owned by a thread.\n", __FUNCTION__, GetCurrentThreadId(), permits[i], ptask->TargetPool);
+                    ready_to_run_c += OsCompleteTask(taskenv, permits[i]);
+                }
             }
         }
         if (ready_to_run_s != 0)
@@ -7301,22 +15494,98 @@ OsCompleteTask
             }
         }
 
-        // finally, mark the slot as being available on the owning task pool.
-        pool_list[tsrc].SlotStatus[tidx].store(OS_TASK_SLOT_STATUS_FREE, std::memory_order_release);
+        // finally, mark the slot as being available on the owning task pool.
+        pool_list[tsrc].SlotStatus[tidx].store(OS_TASK_SLOT_STATUS_FREE, std::memory_order_release);
+    }
+    return (ready_to_run_s + ready_to_run_p + ready_to_run_c);
+}
+
+/// @summary Retrieve the OS_TASK_POOL_ERROR resulting from the most recent task definition.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the OS_TASK_POOL to query.
+/// @return One of OS_TASK_POOL_ERROR.
+public_function int
+OsGetTaskPoolError
+(
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    return taskenv->TaskPool->LastError;
+}
+
+/// @summary Retrieve the index of the task pool bound to a thread. Other threads pass this value to OsDefineAffineTask to run tasks on the thread.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the OS_TASK_POOL to query.
+/// @return The zero-based index of the OS_TASK_POOL within the task scheduler.
+public_function uint32_t
+OsGetTaskPoolIndex
+(
+    OS_TASK_ENVIRONMENT *taskenv
+)
+{
+    return taskenv->TaskPool->PoolIndex;
+}
+
+/// @summary Specify an event to signal when a thread-affine task is delivered to the mailbox of a task pool owned by an application thread. 
+/// This allows a thread that is not a task scheduler worker, such as the thread that owns a window, to include the event in its own wait and then call OsExecuteMailboxTasks.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread, which must own the task pool.
+/// @param wake_event An auto-reset event owned by the application, or NULL to stop signaling. The event must remain valid until the task pool is returned.
+public_function void
+OsSetTaskMailboxEvent
+(
+    OS_TASK_ENVIRONMENT *taskenv, 
+    HANDLE            wake_event
+)
+{
+    assert(GetCurrentThreadId() == taskenv->ThreadId);
+    taskenv->TaskPool->WakeEvent.store(wake_event, std::memory_order_seq_cst);
+    if (wake_event != NULL && taskenv->TaskPool->Mailbox.load(std::memory_order_seq_cst) != OS_INVALID_TASK_ID)
+    {   // tasks were delivered before the event was set; make sure they are not missed.
+        SetEvent(wake_event);
     }
-    return (ready_to_run_s + ready_to_run_p);
 }
 
-/// @summary Retrieve the OS_TASK_POOL_ERROR resulting from the most recent task definition.
-/// @param taskenv The OS_TASK_ENVIRONMENT associated with the OS_TASK_POOL to query.
-/// @return One of OS_TASK_POOL_ERROR.
-public_function int
-OsGetTaskPoolError
+/// @summary Execute all thread-affine tasks currently in the mailbox of the task pool bound to the calling thread. Tasks are executed in the order they became ready-to-run.
+/// Tasks that become ready-to-run as a result are pushed onto the thread-local ready-to-run queue as usual.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread, which must own the task pool.
+/// @return The number of tasks executed.
+public_function size_t
+OsExecuteMailboxTasks
 (
     OS_TASK_ENVIRONMENT *taskenv
 )
 {
-    return taskenv->TaskPool->LastError;
+    OS_TASK_POOL      *self = taskenv->TaskPool;
+    OS_TASK_POOL *pool_list = self->TaskPoolList;
+    os_task_id_t       list = OS_INVALID_TASK_ID;
+    os_task_id_t       fifo = OS_INVALID_TASK_ID;
+    size_t            count = 0;
+
+    assert(GetCurrentThreadId() == taskenv->ThreadId);
+    if ((list = self->Mailbox.load(std::memory_order_relaxed)) == OS_INVALID_TASK_ID || list == OS_TASK_MAILBOX_CLOSED)
+    {   // the common case - nothing has been delivered.
+        return 0;
+    }
+    // detach the entire list. only the owning thread removes items, so there is no ABA problem.
+    list = self->Mailbox.exchange(OS_INVALID_TASK_ID, std::memory_order_acquire);
+    while (list != OS_INVALID_TASK_ID)
+    {   // the list is in LIFO order; reverse it so that tasks run in delivery order.
+        uint32_t const  tsrc = (list & OS_TASK_ID_MASK_POOL ) >> OS_TASK_ID_SHIFT_POOL;
+        uint32_t const  tidx = (list & OS_TASK_ID_MASK_INDEX) >> OS_TASK_ID_SHIFT_INDEX;
+        OS_TASK_DATA   *task = &pool_list[tsrc].TaskPoolData[tidx];
+        os_task_id_t    next =  task->MailboxNext;
+        task->MailboxNext    =  fifo;
+        fifo                 =  list;
+        list                 =  next;
+    }
+    while (fifo != OS_INVALID_TASK_ID)
+    {   // read the link before executing, since the task slot is freed when the task completes.
+        uint32_t const  tsrc = (fifo & OS_TASK_ID_MASK_POOL ) >> OS_TASK_ID_SHIFT_POOL;
+        uint32_t const  tidx = (fifo & OS_TASK_ID_MASK_INDEX) >> OS_TASK_ID_SHIFT_INDEX;
+        os_task_id_t    next =  pool_list[tsrc].TaskPoolData[tidx].MailboxNext;
+        OsExecuteTask(taskenv, fifo);
+        fifo = next;
+        count++;
+    }
+    return count;
 }
 
 /// @summary Set the OS_TASK_POOL_ERROR resulting from the most recent task definition attempt on a task pool.
@@ -7351,6 +15620,7 @@ OsFinishTaskDefinition
 }
 
 /// @summary Execute tasks on the calling thread until the specified task has completed. The calling thread never enters an operating system wait state.
+/// Local memory allocated by the calling task before the wait remains valid; each helped task runs in its own nested scope of the local memory arena.
 /// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread.
 /// @param wait_task The identifier of the task to wait for.
 public_function void
@@ -7380,8 +15650,14 @@ OsWaitForTask
                 {   // continue to check for completion of the waited-on task.
                     if (wait->WorkCount.load(std::memory_order_seq_cst) == 0)
                         return;
+                    // thread-affine tasks targeting this thread cannot run anywhere else, 
+                    // and the waited-on task may depend on them, so run those first.
+                    if (OsExecuteMailboxTasks(taskenv) > 0)
+                    {   // the mailbox tasks may have produced work in the local queue.
+                        work_id = OsTaskQueueTake(local, more_work);
+                    }
                     // there's nothing in the local queue, so attempt to steal some work.
-                    if ((victim_index = ((self->NextWorker++) % pool_count)) != this_index)
+                    else if ((victim_index = ((self->NextWorker++) % pool_count)) != this_index)
                     {   // attempt to steal a single task from the selected victim.
                         work_id = OsTaskQueueSteal(&self->TaskPoolList[victim_index].WorkQueue, more_work);
                     }
@@ -7389,33 +15665,33 @@ OsWaitForTask
             }
             // at this point, work_id identifies a valid task, so execute it on this thread.
             // if this task spawns additional tasks, they'll appear in the local work queue.
-            uint32_t const tsrc = (work_id & OS_TASK_ID_MASK_POOL) >> OS_TASK_ID_SHIFT_POOL;
-            uint32_t const tidx = (work_id & OS_TASK_ID_MASK_INDEX) >> OS_TASK_ID_SHIFT_INDEX;
-            OS_TASK_DATA  *task = &self->TaskPoolList[tsrc].TaskPoolData[tidx];
-            OsMemoryArenaReset(taskenv->LocalMemory);
-            task->TaskMain(work_id, task->TaskData, taskenv);
-            OsCompleteTask(taskenv, work_id);
+            // the helped task runs in a nested scope of the local memory arena, so the
+            // waiting task's local allocations remain valid when this function returns.
+            OsExecuteTask(taskenv, work_id);
         }
     }
 }
 
-/// @summary Create a new task. If all dependencies have been satisfied, add the task to the ready-to-run queue. The task cannot complete until FinishTaskDefinition is called.
+/// @summary Create a new task that must execute on the thread that owns a specific task pool. If all dependencies have been satisfied, deliver the task to the mailbox of the target pool. The task cannot complete until FinishTaskDefinition is called.
+/// Thread-affine tasks are never placed in a work-stealing queue, so they only run when the owning thread calls OsExecuteMailboxTasks (directly, from OsWaitForTask, or from the worker thread main loop.)
 /// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread.
 /// @param task_type One of the values of the TASK_ID_TYPE enumeration specifying the type of task.
 /// @param task_main The entry point of the new task.
 /// @param task_args Optional data to be supplied to the task when it executes. This data is memcpy'd into the new task.
 /// @param args_size The size of the optional task data, in bytes.
+/// @param target_pool The index of the OS_TASK_POOL owned by the thread that must execute the task, as returned by OsGetTaskPoolIndex on that thread, or OS_TASK_POOL_INDEX_ANY to allow any thread to execute the task.
 /// @param dependency_list The optional list of task identifiers for all tasks that must complete before the new task is made ready-to-run.
 /// @param dependency_count The number of valid task identifiers in the dependencies list.
 /// @return The identifier of the new task, or OS_INVALID_TASK_ID.
 public_function os_task_id_t
-OsDefineTask
+OsDefineAffineTask
 (
     OS_TASK_ENVIRONMENT        *taskenv, 
     uint32_t     const        task_type, 
     OS_TASK_ENTRYPOINT        task_main, 
     void         const       *task_args, 
     size_t       const        args_size, 
+    uint32_t     const      target_pool, 
     os_task_id_t const *dependency_list,
     size_t       const dependency_count
 )
@@ -7432,6 +15708,17 @@ OsDefineTask
         assert(args_size <= OS_TASK_DATA::MAX_DATA_BYTES);
         return OS_INVALID_TASK_ID;
     }
+    if (target_pool != OS_TASK_POOL_INDEX_ANY && target_pool >= taskenv->TaskScheduler->TaskPoolCount)
+    {   // the target pool does not exist.
+        OsSetTaskPoolLastError(taskenv, OS_TASK_POOL_ERROR_INVALID_TARGET);
+        assert(target_pool < taskenv->TaskScheduler->TaskPoolCount);
+        return OS_INVALID_TASK_ID;
+    }
+    if (target_pool != OS_TASK_POOL_INDEX_ANY && taskenv->TaskPool->TaskPoolList[target_pool].Mailbox.load(std::memory_order_seq_cst) == OS_TASK_MAILBOX_CLOSED)
+    {   // the target pool is not owned by a thread, so nothing would ever run the task.
+        OsSetTaskPoolLastError(taskenv, OS_TASK_POOL_ERROR_INVALID_TARGET);
+        return OS_INVALID_TASK_ID;
+    }
 
     // reset the error code on the task pool.
     OsSetTaskPoolLastError(taskenv, OS_TASK_POOL_ERROR_NONE);
@@ -7467,6 +15754,7 @@ OsDefineTask
     OS_TASK_DATA *task_data = &taskenv->TaskPool->TaskPoolData[array_index];
     task_data->ParentId     = OS_INVALID_TASK_ID;
     task_data->TaskMain     = task_main;
+    task_data->TargetPool   = target_pool;
     CopyMemory(task_data->TaskData, task_args, args_size);
     task_data->WorkCount.store(2, std::memory_order_release);
     task_data->PermitCount.store(0, std::memory_order_release);
@@ -7507,7 +15795,17 @@ OsDefineTask
 
     // if the task is ready-to-run, and is not an EXTERNAL task, add it to the local work queue.
     if (ready_to_run && task_type != OS_TASK_ID_TYPE_EXTERNAL)
-    {   // push the task onto the private end of the thread-local queue.
+    {
+        if (target_pool != OS_TASK_POOL_INDEX_ANY)
+        {   // thread-affine tasks bypass the work-stealing queue entirely.
+            if (!OsTaskMailboxPost(&taskenv->TaskPool->TaskPoolList[target_pool], task_data, task_id))
+            {   // the target pool was returned after the check above. complete the task without running it.
+                OsLayerError("ERROR: %S(%u): Task %08X cancelled; target task pool %u is not owned by a thread.\n", __FUNCTION__, GetCurrentThreadId(), task_id, target_pool);
+                OsCompleteTask(taskenv, task_id);
+            }
+            return task_id;
+        }
+        // push the task onto the private end of the thread-local queue.
         OsTaskQueuePush(&taskenv->TaskPool->WorkQueue, task_id);
         if ((taskenv->PoolUsage & OS_TASK_POOL_USAGE_FLAG_EXECUTE) == 0)
         {   // this task pool cannot execute tasks, so notify a worker thread to pick it up.
@@ -7517,6 +15815,30 @@ OsDefineTask
     return task_id;
 }
 
+/// @summary Create a new task. If all dependencies have been satisfied, add the task to the ready-to-run queue. The task cannot complete until FinishTaskDefinition is called.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread.
+/// @param task_type One of the values of the TASK_ID_TYPE enumeration specifying the type of task.
+/// @param task_main The entry point of the new task.
+/// @param task_args Optional data to be supplied to the task when it executes. This data is memcpy'd into the new task.
+/// @param args_size The size of the optional task data, in bytes.
+/// @param dependency_list The optional list of task identifiers for all tasks that must complete before the new task is made ready-to-run.
+/// @param dependency_count The number of valid task identifiers in the dependencies list.
+/// @return The identifier of the new task, or OS_INVALID_TASK_ID.
+public_function os_task_id_t
+OsDefineTask
+(
+    OS_TASK_ENVIRONMENT        *taskenv, 
+    uint32_t     const        task_type, 
+    OS_TASK_ENTRYPOINT        task_main, 
+    void         const       *task_args, 
+    size_t       const        args_size, 
+    os_task_id_t const *dependency_list,
+    size_t       const dependency_count
+)
+{
+    return OsDefineAffineTask(taskenv, task_type, task_main, task_args, args_size, OS_TASK_POOL_INDEX_ANY, dependency_list, dependency_count);
+}
+
 /// @summary Create a new child task. If all dependencies have been satisfied, add the task to the ready-to-run queue. The task cannot complete until FinishTaskDefinition is called.
 /// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread.
 /// @param task_type One of the values of the TASK_ID_TYPE enumeration specifying the type of task.
@@ -7599,6 +15921,7 @@ OsDefineChildTask
     OS_TASK_DATA *task_data = &taskenv->TaskPool->TaskPoolData[array_index];
     task_data->ParentId     = parent_id;
     task_data->TaskMain     = task_main;
+    task_data->TargetPool   = OS_TASK_POOL_INDEX_ANY;
     CopyMemory(task_data->TaskData, task_args, args_size);
     task_data->WorkCount.store(2, std::memory_order_release);
     task_data->PermitCount.store(0, std::memory_order_release);
@@ -7703,6 +16026,50 @@ OsSpawnChildTask
     return task_id;
 }
 
+/// @summary Create a new task that must execute on the thread that owns the target task pool, and call OsFinishTaskDefinition. The task is delivered to the target pool's mailbox when it becomes ready-to-run.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread.
+/// @param target_pool The index of the OS_TASK_POOL owned by the thread that must execute the task, as returned by OsGetTaskPoolIndex on that thread.
+/// @param task_main The entry point of the new task.
+/// @return The identifier of the new task, or OS_INVALID_TASK_ID.
+public_function inline os_task_id_t
+OsSpawnAffineTask
+(
+    OS_TASK_ENVIRONMENT  *taskenv,
+    uint32_t const    target_pool,
+    OS_TASK_ENTRYPOINT  task_main
+)
+{
+    os_task_id_t task_id = OsDefineAffineTask(taskenv, OS_TASK_ID_TYPE_INTERNAL, task_main, NULL, 0, target_pool, NULL, 0);
+    OsFinishTaskDefinition(taskenv, task_id);
+    return task_id;
+}
+
+/// @summary Create a new task that must execute on the thread that owns the target task pool, and call OsFinishTaskDefinition. The task is delivered to the target pool's mailbox when all dependencies have completed.
+/// @typeparam ArgsType The type of the task argument data.
+/// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread.
+/// @param target_pool The index of the OS_TASK_POOL owned by the thread that must execute the task, as returned by OsGetTaskPoolIndex on that thread.
+/// @param task_main The entry point of the new task.
+/// @param task_args Data to be supplied to the task when it executes. This data is memcpy'd into the new task.
+/// @param dependency_list The optional list of task identifiers for all tasks that must complete before the new task is made ready-to-run.
+/// @param dependency_count The number of valid task identifiers in the dependency list.
+/// @return The identifier of the new task, or OS_INVALID_TASK_ID.
+template <typename ArgsType>
+public_function inline os_task_id_t
+OsSpawnAffineTask
+(
+    OS_TASK_ENVIRONMENT         *taskenv,
+    uint32_t     const       target_pool,
+    OS_TASK_ENTRYPOINT         task_main,
+    ArgsType     const        *task_args, 
+    os_task_id_t const  *dependency_list=NULL, 
+    size_t       const  dependency_count=0
+)
+{
+    os_task_id_t task_id = OsDefineAffineTask(taskenv, OS_TASK_ID_TYPE_INTERNAL, task_main, task_args, sizeof(ArgsType), target_pool, dependency_list, dependency_count);
+    OsFinishTaskDefinition(taskenv, task_id);
+    return task_id;
+}
+
 /// @summary Create a new task that is completed based on an external event. Do not call OsFinishTaskDefinition. Call OsCompleteTask when the external event occurs.
 /// @param taskenv The OS_TASK_ENVIRONMENT associated with the calling thread.
 /// @return The identifier of the new task, or OS_INVALID_TASK_ID.
@@ -8121,6 +16488,7 @@ OsWorkerThreadMain
     OS_WORKER_THREAD_INIT  init = {};
     OS_WORKER_THREAD       args = {};
     OS_MEMORY_ARENA       arena = {};
+    OS_THREAD_POOL        *pool = NULL;
     os_arena_marker_t user_mark = 0;
     uintptr_t        signal_arg = 0;
     const DWORD          LAUNCH = 0;
@@ -8137,6 +16505,7 @@ OsWorkerThreadMain
     // argp may have been allocated on the stack of the caller 
     // and is only guaranteed to remain valid until the ReadySignal is set.
     CopyMemory(&init, argp, sizeof(OS_WORKER_THREAD_INIT));
+    pool = init.ThreadPool;
 
     // spit out a message just prior to initialization:
     OsLayerOutput("START: %S(%u): Worker thread starting on pool 0x%p.\n", __FUNCTION__, tid, init.ThreadPool);
@@ -8156,6 +16525,7 @@ OsWorkerThreadMain
     args.PoolContext    = init.PoolContext;
     args.ThreadContext  = NULL;
     args.ArenaSize      = OsMemoryArenaBytesReserved(&arena);
+    args.WorkerIndex    = init.WorkerIndex;
     args.ThreadId       = tid;
 
     // allow the application to perform per-thread setup.
@@ -8200,8 +16570,36 @@ OsWorkerThreadMain
     __try
     {
         while (keep_running)
-        {   // once launched by the thread pool, enter the main wait loop.
-            switch ((wake_reason = OsWorkerThreadWaitForWakeup(init.CompletionPort, init.TerminateSignal, tid, signal_arg)))
+        {   // once launched by the thread pool, drain the worker queues before entering the wait state.
+            if (pool->Terminating.load(std::memory_order_relaxed) == 0 && OsThreadPoolTakeWorkItem(pool, init.WorkerIndex, signal_arg))
+            {   // execute the work item without a round trip through the completion port.
+                init.ThreadMain(&args, signal_arg, OS_WORKER_THREAD_WAKE_FOR_RUN);
+                OsMemoryArenaResetToMarker(&arena, user_mark);
+                signal_arg = 0;
+                continue;
+            }
+            // advertise this worker as idle, and then check the queues again.
+            // this closes the race with a submitter that queued items after the 
+            // queues were found empty but before the idle count was incremented.
+            pool->IdleThreads.fetch_add(1, std::memory_order_seq_cst);
+            if (pool->Terminating.load(std::memory_order_relaxed) == 0 && OsThreadPoolHasQueuedWork(pool))
+            {   // if a submitter already claimed this worker, a wakeup is in flight; consume it.
+                if (OsThreadPoolCancelIdle(pool))
+                    continue;
+            }
+            wake_reason = OsWorkerThreadWaitForWakeup(init.CompletionPort, init.TerminateSignal, tid, signal_arg);
+            if (signal_arg == OS_COMPLETION_KEY_WORK_QUEUED)
+            {   // a submitter claimed this worker after queueing work items.
+                // unless the pool is terminating, go back and drain the queues.
+                signal_arg = 0;
+                if (wake_reason == OS_WORKER_THREAD_WAKE_FOR_RUN)
+                    continue;
+            }
+            else
+            {   // the wakeup was not posted by a submitter that claimed an idle worker.
+                OsThreadPoolCancelIdle(pool);
+            }
+            switch (wake_reason)
             {
                 case OS_WORKER_THREAD_WAKE_FOR_EXIT:
                     {   // allow the application to clean up any thread-local resources.
@@ -8246,18 +16644,24 @@ OsWorkerThreadMain
 
 /// @summary Calculate the amount of memory required to create an OS thread pool.
 /// @param thread_count The number of threads in the thread pool.
+/// @param queue_capacity The capacity of each worker-local work item queue, or OS_WORKER_QUEUE_CAPACITY_DEFAULT.
 /// @return The number of bytes required to create an OS_THREAD_POOL with the specified number of worker threads. This value does not include the thread-local memory or thread stack memory.
 public_function size_t
 OsAllocationSizeForThreadPool
 (
-    size_t thread_count
+    size_t   thread_count, 
+    size_t queue_capacity
 )
 {
     size_t size_in_bytes = 0;
+    if (queue_capacity == OS_WORKER_QUEUE_CAPACITY_DEFAULT)
+        queue_capacity  = OS_WORKER_QUEUE::DEFAULT_CAPACITY;
     size_in_bytes += OsAllocationSizeForArray<unsigned int>(thread_count);
     size_in_bytes += OsAllocationSizeForArray<HANDLE>(thread_count);
     size_in_bytes += OsAllocationSizeForArray<HANDLE>(thread_count);
     size_in_bytes += OsAllocationSizeForArray<HANDLE>(thread_count);
+    size_in_bytes += OsAllocationSizeForArray<OS_WORKER_QUEUE>(thread_count);
+    size_in_bytes += OsAllocationSizeForArray<OS_WORKER_QUEUE_CELL>(queue_capacity) * thread_count;
     return size_in_bytes;
 }
 
@@ -8281,13 +16685,20 @@ OsCreateThreadPool
     HANDLE         evt_terminate = NULL;
     DWORD                    tid = GetCurrentThreadId();
     os_arena_marker_t mem_marker = OsMemoryArenaMark(arena);
-    size_t        bytes_required = OsAllocationSizeForThreadPool(init->ThreadCount);
-    size_t        align_required = std::alignment_of<HANDLE>::value;
+    size_t        queue_capacity = init->QueueCapacity != OS_WORKER_QUEUE_CAPACITY_DEFAULT ? init->QueueCapacity : OS_WORKER_QUEUE::DEFAULT_CAPACITY;
+    size_t        bytes_required = OsAllocationSizeForThreadPool(init->ThreadCount, queue_capacity);
+    size_t        align_required = std::alignment_of<OS_WORKER_QUEUE>::value;
     CV_PROVIDER     *cv_provider = NULL;
     CV_MARKERSERIES   *cv_series = NULL;
     HRESULT            cv_result = S_OK;
     char             cv_name[64] = {};
 
+    if ((queue_capacity & (queue_capacity - 1)) != 0)
+    {
+        OsLayerError("ERROR: %S(%u): Worker queue capacity %Iu must be a power of two.\n", __FUNCTION__, tid, queue_capacity);
+        ZeroMemory(pool, sizeof(OS_THREAD_POOL));
+        return -1;
+    }
     if (!OsMemoryArenaCanSatisfyAllocation(arena, bytes_required, align_required))
     {
         OsLayerError("ERROR: %S(%u): Insufficient memory to create thread pool.\n", __FUNCTION__, tid);
@@ -8346,15 +16757,28 @@ OsCreateThreadPool
     pool->OSThreadHandle  = OsMemoryArenaAllocateArray<HANDLE      >(arena, init->ThreadCount);
     pool->WorkerReady     = OsMemoryArenaAllocateArray<HANDLE      >(arena, init->ThreadCount);
     pool->WorkerError     = OsMemoryArenaAllocateArray<HANDLE      >(arena, init->ThreadCount);
+    pool->QueueCount      = init->ThreadCount;
+    pool->WorkerQueues    = OsMemoryArenaAllocateArray<OS_WORKER_QUEUE>(arena, init->ThreadCount);
     pool->CompletionPort  = iocp;
     pool->LaunchSignal    = evt_launch;
     pool->TerminateSignal = evt_terminate;
     pool->TaskProfiler.Provider     = cv_provider;
     pool->TaskProfiler.MarkerSeries = cv_series;
+    pool->IdleThreads.store(0, std::memory_order_relaxed);
+    pool->NextQueue.store(0, std::memory_order_relaxed);
+    pool->Terminating.store(0, std::memory_order_relaxed);
     ZeroMemory(pool->OSThreadIds    , init->ThreadCount * sizeof(unsigned int));
     ZeroMemory(pool->OSThreadHandle , init->ThreadCount * sizeof(HANDLE));
     ZeroMemory(pool->WorkerReady    , init->ThreadCount * sizeof(HANDLE));
     ZeroMemory(pool->WorkerError    , init->ThreadCount * sizeof(HANDLE));
+    for (size_t i = 0, n = init->ThreadCount; i < n; ++i)
+    {   // create the local work item queue for each worker.
+        if (pool->WorkerQueues == NULL || OsCreateWorkerQueue(&pool->WorkerQueues[i], queue_capacity, arena) < 0)
+        {
+            OsLayerError("ERROR: %S(%u): Unable to allocate work item queue for worker %Iu of %Iu.\n", __FUNCTION__, tid, i, n);
+            goto cleanup_and_fail;
+        }
+    }
 
     // set up the worker init structure and spawn all threads.
     for (size_t i = 0, n = init->ThreadCount; i < n; ++i)
@@ -8397,6 +16821,7 @@ OsCreateThreadPool
         winit.PoolContext     = init->PoolContext;
         winit.StackSize       = init->StackSize;
         winit.ArenaSize       = init->ArenaSize;
+        winit.WorkerIndex     = i;
         winit.NUMAGroup       = init->NUMAGroup;
         if ((whand = (HANDLE) _beginthreadex(NULL, (unsigned) init->StackSize, OsWorkerThreadMain, &winit, 0, &thread_id)) == NULL)
         {
@@ -8482,7 +16907,8 @@ OsTerminateThreadPool
     if (pool->ActiveThreads > 0)
     {
         DWORD last_error = ERROR_SUCCESS;
-        // signal the termination event prior to waking any waiting threads.
+        // stop workers from draining their queues, and then signal the termination event prior to waking any waiting threads.
+        pool->Terminating.store(1, std::memory_order_seq_cst);
         SetEvent(pool->TerminateSignal);
         // signal all worker threads in the pool. any active processing will complete before this signal is received.
         OsSignalWorkerThreads(pool->CompletionPort, 0, pool->ActiveThreads, last_error);
@@ -8502,7 +16928,8 @@ OsDestroyThreadPool
     if (pool->ActiveThreads > 0)
     {   
         DWORD last_error = ERROR_SUCCESS;
-        // signal the termination event prior to waking any waiting threads.
+        // stop workers from draining their queues, and then signal the termination event prior to waking any waiting threads.
+        pool->Terminating.store(1, std::memory_order_seq_cst);
         SetEvent(pool->TerminateSignal);
         // signal all worker threads in the pool. any active processing will complete before this signal is received.
         OsSignalWorkerThreads(pool->CompletionPort, 0, pool->ActiveThreads, last_error);
@@ -8595,6 +17022,53 @@ OsSignalWorkerThreads
     return true;
 }
 
+/// @summary Submit a batch of work items from a worker thread to the other workers in the same pool.
+/// Items are added to the sending worker's local queue first, where they are picked up by the sender when it returns or stolen by idle workers. At most one wakeup is posted per idle worker.
+/// @param sender The OS_WORKER_THREAD state for the thread submitting the work items.
+/// @param work_items The set of application-defined work item values. Each value is passed to OS_WORKER_ENTRY with OS_WORKER_THREAD_WAKE_FOR_RUN, and must be non-zero.
+/// @param item_count The number of items in the work_items array.
+/// @return true if all work items were submitted to the thread pool.
+public_function bool
+OsSubmitWorkItems
+(
+    OS_WORKER_THREAD      *sender, 
+    uintptr_t const *work_items, 
+    size_t           item_count
+)
+{
+    DWORD last_error = ERROR_SUCCESS;
+    if  (!OsSubmitWorkItems(sender->ThreadPool, sender->WorkerIndex, false, work_items, item_count, last_error))
+    {
+        OsLayerError("ERROR: %S(%u): Submitting work items failed with result 0x%08X.\n", __FUNCTION__, sender->ThreadId, last_error);
+        return false;
+    }
+    return true;
+}
+
+/// @summary Submit a batch of work items to a thread pool. 
+/// Items are distributed round-robin across the worker-local queues, and at most one wakeup is posted per idle worker, so short work items do not each pay for a kernel transition.
+/// @param pool The thread pool that will execute the work items.
+/// @param work_items The set of application-defined work item values. Each value is passed to OS_WORKER_ENTRY with OS_WORKER_THREAD_WAKE_FOR_RUN, and must be non-zero.
+/// @param item_count The number of items in the work_items array.
+/// @return true if all work items were submitted to the thread pool.
+public_function bool
+OsSubmitWorkItems
+(
+    OS_THREAD_POOL        *pool, 
+    uintptr_t const *work_items, 
+    size_t           item_count
+)
+{
+    DWORD last_error = ERROR_SUCCESS;
+    size_t     first = pool->NextQueue.fetch_add(1, std::memory_order_relaxed) % pool->QueueCount;
+    if  (!OsSubmitWorkItems(pool, first, true, work_items, item_count, last_error))
+    {
+        OsLayerError("ERROR: %S(%u): Submitting work items failed with result 0x%08X.\n", __FUNCTION__, GetCurrentThreadId(), last_error);
+        return false;
+    }
+    return true;
+}
+
 /// @summary Resets the state of the low-level input system.
 /// @param system A pointer to the low-level input system to reset.
 public_function void
@@ -11776,6 +20250,305 @@ OsFreeFileData
     ZeroMemory(data, sizeof(OS_FILE_DATA));
 }
 
+/// @summary Retrieve the address stored in a self-relative pointer.
+/// @param ptr The OS_RELATIVE_PTR to read.
+/// @return The address of the target object, or NULL.
+template <typename T>
+public_function inline T*
+OsRelativePtrGet
+(
+    OS_RELATIVE_PTR<T> const *ptr
+)
+{
+    return ptr->Offset != 0 ? (T*)((uint8_t const*) ptr + ptr->Offset) : NULL;
+}
+
+/// @summary Store an address in a self-relative pointer. The pointer and its target should be allocated from the same arena.
+/// @param ptr The OS_RELATIVE_PTR to write.
+/// @param target The address of the target object, or NULL.
+template <typename T>
+public_function inline void
+OsRelativePtrSet
+(
+    OS_RELATIVE_PTR<T> *ptr, 
+    T const         *target
+)
+{   assert(target != (T const*) ptr || target == NULL);
+    ptr->Offset = target != NULL ? (int64_t)((intptr_t) target - (intptr_t) ptr) : 0;
+}
+
+/// @summary Compute the checksum stored with an arena snapshot. The data is consumed eight bytes at a time, so the cost is close to that of reading it.
+/// @param data The data to checksum.
+/// @param size The number of bytes of data.
+/// @return The 64-bit checksum.
+public_function uint64_t
+OsArenaSnapshotChecksum
+(
+    void const *data, 
+    size_t      size
+)
+{
+    uint8_t const *src = (uint8_t const*) data;
+    uint64_t      hash = 0xCBF29CE484222325ULL ^ (uint64_t) size;
+    uint64_t      word = 0;
+    while (size >= sizeof(uint64_t))
+    {
+        memcpy(&word, src, sizeof(uint64_t));
+        hash  = (hash ^ word) * 0x100000001B3ULL;
+        hash ^= hash >> 29;
+        src  += sizeof(uint64_t);
+        size -= sizeof(uint64_t);
+    }
+    while (size > 0)
+    {
+        hash = (hash ^ *src++) * 0x100000001B3ULL;
+        size--;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/// @summary Check that the header of an arena snapshot describes a file this process can use.
+/// @param header The header read from the start of the file.
+/// @param file_size The size of the snapshot file, in bytes.
+/// @param user_tag The application-defined value the snapshot must have been written with.
+/// @param path The zero-terminated UTF-16 path of the snapshot file, used for error reporting.
+/// @return true if the header is valid.
+internal_function bool
+OsArenaSnapshotValidateHeader
+(
+    OS_ARENA_SNAPSHOT_HEADER const *header, 
+    uint64_t                     file_size, 
+    uint64_t                      user_tag, 
+    WCHAR const                      *path
+)
+{
+    if (header->Magic != OS_ARENA_SNAPSHOT_MAGIC)
+    {
+        OsLayerError("ERROR: %S(%u): File \"%s\" is not an arena snapshot, or was not completely written.\n", __FUNCTION__, OsThreadId(), path);
+        return false;
+    }
+    if (header->Version != OS_ARENA_SNAPSHOT_VERSION || header->HeaderSize != sizeof(OS_ARENA_SNAPSHOT_HEADER))
+    {
+        OsLayerError("ERROR: %S(%u): Arena snapshot \"%s\" has unsupported version %u (header size %u).\n", __FUNCTION__, OsThreadId(), path, (unsigned) header->Version, (unsigned) header->HeaderSize);
+        return false;
+    }
+    if (header->PointerSize != sizeof(void*) || header->ByteOrder != 0x01020304UL)
+    {
+        OsLayerError("ERROR: %S(%u): Arena snapshot \"%s\" was written by a process with a different pointer size or byte order.\n", __FUNCTION__, OsThreadId(), path);
+        return false;
+    }
+    if (header->DataOffset < sizeof(OS_ARENA_SNAPSHOT_HEADER) || (header->DataOffset & (OS_ARENA_SNAPSHOT_DATA_ALIGNMENT - 1)) != 0 || 
+        header->DataOffset > file_size || header->DataSize != (file_size - header->DataOffset) || header->DataSize > SIZE_MAX)
+    {
+        OsLayerError("ERROR: %S(%u): Arena snapshot \"%s\" data range [%I64u, +%I64u) does not match file size %I64u.\n", __FUNCTION__, OsThreadId(), path, header->DataOffset, header->DataSize, file_size);
+        return false;
+    }
+    if (header->RootOffset != OS_ARENA_SNAPSHOT_NO_ROOT && header->RootOffset >= header->DataSize)
+    {
+        OsLayerError("ERROR: %S(%u): Arena snapshot \"%s\" root offset %I64u is outside of the data.\n", __FUNCTION__, OsThreadId(), path, header->RootOffset);
+        return false;
+    }
+    if (header->UserTag != user_tag)
+    {   // the data was written by a different version of the application. the caller should rebuild it.
+        OsLayerError("ERROR: %S(%u): Arena snapshot \"%s\" has tag %016I64X, expected %016I64X.\n", __FUNCTION__, OsThreadId(), path, header->UserTag, user_tag);
+        return false;
+    }
+    return true;
+}
+
+/// @summary Write the used portion of a host memory arena to a file, so that it can be mapped back with OsLoadArenaSnapshot on a later run.
+/// The arena contents are written byte-for-byte. Any pointers between objects in the arena must be stored as OS_RELATIVE_PTR, and the 
+/// data must not contain pointers to memory outside of the arena, such as OS handles or the tables of an OS_HASH_MAP.
+/// The existing file, if any, is replaced. The header is written after the data, so a partially-written file fails validation.
+/// @param arena The arena whose used portion, from offset zero to the current allocation offset, is written.
+/// @param root The address of the object through which the data is accessed after loading, or NULL. The address must lie in the used portion of the arena.
+/// @param user_tag An application-defined value identifying the layout of the data. OsLoadArenaSnapshot rejects files with a different tag.
+/// @param path The zero-terminated UTF-16 path of the file to write.
+/// @return Zero if the snapshot is written successfully, or -1 if an error occurred.
+public_function int
+OsWriteArenaSnapshot
+(
+    OS_HOST_MEMORY_ARENA *arena, 
+    void const            *root, 
+    uint64_t           user_tag, 
+    WCHAR const           *path
+)
+{
+    OS_ARENA_SNAPSHOT_HEADER header = {};
+    uint8_t     page[OS_ARENA_SNAPSHOT_DATA_ALIGNMENT];
+    uint8_t const *data = arena->HostMemory.HostAddress;
+    size_t         size = arena->Allocator.NextOffset;
+    HANDLE           fd = INVALID_HANDLE_VALUE;
+    DWORD       written = 0;
+    size_t           nw = 0;
+
+    if (root != NULL && ((uint8_t const*) root < data || (uint8_t const*) root >= data + size))
+    {
+        OsLayerError("ERROR: %S(%u): Snapshot root %p is outside of the used portion of the arena.\n", __FUNCTION__, OsThreadId(), root);
+        return -1;
+    }
+    header.Magic       = OS_ARENA_SNAPSHOT_MAGIC;
+    header.Version     = OS_ARENA_SNAPSHOT_VERSION;
+    header.HeaderSize  = (uint16_t) sizeof(OS_ARENA_SNAPSHOT_HEADER);
+    header.PointerSize = (uint16_t) sizeof(void*);
+    header.Reserved    = 0;
+    header.ByteOrder   = 0x01020304UL;
+    header.DataOffset  = OS_ARENA_SNAPSHOT_DATA_ALIGNMENT;
+    header.DataSize    = size;
+    header.RootOffset  = root != NULL ? (uint64_t)((uint8_t const*) root - data) : OS_ARENA_SNAPSHOT_NO_ROOT;
+    header.UserTag     = user_tag;
+    header.Checksum    = OsArenaSnapshotChecksum(data, size);
+
+    if ((fd = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to create snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        return -1;
+    }
+    // write a zero-filled header page, so the magic value is not present until all of the data is on disk.
+    ZeroMemory(page, sizeof(page));
+    if (!WriteFile(fd, page, (DWORD) sizeof(page), &written, NULL) || written != sizeof(page))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to write header page of snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        goto cleanup_and_fail;
+    }
+    // write the arena data, in 1MB chunks.
+    while (nw < size)
+    {
+        size_t  remain = size - nw;
+        DWORD to_write =(remain < Megabytes(1)) ? (DWORD) remain : (DWORD) Megabytes(1);
+        if (!WriteFile(fd, data + nw, to_write, &written, NULL) || written != to_write)
+        {
+            OsLayerError("ERROR: %S(%u): WriteFile failed for snapshot file \"%s\", offset %Iu (%08X).\n", __FUNCTION__, OsThreadId(), path, nw, GetLastError());
+            goto cleanup_and_fail;
+        }
+        nw += to_write;
+    }
+    // the data is complete; make it durable before the header marks the file as valid.
+    if (!FlushFileBuffers(fd))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to flush snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        goto cleanup_and_fail;
+    }
+    if (SetFilePointer(fd, 0, NULL, FILE_BEGIN) == INVALID_SET_FILE_POINTER || !WriteFile(fd, &header, (DWORD) sizeof(header), &written, NULL) || written != sizeof(header))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to write header of snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        goto cleanup_and_fail;
+    }
+    if (!FlushFileBuffers(fd))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to flush snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        goto cleanup_and_fail;
+    }
+    CloseHandle(fd);
+    return 0;
+
+cleanup_and_fail:
+    CloseHandle(fd);
+    DeleteFileW(path);
+    return -1;
+}
+
+/// @summary Map an arena snapshot written by OsWriteArenaSnapshot into the process address space. The header is validated, but the data 
+/// is not read, so pages are loaded from the file (or the system file cache) on first access. The mapping does not depend on the file 
+/// handle remaining open; the file cannot be deleted or replaced until OsCloseArenaSnapshot is called.
+/// @param snapshot The OS_ARENA_SNAPSHOT to initialize.
+/// @param path The zero-terminated UTF-16 path of the snapshot file.
+/// @param user_tag The application-defined value the snapshot must have been written with.
+/// @param flags One or more of OS_ARENA_SNAPSHOT_FLAGS. By default, the data is mapped read-only and the checksum is not verified.
+/// @return Zero if the snapshot is mapped, or -1 if the file could not be opened or failed validation. The caller should rebuild the data in this case.
+public_function int
+OsLoadArenaSnapshot
+(
+    OS_ARENA_SNAPSHOT *snapshot, 
+    WCHAR const           *path, 
+    uint64_t           user_tag, 
+    uint32_t              flags
+)
+{
+    OS_ARENA_SNAPSHOT_HEADER const *header = NULL;
+    LARGE_INTEGER file_size = {};
+    bool      copy_on_write = (flags & OS_ARENA_SNAPSHOT_FLAG_COPY_ON_WRITE) != 0;
+    HANDLE               fd = INVALID_HANDLE_VALUE;
+    HANDLE              map = NULL;
+    void              *view = NULL;
+    uint8_t           *base = NULL;
+
+    ZeroMemory(snapshot, sizeof(OS_ARENA_SNAPSHOT));
+
+    if ((fd = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to open snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        goto cleanup_and_fail;
+    }
+    if (!GetFileSizeEx(fd, &file_size))
+    {
+        OsLayerError("ERROR: %S(%u): Failed to retrieve file size for snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        goto cleanup_and_fail;
+    }
+    if (file_size.QuadPart < (LONGLONG) OS_ARENA_SNAPSHOT_DATA_ALIGNMENT)
+    {
+        OsLayerError("ERROR: %S(%u): File \"%s\" is too small to be an arena snapshot (%I64d bytes).\n", __FUNCTION__, OsThreadId(), path, file_size.QuadPart);
+        goto cleanup_and_fail;
+    }
+    // map the entire file with a single view. PAGE_WRITECOPY gives the process private copies of any pages it writes to.
+    if ((map = CreateFileMapping(fd, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Failed to create the file mapping for snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        goto cleanup_and_fail;
+    }
+    if ((view = MapViewOfFile(map, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0)) == NULL)
+    {
+        OsLayerError("ERROR: %S(%u): Unable to map snapshot file \"%s\" (%08X).\n", __FUNCTION__, OsThreadId(), path, GetLastError());
+        goto cleanup_and_fail;
+    }
+    // the view keeps the section and file alive after the handles are closed.
+    CloseHandle(map); map = NULL;
+    CloseHandle(fd);  fd  = INVALID_HANDLE_VALUE;
+
+    header = (OS_ARENA_SNAPSHOT_HEADER const*) view;
+    if (!OsArenaSnapshotValidateHeader(header, (uint64_t) file_size.QuadPart, user_tag, path))
+    {   // OsArenaSnapshotValidateHeader output error information already.
+        goto cleanup_and_fail;
+    }
+    base = (uint8_t*) view + header->DataOffset;
+    if ((flags & OS_ARENA_SNAPSHOT_FLAG_VERIFY_CHECKSUM) && OsArenaSnapshotChecksum(base, (size_t) header->DataSize) != header->Checksum)
+    {
+        OsLayerError("ERROR: %S(%u): Arena snapshot \"%s\" failed checksum verification.\n", __FUNCTION__, OsThreadId(), path);
+        goto cleanup_and_fail;
+    }
+    snapshot->MapPtr      = view;
+    snapshot->BaseAddress = base;
+    snapshot->Root        = header->RootOffset != OS_ARENA_SNAPSHOT_NO_ROOT ? base + header->RootOffset : NULL;
+    snapshot->DataSize    = (size_t) header->DataSize;
+    snapshot->UserTag     = header->UserTag;
+    snapshot->Flags       = flags;
+    return 0;
+
+cleanup_and_fail:
+    if (view != NULL) UnmapViewOfFile(view);
+    if (map  != NULL) CloseHandle(map);
+    if (fd   != INVALID_HANDLE_VALUE) CloseHandle(fd);
+    return -1;
+}
+
+/// @summary Unmap an arena snapshot. Pointers into the snapshot data are invalid after this call, and copy-on-write modifications are discarded.
+/// @param snapshot The OS_ARENA_SNAPSHOT returned by OsLoadArenaSnapshot.
+public_function void
+OsCloseArenaSnapshot
+(
+    OS_ARENA_SNAPSHOT *snapshot
+)
+{
+    if (snapshot->MapPtr != NULL)
+    {
+        UnmapViewOfFile(snapshot->MapPtr);
+    }
+    ZeroMemory(snapshot, sizeof(OS_ARENA_SNAPSHOT));
+}
+
 /// @summary Calculate the amount of memory required to create an OS thread pool.
 /// @param thread_count The number of threads in the thread pool.
 /// @return The number of bytes required to create an OS_IO_THREAD_POOL with the specified number of worker threads. This value does not include the thread-local memory or thread stack memory.
@@ -12111,4 +20884,5 @@ OsSubmitIoRequest
     }
     return true;
 }
+#endif /* !defined(__linux__) */
 